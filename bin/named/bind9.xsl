@@ -15,7 +15,7 @@
   <xsl:output method="html" indent="yes" version="4.0"/>
   <!-- the version number **below** must match version in bin/named/statschannel.c -->
   <!-- don't forget to update "/xml/v<STATS_XML_VERSION_MAJOR>" in the HTTP endpoints listed below -->
-  <xsl:template match="statistics[@version=&quot;3.14&quot;]">
+  <xsl:template match="statistics[@version=&quot;3.19&quot;]">
     <html>
       <head>
         <script type="text/javascript" src="https://ajax.googleapis.com/ajax/libs/jquery/3.4.1/jquery.min.js"></script>
@@ -323,12 +323,30 @@
             </td>
           </tr>
           <tr class="odd">
+            <th>Last reconfiguration pause (us):</th>
+            <td>
+              <xsl:value-of select="server/config-pause"/>
+            </td>
+          </tr>
+          <tr class="even">
+            <th>Zones waiting for a refresh query:</th>
+            <td>
+              <xsl:value-of select="server/refresh-backlog"/>
+            </td>
+          </tr>
+          <tr class="odd">
+            <th>Primaries waiting for a refresh query:</th>
+            <td>
+              <xsl:value-of select="server/refresh-primaries"/>
+            </td>
+          </tr>
+          <tr class="even">
             <th>Current time:</th>
             <td>
               <xsl:value-of select="server/current-time"/>
             </td>
           </tr>
-          <tr class="even">
+          <tr class="odd">
             <th>Server version:</th>
             <td>
               <xsl:value-of select="server/version"/>
@@ -610,6 +628,70 @@
             </table>
           </xsl:if>
         </xsl:for-each>
+        <xsl:for-each select="views/view">
+          <xsl:variable name="thisview4">
+            <xsl:value-of select="@name"/>
+          </xsl:variable>
+          <xsl:for-each select="counters[@type=&quot;dlzcache&quot;]">
+            <xsl:if test="counter[.&gt;0]">
+              <h3>DLZ Answer Cache Statistics for View <xsl:value-of select="$thisview4"/> (DLZ <xsl:value-of select="@name"/>)</h3>
+              <table class="counters">
+                <xsl:for-each select="counter[.&gt;0]">
+                  <xsl:sort select="." data-type="number" order="descending"/>
+                  <xsl:variable name="css-class5">
+                    <xsl:choose>
+                      <xsl:when test="position() mod 2 = 0">even</xsl:when>
+                      <xsl:otherwise>odd</xsl:otherwise>
+                    </xsl:choose>
+                  </xsl:variable>
+                  <tr class="{$css-class5}">
+                    <th>
+                      <xsl:value-of select="@name"/>
+                    </th>
+                    <td>
+                      <xsl:value-of select="."/>
+                    </td>
+                  </tr>
+                </xsl:for-each>
+              </table>
+            </xsl:if>
+          </xsl:for-each>
+        </xsl:for-each>
+        <xsl:for-each select="views/view">
+          <xsl:if test="adbrtt/server">
+            <h3>Server Round Trip Times for View <xsl:value-of select="@name"/></h3>
+            <table class="counters">
+              <thead>
+                <tr>
+                  <th>Address</th>
+                  <th>Answers</th>
+                  <th>SRTT (us)</th>
+                  <th>50th Percentile (us)</th>
+                  <th>95th Percentile (us)</th>
+                  <th>99th Percentile (us)</th>
+                </tr>
+              </thead>
+              <tbody>
+                <xsl:for-each select="adbrtt/server">
+                  <xsl:variable name="css-class5">
+                    <xsl:choose>
+                      <xsl:when test="position() mod 2 = 0">even</xsl:when>
+                      <xsl:otherwise>odd</xsl:otherwise>
+                    </xsl:choose>
+                  </xsl:variable>
+                  <tr class="{$css-class5}">
+                    <th><xsl:value-of select="address"/></th>
+                    <td><xsl:value-of select="samples"/></td>
+                    <td><xsl:value-of select="srtt"/></td>
+                    <td><xsl:value-of select="p50"/></td>
+                    <td><xsl:value-of select="p95"/></td>
+                    <td><xsl:value-of select="p99"/></td>
+                  </tr>
+                </xsl:for-each>
+              </tbody>
+            </table>
+          </xsl:if>
+        </xsl:for-each>
         <xsl:for-each select="views/view">
           <xsl:if test="cache/rrset">
             <h3>Cache DB RRsets for View <xsl:value-of select="@name"/></h3>
@@ -729,6 +811,44 @@
           </table>
           <br/>
         </xsl:if>
+        <xsl:if test="traffic/latency/histogram">
+          <h2>Query Latency Statistics</h2>
+          <table class="counters">
+            <thead>
+              <tr>
+                <th>Group</th>
+                <th>Name</th>
+                <th>Responses</th>
+                <th>Mean (us)</th>
+                <th>50th Percentile (us)</th>
+                <th>90th Percentile (us)</th>
+                <th>99th Percentile (us)</th>
+                <th>99.9th Percentile (us)</th>
+              </tr>
+            </thead>
+            <tbody>
+              <xsl:for-each select="traffic/latency/histogram">
+                <xsl:variable name="css-class7">
+                  <xsl:choose>
+                    <xsl:when test="position() mod 2 = 0">even</xsl:when>
+                    <xsl:otherwise>odd</xsl:otherwise>
+                  </xsl:choose>
+                </xsl:variable>
+                <tr class="{$css-class7}">
+                  <th><xsl:value-of select="@group"/></th>
+                  <th><xsl:value-of select="@name"/></th>
+                  <td><xsl:value-of select="count"/></td>
+                  <td><xsl:value-of select="mean"/></td>
+                  <td><xsl:value-of select="p50"/></td>
+                  <td><xsl:value-of select="p90"/></td>
+                  <td><xsl:value-of select="p99"/></td>
+                  <td><xsl:value-of select="p999"/></td>
+                </tr>
+              </xsl:for-each>
+            </tbody>
+          </table>
+          <br/>
+        </xsl:if>
         <xsl:if test="server/counters[@type=&quot;sockstat&quot;]/counter[.&gt;0]">
           <h2>Socket I/O Statistics</h2>
           <table class="counters">
@@ -65,6 +65,7 @@ options {\n\
 			    "\
 	heartbeat-interval 60;\n\
 	interface-interval 60;\n\
+	io-uring no;\n\
 	listen-on {any;};\n\
 	listen-on-v6 {any;};\n\
 	match-mapped-addresses no;\n\
@@ -103,6 +104,7 @@ options {\n\
 	rrset-order { order random; };\n\
 	secroots-file \"named.secroots\";\n\
 	send-cookie true;\n\
+	serial-query-batch 1;\n\
 	serial-query-rate 20;\n\
 	server-id none;\n\
 	session-keyalg hmac-sha256;\n\
@@ -147,6 +149,7 @@ options {\n\
 	check-svcb yes;\n\
 	clients-per-query 10;\n\
 	dnssec-accept-expired no;\n\
+	dnssec-chain-prefetch no;\n\
 	dnssec-validation " VALIDATION_DEFAULT "; \n"
 #ifdef USE_DNSRPS
 			    "	dnsrps-library \"" DNSRPS_LIBRPZ_PATH "\";\n"
@@ -187,6 +190,7 @@ options {\n\
 	request-expire true;\n\
 	request-ixfr true;\n\
 	require-server-cookie no;\n\
+	resolver-hedge-ratio 0%;\n\
 	resolver-nonbackoff-tries 3;\n\
 	resolver-retry-interval 800; /* in milliseconds */\n\
 	root-key-sentinel yes;\n\
@@ -241,6 +245,7 @@ options {\n\
 	transfer-source *;\n\
 	transfer-source-v6 *;\n\
 	try-tcp-refresh yes; /* BIND 8 compat */\n\
+	update-commit-window 0;\n\
 	zero-no-soa-ttl yes;\n\
 	zone-statistics terse;\n\
 };\n\
@@ -29,7 +29,17 @@
 static dns_geoip_databases_t geoip_table;
 
 #if defined(HAVE_GEOIP2)
-static MMDB_s geoip_country, geoip_city, geoip_as, geoip_isp, geoip_domain;
+/*
+ * A reconfiguration opens the databases into 'geoip_staged' while the
+ * server keeps matching ACLs against 'geoip_table'; named_geoip_commit()
+ * swaps them while the loops are paused, and the databases it replaced
+ * stay in 'geoip_retired' until named_geoip_unload() closes them.  The
+ * two generations alternate between the two sets of MMDB_s structures.
+ */
+static dns_geoip_databases_t geoip_staged, geoip_retired;
+static MMDB_s geoip_country[2], geoip_city[2], geoip_as[2], geoip_isp[2],
+	geoip_domain[2];
+static unsigned int geoip_slot = 0;
 
 static MMDB_s *
 open_geoip2(const char *dir, const char *dbfile, MMDB_s *mmdb) {
@@ -61,6 +71,30 @@ open_geoip2(const char *dir, const char *dbfile, MMDB_s *mmdb) {
 
 	return (NULL);
 }
+
+static void
+close_geoip2(dns_geoip_databases_t *dbs) {
+	if (dbs->country != NULL) {
+		MMDB_close(dbs->country);
+		dbs->country = NULL;
+	}
+	if (dbs->city != NULL) {
+		MMDB_close(dbs->city);
+		dbs->city = NULL;
+	}
+	if (dbs->as != NULL) {
+		MMDB_close(dbs->as);
+		dbs->as = NULL;
+	}
+	if (dbs->isp != NULL) {
+		MMDB_close(dbs->isp);
+		dbs->isp = NULL;
+	}
+	if (dbs->domain != NULL) {
+		MMDB_close(dbs->domain);
+		dbs->domain = NULL;
+	}
+}
 #endif /* HAVE_GEOIP2 */
 
 void
@@ -77,34 +111,40 @@ named_geoip_init(void) {
 void
 named_geoip_load(char *dir) {
 #if defined(HAVE_GEOIP2)
+	dns_geoip_databases_t *dbs = &geoip_staged;
+	unsigned int slot = 1 - geoip_slot;
+
 	REQUIRE(dir != NULL);
 
+	/* The staging slot may still be held by older databases. */
+	named_geoip_unload();
+
 	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
 		      NAMED_LOGMODULE_SERVER, ISC_LOG_INFO,
 		      "looking for GeoIP2 databases in '%s'", dir);
 
-	named_g_geoip->country = open_geoip2(dir, "GeoIP2-Country.mmdb",
-					     &geoip_country);
-	if (named_g_geoip->country == NULL) {
-		named_g_geoip->country = open_geoip2(
-			dir, "GeoLite2-Country.mmdb", &geoip_country);
+	dbs->country = open_geoip2(dir, "GeoIP2-Country.mmdb",
+				   &geoip_country[slot]);
+	if (dbs->country == NULL) {
+		dbs->country = open_geoip2(dir, "GeoLite2-Country.mmdb",
+					   &geoip_country[slot]);
 	}
 
-	named_g_geoip->city = open_geoip2(dir, "GeoIP2-City.mmdb", &geoip_city);
-	if (named_g_geoip->city == NULL) {
-		named_g_geoip->city = open_geoip2(dir, "GeoLite2-City.mmdb",
-						  &geoip_city);
+	dbs->city = open_geoip2(dir, "GeoIP2-City.mmdb", &geoip_city[slot]);
+	if (dbs->city == NULL) {
+		dbs->city = open_geoip2(dir, "GeoLite2-City.mmdb",
+					&geoip_city[slot]);
 	}
 
-	named_g_geoip->as = open_geoip2(dir, "GeoIP2-ASN.mmdb", &geoip_as);
-	if (named_g_geoip->as == NULL) {
-		named_g_geoip->as = open_geoip2(dir, "GeoLite2-ASN.mmdb",
-						&geoip_as);
+	dbs->as = open_geoip2(dir, "GeoIP2-ASN.mmdb", &geoip_as[slot]);
+	if (dbs->as == NULL) {
+		dbs->as = open_geoip2(dir, "GeoLite2-ASN.mmdb",
+				      &geoip_as[slot]);
 	}
 
-	named_g_geoip->isp = open_geoip2(dir, "GeoIP2-ISP.mmdb", &geoip_isp);
-	named_g_geoip->domain = open_geoip2(dir, "GeoIP2-Domain.mmdb",
-					    &geoip_domain);
+	dbs->isp = open_geoip2(dir, "GeoIP2-ISP.mmdb", &geoip_isp[slot]);
+	dbs->domain = open_geoip2(dir, "GeoIP2-Domain.mmdb",
+				  &geoip_domain[slot]);
 #else  /* if defined(HAVE_GEOIP2) */
 	UNUSED(dir);
 
@@ -112,29 +152,34 @@ named_geoip_load(char *dir) {
 #endif /* if defined(HAVE_GEOIP2) */
 }
 
+dns_geoip_databases_t *
+named_geoip_staged(void) {
+#if defined(HAVE_GEOIP2)
+	return (&geoip_staged);
+#else  /* if defined(HAVE_GEOIP2) */
+	return (NULL);
+#endif /* if defined(HAVE_GEOIP2) */
+}
+
+void
+named_geoip_commit(void) {
+#if defined(HAVE_GEOIP2)
+	INSIST(geoip_retired.country == NULL && geoip_retired.city == NULL &&
+	       geoip_retired.as == NULL && geoip_retired.isp == NULL &&
+	       geoip_retired.domain == NULL);
+
+	geoip_retired = geoip_table;
+	geoip_table = geoip_staged;
+	geoip_staged = (dns_geoip_databases_t){ 0 };
+	geoip_slot = 1 - geoip_slot;
+#endif /* if defined(HAVE_GEOIP2) */
+}
+
 void
 named_geoip_unload(void) {
 #ifdef HAVE_GEOIP2
-	if (named_g_geoip->country != NULL) {
-		MMDB_close(named_g_geoip->country);
-		named_g_geoip->country = NULL;
-	}
-	if (named_g_geoip->city != NULL) {
-		MMDB_close(named_g_geoip->city);
-		named_g_geoip->city = NULL;
-	}
-	if (named_g_geoip->as != NULL) {
-		MMDB_close(named_g_geoip->as);
-		named_g_geoip->as = NULL;
-	}
-	if (named_g_geoip->isp != NULL) {
-		MMDB_close(named_g_geoip->isp);
-		named_g_geoip->isp = NULL;
-	}
-	if (named_g_geoip->domain != NULL) {
-		MMDB_close(named_g_geoip->domain);
-		named_g_geoip->domain = NULL;
-	}
+	close_geoip2(&geoip_staged);
+	close_geoip2(&geoip_retired);
 #endif /* ifdef HAVE_GEOIP2 */
 }
 
@@ -142,5 +187,6 @@ void
 named_geoip_shutdown(void) {
 #ifdef HAVE_GEOIP2
 	named_geoip_unload();
+	close_geoip2(&geoip_table);
 #endif /* HAVE_GEOIP2 */
 }
@@ -20,9 +20,33 @@ named_geoip_init(void);
 
 void
 named_geoip_load(char *dir);
+/*%<
+ * Open the GeoIP2 databases found in 'dir'.  They are not used for
+ * matching until named_geoip_commit() is called; until then they are
+ * available through named_geoip_staged().
+ */
+
+dns_geoip_databases_t *
+named_geoip_staged(void);
+/*%<
+ * Return the databases opened by the last named_geoip_load() that
+ * have not been committed yet.
+ */
+
+void
+named_geoip_commit(void);
+/*%<
+ * Replace the databases in named_g_geoip with the staged ones.  This
+ * must be called with the loops paused.
+ */
 
 void
 named_geoip_unload(void);
+/*%<
+ * Close the databases replaced by named_geoip_commit() and any staged
+ * ones that were not committed.  The databases in named_g_geoip are
+ * left alone.
+ */
 
 void
 named_geoip_shutdown(void);
@@ -63,7 +63,10 @@ struct named_server {
 	/* Server data structures. */
 	dns_loadmgr_t	  *loadmgr;
 	dns_zonemgr_t	  *zonemgr;
-	dns_viewlist_t	   viewlist;
+	dns_viewlist_t	  *viewlist; /*%< Replaced with
+					* rcu_assign_pointer() by the main
+					* loop; other loops must read it
+					* with rcu_dereference() */
 	dns_kasplist_t	   kasplist;
 	ns_interfacemgr_t *interfacemgr;
 	dns_db_t	  *in_roothints;
@@ -77,6 +80,10 @@ struct named_server {
 	uint32_t heartbeat_interval;
 
 	atomic_int reload_status;
+	atomic_uint_fast64_t reconfig_pause; /*%< Duration of the loop
+					      * pause during the last
+					      * (re)configuration, in
+					      * microseconds */
 
 	bool flushonshutdown;
 
@@ -28,12 +28,17 @@ ISC_LANG_BEGINDECLS
 isc_result_t
 named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 		     const cfg_obj_t *zconfig, cfg_aclconfctx_t *ac,
-		     dns_kasplist_t *kasplist, dns_zone_t *zone,
-		     dns_zone_t *raw);
+		     dns_kasplist_t *kasplist, dns_view_t *view,
+		     dns_zone_t *zone, dns_zone_t *raw);
 /*%<
  * Configure or reconfigure a zone according to the named.conf
  * data.
  *
+ * 'view' is the view the zone is being configured for; the zone
+ * inherits that view's default ACLs.  During a reconfiguration a
+ * reused zone is configured while it is still attached to its old
+ * view, so this need not be the zone's current view.
+ *
  * The zone origin is not configured, it is assumed to have been set
  * at zone creation time.
  *
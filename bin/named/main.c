@@ -314,7 +314,7 @@ usage(void) {
 			"username] [-U listeners]\n"
 			"             [-m "
 			"{usage|trace|record|size|mctx}]\n"
-			"             [-M fill|nofill]\n"
+			"             [-M fill|nofill|sharded|looparenas]\n"
 			"usage: named [-v|-V|-C]\n");
 }
 
@@ -420,6 +420,8 @@ static struct flag_def {
 			{ NULL, 0, false } },
   mem_context_flags[] = { { "fill", ISC_MEMFLAG_FILL, false },
 			  { "nofill", ISC_MEMFLAG_FILL, true },
+			  { "sharded", ISC_MEMFLAG_SHARDED, false },
+			  { "looparenas", ISC_MEMFLAG_LOOPARENAS, false },
 			  { NULL, 0, false } };
 
 static void
@@ -61,6 +61,7 @@
 #include <isc/string.h>
 #include <isc/time.h>
 #include <isc/timer.h>
+#include <isc/urcu.h>
 #include <isc/util.h>
 
 #include <dns/adb.h>
@@ -98,6 +99,7 @@
 #include <dns/resolver.h>
 #include <dns/rootns.h>
 #include <dns/rriterator.h>
+#include <dns/sdlz.h>
 #include <dns/secalg.h>
 #include <dns/soa.h>
 #include <dns/stats.h>
@@ -232,6 +234,12 @@
  */
 #define MAX_ADB_SIZE_FOR_CACHESHARE 8388608U
 
+/*%
+ * Default number of names in a DLZ answer cache, if "cache-ttl" is set
+ * without "cache-entries".
+ */
+#define DEFAULT_DLZ_CACHE_ENTRIES 65536U
+
 struct named_dispatch {
 	isc_sockaddr_t addr;
 	unsigned int dispatchgen;
@@ -278,6 +286,59 @@ struct zonelistentry {
 	ISC_LINK(struct zonelistentry) link;
 };
 
+/*%
+ * A change to an object that the running server is still using, such
+ * as a zone reused from a production view.  While load_configuration()
+ * builds the new views with the loops running these are queued, and
+ * they are applied after the loops have been paused to swap the new
+ * views in.  configure_zone() also uses this to describe the last steps
+ * of configuring a zone when there is nothing to defer.
+ */
+typedef enum {
+	reconfig_zone,	       /*%< zone, see configure_zone() */
+	reconfig_redirectzone, /*%< redirect zone */
+	reconfig_emptyzone,    /*%< automatic empty zone */
+	reconfig_ipv4onlyzone, /*%< automatic ipv4only zone */
+	reconfig_keyzone,      /*%< managed-keys zone */
+	reconfig_rpz,	       /*%< response policy summary */
+} reconfig_optype_t;
+
+typedef struct reconfig_op reconfig_op_t;
+struct reconfig_op {
+	reconfig_optype_t type;
+	dns_view_t *view;  /*%< the new view */
+	dns_view_t *pview; /*%< the production view */
+	dns_zone_t *zone;
+	const cfg_obj_t *config;
+	const cfg_obj_t *vconfig;
+	const cfg_obj_t *zconfig;
+	cfg_aclconfctx_t *aclconf;
+	dns_kasplist_t *kasplist;
+	dns_rpz_num_t rpz_num;
+	bool reused;
+	bool added;
+	bool catz;
+	bool inline_signing;
+	bool fullsign;
+	bool shared; /*%< the new view took over the production rpzs */
+	ISC_LINK(reconfig_op_t) link;
+};
+
+/*%
+ * State of a load_configuration() call.
+ */
+typedef struct reconfig {
+	isc_time_t pausetime;
+	uint64_t paused; /*%< time spent paused, in microseconds */
+	bool exclusive;	 /*%< the loops are paused */
+	ISC_LIST(reconfig_op_t) ops;
+} reconfig_t;
+
+/*%
+ * The reconfiguration whose views are being built, if any.
+ */
+static reconfig_t *reconfig = NULL;
+
 /*%
  * Configuration context to retain for each view that allows
  * new zones to be added at runtime.
@@ -448,6 +509,18 @@ static void
 configure_zone_setviewcommit(isc_result_t result, const cfg_obj_t *zconfig,
 			     dns_view_t *view);
 
+static isc_result_t
+configure_zone_setup(reconfig_op_t *op);
+
+static void
+configure_zone_finish(reconfig_op_t *op);
+
+static void
+reconfig_submit(const reconfig_op_t *op);
+
+static void
+reconfig_apply(reconfig_op_t *op);
+
 static isc_result_t
 configure_newzones(dns_view_t *view, cfg_obj_t *config, cfg_obj_t *vconfig,
 		   cfg_aclconfctx_t *actx);
@@ -2396,7 +2469,7 @@ configure_rpz_zone(dns_view_t *view, const cfg_listelt_t *element,
 }
 
 static isc_result_t
-configure_rpz(dns_view_t *view, dns_view_t *pview, const cfg_obj_t **maps,
+configure_rpz(dns_view_t *view, const cfg_obj_t **maps,
 	      const cfg_obj_t *rpz_obj, bool *old_rpz_okp) {
 	bool dnsrps_enabled;
 	const cfg_listelt_t *zone_element;
@@ -2410,7 +2483,7 @@ configure_rpz(dns_view_t *view, dns_view_t *pview, const cfg_obj_t **maps,
 	uint32_t minupdateinterval_default;
 	dns_rpz_zones_t *zones;
 	const dns_rpz_zones_t *old;
-	bool pview_must_detach = false;
+	dns_view_t *pview = NULL; /* Production view */
 	const dns_rpz_zone_t *old_zone;
 	isc_result_t result;
 	int i;
@@ -2555,17 +2628,12 @@ configure_rpz(dns_view_t *view, dns_view_t *pview, const cfg_obj_t **maps,
 		zones->p.nsip_wait_recurse = false;
 	}
 
-	if (pview != NULL) {
+	result = dns_viewlist_find(named_g_server->viewlist, view->name,
+				   view->rdclass, &pview);
+	if (result == ISC_R_SUCCESS) {
 		old = pview->rpzs;
 	} else {
-		result = dns_viewlist_find(&named_g_server->viewlist,
-					   view->name, view->rdclass, &pview);
-		if (result == ISC_R_SUCCESS) {
-			pview_must_detach = true;
-			old = pview->rpzs;
-		} else {
-			old = NULL;
-		}
+		old = NULL;
 	}
 
 	if (old == NULL) {
@@ -2589,7 +2657,7 @@ configure_rpz(dns_view_t *view, dns_view_t *pview, const cfg_obj_t **maps,
 			add_soa_default, ttl_default, minupdateinterval_default,
 			old_zone, old_rpz_okp);
 		if (result != ISC_R_SUCCESS) {
-			if (pview_must_detach) {
+			if (pview != NULL) {
 				dns_view_detach(&pview);
 			}
 			return (result);
@@ -2617,20 +2685,33 @@ configure_rpz(dns_view_t *view, dns_view_t *pview, const cfg_obj_t **maps,
 		}
 	}
 
+	/*
+	 * The production view keeps using its policy data until the new
+	 * views are swapped in; see reconfig_apply().
+	 */
 	if (*old_rpz_okp) {
+		reconfig_op_t op = { .type = reconfig_rpz,
+				     .view = view,
+				     .pview = pview,
+				     .shared = true };
+
 		dns_rpz_zones_shutdown(view->rpzs);
 		dns_rpz_zones_detach(&view->rpzs);
 		dns_rpz_zones_attach(pview->rpzs, &view->rpzs);
-		dns_rpz_zones_detach(&pview->rpzs);
-	} else if (old != NULL && pview != NULL) {
-		++pview->rpzs->rpz_ver;
-		view->rpzs->rpz_ver = pview->rpzs->rpz_ver;
+		reconfig_submit(&op);
+	} else if (old != NULL) {
+		reconfig_op_t op = { .type = reconfig_rpz,
+				     .view = view,
+				     .pview = pview };
+
+		view->rpzs->rpz_ver = pview->rpzs->rpz_ver + 1;
+		reconfig_submit(&op);
 		cfg_obj_log(rpz_obj, named_g_lctx, DNS_RPZ_DEBUG_LEVEL1,
 			    "updated RPZ policy: version %d",
 			    view->rpzs->rpz_ver);
 	}
 
-	if (pview_must_detach) {
+	if (pview != NULL) {
 		dns_view_detach(&pview);
 	}
 
@@ -2791,7 +2872,7 @@ catz_addmodzone_cb(void *arg) {
 	isc_loopmgr_pause(named_g_loopmgr);
 	dns_view_thaw(cz->view);
 	result = configure_zone(cfg->config, zoneobj, cfg->vconfig, cz->view,
-				&cz->cbd->server->viewlist,
+				cz->cbd->server->viewlist,
 				&cz->cbd->server->kasplist, cfg->actx, true,
 				false, cz->mod);
 	dns_view_freeze(cz->view);
@@ -3101,7 +3182,7 @@ configure_catz(dns_view_t *view, dns_view_t *pview, const cfg_obj_t *config,
 	if (pview != NULL) {
 		old = pview->catzs;
 	} else {
-		result = dns_viewlist_find(&named_g_server->viewlist,
+		result = dns_viewlist_find(named_g_server->viewlist,
 					   view->name, view->rdclass, &pview);
 		if (result == ISC_R_SUCCESS) {
 			pview_must_detach = true;
@@ -3367,6 +3448,51 @@ cleanup:
 	return (result);
 }
 
+/*
+ * Settings shared by new and reused automatic empty zones.  The zone is
+ * not moved to 'view' here; a reused zone is still serving the
+ * production view until the new views are committed.
+ */
+static isc_result_t
+setup_empty_zone(dns_zone_t *zone, dns_view_t *view, dns_db_t *db,
+		 dns_zonestat_level_t statlevel) {
+	isc_result_t result = ISC_R_SUCCESS;
+
+	dns_zone_setoption(zone, ~DNS_ZONEOPT_NOCHECKNS, false);
+	dns_zone_setoption(zone, DNS_ZONEOPT_NOCHECKNS, true);
+	dns_zone_setcheckdstype(zone, dns_checkdstype_no);
+	dns_zone_setnotifytype(zone, dns_notifytype_no);
+	dns_zone_setdialup(zone, dns_dialuptype_no);
+	dns_zone_setautomatic(zone, true);
+	if (view->queryacl != NULL) {
+		dns_zone_setqueryacl(zone, view->queryacl);
+	} else {
+		dns_zone_clearqueryacl(zone);
+	}
+	if (view->queryonacl != NULL) {
+		dns_zone_setqueryonacl(zone, view->queryonacl);
+	} else {
+		dns_zone_clearqueryonacl(zone);
+	}
+	dns_zone_clearupdateacl(zone);
+	if (view->transferacl != NULL) {
+		dns_zone_setxfracl(zone, view->transferacl);
+	} else {
+		dns_zone_clearxfracl(zone);
+	}
+
+	setquerystats(zone, view->mctx, statlevel);
+	if (db != NULL) {
+		result = dns_zone_replacedb(zone, db, false);
+		if (result != ISC_R_SUCCESS) {
+			return (result);
+		}
+	}
+	dns_zone_setoption(zone, DNS_ZONEOPT_AUTOEMPTY, true);
+
+	return (ISC_R_SUCCESS);
+}
+
 static isc_result_t
 create_empty_zone(dns_zone_t *pzone, dns_name_t *name, dns_view_t *view,
 		  const cfg_obj_t *zonelist, const char **empty_dbtype,
@@ -3501,36 +3627,19 @@ create_empty_zone(dns_zone_t *pzone, dns_name_t *name, dns_view_t *view,
 		dns_zone_attach(pzone, &zone);
 	}
 
-	dns_zone_setoption(zone, ~DNS_ZONEOPT_NOCHECKNS, false);
-	dns_zone_setoption(zone, DNS_ZONEOPT_NOCHECKNS, true);
-	dns_zone_setcheckdstype(zone, dns_checkdstype_no);
-	dns_zone_setnotifytype(zone, dns_notifytype_no);
-	dns_zone_setdialup(zone, dns_dialuptype_no);
-	dns_zone_setautomatic(zone, true);
-	if (view->queryacl != NULL) {
-		dns_zone_setqueryacl(zone, view->queryacl);
-	} else {
-		dns_zone_clearqueryacl(zone);
-	}
-	if (view->queryonacl != NULL) {
-		dns_zone_setqueryonacl(zone, view->queryonacl);
-	} else {
-		dns_zone_clearqueryonacl(zone);
-	}
-	dns_zone_clearupdateacl(zone);
-	if (view->transferacl != NULL) {
-		dns_zone_setxfracl(zone, view->transferacl);
-	} else {
-		dns_zone_clearxfracl(zone);
-	}
-
-	setquerystats(zone, view->mctx, statlevel);
 	if (db != NULL) {
 		dns_db_closeversion(db, &version, true);
-		CHECK(dns_zone_replacedb(zone, db, false));
 	}
-	dns_zone_setoption(zone, DNS_ZONEOPT_AUTOEMPTY, true);
-	dns_zone_setview(zone, view);
+	CHECK(setup_empty_zone(zone, view, db, statlevel));
+	if (pzone != NULL) {
+		reconfig_op_t op = { .type = reconfig_emptyzone,
+				     .view = view,
+				     .zone = zone };
+
+		reconfig_submit(&op);
+	} else {
+		dns_zone_setview(zone, view);
+	}
 	CHECK(dns_view_addzone(view, zone));
 
 	if (!strcmp(viewname, "_default")) {
@@ -3558,6 +3667,24 @@ cleanup:
 	return (result);
 }
 
+/*
+ * Settings shared by new and reused automatic ipv4only zones.
+ */
+static void
+setup_ipv4only_zone(dns_zone_t *zone, dns_view_t *view) {
+	if (view->queryacl != NULL) {
+		dns_zone_setqueryacl(zone, view->queryacl);
+	} else {
+		dns_zone_clearqueryacl(zone);
+	}
+	if (view->queryonacl != NULL) {
+		dns_zone_setqueryonacl(zone, view->queryonacl);
+	} else {
+		dns_zone_clearqueryonacl(zone);
+	}
+	dns_zone_setview(zone, view);
+}
+
 static isc_result_t
 create_ipv4only_zone(dns_zone_t *pzone, dns_view_t *view,
 		     const dns_name_t *name, const char *type, isc_mem_t *mctx,
@@ -3611,17 +3738,15 @@ create_ipv4only_zone(dns_zone_t *pzone, dns_view_t *view,
 	} else {
 		dns_zone_attach(pzone, &zone);
 	}
-	if (view->queryacl != NULL) {
-		dns_zone_setqueryacl(zone, view->queryacl);
-	} else {
-		dns_zone_clearqueryacl(zone);
-	}
-	if (view->queryonacl != NULL) {
-		dns_zone_setqueryonacl(zone, view->queryonacl);
+	if (pzone != NULL) {
+		reconfig_op_t op = { .type = reconfig_ipv4onlyzone,
+				     .view = view,
+				     .zone = zone };
+
+		reconfig_submit(&op);
 	} else {
-		dns_zone_clearqueryonacl(zone);
+		setup_ipv4only_zone(zone, view);
 	}
-	dns_zone_setview(zone, view);
 	CHECK(dns_view_addzone(view, zone));
 
 	dns_name_format(name, namebuf, sizeof(namebuf));
@@ -4011,7 +4136,6 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	dns_view_t *pview = NULL; /* Production view */
 	dns_dispatch_t *dispatch4 = NULL;
 	dns_dispatch_t *dispatch6 = NULL;
-	bool rpz_configured = false;
 	bool catz_configured = false;
 	bool shared_cache = false;
 	int i = 0, j = 0, k = 0;
@@ -4083,8 +4207,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	if (view->rdclass == dns_rdataclass_in && need_hints &&
 	    named_config_get(maps, "response-policy", &obj) == ISC_R_SUCCESS)
 	{
-		CHECK(configure_rpz(view, NULL, maps, obj, &old_rpz_ok));
-		rpz_configured = true;
+		CHECK(configure_rpz(view, maps, obj, &old_rpz_ok));
 	}
 
 	obj = NULL;
@@ -4104,6 +4227,44 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 		catz_configured = true;
 	}
 
+	/*
+	 * Set the view defaults of the ACLs that zones inherit before any
+	 * zone is configured.  configure_zone_acl() would otherwise set
+	 * them from whichever zone happens to be configured first, which
+	 * may be a zone reconfigured only after the view is complete, or
+	 * none at all when every zone is reused unchanged.
+	 */
+	if (view->notifyacl == NULL) {
+		CHECK(configure_view_acl(vconfig, config, named_g_config,
+					 "allow-notify", NULL, actx,
+					 named_g_mctx, &view->notifyacl));
+	}
+	if (view->queryacl == NULL) {
+		CHECK(configure_view_acl(vconfig, config, named_g_config,
+					 "allow-query", NULL, actx,
+					 named_g_mctx, &view->queryacl));
+	}
+	if (view->queryonacl == NULL) {
+		CHECK(configure_view_acl(vconfig, config, named_g_config,
+					 "allow-query-on", NULL, actx,
+					 named_g_mctx, &view->queryonacl));
+	}
+	if (view->transferacl == NULL) {
+		CHECK(configure_view_acl(vconfig, config, named_g_config,
+					 "allow-transfer", NULL, actx,
+					 named_g_mctx, &view->transferacl));
+	}
+	if (view->updateacl == NULL) {
+		CHECK(configure_view_acl(vconfig, config, named_g_config,
+					 "allow-update", NULL, actx,
+					 named_g_mctx, &view->updateacl));
+	}
+	if (view->upfwdacl == NULL) {
+		CHECK(configure_view_acl(vconfig, config, named_g_config,
+					 "allow-update-forwarding", NULL, actx,
+					 named_g_mctx, &view->upfwdacl));
+	}
+
 	/*
 	 * Configure the zones.
 	 */
@@ -4180,6 +4341,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 		if (obj != NULL) {
 			dns_dlzdb_t *dlzdb = NULL;
 			const cfg_obj_t *name, *search = NULL;
+			const cfg_obj_t *cachettl = NULL, *cacheentries = NULL;
 			char *s = isc_mem_strdup(mctx, cfg_obj_asstring(obj));
 
 			if (s == NULL) {
@@ -4204,6 +4366,30 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 				goto cleanup;
 			}
 
+			(void)cfg_map_get(dlz, "cache-ttl", &cachettl);
+			(void)cfg_map_get(dlz, "cache-entries", &cacheentries);
+			if (cachettl != NULL &&
+			    cfg_obj_asduration(cachettl) > 0 &&
+			    (cacheentries == NULL ||
+			     cfg_obj_asuint32(cacheentries) > 0))
+			{
+				result = dns_sdlz_setcache(
+					dlzdb, cfg_obj_asduration(cachettl),
+					cacheentries != NULL
+						? cfg_obj_asuint32(cacheentries)
+						: DEFAULT_DLZ_CACHE_ENTRIES);
+				if (result != ISC_R_SUCCESS) {
+					cfg_obj_log(cachettl, named_g_lctx,
+						    ISC_LOG_ERROR,
+						    "dlz '%s': cannot cache "
+						    "answers: %s",
+						    cfg_obj_asstring(name),
+						    isc_result_totext(result));
+					dns_dlzdestroy(&dlzdb);
+					goto cleanup;
+				}
+			}
+
 			/*
 			 * If the DLZ backend supports configuration,
 			 * and is searchable, then call its configure
@@ -4449,6 +4635,11 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	INSIST(result == ISC_R_SUCCESS);
 	view->acceptexpired = cfg_obj_asboolean(obj);
 
+	obj = NULL;
+	result = named_config_get(maps, "dnssec-chain-prefetch", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	view->chainprefetch = cfg_obj_asboolean(obj);
+
 	obj = NULL;
 	/* 'optionmaps', not 'maps': don't check named_g_defaults yet */
 	(void)named_config_get(optionmaps, "dnssec-validation", &obj);
@@ -4516,7 +4707,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	INSIST(result == ISC_R_SUCCESS);
 	view->staleanswersenable = cfg_obj_asboolean(obj);
 
-	result = dns_viewlist_find(&named_g_server->viewlist, view->name,
+	result = dns_viewlist_find(named_g_server->viewlist, view->name,
 				   view->rdclass, &pview);
 	if (result == ISC_R_SUCCESS) {
 		view->staleanswersok = pview->staleanswersok;
@@ -4596,7 +4787,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 		shared_cache = true;
 	} else {
 		if (strcmp(cachename, view->name) == 0) {
-			result = dns_viewlist_find(&named_g_server->viewlist,
+			result = dns_viewlist_find(named_g_server->viewlist,
 						   cachename, view->rdclass,
 						   &pview);
 			if (result != ISC_R_NOTFOUND && result != ISC_R_SUCCESS)
@@ -4905,6 +5096,10 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 		dns_resolver_setnonbackofftries(view->resolver, resolver_param);
 	}
 
+	obj = NULL;
+	CHECK(named_config_get(maps, "resolver-hedge-ratio", &obj));
+	dns_resolver_sethedgeratio(view->resolver, cfg_obj_aspercentage(obj));
+
 	/*
 	 * Set supported DNSSEC algorithms.
 	 */
@@ -5016,7 +5211,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 	/*
 	 * See if we can re-use a dynamic key ring.
 	 */
-	result = dns_viewlist_find(&named_g_server->viewlist, view->name,
+	result = dns_viewlist_find(named_g_server->viewlist, view->name,
 				   view->rdclass, &pview);
 	if (result != ISC_R_NOTFOUND && result != ISC_R_SUCCESS) {
 		goto cleanup;
@@ -5731,7 +5926,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 			/*
 			 * See if we can re-use a existing zone.
 			 */
-			result = dns_viewlist_find(&named_g_server->viewlist,
+			result = dns_viewlist_find(named_g_server->viewlist,
 						   view->name, view->rdclass,
 						   &pview);
 			if (result != ISC_R_NOTFOUND && result != ISC_R_SUCCESS)
@@ -5827,7 +6022,7 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 			/*
 			 * See if we can re-use a existing zone.
 			 */
-			result = dns_viewlist_find(&named_g_server->viewlist,
+			result = dns_viewlist_find(named_g_server->viewlist,
 						   view->name, view->rdclass,
 						   &pview);
 			if (result != ISC_R_NOTFOUND && result != ISC_R_SUCCESS)
@@ -5922,42 +6117,19 @@ configure_view(dns_view_t *view, dns_viewlist_t *viewlist, cfg_obj_t *config,
 
 cleanup:
 	/*
-	 * Revert to the old view if there was an error.
+	 * Revert to the old view if there was an error.  Response policy
+	 * changes are only applied to the production view once the new
+	 * views are committed, so only the catalog zones need reverting;
+	 * catalog zones are never configured while the loops are running.
 	 */
-	if (result != ISC_R_SUCCESS) {
+	if (result != ISC_R_SUCCESS && catz_configured) {
 		isc_result_t result2;
 
-		result2 = dns_viewlist_find(&named_g_server->viewlist,
+		result2 = dns_viewlist_find(named_g_server->viewlist,
 					    view->name, view->rdclass, &pview);
 		if (result2 == ISC_R_SUCCESS) {
 			dns_view_thaw(pview);
 
-			obj = NULL;
-			if (rpz_configured &&
-			    pview->rdclass == dns_rdataclass_in && need_hints &&
-			    named_config_get(maps, "response-policy", &obj) ==
-				    ISC_R_SUCCESS)
-			{
-				/*
-				 * We are swapping the places of the `view` and
-				 * `pview` in the function's parameters list
-				 * because we are reverting the same operation
-				 * done previously in the "correct" order.
-				 */
-				result2 = configure_rpz(pview, view, maps, obj,
-							&old_rpz_ok);
-				if (result2 != ISC_R_SUCCESS) {
-					isc_log_write(named_g_lctx,
-						      NAMED_LOGCATEGORY_GENERAL,
-						      NAMED_LOGMODULE_SERVER,
-						      ISC_LOG_ERROR,
-						      "rpz configuration "
-						      "revert failed for view "
-						      "'%s'",
-						      pview->name);
-				}
-			}
-
 			obj = NULL;
 			if (catz_configured &&
 			    pview->rdclass == dns_rdataclass_in && need_hints &&
@@ -6444,7 +6616,6 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	       bool modify) {
 	dns_view_t *pview = NULL; /* Production view */
 	dns_zone_t *zone = NULL;  /* New or reused zone */
-	dns_zone_t *raw = NULL;	  /* New or reused raw zone */
 	dns_zone_t *dupzone = NULL;
 	const cfg_obj_t *options = NULL;
 	const cfg_obj_t *zoptions = NULL;
@@ -6454,7 +6625,6 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	const cfg_obj_t *ixfrfromdiffs = NULL;
 	const cfg_obj_t *viewobj = NULL;
 	isc_result_t result = ISC_R_SUCCESS;
-	isc_result_t tresult;
 	isc_buffer_t buffer;
 	dns_fixedname_t fixorigin;
 	dns_name_t *origin;
@@ -6466,6 +6636,8 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	bool zone_maybe_inline = false;
 	bool inline_signing = false;
 	bool fullsign = false;
+	bool reused = false;
+	reconfig_op_t op;
 
 	options = NULL;
 	(void)cfg_map_get(config, "options", &options);
@@ -6624,18 +6796,26 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 		}
 		if (pview != NULL && pview->redirect != NULL) {
 			dns_zone_attach(pview->redirect, &zone);
-			dns_zone_setview(zone, view);
+			reused = true;
 		} else {
 			CHECK(dns_zonemgr_createzone(named_g_server->zonemgr,
 						     &zone));
 			CHECK(dns_zone_setorigin(zone, origin));
-			dns_zone_setview(zone, view);
 			CHECK(dns_zonemgr_managezone(named_g_server->zonemgr,
 						     zone));
 			dns_zone_setstats(zone, named_g_server->zonestats);
 		}
+		if (!reused) {
+			dns_zone_setview(zone, view);
+		}
 		CHECK(named_zone_configure(config, vconfig, zconfig, aclconf,
-					   kasplist, zone, NULL));
+					   kasplist, view, zone, NULL));
+		if (reused) {
+			op = (reconfig_op_t){ .type = reconfig_redirectzone,
+					      .view = view,
+					      .zone = zone };
+			reconfig_submit(&op);
+		}
 		dns_zone_attach(zone, &view->redirect);
 		goto cleanup;
 	}
@@ -6695,7 +6875,7 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	 *     or the zone is a policy zone with an unchanged number
 	 *     and we are using the old policy zone summary data.
 	 */
-	result = dns_viewlist_find(&named_g_server->viewlist, view->name,
+	result = dns_viewlist_find(named_g_server->viewlist, view->name,
 				   view->rdclass, &pview);
 	if (result != ISC_R_NOTFOUND && result != ISC_R_SUCCESS) {
 		goto cleanup;
@@ -6721,13 +6901,7 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 		dns_zone_detach(&zone);
 	}
 
-	if (zone != NULL) {
-		/*
-		 * We found a reusable zone.  Make it use the
-		 * new view.
-		 */
-		dns_zone_setview(zone, view);
-	} else {
+	if (zone == NULL) {
 		/*
 		 * We cannot reuse an existing zone, we have
 		 * to create a new one.
@@ -6737,24 +6911,8 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 		dns_zone_setview(zone, view);
 		CHECK(dns_zonemgr_managezone(named_g_server->zonemgr, zone));
 		dns_zone_setstats(zone, named_g_server->zonestats);
-	}
-	if (rpz_num != DNS_RPZ_INVALID_NUM) {
-		result = dns_zone_rpz_enable(zone, view->rpzs, rpz_num);
-		if (result != ISC_R_SUCCESS) {
-			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
-				      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
-				      "zone '%s': incompatible"
-				      " masterfile-format or database"
-				      " for a response policy zone",
-				      zname);
-			goto cleanup;
-		}
-	}
-
-	if (zone_is_catz) {
-		dns_zone_catz_enable(zone, view->catzs);
-	} else if (dns_zone_catz_is_enabled(zone)) {
-		dns_zone_catz_disable(zone);
+	} else {
+		reused = true;
 	}
 
 	/*
@@ -6769,11 +6927,6 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 					forwardtype));
 	}
 
-	/*
-	 * Mark whether the zone was originally added at runtime or not
-	 */
-	dns_zone_setadded(zone, added);
-
 	/*
 	 * Determine if we need to set up inline signing.
 	 */
@@ -6786,50 +6939,155 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 		inline_signing = named_zone_inlinesigning(zconfig, vconfig,
 							  config, kasplist);
 	}
-	if (inline_signing) {
-		dns_zone_getraw(zone, &raw);
-		if (raw == NULL) {
-			dns_zone_create(&raw, dns_zone_getmem(zone),
-					dns_zone_gettid(zone));
-			CHECK(dns_zone_setorigin(raw, origin));
-			dns_zone_setview(raw, view);
-			dns_zone_setstats(raw, named_g_server->zonestats);
-			CHECK(dns_zone_link(zone, raw));
-		}
-		if (cfg_map_get(zoptions, "ixfr-from-differences",
-				&ixfrfromdiffs) == ISC_R_SUCCESS)
-		{
-			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
-				      NAMED_LOGMODULE_SERVER, ISC_LOG_INFO,
-				      "zone '%s': 'ixfr-from-differences' is "
-				      "ignored for inline-signed zones",
-				      zname);
-		}
+	if (inline_signing &&
+	    cfg_map_get(zoptions, "ixfr-from-differences", &ixfrfromdiffs) ==
+		    ISC_R_SUCCESS)
+	{
+		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+			      NAMED_LOGMODULE_SERVER, ISC_LOG_INFO,
+			      "zone '%s': 'ixfr-from-differences' is "
+			      "ignored for inline-signed zones",
+			      zname);
+	}
+
+	op = (reconfig_op_t){ .type = reconfig_zone,
+			      .view = view,
+			      .zone = zone,
+			      .config = config,
+			      .vconfig = vconfig,
+			      .zconfig = zconfig,
+			      .aclconf = aclconf,
+			      .kasplist = kasplist,
+			      .rpz_num = rpz_num,
+			      .reused = reused,
+			      .added = added,
+			      .catz = zone_is_catz,
+			      .inline_signing = inline_signing,
+			      .fullsign = fullsign };
+
+	CHECK(configure_zone_setup(&op));
+
+	if (reused && reconfig != NULL) {
+		/*
+		 * The zone is still serving the production view; it is
+		 * moved over to the new view once the new views are
+		 * committed.  Until then the new view only holds a
+		 * reference.
+		 */
+		INSIST(!modify);
+		CHECK(dns_view_addzone(view, zone));
+		reconfig_submit(&op);
+		goto cleanup;
 	}
 
 	/*
-	 * Configure the zone.
+	 * Add the zone to its view in the new view list.
 	 */
-	CHECK(named_zone_configure(config, vconfig, zconfig, aclconf, kasplist,
-				   zone, raw));
+	if (!modify) {
+		CHECK(dns_view_addzone(view, zone));
+	}
+
+	configure_zone_finish(&op);
+
+cleanup:
+	if (zone != NULL) {
+		dns_zone_detach(&zone);
+	}
+	if (pview != NULL) {
+		dns_view_detach(&pview);
+	}
+
+	return (result);
+}
+
+/*
+ * Configure the zone described by 'op' for 'op->view'.  A new zone is
+ * already attached to 'op->view'; a reused one is still attached to its
+ * production view and is only moved by configure_zone_finish().
+ */
+static isc_result_t
+configure_zone_setup(reconfig_op_t *op) {
+	isc_result_t result;
+	dns_zone_t *zone = op->zone;
+	dns_zone_t *raw = NULL;
+	dns_view_t *view = op->view;
+	const char *zname;
+
+	if (op->rpz_num != DNS_RPZ_INVALID_NUM) {
+		result = dns_zone_rpz_enable(zone, view->rpzs, op->rpz_num);
+		if (result != ISC_R_SUCCESS) {
+			zname = cfg_obj_asstring(
+				cfg_tuple_get(op->zconfig, "name"));
+			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+				      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+				      "zone '%s': incompatible"
+				      " masterfile-format or database"
+				      " for a response policy zone",
+				      zname);
+			return (result);
+		}
+	}
+
+	if (op->inline_signing) {
+		dns_zone_getraw(zone, &raw);
+		if (raw == NULL) {
+			dns_zone_create(&raw, dns_zone_getmem(zone),
+					dns_zone_gettid(zone));
+			CHECK(dns_zone_setorigin(raw, dns_zone_getorigin(zone)));
+			dns_zone_setview(raw, view);
+			dns_zone_setstats(raw, named_g_server->zonestats);
+			CHECK(dns_zone_link(zone, raw));
+		}
+	}
 
 	/*
-	 * Add the zone to its view in the new view list.
+	 * Configure the zone.
 	 */
-	if (!modify) {
-		CHECK(dns_view_addzone(view, zone));
+	CHECK(named_zone_configure(op->config, op->vconfig, op->zconfig,
+				   op->aclconf, op->kasplist, view, zone,
+				   raw));
+
+cleanup:
+	if (raw != NULL) {
+		dns_zone_detach(&raw);
+	}
+
+	return (result);
+}
+
+/*
+ * Move a reused zone over to its view, and act on the configuration of
+ * the zone once it is in use by that view.  This can't fail, so that it
+ * can be done with the loops paused once the new views are complete.
+ */
+static void
+configure_zone_finish(reconfig_op_t *op) {
+	dns_zone_t *zone = op->zone;
+
+	if (op->reused) {
+		dns_zone_setview(zone, op->view);
+	}
+
+	if (op->catz) {
+		dns_zone_catz_enable(zone, op->view->catzs);
+	} else if (dns_zone_catz_is_enabled(zone)) {
+		dns_zone_catz_disable(zone);
 	}
 
-	if (zone_is_catz) {
+	/*
+	 * Mark whether the zone was originally added at runtime or not
+	 */
+	dns_zone_setadded(zone, op->added);
+
+	if (op->catz) {
 		/*
 		 * force catz reload if the zone is loaded;
 		 * if it's not it'll get reloaded on zone load
 		 */
 		dns_db_t *db = NULL;
 
-		tresult = dns_zone_getdb(zone, &db);
-		if (tresult == ISC_R_SUCCESS) {
-			dns_catz_dbupdate_callback(db, view->catzs);
+		if (dns_zone_getdb(zone, &db) == ISC_R_SUCCESS) {
+			dns_catz_dbupdate_callback(db, op->view->catzs);
 			dns_db_detach(&db);
 		}
 	}
@@ -6838,21 +7096,8 @@ configure_zone(const cfg_obj_t *config, const cfg_obj_t *zconfig,
 	 * Ensure that zone keys are reloaded on reconfig
 	 */
 	if ((dns_zone_getkeyopts(zone) & DNS_ZONEKEY_MAINTAIN) != 0) {
-		dns_zone_rekey(zone, fullsign);
-	}
-
-cleanup:
-	if (zone != NULL) {
-		dns_zone_detach(&zone);
-	}
-	if (raw != NULL) {
-		dns_zone_detach(&raw);
-	}
-	if (pview != NULL) {
-		dns_view_detach(&pview);
+		dns_zone_rekey(zone, op->fullsign);
 	}
-
-	return (result);
 }
 
 /*
@@ -6870,7 +7115,7 @@ add_keydata_zone(dns_view_t *view, const char *directory, isc_mem_t *mctx) {
 	REQUIRE(view != NULL);
 
 	/* See if we can re-use an existing keydata zone. */
-	result = dns_viewlist_find(&named_g_server->viewlist, view->name,
+	result = dns_viewlist_find(named_g_server->viewlist, view->name,
 				   view->rdclass, &pview);
 	if (result != ISC_R_NOTFOUND && result != ISC_R_SUCCESS) {
 		return (result);
@@ -6878,12 +7123,14 @@ add_keydata_zone(dns_view_t *view, const char *directory, isc_mem_t *mctx) {
 
 	if (pview != NULL) {
 		if (pview->managed_keys != NULL) {
+			reconfig_op_t op = { .type = reconfig_keyzone,
+					     .view = view,
+					     .zone = pview->managed_keys };
+
 			dns_zone_attach(pview->managed_keys,
 					&view->managed_keys);
-			dns_zone_setview(pview->managed_keys, view);
-			dns_zone_setviewcommit(pview->managed_keys);
+			reconfig_submit(&op);
 			dns_view_detach(&pview);
-			dns_zone_synckeyzone(view->managed_keys);
 			return (ISC_R_SUCCESS);
 		}
 
@@ -6956,18 +7203,230 @@ configure_server_quota(const cfg_obj_t **maps, const char *name,
 	isc_quota_max(quota, cfg_obj_asuint32(obj));
 }
 
+/*
+ * Take the references needed to queue 'op', or apply it right away when
+ * there is no reconfiguration in progress.
+ */
+static void
+reconfig_submit(const reconfig_op_t *op) {
+	reconfig_op_t *rop = NULL;
+
+	if (reconfig == NULL) {
+		reconfig_op_t copy = *op;
+
+		reconfig_apply(&copy);
+		return;
+	}
+
+	rop = isc_mem_get(named_g_mctx, sizeof(*rop));
+	*rop = *op;
+	rop->view = NULL;
+	rop->pview = NULL;
+	rop->zone = NULL;
+	ISC_LINK_INIT(rop, link);
+
+	if (op->view != NULL) {
+		dns_view_attach(op->view, &rop->view);
+	}
+	if (op->pview != NULL) {
+		dns_view_attach(op->pview, &rop->pview);
+	}
+	if (op->zone != NULL) {
+		dns_zone_attach(op->zone, &rop->zone);
+	}
+	ISC_LIST_APPEND(reconfig->ops, rop, link);
+}
+
+/*
+ * Apply 'op'.  Everything that can fail has been done while the new
+ * views were built, so this can't fail.
+ */
+static void
+reconfig_apply(reconfig_op_t *op) {
+	switch (op->type) {
+	case reconfig_zone:
+		configure_zone_finish(op);
+		break;
+	case reconfig_redirectzone:
+	case reconfig_emptyzone:
+		dns_zone_setview(op->zone, op->view);
+		break;
+	case reconfig_ipv4onlyzone:
+		setup_ipv4only_zone(op->zone, op->view);
+		break;
+	case reconfig_keyzone:
+		dns_zone_setview(op->zone, op->view);
+		dns_zone_setviewcommit(op->zone);
+		dns_zone_synckeyzone(op->zone);
+		break;
+	case reconfig_rpz:
+		if (op->shared) {
+			dns_rpz_zones_detach(&op->pview->rpzs);
+		} else {
+			op->pview->rpzs->rpz_ver = op->view->rpzs->rpz_ver;
+		}
+		break;
+	default:
+		UNREACHABLE();
+	}
+}
+
+static void
+reconfig_freeop(reconfig_op_t **opp) {
+	reconfig_op_t *op = *opp;
+
+	*opp = NULL;
+
+	if (op->zone != NULL) {
+		dns_zone_detach(&op->zone);
+	}
+	if (op->pview != NULL) {
+		dns_view_detach(&op->pview);
+	}
+	if (op->view != NULL) {
+		dns_view_detach(&op->view);
+	}
+	isc_mem_put(named_g_mctx, op, sizeof(*op));
+}
+
+/*
+ * Apply the queued changes; the loops must be paused.  None of them can
+ * fail, so the production views are never left half switched over.
+ */
+static void
+reconfig_commit(reconfig_t *rc) {
+	reconfig_op_t *op = NULL;
+
+	REQUIRE(rc->exclusive);
+
+	while ((op = ISC_LIST_HEAD(rc->ops)) != NULL) {
+		ISC_LIST_UNLINK(rc->ops, op, link);
+		reconfig_apply(op);
+		reconfig_freeop(&op);
+	}
+}
+
+/*
+ * Drop the changes that were not applied.
+ */
+static void
+reconfig_discard(reconfig_t *rc) {
+	reconfig_op_t *op = NULL;
+
+	while ((op = ISC_LIST_HEAD(rc->ops)) != NULL) {
+		ISC_LIST_UNLINK(rc->ops, op, link);
+		if (op->type == reconfig_rpz && op->shared) {
+			/*
+			 * The new view shares the production policy
+			 * data; make sure that discarding the new view
+			 * does not shut it down.
+			 */
+			dns_rpz_zones_detach(&op->view->rpzs);
+		}
+		reconfig_freeop(&op);
+	}
+}
+
+/*
+ * Return true if the new views can be built while the loops are running.
+ * Dynamically loaded databases and catalog zones keep state that the
+ * production views are using, and the DNSRPS provider is global, so when
+ * any of them is in use the views are built with the loops paused.
+ */
+static bool
+reconfig_canstage(const cfg_obj_t *config, const cfg_obj_t **maps,
+		  named_server_t *server) {
+	const cfg_obj_t *views = NULL;
+	const cfg_obj_t *obj = NULL;
+	const cfg_listelt_t *element = NULL;
+
+	if (cfg_map_get(config, "dyndb", &obj) == ISC_R_SUCCESS) {
+		return (false);
+	}
+	obj = NULL;
+	if (named_config_get(maps, "catalog-zones", &obj) == ISC_R_SUCCESS) {
+		return (false);
+	}
+#ifdef USE_DNSRPS
+	obj = NULL;
+	if (named_config_get(maps, "dnsrps-library", &obj) == ISC_R_SUCCESS) {
+		return (false);
+	}
+#endif /* ifdef USE_DNSRPS */
+
+	(void)cfg_map_get(config, "view", &views);
+	for (element = cfg_list_first(views); element != NULL;
+	     element = cfg_list_next(element))
+	{
+		const cfg_obj_t *voptions =
+			cfg_tuple_get(cfg_listelt_value(element), "options");
+
+		obj = NULL;
+		if (cfg_map_get(voptions, "dyndb", &obj) == ISC_R_SUCCESS) {
+			return (false);
+		}
+		obj = NULL;
+		if (cfg_map_get(voptions, "catalog-zones", &obj) ==
+		    ISC_R_SUCCESS)
+		{
+			return (false);
+		}
+	}
+
+	for (dns_view_t *view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
+	     view = ISC_LIST_NEXT(view, link))
+	{
+		if (view->catzs != NULL) {
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+/*
+ * Pause and resume all loops for reconfiguration, accumulating the time
+ * spent paused in 'rc->paused' (in microseconds).
+ */
+static void
+reconfig_pause(reconfig_t *rc) {
+	REQUIRE(!rc->exclusive);
+
+	isc_loopmgr_pause(named_g_loopmgr);
+	rc->pausetime = isc_time_now_hires();
+	rc->exclusive = true;
+}
+
+static void
+reconfig_resume(reconfig_t *rc) {
+	isc_time_t now = isc_time_now_hires();
+
+	REQUIRE(rc->exclusive);
+
+	rc->paused += isc_time_microdiff(&now, &rc->pausetime);
+	rc->exclusive = false;
+	isc_loopmgr_resume(named_g_loopmgr);
+}
+
 /*
  * This function is called as soon as the 'directory' statement has been
  * parsed.  This can be extended to support other options if necessary.
+ *
+ * Relative paths in the configuration are resolved against the working
+ * directory, so the loops have to be paused before it is changed; 'arg'
+ * is the reconfig_t of the load_configuration() call, which then builds
+ * the new views with the loops paused.  Reloading with an unchanged
+ * directory does not pause anything.
  */
 static isc_result_t
 directory_callback(const char *clausename, const cfg_obj_t *obj, void *arg) {
 	isc_result_t result;
 	const char *directory;
+	reconfig_t *rc = arg;
+	struct stat cwd, dir;
 
 	REQUIRE(strcasecmp("directory", clausename) == 0);
 
-	UNUSED(arg);
 	UNUSED(clausename);
 
 	/*
@@ -6988,6 +7447,16 @@ directory_callback(const char *clausename, const cfg_obj_t *obj, void *arg) {
 		return (ISC_R_NOPERM);
 	}
 
+	if (stat(".", &cwd) == 0 && stat(directory, &dir) == 0 &&
+	    cwd.st_dev == dir.st_dev && cwd.st_ino == dir.st_ino)
+	{
+		return (ISC_R_SUCCESS);
+	}
+
+	if (rc != NULL && !rc->exclusive) {
+		reconfig_pause(rc);
+	}
+
 	result = isc_dir_chdir(directory);
 	if (result != ISC_R_SUCCESS) {
 		cfg_obj_log(obj, named_g_lctx, ISC_LOG_ERROR,
@@ -7016,7 +7485,7 @@ heartbeat_timer_tick(void *arg) {
 	named_server_t *server = (named_server_t *)arg;
 	dns_view_t *view = NULL;
 
-	view = ISC_LIST_HEAD(server->viewlist);
+	view = ISC_LIST_HEAD(*server->viewlist);
 	while (view != NULL) {
 		dns_view_dialup(view);
 		view = ISC_LIST_NEXT(view, link);
@@ -7284,7 +7753,7 @@ tat_timer_tick(void *arg) {
 	dns_view_t *view = NULL;
 	dns_keytable_t *secroots = NULL;
 
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (!view->trust_anchor_telemetry || !view->enablevalidation) {
@@ -7761,7 +8230,7 @@ configure_zone_setviewcommit(isc_result_t result, const cfg_obj_t *zconfig,
 		return;
 	}
 
-	result2 = dns_viewlist_find(&named_g_server->viewlist, view->name,
+	result2 = dns_viewlist_find(named_g_server->viewlist, view->name,
 				    view->rdclass, &pview);
 	if (result2 != ISC_R_SUCCESS) {
 		return;
@@ -7810,7 +8279,7 @@ configure_newzones(dns_view_t *view, cfg_obj_t *config, cfg_obj_t *vconfig,
 	{
 		const cfg_obj_t *zconfig = cfg_listelt_value(element);
 		CHECK(configure_zone(config, zconfig, vconfig, view,
-				     &named_g_server->viewlist,
+				     named_g_server->viewlist,
 				     &named_g_server->kasplist, actx, true,
 				     false, false));
 	}
@@ -7995,7 +8464,7 @@ configure_newzone(const cfg_obj_t *zconfig, cfg_obj_t *config,
 		  cfg_obj_t *vconfig, dns_view_t *view,
 		  cfg_aclconfctx_t *actx) {
 	return (configure_zone(
-		config, zconfig, vconfig, view, &named_g_server->viewlist,
+		config, zconfig, vconfig, view, named_g_server->viewlist,
 		&named_g_server->kasplist, actx, true, false, false));
 }
 
@@ -8147,8 +8616,8 @@ load_configuration(const char *filename, named_server_t *server,
 	const cfg_obj_t *views;
 
 	dns_view_t *view_next = NULL;
-	dns_viewlist_t tmpviewlist;
 	dns_viewlist_t viewlist, builtin_viewlist;
+	dns_viewlist_t *newviewlist = NULL, *oldviewlist = NULL;
 	in_port_t listen_port, udpport_low, udpport_high;
 	int i, backlog;
 	isc_interval_t interval;
@@ -8172,7 +8641,9 @@ load_configuration(const char *filename, named_server_t *server,
 	uint32_t max;
 	uint64_t initial, idle, keepalive, advertised;
 	bool loadbalancesockets;
-	bool exclusive = true;
+	bool iouring;
+	bool staged;
+	reconfig_t rc = { .paused = 0 };
 	dns_aclenv_t *env =
 		ns_interfacemgr_getaclenv(named_g_server->interfacemgr);
 
@@ -8186,23 +8657,17 @@ load_configuration(const char *filename, named_server_t *server,
 	ISC_LIST_INIT(builtin_viewlist);
 	ISC_LIST_INIT(cachelist);
 	ISC_LIST_INIT(altsecrets);
-
-	/* Ensure exclusive access to configuration data. */
-	isc_loopmgr_pause(named_g_loopmgr);
-
-	/* Create the ACL configuration context */
-	if (named_g_aclconfctx != NULL) {
-		cfg_aclconfctx_detach(&named_g_aclconfctx);
-	}
-	result = cfg_aclconfctx_create(named_g_mctx, &named_g_aclconfctx);
-	if (result != ISC_R_SUCCESS) {
-		goto cleanup_exclusive;
-	}
+	ISC_LIST_INIT(rc.ops);
 
 	/*
-	 * Shut down all dyndb instances.
+	 * Parsing and checking the configuration and building the new
+	 * views don't touch any state used by the running server, so they
+	 * are done before the loops are paused; with many zones these are
+	 * the most expensive steps.  The changes to shared objects, such as
+	 * zones that are reused from the production views, are queued and
+	 * applied with the loops paused, right before the new views are
+	 * swapped in.
 	 */
-	dns_dyndb_cleanup(false);
 
 	/*
 	 * Parse the global default pseudo-config file.
@@ -8231,7 +8696,7 @@ load_configuration(const char *filename, named_server_t *server,
 		goto cleanup_exclusive;
 	}
 
-	cfg_parser_setcallback(conf_parser, directory_callback, NULL);
+	cfg_parser_setcallback(conf_parser, directory_callback, &rc);
 	result = cfg_parse_file(conf_parser, filename, &cfg_type_namedconf,
 				&config);
 	if (result != ISC_R_SUCCESS) {
@@ -8251,6 +8716,15 @@ load_configuration(const char *filename, named_server_t *server,
 		goto cleanup_config;
 	}
 
+	/* Create the ACL configuration context */
+	if (named_g_aclconfctx != NULL) {
+		cfg_aclconfctx_detach(&named_g_aclconfctx);
+	}
+	result = cfg_aclconfctx_create(named_g_mctx, &named_g_aclconfctx);
+	if (result != ISC_R_SUCCESS) {
+		goto cleanup_config;
+	}
+
 	/* Let's recreate the TLS context cache */
 	if (server->tlsctx_server_cache != NULL) {
 		isc_tlsctx_cache_detach(&server->tlsctx_server_cache);
@@ -8301,6 +8775,23 @@ load_configuration(const char *filename, named_server_t *server,
 	named_g_http_streams_per_conn = cfg_obj_asuint32(obj);
 #endif
 
+	/*
+	 * Decide whether the new views can be built while the loops are
+	 * running.  If they can't, or if the working directory has been
+	 * changed already, pause them now.
+	 */
+	staged = !rc.exclusive && reconfig_canstage(config, maps, server);
+	if (!staged) {
+		if (!rc.exclusive) {
+			reconfig_pause(&rc);
+		}
+
+		/*
+		 * Shut down all dyndb instances.
+		 */
+		dns_dyndb_cleanup(false);
+	}
+
 	/*
 	 * If "dnssec-validation auto" is turned on, the root key
 	 * will be used as a default trust anchor. The root key
@@ -8345,7 +8836,8 @@ load_configuration(const char *filename, named_server_t *server,
 
 #if defined(HAVE_GEOIP2)
 	/*
-	 * Release any previously opened GeoIP2 databases.
+	 * Release any previously opened GeoIP2 databases that are no
+	 * longer in use.
 	 */
 	named_geoip_unload();
 
@@ -8353,7 +8845,8 @@ load_configuration(const char *filename, named_server_t *server,
 	 * Initialize GeoIP databases from the configured location.
 	 * This should happen before configuring any ACLs, so that we
 	 * know what databases are available and can reject any GeoIP
-	 * ACLs that can't work.
+	 * ACLs that can't work.  The production views keep using the
+	 * current databases until the new ones are committed below.
 	 */
 	obj = NULL;
 	result = named_config_get(maps, "geoip-directory", &obj);
@@ -8362,189 +8855,29 @@ load_configuration(const char *filename, named_server_t *server,
 		char *dir = UNCONST(cfg_obj_asstring(obj));
 		named_geoip_load(dir);
 	}
-	named_g_aclconfctx->geoip = named_g_geoip;
+	named_g_aclconfctx->geoip = named_geoip_staged();
 #endif /* HAVE_GEOIP2 */
 
+
 	/*
-	 * Configure various server options.
+	 * Configure sets of UDP query source ports.
 	 */
-	configure_server_quota(maps, "transfers-out",
-			       &server->sctx->xfroutquota);
-	configure_server_quota(maps, "tcp-clients", &server->sctx->tcpquota);
-	configure_server_quota(maps, "recursive-clients",
-			       &server->sctx->recursionquota);
-	configure_server_quota(maps, "update-quota", &server->sctx->updquota);
-
-	max = isc_quota_getmax(&server->sctx->recursionquota);
-	if (max > 1000) {
-		unsigned int margin = ISC_MAX(100, named_g_cpus + 1);
-		if (margin + 100 > max) {
-			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
-				      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
-				      "'recursive-clients %d' too low when "
-				      "running with %d worker threads",
-				      max, named_g_cpus);
-			result = ISC_R_RANGE;
-
-			goto cleanup_bindkeys_parser;
-		}
-		softquota = max - margin;
-	} else {
-		softquota = (max * 90) / 100;
-	}
-
-	isc_quota_soft(&server->sctx->recursionquota, softquota);
-
-	/*
-	 * Set "blackhole". Only legal at options level; there is
-	 * no default.
-	 */
-	result = configure_view_acl(NULL, config, NULL, "blackhole", NULL,
-				    named_g_aclconfctx, named_g_mctx,
-				    &server->sctx->blackholeacl);
-	if (result != ISC_R_SUCCESS) {
-		goto cleanup_bindkeys_parser;
-	}
-
-	if (server->sctx->blackholeacl != NULL) {
-		dns_dispatchmgr_setblackhole(named_g_dispatchmgr,
-					     server->sctx->blackholeacl);
-	}
-
-	obj = NULL;
-	result = named_config_get(maps, "match-mapped-addresses", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	env->match_mapped = cfg_obj_asboolean(obj);
-
-	/*
-	 * Configure the network manager
-	 */
-	obj = NULL;
-	result = named_config_get(maps, "tcp-initial-timeout", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	initial = cfg_obj_asuint32(obj) * 100;
-	if (initial > MAX_INITIAL_TIMEOUT) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "tcp-initial-timeout value is out of range: "
-			    "lowering to %" PRIu32,
-			    MAX_INITIAL_TIMEOUT / 100);
-		initial = MAX_INITIAL_TIMEOUT;
-	} else if (initial < MIN_INITIAL_TIMEOUT) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "tcp-initial-timeout value is out of range: "
-			    "raising to %" PRIu32,
-			    MIN_INITIAL_TIMEOUT / 100);
-		initial = MIN_INITIAL_TIMEOUT;
-	}
-
-	obj = NULL;
-	result = named_config_get(maps, "tcp-idle-timeout", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	idle = cfg_obj_asuint32(obj) * 100;
-	if (idle > MAX_IDLE_TIMEOUT) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "tcp-idle-timeout value is out of range: "
-			    "lowering to %" PRIu32,
-			    MAX_IDLE_TIMEOUT / 100);
-		idle = MAX_IDLE_TIMEOUT;
-	} else if (idle < MIN_IDLE_TIMEOUT) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "tcp-idle-timeout value is out of range: "
-			    "raising to %" PRIu32,
-			    MIN_IDLE_TIMEOUT / 100);
-		idle = MIN_IDLE_TIMEOUT;
-	}
-
-	obj = NULL;
-	result = named_config_get(maps, "tcp-keepalive-timeout", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	keepalive = cfg_obj_asuint32(obj) * 100;
-	if (keepalive > MAX_KEEPALIVE_TIMEOUT) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "tcp-keepalive-timeout value is out of range: "
-			    "lowering to %" PRIu32,
-			    MAX_KEEPALIVE_TIMEOUT / 100);
-		keepalive = MAX_KEEPALIVE_TIMEOUT;
-	} else if (keepalive < MIN_KEEPALIVE_TIMEOUT) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "tcp-keepalive-timeout value is out of range: "
-			    "raising to %" PRIu32,
-			    MIN_KEEPALIVE_TIMEOUT / 100);
-		keepalive = MIN_KEEPALIVE_TIMEOUT;
-	}
-
-	obj = NULL;
-	result = named_config_get(maps, "tcp-advertised-timeout", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	advertised = cfg_obj_asuint32(obj) * 100;
-	if (advertised > MAX_ADVERTISED_TIMEOUT) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "tcp-advertized-timeout value is out of range: "
-			    "lowering to %" PRIu32,
-			    MAX_ADVERTISED_TIMEOUT / 100);
-		advertised = MAX_ADVERTISED_TIMEOUT;
-	}
-
-	isc_nm_settimeouts(named_g_netmgr, initial, idle, keepalive,
-			   advertised);
-
-#define CAP_IF_NOT_ZERO(v, min, max) \
-	if (v > 0 && v < min) {      \
-		v = min;             \
-	} else if (v > max) {        \
-		v = max;             \
-	}
-
-	/* Set the kernel send and receive buffer sizes */
-	obj = NULL;
-	result = named_config_get(maps, "tcp-receive-buffer", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	recv_tcp_buffer_size = cfg_obj_asuint32(obj);
-	CAP_IF_NOT_ZERO(recv_tcp_buffer_size, 4096, INT32_MAX);
-
-	obj = NULL;
-	result = named_config_get(maps, "tcp-send-buffer", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	send_tcp_buffer_size = cfg_obj_asuint32(obj);
-	CAP_IF_NOT_ZERO(send_tcp_buffer_size, 4096, INT32_MAX);
-
-	obj = NULL;
-	result = named_config_get(maps, "udp-receive-buffer", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	recv_udp_buffer_size = cfg_obj_asuint32(obj);
-	CAP_IF_NOT_ZERO(recv_udp_buffer_size, 4096, INT32_MAX);
-
-	obj = NULL;
-	result = named_config_get(maps, "udp-send-buffer", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	send_udp_buffer_size = cfg_obj_asuint32(obj);
-	CAP_IF_NOT_ZERO(send_udp_buffer_size, 4096, INT32_MAX);
-
-	isc_nm_setnetbuffers(named_g_netmgr, recv_tcp_buffer_size,
-			     send_tcp_buffer_size, recv_udp_buffer_size,
-			     send_udp_buffer_size);
-
-#undef CAP_IF_NOT_ZERO
-
-	/*
-	 * Configure sets of UDP query source ports.
-	 */
-	result = isc_portset_create(named_g_mctx, &v4portset);
-	if (result != ISC_R_SUCCESS) {
-		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
-			      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
-			      "creating UDP/IPv4 port set: %s",
-			      isc_result_totext(result));
-		goto cleanup_bindkeys_parser;
-	}
-	result = isc_portset_create(named_g_mctx, &v6portset);
-	if (result != ISC_R_SUCCESS) {
-		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
-			      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
-			      "creating UDP/IPv6 port set: %s",
-			      isc_result_totext(result));
-		goto cleanup_v4portset;
-	}
+	result = isc_portset_create(named_g_mctx, &v4portset);
+	if (result != ISC_R_SUCCESS) {
+		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+			      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+			      "creating UDP/IPv4 port set: %s",
+			      isc_result_totext(result));
+		goto cleanup_bindkeys_parser;
+	}
+	result = isc_portset_create(named_g_mctx, &v6portset);
+	if (result != ISC_R_SUCCESS) {
+		isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+			      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+			      "creating UDP/IPv6 port set: %s",
+			      isc_result_totext(result));
+		goto cleanup_v4portset;
+	}
 
 	usev4ports = NULL;
 	usev6ports = NULL;
@@ -8616,315 +8949,49 @@ load_configuration(const char *filename, named_server_t *server,
 		portset_fromconf(v6portset, avoidv6ports, false);
 	}
 
-	dns_dispatchmgr_setavailports(named_g_dispatchmgr, v4portset,
-				      v6portset);
-
 	/*
-	 * Set the EDNS UDP size when we don't match a view.
+	 * Configure the server-wide session key.  This must be done before
+	 * configure views because zone configuration may need to know
+	 * session-keyname.
+	 *
+	 * Failure of session key generation isn't fatal at this time; if it
+	 * turns out that a session key is really needed but doesn't exist,
+	 * we'll treat it as a fatal error then.
 	 */
-	obj = NULL;
-	result = named_config_get(maps, "edns-udp-size", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	udpsize = cfg_obj_asuint32(obj);
-	if (udpsize < 512) {
-		udpsize = 512;
-	}
-	if (udpsize > 4096) {
-		udpsize = 4096;
-	}
-	server->sctx->udpsize = (uint16_t)udpsize;
-
-	/* Set the transfer message size for TCP */
-	obj = NULL;
-	result = named_config_get(maps, "transfer-message-size", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	transfer_message_size = cfg_obj_asuint32(obj);
-	if (transfer_message_size < 512) {
-		transfer_message_size = 512;
-	} else if (transfer_message_size > 65535) {
-		transfer_message_size = 65535;
-	}
-	server->sctx->transfer_tcp_message_size =
-		(uint16_t)transfer_message_size;
+	(void)configure_session_key(maps, server, named_g_mctx, first_time);
 
 	/*
-	 * Configure the zone manager.
+	 * Create the built-in kasp policies ("default", "insecure").
 	 */
-	obj = NULL;
-	result = named_config_get(maps, "transfers-in", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	dns_zonemgr_settransfersin(server->zonemgr, cfg_obj_asuint32(obj));
-
-	obj = NULL;
-	result = named_config_get(maps, "transfers-per-ns", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	dns_zonemgr_settransfersperns(server->zonemgr, cfg_obj_asuint32(obj));
+	kasps = NULL;
+	(void)cfg_map_get(named_g_config, "dnssec-policy", &kasps);
+	for (element = cfg_list_first(kasps); element != NULL;
+	     element = cfg_list_next(element))
+	{
+		cfg_obj_t *kconfig = cfg_listelt_value(element);
 
-	obj = NULL;
-	result = named_config_get(maps, "notify-rate", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	dns_zonemgr_setnotifyrate(server->zonemgr, cfg_obj_asuint32(obj));
+		kasp = NULL;
+		result = cfg_kasp_fromconfig(kconfig, default_kasp, true,
+					     named_g_mctx, named_g_lctx,
+					     &kasplist, &kasp);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_kasplist;
+		}
+		INSIST(kasp != NULL);
+		dns_kasp_freeze(kasp);
 
-	obj = NULL;
-	result = named_config_get(maps, "startup-notify-rate", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	dns_zonemgr_setstartupnotifyrate(server->zonemgr,
-					 cfg_obj_asuint32(obj));
+		/* Insist that the first built-in policy is the default one. */
+		if (default_kasp == NULL) {
+			INSIST(strcmp(dns_kasp_getname(kasp), "default") == 0);
+			dns_kasp_attach(kasp, &default_kasp);
+		}
 
-	obj = NULL;
-	result = named_config_get(maps, "serial-query-rate", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	dns_zonemgr_setserialqueryrate(server->zonemgr, cfg_obj_asuint32(obj));
+		dns_kasp_detach(&kasp);
+	}
+	INSIST(default_kasp != NULL);
 
 	/*
-	 * Determine which port to use for listening for incoming connections.
-	 */
-	if (named_g_port != 0) {
-		listen_port = named_g_port;
-	} else {
-		result = named_config_getport(config, "port", &listen_port);
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_v6portset;
-		}
-	}
-
-	/*
-	 * Find the listen queue depth.
-	 */
-	obj = NULL;
-	result = named_config_get(maps, "tcp-listen-queue", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	backlog = cfg_obj_asuint32(obj);
-	if ((backlog > 0) && (backlog < 10)) {
-		backlog = 10;
-	}
-	ns_interfacemgr_setbacklog(server->interfacemgr, backlog);
-
-	obj = NULL;
-	result = named_config_get(maps, "reuseport", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	loadbalancesockets = cfg_obj_asboolean(obj);
-#if HAVE_SO_REUSEPORT_LB
-	if (first_time) {
-		isc_nm_setloadbalancesockets(named_g_netmgr,
-					     cfg_obj_asboolean(obj));
-	} else if (loadbalancesockets !=
-		   isc_nm_getloadbalancesockets(named_g_netmgr))
-	{
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "changing reuseport value requires server restart");
-	}
-#else
-	if (loadbalancesockets) {
-		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
-			    "reuseport has no effect on this system");
-	}
-#endif
-
-	/*
-	 * Configure the interface manager according to the "listen-on"
-	 * statement.
-	 */
-	{
-		const cfg_obj_t *clistenon = NULL;
-		ns_listenlist_t *listenon = NULL;
-
-		/*
-		 * Even though listen-on is present in the default
-		 * configuration, this way is easier.
-		 */
-		if (options != NULL) {
-			(void)cfg_map_get(options, "listen-on", &clistenon);
-		}
-		if (clistenon != NULL) {
-			result = listenlist_fromconfig(
-				clistenon, config, named_g_aclconfctx,
-				named_g_mctx, AF_INET,
-				server->tlsctx_server_cache, &listenon);
-		} else {
-			/*
-			 * Not specified, use default.
-			 */
-			result = ns_listenlist_default(named_g_mctx,
-						       listen_port, true,
-						       AF_INET, &listenon);
-		}
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_v6portset;
-		}
-
-		if (listenon != NULL) {
-			ns_interfacemgr_setlistenon4(server->interfacemgr,
-						     listenon);
-			ns_listenlist_detach(&listenon);
-		}
-	}
-
-	/*
-	 * Ditto for IPv6.
-	 */
-	{
-		const cfg_obj_t *clistenon = NULL;
-		ns_listenlist_t *listenon = NULL;
-
-		if (options != NULL) {
-			(void)cfg_map_get(options, "listen-on-v6", &clistenon);
-		}
-		if (clistenon != NULL) {
-			result = listenlist_fromconfig(
-				clistenon, config, named_g_aclconfctx,
-				named_g_mctx, AF_INET6,
-				server->tlsctx_server_cache, &listenon);
-		} else {
-			/*
-			 * Not specified, use default.
-			 */
-			result = ns_listenlist_default(named_g_mctx,
-						       listen_port, true,
-						       AF_INET6, &listenon);
-		}
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_v6portset;
-		}
-		if (listenon != NULL) {
-			ns_interfacemgr_setlistenon6(server->interfacemgr,
-						     listenon);
-			ns_listenlist_detach(&listenon);
-		}
-	}
-
-	if (first_time) {
-		/*
-		 * Rescan the interface list to pick up changes in the
-		 * listen-on option. This requires the loopmgr to be
-		 * temporarily resumed.
-		 */
-		isc_loopmgr_resume(named_g_loopmgr);
-		result = ns_interfacemgr_scan(server->interfacemgr, true, true);
-		isc_loopmgr_pause(named_g_loopmgr);
-
-		/*
-		 * Check that named is able to TCP listen on at least one
-		 * interface. Otherwise, another named process could be running
-		 * and we should fail.
-		 */
-		if (result == ISC_R_ADDRINUSE) {
-			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
-				      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
-				      "unable to listen on any configured "
-				      "interfaces");
-			result = ISC_R_FAILURE;
-			goto cleanup_v6portset;
-		}
-	}
-
-	/*
-	 * Arrange for further interface scanning to occur periodically
-	 * as specified by the "interface-interval" option.
-	 */
-	obj = NULL;
-	result = named_config_get(maps, "interface-interval", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	interface_interval = cfg_obj_asduration(obj);
-	if (server->interface_timer != NULL) {
-		if (interface_interval == 0) {
-			isc_timer_stop(server->interface_timer);
-		} else if (server->interface_interval != interface_interval) {
-			isc_interval_set(&interval, interface_interval, 0);
-			isc_timer_start(server->interface_timer,
-					isc_timertype_ticker, &interval);
-		}
-	}
-	server->interface_interval = interface_interval;
-
-	/*
-	 * Enable automatic interface scans.
-	 */
-	obj = NULL;
-	result = named_config_get(maps, "automatic-interface-scan", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	server->sctx->interface_auto = cfg_obj_asboolean(obj);
-
-	/*
-	 * Configure the dialup heartbeat timer.
-	 */
-	obj = NULL;
-	result = named_config_get(maps, "heartbeat-interval", &obj);
-	INSIST(result == ISC_R_SUCCESS);
-	heartbeat_interval = cfg_obj_asuint32(obj) * 60;
-	if (heartbeat_interval == 0) {
-		isc_timer_stop(server->heartbeat_timer);
-	} else if (server->heartbeat_interval != heartbeat_interval) {
-		isc_interval_set(&interval, heartbeat_interval, 0);
-		isc_timer_start(server->heartbeat_timer, isc_timertype_ticker,
-				&interval);
-	}
-	server->heartbeat_interval = heartbeat_interval;
-
-	isc_interval_set(&interval, 1200, 0);
-	isc_timer_start(server->pps_timer, isc_timertype_ticker, &interval);
-
-	isc_interval_set(&interval, named_g_tat_interval, 0);
-	isc_timer_start(server->tat_timer, isc_timertype_ticker, &interval);
-
-	/*
-	 * Write the PID file.
-	 */
-	obj = NULL;
-	if (named_config_get(maps, "pid-file", &obj) == ISC_R_SUCCESS) {
-		if (cfg_obj_isvoid(obj)) {
-			named_os_writepidfile(NULL, first_time);
-		} else {
-			named_os_writepidfile(cfg_obj_asstring(obj),
-					      first_time);
-		}
-	} else {
-		named_os_writepidfile(named_g_defaultpidfile, first_time);
-	}
-
-	/*
-	 * Configure the server-wide session key.  This must be done before
-	 * configure views because zone configuration may need to know
-	 * session-keyname.
-	 *
-	 * Failure of session key generation isn't fatal at this time; if it
-	 * turns out that a session key is really needed but doesn't exist,
-	 * we'll treat it as a fatal error then.
-	 */
-	(void)configure_session_key(maps, server, named_g_mctx, first_time);
-
-	/*
-	 * Create the built-in kasp policies ("default", "insecure").
-	 */
-	kasps = NULL;
-	(void)cfg_map_get(named_g_config, "dnssec-policy", &kasps);
-	for (element = cfg_list_first(kasps); element != NULL;
-	     element = cfg_list_next(element))
-	{
-		cfg_obj_t *kconfig = cfg_listelt_value(element);
-
-		kasp = NULL;
-		result = cfg_kasp_fromconfig(kconfig, default_kasp, true,
-					     named_g_mctx, named_g_lctx,
-					     &kasplist, &kasp);
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_kasplist;
-		}
-		INSIST(kasp != NULL);
-		dns_kasp_freeze(kasp);
-
-		/* Insist that the first built-in policy is the default one. */
-		if (default_kasp == NULL) {
-			INSIST(strcmp(dns_kasp_getname(kasp), "default") == 0);
-			dns_kasp_attach(kasp, &default_kasp);
-		}
-
-		dns_kasp_detach(&kasp);
-	}
-	INSIST(default_kasp != NULL);
-
-	/*
-	 * Create the DNSSEC key and signing policies (KASP).
+	 * Create the DNSSEC key and signing policies (KASP).
 	 */
 	kasps = NULL;
 	(void)cfg_map_get(config, "dnssec-policy", &kasps);
@@ -8978,6 +9045,12 @@ load_configuration(const char *filename, named_server_t *server,
 	}
 #endif /* ifdef USE_DNSRPS */
 
+	/*
+	 * Queue the changes to objects shared with the production views
+	 * from here on; see reconfig_submit().
+	 */
+	reconfig = &rc;
+
 	/*
 	 * Configure the views.
 	 */
@@ -8985,131 +9058,608 @@ load_configuration(const char *filename, named_server_t *server,
 	(void)cfg_map_get(config, "view", &views);
 
 	/*
-	 * Create the views.
+	 * Create the views.
+	 */
+	for (element = cfg_list_first(views); element != NULL;
+	     element = cfg_list_next(element))
+	{
+		cfg_obj_t *vconfig = cfg_listelt_value(element);
+		dns_view_t *view = NULL;
+
+		result = create_view(vconfig, &viewlist, &view);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_viewlist;
+		}
+		INSIST(view != NULL);
+
+		result = setup_newzones(view, config, vconfig, conf_parser,
+					named_g_aclconfctx);
+		dns_view_detach(&view);
+
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_viewlist;
+		}
+	}
+
+	/*
+	 * If there were no explicit views then we do the default
+	 * view here.
+	 */
+	if (views == NULL) {
+		dns_view_t *view = NULL;
+
+		result = create_view(NULL, &viewlist, &view);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_viewlist;
+		}
+		INSIST(view != NULL);
+
+		result = setup_newzones(view, config, NULL, conf_parser,
+					named_g_aclconfctx);
+
+		dns_view_detach(&view);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_viewlist;
+		}
+	}
+
+	/*
+	 * Configure and freeze all explicit views.  Explicit
+	 * views that have zones were already created at parsing
+	 * time, but views with no zones must be created here.
+	 */
+	for (element = cfg_list_first(views); element != NULL;
+	     element = cfg_list_next(element))
+	{
+		cfg_obj_t *vconfig = cfg_listelt_value(element);
+		dns_view_t *view = NULL;
+
+		view = NULL;
+		result = find_view(vconfig, &viewlist, &view);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_cachelist;
+		}
+
+		result = configure_view(view, &viewlist, config, vconfig,
+					&cachelist, &server->kasplist, bindkeys,
+					named_g_mctx, named_g_aclconfctx, true);
+		if (result != ISC_R_SUCCESS) {
+			dns_view_detach(&view);
+			goto cleanup_cachelist;
+		}
+		dns_view_freeze(view);
+		dns_view_detach(&view);
+	}
+
+	/*
+	 * Make sure we have a default view if and only if there
+	 * were no explicit views.
+	 */
+	if (views == NULL) {
+		dns_view_t *view = NULL;
+		result = find_view(NULL, &viewlist, &view);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_cachelist;
+		}
+		result = configure_view(view, &viewlist, config, NULL,
+					&cachelist, &server->kasplist, bindkeys,
+					named_g_mctx, named_g_aclconfctx, true);
+		if (result != ISC_R_SUCCESS) {
+			dns_view_detach(&view);
+			goto cleanup_cachelist;
+		}
+		dns_view_freeze(view);
+		dns_view_detach(&view);
+	}
+
+	/*
+	 * Create (or recreate) the built-in views.
+	 */
+	builtin_views = NULL;
+	RUNTIME_CHECK(cfg_map_get(named_g_config, "view", &builtin_views) ==
+		      ISC_R_SUCCESS);
+	for (element = cfg_list_first(builtin_views); element != NULL;
+	     element = cfg_list_next(element))
+	{
+		cfg_obj_t *vconfig = cfg_listelt_value(element);
+		dns_view_t *view = NULL;
+
+		result = create_view(vconfig, &builtin_viewlist, &view);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_cachelist;
+		}
+
+		result = configure_view(view, &viewlist, config, vconfig,
+					&cachelist, &server->kasplist, bindkeys,
+					named_g_mctx, named_g_aclconfctx,
+					false);
+		if (result != ISC_R_SUCCESS) {
+			dns_view_detach(&view);
+			goto cleanup_cachelist;
+		}
+		dns_view_freeze(view);
+		dns_view_detach(&view);
+	}
+
+	/* Now combine the two viewlists into one */
+	ISC_LIST_APPENDLIST(viewlist, builtin_viewlist, link);
+
+	/*
+	 * The new views are complete; everything from here on changes
+	 * state used by the running server.
+	 */
+	if (!rc.exclusive) {
+		reconfig_pause(&rc);
+	}
+	if (staged) {
+		/*
+		 * Shut down all dyndb instances.
+		 */
+		dns_dyndb_cleanup(false);
+	}
+
+#if defined(HAVE_GEOIP2)
+	named_geoip_commit();
+	named_g_aclconfctx->geoip = named_g_geoip;
+#endif /* HAVE_GEOIP2 */
+
+	/*
+	 * Configure various server options.
+	 */
+	configure_server_quota(maps, "transfers-out",
+			       &server->sctx->xfroutquota);
+	configure_server_quota(maps, "tcp-clients", &server->sctx->tcpquota);
+	configure_server_quota(maps, "recursive-clients",
+			       &server->sctx->recursionquota);
+	configure_server_quota(maps, "update-quota", &server->sctx->updquota);
+
+	max = isc_quota_getmax(&server->sctx->recursionquota);
+	if (max > 1000) {
+		unsigned int margin = ISC_MAX(100, named_g_cpus + 1);
+		if (margin + 100 > max) {
+			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+				      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+				      "'recursive-clients %d' too low when "
+				      "running with %d worker threads",
+				      max, named_g_cpus);
+			result = ISC_R_RANGE;
+
+			goto cleanup_cachelist;
+		}
+		softquota = max - margin;
+	} else {
+		softquota = (max * 90) / 100;
+	}
+
+	isc_quota_soft(&server->sctx->recursionquota, softquota);
+
+	/*
+	 * Set "blackhole". Only legal at options level; there is
+	 * no default.
+	 */
+	result = configure_view_acl(NULL, config, NULL, "blackhole", NULL,
+				    named_g_aclconfctx, named_g_mctx,
+				    &server->sctx->blackholeacl);
+	if (result != ISC_R_SUCCESS) {
+		goto cleanup_cachelist;
+	}
+
+	if (server->sctx->blackholeacl != NULL) {
+		dns_dispatchmgr_setblackhole(named_g_dispatchmgr,
+					     server->sctx->blackholeacl);
+	}
+
+	obj = NULL;
+	result = named_config_get(maps, "match-mapped-addresses", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	env->match_mapped = cfg_obj_asboolean(obj);
+
+	/*
+	 * Configure the network manager
+	 */
+	obj = NULL;
+	result = named_config_get(maps, "tcp-initial-timeout", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	initial = cfg_obj_asuint32(obj) * 100;
+	if (initial > MAX_INITIAL_TIMEOUT) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "tcp-initial-timeout value is out of range: "
+			    "lowering to %" PRIu32,
+			    MAX_INITIAL_TIMEOUT / 100);
+		initial = MAX_INITIAL_TIMEOUT;
+	} else if (initial < MIN_INITIAL_TIMEOUT) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "tcp-initial-timeout value is out of range: "
+			    "raising to %" PRIu32,
+			    MIN_INITIAL_TIMEOUT / 100);
+		initial = MIN_INITIAL_TIMEOUT;
+	}
+
+	obj = NULL;
+	result = named_config_get(maps, "tcp-idle-timeout", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	idle = cfg_obj_asuint32(obj) * 100;
+	if (idle > MAX_IDLE_TIMEOUT) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "tcp-idle-timeout value is out of range: "
+			    "lowering to %" PRIu32,
+			    MAX_IDLE_TIMEOUT / 100);
+		idle = MAX_IDLE_TIMEOUT;
+	} else if (idle < MIN_IDLE_TIMEOUT) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "tcp-idle-timeout value is out of range: "
+			    "raising to %" PRIu32,
+			    MIN_IDLE_TIMEOUT / 100);
+		idle = MIN_IDLE_TIMEOUT;
+	}
+
+	obj = NULL;
+	result = named_config_get(maps, "tcp-keepalive-timeout", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	keepalive = cfg_obj_asuint32(obj) * 100;
+	if (keepalive > MAX_KEEPALIVE_TIMEOUT) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "tcp-keepalive-timeout value is out of range: "
+			    "lowering to %" PRIu32,
+			    MAX_KEEPALIVE_TIMEOUT / 100);
+		keepalive = MAX_KEEPALIVE_TIMEOUT;
+	} else if (keepalive < MIN_KEEPALIVE_TIMEOUT) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "tcp-keepalive-timeout value is out of range: "
+			    "raising to %" PRIu32,
+			    MIN_KEEPALIVE_TIMEOUT / 100);
+		keepalive = MIN_KEEPALIVE_TIMEOUT;
+	}
+
+	obj = NULL;
+	result = named_config_get(maps, "tcp-advertised-timeout", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	advertised = cfg_obj_asuint32(obj) * 100;
+	if (advertised > MAX_ADVERTISED_TIMEOUT) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "tcp-advertized-timeout value is out of range: "
+			    "lowering to %" PRIu32,
+			    MAX_ADVERTISED_TIMEOUT / 100);
+		advertised = MAX_ADVERTISED_TIMEOUT;
+	}
+
+	isc_nm_settimeouts(named_g_netmgr, initial, idle, keepalive,
+			   advertised);
+
+#define CAP_IF_NOT_ZERO(v, min, max) \
+	if (v > 0 && v < min) {      \
+		v = min;             \
+	} else if (v > max) {        \
+		v = max;             \
+	}
+
+	/* Set the kernel send and receive buffer sizes */
+	obj = NULL;
+	result = named_config_get(maps, "tcp-receive-buffer", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	recv_tcp_buffer_size = cfg_obj_asuint32(obj);
+	CAP_IF_NOT_ZERO(recv_tcp_buffer_size, 4096, INT32_MAX);
+
+	obj = NULL;
+	result = named_config_get(maps, "tcp-send-buffer", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	send_tcp_buffer_size = cfg_obj_asuint32(obj);
+	CAP_IF_NOT_ZERO(send_tcp_buffer_size, 4096, INT32_MAX);
+
+	obj = NULL;
+	result = named_config_get(maps, "udp-receive-buffer", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	recv_udp_buffer_size = cfg_obj_asuint32(obj);
+	CAP_IF_NOT_ZERO(recv_udp_buffer_size, 4096, INT32_MAX);
+
+	obj = NULL;
+	result = named_config_get(maps, "udp-send-buffer", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	send_udp_buffer_size = cfg_obj_asuint32(obj);
+	CAP_IF_NOT_ZERO(send_udp_buffer_size, 4096, INT32_MAX);
+
+	isc_nm_setnetbuffers(named_g_netmgr, recv_tcp_buffer_size,
+			     send_tcp_buffer_size, recv_udp_buffer_size,
+			     send_udp_buffer_size);
+
+#undef CAP_IF_NOT_ZERO
+
+	dns_dispatchmgr_setavailports(named_g_dispatchmgr, v4portset,
+				      v6portset);
+
+	/*
+	 * Set the EDNS UDP size when we don't match a view.
+	 */
+	obj = NULL;
+	result = named_config_get(maps, "edns-udp-size", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	udpsize = cfg_obj_asuint32(obj);
+	if (udpsize < 512) {
+		udpsize = 512;
+	}
+	if (udpsize > 4096) {
+		udpsize = 4096;
+	}
+	server->sctx->udpsize = (uint16_t)udpsize;
+
+	/* Set the transfer message size for TCP */
+	obj = NULL;
+	result = named_config_get(maps, "transfer-message-size", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	transfer_message_size = cfg_obj_asuint32(obj);
+	if (transfer_message_size < 512) {
+		transfer_message_size = 512;
+	} else if (transfer_message_size > 65535) {
+		transfer_message_size = 65535;
+	}
+	server->sctx->transfer_tcp_message_size =
+		(uint16_t)transfer_message_size;
+
+	/*
+	 * Configure the zone manager.
+	 */
+	obj = NULL;
+	result = named_config_get(maps, "transfers-in", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zonemgr_settransfersin(server->zonemgr, cfg_obj_asuint32(obj));
+
+	obj = NULL;
+	result = named_config_get(maps, "transfers-per-ns", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zonemgr_settransfersperns(server->zonemgr, cfg_obj_asuint32(obj));
+
+	obj = NULL;
+	result = named_config_get(maps, "notify-rate", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zonemgr_setnotifyrate(server->zonemgr, cfg_obj_asuint32(obj));
+
+	obj = NULL;
+	result = named_config_get(maps, "startup-notify-rate", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zonemgr_setstartupnotifyrate(server->zonemgr,
+					 cfg_obj_asuint32(obj));
+
+	obj = NULL;
+	result = named_config_get(maps, "serial-query-rate", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zonemgr_setserialqueryrate(server->zonemgr, cfg_obj_asuint32(obj));
+
+	obj = NULL;
+	result = named_config_get(maps, "serial-query-batch", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	dns_zonemgr_setserialquerybatch(server->zonemgr,
+					cfg_obj_asuint32(obj));
+
+	/*
+	 * Determine which port to use for listening for incoming connections.
+	 */
+	if (named_g_port != 0) {
+		listen_port = named_g_port;
+	} else {
+		result = named_config_getport(config, "port", &listen_port);
+		if (result != ISC_R_SUCCESS) {
+			goto cleanup_cachelist;
+		}
+	}
+
+	/*
+	 * Find the listen queue depth.
+	 */
+	obj = NULL;
+	result = named_config_get(maps, "tcp-listen-queue", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	backlog = cfg_obj_asuint32(obj);
+	if ((backlog > 0) && (backlog < 10)) {
+		backlog = 10;
+	}
+	ns_interfacemgr_setbacklog(server->interfacemgr, backlog);
+
+	obj = NULL;
+	result = named_config_get(maps, "reuseport", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	loadbalancesockets = cfg_obj_asboolean(obj);
+#if HAVE_SO_REUSEPORT_LB
+	if (first_time) {
+		isc_nm_setloadbalancesockets(named_g_netmgr,
+					     cfg_obj_asboolean(obj));
+	} else if (loadbalancesockets !=
+		   isc_nm_getloadbalancesockets(named_g_netmgr))
+	{
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "changing reuseport value requires server restart");
+	}
+#else
+	if (loadbalancesockets) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "reuseport has no effect on this system");
+	}
+#endif
+
+	obj = NULL;
+	result = named_config_get(maps, "io-uring", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	iouring = cfg_obj_asboolean(obj);
+#if HAVE_LIBURING
+	if (first_time) {
+		isc_nm_setiouring(named_g_netmgr, iouring);
+	} else if (iouring != isc_nm_getiouring(named_g_netmgr)) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "changing io-uring value requires server restart");
+	}
+#else
+	if (iouring) {
+		cfg_obj_log(obj, named_g_lctx, ISC_LOG_WARNING,
+			    "io-uring has no effect on this system");
+	}
+#endif
+
+	/*
+	 * Configure the interface manager according to the "listen-on"
+	 * statement.
 	 */
-	for (element = cfg_list_first(views); element != NULL;
-	     element = cfg_list_next(element))
 	{
-		cfg_obj_t *vconfig = cfg_listelt_value(element);
-		dns_view_t *view = NULL;
+		const cfg_obj_t *clistenon = NULL;
+		ns_listenlist_t *listenon = NULL;
 
-		result = create_view(vconfig, &viewlist, &view);
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_viewlist;
+		/*
+		 * Even though listen-on is present in the default
+		 * configuration, this way is easier.
+		 */
+		if (options != NULL) {
+			(void)cfg_map_get(options, "listen-on", &clistenon);
 		}
-		INSIST(view != NULL);
-
-		result = setup_newzones(view, config, vconfig, conf_parser,
-					named_g_aclconfctx);
-		dns_view_detach(&view);
-
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_viewlist;
+		if (clistenon != NULL) {
+			result = listenlist_fromconfig(
+				clistenon, config, named_g_aclconfctx,
+				named_g_mctx, AF_INET,
+				server->tlsctx_server_cache, &listenon);
+		} else {
+			/*
+			 * Not specified, use default.
+			 */
+			result = ns_listenlist_default(named_g_mctx,
+						       listen_port, true,
+						       AF_INET, &listenon);
 		}
-	}
-
-	/*
-	 * If there were no explicit views then we do the default
-	 * view here.
-	 */
-	if (views == NULL) {
-		dns_view_t *view = NULL;
-
-		result = create_view(NULL, &viewlist, &view);
 		if (result != ISC_R_SUCCESS) {
-			goto cleanup_viewlist;
+			goto cleanup_cachelist;
 		}
-		INSIST(view != NULL);
-
-		result = setup_newzones(view, config, NULL, conf_parser,
-					named_g_aclconfctx);
 
-		dns_view_detach(&view);
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_viewlist;
+		if (listenon != NULL) {
+			ns_interfacemgr_setlistenon4(server->interfacemgr,
+						     listenon);
+			ns_listenlist_detach(&listenon);
 		}
 	}
 
 	/*
-	 * Configure and freeze all explicit views.  Explicit
-	 * views that have zones were already created at parsing
-	 * time, but views with no zones must be created here.
+	 * Ditto for IPv6.
 	 */
-	for (element = cfg_list_first(views); element != NULL;
-	     element = cfg_list_next(element))
 	{
-		cfg_obj_t *vconfig = cfg_listelt_value(element);
-		dns_view_t *view = NULL;
+		const cfg_obj_t *clistenon = NULL;
+		ns_listenlist_t *listenon = NULL;
 
-		view = NULL;
-		result = find_view(vconfig, &viewlist, &view);
+		if (options != NULL) {
+			(void)cfg_map_get(options, "listen-on-v6", &clistenon);
+		}
+		if (clistenon != NULL) {
+			result = listenlist_fromconfig(
+				clistenon, config, named_g_aclconfctx,
+				named_g_mctx, AF_INET6,
+				server->tlsctx_server_cache, &listenon);
+		} else {
+			/*
+			 * Not specified, use default.
+			 */
+			result = ns_listenlist_default(named_g_mctx,
+						       listen_port, true,
+						       AF_INET6, &listenon);
+		}
 		if (result != ISC_R_SUCCESS) {
 			goto cleanup_cachelist;
 		}
+		if (listenon != NULL) {
+			ns_interfacemgr_setlistenon6(server->interfacemgr,
+						     listenon);
+			ns_listenlist_detach(&listenon);
+		}
+	}
 
-		result = configure_view(view, &viewlist, config, vconfig,
-					&cachelist, &server->kasplist, bindkeys,
-					named_g_mctx, named_g_aclconfctx, true);
-		if (result != ISC_R_SUCCESS) {
-			dns_view_detach(&view);
+	if (first_time) {
+		/*
+		 * Rescan the interface list to pick up changes in the
+		 * listen-on option. This requires the loopmgr to be
+		 * temporarily resumed.
+		 */
+		reconfig_resume(&rc);
+		result = ns_interfacemgr_scan(server->interfacemgr, true, true);
+		reconfig_pause(&rc);
+
+		/*
+		 * Check that named is able to TCP listen on at least one
+		 * interface. Otherwise, another named process could be running
+		 * and we should fail.
+		 */
+		if (result == ISC_R_ADDRINUSE) {
+			isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+				      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+				      "unable to listen on any configured "
+				      "interfaces");
+			result = ISC_R_FAILURE;
 			goto cleanup_cachelist;
 		}
-		dns_view_freeze(view);
-		dns_view_detach(&view);
 	}
 
 	/*
-	 * Make sure we have a default view if and only if there
-	 * were no explicit views.
+	 * Arrange for further interface scanning to occur periodically
+	 * as specified by the "interface-interval" option.
 	 */
-	if (views == NULL) {
-		dns_view_t *view = NULL;
-		result = find_view(NULL, &viewlist, &view);
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_cachelist;
-		}
-		result = configure_view(view, &viewlist, config, NULL,
-					&cachelist, &server->kasplist, bindkeys,
-					named_g_mctx, named_g_aclconfctx, true);
-		if (result != ISC_R_SUCCESS) {
-			dns_view_detach(&view);
-			goto cleanup_cachelist;
+	obj = NULL;
+	result = named_config_get(maps, "interface-interval", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	interface_interval = cfg_obj_asduration(obj);
+	if (server->interface_timer != NULL) {
+		if (interface_interval == 0) {
+			isc_timer_stop(server->interface_timer);
+		} else if (server->interface_interval != interface_interval) {
+			isc_interval_set(&interval, interface_interval, 0);
+			isc_timer_start(server->interface_timer,
+					isc_timertype_ticker, &interval);
 		}
-		dns_view_freeze(view);
-		dns_view_detach(&view);
 	}
+	server->interface_interval = interface_interval;
 
 	/*
-	 * Create (or recreate) the built-in views.
+	 * Enable automatic interface scans.
 	 */
-	builtin_views = NULL;
-	RUNTIME_CHECK(cfg_map_get(named_g_config, "view", &builtin_views) ==
-		      ISC_R_SUCCESS);
-	for (element = cfg_list_first(builtin_views); element != NULL;
-	     element = cfg_list_next(element))
-	{
-		cfg_obj_t *vconfig = cfg_listelt_value(element);
-		dns_view_t *view = NULL;
+	obj = NULL;
+	result = named_config_get(maps, "automatic-interface-scan", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	server->sctx->interface_auto = cfg_obj_asboolean(obj);
 
-		result = create_view(vconfig, &builtin_viewlist, &view);
-		if (result != ISC_R_SUCCESS) {
-			goto cleanup_cachelist;
-		}
+	/*
+	 * Configure the dialup heartbeat timer.
+	 */
+	obj = NULL;
+	result = named_config_get(maps, "heartbeat-interval", &obj);
+	INSIST(result == ISC_R_SUCCESS);
+	heartbeat_interval = cfg_obj_asuint32(obj) * 60;
+	if (heartbeat_interval == 0) {
+		isc_timer_stop(server->heartbeat_timer);
+	} else if (server->heartbeat_interval != heartbeat_interval) {
+		isc_interval_set(&interval, heartbeat_interval, 0);
+		isc_timer_start(server->heartbeat_timer, isc_timertype_ticker,
+				&interval);
+	}
+	server->heartbeat_interval = heartbeat_interval;
 
-		result = configure_view(view, &viewlist, config, vconfig,
-					&cachelist, &server->kasplist, bindkeys,
-					named_g_mctx, named_g_aclconfctx,
-					false);
-		if (result != ISC_R_SUCCESS) {
-			dns_view_detach(&view);
-			goto cleanup_cachelist;
+	isc_interval_set(&interval, 1200, 0);
+	isc_timer_start(server->pps_timer, isc_timertype_ticker, &interval);
+
+	isc_interval_set(&interval, named_g_tat_interval, 0);
+	isc_timer_start(server->tat_timer, isc_timertype_ticker, &interval);
+
+	/*
+	 * Write the PID file.
+	 */
+	obj = NULL;
+	if (named_config_get(maps, "pid-file", &obj) == ISC_R_SUCCESS) {
+		if (cfg_obj_isvoid(obj)) {
+			named_os_writepidfile(NULL, first_time);
+		} else {
+			named_os_writepidfile(cfg_obj_asstring(obj),
+					      first_time);
 		}
-		dns_view_freeze(view);
-		dns_view_detach(&view);
+	} else {
+		named_os_writepidfile(named_g_defaultpidfile, first_time);
 	}
 
-	/* Now combine the two viewlists into one */
-	ISC_LIST_APPENDLIST(viewlist, builtin_viewlist, link);
+	/*
+	 * Apply the changes to the zones and other objects shared with
+	 * the production views.
+	 */
+	reconfig_commit(&rc);
+	reconfig = NULL;
 
 	/*
 	 * Commit any dns_zone_setview() calls on all zones in the new
@@ -9121,18 +9671,27 @@ load_configuration(const char *filename, named_server_t *server,
 		dns_view_setviewcommit(view);
 	}
 
-	/* Swap our new view list with the production one. */
-	tmpviewlist = server->viewlist;
-	server->viewlist = viewlist;
-	viewlist = tmpviewlist;
-
-	/* Make the view list available to each of the views */
-	for (dns_view_t *view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	/*
+	 * Make the view list available to each of the views, and pick
+	 * up the server-wide ACL environment settings made above.
+	 */
+	newviewlist = isc_mem_get(named_g_mctx, sizeof(*newviewlist));
+	for (dns_view_t *view = ISC_LIST_HEAD(viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
-		view->viewlist = &server->viewlist;
+		view->viewlist = newviewlist;
+		dns_aclenv_copy(view->aclenv, env);
 	}
 
+	/*
+	 * Publish the new view list.  The old one is freed once the
+	 * readers that may still be walking it are done, see below.
+	 */
+	*newviewlist = viewlist;
+	ISC_LIST_INIT(viewlist);
+	oldviewlist = server->viewlist;
+	rcu_assign_pointer(server->viewlist, newviewlist);
+
 	/* Swap our new cache list with the production one. */
 	tmpcachelist = server->cachelist;
 	server->cachelist = cachelist;
@@ -9165,7 +9724,7 @@ load_configuration(const char *filename, named_server_t *server,
 	 * after relinquishing privileges them.
 	 */
 	if (first_time) {
-		for (dns_view_t *view = ISC_LIST_HEAD(server->viewlist);
+		for (dns_view_t *view = ISC_LIST_HEAD(*server->viewlist);
 		     view != NULL; view = ISC_LIST_NEXT(view, link))
 		{
 			nzd_env_close(view);
@@ -9196,7 +9755,7 @@ load_configuration(const char *filename, named_server_t *server,
 	 * Reopen NZD databases.
 	 */
 	if (first_time) {
-		for (dns_view_t *view = ISC_LIST_HEAD(server->viewlist);
+		for (dns_view_t *view = ISC_LIST_HEAD(*server->viewlist);
 		     view != NULL; view = ISC_LIST_NEXT(view, link))
 		{
 			nzd_env_reopen(view);
@@ -9522,7 +10081,7 @@ load_configuration(const char *filename, named_server_t *server,
 	 * Start and connect to the DNS Response Policy Service
 	 * daemon, dnsrpzd, for each view that uses DNSRPS.
 	 */
-	for (dns_view_t *view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (dns_view_t *view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		result = dns_dnsrps_connect(view->rpzs);
@@ -9538,8 +10097,7 @@ load_configuration(const char *filename, named_server_t *server,
 	 */
 	named_g_configtime = isc_time_now();
 
-	isc_loopmgr_resume(named_g_loopmgr);
-	exclusive = false;
+	reconfig_resume(&rc);
 
 	/* Configure the statistics channel(s) */
 	result = named_statschannels_configure(named_g_server, config,
@@ -9593,6 +10151,26 @@ cleanup_cachelist:
 	ISC_LIST_APPENDLIST(viewlist, builtin_viewlist, link);
 
 cleanup_viewlist:
+	if (reconfig != NULL) {
+		reconfig_discard(reconfig);
+		reconfig = NULL;
+	}
+
+	if (oldviewlist != NULL) {
+		/*
+		 * Wait until nobody is walking the old view list anymore
+		 * before taking it apart; the loops can't be paused for
+		 * that.
+		 */
+		if (rc.exclusive) {
+			reconfig_resume(&rc);
+		}
+		synchronize_rcu();
+		INSIST(ISC_LIST_EMPTY(viewlist));
+		viewlist = *oldviewlist;
+		isc_mem_put(named_g_mctx, oldviewlist, sizeof(*oldviewlist));
+	}
+
 	for (dns_view_t *view = ISC_LIST_HEAD(viewlist); view != NULL;
 	     view = view_next)
 	{
@@ -9635,13 +10213,28 @@ cleanup_conf_parser:
 	cfg_parser_destroy(&conf_parser);
 
 cleanup_exclusive:
-	if (exclusive) {
-		isc_loopmgr_resume(named_g_loopmgr);
+	if (rc.exclusive) {
+		reconfig_resume(&rc);
+	}
+
+#if defined(HAVE_GEOIP2)
+	/*
+	 * Close the replaced databases, or the new ones if they were
+	 * not committed.
+	 */
+	if (named_g_aclconfctx != NULL) {
+		named_g_aclconfctx->geoip = named_g_geoip;
 	}
+	named_geoip_unload();
+#endif /* HAVE_GEOIP2 */
+
+	atomic_store_relaxed(&server->reconfig_pause, rc.paused);
 
 	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
 		      NAMED_LOGMODULE_SERVER, ISC_LOG_DEBUG(1),
-		      "load_configuration: %s", isc_result_totext(result));
+		      "load_configuration: %s (loops paused for %" PRIu64
+		      " us)",
+		      isc_result_totext(result), rc.paused);
 
 	return (result);
 }
@@ -9683,7 +10276,7 @@ view_loaded(void *arg) {
 				      "all zones loaded");
 		}
 
-		for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+		for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 		     view = ISC_LIST_NEXT(view, link))
 		{
 			if (view->managed_keys != NULL) {
@@ -9750,7 +10343,7 @@ load_zones(named_server_t *server, bool reconfig) {
 	/*
 	 * Schedule zones to be loaded from disk.
 	 */
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (view->managed_keys != NULL) {
@@ -9923,11 +10516,11 @@ shutdown_server(void *arg) {
 		dns_kasp_detach(&kasp);
 	}
 
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = view_next)
 	{
 		view_next = ISC_LIST_NEXT(view, link);
-		ISC_LIST_UNLINK(server->viewlist, view, link);
+		ISC_LIST_UNLINK(*server->viewlist, view, link);
 		dns_view_flushonshutdown(view, flush);
 		dns_view_detach(&view);
 	}
@@ -9976,13 +10569,17 @@ static isc_result_t
 get_matching_view(isc_netaddr_t *srcaddr, isc_netaddr_t *destaddr,
 		  dns_message_t *message, dns_aclenv_t *env,
 		  isc_result_t *sigresult, dns_view_t **viewp) {
+	dns_viewlist_t *viewlist = NULL;
 	dns_view_t *view;
+	isc_result_t result = ISC_R_NOTFOUND;
 
 	REQUIRE(message != NULL);
 	REQUIRE(sigresult != NULL);
 	REQUIRE(viewp != NULL && *viewp == NULL);
 
-	for (view = ISC_LIST_HEAD(named_g_server->viewlist); view != NULL;
+	rcu_read_lock();
+	viewlist = rcu_dereference(named_g_server->viewlist);
+	for (view = ISC_LIST_HEAD(*viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (message->rdclass == view->rdclass ||
@@ -10006,12 +10603,14 @@ get_matching_view(isc_netaddr_t *srcaddr, isc_netaddr_t *destaddr,
 			      (message->flags & DNS_MESSAGEFLAG_RD) == 0))
 			{
 				dns_view_attach(view, viewp);
-				return (ISC_R_SUCCESS);
+				result = ISC_R_SUCCESS;
+				break;
 			}
 		}
 	}
+	rcu_read_unlock();
 
-	return (ISC_R_NOTFOUND);
+	return (result);
 }
 
 void
@@ -10029,7 +10628,8 @@ named_server_create(isc_mem_t *mctx, named_server_t **serverp) {
 
 	/* Initialize server data structures. */
 	ISC_LIST_INIT(server->kasplist);
-	ISC_LIST_INIT(server->viewlist);
+	server->viewlist = isc_mem_get(mctx, sizeof(*server->viewlist));
+	ISC_LIST_INIT(*server->viewlist);
 
 	/* Must be first. */
 	CHECKFATAL(dst_lib_init(named_g_mctx, named_g_engine),
@@ -10040,6 +10640,7 @@ named_server_create(isc_mem_t *mctx, named_server_t **serverp) {
 		   "setting up root hints");
 
 	atomic_init(&server->reload_status, NAMED_RELOAD_IN_PROGRESS);
+	atomic_init(&server->reconfig_pause, 0);
 
 	ns_server_create(mctx, get_matching_view, &server->sctx);
 
@@ -10137,9 +10738,11 @@ named_server_destroy(named_server_t **serverp) {
 	dst_lib_destroy();
 
 	INSIST(ISC_LIST_EMPTY(server->kasplist));
-	INSIST(ISC_LIST_EMPTY(server->viewlist));
+	INSIST(ISC_LIST_EMPTY(*server->viewlist));
 	INSIST(ISC_LIST_EMPTY(server->cachelist));
 
+	isc_mem_put(server->mctx, server->viewlist, sizeof(*server->viewlist));
+
 	if (server->tlsctx_server_cache != NULL) {
 		isc_tlsctx_cache_detach(&server->tlsctx_server_cache);
 	}
@@ -10388,7 +10991,7 @@ zone_from_args(named_server_t *server, isc_lex_t *lex, const char *zonetxt,
 
 	if (viewtxt == NULL) {
 		if (redirect) {
-			result = dns_viewlist_find(&server->viewlist,
+			result = dns_viewlist_find(server->viewlist,
 						   "_default",
 						   dns_rdataclass_in, &view);
 			if (result != ISC_R_SUCCESS || view->redirect == NULL) {
@@ -10401,7 +11004,7 @@ zone_from_args(named_server_t *server, isc_lex_t *lex, const char *zonetxt,
 				result = ISC_R_SUCCESS;
 			}
 		} else {
-			result = dns_viewlist_findzone(&server->viewlist, name,
+			result = dns_viewlist_findzone(server->viewlist, name,
 						       (classtxt == NULL),
 						       rdclass, zonep);
 			if (result == ISC_R_NOTFOUND) {
@@ -10416,7 +11019,7 @@ zone_from_args(named_server_t *server, isc_lex_t *lex, const char *zonetxt,
 			}
 		}
 	} else {
-		result = dns_viewlist_find(&server->viewlist, viewtxt, rdclass,
+		result = dns_viewlist_find(server->viewlist, viewtxt, rdclass,
 					   &view);
 		if (result != ISC_R_SUCCESS) {
 			snprintf(problem, sizeof(problem),
@@ -10815,6 +11418,7 @@ listenelt_fromconfig(const cfg_obj_t *listener, const cfg_obj_t *config,
 	bool tls_prefer_server_ciphers = false,
 	     tls_prefer_server_ciphers_set = false;
 	bool tls_session_tickets = false, tls_session_tickets_set = false;
+	bool tls_kernel_tls = false;
 	bool do_tls = false, no_tls = false, http = false;
 	ns_listenelt_t *delt = NULL;
 	uint32_t tls_protos = 0;
@@ -10842,6 +11446,7 @@ listenelt_fromconfig(const cfg_obj_t *listener, const cfg_obj_t *config,
 			const cfg_obj_t *ciphers_obj = NULL;
 			const cfg_obj_t *prefer_server_ciphers_obj = NULL;
 			const cfg_obj_t *session_tickets_obj = NULL;
+			const cfg_obj_t *kernel_tls_obj = NULL;
 
 			do_tls = true;
 
@@ -10916,6 +11521,13 @@ listenelt_fromconfig(const cfg_obj_t *listener, const cfg_obj_t *config,
 					cfg_obj_asboolean(session_tickets_obj);
 				tls_session_tickets_set = true;
 			}
+
+			if (cfg_map_get(tlsmap, "kernel-tls", &kernel_tls_obj) ==
+			    ISC_R_SUCCESS)
+			{
+				tls_kernel_tls =
+					cfg_obj_asboolean(kernel_tls_obj);
+			}
 		}
 	}
 
@@ -10930,7 +11542,8 @@ listenelt_fromconfig(const cfg_obj_t *listener, const cfg_obj_t *config,
 		.prefer_server_ciphers = tls_prefer_server_ciphers,
 		.prefer_server_ciphers_set = tls_prefer_server_ciphers_set,
 		.session_tickets = tls_session_tickets,
-		.session_tickets_set = tls_session_tickets_set
+		.session_tickets_set = tls_session_tickets_set,
+		.kernel_tls = tls_kernel_tls
 	};
 
 	httpobj = cfg_tuple_get(ltup, "http");
@@ -11451,7 +12064,7 @@ named_server_dumpdb(named_server_t *server, isc_lex_t *lex,
 
 nextview:
 	found = false;
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (ptr != NULL && strcmp(view->name, ptr) != 0) {
@@ -11527,7 +12140,7 @@ named_server_dumpsecroots(named_server_t *server, isc_lex_t *lex,
 	used = isc_buffer_usedlength(*text);
 
 	do {
-		for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+		for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 		     view = ISC_LIST_NEXT(view, link))
 		{
 			if (ptr != NULL && strcmp(view->name, ptr) != 0) {
@@ -11616,7 +12229,7 @@ named_server_dumprecursing(named_server_t *server) {
 	fprintf(fp, ";\n; Recursing Queries\n;\n");
 	ns_interfacemgr_dumprecursing(fp, server->interfacemgr);
 
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		fprintf(fp, ";\n; Active fetch domains [view: %s]\n;\n",
@@ -11719,7 +12332,7 @@ named_server_validation(named_server_t *server, isc_lex_t *lex,
 	ptr = next_token(lex, text);
 
 	isc_loopmgr_pause(named_g_loopmgr);
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if ((ptr != NULL && strcasecmp(ptr, view->name) != 0) ||
@@ -11795,7 +12408,7 @@ named_server_flushcache(named_server_t *server, isc_lex_t *lex) {
 		 * much more lightweight because only a few (most typically just
 		 * one) views will match.
 		 */
-		for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+		for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 		     view = ISC_LIST_NEXT(view, link))
 		{
 			if (strcasecmp(ptr, view->name) != 0) {
@@ -11844,7 +12457,7 @@ named_server_flushcache(named_server_t *server, isc_lex_t *lex) {
 	 * A worst case is that we have n views and n/2 caches, each shared by
 	 * two views.  Then this will be a O(n^2/4) operation.
 	 */
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (!dns_view_iscacheshared(view)) {
@@ -11943,7 +12556,7 @@ named_server_flushnode(named_server_t *server, isc_lex_t *lex, bool tree) {
 	isc_loopmgr_pause(named_g_loopmgr);
 	flushed = true;
 	found = false;
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (viewname != NULL && strcasecmp(viewname, view->name) != 0) {
@@ -12274,7 +12887,7 @@ named_server_sync(named_server_t *server, isc_lex_t *lex, isc_buffer_t **text) {
 	if (zone == NULL) {
 		isc_loopmgr_pause(named_g_loopmgr);
 		tresult = ISC_R_SUCCESS;
-		for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+		for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 		     view = ISC_LIST_NEXT(view, link))
 		{
 			result = dns_view_apply(view, false, NULL, synczone,
@@ -12344,7 +12957,7 @@ named_server_freeze(named_server_t *server, bool freeze, isc_lex_t *lex,
 	if (mayberaw == NULL) {
 		isc_loopmgr_pause(named_g_loopmgr);
 		tresult = ISC_R_SUCCESS;
-		for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+		for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 		     view = ISC_LIST_NEXT(view, link))
 		{
 			result = dns_view_freezezones(view, freeze);
@@ -13197,7 +13810,7 @@ newzone_parse(named_server_t *server, char *command, dns_view_t **viewp,
 	if (viewname == NULL || *viewname == '\0') {
 		viewname = "_default";
 	}
-	result = dns_viewlist_find(&server->viewlist, viewname, rdclass, &view);
+	result = dns_viewlist_find(server->viewlist, viewname, rdclass, &view);
 	if (result == ISC_R_NOTFOUND) {
 		(void)putstr(text, "no matching view found for '");
 		(void)putstr(text, viewname);
@@ -13352,7 +13965,7 @@ do_addzone(named_server_t *server, ns_cfgctx_t *cfg, dns_view_t *view,
 	/* Mark view unfrozen and configure zone */
 	dns_view_thaw(view);
 	result = configure_zone(cfg->config, zoneobj, cfg->vconfig, view,
-				&server->viewlist, &server->kasplist, cfg->actx,
+				server->viewlist, &server->kasplist, cfg->actx,
 				true, false, false);
 	dns_view_freeze(view);
 
@@ -13537,7 +14150,7 @@ do_modzone(named_server_t *server, ns_cfgctx_t *cfg, dns_view_t *view,
 	/* Reconfigure the zone */
 	dns_view_thaw(view);
 	result = configure_zone(cfg->config, zoneobj, cfg->vconfig, view,
-				&server->viewlist, &server->kasplist, cfg->actx,
+				server->viewlist, &server->kasplist, cfg->actx,
 				true, false, true);
 	dns_view_freeze(view);
 
@@ -15253,7 +15866,7 @@ named_server_nta(named_server_t *server, isc_lex_t *lex, bool readonly,
 	 * If -dump was specified, list NTA's and return
 	 */
 	if (dump) {
-		for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+		for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 		     view = ISC_LIST_NEXT(view, link))
 		{
 			if (ntatable != NULL) {
@@ -15314,7 +15927,7 @@ named_server_nta(named_server_t *server, isc_lex_t *lex, bool readonly,
 	now = isc_stdtime_now();
 
 	isc_loopmgr_pause(named_g_loopmgr);
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (viewname != NULL && strcmp(view->name, viewname) != 0) {
@@ -15444,7 +16057,7 @@ isc_result_t
 named_server_saventa(named_server_t *server) {
 	dns_view_t *view;
 
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		isc_result_t result = dns_view_saventa(view);
@@ -15465,7 +16078,7 @@ isc_result_t
 named_server_loadnta(named_server_t *server) {
 	dns_view_t *view;
 
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		isc_result_t result = dns_view_loadnta(view);
@@ -15765,7 +16378,7 @@ named_server_mkeys(named_server_t *server, isc_lex_t *lex,
 		viewtxt = next_token(lex, text);
 	}
 
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (viewtxt != NULL && (rdclass != view->rdclass ||
@@ -16048,7 +16661,7 @@ named_server_servestale(named_server_t *server, isc_lex_t *lex,
 
 	isc_loopmgr_pause(named_g_loopmgr);
 
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		dns_ttl_t stale_ttl = 0;
@@ -16163,7 +16776,7 @@ named_server_fetchlimit(named_server_t *server, isc_lex_t *lex,
 
 	/* Look for the view name. */
 	viewname = next_token(lex, text);
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		char tbuf[100];
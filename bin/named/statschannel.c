@@ -17,21 +17,25 @@
 #include <stdbool.h>
 
 #include <isc/buffer.h>
+#include <isc/histo.h>
 #include <isc/httpd.h>
 #include <isc/mem.h>
 #include <isc/once.h>
 #include <isc/stats.h>
 #include <isc/string.h>
+#include <isc/urcu.h>
 #include <isc/util.h>
 
 #include <dns/adb.h>
 #include <dns/cache.h>
 #include <dns/db.h>
+#include <dns/dlz.h>
 #include <dns/opcode.h>
 #include <dns/rcode.h>
 #include <dns/rdataclass.h>
 #include <dns/rdatatype.h>
 #include <dns/resolver.h>
+#include <dns/sdlz.h>
 #include <dns/stats.h>
 #include <dns/transport.h>
 #include <dns/view.h>
@@ -57,11 +61,11 @@
 #include "xsl_p.h"
 
 #define STATS_XML_VERSION_MAJOR "3"
-#define STATS_XML_VERSION_MINOR "14"
+#define STATS_XML_VERSION_MINOR "19"
 #define STATS_XML_VERSION	STATS_XML_VERSION_MAJOR "." STATS_XML_VERSION_MINOR
 
 #define STATS_JSON_VERSION_MAJOR "1"
-#define STATS_JSON_VERSION_MINOR "8"
+#define STATS_JSON_VERSION_MINOR "13"
 #define STATS_JSON_VERSION	 STATS_JSON_VERSION_MAJOR "." STATS_JSON_VERSION_MINOR
 
 #define CHECK(m)                               \
@@ -159,6 +163,7 @@ static const char *tcpinsizestats_desc[dns_sizecounter_in_max];
 static const char *tcpoutsizestats_desc[dns_sizecounter_out_max];
 static const char *dnstapstats_desc[dns_dnstapcounter_max];
 static const char *gluecachestats_desc[dns_gluecachestatscounter_max];
+static const char *dlzcachestats_desc[dns_dlzcachestatscounter_max];
 #if defined(EXTENDED_STATS)
 static const char *nsstats_xmldesc[ns_statscounter_max];
 static const char *resstats_xmldesc[dns_resstatscounter_max];
@@ -172,6 +177,7 @@ static const char *tcpinsizestats_xmldesc[dns_sizecounter_in_max];
 static const char *tcpoutsizestats_xmldesc[dns_sizecounter_out_max];
 static const char *dnstapstats_xmldesc[dns_dnstapcounter_max];
 static const char *gluecachestats_xmldesc[dns_gluecachestatscounter_max];
+static const char *dlzcachestats_xmldesc[dns_dlzcachestatscounter_max];
 #else /* if defined(EXTENDED_STATS) */
 #define nsstats_xmldesc		NULL
 #define resstats_xmldesc	NULL
@@ -185,6 +191,7 @@ static const char *gluecachestats_xmldesc[dns_gluecachestatscounter_max];
 #define tcpoutsizestats_xmldesc NULL
 #define dnstapstats_xmldesc	NULL
 #define gluecachestats_xmldesc	NULL
+#define dlzcachestats_xmldesc	NULL
 #endif /* EXTENDED_STATS */
 
 #define TRY0(a)                       \
@@ -194,6 +201,49 @@ static const char *gluecachestats_xmldesc[dns_gluecachestatscounter_max];
 			goto cleanup; \
 	} while (0)
 
+/*%
+ * The number of servers, per view, for which the round trip time
+ * percentiles are reported.
+ */
+#define ADBRTT_SERVERS 20
+
+#if defined(EXTENDED_STATS)
+/*%
+ * Names of the query latency histograms, in the order of ns_latency_t.
+ */
+static const struct {
+	const char *group;
+	const char *name;
+} latencystats_desc[ns_latency_max] = {
+	[ns_latency_udp] = { "transport", "UDP" },
+	[ns_latency_tcp] = { "transport", "TCP" },
+	[ns_latency_tls] = { "transport", "TLS" },
+	[ns_latency_https] = { "transport", "HTTPS" },
+	[ns_latency_noerror] = { "rcode", "NOERROR" },
+	[ns_latency_nxdomain] = { "rcode", "NXDOMAIN" },
+	[ns_latency_servfail] = { "rcode", "SERVFAIL" },
+	[ns_latency_refused] = { "rcode", "REFUSED" },
+	[ns_latency_otherrcode] = { "rcode", "other" },
+	[ns_latency_auth] = { "source", "authoritative" },
+	[ns_latency_cachehit] = { "source", "cache-hit" },
+	[ns_latency_cachemiss] = { "source", "cache-miss" },
+	[ns_latency_recursion] = { "source", "recursion" },
+};
+
+/*%
+ * The quantiles reported for each latency histogram, in the decreasing
+ * order that isc_histo_quantiles() requires.
+ */
+static const double latency_fractions[] = { 0.999, 0.99, 0.9, 0.5 };
+static const char *latency_quantiles[] = { "p999", "p99", "p90", "p50" };
+
+typedef struct latency_summary {
+	uint64_t count;
+	uint64_t mean;
+	uint64_t quantiles[ARRAY_SIZE(latency_fractions)];
+} latency_summary_t;
+#endif /* if defined(EXTENDED_STATS) */
+
 /*%
  * Mapping arrays to represent statistics counters in the order of our
  * preference, regardless of the order of counter indices.  For example,
@@ -211,6 +261,7 @@ static int tcpinsizestats_index[dns_sizecounter_in_max];
 static int tcpoutsizestats_index[dns_sizecounter_out_max];
 static int dnstapstats_index[dns_dnstapcounter_max];
 static int gluecachestats_index[dns_gluecachestatscounter_max];
+static int dlzcachestats_index[dns_dlzcachestatscounter_max];
 
 static void
 set_desc(int counter, int maxcounter, const char *fdesc, const char **fdescs,
@@ -254,6 +305,59 @@ get_histo_desc(const char *prefix, int i, int inf, bool ext) {
 	return (desc);
 }
 
+#if defined(EXTENDED_STATS)
+/*%
+ * Summarize a latency histogram; returns false if it is empty.
+ */
+static bool
+latency_summarize(isc_histomulti_t *hm, latency_summary_t *summary) {
+	isc_histo_t *hg = NULL;
+	double pop = 0.0, mean = 0.0;
+	isc_result_t result;
+
+	*summary = (latency_summary_t){ 0 };
+
+	isc_histomulti_merge(&hg, hm);
+	isc_histo_moments(hg, &pop, &mean, NULL);
+	result = isc_histo_quantiles(hg, ARRAY_SIZE(latency_fractions),
+				     latency_fractions, summary->quantiles);
+	isc_histo_destroy(&hg);
+
+	if (result != ISC_R_SUCCESS) {
+		return (false);
+	}
+
+	summary->count = (uint64_t)pop;
+	summary->mean = (uint64_t)mean;
+	return (true);
+}
+#endif /* if defined(EXTENDED_STATS) */
+
+/*%
+ * Iterate over all DLZ databases configured in 'view', searched and
+ * unsearched alike.  Pass NULL to get the first one.
+ */
+static dns_dlzdb_t *
+view_nextdlz(dns_view_t *view, dns_dlzdb_t *dlzdb) {
+	if (dlzdb == NULL) {
+		dlzdb = ISC_LIST_HEAD(view->dlz_searched);
+		if (dlzdb == NULL) {
+			dlzdb = ISC_LIST_HEAD(view->dlz_unsearched);
+		}
+		return (dlzdb);
+	}
+
+	if (dlzdb->search) {
+		dns_dlzdb_t *next = ISC_LIST_NEXT(dlzdb, link);
+		if (next == NULL) {
+			next = ISC_LIST_HEAD(view->dlz_unsearched);
+		}
+		return (next);
+	}
+
+	return (ISC_LIST_NEXT(dlzdb, link));
+}
+
 static void
 init_desc(void) {
 	int i;
@@ -377,6 +481,10 @@ init_desc(void) {
 		       "queries dropped due to recursive client limit",
 		       "RecLimitDropped");
 	SET_NSSTATDESC(updatequota, "Update quota exceeded", "UpdateQuota");
+	SET_NSSTATDESC(nsec3cachehit, "NSEC3 hashes found in the cache",
+		       "NSEC3CacheHit");
+	SET_NSSTATDESC(nsec3cachemiss, "NSEC3 hashes computed",
+		       "NSEC3CacheMiss");
 
 	INSIST(i == ns_statscounter_max);
 
@@ -470,6 +578,13 @@ init_desc(void) {
 			"ClientQuota");
 	SET_RESSTATDESC(nextitem, "waited for next item", "NextItem");
 	SET_RESSTATDESC(priming, "priming queries", "Priming");
+	SET_RESSTATDESC(valprefetch, "DNSSEC chain of trust prefetches",
+			"ValPrefetch");
+	SET_RESSTATDESC(qminskip, "QNAME minimization steps skipped",
+			"QminSkip");
+	SET_RESSTATDESC(hedgesent, "hedged queries sent", "HedgeSent");
+	SET_RESSTATDESC(hedgewon, "hedged queries answered first",
+			"HedgeWon");
 
 	INSIST(i == dns_resstatscounter_max);
 
@@ -530,6 +645,11 @@ init_desc(void) {
 	SET_ZONESTATDESC(xfrsuccess, "transfer requests succeeded",
 			 "XfrSuccess");
 	SET_ZONESTATDESC(xfrfail, "transfer requests failed", "XfrFail");
+	SET_ZONESTATDESC(jnlcompact, "journal compactions", "JnlCompact");
+	SET_ZONESTATDESC(jnlcompactfail, "journal compactions failed",
+			 "JnlCompactFail");
+	SET_ZONESTATDESC(jnlcompacttime, "longest journal compaction (ms)",
+			 "JnlCompactTime");
 	INSIST(i == dns_zonestatscounter_max);
 
 	/* Initialize socket statistics */
@@ -690,6 +810,25 @@ init_desc(void) {
 			      "GLUECACHEinsertsabsent");
 	INSIST(i == dns_gluecachestatscounter_max);
 
+#define SET_DLZCACHESTATDESC(counterid, desc, xmldesc)         \
+	do {                                                   \
+		set_desc(dns_dlzcachestatscounter_##counterid, \
+			 dns_dlzcachestatscounter_max, desc,   \
+			 dlzcachestats_desc, xmldesc,          \
+			 dlzcachestats_xmldesc);               \
+		dlzcachestats_index[i++] =                     \
+			dns_dlzcachestatscounter_##counterid;  \
+	} while (0)
+	i = 0;
+	SET_DLZCACHESTATDESC(hits, "DLZ answer cache hits", "DLZCACHEhits");
+	SET_DLZCACHESTATDESC(misses, "DLZ answer cache misses",
+			     "DLZCACHEmisses");
+	SET_DLZCACHESTATDESC(inserts, "DLZ answer cache inserts",
+			     "DLZCACHEinserts");
+	SET_DLZCACHESTATDESC(evictions, "DLZ answer cache evictions",
+			     "DLZCACHEevictions");
+	INSIST(i == dns_dlzcachestatscounter_max);
+
 	/* Sanity check */
 	for (i = 0; i < ns_statscounter_max; i++) {
 		INSIST(nsstats_desc[i] != NULL);
@@ -715,6 +854,9 @@ init_desc(void) {
 	for (i = 0; i < dns_gluecachestatscounter_max; i++) {
 		INSIST(gluecachestats_desc[i] != NULL);
 	}
+	for (i = 0; i < dns_dlzcachestatscounter_max; i++) {
+		INSIST(dlzcachestats_desc[i] != NULL);
+	}
 #if defined(EXTENDED_STATS)
 	for (i = 0; i < ns_statscounter_max; i++) {
 		INSIST(nsstats_xmldesc[i] != NULL);
@@ -740,6 +882,9 @@ init_desc(void) {
 	for (i = 0; i < dns_gluecachestatscounter_max; i++) {
 		INSIST(gluecachestats_xmldesc[i] != NULL);
 	}
+	for (i = 0; i < dns_dlzcachestatscounter_max; i++) {
+		INSIST(dlzcachestats_xmldesc[i] != NULL);
+	}
 #endif /* if defined(EXTENDED_STATS) */
 
 	/* Initialize traffic size statistics */
@@ -1272,6 +1417,54 @@ cleanup:
 #define STATS_XML_TRAFFIC 0x20
 #define STATS_XML_ALL	  0xff
 
+/*
+ * Render a latency histogram summary as a <histogram> element with the
+ * given group and name, or as a <latency> element if 'group' is NULL.
+ * Empty histograms are omitted.
+ */
+static isc_result_t
+latency_xmlrender(isc_histomulti_t *hm, const char *group, const char *name,
+		  xmlTextWriterPtr writer) {
+	latency_summary_t summary;
+	int xmlrc;
+
+	if (!latency_summarize(hm, &summary)) {
+		return (ISC_R_SUCCESS);
+	}
+
+	if (group != NULL) {
+		TRY0(xmlTextWriterStartElement(writer,
+					       ISC_XMLCHAR "histogram"));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "group",
+						 ISC_XMLCHAR group));
+		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "name",
+						 ISC_XMLCHAR name));
+	} else {
+		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "latency"));
+	}
+
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "count",
+					     "%" PRIu64, summary.count));
+	TRY0(xmlTextWriterWriteFormatElement(writer, ISC_XMLCHAR "mean",
+					     "%" PRIu64, summary.mean));
+	for (size_t i = ARRAY_SIZE(latency_fractions); i-- > 0;) {
+		TRY0(xmlTextWriterWriteFormatElement(
+			writer, ISC_XMLCHAR latency_quantiles[i], "%" PRIu64,
+			summary.quantiles[i]));
+	}
+
+	TRY0(xmlTextWriterEndElement(writer)); /* histogram or latency */
+
+	return (ISC_R_SUCCESS);
+
+cleanup:
+	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+		      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+		      "Failed at latency_xmlrender()");
+
+	return (ISC_R_FAILURE);
+}
+
 static isc_result_t
 zone_xmlrender(dns_zone_t *zone, void *arg) {
 	isc_result_t result;
@@ -1352,6 +1545,7 @@ zone_xmlrender(dns_zone_t *zone, void *arg) {
 		isc_stats_t *gluecachestats;
 		dns_stats_t *rcvquerystats;
 		dns_stats_t *dnssecsignstats;
+		isc_histomulti_t *latencystats;
 		uint64_t nsstat_values[ns_statscounter_max];
 		uint64_t gluecachestats_values[dns_gluecachestatscounter_max];
 
@@ -1440,6 +1634,13 @@ zone_xmlrender(dns_zone_t *zone, void *arg) {
 			/* counters type="dnssec-refresh"*/
 			TRY0(xmlTextWriterEndElement(writer));
 		}
+
+		latencystats = dns_zone_getlatencystats(zone);
+		if (latencystats != NULL) {
+			/* <latency> */
+			CHECK(latency_xmlrender(latencystats, NULL, NULL,
+						writer));
+		}
 	}
 
 	TRY0(xmlTextWriterEndElement(writer)); /* zone */
@@ -1720,6 +1921,55 @@ cleanup:
 	return (ISC_R_FAILURE);
 }
 
+static isc_result_t
+adbrtt_xmlrender(dns_view_t *view, xmlTextWriterPtr writer) {
+	dns_adbrtt_t servers[ADBRTT_SERVERS];
+	dns_adb_t *adb = NULL;
+	size_t count;
+	int xmlrc;
+
+	dns_view_getadb(view, &adb);
+	if (adb == NULL) {
+		return (ISC_R_SUCCESS);
+	}
+	count = dns_adb_toprtt(adb, servers, ARRAY_SIZE(servers));
+	dns_adb_detach(&adb);
+
+	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "adbrtt"));
+	for (size_t i = 0; i < count; i++) {
+		char addrbuf[ISC_SOCKADDR_FORMATSIZE];
+
+		isc_sockaddr_format(&servers[i].sockaddr, addrbuf,
+				    sizeof(addrbuf));
+
+		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "server"));
+		TRY0(xmlTextWriterWriteElement(writer, ISC_XMLCHAR "address",
+					       ISC_XMLCHAR addrbuf));
+		TRY0(xmlTextWriterWriteFormatElement(
+			writer, ISC_XMLCHAR "samples", "%" PRIu64,
+			servers[i].samples));
+		TRY0(xmlTextWriterWriteFormatElement(
+			writer, ISC_XMLCHAR "srtt", "%u", servers[i].srtt));
+		TRY0(xmlTextWriterWriteFormatElement(
+			writer, ISC_XMLCHAR "p50", "%u", servers[i].p50));
+		TRY0(xmlTextWriterWriteFormatElement(
+			writer, ISC_XMLCHAR "p95", "%u", servers[i].p95));
+		TRY0(xmlTextWriterWriteFormatElement(
+			writer, ISC_XMLCHAR "p99", "%u", servers[i].p99));
+		TRY0(xmlTextWriterEndElement(writer)); /* server */
+	}
+	TRY0(xmlTextWriterEndElement(writer)); /* adbrtt */
+
+	return (ISC_R_SUCCESS);
+
+cleanup:
+	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
+		      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
+		      "Failed at adbrtt_xmlrender()");
+
+	return (ISC_R_FAILURE);
+}
+
 static isc_result_t
 generatexml(named_server_t *server, uint32_t flags, int *buflen,
 	    xmlChar **buf) {
@@ -1727,15 +1977,18 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 	char configtime[sizeof "yyyy-mm-ddThh:mm:ss.sssZ"];
 	char nowstr[sizeof "yyyy-mm-ddThh:mm:ss.sssZ"];
 	isc_time_t now = isc_time_now();
+	size_t refreshzones, refreshprimaries;
 	xmlTextWriterPtr writer = NULL;
 	xmlDocPtr doc = NULL;
 	int xmlrc;
+	dns_viewlist_t *viewlist = NULL;
 	dns_view_t *view;
 	stats_dumparg_t dumparg;
 	dns_stats_t *cacherrstats;
 	uint64_t nsstat_values[ns_statscounter_max];
 	uint64_t resstat_values[dns_resstatscounter_max];
 	uint64_t adbstat_values[dns_adbstats_max];
+	uint64_t dlzcachestat_values[dns_dlzcachestatscounter_max];
 	uint64_t zonestat_values[dns_zonestatscounter_max];
 	uint64_t sockstat_values[isc_sockstatscounter_max];
 	uint64_t udpinsizestat_values[DNS_SIZEHISTO_MAXIN + 1];
@@ -1776,6 +2029,20 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "config-time"));
 	TRY0(xmlTextWriterWriteString(writer, ISC_XMLCHAR configtime));
 	TRY0(xmlTextWriterEndElement(writer)); /* config-time */
+	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "config-pause"));
+	TRY0(xmlTextWriterWriteFormatString(
+		writer, "%" PRIu64,
+		(uint64_t)atomic_load_relaxed(&server->reconfig_pause)));
+	TRY0(xmlTextWriterEndElement(writer)); /* config-pause */
+	dns_zonemgr_getrefreshbacklog(server->zonemgr, &refreshzones,
+				      &refreshprimaries);
+	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "refresh-backlog"));
+	TRY0(xmlTextWriterWriteFormatString(writer, "%zu", refreshzones));
+	TRY0(xmlTextWriterEndElement(writer)); /* refresh-backlog */
+	TRY0(xmlTextWriterStartElement(writer,
+				       ISC_XMLCHAR "refresh-primaries"));
+	TRY0(xmlTextWriterWriteFormatString(writer, "%zu", refreshprimaries));
+	TRY0(xmlTextWriterEndElement(writer)); /* refresh-primaries */
 	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "current-time"));
 	TRY0(xmlTextWriterWriteString(writer, ISC_XMLCHAR nowstr));
 	TRY0(xmlTextWriterEndElement(writer)); /* current-time */
@@ -1989,14 +2256,27 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 		TRY0(xmlTextWriterEndElement(writer)); /* </counters> */
 		TRY0(xmlTextWriterEndElement(writer)); /* </tcp> */
 		TRY0(xmlTextWriterEndElement(writer)); /* </ipv6> */
+
+		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "latency"));
+		for (size_t i = 0; i < ns_latency_max; i++) {
+			CHECK(latency_xmlrender(server->sctx->latencystats[i],
+						latencystats_desc[i].group,
+						latencystats_desc[i].name,
+						writer));
+		}
+		TRY0(xmlTextWriterEndElement(writer)); /* </latency> */
 		TRY0(xmlTextWriterEndElement(writer)); /* </traffic> */
 	}
 
 	/*
 	 * Render views.  For each view we know of, call its
-	 * rendering function.
+	 * rendering function.  The view list may be replaced by a
+	 * reconfiguration while we render it, so stay in an RCU read-side
+	 * critical section until we are done.
 	 */
-	view = ISC_LIST_HEAD(server->viewlist);
+	rcu_read_lock();
+	viewlist = rcu_dereference(server->viewlist);
+	view = ISC_LIST_HEAD(*viewlist);
 	TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "views"));
 	while (view != NULL && ((flags & (STATS_XML_SERVER | STATS_XML_ZONES |
 					  STATS_XML_XFRINS)) != 0))
@@ -2090,6 +2370,9 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 		}
 		TRY0(xmlTextWriterEndElement(writer)); /* </adbstats> */
 
+		/* <adbrtt> */
+		CHECK(adbrtt_xmlrender(view, writer));
+
 		/* <cachestats> */
 		TRY0(xmlTextWriterStartElement(writer, ISC_XMLCHAR "counters"));
 		TRY0(xmlTextWriterWriteAttribute(writer, ISC_XMLCHAR "type",
@@ -2097,10 +2380,37 @@ generatexml(named_server_t *server, uint32_t flags, int *buflen,
 		TRY0(dns_cache_renderxml(view->cache, writer));
 		TRY0(xmlTextWriterEndElement(writer)); /* </cachestats> */
 
+		/* <dlzcache> */
+		for (dns_dlzdb_t *dlzdb = view_nextdlz(view, NULL);
+		     dlzdb != NULL; dlzdb = view_nextdlz(view, dlzdb))
+		{
+			isc_stats_t *dlzstats = dns_sdlz_getcachestats(dlzdb);
+			if (dlzstats == NULL) {
+				continue;
+			}
+			TRY0(xmlTextWriterStartElement(writer,
+						       ISC_XMLCHAR "counters"));
+			TRY0(xmlTextWriterWriteAttribute(
+				writer, ISC_XMLCHAR "type",
+				ISC_XMLCHAR "dlzcache"));
+			TRY0(xmlTextWriterWriteAttribute(
+				writer, ISC_XMLCHAR "name",
+				ISC_XMLCHAR dlzdb->dlzname));
+			CHECK(dump_stats(dlzstats, isc_statsformat_xml, writer,
+					 NULL, dlzcachestats_xmldesc,
+					 dns_dlzcachestatscounter_max,
+					 dlzcachestats_index,
+					 dlzcachestat_values,
+					 ISC_STATSDUMP_VERBOSE));
+			TRY0(xmlTextWriterEndElement(writer)); /* </dlzcache> */
+		}
+
 		TRY0(xmlTextWriterEndElement(writer)); /* view */
 
 		view = ISC_LIST_NEXT(view, link);
 	}
+	rcu_read_unlock();
+	viewlist = NULL;
 	TRY0(xmlTextWriterEndElement(writer)); /* /views */
 
 	if ((flags & STATS_XML_MEM) != 0) {
@@ -2125,6 +2435,9 @@ cleanup:
 	isc_log_write(named_g_lctx, NAMED_LOGCATEGORY_GENERAL,
 		      NAMED_LOGMODULE_SERVER, ISC_LOG_ERROR,
 		      "failed generating XML response");
+	if (viewlist != NULL) {
+		rcu_read_unlock();
+	}
 	if (writer != NULL) {
 		xmlFreeTextWriter(writer);
 	}
@@ -2311,6 +2624,44 @@ addzone(char *name, char *classname, const char *ztype, uint32_t serial,
 	return (node);
 }
 
+/*
+ * Render a latency histogram summary as a JSON object; '*objp' is left
+ * NULL if the histogram is empty.
+ */
+static isc_result_t
+latency_jsonrender(isc_histomulti_t *hm, json_object **objp) {
+	isc_result_t result = ISC_R_SUCCESS;
+	latency_summary_t summary;
+	json_object *obj = NULL;
+
+	REQUIRE(objp != NULL && *objp == NULL);
+
+	if (!latency_summarize(hm, &summary)) {
+		return (ISC_R_SUCCESS);
+	}
+
+	obj = json_object_new_object();
+	CHECKMEM(obj);
+
+	json_object_object_add(
+		obj, "count",
+		json_object_new_int64(summary.count > INT64_MAX
+					      ? INT64_MAX
+					      : (int64_t)summary.count));
+	json_object_object_add(obj, "mean",
+			       json_object_new_int64(summary.mean));
+	for (size_t i = ARRAY_SIZE(latency_fractions); i-- > 0;) {
+		json_object_object_add(
+			obj, latency_quantiles[i],
+			json_object_new_int64(summary.quantiles[i]));
+	}
+
+	*objp = obj;
+
+cleanup:
+	return (result);
+}
+
 static isc_result_t
 zone_jsonrender(dns_zone_t *zone, void *arg) {
 	isc_result_t result = ISC_R_SUCCESS;
@@ -2377,6 +2728,7 @@ zone_jsonrender(dns_zone_t *zone, void *arg) {
 		isc_stats_t *gluecachestats;
 		dns_stats_t *rcvquerystats;
 		dns_stats_t *dnssecsignstats;
+		isc_histomulti_t *latencystats;
 		uint64_t nsstat_values[ns_statscounter_max];
 		uint64_t gluecachestats_values[dns_gluecachestatscounter_max];
 
@@ -2504,6 +2856,17 @@ zone_jsonrender(dns_zone_t *zone, void *arg) {
 				json_object_put(refresh_counters);
 			}
 		}
+
+		latencystats = dns_zone_getlatencystats(zone);
+		if (latencystats != NULL) {
+			json_object *latency = NULL;
+
+			CHECK(latency_jsonrender(latencystats, &latency));
+			if (latency != NULL) {
+				json_object_object_add(zoneobj, "latency",
+						       latency);
+			}
+		}
 	}
 
 	json_object_array_add(zonearray, zoneobj);
@@ -2766,13 +3129,121 @@ cleanup:
 	return (result);
 }
 
+static isc_result_t
+dlzcache_jsonrender(dns_view_t *view, json_object *viewobj) {
+	isc_result_t result = ISC_R_SUCCESS;
+	uint64_t dlzcachestat_values[dns_dlzcachestatscounter_max];
+	json_object *dlzobj = NULL;
+
+	for (dns_dlzdb_t *dlzdb = view_nextdlz(view, NULL); dlzdb != NULL;
+	     dlzdb = view_nextdlz(view, dlzdb))
+	{
+		isc_stats_t *dlzstats = dns_sdlz_getcachestats(dlzdb);
+		json_object *counters = NULL;
+
+		if (dlzstats == NULL) {
+			continue;
+		}
+
+		if (dlzobj == NULL) {
+			dlzobj = json_object_new_object();
+			CHECKMEM(dlzobj);
+		}
+
+		counters = json_object_new_object();
+		CHECKMEM(counters);
+
+		result = dump_stats(dlzstats, isc_statsformat_json, counters,
+				    NULL, dlzcachestats_xmldesc,
+				    dns_dlzcachestatscounter_max,
+				    dlzcachestats_index, dlzcachestat_values,
+				    0);
+		if (result != ISC_R_SUCCESS) {
+			json_object_put(counters);
+			goto cleanup;
+		}
+
+		json_object_object_add(dlzobj, dlzdb->dlzname, counters);
+	}
+
+	if (dlzobj != NULL) {
+		json_object_object_add(viewobj, "dlzcache", dlzobj);
+		dlzobj = NULL;
+	}
+
+cleanup:
+	if (dlzobj != NULL) {
+		json_object_put(dlzobj);
+	}
+	return (result);
+}
+
+static isc_result_t
+adbrtt_jsonrender(dns_view_t *view, json_object *viewobj) {
+	isc_result_t result = ISC_R_SUCCESS;
+	dns_adbrtt_t servers[ADBRTT_SERVERS];
+	dns_adb_t *adb = NULL;
+	json_object *list = NULL;
+	size_t count;
+
+	dns_view_getadb(view, &adb);
+	if (adb == NULL) {
+		return (ISC_R_SUCCESS);
+	}
+	count = dns_adb_toprtt(adb, servers, ARRAY_SIZE(servers));
+	dns_adb_detach(&adb);
+
+	list = json_object_new_array();
+	CHECKMEM(list);
+
+	for (size_t i = 0; i < count; i++) {
+		char addrbuf[ISC_SOCKADDR_FORMATSIZE];
+		json_object *srvobj = NULL;
+
+		isc_sockaddr_format(&servers[i].sockaddr, addrbuf,
+				    sizeof(addrbuf));
+
+		srvobj = json_object_new_object();
+		CHECKMEM(srvobj);
+		json_object_array_add(list, srvobj);
+
+		json_object_object_add(srvobj, "address",
+				       json_object_new_string(addrbuf));
+		json_object_object_add(
+			srvobj, "samples",
+			json_object_new_int64(
+				servers[i].samples > INT64_MAX
+					? INT64_MAX
+					: (int64_t)servers[i].samples));
+		json_object_object_add(srvobj, "srtt",
+				       json_object_new_int64(servers[i].srtt));
+		json_object_object_add(srvobj, "p50",
+				       json_object_new_int64(servers[i].p50));
+		json_object_object_add(srvobj, "p95",
+				       json_object_new_int64(servers[i].p95));
+		json_object_object_add(srvobj, "p99",
+				       json_object_new_int64(servers[i].p99));
+	}
+
+	json_object_object_add(viewobj, "adbrtt", list);
+	list = NULL;
+
+cleanup:
+	if (list != NULL) {
+		json_object_put(list);
+	}
+	return (result);
+}
+
 static isc_result_t
 generatejson(named_server_t *server, size_t *msglen, const char **msg,
 	     json_object **rootp, uint32_t flags) {
+	dns_viewlist_t *views = NULL;
 	dns_view_t *view;
 	isc_result_t result = ISC_R_SUCCESS;
 	json_object *bindstats, *viewlist, *counters, *obj;
 	json_object *traffic = NULL;
+	json_object *latency = NULL;
 	json_object *udpreq4 = NULL, *udpresp4 = NULL;
 	json_object *tcpreq4 = NULL, *tcpresp4 = NULL;
 	json_object *udpreq6 = NULL, *udpresp6 = NULL;
@@ -2794,6 +3265,7 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 	char configtime[sizeof "yyyy-mm-ddThh:mm:ss.sssZ"];
 	char nowstr[sizeof "yyyy-mm-ddThh:mm:ss.sssZ"];
 	isc_time_t now;
+	size_t refreshzones, refreshprimaries;
 
 	REQUIRE(msglen != NULL);
 	REQUIRE(msg != NULL && *msg == NULL);
@@ -2825,6 +3297,21 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 	CHECKMEM(obj);
 	json_object_object_add(bindstats, "config-time", obj);
 
+	obj = json_object_new_int64(
+		atomic_load_relaxed(&server->reconfig_pause));
+	CHECKMEM(obj);
+	json_object_object_add(bindstats, "config-pause", obj);
+
+	dns_zonemgr_getrefreshbacklog(server->zonemgr, &refreshzones,
+				      &refreshprimaries);
+	obj = json_object_new_int64(refreshzones);
+	CHECKMEM(obj);
+	json_object_object_add(bindstats, "refresh-backlog", obj);
+
+	obj = json_object_new_int64(refreshprimaries);
+	CHECKMEM(obj);
+	json_object_object_add(bindstats, "refresh-primaries", obj);
+
 	obj = json_object_new_string(nowstr);
 	CHECKMEM(obj);
 	json_object_object_add(bindstats, "current-time", obj);
@@ -2992,7 +3479,9 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 
 		json_object_object_add(bindstats, "views", viewlist);
 
-		view = ISC_LIST_HEAD(server->viewlist);
+		rcu_read_lock();
+		views = rcu_dereference(server->viewlist);
+		view = ISC_LIST_HEAD(*views);
 		while (view != NULL) {
 			json_object *za, *xa, *v = json_object_new_object();
 			dns_adb_t *adb = NULL;
@@ -3140,10 +3629,16 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 					json_object_object_add(res, "adb",
 							       counters);
 				}
+
+				CHECK(adbrtt_jsonrender(view, res));
+
+				CHECK(dlzcache_jsonrender(view, v));
 			}
 
 			view = ISC_LIST_NEXT(view, link);
 		}
+		rcu_read_unlock();
+		views = NULL;
 	}
 
 	if ((flags & STATS_JSON_NET) != 0) {
@@ -3279,6 +3774,36 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 				       tcpreq6);
 		json_object_object_add(
 			traffic, "dns-tcp-responses-sizes-sent-ipv6", tcpresp6);
+
+		latency = json_object_new_object();
+		CHECKMEM(latency);
+		json_object_object_add(traffic, "latency", latency);
+
+		for (size_t i = 0; i < ns_latency_max; i++) {
+			const char *group = latencystats_desc[i].group;
+			json_object *groupobj = NULL;
+			json_object *histo = NULL;
+
+			CHECK(latency_jsonrender(server->sctx->latencystats[i],
+						 &histo));
+			if (histo == NULL) {
+				continue;
+			}
+			if (!json_object_object_get_ex(latency, group,
+						       &groupobj))
+			{
+				groupobj = json_object_new_object();
+				if (groupobj == NULL) {
+					json_object_put(histo);
+					CHECKMEM(groupobj);
+				}
+				json_object_object_add(latency, group,
+						       groupobj);
+			}
+			json_object_object_add(groupobj,
+					       latencystats_desc[i].name, histo);
+		}
+
 		json_object_object_add(bindstats, "traffic", traffic);
 		udpreq4 = NULL;
 		udpresp4 = NULL;
@@ -3303,6 +3828,9 @@ generatejson(named_server_t *server, size_t *msglen, const char **msg,
 	result = ISC_R_SUCCESS;
 
 cleanup:
+	if (views != NULL) {
+		rcu_read_unlock();
+	}
 	if (udpreq4 != NULL) {
 		json_object_put(udpreq4);
 	}
@@ -3905,6 +4433,7 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 	uint64_t zonestat_values[dns_zonestatscounter_max];
 	uint64_t sockstat_values[isc_sockstatscounter_max];
 	uint64_t gluecachestats_values[dns_gluecachestatscounter_max];
+	uint64_t dlzcachestat_values[dns_dlzcachestatscounter_max];
 	isc_stdtime_t now = isc_stdtime_now();
 
 	isc_once_do(&once, init_desc);
@@ -3928,7 +4457,7 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 			    0);
 
 	fprintf(fp, "++ Outgoing Queries ++\n");
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		dns_stats_t *dstats = NULL;
@@ -3960,7 +4489,7 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 	(void)dump_stats(server->resolverstats, isc_statsformat_file, fp, NULL,
 			 resstats_desc, dns_resstatscounter_max, resstats_index,
 			 resstat_values, 0);
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		isc_stats_t *istats = NULL;
@@ -3980,7 +4509,7 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 	}
 
 	fprintf(fp, "++ Cache Statistics ++\n");
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		if (strcmp(view->name, "_default") == 0) {
@@ -3999,7 +4528,7 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 	}
 
 	fprintf(fp, "++ Cache DB RRsets ++\n");
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		dns_stats_t *cacherrstats;
@@ -4026,7 +4555,7 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 	}
 
 	fprintf(fp, "++ ADB stats ++\n");
-	for (view = ISC_LIST_HEAD(server->viewlist); view != NULL;
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		dns_adb_t *adb = NULL;
@@ -4050,6 +4579,32 @@ named_stats_dump(named_server_t *server, FILE *fp) {
 				 adbstats_index, adbstat_values, 0);
 	}
 
+	fprintf(fp, "++ DLZ Answer Cache Statistics ++\n");
+	for (view = ISC_LIST_HEAD(*server->viewlist); view != NULL;
+	     view = ISC_LIST_NEXT(view, link))
+	{
+		for (dns_dlzdb_t *dlzdb = view_nextdlz(view, NULL);
+		     dlzdb != NULL; dlzdb = view_nextdlz(view, dlzdb))
+		{
+			isc_stats_t *dlzstats = dns_sdlz_getcachestats(dlzdb);
+			if (dlzstats == NULL) {
+				continue;
+			}
+			if (strcmp(view->name, "_default") == 0) {
+				fprintf(fp, "[View: default (DLZ: %s)]\n",
+					dlzdb->dlzname);
+			} else {
+				fprintf(fp, "[View: %s (DLZ: %s)]\n",
+					view->name, dlzdb->dlzname);
+			}
+			(void)dump_stats(dlzstats, isc_statsformat_file, fp,
+					 NULL, dlzcachestats_desc,
+					 dns_dlzcachestatscounter_max,
+					 dlzcachestats_index,
+					 dlzcachestat_values, 0);
+		}
+	}
+
 	fprintf(fp, "++ Socket I/O Statistics ++\n");
 	(void)dump_stats(server->sockstats, isc_statsformat_file, fp, NULL,
 			 sockstats_desc, isc_sockstatscounter_max,
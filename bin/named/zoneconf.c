@@ -20,6 +20,7 @@
 #include <isc/result.h>
 #include <isc/stats.h>
 #include <isc/string.h>
+#include <isc/urcu.h>
 #include <isc/util.h>
 
 #include <dns/acl.h>
@@ -81,7 +82,7 @@ typedef enum {
 static isc_result_t
 configure_zone_acl(const cfg_obj_t *zconfig, const cfg_obj_t *vconfig,
 		   const cfg_obj_t *config, acl_type_t acltype,
-		   cfg_aclconfctx_t *actx, dns_zone_t *zone,
+		   cfg_aclconfctx_t *actx, dns_view_t *view, dns_zone_t *zone,
 		   void (*setzacl)(dns_zone_t *, dns_acl_t *),
 		   void (*clearzacl)(dns_zone_t *)) {
 	isc_result_t result;
@@ -90,9 +91,6 @@ configure_zone_acl(const cfg_obj_t *zconfig, const cfg_obj_t *vconfig,
 	int i = 0;
 	dns_acl_t **aclp = NULL, *acl = NULL;
 	const char *aclname;
-	dns_view_t *view;
-
-	view = dns_zone_getview(zone);
 
 	switch (acltype) {
 	case allow_notify:
@@ -773,6 +771,7 @@ isself(dns_view_t *myview, dns_tsigkey_t *mykey, const isc_sockaddr_t *srcaddr,
        const isc_sockaddr_t *dstaddr, dns_rdataclass_t rdclass,
        void *arg ISC_ATTR_UNUSED) {
 	dns_aclenv_t *env = NULL;
+	dns_viewlist_t *viewlist = NULL;
 	dns_view_t *view = NULL;
 	dns_tsigkey_t *key = NULL;
 	isc_netaddr_t netsrc;
@@ -792,7 +791,9 @@ isself(dns_view_t *myview, dns_tsigkey_t *mykey, const isc_sockaddr_t *srcaddr,
 	isc_netaddr_fromsockaddr(&netdst, dstaddr);
 	env = ns_interfacemgr_getaclenv(named_g_server->interfacemgr);
 
-	for (view = ISC_LIST_HEAD(named_g_server->viewlist); view != NULL;
+	rcu_read_lock();
+	viewlist = rcu_dereference(named_g_server->viewlist);
+	for (view = ISC_LIST_HEAD(*viewlist); view != NULL;
 	     view = ISC_LIST_NEXT(view, link))
 	{
 		const dns_name_t *tsig = NULL;
@@ -828,6 +829,8 @@ isself(dns_view_t *myview, dns_tsigkey_t *mykey, const isc_sockaddr_t *srcaddr,
 			break;
 		}
 	}
+	rcu_read_unlock();
+
 	return (view == myview);
 }
 
@@ -866,8 +869,8 @@ process_notifytype(dns_notifytype_t ntype, dns_zonetype_t ztype,
 isc_result_t
 named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 		     const cfg_obj_t *zconfig, cfg_aclconfctx_t *ac,
-		     dns_kasplist_t *kasplist, dns_zone_t *zone,
-		     dns_zone_t *raw) {
+		     dns_kasplist_t *kasplist, dns_view_t *view,
+		     dns_zone_t *zone, dns_zone_t *raw) {
 	isc_result_t result;
 	const char *zname;
 	dns_rdataclass_t zclass;
@@ -1104,7 +1107,8 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 	 */
 	if (ztype == dns_zone_secondary || ztype == dns_zone_mirror) {
 		CHECK(configure_zone_acl(zconfig, vconfig, config, allow_notify,
-					 ac, mayberaw, dns_zone_setnotifyacl,
+					 ac, view, mayberaw,
+					 dns_zone_setnotifyacl,
 					 dns_zone_clearnotifyacl));
 	}
 
@@ -1112,11 +1116,11 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 	 * XXXAG This probably does not make sense for stubs.
 	 */
 	CHECK(configure_zone_acl(zconfig, vconfig, config, allow_query, ac,
-				 zone, dns_zone_setqueryacl,
+				 view, zone, dns_zone_setqueryacl,
 				 dns_zone_clearqueryacl));
 
 	CHECK(configure_zone_acl(zconfig, vconfig, config, allow_query_on, ac,
-				 zone, dns_zone_setqueryonacl,
+				 view, zone, dns_zone_setqueryonacl,
 				 dns_zone_clearqueryonacl));
 
 	obj = NULL;
@@ -1309,8 +1313,8 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 		dns_zone_setisself(zone, isself, NULL);
 
 		CHECK(configure_zone_acl(
-			zconfig, vconfig, config, allow_transfer, ac, zone,
-			dns_zone_setxfracl, dns_zone_clearxfracl));
+			zconfig, vconfig, config, allow_transfer, ac, view,
+			zone, dns_zone_setxfracl, dns_zone_clearxfracl));
 
 		obj = NULL;
 		result = named_config_get(maps, "max-transfer-time-out", &obj);
@@ -1525,7 +1529,8 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 		dns_acl_t *updateacl;
 
 		CHECK(configure_zone_acl(zconfig, vconfig, config, allow_update,
-					 ac, mayberaw, dns_zone_setupdateacl,
+					 ac, view, mayberaw,
+					 dns_zone_setupdateacl,
 					 dns_zone_clearupdateacl));
 
 		updateacl = dns_zone_getupdateacl(mayberaw);
@@ -1610,8 +1615,8 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 
 	if (ztype == dns_zone_secondary || ztype == dns_zone_mirror) {
 		CHECK(configure_zone_acl(zconfig, vconfig, config,
-					 allow_update_forwarding, ac, mayberaw,
-					 dns_zone_setforwardacl,
+					 allow_update_forwarding, ac, view,
+					 mayberaw, dns_zone_setforwardacl,
 					 dns_zone_clearforwardacl));
 	}
 
@@ -1760,6 +1765,11 @@ named_zone_configure(const cfg_obj_t *config, const cfg_obj_t *vconfig,
 			dns_zone_setserialupdatemethod(
 				zone, dns_updatemethod_increment);
 		}
+
+		obj = NULL;
+		result = named_config_get(maps, "update-commit-window", &obj);
+		INSIST(result == ISC_R_SUCCESS && obj != NULL);
+		dns_zone_setupdatewindow(mayberaw, cfg_obj_asuint32(obj));
 	}
 
 	/*
@@ -0,0 +1,105 @@
+# Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+#
+# SPDX-License-Identifier: MPL-2.0
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0.  If a copy of the MPL was not distributed with this
+# file, you can obtain one at https://mozilla.org/MPL/2.0/.
+#
+# See the COPYRIGHT file distributed with this work for additional
+# information regarding copyright ownership.
+
+
+from __future__ import print_function
+import os
+import sys
+import signal
+import socket
+import select
+import threading
+import time
+
+
+############################################################################
+# Relay a DNS query.
+# Forwards every UDP query to the authoritative server behind this proxy
+# and sends its response back after a delay of 200 milliseconds, so that
+# each round trip the resolver makes costs a known amount of time.  Each
+# query is relayed on its own thread, so queries sent in parallel are
+# also delayed in parallel.
+############################################################################
+DELAY = 0.2
+
+
+def relay(s, msg, client, server):
+    time.sleep(DELAY)
+    upstream = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    upstream.settimeout(2)
+    try:
+        upstream.sendto(msg, server)
+        rsp = upstream.recvfrom(65535)
+        s.sendto(rsp[0], client)
+    except socket.error:
+        print("NO RESPONSE")
+    finally:
+        upstream.close()
+
+
+def sigterm(signum, frame):
+    print("Shutting down now...")
+    os.remove("ans.pid")
+    running = False
+    sys.exit(0)
+
+
+############################################################################
+# Main
+#
+# Set up the relay, open the pid file, and start the main loop,
+# listening for queries and relaying them.
+############################################################################
+ip4 = "10.53.0.6"
+target4 = "10.53.0.3"
+
+try:
+    port = int(os.environ["PORT"])
+except:
+    port = 5300
+
+query4_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+query4_socket.bind((ip4, port))
+
+signal.signal(signal.SIGTERM, sigterm)
+
+f = open("ans.pid", "w")
+pid = os.getpid()
+print(pid, file=f)
+f.close()
+
+running = True
+
+print("Relaying %s port %d to %s" % (ip4, port, target4))
+print("Ctrl-c to quit")
+
+input = [query4_socket]
+
+while running:
+    try:
+        inputready, outputready, exceptready = select.select(input, [], [])
+    except select.error as e:
+        break
+    except socket.error as e:
+        break
+    except KeyboardInterrupt:
+        break
+
+    for s in inputready:
+        if s == query4_socket:
+            msg = s.recvfrom(65535)
+            t = threading.Thread(
+                target=relay, args=(s, msg[0], msg[1], (target4, port))
+            )
+            t.daemon = True
+            t.start()
+    if not running:
+        break
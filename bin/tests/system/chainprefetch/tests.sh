@@ -0,0 +1,73 @@
+#!/bin/sh
+
+# Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+#
+# SPDX-License-Identifier: MPL-2.0
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0.  If a copy of the MPL was not distributed with this
+# file, you can obtain one at https://mozilla.org/MPL/2.0/.
+#
+# See the COPYRIGHT file distributed with this work for additional
+# information regarding copyright ownership.
+
+set -e
+
+. ../conf.sh
+
+status=0
+n=0
+
+rm -f dig.out.*
+
+DIGOPTS="+noadd +nosea +nocmd +dnssec -p ${PORT}"
+
+# Every authoritative server sits behind a proxy adding 200 ms to each
+# round trip, so the query time of the first, cold-cache lookup is
+# dominated by the number of sequential round trips the resolver makes.
+# ns7 validates the chain of trust one zone at a time; ns8 has
+# dnssec-chain-prefetch enabled and looks up the DS and DNSKEY RRsets
+# of sub.example, example and the root in parallel.
+
+query_time() {
+  awk '/^;; Query time:/ { print $4 }' "$1"
+}
+
+n=$((n + 1))
+echo_i "checking cold-cache validation without chain prefetch ($n)"
+ret=0
+$DIG $DIGOPTS www.sub.example. @10.53.0.7 a >dig.out.ns7.test$n || ret=1
+grep "status: NOERROR" dig.out.ns7.test$n >/dev/null || ret=1
+grep "flags:[^;]* ad[ ;]" dig.out.ns7.test$n >/dev/null || ret=1
+grep "^www\.sub\.example\..*192\.0\.2\.1" dig.out.ns7.test$n >/dev/null || ret=1
+noprefetch=$(query_time dig.out.ns7.test$n)
+echo_i "query time without chain prefetch: ${noprefetch:-?} msec"
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
+n=$((n + 1))
+echo_i "checking cold-cache validation with chain prefetch ($n)"
+ret=0
+$DIG $DIGOPTS www.sub.example. @10.53.0.8 a >dig.out.ns8.test$n || ret=1
+grep "status: NOERROR" dig.out.ns8.test$n >/dev/null || ret=1
+grep "flags:[^;]* ad[ ;]" dig.out.ns8.test$n >/dev/null || ret=1
+grep "^www\.sub\.example\..*192\.0\.2\.1" dig.out.ns8.test$n >/dev/null || ret=1
+prefetch=$(query_time dig.out.ns8.test$n)
+echo_i "query time with chain prefetch: ${prefetch:-?} msec"
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
+n=$((n + 1))
+echo_i "checking that the chain prefetch saves at least one round trip ($n)"
+ret=0
+[ -n "$noprefetch" ] || ret=1
+[ -n "$prefetch" ] || ret=1
+if [ $ret = 0 ]; then
+  echo_i "saved $((noprefetch - prefetch)) msec ($noprefetch -> $prefetch)"
+  [ "$((noprefetch - prefetch))" -ge 200 ] || ret=1
+fi
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
+echo_i "exit status: $status"
+[ $status -eq 0 ] || exit 1
@@ -21,5 +21,6 @@ rm -f */named.conf
 rm -f */named.run
 rm -f ns1/ddns.key
 rm -f dig.out*
+rm -f deferred.test*
 rm -f ns1/session.key
 rm -f ns*/managed-keys.bind*
@@ -18,10 +18,12 @@
 
 #include "driver.h"
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include <isc/log.h>
 #include <isc/result.h>
@@ -39,6 +41,7 @@ dlz_dlopen_create_t dlz_create;
 dlz_dlopen_destroy_t dlz_destroy;
 dlz_dlopen_findzonedb_t dlz_findzonedb;
 dlz_dlopen_lookup_t dlz_lookup;
+dlz_dlopen_lookup_async_t dlz_lookup_async;
 dlz_dlopen_allowzonexfr_t dlz_allowzonexfr;
 dlz_dlopen_allnodes_t dlz_allnodes;
 dlz_dlopen_newversion_t dlz_newversion;
@@ -90,6 +93,15 @@ struct dlz_example_data {
 
 	bool transaction_started;
 
+	/*
+	 * With "delay=<ms>", dlz_lookup_async() answers from a thread of
+	 * its own after that long, to simulate a slow backend.
+	 */
+	unsigned int delay;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned int pending;
+
 	/* Helper functions from the dlz_dlopen driver */
 	log_t *log;
 	dns_sdlz_putrr_t *putrr;
@@ -267,6 +279,8 @@ dlz_create(const char *dlzname, unsigned int argc, char *argv[], void **dbdata,
 	if (state == NULL) {
 		return (ISC_R_NOMEMORY);
 	}
+	pthread_mutex_init(&state->lock, NULL);
+	pthread_cond_init(&state->cond, NULL);
 
 	/* Fill in the helper functions */
 	va_start(ap, dbdata);
@@ -309,6 +323,10 @@ dlz_create(const char *dlzname, unsigned int argc, char *argv[], void **dbdata,
 		CHECK(ISC_R_NOSPACE);
 	}
 
+	if (argc > 2 && strncmp(argv[2], "delay=", 6) == 0) {
+		state->delay = atoi(argv[2] + 6);
+	}
+
 	add_name(state, &state->current[0], state->zone_name, "soa", 3600,
 		 soa_data);
 	add_name(state, &state->current[0], state->zone_name, "ns", 3600,
@@ -334,6 +352,16 @@ dlz_destroy(void *dbdata) {
 	struct dlz_example_data *state = (struct dlz_example_data *)dbdata;
 
 	loginfo("dlz_example: shutting down zone %s", state->zone_name);
+
+	/* Lookups still running in the background must complete first */
+	pthread_mutex_lock(&state->lock);
+	while (state->pending > 0) {
+		pthread_cond_wait(&state->cond, &state->lock);
+	}
+	pthread_mutex_unlock(&state->lock);
+	pthread_cond_destroy(&state->cond);
+	pthread_mutex_destroy(&state->lock);
+
 	free(state->zone_name);
 	free(state);
 }
@@ -417,10 +445,10 @@ dlz_findzonedb(void *dbdata, const char *name, dns_clientinfomethods_t *methods,
  * If the queryname is "too-long", send back a TXT record that's too long
  * to process; this should result in a SERVFAIL when queried.
  */
-isc_result_t
-dlz_lookup(const char *zone, const char *name, void *dbdata,
-	   dns_sdlzlookup_t *lookup, dns_clientinfomethods_t *methods,
-	   dns_clientinfo_t *clientinfo) {
+static isc_result_t
+lookup_name(const char *zone, const char *name, void *dbdata,
+	    dns_sdlzlookup_t *lookup, dns_clientinfomethods_t *methods,
+	    dns_clientinfo_t *clientinfo) {
 	isc_result_t result;
 	struct dlz_example_data *state = (struct dlz_example_data *)dbdata;
 	bool found = false;
@@ -572,6 +600,121 @@ dlz_lookup(const char *zone, const char *name, void *dbdata,
 	return (ISC_R_SUCCESS);
 }
 
+/*
+ * lookup_name() keeps static state, and it is also called from the
+ * threads answering the lookups deferred by dlz_lookup_async().
+ */
+static pthread_mutex_t lookup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+isc_result_t
+dlz_lookup(const char *zone, const char *name, void *dbdata,
+	   dns_sdlzlookup_t *lookup, dns_clientinfomethods_t *methods,
+	   dns_clientinfo_t *clientinfo) {
+	isc_result_t result;
+
+	pthread_mutex_lock(&lookup_lock);
+	result = lookup_name(zone, name, dbdata, lookup, methods, clientinfo);
+	pthread_mutex_unlock(&lookup_lock);
+
+	return (result);
+}
+
+struct deferred_lookup {
+	struct dlz_example_data *state;
+	char *zone;
+	char *name;
+	dns_sdlzlookup_t *lookup;
+	dns_sdlz_lookupdone_t *done;
+	void *arg;
+};
+
+static void *
+deferred_lookup_run(void *arg) {
+	struct deferred_lookup *dl = (struct deferred_lookup *)arg;
+	struct dlz_example_data *state = dl->state;
+	struct timespec ts = {
+		.tv_sec = state->delay / 1000,
+		.tv_nsec = (state->delay % 1000) * 1000000,
+	};
+	isc_result_t result;
+
+	nanosleep(&ts, NULL);
+
+	/* The client information is gone by now */
+	result = dlz_lookup(dl->zone, dl->name, state, dl->lookup, NULL,
+			    NULL);
+	loginfo("dlz_example: deferred lookup for %s done", dl->name);
+	dl->done(dl->arg, result);
+
+	free(dl->zone);
+	free(dl->name);
+	free(dl);
+
+	pthread_mutex_lock(&state->lock);
+	state->pending--;
+	pthread_cond_signal(&state->cond);
+	pthread_mutex_unlock(&state->lock);
+
+	return (NULL);
+}
+
+/*
+ * Answer lookups after the configured delay, without holding up
+ * named in the meantime.
+ */
+isc_result_t
+dlz_lookup_async(const char *zone, const char *name, void *dbdata,
+		 dns_sdlzlookup_t *lookup, dns_clientinfomethods_t *methods,
+		 dns_clientinfo_t *clientinfo, dns_sdlz_lookupdone_t *done,
+		 void *arg) {
+	struct dlz_example_data *state = (struct dlz_example_data *)dbdata;
+	struct deferred_lookup *dl = NULL;
+	pthread_t thread;
+
+	UNUSED(methods);
+	UNUSED(clientinfo);
+
+	if (state->delay == 0) {
+		return (ISC_R_NOTIMPLEMENTED);
+	}
+
+	dl = calloc(1, sizeof(*dl));
+	if (dl == NULL) {
+		return (ISC_R_NOMEMORY);
+	}
+	dl->state = state;
+	dl->zone = strdup(zone);
+	dl->name = strdup(name);
+	dl->lookup = lookup;
+	dl->done = done;
+	dl->arg = arg;
+	if (dl->zone == NULL || dl->name == NULL) {
+		goto failure;
+	}
+
+	pthread_mutex_lock(&state->lock);
+	state->pending++;
+	pthread_mutex_unlock(&state->lock);
+
+	if (pthread_create(&thread, NULL, deferred_lookup_run, dl) != 0) {
+		pthread_mutex_lock(&state->lock);
+		state->pending--;
+		pthread_mutex_unlock(&state->lock);
+		goto failure;
+	}
+	pthread_detach(thread);
+
+	loginfo("dlz_example: lookup for %s deferred by %u ms", name,
+		state->delay);
+	return (ISC_R_INPROGRESS);
+
+failure:
+	free(dl->zone);
+	free(dl->name);
+	free(dl);
+	return (ISC_R_NOMEMORY);
+}
+
 /*
  * See if a zone transfer is allowed
  */
@@ -24,6 +24,7 @@ dlz_dlopen_create_t dlz_create;
 dlz_dlopen_destroy_t dlz_destroy;
 dlz_dlopen_findzonedb_t dlz_findzonedb;
 dlz_dlopen_lookup_t dlz_lookup;
+dlz_dlopen_lookup_async_t dlz_lookup_async;
 dlz_dlopen_allowzonexfr_t dlz_allowzonexfr;
 dlz_dlopen_allnodes_t dlz_allnodes;
 dlz_dlopen_newversion_t dlz_newversion;
@@ -227,5 +227,33 @@ grep "not.*present" dig.out.ns1.test$n.2 >/dev/null || ret=1
 if [ $ret != 0 ]; then echo_i "failed"; fi
 status=$((status + ret))
 
+newtest "checking a slow DLZ lookup does not hold up other queries"
+$DIG $DIGOPTS +tries=1 +time=10 slow.nil a >dig.out.ns1.test$n.slow 2>&1 &
+slowpid=$!
+sleep 1
+$DIG $DIGOPTS example.nil a >dig.out.ns1.test$n.fast || ret=1
+wait $slowpid || ret=1
+grep "status: NOERROR" dig.out.ns1.test$n.fast >/dev/null || ret=1
+grep "^example.nil.*A.*10.53.0.1" dig.out.ns1.test$n.fast >/dev/null || ret=1
+fasttime=$(sed -n 's/^;; Query time: \([0-9]*\) msec$/\1/p' dig.out.ns1.test$n.fast)
+[ "${fasttime:-1000}" -lt 1000 ] || ret=1
+grep "status: NOERROR" dig.out.ns1.test$n.slow >/dev/null || ret=1
+grep "^slow.nil.*A.*10.53.0.1" dig.out.ns1.test$n.slow >/dev/null || ret=1
+slowtime=$(sed -n 's/^;; Query time: \([0-9]*\) msec$/\1/p' dig.out.ns1.test$n.slow)
+[ "${slowtime:-0}" -ge 2000 ] || ret=1
+grep "lookup for @ deferred" ns1/named.run >/dev/null || ret=1
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
+newtest "checking a slow DLZ lookup several labels below the apex"
+$DIG $DIGOPTS +tries=1 +time=30 x.y.z.slow.nil a >dig.out.ns1.test$n 2>&1 || ret=1
+grep "status: NXDOMAIN" dig.out.ns1.test$n >/dev/null || ret=1
+grep -o "lookup for [^ ]*z deferred" ns1/named.run >deferred.test$n
+grep "lookup for x.y.z deferred" deferred.test$n >/dev/null || ret=1
+# every name is only looked up once per query
+[ -z "$(sort deferred.test$n | uniq -d)" ] || ret=1
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
 echo_i "exit status: $status"
 [ $status -eq 0 ] || exit 1
@@ -193,6 +193,26 @@ n=$((n + 1))
 test "$ret" -eq 0 || echo_i "failed"
 status=$((status + ret))
 
+echo_i "checking that the chain of trust is prefetched in parallel ($n)"
+ret=0
+rndccmd 10.53.0.4 flush 2>&1 | sed 's/^/ns4 /' | cat_i
+nextpart ns4/named.run >/dev/null
+dig_with_opts +noauth a.secure.nsec3.example. @10.53.0.4 a >dig.out.ns4.test$n || ret=1
+grep "status: NOERROR" dig.out.ns4.test$n >/dev/null || ret=1
+grep "flags:.*ad.*QUERY" dig.out.ns4.test$n >/dev/null || ret=1
+nextpart ns4/named.run | grep "prefetch_chain: creating fetch for nsec3.example DNSKEY" >/dev/null || ret=1
+rm -f ns4/named.stats
+rndccmd 10.53.0.4 stats 2>&1 | sed 's/^/ns4 /' | cat_i
+for try in 1 2 3 4 5; do
+  [ -f ns4/named.stats ] && break
+  sleep 1
+done
+prefetches=$(grep 'DNSSEC chain of trust prefetches' ns4/named.stats | sed 's/ *\([0-9][0-9]*\) DNSSEC.*/\1/')
+[ "${prefetches:-0}" -gt 0 ] || ret=1
+n=$((n + 1))
+test "$ret" -eq 0 || echo_i "failed"
+status=$((status + ret))
+
 if [ -x "${DELV}" ]; then
   ret=0
   echo_i "checking positive validation NSEC using dns_client ($n)"
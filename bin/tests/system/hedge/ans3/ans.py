@@ -0,0 +1,129 @@
+# Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+#
+# SPDX-License-Identifier: MPL-2.0
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0.  If a copy of the MPL was not distributed with this
+# file, you can obtain one at https://mozilla.org/MPL/2.0/.
+#
+# See the COPYRIGHT file distributed with this work for additional
+# information regarding copyright ownership.
+
+
+from __future__ import print_function
+import os
+import sys
+import signal
+import socket
+import select
+import time
+
+import dns, dns.message, dns.flags
+from dns.rdatatype import *
+from dns.rdataclass import *
+from dns.rcode import *
+from dns.name import *
+
+
+############################################################################
+# Respond to a DNS query.
+# Serves example. together with the other ans server, answering
+# every A query below it with 192.0.2.1 after a delay of 300
+# milliseconds, long enough for the resolver to hedge the query to the
+# other server.  Name server addresses are answered without a delay.
+############################################################################
+def create_response(msg):
+    m = dns.message.from_wire(msg)
+    qname = m.question[0].name.to_text()
+    rrtype = m.question[0].rdtype
+    typename = dns.rdatatype.to_text(rrtype)
+
+    with open("query.log", "a") as f:
+        f.write("%s %s\n" % (typename, qname))
+        print("%s %s" % (typename, qname), end=" ")
+
+    r = dns.message.make_response(m)
+    r.set_rcode(NOERROR)
+    r.flags |= dns.flags.AA
+
+    if qname == "example." and rrtype == NS:
+        r.answer.append(
+            dns.rrset.from_text(qname, 300, IN, NS, "a.ns.example.", "b.ns.example.")
+        )
+    elif qname == "a.ns.example." and rrtype == A:
+        r.answer.append(dns.rrset.from_text(qname, 300, IN, A, "10.53.0.2"))
+    elif qname == "b.ns.example." and rrtype == A:
+        r.answer.append(dns.rrset.from_text(qname, 300, IN, A, "10.53.0.3"))
+    elif qname.endswith(".example.") and rrtype == A:
+        r.answer.append(dns.rrset.from_text(qname, 300, IN, A, "192.0.2.1"))
+        time.sleep(0.3)
+    else:
+        r.authority.append(
+            dns.rrset.from_text(
+                "example.", 300, IN, SOA, "a.ns.example. . 1 3600 600 86400 300"
+            )
+        )
+
+    return r
+
+
+def sigterm(signum, frame):
+    print("Shutting down now...")
+    os.remove("ans.pid")
+    running = False
+    sys.exit(0)
+
+
+############################################################################
+# Main
+#
+# Set up responder, open the pid file, and start the main loop,
+# listening for queries and answering them.
+############################################################################
+ip4 = "10.53.0.3"
+
+try:
+    port = int(os.environ["PORT"])
+except:
+    port = 5300
+
+query4_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+query4_socket.bind((ip4, port))
+
+signal.signal(signal.SIGTERM, sigterm)
+
+f = open("ans.pid", "w")
+pid = os.getpid()
+print(pid, file=f)
+f.close()
+
+running = True
+
+print("Listening on %s port %d" % (ip4, port))
+print("Ctrl-c to quit")
+
+input = [query4_socket]
+
+while running:
+    try:
+        inputready, outputready, exceptready = select.select(input, [], [])
+    except select.error as e:
+        break
+    except socket.error as e:
+        break
+    except KeyboardInterrupt:
+        break
+
+    for s in inputready:
+        if s == query4_socket:
+            print("Query received on %s" % ip4, end=" ")
+            # Handle incoming queries
+            msg = s.recvfrom(65535)
+            rsp = create_response(msg[0])
+            if rsp:
+                print(dns.rcode.to_text(rsp.rcode()))
+                s.sendto(rsp.to_wire(), msg[1])
+            else:
+                print("NO RESPONSE")
+    if not running:
+        break
@@ -0,0 +1,53 @@
+#!/bin/sh
+
+# Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+#
+# SPDX-License-Identifier: MPL-2.0
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0.  If a copy of the MPL was not distributed with this
+# file, you can obtain one at https://mozilla.org/MPL/2.0/.
+#
+# See the COPYRIGHT file distributed with this work for additional
+# information regarding copyright ownership.
+
+set -e
+
+. ../conf.sh
+
+DIGOPTS="-p ${PORT} +tries=1 +time=5"
+RNDCCMD="$RNDC -c ../_common/rndc.conf -p ${CONTROLPORT} -s"
+
+status=0
+n=0
+
+n=$((n + 1))
+echo_i "checking that a slow answer is hedged to the other server ($n)"
+ret=0
+$DIG $DIGOPTS @10.53.0.4 a.example A >dig.out.$n || ret=1
+grep "status: NOERROR" dig.out.$n >/dev/null || ret=1
+grep "^a\.example\..*A.*192\.0\.2\.1" dig.out.$n >/dev/null || ret=1
+# both servers got the query
+grep "^A a\.example\.$" ans2/query.log >/dev/null || ret=1
+grep "^A a\.example\.$" ans3/query.log >/dev/null || ret=1
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
+n=$((n + 1))
+echo_i "checking the hedged query statistics ($n)"
+ret=0
+rm -f ns4/named.stats
+$RNDCCMD 10.53.0.4 stats
+for try in 1 2 3 4 5; do
+  [ -f ns4/named.stats ] && break
+  sleep 1
+done
+sent=$(sed -n 's/^ *\([0-9][0-9]*\) hedged queries sent$/\1/p' ns4/named.stats)
+[ -n "$sent" ] || ret=1
+[ "${sent:-0}" -ge 1 ] || ret=1
+echo_i "$sent hedged queries sent"
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
+echo_i "exit status: $status"
+[ $status -eq 0 ] || exit 1
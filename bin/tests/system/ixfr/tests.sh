@@ -337,6 +337,22 @@ nextpart ns4/named.run | grep "IXFR delta size (306 bytes)" >/dev/null || ret=1
 if [ $ret != 0 ]; then echo_i "failed"; fi
 status=$((status + ret))
 
+n=$((n + 1))
+echo_i "check concurrent IXFRs share the mapped journal ($n)"
+ret=0
+# The previous IXFR mapped the journal, which has not changed since.
+grep "mytest.db.jnl: mapped [0-9]* transactions" ns4/named.run >/dev/null || ret=1
+for i in 1 2 3 4; do
+  $DIG $DIGOPTS ixfr=1 test @10.53.0.4 >dig.out$i.test$n &
+done
+wait
+for i in 1 2 3 4; do
+  awk '$4 == "SOA" { soacnt++} END { if (soacnt == 6) exit(0); else exit(1);}' dig.out$i.test$n || ret=1
+done
+nextpart ns4/named.run | grep "mytest.db.jnl: mapped" >/dev/null && ret=1
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
 # make sure ns5 has transfered the zone
 # wait for secondary to reload
 tret=0
@@ -23,12 +23,14 @@ rm -f */named.run.prev
 rm -f Kxxx.*
 rm -f check.out.*
 rm -f dig.out.*
+rm -f journalprint.out.*
 rm -f jp.out.ns3.*
 rm -f keygen.out.*
 rm -f nextpart.out.*
 rm -f ns*/managed-keys.bind* ns*/*.mkeys*
 rm -f ns1/example.db ns1/unixtime.db ns1/yyyymmddvv.db ns1/update.db ns1/other.db ns1/keytests.db
 rm -f ns1/many.test.db
+rm -f ns1/group.test.db
 rm -f ns1/maxjournal.db
 rm -f ns1/md5.key ns1/sha1.key ns1/sha224.key ns1/sha256.key ns1/sha384.key
 rm -f ns1/legacy157.key ns1/legacy161.key ns1/legacy162.key ns1/legacy163.key ns1/legacy164.key ns1/legacy165.key
@@ -67,6 +69,7 @@ rm -f ns9/example.com.db
 rm -f ns9/in-addr.db
 rm -f perl.update_test.out
 rm -f nsupdate.alg-*
+rm -f nsupdate.failed-*
 rm -f nsupdate.out*
 rm -f typelist.out.*
 rm -f update.out.*
@@ -108,6 +108,7 @@ echo 'key "legacy-165" { algorithm "hmac-sha512"; secret "OgZrTcEa8P76hVY+xyN7Wg
 )
 
 cp -f ns1/many.test.db.in ns1/many.test.db
+cp -f ns1/many.test.db.in ns1/group.test.db
 
 cp ns1/sample.db.in ns1/sample.db
 cp ns2/sample.db.in ns2/sample.db
@@ -1339,6 +1339,45 @@ EOF
   }
 fi
 
+n=$((n + 1))
+echo_i "check updates are committed together with update-commit-window ($n)"
+ret=0
+for i in 0 1 2 3 4 5 6 7; do
+  $NSUPDATE <<EOF >nsupdate.out-$n-$i 2>&1 &
+server 10.53.0.1 ${PORT}
+zone group.test
+update add $i.group.test 300 IN A 10.0.0.$i
+send
+EOF
+done
+# only one of the updates for the same name satisfies its prerequisite
+for i in 0 1; do
+  $NSUPDATE <<EOF >nsupdate.out-$n-prereq$i 2>&1 &
+server 10.53.0.1 ${PORT}
+zone group.test
+prereq nxdomain once.group.test
+update add once.group.test 300 IN A 10.0.1.$i
+send
+EOF
+done
+wait
+grep -l "update failed: YXDOMAIN" nsupdate.out-$n-prereq* >nsupdate.failed-$n
+test "$(wc -l <nsupdate.failed-$n)" -eq 1 || ret=1
+$DIG $DIGOPTS +tcp axfr group.test @10.53.0.1 >dig.out.ns1.test$n || ret=1
+lines=$(awk '$4 == "A" { l++ } END { print l }' dig.out.ns1.test$n)
+test "${lines:-0}" -eq 9 || ret=1
+# every successful update incremented the serial...
+$DIG $DIGOPTS +short group.test soa @10.53.0.1 >dig.out.soa.test$n || ret=1
+test "$(awk '{ print $3 }' dig.out.soa.test$n)" -eq 10 || ret=1
+# ...but they were written to the journal in fewer transactions
+$JOURNALPRINT ns1/group.test.db.jnl >journalprint.out.test$n || ret=1
+transactions=$(awk '$1 == "del" && $5 == "SOA" { t++ } END { print t + 0 }' journalprint.out.test$n)
+test "$transactions" -ge 1 -a "$transactions" -lt 9 || ret=1
+[ $ret = 0 ] || {
+  echo_i "failed"
+  status=1
+}
+
 n=$((n + 1))
 echo_i "check max-journal-size limits ($n)"
 ret=0
@@ -43,6 +43,7 @@ def endswith(domain, labels):
 # zoop.boing.good. NS ns3.good.
 # ns3.good. IN A 10.53.0.3
 # too.many.labels.a.b.c.d.e.f.g.h.i.j.k.l.m.n.o.p.q.r.s.t.u.v.w.x.y.z.good. A 192.0.2.2
+# *.y.nocut.good. A 192.0.2.3 (authoritative, with a TTL of 30 seconds)
 # it responds properly (with NODATA empty response) to non-empty terminals
 #
 # For slow. it works the same as for good., but each response is delayed by 400 milliseconds
@@ -281,6 +282,23 @@ def create_response(msg):
             dns.rrset.from_text("ns4." + suffix, 30, IN, AAAA, "fd92:7065:b8e:ffff::4")
         )
         r.flags |= dns.flags.AA
+    elif lqname in ("nocut.", "y.nocut.") or (
+        endswith(lqname, "y.nocut.") and rrtype != A
+    ):
+        # Authoritative NODATA, with a TTL long enough to be remembered
+        r.authority.append(
+            dns.rrset.from_text(
+                suffix,
+                30,
+                IN,
+                SOA,
+                "ns2." + suffix + " hostmaster.arpa. 2018050100 1 1 1 30",
+            )
+        )
+        r.flags |= dns.flags.AA
+    elif endswith(lqname, "y.nocut."):
+        r.answer.append(dns.rrset.from_text(lqname + suffix, 30, IN, A, "192.0.2.3"))
+        r.flags |= dns.flags.AA
     elif lqname == "a.bit.longer.ns.name." and rrtype == A:
         r.answer.append(
             dns.rrset.from_text("a.bit.longer.ns.name." + suffix, 1, IN, A, "10.53.0.4")
@@ -17,3 +17,4 @@ rm -f */named.run */named.run.prev
 rm -f dig.out.*
 rm -f ans*/query.log*
 rm -f query*.log
+rm -f ns*/named.stats ns*/named.stats.prev
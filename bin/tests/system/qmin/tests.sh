@@ -533,5 +533,35 @@ for ans in ans2 ans3 ans4; do mv -f $ans/query.log query-$ans-$n.log 2>/dev/null
 if [ $ret != 0 ]; then echo_i "failed"; fi
 status=$((status + ret))
 
+n=$((n + 1))
+echo_i "names known not to be zone cuts are not queried again ($n)"
+ret=0
+$CLEANQL
+$RNDCCMD 10.53.0.6 flush
+$DIG $DIGOPTS one.y.nocut.good. @10.53.0.6 >dig.out.test$n.1
+grep "status: NOERROR" dig.out.test$n.1 >/dev/null || ret=1
+grep "one\.y\.nocut\.good\..*IN.*A.*192\.0\.2\.3" dig.out.test$n.1 >/dev/null || ret=1
+sleep 1
+grep "^NS y\.nocut\.good\.$" ans2/query.log >/dev/null || ret=1
+for ans in ans2 ans3 ans4; do mv -f $ans/query.log query-$ans-$n.1.log 2>/dev/null || true; done
+# nocut.good. and y.nocut.good. had no data for NS, and one.y.nocut.good.
+# had an authoritative answer, so none of them is queried for NS again
+$DIG $DIGOPTS two.one.y.nocut.good. @10.53.0.6 >dig.out.test$n.2
+grep "status: NOERROR" dig.out.test$n.2 >/dev/null || ret=1
+grep "two\.one\.y\.nocut\.good\..*IN.*A.*192\.0\.2\.3" dig.out.test$n.2 >/dev/null || ret=1
+sleep 1
+echo "ADDR two.one.y.nocut.good." | diff ans2/query.log - >/dev/null || ret=1
+for ans in ans2 ans3 ans4; do mv -f $ans/query.log query-$ans-$n.2.log 2>/dev/null || true; done
+rm -f ns6/named.stats
+$RNDCCMD 10.53.0.6 stats
+for try in 1 2 3 4 5; do
+  [ -f ns6/named.stats ] && break
+  sleep 1
+done
+skipped=$(sed -n 's/^ *\([0-9][0-9]*\) QNAME minimization steps skipped$/\1/p' ns6/named.stats)
+[ "${skipped:-0}" -ge 1 ] || ret=1
+if [ $ret != 0 ]; then echo_i "failed"; fi
+status=$((status + ret))
+
 echo_i "exit status: $status"
 [ $status -eq 0 ] || exit 1
@@ -126,3 +126,58 @@ def test_traffic(fetch_traffic, **kwargs):
     data = fetch_traffic(statsip, statsport)
 
     check_traffic(data, exp)
+
+
+def latency_count(data, group, name):
+    return data.get(group, {}).get(name, {}).get("count", 0)
+
+
+def test_latency(fetch_latency, **kwargs):
+    statsip = kwargs["statsip"]
+    statsport = kwargs["statsport"]
+    port = kwargs["port"]
+
+    before = fetch_latency(statsip, statsport)
+
+    msg = create_msg("short.example.", "TXT")
+    udp_query(statsip, port, msg)
+    tcp_query(statsip, port, msg)
+
+    after = fetch_latency(statsip, statsport)
+
+    for group, name, delta in [
+        ("transport", "UDP", 1),
+        ("transport", "TCP", 1),
+        ("rcode", "NOERROR", 2),
+        ("source", "authoritative", 2),
+    ]:
+        assert latency_count(after, group, name) >= (
+            latency_count(before, group, name) + delta
+        )
+
+    for group in after.values():
+        for summary in group.values():
+            assert summary["count"] > 0
+            assert summary["p50"] <= summary["p90"] <= summary["p99"]
+            assert summary["p99"] <= summary["p999"]
+
+
+def test_adbrtt(fetch_adbrtt, **kwargs):
+    statsip = kwargs["statsip"]
+    statsport = kwargs["statsport"]
+    port = kwargs["port"]
+    server = kwargs["server"]
+
+    # Every name is new, so each lookup is resolved from the server
+    for i in range(32):
+        msg = create_msg("rtt{}.example.".format(i), "A")
+        ans = dns.query.udp(msg, statsip, TIMEOUT, port=port)
+        assert ans.rcode() == dns.rcode.NXDOMAIN
+
+    servers = fetch_adbrtt(statsip, statsport)
+
+    address = "{}#{}".format(server, port)
+    assert address in servers
+    rtt = servers[address]
+    assert rtt["samples"] >= 32
+    assert rtt["p50"] <= rtt["p95"] <= rtt["p99"]
@@ -41,7 +41,33 @@ def fetch_traffic_json(statsip, statsport):
 
     data = r.json()
 
-    return data["traffic"]
+    traffic = data["traffic"]
+    traffic.pop("latency", None)
+
+    return traffic
+
+
+def fetch_latency_json(statsip, statsport):
+    r = requests.get(
+        "http://{}:{}/json/v1/traffic".format(statsip, statsport), timeout=600
+    )
+    assert r.status_code == 200
+
+    data = r.json()
+
+    return data["traffic"].get("latency", {})
+
+
+def fetch_adbrtt_json(statsip, statsport):
+    r = requests.get(
+        "http://{}:{}/json/v1/server".format(statsip, statsport), timeout=600
+    )
+    assert r.status_code == 200
+
+    data = r.json()
+
+    servers = data["views"]["_default"]["resolver"]["adbrtt"]
+    return {server["address"]: server for server in servers}
 
 
 def load_timers_json(zone, primary=True):
@@ -103,3 +129,21 @@ def test_traffic_json(named_port, statsport):
     generic_dnspython.test_traffic(
         fetch_traffic_json, statsip="10.53.0.2", statsport=statsport, port=named_port
     )
+
+
+def test_latency_json(named_port, statsport):
+    generic_dnspython = pytest.importorskip("generic_dnspython")
+    generic_dnspython.test_latency(
+        fetch_latency_json, statsip="10.53.0.2", statsport=statsport, port=named_port
+    )
+
+
+def test_adbrtt_json(named_port, statsport):
+    generic_dnspython = pytest.importorskip("generic_dnspython")
+    generic_dnspython.test_adbrtt(
+        fetch_adbrtt_json,
+        statsip="10.53.0.4",
+        statsport=statsport,
+        port=named_port,
+        server="10.53.0.1",
+    )
@@ -73,6 +73,48 @@ def fetch_traffic_xml(statsip, statsport):
     return traffic
 
 
+def fetch_latency_xml(statsip, statsport):
+    r = requests.get(
+        "http://{}:{}/xml/v3/traffic".format(statsip, statsport), timeout=600
+    )
+    assert r.status_code == 200
+
+    root = ET.fromstring(r.text)
+
+    latency = {}
+    latency_root = root.find("traffic").find("latency")
+    if latency_root is None:
+        return latency
+
+    for histogram in latency_root.findall("histogram"):
+        group = latency.setdefault(histogram.attrib["group"], {})
+        group[histogram.attrib["name"]] = {
+            child.tag: int(child.text) for child in histogram
+        }
+
+    return latency
+
+
+def fetch_adbrtt_xml(statsip, statsport):
+    r = requests.get(
+        "http://{}:{}/xml/v3/server".format(statsip, statsport), timeout=600
+    )
+    assert r.status_code == 200
+
+    root = ET.fromstring(r.text)
+
+    servers = {}
+    for view in root.find("views").iter("view"):
+        if view.attrib["name"] != "_default":
+            continue
+        for server in view.find("adbrtt").findall("server"):
+            servers[server.find("address").text] = {
+                child.tag: int(child.text) for child in server if child.tag != "address"
+            }
+
+    return servers
+
+
 def load_timers_xml(zone, primary=True):
     name = zone.attrib["name"]
 
@@ -133,3 +175,21 @@ def test_traffic_xml(named_port, statsport):
     generic_dnspython.test_traffic(
         fetch_traffic_xml, statsip="10.53.0.2", statsport=statsport, port=named_port
     )
+
+
+def test_latency_xml(named_port, statsport):
+    generic_dnspython = pytest.importorskip("generic_dnspython")
+    generic_dnspython.test_latency(
+        fetch_latency_xml, statsip="10.53.0.2", statsport=statsport, port=named_port
+    )
+
+
+def test_adbrtt_xml(named_port, statsport):
+    generic_dnspython = pytest.importorskip("generic_dnspython")
+    generic_dnspython.test_adbrtt(
+        fetch_adbrtt_xml,
+        statsip="10.53.0.4",
+        statsport=statsport,
+        port=named_port,
+        server="10.53.0.1",
+    )
@@ -43,8 +43,8 @@ typedef uint32_t     dns_ttl_t;
  * of the interface
  */
 #ifndef DLZ_DLOPEN_VERSION
-#define DLZ_DLOPEN_VERSION 3
-#define DLZ_DLOPEN_AGE	   0
+#define DLZ_DLOPEN_VERSION 4
+#define DLZ_DLOPEN_AGE	   1
 #endif /* ifndef DLZ_DLOPEN_VERSION */
 
 /* return these in flags from dlz_version() */
@@ -64,6 +64,7 @@ typedef uint32_t     dns_ttl_t;
 #define ISC_R_INVALIDFILE    30
 #define ISC_R_UNEXPECTED     34
 #define ISC_R_FILENOTFOUND   38
+#define ISC_R_INPROGRESS     53
 
 /* log levels */
 #define ISC_LOG_INFO	     (-1)
@@ -136,12 +137,13 @@ typedef struct dns_ecs {
 	uint8_t	      scope;
 } dns_ecs_t;
 
-#define DNS_CLIENTINFO_VERSION 3
+#define DNS_CLIENTINFO_VERSION 4
 typedef struct dns_clientinfo {
 	uint16_t  version;
 	void	 *data;
 	void	 *dbversion;
 	dns_ecs_t ecs;
+	void	 *dlzasync;
 } dns_clientinfo_t;
 
 typedef isc_result_t (*dns_clientinfo_sourceip_t)(dns_clientinfo_t *client,
@@ -173,6 +175,13 @@ typedef isc_result_t
 dns_sdlz_putrr_t(dns_sdlzlookup_t *lookup, const char *type, dns_ttl_t ttl,
 		 const char *data);
 
+typedef isc_result_t
+dns_sdlz_putrdata_t(dns_sdlzlookup_t *lookup, uint16_t type, dns_ttl_t ttl,
+		    const unsigned char *rdata, unsigned int length);
+
+typedef void
+dns_sdlz_lookupdone_t(void *arg, isc_result_t result);
+
 typedef isc_result_t
 dns_sdlz_putnamedrr_t(dns_sdlzallnodes_t *allnodes, const char *name,
 		      const char *type, dns_ttl_t ttl, const char *data);
@@ -240,6 +249,25 @@ dlz_lookup(const char *zone, const char *name, void *dbdata,
 	   dns_clientinfo_t *clientinfo);
 #endif /* DLZ_DLOPEN_VERSION */
 
+#if DLZ_DLOPEN_VERSION >= 4
+/*
+ * dlz_lookup_async() is optional.  If supplied, it is called instead
+ * of dlz_lookup() when the query can wait for the answer.  It may
+ * start the lookup in the background and return ISC_R_INPROGRESS; it
+ * must then add the records to 'lookup' and call done(arg, result)
+ * exactly once, from any thread, and for every pending lookup before
+ * dlz_destroy() returns.  'zone', 'name', 'methods' and 'clientinfo'
+ * are only valid until dlz_lookup_async() returns.  Any other result
+ * is the answer, as from dlz_lookup(), and ISC_R_NOTIMPLEMENTED makes
+ * named call dlz_lookup() instead.
+ */
+isc_result_t
+dlz_lookup_async(const char *zone, const char *name, void *dbdata,
+		 dns_sdlzlookup_t *lookup, dns_clientinfomethods_t *methods,
+		 dns_clientinfo_t *clientinfo, dns_sdlz_lookupdone_t *done,
+		 void *arg);
+#endif /* DLZ_DLOPEN_VERSION >= 4 */
+
 /*
  * dlz_authority() is optional if dlz_lookup() supplies
  * authority information (i.e., SOA, NS) for the dns record
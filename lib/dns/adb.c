@@ -82,6 +82,26 @@
 
 #define DNS_ADB_MINADBSIZE (1024U * 1024U) /*%< 1 Megabyte */
 
+/*%
+ * Each entry keeps a small histogram of the round trip times of the
+ * answers received from it.  The buckets are log-linear with two
+ * buckets per power of two, the same as an isc_histo with sigbits 1:
+ * bucket 0 holds everything below ADB_RTT_MINUS, and the rest cover
+ * ADB_RTT_OCTAVES powers of two above it, with the last bucket also
+ * catching anything slower than that.
+ *
+ * Once ADB_RTT_DECAY samples have been collected all the buckets are
+ * halved, so that the histogram follows changes in the server's
+ * behaviour.  No quantiles are reported until the histogram holds at
+ * least ADB_RTT_MINSAMPLES samples.
+ */
+#define ADB_RTT_MINBITS	   10 /*%< 1024 microseconds */
+#define ADB_RTT_MINUS	   (1U << ADB_RTT_MINBITS)
+#define ADB_RTT_OCTAVES	   14
+#define ADB_RTT_BUCKETS	   (1 + 2 * ADB_RTT_OCTAVES)
+#define ADB_RTT_DECAY	   512
+#define ADB_RTT_MINSAMPLES 16
+
 typedef ISC_LIST(dns_adbname_t) dns_adbnamelist_t;
 typedef struct dns_adbnamehook dns_adbnamehook_t;
 typedef ISC_LIST(dns_adbnamehook_t) dns_adbnamehooklist_t;
@@ -222,6 +242,9 @@ struct dns_adbentry {
 
 	atomic_uint flags;
 	atomic_uint srtt;
+	uint16_t rtthist[ADB_RTT_BUCKETS];
+	uint16_t rttsamples;
+	uint64_t rttcount;
 	unsigned int completed;
 	unsigned int timeouts;
 	unsigned char plain;
@@ -352,6 +375,8 @@ dump_entry(FILE *, dns_adb_t *, dns_adbentry_t *, bool, isc_stdtime_t);
 static void
 adjustsrtt(dns_adbaddrinfo_t *addr, unsigned int rtt, unsigned int factor,
 	   isc_stdtime_t now);
+static isc_result_t
+rtthist_quantile(dns_adbentry_t *entry, double fraction, unsigned int *rttp);
 static void
 log_quota(dns_adbentry_t *entry, const char *fmt, ...) ISC_FORMAT_PRINTF(2, 3);
 
@@ -2435,6 +2460,7 @@ dump_entry(FILE *f, dns_adb_t *adb, dns_adbentry_t *entry, bool debug,
 	   isc_stdtime_t now) {
 	char addrbuf[ISC_NETADDR_FORMATSIZE];
 	isc_netaddr_t netaddr;
+	unsigned int p50, p95;
 
 	isc_netaddr_fromsockaddr(&netaddr, &entry->sockaddr);
 	isc_netaddr_format(&netaddr, addrbuf, sizeof(addrbuf));
@@ -2452,6 +2478,10 @@ dump_entry(FILE *f, dns_adb_t *adb, dns_adbentry_t *entry, bool debug,
 	if (entry->udpsize != 0U) {
 		fprintf(f, " [udpsize %u]", entry->udpsize);
 	}
+	if (rtthist_quantile(entry, 0.50, &p50) == ISC_R_SUCCESS) {
+		(void)rtthist_quantile(entry, 0.95, &p95);
+		fprintf(f, " [rtt p50 %u p95 %u]", p50, p95);
+	}
 	if (entry->cookie != NULL) {
 		unsigned int i;
 		fprintf(f, " [cookie=");
@@ -3045,6 +3075,93 @@ dns_adb_agesrtt(dns_adb_t *adb, dns_adbaddrinfo_t *addr, isc_stdtime_t now) {
 	adjustsrtt(addr, 0, DNS_ADB_RTTADJAGE, now);
 }
 
+static unsigned int
+rtt_bucket(unsigned int rtt) {
+	unsigned int bits, octave;
+
+	if (rtt < ADB_RTT_MINUS) {
+		return (0);
+	}
+
+	bits = 31 - __builtin_clz(rtt);
+	octave = bits - ADB_RTT_MINBITS;
+	if (octave >= ADB_RTT_OCTAVES) {
+		return (ADB_RTT_BUCKETS - 1);
+	}
+
+	return (1 + 2 * octave + ((rtt >> (bits - 1)) & 1));
+}
+
+static void
+rtt_bucketrange(unsigned int bucket, uint64_t *minp, uint64_t *maxp) {
+	uint64_t base, half;
+
+	if (bucket == 0) {
+		*minp = 0;
+		*maxp = ADB_RTT_MINUS;
+		return;
+	}
+
+	base = (uint64_t)ADB_RTT_MINUS << ((bucket - 1) / 2);
+	half = base / 2;
+	*minp = base + half * ((bucket - 1) % 2);
+	*maxp = *minp + half;
+}
+
+/*
+ * Add a round trip time to the entry's histogram.
+ *
+ * Requires the entry to be locked.
+ */
+static void
+rtthist_add(dns_adbentry_t *entry, unsigned int rtt) {
+	entry->rtthist[rtt_bucket(rtt)]++;
+	entry->rttcount++;
+
+	if (++entry->rttsamples < ADB_RTT_DECAY) {
+		return;
+	}
+
+	entry->rttsamples = 0;
+	for (size_t i = 0; i < ADB_RTT_BUCKETS; i++) {
+		entry->rtthist[i] /= 2;
+		entry->rttsamples += entry->rtthist[i];
+	}
+}
+
+/*
+ * Estimate the round trip time below which 'fraction' of the samples
+ * in the entry's histogram lie, interpolating linearly inside the
+ * bucket that holds it.
+ *
+ * Requires the entry to be locked.
+ */
+static isc_result_t
+rtthist_quantile(dns_adbentry_t *entry, double fraction, unsigned int *rttp) {
+	uint64_t min, max, rank, count = 0;
+	unsigned int bucket;
+
+	if (entry->rttsamples < ADB_RTT_MINSAMPLES) {
+		return (ISC_R_NOTFOUND);
+	}
+
+	rank = (uint64_t)(fraction * (entry->rttsamples - 1));
+	for (bucket = 0; bucket < ADB_RTT_BUCKETS - 1; bucket++) {
+		if (count + entry->rtthist[bucket] > rank) {
+			break;
+		}
+		count += entry->rtthist[bucket];
+	}
+
+	rtt_bucketrange(bucket, &min, &max);
+	if (entry->rtthist[bucket] != 0) {
+		min += (max - min) * (rank - count) / entry->rtthist[bucket];
+	}
+	*rttp = (unsigned int)min;
+
+	return (ISC_R_SUCCESS);
+}
+
 static void
 adjustsrtt(dns_adbaddrinfo_t *addr, unsigned int rtt, unsigned int factor,
 	   isc_stdtime_t now) {
@@ -3066,11 +3183,102 @@ adjustsrtt(dns_adbaddrinfo_t *addr, unsigned int rtt, unsigned int factor,
 		addr->srtt = new_srtt;
 	}
 
+	/*
+	 * A replacement is the penalty for a query that timed out, not
+	 * a measured round trip time, so it is kept out of the histogram.
+	 */
+	if (factor != DNS_ADB_RTTADJAGE && factor != DNS_ADB_RTTADJREPLACE) {
+		LOCK(&addr->entry->lock);
+		rtthist_add(addr->entry, rtt);
+		UNLOCK(&addr->entry->lock);
+	}
+
 	(void)atomic_compare_exchange_strong(&addr->entry->expires,
 					     &(isc_stdtime_t){ 0 },
 					     now + ADB_ENTRY_WINDOW);
 }
 
+isc_result_t
+dns_adb_rttquantile(dns_adb_t *adb, dns_adbaddrinfo_t *addr, double fraction,
+		    unsigned int *rttp) {
+	REQUIRE(DNS_ADB_VALID(adb));
+	REQUIRE(DNS_ADBADDRINFO_VALID(addr));
+	REQUIRE(fraction >= 0.0 && fraction <= 1.0);
+	REQUIRE(rttp != NULL);
+
+	isc_result_t result;
+	dns_adbentry_t *entry = addr->entry;
+
+	LOCK(&entry->lock);
+	result = rtthist_quantile(entry, fraction, rttp);
+	UNLOCK(&entry->lock);
+
+	return (result);
+}
+
+size_t
+dns_adb_toprtt(dns_adb_t *adb, dns_adbrtt_t *servers, size_t size) {
+	REQUIRE(DNS_ADB_VALID(adb));
+	REQUIRE(servers != NULL || size == 0);
+
+	isc_hashmap_iter_t *it = NULL;
+	isc_result_t result;
+	size_t count = 0;
+
+	if (size == 0) {
+		return (0);
+	}
+
+	RWLOCK(&adb->entries_lock, isc_rwlocktype_read);
+	isc_hashmap_iter_create(adb->entries, &it);
+	for (result = isc_hashmap_iter_first(it); result == ISC_R_SUCCESS;
+	     result = isc_hashmap_iter_next(it))
+	{
+		dns_adbentry_t *entry = NULL;
+		dns_adbrtt_t server;
+		size_t i;
+
+		isc_hashmap_iter_current(it, (void **)&entry);
+
+		LOCK(&entry->lock);
+		if (rtthist_quantile(entry, 0.50, &server.p50) !=
+		    ISC_R_SUCCESS)
+		{
+			UNLOCK(&entry->lock);
+			continue;
+		}
+		(void)rtthist_quantile(entry, 0.95, &server.p95);
+		(void)rtthist_quantile(entry, 0.99, &server.p99);
+		server.sockaddr = entry->sockaddr;
+		server.samples = entry->rttcount;
+		server.srtt = atomic_load(&entry->srtt);
+		UNLOCK(&entry->lock);
+
+		/*
+		 * Keep the servers sorted by the number of samples,
+		 * busiest first, dropping the least busy one when full.
+		 */
+		for (i = count; i > 0; i--) {
+			if (servers[i - 1].samples >= server.samples) {
+				break;
+			}
+			if (i < size) {
+				servers[i] = servers[i - 1];
+			}
+		}
+		if (i < size) {
+			servers[i] = server;
+			if (count < size) {
+				count++;
+			}
+		}
+	}
+	isc_hashmap_iter_destroy(&it);
+	RWUNLOCK(&adb->entries_lock, isc_rwlocktype_read);
+
+	return (count);
+}
+
 void
 dns_adb_changeflags(dns_adb_t *adb, dns_adbaddrinfo_t *addr, unsigned int bits,
 		    unsigned int mask) {
@@ -497,12 +497,11 @@ dns_cache_getstats(dns_cache_t *cache) {
 	return (cache->stats);
 }
 
-void
+bool
 dns_cache_updatestats(dns_cache_t *cache, isc_result_t result) {
+	bool hit;
+
 	REQUIRE(VALID_CACHE(cache));
-	if (cache->stats == NULL) {
-		return;
-	}
 
 	switch (result) {
 	case ISC_R_SUCCESS:
@@ -513,13 +512,19 @@ dns_cache_updatestats(dns_cache_t *cache, isc_result_t result) {
 	case DNS_R_GLUE:
 	case DNS_R_ZONECUT:
 	case DNS_R_COVERINGNSEC:
-		isc_stats_increment(cache->stats,
-				    dns_cachestatscounter_queryhits);
+		hit = true;
 		break;
 	default:
+		hit = false;
+	}
+
+	if (cache->stats != NULL) {
 		isc_stats_increment(cache->stats,
-				    dns_cachestatscounter_querymisses);
+				    hit ? dns_cachestatscounter_queryhits
+					: dns_cachestatscounter_querymisses);
 	}
+
+	return (hit);
 }
 
 /*
@@ -30,6 +30,7 @@ dns_clientinfo_init(dns_clientinfo_t *ci, void *data, void *versionp) {
 	ci->data = data;
 	ci->dbversion = versionp;
 	dns_ecs_init(&ci->ecs);
+	ci->dlzasync = NULL;
 }
 
 void
@@ -40,3 +41,8 @@ dns_clientinfo_setecs(dns_clientinfo_t *ci, dns_ecs_t *ecs) {
 		dns_ecs_init(&ci->ecs);
 	}
 }
+
+void
+dns_clientinfo_setdlzasync(dns_clientinfo_t *ci, dns_sdlzasync_t *async) {
+	ci->dlzasync = async;
+}
@@ -116,6 +116,7 @@ struct dns_dispatch {
 	isc_nmhandle_t *handle; /*%< netmgr handle for TCP connection */
 	isc_sockaddr_t local;	/*%< local address */
 	isc_sockaddr_t peer;	/*%< peer address (TCP) */
+	dns_transport_t *transport; /*%< transport (TCP) */
 
 	dns_dispatchopt_t options;
 	dns_dispatchstate_t state;
@@ -139,6 +140,8 @@ struct dns_dispatch {
 #define DISPATCH_MAGIC	  ISC_MAGIC('D', 'i', 's', 'p')
 #define VALID_DISPATCH(e) ISC_MAGIC_VALID((e), DISPATCH_MAGIC)
 
+#define KEEPALIVE(disp) (((disp)->options & DNS_DISPATCHOPT_KEEPALIVE) != 0)
+
 #define DNS_DISPATCHMGR_MAGIC ISC_MAGIC('D', 'M', 'g', 'r')
 #define VALID_DISPATCHMGR(e)  ISC_MAGIC_VALID((e), DNS_DISPATCHMGR_MAGIC)
 
@@ -167,6 +170,14 @@ ISC_REFCOUNT_DECL(dns_dispentry);
 #define QIDS_INIT_SIZE (1 << 4) /* Must be power of 2 */
 #define QIDS_MIN_SIZE  (1 << 4) /* Must be power of 2 */
 
+/*
+ * The number of queries that dns_dispatch_gettcp() lets share one TCP
+ * connection, and how long an idle DNS_DISPATCHOPT_KEEPALIVE connection
+ * is kept open, in milliseconds.
+ */
+#define TCP_MAX_PIPELINE 64
+#define TCP_IDLE_TIMEOUT 10000
+
 /*
  * Statics.
  */
@@ -191,6 +202,8 @@ udp_dispatch_connect(dns_dispatch_t *disp, dns_dispentry_t *resp);
 static void
 tcp_startrecv(dns_dispatch_t *disp, dns_dispentry_t *resp);
 static void
+tcp_startidle(dns_dispatch_t *disp);
+static void
 tcp_dispatch_getnext(dns_dispatch_t *disp, dns_dispentry_t *resp,
 		     int32_t timeout);
 static void
@@ -787,6 +800,17 @@ tcp_recv(isc_nmhandle_t *handle, isc_result_t result, isc_region_t *region,
 
 	peer = isc_nmhandle_peeraddr(handle);
 
+	if (result == ISC_R_TIMEDOUT && KEEPALIVE(disp) &&
+	    ISC_LIST_EMPTY(disp->active))
+	{
+		/* The idle timeout of a kept-alive connection has expired */
+		dispatch_log(disp, ISC_LOG_DEBUG(90),
+			     "closing idle TCP connection %p", handle);
+		disp->state = DNS_DISPATCHSTATE_CANCELED;
+		dns_dispatch_detach(&disp); /* DISPATCH002 */
+		return;
+	}
+
 	rcu_read_lock();
 	/*
 	 * Phase 1: Process timeout and success.
@@ -819,9 +843,13 @@ tcp_recv(isc_nmhandle_t *handle, isc_result_t result, isc_region_t *region,
 		if (disp->timedout > 0) {
 			/* There was active query that timed-out before */
 			disp->timedout--;
-		} else {
+		} else if (!KEEPALIVE(disp)) {
 			result = ISC_R_UNEXPECTED;
 		}
+		/*
+		 * Queries sharing a kept-alive connection may have been
+		 * canceled before their answer arrived; it is dropped.
+		 */
 	}
 
 	/*
@@ -882,6 +910,10 @@ tcp_recv(isc_nmhandle_t *handle, isc_result_t result, isc_region_t *region,
 		INSIST(timeout > 0);
 		tcp_startrecv(disp, resp);
 		isc_nmhandle_settimeout(handle, timeout);
+	} else if (KEEPALIVE(disp) &&
+		   disp->state == DNS_DISPATCHSTATE_CONNECTED)
+	{
+		tcp_startidle(disp);
 	}
 
 	rcu_read_unlock();
@@ -1124,6 +1156,7 @@ dispatch_allocate(dns_dispatchmgr_t *mgr, isc_socktype_t type, uint32_t tid,
 struct dispatch_key {
 	const isc_sockaddr_t *local;
 	const isc_sockaddr_t *peer;
+	const dns_transport_t *transport;
 };
 
 static uint32_t
@@ -1151,14 +1184,27 @@ dispatch_match(struct cds_lfht_node *node, const void *key0) {
 		peer = disp->peer;
 	}
 
-	return (isc_sockaddr_equal(&peer, key->peer) &&
-		(key->local == NULL || isc_sockaddr_equal(&local, key->local)));
+	if (disp->transport != key->transport ||
+	    !isc_sockaddr_equal(&peer, key->peer))
+	{
+		return (false);
+	}
+
+	/* Without a local port, any port the connection got will do */
+	if (key->local == NULL) {
+		return (true);
+	} else if (isc_sockaddr_getport(key->local) == 0) {
+		return (isc_sockaddr_eqaddr(&local, key->local));
+	} else {
+		return (isc_sockaddr_equal(&local, key->local));
+	}
 }
 
 isc_result_t
 dns_dispatch_createtcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *localaddr,
 		       const isc_sockaddr_t *destaddr,
-		       dns_dispatchopt_t options, dns_dispatch_t **dispp) {
+		       dns_transport_t *transport, dns_dispatchopt_t options,
+		       dns_dispatch_t **dispp) {
 	dns_dispatch_t *disp = NULL;
 	uint32_t tid = isc_tid();
 
@@ -1169,6 +1215,9 @@ dns_dispatch_createtcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *localaddr,
 
 	disp->options = options;
 	disp->peer = *destaddr;
+	if (transport != NULL) {
+		dns_transport_attach(transport, &disp->transport);
+	}
 
 	if (localaddr != NULL) {
 		disp->local = *localaddr;
@@ -1185,6 +1234,7 @@ dns_dispatch_createtcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *localaddr,
 	struct dispatch_key key = {
 		.local = &disp->local,
 		.peer = &disp->peer,
+		.transport = disp->transport,
 	};
 
 	if ((disp->options & DNS_DISPATCHOPT_UNSHARED) == 0) {
@@ -1212,7 +1262,8 @@ dns_dispatch_createtcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *localaddr,
 
 isc_result_t
 dns_dispatch_gettcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *destaddr,
-		    const isc_sockaddr_t *localaddr, dns_dispatch_t **dispp) {
+		    const isc_sockaddr_t *localaddr, dns_transport_t *transport,
+		    dns_dispatch_t **dispp) {
 	dns_dispatch_t *disp_connected = NULL;
 	dns_dispatch_t *disp_fallback = NULL;
 	isc_result_t result = ISC_R_NOTFOUND;
@@ -1225,6 +1276,7 @@ dns_dispatch_gettcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *destaddr,
 	struct dispatch_key key = {
 		.local = localaddr,
 		.peer = destaddr,
+		.transport = transport,
 	};
 
 	rcu_read_lock();
@@ -1236,12 +1288,19 @@ dns_dispatch_gettcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *destaddr,
 		INSIST(disp->tid == isc_tid());
 		INSIST(disp->socktype == isc_socktype_tcp);
 
+		if (disp->requests >= TCP_MAX_PIPELINE) {
+			/* This connection is busy enough, try another one */
+			continue;
+		}
+
 		switch (disp->state) {
 		case DNS_DISPATCHSTATE_NONE:
 			/* A dispatch in indeterminate state, skip it */
 			break;
 		case DNS_DISPATCHSTATE_CONNECTED:
-			if (ISC_LIST_EMPTY(disp->active)) {
+			if (ISC_LIST_EMPTY(disp->active) &&
+			    (!KEEPALIVE(disp) || !disp->reading))
+			{
 				/* Ignore dispatch with no responses */
 				break;
 			}
@@ -1387,6 +1446,9 @@ dispatch_destroy(dns_dispatch_t *disp) {
 			     &disp->handle);
 		isc_nmhandle_detach(&disp->handle);
 	}
+	if (disp->transport != NULL) {
+		dns_transport_detach(&disp->transport);
+	}
 	dns_dispatchmgr_detach(&disp->mgr);
 
 	call_rcu(&disp->rcu_head, dispatch_destroy_rcu);
@@ -1649,40 +1711,22 @@ tcp_dispentry_cancel(dns_dispentry_t *resp, isc_result_t result) {
 		if (ISC_LIST_EMPTY(disp->active)) {
 			INSIST(disp->handle != NULL);
 
-#if DISPATCH_TCP_KEEPALIVE
-			/*
-			 * This is an experimental code that keeps the TCP
-			 * connection open for 1 second before it is finally
-			 * closed.  By keeping the TCP connection open, it can
-			 * be reused by dns_request that uses
-			 * dns_dispatch_gettcp() to join existing TCP
-			 * connections.
-			 *
-			 * It is disabled for now, because it changes the
-			 * behaviour, but I am keeping the code here for future
-			 * reference when we improve the dns_dispatch to reuse
-			 * the TCP connections also in the resolver.
-			 *
-			 * The TCP connection reuse should be seamless and not
-			 * require any extra handling on the client side though.
-			 */
-			isc_nmhandle_cleartimeout(disp->handle);
-			isc_nmhandle_settimeout(disp->handle, 1000);
-
-			if (!disp->reading) {
-				dispentry_log(resp, ISC_LOG_DEBUG(90),
-					      "final 1 second timeout on %p",
-					      disp->handle);
-				tcp_startrecv(disp, NULL);
-			}
-#else
-			if (disp->reading) {
+			if (KEEPALIVE(disp) &&
+			    disp->state == DNS_DISPATCHSTATE_CONNECTED)
+			{
+				/*
+				 * Keep the connection open, so that
+				 * dns_dispatch_gettcp() can find it for the
+				 * next query, until it has been idle for a
+				 * while.
+				 */
+				tcp_startidle(disp);
+			} else if (disp->reading) {
 				dispentry_log(resp, ISC_LOG_DEBUG(90),
 					      "canceling read on %p",
 					      disp->handle);
 				isc_nm_cancelread(disp->handle);
 			}
-#endif
 		}
 		break;
 
@@ -1776,6 +1820,22 @@ tcp_startrecv(dns_dispatch_t *disp, dns_dispentry_t *resp) {
 	disp->reading = true;
 }
 
+static void
+tcp_startidle(dns_dispatch_t *disp) {
+	REQUIRE(disp->state == DNS_DISPATCHSTATE_CONNECTED);
+	REQUIRE(ISC_LIST_EMPTY(disp->active));
+
+	dispatch_log(disp, ISC_LOG_DEBUG(90),
+		     "keeping idle TCP connection %p open for %u ms",
+		     disp->handle, TCP_IDLE_TIMEOUT);
+
+	isc_nmhandle_cleartimeout(disp->handle);
+	isc_nmhandle_settimeout(disp->handle, TCP_IDLE_TIMEOUT);
+	if (!disp->reading) {
+		tcp_startrecv(disp, NULL);
+	}
+}
+
 static void
 tcp_connected(isc_nmhandle_t *handle, isc_result_t eresult, void *arg) {
 	dns_dispatch_t *disp = (dns_dispatch_t *)arg;
@@ -1988,6 +2048,10 @@ tcp_dispatch_connect(dns_dispatch_t *disp, dns_dispentry_t *resp) {
 		resp->start = isc_loop_now(resp->loop);
 
 		/* Add the resp to the reading list */
+		if (ISC_LIST_EMPTY(disp->active) && disp->reading) {
+			/* The idle timeout no longer applies */
+			isc_nmhandle_settimeout(disp->handle, resp->timeout);
+		}
 		ISC_LIST_APPEND(disp->active, resp, alink);
 		dispentry_log(resp, ISC_LOG_DEBUG(90),
 			      "already connected; attaching");
@@ -204,6 +204,19 @@ struct dns_adbaddrinfo {
 	ISC_LINK(dns_adbaddrinfo_t) publink;
 };
 
+/*%
+ * A summary of the round trip times measured for one server, as
+ * returned by dns_adb_toprtt().  All the times are in microseconds.
+ */
+typedef struct dns_adbrtt {
+	isc_sockaddr_t sockaddr;
+	uint64_t       samples; /*%< answers received */
+	unsigned int   srtt;
+	unsigned int   p50;
+	unsigned int   p95;
+	unsigned int   p99;
+} dns_adbrtt_t;
+
 /*!<
  * When the caller recieves a callback from dns_adb_createfind(), the
  * argument will a pointer to the dns_adbfind_t structure, which includes
@@ -450,6 +463,55 @@ dns_adb_adjustsrtt(dns_adb_t *adb, dns_adbaddrinfo_t *addr, unsigned int rtt,
  *	srtt value.  This may include changes made by others.
  */
 
+isc_result_t
+dns_adb_rttquantile(dns_adb_t *adb, dns_adbaddrinfo_t *addr, double fraction,
+		    unsigned int *rttp);
+/*%<
+ * Estimate the round trip time, in microseconds, within which the given
+ * 'fraction' of the recent answers from 'addr' have arrived; e.g. a
+ * 'fraction' of 0.95 gives the 95th percentile.
+ *
+ * The estimate is taken from a histogram of the round trip times passed
+ * to dns_adb_adjustsrtt(), excluding those recorded with the
+ * DNS_ADB_RTTADJREPLACE and DNS_ADB_RTTADJAGE factors.  Older samples
+ * are given progressively less weight.
+ *
+ * Requires:
+ *
+ *\li	adb be valid.
+ *
+ *\li	addr be valid.
+ *
+ *\li	0.0 <= fraction <= 1.0
+ *
+ *\li	rttp != NULL
+ *
+ * Returns:
+ *
+ *\li	ISC_R_SUCCESS
+ *\li	ISC_R_NOTFOUND	-- too few answers have been received from the
+ *			   server for an estimate; '*rttp' is unchanged.
+ */
+
+size_t
+dns_adb_toprtt(dns_adb_t *adb, dns_adbrtt_t *servers, size_t size);
+/*%<
+ * Fill 'servers' with the round trip time summaries of, at most, 'size'
+ * servers that have answered the most queries, busiest first.  Servers
+ * that have answered too few queries for their percentiles to be
+ * estimated are skipped.
+ *
+ * Requires:
+ *
+ *\li	adb be valid.
+ *
+ *\li	servers != NULL, unless size is zero.
+ *
+ * Returns:
+ *
+ *\li	The number of elements of 'servers' that were filled in.
+ */
+
 void
 dns_adb_agesrtt(dns_adb_t *adb, dns_adbaddrinfo_t *addr, isc_stdtime_t now);
 /*
@@ -255,10 +255,11 @@ dns_cache_dumpstats(dns_cache_t *cache, FILE *fp);
  * Dump cache statistics and status in text to 'fp'
  */
 
-void
+bool
 dns_cache_updatestats(dns_cache_t *cache, isc_result_t result);
 /*
- * Update cache statistics based on result code in 'result'
+ * Update cache statistics based on result code in 'result', and
+ * return true if it counts as a cache hit.
  */
 
 #ifdef HAVE_LIBXML2
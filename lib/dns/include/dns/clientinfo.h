@@ -50,7 +50,7 @@ ISC_LANG_BEGINDECLS
 ***** Types
 *****/
 
-#define DNS_CLIENTINFO_VERSION 3
+#define DNS_CLIENTINFO_VERSION 4
 /*
  * Any updates to this structure should also be applied in
  * contrib/modules/dlz/dlz_minmal.h.
@@ -60,6 +60,8 @@ typedef struct dns_clientinfo {
 	void	 *data;
 	void	 *dbversion;
 	dns_ecs_t ecs;
+	/* Private to libdns, not for use by DLZ modules. */
+	dns_sdlzasync_t *dlzasync;
 } dns_clientinfo_t;
 
 typedef isc_result_t (*dns_clientinfo_sourceip_t)(dns_clientinfo_t *client,
@@ -99,4 +101,11 @@ dns_clientinfo_setecs(dns_clientinfo_t *ci, dns_ecs_t *ecs);
  * If 'ecs' is NULL, initialize ci->ecs to 0/0/0; otherwise copy it.
  */
 
+void
+dns_clientinfo_setdlzasync(dns_clientinfo_t *ci, dns_sdlzasync_t *async);
+/*%<
+ * Allow lookups in DLZ databases made with 'ci' to run asynchronously,
+ * using the per-query state 'async' (see dns_sdlz_asynccreate()).
+ */
+
 ISC_LANG_ENDDECLS
@@ -75,6 +75,7 @@ struct dns_dispatchset {
 typedef enum dns_dispatchopt {
 	DNS_DISPATCHOPT_FIXEDID = 1 << 0,
 	DNS_DISPATCHOPT_UNSHARED = 1 << 1, /* Don't share this connection */
+	DNS_DISPATCHOPT_KEEPALIVE = 1 << 2, /* Keep it open while idle */
 } dns_dispatchopt_t;
 
 isc_result_t
@@ -185,9 +186,17 @@ dns_dispatch_createudp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *localaddr,
 isc_result_t
 dns_dispatch_createtcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *localaddr,
 		       const isc_sockaddr_t *destaddr,
-		       dns_dispatchopt_t options, dns_dispatch_t **dispp);
+		       dns_transport_t *transport, dns_dispatchopt_t options,
+		       dns_dispatch_t **dispp);
 /*%<
- * Create a new TCP dns_dispatch.
+ * Create a new TCP dns_dispatch to 'destaddr', which will use
+ * 'transport' (plain TCP if NULL).
+ *
+ * Unless DNS_DISPATCHOPT_UNSHARED is set in 'options', the dispatch can
+ * be found by dns_dispatch_gettcp() and shared by several queries,
+ * which are pipelined over its connection.  With
+ * DNS_DISPATCHOPT_KEEPALIVE, the connection is kept open for a while
+ * when no query is using it, so that it can be reused.
  *
  * Requires:
  *
@@ -255,9 +264,12 @@ dns_dispatch_resume(dns_dispentry_t *resp, uint16_t timeout);
 
 isc_result_t
 dns_dispatch_gettcp(dns_dispatchmgr_t *mgr, const isc_sockaddr_t *destaddr,
-		    const isc_sockaddr_t *localaddr, dns_dispatch_t **dispp);
+		    const isc_sockaddr_t *localaddr, dns_transport_t *transport,
+		    dns_dispatch_t **dispp);
 /*
- * Attempt to connect to a existing TCP connection.
+ * Attempt to connect to a existing TCP connection to 'destaddr' using
+ * 'transport', which is not yet carrying too many queries.  If
+ * 'localaddr' has no port, any local port matches.
  */
 
 typedef void (*dispatch_cb_t)(isc_result_t eresult, isc_region_t *region,
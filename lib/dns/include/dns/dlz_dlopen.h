@@ -27,8 +27,8 @@ ISC_LANG_BEGINDECLS
  * for the entry points of an external DLZ module for bind9.
  */
 
-#define DLZ_DLOPEN_VERSION 3
-#define DLZ_DLOPEN_AGE	   0
+#define DLZ_DLOPEN_VERSION 4
+#define DLZ_DLOPEN_AGE	   1
 
 /*
  * dlz_dlopen_version() is required for all DLZ external drivers. It
@@ -67,6 +67,18 @@ dlz_dlopen_lookup_t(const char *zone, const char *name, void *dbdata,
 		    dns_sdlzlookup_t *lookup, dns_clientinfomethods_t *methods,
 		    dns_clientinfo_t *clientinfo);
 
+/*
+ * dlz_dlopen_lookup_async() is optional.  It should be supplied if
+ * lookups can take long enough to hold up other queries; see
+ * dns_sdlzlookupasync_t for how it returns its answer.
+ */
+typedef isc_result_t
+dlz_dlopen_lookup_async_t(const char *zone, const char *name, void *dbdata,
+			  dns_sdlzlookup_t *lookup,
+			  dns_clientinfomethods_t *methods,
+			  dns_clientinfo_t *clientinfo,
+			  dns_sdlz_lookupdone_t *done, void *arg);
+
 /*
  * dlz_dlopen_authority is optional() if dlz_dlopen_lookup()
  * supplies authority information for the dns record
@@ -31,6 +31,8 @@
 
 #include <isc/lang.h>
 #include <isc/magic.h>
+#include <isc/refcount.h>
+#include <isc/time.h>
 
 #include <dns/diff.h>
 #include <dns/name.h>
@@ -71,6 +73,18 @@
  */
 typedef struct dns_journal dns_journal_t;
 
+/*%
+ * A dns_journalcompact_t holds the state of a journal compaction between
+ * dns_journal_compact_begin() and dns_journal_compact_finish().
+ */
+typedef struct dns_journalcompact dns_journalcompact_t;
+
+/*%
+ * A dns_loaddiff_t compares the records loaded into a database with those
+ * in an older version of the zone as they are loaded.
+ */
+typedef struct dns_loaddiff dns_loaddiff_t;
+
 /***
  *** Functions
  ***/
@@ -120,6 +134,85 @@ dns_journal_destroy(dns_journal_t **journalp);
  * Destroy a dns_journal_t, closing any open files and freeing its memory.
  */
 
+isc_result_t
+dns_journal_openmap(isc_mem_t *mctx, dns_journalmap_t *map,
+		    dns_journal_t **journalp);
+/*%<
+ * Create a dns_journal_t for reading the journal snapshot 'map'.  The
+ * journal holds a reference to 'map' until it is destroyed, and reads
+ * the transactions that were in the journal file when 'map' was created,
+ * even if the file has been changed or removed since.
+ *
+ * Requires:
+ *\li	'map' is a valid journal map.
+ *\li	'journalp' is not NULL and '*journalp' is NULL.
+ */
+
+/**************************************************************************/
+/*
+ * Journal maps.  A dns_journalmap_t is a read-only snapshot of a journal
+ * file mapped into memory, together with an index of the position of
+ * every transaction in it.  It is reference counted, and any number of
+ * journals opened with dns_journal_openmap() can read it at once.
+ */
+
+isc_result_t
+dns_journalmap_create(isc_mem_t *mctx, const char *filename,
+		      const dns_journalmap_t *prev, dns_journalmap_t **mapp);
+/*%<
+ * Map the journal file 'filename' into memory and index its transactions.
+ *
+ * If 'prev' is not NULL, it should be an earlier map of the same journal;
+ * if the file has only had transactions appended since, the positions of
+ * the transactions already indexed in 'prev' are reused.
+ *
+ * Requires:
+ *\li	'filename' is not NULL.
+ *\li	'prev' is NULL or a valid journal map.
+ *\li	'mapp' is not NULL and '*mapp' is NULL.
+ *
+ * Returns:
+ *\li	ISC_R_SUCCESS
+ *\li	ISC_R_NOTFOUND		the journal file does not exist
+ *\li	ISC_R_NOTIMPLEMENTED	the journal is in an old format that has
+ *				to be read with dns_journal_open()
+ *\li	ISC_R_UNEXPECTED	the journal file is corrupt or could not be
+ *				mapped
+ */
+
+bool
+dns_journalmap_current(dns_journalmap_t *map);
+/*%<
+ * Return true if the journal file 'map' was created from has not been
+ * replaced and has not had any transactions added since.
+ *
+ * Requires:
+ *\li	'map' is a valid journal map.
+ */
+
+const char *
+dns_journalmap_filename(dns_journalmap_t *map);
+/*%<
+ * Return the name of the journal file 'map' was created from.
+ *
+ * Requires:
+ *\li	'map' is a valid journal map.
+ */
+
+#if DNS_JOURNALMAP_TRACE
+#define dns_journalmap_ref(ptr) \
+	dns_journalmap__ref(ptr, __func__, __FILE__, __LINE__)
+#define dns_journalmap_unref(ptr) \
+	dns_journalmap__unref(ptr, __func__, __FILE__, __LINE__)
+#define dns_journalmap_attach(ptr, ptrp) \
+	dns_journalmap__attach(ptr, ptrp, __func__, __FILE__, __LINE__)
+#define dns_journalmap_detach(ptrp) \
+	dns_journalmap__detach(ptrp, __func__, __FILE__, __LINE__)
+ISC_REFCOUNT_TRACE_DECL(dns_journalmap);
+#else
+ISC_REFCOUNT_DECL(dns_journalmap);
+#endif
+
 /**************************************************************************/
 /*
  * Writing transactions to journals.
@@ -299,6 +392,62 @@ dns_db_diffx(dns_diff_t *diff, dns_db_t *dba, dns_dbversion_t *dbvera,
  * non-NULL.
  */
 
+isc_result_t
+dns_loaddiff_create(isc_mem_t *mctx, dns_db_t *db, dns_db_t *loaddb,
+		    dns_loaddiff_t **ldp);
+/*%<
+ * Prepare to generate the diff between the current version of 'db' and
+ * the zone that is about to be loaded into 'loaddb', comparing the
+ * records at each name with those in 'db' as they are loaded.  When the
+ * names are loaded in DNSSEC order, as in the files written by named,
+ * the cost of generating the diff once the load has finished depends on
+ * the number of names that have changed rather than the size of the
+ * zone.
+ *
+ * Requires:
+ *\li	'db' and 'loaddb' are valid databases.
+ *\li	'ldp' is not NULL and '*ldp' is NULL.
+ */
+
+void
+dns_loaddiff_callbacks(dns_loaddiff_t *ld,
+		       const dns_rdatacallbacks_t *dbcallbacks,
+		       dns_rdatacallbacks_t *callbacks);
+/*%<
+ * Initialize 'callbacks' for loading the zone, as a copy of the
+ * 'dbcallbacks' set up by dns_db_beginload() that passes each rdataset
+ * loaded through 'ld'.  'dbcallbacks' must still be passed to
+ * dns_db_endload().
+ */
+
+bool
+dns_loaddiff_current(dns_loaddiff_t *ld, dns_db_t *db, dns_db_t *loaddb);
+/*%<
+ * Return true if 'ld' compares 'loaddb' with the current version of 'db'.
+ */
+
+isc_result_t
+dns_loaddiff_diff(dns_loaddiff_t **ldp, dns_diff_t *diff, dns_db_t *db,
+		  dns_dbversion_t *ver, const char *journal_filename);
+/*%<
+ * Generate the diff containing the changes to make version 'ver' of the
+ * loaded database 'db' from the older version of the zone, as
+ * dns_db_diffx() would, and destroy '*ldp'.  If the records compared
+ * while the zone was loaded do not account for all the changes, the
+ * databases are compared in full.
+ *
+ * Requires:
+ *\li	'ldp' is not NULL and '*ldp' is valid.
+ *\li	'db' is the database passed as 'loaddb' to dns_loaddiff_create(),
+ *	and the load has finished.
+ */
+
+void
+dns_loaddiff_destroy(dns_loaddiff_t **ldp);
+/*%<
+ * Destroy '*ldp' without generating the diff.
+ */
+
 isc_result_t
 dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
 		    uint32_t flags, uint32_t target_size);
@@ -324,6 +473,51 @@ dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
  * Other errors may be returned from file operations.
  */
 
+isc_result_t
+dns_journal_compact_begin(isc_mem_t *mctx, const char *filename,
+			  uint32_t serial, uint32_t target_size,
+			  dns_journalcompact_t **jcp);
+isc_result_t
+dns_journal_compact_finish(dns_journalcompact_t **jcp,
+			   isc_nanosecs_t *elapsedp);
+void
+dns_journal_compact_cancel(dns_journalcompact_t **jcp);
+/*%<
+ * Compact the journal 'filename' in two steps, as dns_journal_compact()
+ * would, so that the bulk of the work can be done while the journal is
+ * still in use.
+ *
+ * dns_journal_compact_begin() copies the transactions to be kept into a
+ * new journal, as far as the end of the journal when it is called, and
+ * returns a compaction context in '*jcp'.  It does not modify the journal,
+ * and transactions may be added to it while it runs.  If the journal does
+ * not need compacting, ISC_R_SUCCESS is returned and '*jcp' is left NULL.
+ *
+ * dns_journal_compact_finish() copies any transactions that were added in
+ * the meantime, and replaces the journal with the new one.  No other
+ * transactions may be added to the journal while it runs.  If 'elapsedp'
+ * is not NULL, the time since dns_journal_compact_begin() was called is
+ * returned in it.
+ *
+ * dns_journal_compact_cancel() discards the new journal.
+ *
+ * Requires:
+ *\li	'filename' is not NULL.
+ *\li	'jcp' is not NULL; '*jcp' is NULL for dns_journal_compact_begin()
+ *	and a valid compaction context otherwise.
+ *
+ * Returns:
+ *\li	ISC_R_SUCCESS
+ *\li	ISC_R_RANGE		'serial' is outside the range existing in
+ *				the journal
+ *\li	ISC_R_NOTIMPLEMENTED	the journal must be repaired, which only
+ *				dns_journal_compact() does
+ *\li	ISC_R_CANCELED		(finish) the journal was replaced after
+ *				the compaction began
+ *
+ * Other errors may be returned from file operations.
+ */
+
 bool
 dns_journal_get_sourceserial(dns_journal_t *j, uint32_t *sourceserial);
 void
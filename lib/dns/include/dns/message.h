@@ -223,6 +223,10 @@ typedef enum dns_message_intent {
 #define DNS_MESSAGEPARSE_IGNORETRUNCATION \
 	0x0008 /*%< truncation errors are \
 		* not fatal. */
+#define DNS_MESSAGEPARSE_LAZY           \
+	0x0010 /*%< defer building the \
+		* sections of a query  \
+		* until used */
 
 /*
  * Control behavior of rendering
@@ -289,6 +293,7 @@ struct dns_message {
 	unsigned int	     rdclass_set      : 1; /* 14 */
 	unsigned int	     fuzzing	      : 1; /* 15 */
 	unsigned int	     free_pools	      : 1; /* 16 */
+	unsigned int	     lazy_pending     : 1; /* 17 */
 	unsigned int			      : 0;
 
 	unsigned int opt_reserved;
@@ -331,6 +336,9 @@ struct dns_message {
 	dns_rcode_t  sig0status;
 	isc_region_t query;
 	isc_region_t saved;
+	unsigned int lazy_offset;     /* start of deferred sections in saved */
+	unsigned int lazy_additional; /* deferred additional records */
+	unsigned int lazy_options;    /* parse options for deferred sections */
 
 	/*
 	 * Time to be used when fuzzing.
@@ -559,6 +567,22 @@ dns_message_parse(dns_message_t *msg, isc_buffer_t *source,
  * If #DNS_MESSAGEPARSE_IGNORETRUNCATION is set then return as many complete
  * RR's as possible, DNS_R_RECOVERABLE will be returned.
  *
+ * If #DNS_MESSAGEPARSE_LAZY is set and the message is a QUERY, the
+ * answer, authority and additional sections are only checked for
+ * correct framing (owner names, fixed fields and rdata lengths) during
+ * the parse, without decompressing any names.  The OPT, TSIG and SIG(0)
+ * records at the end of the additional section are parsed as usual;
+ * the names and rdatasets for the other records are built the first
+ * time any section is accessed with dns_message_firstname(),
+ * dns_message_findname() or dns_message_sectiontotext().  Errors in
+ * the owner names and rdata of deferred records are reported at that
+ * point instead.
+ * Unless #DNS_MESSAGEPARSE_CLONEBUFFER is also set, 'source' must
+ * remain valid until the message is replied to, reset or destroyed,
+ * or dns_message_clonebuffer() is called.  The option is ignored when
+ * #DNS_MESSAGEPARSE_BESTEFFORT or #DNS_MESSAGEPARSE_IGNORETRUNCATION
+ * is set.
+ *
  * OPT and TSIG records are always handled specially, regardless of the
  * 'preserve_order' setting.
  *
@@ -758,6 +782,8 @@ dns_message_firstname(dns_message_t *msg, dns_section_t section);
  * Returns:
  *\li	#ISC_R_SUCCESS		-- All is well.
  *\li	#ISC_R_NOMORE		-- No names on given section.
+ *\li	Any error from building sections deferred by
+ *	#DNS_MESSAGEPARSE_LAZY.
  */
 
 isc_result_t
@@ -93,6 +93,48 @@ dns_nsec3_hashname(dns_fixedname_t *result,
  * the raw hash is stored there.
  */
 
+void
+dns_nsec3cache_create(isc_mem_t *mctx, unsigned int size,
+		      dns_nsec3cache_t **cachep);
+/*%<
+ * Create a bounded cache of NSEC3 owner name hashes holding at most
+ * 'size' entries.
+ *
+ * Authoritative servers hash the query name, the closest encloser and
+ * the wildcard name for every negative answer from a NSEC3-signed zone.
+ * The closest encloser and wildcard names are the same for most
+ * queries, so caching their hashes avoids the iterated hashing.
+ * The cached hashes only depend on the name and the NSEC3 parameters,
+ * so entries stay valid across zone versions; entries computed with
+ * different NSEC3 parameters are simply treated as misses.
+ *
+ * Requires:
+ *\li	'mctx' is a valid memory context.
+ *\li	'size' is greater than zero.
+ *\li	'cachep' is not NULL and '*cachep' is NULL.
+ */
+
+void
+dns_nsec3cache_destroy(dns_nsec3cache_t **cachep);
+/*%<
+ * Destroy the NSEC3 hash cache pointed to by '*cachep'.
+ */
+
+isc_result_t
+dns_nsec3cache_hashname(dns_nsec3cache_t *cache, dns_fixedname_t *result,
+			const dns_name_t *name, const dns_name_t *origin,
+			dns_hash_t hashalg, unsigned int iterations,
+			const unsigned char *salt, size_t saltlength,
+			bool *hitp);
+/*%<
+ * Like dns_nsec3_hashname(), but consult 'cache' first and remember
+ * the computed hash.  If 'hitp' is not NULL, '*hitp' is set to true
+ * when the hash was found in the cache.
+ *
+ * Requires:
+ *\li	'cache' is a valid NSEC3 hash cache.
+ */
+
 unsigned int
 dns_nsec3_hashlength(dns_hash_t hash);
 /*%<
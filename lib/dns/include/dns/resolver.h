@@ -131,6 +131,8 @@ enum {
 	DNS_FETCHOPT_NOFORWARD = 1 << 15,      /*%< Do not use forwarders if
 						* possible. */
 	DNS_FETCHOPT_TRYSTALE_ONTIMEOUT = 1 << 16,
+	DNS_FETCHOPT_QMINFETCH = 1 << 17,      /*%< A QNAME minimization
+						* step of another fetch. */
 
 	/*% EDNS version bits: */
 	DNS_FETCHOPT_EDNSVERSIONSET = 1 << 23,
@@ -535,6 +537,23 @@ dns_resolver_setretryinterval(dns_resolver_t *resolver, unsigned int interval);
  * \li  interval > 0.
  */
 
+unsigned int
+dns_resolver_gethedgeratio(dns_resolver_t *resolver);
+
+void
+dns_resolver_sethedgeratio(dns_resolver_t *resolver, unsigned int percent);
+/*%<
+ * Sets the number of hedged queries the resolver may send, as a
+ * percentage of the other queries it sends.  A query is hedged by
+ * sending it to the next best server as well when the first server
+ * hasn't answered within twice its smoothed round trip time; the first
+ * good answer is used.  Zero, the default, disables hedging.
+ *
+ * Requires:
+ * \li	resolver to be valid.
+ * \li  percent <= 100.
+ */
+
 unsigned int
 dns_resolver_getnonbackofftries(dns_resolver_t *resolver);
 
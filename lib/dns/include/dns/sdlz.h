@@ -53,6 +53,8 @@
 #include <inttypes.h>
 #include <stdbool.h>
 
+#include <isc/job.h>
+
 #include <dns/clientinfo.h>
 #include <dns/dlz.h>
 
@@ -198,6 +200,37 @@ typedef isc_result_t (*dns_sdlzlookupfunc_t)(const char *zone, const char *name,
  * from the caller.
  */
 
+typedef void
+dns_sdlz_lookupdone_t(void *arg, isc_result_t result);
+/*%<
+ * Completion callback for an asynchronous lookup, see
+ * dns_sdlzlookupasync_t.
+ */
+
+typedef isc_result_t (*dns_sdlzlookupasync_t)(
+	const char *zone, const char *name, void *driverarg, void *dbdata,
+	dns_sdlzlookup_t *lookup, dns_clientinfomethods_t *methods,
+	dns_clientinfo_t *clientinfo, dns_sdlz_lookupdone_t *done, void *arg);
+/*%<
+ * Method prototype.  Drivers implementing the SDLZ interface MAY
+ * supply an asynchronous lookup method.  It is called instead of the
+ * lookup method when the query being answered can be suspended, and
+ * it adds records to 'lookup' in the same way.
+ *
+ * If the answer is not available immediately, the method can start
+ * the lookup in the background and return ISC_R_INPROGRESS.  It must
+ * then call 'done' with 'arg' and the result of the lookup exactly
+ * once, after it has added all the records to 'lookup'.  'done' may be
+ * called from any thread, and before the method returns.  'zone',
+ * 'name', 'methods' and 'clientinfo' are only valid until the method
+ * returns.  The driver must complete every pending lookup before its
+ * destroy method returns.
+ *
+ * Any other result completes the lookup at once, as if the lookup
+ * method had returned it, and 'done' is not called.  If the method
+ * returns ISC_R_NOTIMPLEMENTED, the lookup method is called instead.
+ */
+
 typedef isc_result_t (*dns_sdlznewversion_t)(const char *zone, void *driverarg,
 					     void *dbdata, void **versionp);
 /*%<
@@ -287,6 +320,7 @@ typedef struct dns_sdlzmethods {
 	dns_sdlzmodrdataset_t	addrdataset;
 	dns_sdlzmodrdataset_t	subtractrdataset;
 	dns_sdlzdelrdataset_t	delrdataset;
+	dns_sdlzlookupasync_t	lookupasync;
 } dns_sdlzmethods_t;
 
 isc_result_t
@@ -331,6 +365,25 @@ dns_sdlz_putrr_t dns_sdlz_putrr;
  * parsed into a query response.
  */
 
+typedef isc_result_t
+dns_sdlz_putrdata_t(dns_sdlzlookup_t *lookup, dns_rdatatype_t type,
+		    dns_ttl_t ttl, const unsigned char *rdata,
+		    unsigned int length);
+dns_sdlz_putrdata_t dns_sdlz_putrdata;
+/*%<
+ * Like dns_sdlz_putrr(), but 'rdata' holds the 'length' bytes of the
+ * record data in DNS wire format, which saves parsing it from text.
+ * Domain names in 'rdata' must be uncompressed and absolute;
+ * #DNS_SDLZFLAG_RELATIVERDATA does not apply to them.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS
+ *\li	#DNS_R_METATYPE if 'type' is a meta-type
+ *\li	#ISC_R_RANGE if 'length' exceeds the maximum rdata length
+ *\li	the error from dns_rdata_fromwire() if 'rdata' is not valid
+ *	record data of type 'type'
+ */
+
 typedef isc_result_t
 		  dns_sdlz_putsoa_t(dns_sdlzlookup_t *lookup, const char *mname,
 				    const char *rname, uint32_t serial);
@@ -353,4 +406,82 @@ dns_sdlz_setdb_t dns_sdlz_setdb;
  * Create the database pointers for a writeable SDLZ zone
  */
 
+isc_result_t
+dns_sdlz_setcache(dns_dlzdb_t *dlzdb, dns_ttl_t maxttl,
+		  unsigned int maxentries);
+/*%<
+ * Cache the answers looked up from 'dlzdb' for up to 'maxttl' seconds,
+ * or for the lowest TTL of the records found if that is lower.  Names
+ * that do not exist are cached for 'maxttl' seconds.  At most
+ * 'maxentries' names are cached; when the cache is full, the oldest
+ * entries are replaced first.  The cache is flushed when an update to
+ * a zone in 'dlzdb' is committed.
+ *
+ * The cache is keyed on the query name only, so it must not be enabled
+ * for drivers that give different answers to different clients.
+ *
+ * Requires:
+ *\li	'dlzdb' is a valid DLZ database without a cache.
+ *\li	'maxttl' and 'maxentries' are not zero.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS
+ *\li	#ISC_R_NOTIMPLEMENTED if 'dlzdb' is not an SDLZ driver
+ */
+
+isc_stats_t *
+dns_sdlz_getcachestats(dns_dlzdb_t *dlzdb);
+/*%<
+ * Return the answer cache statistics counters of 'dlzdb', indexed by
+ * dns_dlzcachestatscounter_*, or NULL if it has no answer cache.
+ *
+ * Requires:
+ *\li	'dlzdb' is a valid DLZ database.
+ */
+
+bool
+dns_sdlz_asyncsupported(dns_db_t *db);
+/*%<
+ * Return true if 'db' is an SDLZ database whose driver has an
+ * asynchronous lookup method.
+ */
+
+void
+dns_sdlz_asynccreate(isc_mem_t *mctx, dns_sdlzasync_t **asyncp);
+/*%<
+ * Create the state that lets the lookups made on behalf of one query
+ * run asynchronously.
+ *
+ * When the state is set in the clientinfo passed to dns_db_findext()
+ * (see dns_clientinfo_setdlzasync()), a find in an SDLZ database whose
+ * driver starts a lookup in the background returns DNS_R_WAIT.  The
+ * caller then calls dns_sdlz_asyncwait() and repeats the find when it
+ * is told that the lookup has completed.  The answers of completed
+ * lookups are kept in the state, and are used by the repeated find
+ * instead of asking the driver again, so every repetition makes
+ * progress.
+ *
+ * Requires:
+ *\li	'asyncp' is not NULL and '*asyncp' is NULL.
+ */
+
+void
+dns_sdlz_asyncwait(dns_sdlzasync_t *async, isc_loop_t *loop, isc_job_cb cb,
+		   void *cbarg);
+/*%<
+ * Run 'cb' with 'cbarg' on 'loop' when the lookup that made a find
+ * return DNS_R_WAIT has completed, which may already be the case.
+ *
+ * Requires:
+ *\li	The last find using 'async' returned DNS_R_WAIT, and this is
+ *	the first call to dns_sdlz_asyncwait() since.
+ */
+
+void
+dns_sdlz_asyncdetach(dns_sdlzasync_t **asyncp);
+/*%<
+ * Release the caller's reference to '*asyncp'.  It is freed when the
+ * last lookup running on its behalf has completed.
+ */
+
 ISC_LANG_ENDDECLS
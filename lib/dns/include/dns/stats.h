@@ -74,7 +74,11 @@ enum {
 	dns_resstatscounter_clientquota = 43,
 	dns_resstatscounter_nextitem = 44,
 	dns_resstatscounter_priming = 45,
-	dns_resstatscounter_max = 46,
+	dns_resstatscounter_valprefetch = 46,
+	dns_resstatscounter_qminskip = 47,
+	dns_resstatscounter_hedgesent = 48,
+	dns_resstatscounter_hedgewon = 49,
+	dns_resstatscounter_max = 50,
 
 	/*
 	 * DNSSEC stats.
@@ -102,8 +106,11 @@ enum {
 	dns_zonestatscounter_ixfrreqv6 = 10,
 	dns_zonestatscounter_xfrsuccess = 11,
 	dns_zonestatscounter_xfrfail = 12,
+	dns_zonestatscounter_jnlcompact = 13,
+	dns_zonestatscounter_jnlcompactfail = 14,
+	dns_zonestatscounter_jnlcompacttime = 15,
 
-	dns_zonestatscounter_max = 13,
+	dns_zonestatscounter_max = 16,
 
 	/*
 	 * Adb statistics values.
@@ -156,6 +163,16 @@ enum {
 	dns_gluecachestatscounter_inserts_absent = 3,
 
 	dns_gluecachestatscounter_max = 4,
+
+	/*
+	 * DLZ answer cache statistics counters.
+	 */
+	dns_dlzcachestatscounter_hits = 0,
+	dns_dlzcachestatscounter_misses = 1,
+	dns_dlzcachestatscounter_inserts = 2,
+	dns_dlzcachestatscounter_evictions = 3,
+
+	dns_dlzcachestatscounter_max = 4,
 };
 
 /*%
@@ -202,6 +219,13 @@ enum {
 	dns_sizecounter_out_max = DNS_SIZEHISTO_MAXOUT + 1,
 };
 
+/*%
+ * Query latency histograms count microseconds from the receipt of a
+ * request to the sending of its response. Four significant bits keep
+ * the relative error of each quantile below 7%.
+ */
+#define DNS_LATENCYHISTO_SIGBITS 4
+
 /*%
  * Attributes for statistics counters of RRset and Rdatatype types.
  *
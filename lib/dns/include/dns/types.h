@@ -68,6 +68,7 @@ typedef struct dns_dlzimplementation   dns_dlzimplementation_t;
 typedef struct dns_dlzdb	       dns_dlzdb_t;
 typedef ISC_LIST(dns_dlzdb_t) dns_dlzdblist_t;
 typedef struct dns_dyndbctx	      dns_dyndbctx_t;
+typedef struct dns_sdlzasync	      dns_sdlzasync_t;
 typedef struct dns_sdlzimplementation dns_sdlzimplementation_t;
 typedef enum dns_decompress	      dns_decompress_t;
 typedef struct dns_dispatch	      dns_dispatch_t;
@@ -96,6 +97,7 @@ typedef struct dns_geoip_databases dns_geoip_databases_t;
 typedef struct dns_glue		   dns_glue_t;
 typedef struct dns_iptable	   dns_iptable_t;
 typedef uint32_t		   dns_iterations_t;
+typedef struct dns_journalmap	   dns_journalmap_t;
 typedef struct dns_kasp		   dns_kasp_t;
 typedef ISC_LIST(dns_kasp_t) dns_kasplist_t;
 typedef struct dns_kasp_digest dns_kasp_digest_t;
@@ -118,6 +120,7 @@ typedef isc_region_t		   dns_label_t;
 typedef struct dns_name		   dns_name_t;
 typedef struct dns_nametree	   dns_nametree_t;
 typedef ISC_LIST(dns_name_t) dns_namelist_t;
+typedef struct dns_nsec3cache	 dns_nsec3cache_t;
 typedef struct dns_ntatable	 dns_ntatable_t;
 typedef struct dns_ntnode	 dns_ntnode_t;
 typedef uint16_t		 dns_opcode_t;
@@ -121,6 +121,7 @@ struct dns_view {
 	dns_minimaltype_t     minimalresponses;
 	bool		      enablevalidation;
 	bool		      acceptexpired;
+	bool		      chainprefetch;
 	bool		      requireservercookie;
 	bool		      synthfromdnssec;
 	bool		      trust_anchor_telemetry;
@@ -24,6 +24,7 @@
 #include <stdio.h>
 
 #include <isc/formatcheck.h>
+#include <isc/histo.h>
 #include <isc/lang.h>
 #include <isc/rwlock.h>
 #include <isc/tls.h>
@@ -807,7 +808,7 @@ dns_zone_setxfrsource4(dns_zone_t *zone, const isc_sockaddr_t *xfrsource);
  *\li	#ISC_R_SUCCESS
  */
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getxfrsource4(dns_zone_t *zone);
 /*%<
  *	Returns the source address set by a previous dns_zone_setxfrsource4
@@ -830,7 +831,7 @@ dns_zone_setxfrsource6(dns_zone_t *zone, const isc_sockaddr_t *xfrsource);
  *\li	#ISC_R_SUCCESS
  */
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getxfrsource6(dns_zone_t *zone);
 /*%<
  *	Returns the source address set by a previous dns_zone_setxfrsource6
@@ -853,7 +854,7 @@ dns_zone_setparentalsrc4(dns_zone_t *zone, const isc_sockaddr_t *parentalsrc);
  *\li	#ISC_R_SUCCESS
  */
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getparentalsrc4(dns_zone_t *zone);
 /*%<
  *	Returns the source address set by a previous dns_zone_setparentalsrc4
@@ -876,7 +877,7 @@ dns_zone_setparentalsrc6(dns_zone_t *zone, const isc_sockaddr_t *parentalsrc);
  *\li	#ISC_R_SUCCESS
  */
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getparentalsrc6(dns_zone_t *zone);
 /*%<
  *	Returns the source address set by a previous dns_zone_setparentalsrc6
@@ -899,7 +900,7 @@ dns_zone_setnotifysrc4(dns_zone_t *zone, const isc_sockaddr_t *notifysrc);
  *\li	#ISC_R_SUCCESS
  */
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getnotifysrc4(dns_zone_t *zone);
 /*%<
  *	Returns the source address set by a previous dns_zone_setnotifysrc4
@@ -922,7 +923,7 @@ dns_zone_setnotifysrc6(dns_zone_t *zone, const isc_sockaddr_t *notifysrc);
  *\li	#ISC_R_SUCCESS
  */
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getnotifysrc6(dns_zone_t *zone);
 /*%<
  *	Returns the source address set by a previous dns_zone_setnotifysrc6
@@ -1277,6 +1278,26 @@ dns_zone_getjournal(dns_zone_t *zone);
  *\li	'zone' to be valid initialised zone.
  */
 
+isc_result_t
+dns_zone_getjournalmap(dns_zone_t *zone, dns_journalmap_t **mapp);
+/*%<
+ * Attach '*mapp' to a memory mapped snapshot of the zone's journal that
+ * is up to date with the journal file.  The zone keeps the most recent
+ * snapshot, so that concurrent readers of an unchanged journal share it,
+ * and it is only indexed again from where the previous snapshot ended
+ * when transactions are added.
+ *
+ * Requires:
+ *\li	'zone' to be valid initialised zone.
+ *\li	'mapp' is not NULL and '*mapp' is NULL.
+ *
+ * Returns:
+ *\li	ISC_R_SUCCESS
+ *\li	ISC_R_NOTFOUND if the zone has no journal file
+ *\li	Other errors from dns_journalmap_create(); the journal can still
+ *	be read with dns_journal_open().
+ */
+
 dns_zonetype_t
 dns_zone_gettype(dns_zone_t *zone);
 /*%<
@@ -1799,6 +1820,40 @@ dns_zonemgr_setserialqueryrate(dns_zonemgr_t *zmgr, unsigned int value);
  *\li	'zmgr' to be a valid zone manager
  */
 
+void
+dns_zonemgr_setserialquerybatch(dns_zonemgr_t *zmgr, unsigned int value);
+/*%<
+ *	Set the maximum number of SOA queries sent to the same primary
+ *	in one batch.  Each batch counts as a single query against the
+ *	rate set by dns_zonemgr_setserialqueryrate().  A value of zero is
+ *	treated as one.
+ *
+ * Requires:
+ *\li	'zmgr' to be a valid zone manager
+ */
+
+unsigned int
+dns_zonemgr_getserialquerybatch(dns_zonemgr_t *zmgr);
+/*%<
+ *	Return the maximum number of SOA queries sent in one batch.
+ *
+ * Requires:
+ *\li	'zmgr' to be a valid zone manager.
+ */
+
+void
+dns_zonemgr_getrefreshbacklog(dns_zonemgr_t *zmgr, size_t *zonesp,
+			      size_t *primariesp);
+/*%<
+ *	Return the number of zones waiting to send a SOA query in
+ *	'*zonesp', and the number of primaries they are waiting to query in
+ *	'*primariesp'.
+ *
+ * Requires:
+ *\li	'zmgr' to be a valid zone manager.
+ *\li	'zonesp' and 'primariesp' are not NULL.
+ */
+
 unsigned int
 dns_zonemgr_getnotifyrate(dns_zonemgr_t *zmgr);
 /*%<
@@ -1981,6 +2036,27 @@ dns_zone_getrequeststats(dns_zone_t *zone);
 dns_stats_t *
 dns_zone_getrcvquerystats(dns_zone_t *zone);
 
+isc_histomulti_t *
+dns_zone_getlatencystats(dns_zone_t *zone);
+/*%<
+ * Get the zone's query latency histogram, creating it on first use,
+ * if the zone keeps full request statistics; otherwise NULL.  Only the
+ * caller updates the histogram.
+ *
+ * Requires:
+ * \li	'zone' to be a valid zone.
+ */
+
+dns_nsec3cache_t *
+dns_zone_getnsec3cache(dns_zone_t *zone);
+/*%<
+ * Get the cache of NSEC3 owner name hashes used when answering
+ * authoritatively from 'zone', creating it on first use.
+ *
+ * Requires:
+ * \li	'zone' to be a valid zone.
+ */
+
 dns_stats_t *
 dns_zone_getdnssecsignstats(dns_zone_t *zone);
 /*%<
@@ -2375,6 +2451,35 @@ dns_zone_getserialupdatemethod(dns_zone_t *zone);
  * \li	'zone' to be valid.
  */
 
+void
+dns_zone_setupdatewindow(dns_zone_t *zone, uint32_t window);
+uint32_t
+dns_zone_getupdatewindow(dns_zone_t *zone);
+/*%<
+ * Set/get the window, in milliseconds, during which dynamic updates for
+ * 'zone' are collected so that they can be committed as a single new
+ * version of the zone database and a single journal transaction.  Zero
+ * commits each update as it arrives.
+ *
+ * Requires:
+ * \li	'zone' to be valid.
+ */
+
+void
+dns_zone_setupdatequeue(dns_zone_t *zone, void *queue);
+void *
+dns_zone_getupdatequeue(dns_zone_t *zone);
+/*%<
+ * Set/get the queue of dynamic updates waiting to be committed to
+ * 'zone'.  The queue is opaque to the zone and is managed by the
+ * dynamic update code; it must be cleared before the zone is freed.
+ *
+ * Requires:
+ * \li	'zone' to be valid.
+ * \li	The caller is running on the zone's loop.
+ * \li	When setting a non-NULL 'queue', no queue is set.
+ */
+
 isc_result_t
 dns_zone_link(dns_zone_t *zone, dns_zone_t *raw);
 
@@ -12,21 +12,28 @@
  */
 
 #include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <isc/dir.h>
+#include <isc/errno.h>
 #include <isc/file.h>
 #include <isc/mem.h>
 #include <isc/overflow.h>
+#include <isc/refcount.h>
 #include <isc/result.h>
 #include <isc/serial.h>
 #include <isc/stdio.h>
 #include <isc/string.h>
+#include <isc/time.h>
 #include <isc/util.h>
 
+#include <dns/callbacks.h>
 #include <dns/compress.h>
 #include <dns/db.h>
 #include <dns/dbiterator.h>
@@ -336,6 +343,7 @@ struct dns_journal {
 	unsigned char *rawindex;     /*%< In-core buffer for journal index
 				      * in on-disk format */
 	journal_pos_t *index;	     /*%< In-core journal index */
+	dns_journalmap_t *map;	     /*%< Mapped journal, instead of 'fp' */
 
 	/*% Current transaction state (when writing). */
 	struct {
@@ -367,6 +375,30 @@ struct dns_journal {
 #define DNS_JOURNAL_MAGIC    ISC_MAGIC('J', 'O', 'U', 'R')
 #define DNS_JOURNAL_VALID(t) ISC_MAGIC_VALID(t, DNS_JOURNAL_MAGIC)
 
+/*%
+ * A read-only snapshot of a journal file, mapped into memory, with the
+ * position of every transaction in it.  Journals opened for reading with
+ * dns_journal_openmap() read the snapshot instead of the file, and any
+ * number of them can share it.
+ */
+struct dns_journalmap {
+	unsigned int magic; /*%< JMAP */
+	isc_mem_t *mctx;
+	isc_refcount_t references;
+	char *filename;
+	dev_t dev;		 /*%< Device and inode of the mapped */
+	ino_t ino;		 /*%< journal file */
+	unsigned char *base;	 /*%< The mapped file, up to the end */
+	size_t size;		 /*%< of the last transaction */
+	journal_header_t header; /*%< Journal header when mapped */
+	journal_pos_t *index;	 /*%< Start of each transaction */
+	size_t count;		 /*%< Number of transactions */
+	size_t allocated;	 /*%< Size of 'index' */
+};
+
+#define DNS_JOURNALMAP_MAGIC	ISC_MAGIC('J', 'M', 'A', 'P')
+#define DNS_JOURNALMAP_VALID(m) ISC_MAGIC_VALID(m, DNS_JOURNALMAP_MAGIC)
+
 static void
 journal_pos_decode(journal_rawpos_t *raw, journal_pos_t *cooked) {
 	cooked->serial = decode_uint32(raw->serial);
@@ -416,6 +448,17 @@ static isc_result_t
 journal_seek(dns_journal_t *j, uint32_t offset) {
 	isc_result_t result;
 
+	if (j->map != NULL) {
+		if (offset > j->map->size) {
+			isc_log_write(JOURNAL_COMMON_LOGARGS, ISC_LOG_ERROR,
+				      "%s: seek: offset %u beyond end",
+				      j->filename, offset);
+			return (ISC_R_UNEXPECTED);
+		}
+		j->offset = offset;
+		return (ISC_R_SUCCESS);
+	}
+
 	result = isc_stdio_seek(j->fp, (off_t)offset, SEEK_SET);
 	if (result != ISC_R_SUCCESS) {
 		isc_log_write(JOURNAL_COMMON_LOGARGS, ISC_LOG_ERROR,
@@ -431,6 +474,15 @@ static isc_result_t
 journal_read(dns_journal_t *j, void *mem, size_t nbytes) {
 	isc_result_t result;
 
+	if (j->map != NULL) {
+		if (nbytes > j->map->size - (size_t)j->offset) {
+			return (ISC_R_NOMORE);
+		}
+		memmove(mem, j->map->base + j->offset, nbytes);
+		j->offset += (off_t)nbytes;
+		return (ISC_R_SUCCESS);
+	}
+
 	result = isc_stdio_read(mem, 1, nbytes, j->fp, NULL);
 	if (result != ISC_R_SUCCESS) {
 		if (result == ISC_R_EOF) {
@@ -1093,6 +1145,35 @@ index_invalidate(dns_journal_t *j, uint32_t serial) {
 	}
 }
 
+/*
+ * Look up the transaction with initial serial number 'serial' in the
+ * complete index of the journal map 'map'.  The transactions are in
+ * serial number order, so the index can be searched by the distance
+ * of each serial number from the first one.
+ */
+static isc_result_t
+journalmap_find(dns_journalmap_t *map, uint32_t serial, journal_pos_t *pos) {
+	uint32_t begin = map->header.begin.serial;
+	uint32_t distance = serial - begin;
+	size_t lo = 0, hi = map->count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		uint32_t d = map->index[mid].serial - begin;
+
+		if (d == distance) {
+			*pos = map->index[mid];
+			return (ISC_R_SUCCESS);
+		} else if (d < distance) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return (ISC_R_NOTFOUND);
+}
+
 /*
  * Try to find a transaction with initial serial number 'serial'
  * in the journal 'j'.
@@ -1130,6 +1211,10 @@ journal_find(dns_journal_t *j, uint32_t serial, journal_pos_t *pos) {
 		return (ISC_R_SUCCESS);
 	}
 
+	if (j->map != NULL) {
+		return (journalmap_find(j->map, serial, pos));
+	}
+
 	current_pos = j->header.begin;
 	index_find(j, serial, &current_pos);
 
@@ -1465,10 +1550,259 @@ dns_journal_destroy(dns_journal_t **journalp) {
 	if (j->fp != NULL) {
 		(void)isc_stdio_close(j->fp);
 	}
+	if (j->map != NULL) {
+		dns_journalmap_detach(&j->map);
+	}
 	j->magic = 0;
 	isc_mem_putanddetach(&j->mctx, j, sizeof(*j));
 }
 
+/*
+ * Journal maps.
+ */
+
+/*
+ * Add the positions of the transactions in 'map' to its index, checking
+ * that they form an unbroken sequence from the beginning to the end of
+ * the journal.  If 'prev' is an earlier map of the same file, the
+ * transactions it had already indexed are copied from it.
+ */
+static isc_result_t
+journalmap_index(dns_journalmap_t *map, const dns_journalmap_t *prev) {
+	journal_pos_t pos = map->header.begin;
+	uint64_t end = map->header.end.offset;
+
+	if (prev != NULL && prev->dev == map->dev && prev->ino == map->ino &&
+	    prev->header.begin.serial == map->header.begin.serial &&
+	    prev->header.begin.offset == map->header.begin.offset &&
+	    prev->header.end.offset <= map->header.end.offset &&
+	    prev->count > 0)
+	{
+		map->allocated = prev->allocated;
+		map->index = isc_mem_cget(map->mctx, map->allocated,
+					  sizeof(map->index[0]));
+		memmove(map->index, prev->index,
+			prev->count * sizeof(map->index[0]));
+		map->count = prev->count;
+		pos = prev->header.end;
+	}
+
+	while ((uint64_t)pos.offset < end) {
+		journal_rawxhdr_t raw;
+		uint32_t size, serial0, serial1;
+
+		if (end - pos.offset < sizeof(raw)) {
+			goto corrupt;
+		}
+		memmove(&raw, map->base + pos.offset, sizeof(raw));
+		size = decode_uint32(raw.size);
+		serial0 = decode_uint32(raw.serial0);
+		serial1 = decode_uint32(raw.serial1);
+
+		if (serial0 != pos.serial || isc_serial_le(serial1, serial0) ||
+		    size == 0 || size > end - pos.offset - sizeof(raw))
+		{
+			goto corrupt;
+		}
+
+		if (map->count == map->allocated) {
+			size_t allocated = ISC_MAX(16, 2 * map->allocated);
+			map->index = isc_mem_creget(map->mctx, map->index,
+						    map->allocated, allocated,
+						    sizeof(map->index[0]));
+			map->allocated = allocated;
+		}
+		map->index[map->count++] = pos;
+
+		pos.offset += sizeof(raw) + size;
+		pos.serial = serial1;
+	}
+
+	if (pos.offset != map->header.end.offset ||
+	    pos.serial != map->header.end.serial)
+	{
+		goto corrupt;
+	}
+
+	return (ISC_R_SUCCESS);
+
+corrupt:
+	isc_log_write(JOURNAL_COMMON_LOGARGS, ISC_LOG_ERROR,
+		      "%s: journal file corrupt: bad transaction at offset %u",
+		      map->filename, (unsigned int)pos.offset);
+	return (ISC_R_UNEXPECTED);
+}
+
+static void
+journalmap_destroy(dns_journalmap_t *map) {
+	map->magic = 0;
+	if (map->index != NULL) {
+		isc_mem_cput(map->mctx, map->index, map->allocated,
+			     sizeof(map->index[0]));
+	}
+	if (map->base != NULL) {
+		RUNTIME_CHECK(munmap(map->base, map->size) == 0);
+	}
+	isc_mem_free(map->mctx, map->filename);
+	isc_mem_putanddetach(&map->mctx, map, sizeof(*map));
+}
+
+isc_result_t
+dns_journalmap_create(isc_mem_t *mctx, const char *filename,
+		      const dns_journalmap_t *prev, dns_journalmap_t **mapp) {
+	isc_result_t result;
+	dns_journalmap_t *map = NULL;
+	journal_rawheader_t rawheader;
+	struct stat sb;
+	void *base = NULL;
+	int fd;
+
+	REQUIRE(filename != NULL);
+	REQUIRE(prev == NULL || DNS_JOURNALMAP_VALID(prev));
+	REQUIRE(mapp != NULL && *mapp == NULL);
+
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		result = isc_errno_toresult(errno);
+		return (result == ISC_R_FILENOTFOUND ? ISC_R_NOTFOUND
+						     : result);
+	}
+
+	map = isc_mem_get(mctx, sizeof(*map));
+	*map = (dns_journalmap_t){
+		.magic = DNS_JOURNALMAP_MAGIC,
+		.filename = isc_mem_strdup(mctx, filename),
+	};
+	isc_mem_attach(mctx, &map->mctx);
+	isc_refcount_init(&map->references, 1);
+
+	if (fstat(fd, &sb) != 0 ||
+	    pread(fd, &rawheader, sizeof(rawheader), 0) != sizeof(rawheader))
+	{
+		isc_log_write(JOURNAL_COMMON_LOGARGS, ISC_LOG_ERROR,
+			      "%s: read: %s", filename, strerror(errno));
+		FAIL(ISC_R_UNEXPECTED);
+	}
+	map->dev = sb.st_dev;
+	map->ino = sb.st_ino;
+
+	/*
+	 * Journals with version 1 transaction headers may need them to
+	 * be fixed up while reading; leave those to dns_journal_open().
+	 */
+	if (memcmp(rawheader.h.format, initial_journal_header.format,
+		   sizeof(initial_journal_header.format)) != 0)
+	{
+		FAIL(ISC_R_NOTIMPLEMENTED);
+	}
+	journal_header_decode(&rawheader, &map->header);
+
+	if (map->header.end.offset < (off_t)sizeof(rawheader) ||
+	    map->header.begin.offset > map->header.end.offset ||
+	    map->header.end.offset > sb.st_size)
+	{
+		isc_log_write(JOURNAL_COMMON_LOGARGS, ISC_LOG_ERROR,
+			      "%s: journal file corrupt: bad header",
+			      filename);
+		FAIL(ISC_R_UNEXPECTED);
+	}
+
+	map->size = map->header.end.offset;
+	base = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED) {
+		isc_log_write(JOURNAL_COMMON_LOGARGS, ISC_LOG_ERROR,
+			      "%s: mmap: %s", filename, strerror(errno));
+		FAIL(ISC_R_UNEXPECTED);
+	}
+	map->base = base;
+
+	CHECK(journalmap_index(map, prev));
+
+	isc_log_write(JOURNAL_DEBUG_LOGARGS(3),
+		      "%s: mapped %zu transactions (%zu bytes)", filename,
+		      map->count, map->size);
+
+	(void)close(fd);
+	*mapp = map;
+	return (ISC_R_SUCCESS);
+
+failure:
+	(void)close(fd);
+	journalmap_destroy(map);
+	return (result);
+}
+
+bool
+dns_journalmap_current(dns_journalmap_t *map) {
+	journal_rawheader_t *rawheader = NULL;
+	journal_pos_t end;
+	struct stat sb;
+
+	REQUIRE(DNS_JOURNALMAP_VALID(map));
+
+	if (stat(map->filename, &sb) != 0 || sb.st_dev != map->dev ||
+	    sb.st_ino != map->ino)
+	{
+		return (false);
+	}
+
+	/*
+	 * The header is still mapped and shows the end of the journal
+	 * as it is now.
+	 */
+	rawheader = (journal_rawheader_t *)map->base;
+	journal_pos_decode(&rawheader->h.end, &end);
+
+	return (end.serial == map->header.end.serial &&
+		end.offset == map->header.end.offset);
+}
+
+const char *
+dns_journalmap_filename(dns_journalmap_t *map) {
+	REQUIRE(DNS_JOURNALMAP_VALID(map));
+
+	return (map->filename);
+}
+
+#if DNS_JOURNALMAP_TRACE
+ISC_REFCOUNT_TRACE_IMPL(dns_journalmap, journalmap_destroy);
+#else
+ISC_REFCOUNT_IMPL(dns_journalmap, journalmap_destroy);
+#endif
+
+isc_result_t
+dns_journal_openmap(isc_mem_t *mctx, dns_journalmap_t *map,
+		    dns_journal_t **journalp) {
+	dns_journal_t *j = NULL;
+
+	REQUIRE(DNS_JOURNALMAP_VALID(map));
+	REQUIRE(journalp != NULL && *journalp == NULL);
+
+	j = isc_mem_get(mctx, sizeof(*j));
+	*j = (dns_journal_t){ .magic = DNS_JOURNAL_MAGIC,
+			      .state = JOURNAL_STATE_READ,
+			      .filename = isc_mem_strdup(mctx, map->filename),
+			      .xhdr_version = XHDR_VERSION2,
+			      .header = map->header,
+			      .offset = -1 };
+	isc_mem_attach(mctx, &j->mctx);
+	dns_journalmap_attach(map, &j->map);
+
+	/*
+	 * The in-core index is not used; the map has a complete one.
+	 */
+	j->header.index_size = 0;
+
+	dns_name_init(&j->it.name, NULL);
+	dns_rdata_init(&j->it.rdata);
+	isc_buffer_init(&j->it.source, NULL, 0);
+	isc_buffer_init(&j->it.target, NULL, 0);
+	j->it.dctx = DNS_DECOMPRESS_NEVER;
+
+	*journalp = j;
+	return (ISC_R_SUCCESS);
+}
+
 /*
  * Roll the open journal 'j' into the database 'db'.
  * A new database version will be created.
@@ -2106,31 +2440,21 @@ dns_journal_current_rr(dns_journal_t *j, dns_name_t **name, uint32_t *ttl,
  */
 
 /*
- * Construct a diff containing all the RRs at the current name of the
- * database iterator 'dbit' in database 'db', version 'ver'.
- * Set '*name' to the current name, and append the diff to 'diff'.
+ * Construct a diff containing all the RRs at node 'node', named 'name',
+ * in database 'db', version 'ver', and append it to 'diff'.
  * All new tuples will have the operation 'op'.
- *
- * Requires: 'name' must have buffer large enough to hold the name.
- * Typically, a dns_fixedname_t would be used.
  */
 static isc_result_t
-get_name_diff(dns_db_t *db, dns_dbversion_t *ver, isc_stdtime_t now,
-	      dns_dbiterator_t *dbit, dns_name_t *name, dns_diffop_t op,
+get_node_diff(dns_db_t *db, dns_dbversion_t *ver, isc_stdtime_t now,
+	      dns_dbnode_t *node, const dns_name_t *name, dns_diffop_t op,
 	      dns_diff_t *diff) {
 	isc_result_t result;
-	dns_dbnode_t *node = NULL;
 	dns_rdatasetiter_t *rdsiter = NULL;
 	dns_difftuple_t *tuple = NULL;
 
-	result = dns_dbiterator_current(dbit, &node, name);
-	if (result != ISC_R_SUCCESS) {
-		return (result);
-	}
-
 	result = dns_db_allrdatasets(db, node, ver, 0, now, &rdsiter);
 	if (result != ISC_R_SUCCESS) {
-		goto cleanup_node;
+		return (result);
 	}
 
 	for (result = dns_rdatasetiter_first(rdsiter); result == ISC_R_SUCCESS;
@@ -2170,7 +2494,32 @@ get_name_diff(dns_db_t *db, dns_dbversion_t *ver, isc_stdtime_t now,
 cleanup_iterator:
 	dns_rdatasetiter_destroy(&rdsiter);
 
-cleanup_node:
+	return (result);
+}
+
+/*
+ * Construct a diff containing all the RRs at the current name of the
+ * database iterator 'dbit' in database 'db', version 'ver'.
+ * Set '*name' to the current name, and append the diff to 'diff'.
+ * All new tuples will have the operation 'op'.
+ *
+ * Requires: 'name' must have buffer large enough to hold the name.
+ * Typically, a dns_fixedname_t would be used.
+ */
+static isc_result_t
+get_name_diff(dns_db_t *db, dns_dbversion_t *ver, isc_stdtime_t now,
+	      dns_dbiterator_t *dbit, dns_name_t *name, dns_diffop_t op,
+	      dns_diff_t *diff) {
+	isc_result_t result;
+	dns_dbnode_t *node = NULL;
+
+	result = dns_dbiterator_current(dbit, &node, name);
+	if (result != ISC_R_SUCCESS) {
+		return (result);
+	}
+
+	result = get_node_diff(db, ver, now, node, name, op, diff);
+
 	dns_db_detachnode(db, &node);
 
 	return (result);
@@ -2420,80 +2769,906 @@ failure:
 	return (result);
 }
 
-static uint32_t
-rrcount(unsigned char *buf, unsigned int size) {
-	isc_buffer_t b;
-	uint32_t rrsize, count = 0;
+/*
+ * Streaming diffs of zones being loaded
+ */
 
-	isc_buffer_init(&b, buf, size);
-	isc_buffer_add(&b, size);
-	while (isc_buffer_remaininglength(&b) > 0) {
-		rrsize = isc_buffer_getuint32(&b);
-		INSIST(isc_buffer_remaininglength(&b) >= rrsize);
-		isc_buffer_forward(&b, rrsize);
-		count++;
+#define DNS_LOADDIFF_MAGIC    ISC_MAGIC('L', 'D', 'I', 'F')
+#define DNS_LOADDIFF_VALID(l) ISC_MAGIC_VALID(l, DNS_LOADDIFF_MAGIC)
+
+typedef struct loaddiff_name loaddiff_name_t;
+struct loaddiff_name {
+	dns_name_t name;
+	bool nsec3;
+	ISC_LINK(loaddiff_name_t) link;
+};
+
+/*
+ * The names in one of the trees of the old database, in step with the
+ * names being loaded as long as they are loaded in DNSSEC order.
+ */
+typedef struct loaddiff_tree {
+	dns_dbiterator_t *dbit;
+	isc_result_t result;
+	dns_fixedname_t fcurrent;
+	dns_dbnode_t *node;
+	dns_fixedname_t fprev;
+	bool loaded;
+	bool unsorted;
+} loaddiff_tree_t;
+
+struct dns_loaddiff {
+	unsigned int magic;
+	isc_mem_t *mctx;
+	dns_db_t *db;
+	dns_dbversion_t *ver;
+	dns_db_t *loaddb;
+	dns_addrdatasetfunc_t add;
+	void *add_private;
+
+	/* The main and NSEC3 trees of the old database */
+	loaddiff_tree_t trees[2];
+
+	/* The name currently being loaded, and its node in 'db' */
+	dns_fixedname_t fname;
+	dns_dbnode_t *node;
+	bool active;
+	bool nsec3;
+	bool changed;
+	unsigned int rdatasets;
+	uint64_t records;
+
+	/* Records at unchanged names, and the names that have changed */
+	uint64_t unchanged;
+	ISC_LIST(loaddiff_name_t) changes;
+	size_t nchanges;
+	bool failed;
+};
+
+static void
+loaddiff_changed(dns_loaddiff_t *ld, const dns_name_t *name, bool nsec3) {
+	loaddiff_name_t *change = isc_mem_get(ld->mctx, sizeof(*change));
+
+	*change = (loaddiff_name_t){
+		.name = DNS_NAME_INITEMPTY,
+		.nsec3 = nsec3,
+		.link = ISC_LINK_INITIALIZER,
+	};
+	dns_name_dup(name, ld->mctx, &change->name);
+	ISC_LIST_APPEND(ld->changes, change, link);
+	ld->nchanges++;
+}
+
+/*
+ * Move the iterator of 'tree' to the next name in the old database.
+ */
+static void
+loaddiff_step(dns_loaddiff_t *ld, loaddiff_tree_t *tree) {
+	if (tree->node != NULL) {
+		dns_db_detachnode(ld->db, &tree->node);
 	}
 
-	return (count);
+	tree->result = dns_dbiterator_next(tree->dbit);
+	if (tree->result == ISC_R_SUCCESS) {
+		tree->result = dns_dbiterator_current(
+			tree->dbit, &tree->node,
+			dns_fixedname_name(&tree->fcurrent));
+	}
+	if (tree->result != ISC_R_SUCCESS && tree->result != ISC_R_NOMORE) {
+		ld->failed = true;
+	}
+	(void)dns_dbiterator_pause(tree->dbit);
 }
 
-static bool
-check_delta(unsigned char *buf, size_t size) {
-	isc_buffer_t b;
-	uint32_t rrsize;
+/*
+ * Skip past the names in the old database that precede 'name' ('name'
+ * is NULL at the end of the load).  As the names are being loaded in
+ * order, they cannot be in the new database and have been removed.
+ * Returns the node for 'name' in the old database if it exists.
+ */
+static dns_dbnode_t *
+loaddiff_skip(dns_loaddiff_t *ld, loaddiff_tree_t *tree,
+	      const dns_name_t *name) {
+	dns_dbnode_t *node = NULL;
 
-	isc_buffer_init(&b, buf, size);
-	isc_buffer_add(&b, size);
-	while (isc_buffer_remaininglength(&b) > 0) {
-		if (isc_buffer_remaininglength(&b) < 4) {
-			return (false);
+	while (tree->result == ISC_R_SUCCESS) {
+		dns_name_t *current = dns_fixedname_name(&tree->fcurrent);
+		int order = 1;
+
+		if (name != NULL) {
+			order = dns_name_compare(name, current);
 		}
-		rrsize = isc_buffer_getuint32(&b);
-		/* "." + type + class + ttl + rdlen => 11U */
-		if (rrsize < 11U || isc_buffer_remaininglength(&b) < rrsize) {
-			return (false);
+		if (order < 0) {
+			break;
 		}
-		isc_buffer_forward(&b, rrsize);
+		if (order == 0) {
+			node = tree->node;
+			tree->node = NULL;
+			loaddiff_step(ld, tree);
+			break;
+		}
+		loaddiff_changed(ld, current, tree == &ld->trees[1]);
+		loaddiff_step(ld, tree);
 	}
 
-	return (true);
+	return (node);
 }
 
-isc_result_t
-dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
-		    uint32_t flags, uint32_t target_size) {
-	unsigned int i;
-	journal_pos_t best_guess;
-	journal_pos_t current_pos;
-	dns_journal_t *j1 = NULL;
-	dns_journal_t *j2 = NULL;
-	journal_rawheader_t rawheader;
-	unsigned int len;
-	size_t namelen;
-	unsigned char *buf = NULL;
-	unsigned int size = 0;
+static void
+loaddiff_beginname(dns_loaddiff_t *ld, const dns_name_t *name, bool nsec3) {
+	loaddiff_tree_t *tree = &ld->trees[nsec3 ? 1 : 0];
+	dns_name_t *prev = dns_fixedname_name(&tree->fprev);
 	isc_result_t result;
-	unsigned int indexend;
-	char newname[PATH_MAX];
-	char backup[PATH_MAX];
-	bool is_backup = false;
-	bool rewrite = false;
-	bool downgrade = false;
 
-	REQUIRE(filename != NULL);
+	INSIST(!ld->active && ld->node == NULL);
 
-	namelen = strlen(filename);
-	if (namelen > 4U && strcmp(filename + namelen - 4, ".jnl") == 0) {
-		namelen -= 4;
+	dns_name_copy(name, dns_fixedname_name(&ld->fname));
+	ld->active = true;
+	ld->nsec3 = nsec3;
+	ld->changed = false;
+	ld->rdatasets = 0;
+	ld->records = 0;
+
+	/*
+	 * Once a name is loaded out of order, the removed names can no
+	 * longer be found by skipping through the old database.
+	 */
+	if (tree->loaded && dns_name_compare(name, prev) <= 0) {
+		tree->unsorted = true;
 	}
+	tree->loaded = true;
+	dns_name_copy(name, prev);
 
-	result = snprintf(newname, sizeof(newname), "%.*s.jnw", (int)namelen,
-			  filename);
-	RUNTIME_CHECK(result < sizeof(newname));
+	if (!tree->unsorted) {
+		ld->node = loaddiff_skip(ld, tree, name);
+	} else if (nsec3) {
+		result = dns_db_findnsec3node(ld->db, name, false, &ld->node);
+		INSIST(result == ISC_R_SUCCESS || ld->node == NULL);
+	} else {
+		result = dns_db_findnode(ld->db, name, false, &ld->node);
+		INSIST(result == ISC_R_SUCCESS || ld->node == NULL);
+	}
 
-	result = snprintf(backup, sizeof(backup), "%.*s.jbk", (int)namelen,
-			  filename);
-	RUNTIME_CHECK(result < sizeof(backup));
+	if (ld->node == NULL) {
+		ld->changed = true;
+	}
+}
+
+static void
+loaddiff_endname(dns_loaddiff_t *ld) {
+	dns_rdatasetiter_t *rdsiter = NULL;
+	unsigned int rdatasets = 0;
+	isc_result_t result;
+
+	if (!ld->active) {
+		return;
+	}
+
+	/*
+	 * The name is unchanged if every rdataset loaded matched the old
+	 * one and there were no others in the old database.
+	 */
+	if (!ld->changed) {
+		result = dns_db_allrdatasets(ld->db, ld->node, ld->ver, 0, 0,
+					     &rdsiter);
+		if (result == ISC_R_SUCCESS) {
+			for (result = dns_rdatasetiter_first(rdsiter);
+			     result == ISC_R_SUCCESS;
+			     result = dns_rdatasetiter_next(rdsiter))
+			{
+				rdatasets++;
+			}
+			dns_rdatasetiter_destroy(&rdsiter);
+		}
+		if (result != ISC_R_NOMORE || rdatasets != ld->rdatasets) {
+			ld->changed = true;
+		}
+	}
+
+	if (ld->changed) {
+		loaddiff_changed(ld, dns_fixedname_name(&ld->fname),
+				 ld->nsec3);
+	} else {
+		ld->unchanged += ld->records;
+	}
+
+	if (ld->node != NULL) {
+		dns_db_detachnode(ld->db, &ld->node);
+	}
+	ld->active = false;
+}
+
+static int
+rdata_compare(const void *av, const void *bv) {
+	return (dns_rdata_compare(av, bv));
+}
+
+/*
+ * Return true if the old and loaded rdatasets have the same TTL and
+ * the same records.
+ */
+static bool
+rdataset_equal(isc_mem_t *mctx, dns_rdataset_t *old, dns_rdataset_t *loaded) {
+	unsigned int count = dns_rdataset_count(loaded);
+	dns_rdata_t *rdatas = NULL;
+	isc_result_t result;
+	bool equal = true;
+	unsigned int i;
+
+	if (old->ttl != loaded->ttl || dns_rdataset_count(old) != count) {
+		return (false);
+	}
+
+	/*
+	 * The records are sorted, so that sets in a different order
+	 * compare equal.
+	 */
+	rdatas = isc_mem_cget(mctx, 2 * count, sizeof(rdatas[0]));
+	for (i = 0, result = dns_rdataset_first(old); result == ISC_R_SUCCESS;
+	     i++, result = dns_rdataset_next(old))
+	{
+		dns_rdata_init(&rdatas[i]);
+		dns_rdataset_current(old, &rdatas[i]);
+	}
+	for (result = dns_rdataset_first(loaded); result == ISC_R_SUCCESS;
+	     i++, result = dns_rdataset_next(loaded))
+	{
+		dns_rdata_init(&rdatas[i]);
+		dns_rdataset_current(loaded, &rdatas[i]);
+	}
+	INSIST(i == 2 * count);
+
+	if (count > 1) {
+		qsort(rdatas, count, sizeof(rdatas[0]), rdata_compare);
+		qsort(rdatas + count, count, sizeof(rdatas[0]), rdata_compare);
+	}
+	for (i = 0; equal && i < count; i++) {
+		if (dns_rdata_compare(&rdatas[i], &rdatas[count + i]) != 0) {
+			equal = false;
+		}
+	}
+
+	isc_mem_cput(mctx, rdatas, 2 * count, sizeof(rdatas[0]));
+
+	return (equal);
+}
+
+static isc_result_t
+loaddiff_add(void *arg, const dns_name_t *name,
+	     dns_rdataset_t *rdataset DNS__DB_FLARG) {
+	dns_loaddiff_t *ld = arg;
+	dns_rdataset_t old;
+	isc_result_t result;
+	bool nsec3;
+
+	REQUIRE(DNS_LOADDIFF_VALID(ld));
+
+	result = (ld->add)(ld->add_private, name,
+			   rdataset DNS__DB_FLARG_PASS);
+	if (result != ISC_R_SUCCESS) {
+		return (result);
+	}
+
+	nsec3 = (rdataset->type == dns_rdatatype_nsec3 ||
+		 rdataset->covers == dns_rdatatype_nsec3);
+	if (!ld->active || ld->nsec3 != nsec3 ||
+	    !dns_name_equal(name, dns_fixedname_name(&ld->fname)))
+	{
+		loaddiff_endname(ld);
+		loaddiff_beginname(ld, name, nsec3);
+	}
+
+	if (ld->changed) {
+		return (ISC_R_SUCCESS);
+	}
+
+	dns_rdataset_init(&old);
+	if (dns_db_findrdataset(ld->db, ld->node, ld->ver, rdataset->type,
+				rdataset->covers, 0, &old,
+				NULL) != ISC_R_SUCCESS)
+	{
+		ld->changed = true;
+		return (ISC_R_SUCCESS);
+	}
+	if (rdataset_equal(ld->mctx, &old, rdataset)) {
+		ld->rdatasets++;
+		ld->records += dns_rdataset_count(rdataset);
+	} else {
+		ld->changed = true;
+	}
+	dns_rdataset_disassociate(&old);
+
+	return (ISC_R_SUCCESS);
+}
+
+isc_result_t
+dns_loaddiff_create(isc_mem_t *mctx, dns_db_t *db, dns_db_t *loaddb,
+		    dns_loaddiff_t **ldp) {
+	const unsigned int options[2] = { DNS_DB_NONSEC3, DNS_DB_NSEC3ONLY };
+	dns_loaddiff_t *ld = NULL;
+	isc_result_t result;
+
+	REQUIRE(DNS_DB_VALID(db));
+	REQUIRE(DNS_DB_VALID(loaddb));
+	REQUIRE(ldp != NULL && *ldp == NULL);
+
+	ld = isc_mem_get(mctx, sizeof(*ld));
+	*ld = (dns_loaddiff_t){
+		.changes = ISC_LIST_INITIALIZER,
+		.magic = DNS_LOADDIFF_MAGIC,
+	};
+	isc_mem_attach(mctx, &ld->mctx);
+	dns_db_attach(db, &ld->db);
+	dns_db_attach(loaddb, &ld->loaddb);
+	dns_db_currentversion(db, &ld->ver);
+	dns_fixedname_init(&ld->fname);
+
+	for (size_t i = 0; i < ARRAY_SIZE(ld->trees); i++) {
+		loaddiff_tree_t *tree = &ld->trees[i];
+
+		dns_fixedname_init(&tree->fcurrent);
+		dns_fixedname_init(&tree->fprev);
+
+		result = dns_db_createiterator(db, options[i], &tree->dbit);
+		if (result != ISC_R_SUCCESS) {
+			dns_loaddiff_destroy(&ld);
+			return (result);
+		}
+
+		tree->result = dns_dbiterator_first(tree->dbit);
+		if (tree->result == ISC_R_SUCCESS) {
+			tree->result = dns_dbiterator_current(
+				tree->dbit, &tree->node,
+				dns_fixedname_name(&tree->fcurrent));
+		}
+		if (tree->result != ISC_R_SUCCESS &&
+		    tree->result != ISC_R_NOMORE)
+		{
+			ld->failed = true;
+		}
+		(void)dns_dbiterator_pause(tree->dbit);
+	}
+
+	*ldp = ld;
+
+	return (ISC_R_SUCCESS);
+}
+
+void
+dns_loaddiff_callbacks(dns_loaddiff_t *ld,
+		       const dns_rdatacallbacks_t *dbcallbacks,
+		       dns_rdatacallbacks_t *callbacks) {
+	REQUIRE(DNS_LOADDIFF_VALID(ld));
+	REQUIRE(DNS_CALLBACK_VALID(dbcallbacks));
+	REQUIRE(dbcallbacks->add != NULL);
+	REQUIRE(callbacks != NULL);
+
+	ld->add = dbcallbacks->add;
+	ld->add_private = dbcallbacks->add_private;
+
+	*callbacks = *dbcallbacks;
+	callbacks->add = loaddiff_add;
+	callbacks->add_private = ld;
+}
+
+bool
+dns_loaddiff_current(dns_loaddiff_t *ld, dns_db_t *db, dns_db_t *loaddb) {
+	dns_dbversion_t *ver = NULL;
+	bool current;
+
+	REQUIRE(DNS_LOADDIFF_VALID(ld));
+
+	if (db != ld->db || loaddb != ld->loaddb) {
+		return (false);
+	}
+
+	dns_db_currentversion(db, &ver);
+	current = (ver == ld->ver);
+	dns_db_closeversion(db, &ver, false);
+
+	return (current);
+}
+
+static int
+change_order(const void *av, const void *bv) {
+	loaddiff_name_t const *const *ap = av;
+	loaddiff_name_t const *const *bp = bv;
+	loaddiff_name_t const *a = *ap;
+	loaddiff_name_t const *b = *bp;
+
+	if (a->nsec3 != b->nsec3) {
+		return (a->nsec3 ? 1 : -1);
+	}
+	return (dns_name_compare(&a->name, &b->name));
+}
+
+static isc_result_t
+get_change_diff(dns_db_t *db, dns_dbversion_t *ver, loaddiff_name_t *change,
+		dns_diffop_t op, dns_diff_t *diff) {
+	isc_result_t result;
+	dns_dbnode_t *node = NULL;
+
+	if (change->nsec3) {
+		result = dns_db_findnsec3node(db, &change->name, false, &node);
+	} else {
+		result = dns_db_findnode(db, &change->name, false, &node);
+	}
+	if (result == ISC_R_NOTFOUND) {
+		return (ISC_R_SUCCESS);
+	} else if (result != ISC_R_SUCCESS) {
+		return (result);
+	}
+
+	result = get_node_diff(db, ver, 0, node, &change->name, op, diff);
+
+	dns_db_detachnode(db, &node);
+
+	return (result);
+}
+
+static uint64_t
+diff_count(dns_diff_t *diff) {
+	uint64_t count = 0;
+
+	for (dns_difftuple_t *t = ISC_LIST_HEAD(diff->tuples); t != NULL;
+	     t = ISC_LIST_NEXT(t, link))
+	{
+		count++;
+	}
+
+	return (count);
+}
+
+/*
+ * Compare the old and new records at each of the changed names only.
+ * This is only the complete diff if the records at the unchanged and
+ * changed names account for every record in both databases; if not,
+ * ISC_R_NOTFOUND is returned.
+ */
+static isc_result_t
+loaddiff_changes(dns_loaddiff_t *ld, dns_db_t *db, dns_dbversion_t *ver,
+		 dns_diff_t *resultdiff) {
+	isc_result_t result;
+	loaddiff_name_t **changes = NULL;
+	uint64_t oldrecords = 0, newrecords = 0;
+	uint64_t oldcount = ld->unchanged, newcount = ld->unchanged;
+	dns_diff_t diff[2];
+	size_t i = 0;
+
+	if (ld->failed) {
+		return (ISC_R_NOTFOUND);
+	}
+
+	result = dns_db_getsize(ld->db, ld->ver, &oldrecords, NULL);
+	if (result != ISC_R_SUCCESS) {
+		return (result);
+	}
+	result = dns_db_getsize(db, ver, &newrecords, NULL);
+	if (result != ISC_R_SUCCESS) {
+		return (result);
+	}
+
+	dns_diff_init(resultdiff->mctx, &diff[0]);
+	dns_diff_init(resultdiff->mctx, &diff[1]);
+
+	if (ld->nchanges > 0) {
+		changes = isc_mem_cget(ld->mctx, ld->nchanges,
+				       sizeof(changes[0]));
+		for (loaddiff_name_t *change = ISC_LIST_HEAD(ld->changes);
+		     change != NULL; change = ISC_LIST_NEXT(change, link))
+		{
+			changes[i++] = change;
+		}
+		qsort(changes, ld->nchanges, sizeof(changes[0]),
+		      change_order);
+	}
+
+	for (i = 0; i < ld->nchanges; i++) {
+		if (i > 0 && change_order(&changes[i - 1], &changes[i]) == 0) {
+			continue;
+		}
+
+		CHECK(get_change_diff(db, ver, changes[i], DNS_DIFFOP_ADD,
+				      &diff[0]));
+		CHECK(get_change_diff(ld->db, ld->ver, changes[i],
+				      DNS_DIFFOP_DEL, &diff[1]));
+		newcount += diff_count(&diff[0]);
+		oldcount += diff_count(&diff[1]);
+		CHECK(dns_diff_subtract(diff, resultdiff));
+	}
+
+	isc_log_write(JOURNAL_DEBUG_LOGARGS(3),
+		      "compared %zu changed names: %" PRIu64 "/%" PRIu64
+		      " old records, %" PRIu64 "/%" PRIu64 " new records",
+		      ld->nchanges, oldcount, oldrecords, newcount, newrecords);
+
+	if (oldcount != oldrecords || newcount != newrecords) {
+		FAIL(ISC_R_NOTFOUND);
+	}
+
+failure:
+	if (changes != NULL) {
+		isc_mem_cput(ld->mctx, changes, ld->nchanges,
+			     sizeof(changes[0]));
+	}
+	dns_diff_clear(&diff[0]);
+	dns_diff_clear(&diff[1]);
+	return (result);
+}
+
+isc_result_t
+dns_loaddiff_diff(dns_loaddiff_t **ldp, dns_diff_t *diff, dns_db_t *db,
+		  dns_dbversion_t *ver, const char *filename) {
+	dns_loaddiff_t *ld = NULL;
+	dns_journal_t *journal = NULL;
+	isc_result_t result;
+	dns_diff_t changes;
+
+	REQUIRE(ldp != NULL && DNS_LOADDIFF_VALID(*ldp));
+	REQUIRE(DNS_DIFF_VALID(diff));
+
+	ld = *ldp;
+	*ldp = NULL;
+
+	REQUIRE(db == ld->loaddb);
+
+	loaddiff_endname(ld);
+	for (size_t i = 0; i < ARRAY_SIZE(ld->trees); i++) {
+		if (!ld->trees[i].unsorted) {
+			(void)loaddiff_skip(ld, &ld->trees[i], NULL);
+		}
+	}
+
+	dns_diff_init(diff->mctx, &changes);
+	result = loaddiff_changes(ld, db, ver, &changes);
+	if (result == ISC_R_SUCCESS) {
+		ISC_LIST_APPENDLIST(diff->tuples, changes.tuples, link);
+	}
+	dns_diff_clear(&changes);
+
+	if (result != ISC_R_SUCCESS) {
+		/*
+		 * The changed names do not account for every record,
+		 * e.g. because names were removed while others were
+		 * loaded out of order: compare the databases in full.
+		 */
+		isc_log_write(JOURNAL_DEBUG_LOGARGS(1),
+			      "unable to diff the loaded zone by name (%s): "
+			      "comparing all names",
+			      isc_result_totext(result));
+		result = dns_db_diffx(diff, db, ver, ld->db, ld->ver,
+				      filename);
+		goto cleanup;
+	}
+
+	if (filename != NULL) {
+		CHECK(dns_journal_open(diff->mctx, filename,
+				       DNS_JOURNAL_CREATE, &journal));
+		if (ISC_LIST_EMPTY(diff->tuples)) {
+			isc_log_write(JOURNAL_DEBUG_LOGARGS(3), "no changes");
+		} else {
+			CHECK(dns_journal_write_transaction(journal, diff));
+		}
+	}
+
+failure:
+	if (journal != NULL) {
+		dns_journal_destroy(&journal);
+	}
+
+cleanup:
+	dns_loaddiff_destroy(&ld);
+	return (result);
+}
+
+void
+dns_loaddiff_destroy(dns_loaddiff_t **ldp) {
+	dns_loaddiff_t *ld = NULL;
+	loaddiff_name_t *change = NULL;
+
+	REQUIRE(ldp != NULL && DNS_LOADDIFF_VALID(*ldp));
+
+	ld = *ldp;
+	*ldp = NULL;
+
+	ld->magic = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(ld->trees); i++) {
+		loaddiff_tree_t *tree = &ld->trees[i];
+
+		if (tree->node != NULL) {
+			dns_db_detachnode(ld->db, &tree->node);
+		}
+		if (tree->dbit != NULL) {
+			dns_dbiterator_destroy(&tree->dbit);
+		}
+	}
+	if (ld->node != NULL) {
+		dns_db_detachnode(ld->db, &ld->node);
+	}
+
+	while ((change = ISC_LIST_HEAD(ld->changes)) != NULL) {
+		ISC_LIST_UNLINK(ld->changes, change, link);
+		dns_name_free(&change->name, ld->mctx);
+		isc_mem_put(ld->mctx, change, sizeof(*change));
+	}
+
+	dns_db_closeversion(ld->db, &ld->ver, false);
+	dns_db_detach(&ld->loaddb);
+	dns_db_detach(&ld->db);
+	isc_mem_putanddetach(&ld->mctx, ld, sizeof(*ld));
+}
+
+static uint32_t
+rrcount(unsigned char *buf, unsigned int size) {
+	isc_buffer_t b;
+	uint32_t rrsize, count = 0;
+
+	isc_buffer_init(&b, buf, size);
+	isc_buffer_add(&b, size);
+	while (isc_buffer_remaininglength(&b) > 0) {
+		rrsize = isc_buffer_getuint32(&b);
+		INSIST(isc_buffer_remaininglength(&b) >= rrsize);
+		isc_buffer_forward(&b, rrsize);
+		count++;
+	}
+
+	return (count);
+}
+
+static bool
+check_delta(unsigned char *buf, size_t size) {
+	isc_buffer_t b;
+	uint32_t rrsize;
+
+	isc_buffer_init(&b, buf, size);
+	isc_buffer_add(&b, size);
+	while (isc_buffer_remaininglength(&b) > 0) {
+		if (isc_buffer_remaininglength(&b) < 4) {
+			return (false);
+		}
+		rrsize = isc_buffer_getuint32(&b);
+		/* "." + type + class + ttl + rdlen => 11U */
+		if (rrsize < 11U || isc_buffer_remaininglength(&b) < rrsize) {
+			return (false);
+		}
+		isc_buffer_forward(&b, rrsize);
+	}
+
+	return (true);
+}
+
+/*
+ * Names of the new journal written while compacting 'filename', and of
+ * the backup of the old journal used if it cannot be replaced atomically.
+ */
+static void
+compact_names(const char *filename, char newname[PATH_MAX],
+	      char backup[PATH_MAX]) {
+	size_t namelen;
+	int n;
+
+	namelen = strlen(filename);
+	if (namelen > 4U && strcmp(filename + namelen - 4, ".jnl") == 0) {
+		namelen -= 4;
+	}
+
+	n = snprintf(newname, PATH_MAX, "%.*s.jnw", (int)namelen, filename);
+	RUNTIME_CHECK(n >= 0 && (size_t)n < PATH_MAX);
+
+	n = snprintf(backup, PATH_MAX, "%.*s.jbk", (int)namelen, filename);
+	RUNTIME_CHECK(n >= 0 && (size_t)n < PATH_MAX);
+}
+
+/*
+ * Cope with very small target sizes, and return the end of the header
+ * and index of 'j' in '*indexendp'.
+ */
+static uint32_t
+compact_target(dns_journal_t *j, uint32_t target_size,
+	       unsigned int *indexendp) {
+	unsigned int indexend;
+
+	indexend = sizeof(journal_rawheader_t) +
+		   ISC_CHECKED_MUL(j->header.index_size,
+				   sizeof(journal_rawpos_t));
+	if (target_size < DNS_JOURNAL_SIZE_MIN) {
+		target_size = DNS_JOURNAL_SIZE_MIN;
+	}
+	if (target_size < indexend * 2) {
+		target_size = target_size / 2 + indexend;
+	}
+
+	*indexendp = indexend;
+	return (target_size);
+}
+
+/*
+ * Find the first transaction of 'j1' to keep: the latest one, no later
+ * than 'serial', that leaves at least half of 'target_size' in the
+ * journal.
+ */
+static isc_result_t
+compact_start(dns_journal_t *j1, uint32_t serial, uint32_t target_size,
+	      journal_pos_t *posp) {
+	isc_result_t result;
+	journal_pos_t best_guess;
+	journal_pos_t current_pos;
+
+	/*
+	 * Find if we can create enough free space.
+	 */
+	best_guess = j1->header.begin;
+	for (unsigned int i = 0; i < j1->header.index_size; i++) {
+		if (POS_VALID(j1->index[i]) &&
+		    DNS_SERIAL_GE(serial, j1->index[i].serial) &&
+		    ((uint32_t)(j1->header.end.offset - j1->index[i].offset) >=
+		     target_size / 2) &&
+		    j1->index[i].offset > best_guess.offset)
+		{
+			best_guess = j1->index[i];
+		}
+	}
+
+	current_pos = best_guess;
+	while (current_pos.serial != serial) {
+		CHECK(journal_next(j1, &current_pos));
+		if (current_pos.serial == j1->header.end.serial) {
+			break;
+		}
+
+		if (DNS_SERIAL_GE(serial, current_pos.serial) &&
+		    ((uint32_t)(j1->header.end.offset - current_pos.offset) >=
+		     (target_size / 2)) &&
+		    current_pos.offset > best_guess.offset)
+		{
+			best_guess = current_pos;
+		} else {
+			break;
+		}
+	}
+
+	INSIST(best_guess.serial != j1->header.end.serial);
+	if (best_guess.serial != serial) {
+		CHECK(journal_next(j1, &best_guess));
+	}
+
+	*posp = best_guess;
+	result = ISC_R_SUCCESS;
+
+failure:
+	return (result);
+}
+
+/*
+ * Copy 'len' bytes from the current position in 'j1' to 'j2', without
+ * parsing the transactions.
+ */
+static isc_result_t
+compact_copy(isc_mem_t *mctx, dns_journal_t *j1, dns_journal_t *j2,
+	     uint32_t len) {
+	isc_result_t result = ISC_R_SUCCESS;
+	unsigned char *buf = NULL;
+	unsigned int size;
+
+	if (len == 0) {
+		return (ISC_R_SUCCESS);
+	}
+
+	size = ISC_MIN(64 * 1024, len);
+	buf = isc_mem_get(mctx, size);
+	for (uint32_t i = 0; i < len; i += size) {
+		unsigned int blob = ISC_MIN(size, len - i);
+		CHECK(journal_read(j1, buf, blob));
+		CHECK(journal_write(j2, buf, blob));
+	}
+
+failure:
+	isc_mem_put(mctx, buf, size);
+	return (result);
+}
+
+/*
+ * Write the header and the index of the new journal 'j2' once all of its
+ * transactions have been written.
+ */
+static isc_result_t
+compact_index(dns_journal_t *j2) {
+	isc_result_t result;
+	journal_rawheader_t rawheader;
+	journal_pos_t current_pos;
+
+	CHECK(journal_fsync(j2));
+
+	/*
+	 * Update the journal header.
+	 */
+	journal_header_encode(&j2->header, &rawheader);
+	CHECK(journal_seek(j2, 0));
+	CHECK(journal_write(j2, &rawheader, sizeof(rawheader)));
+	CHECK(journal_fsync(j2));
+
+	/*
+	 * Build new index.
+	 */
+	current_pos = j2->header.begin;
+	while (current_pos.serial != j2->header.end.serial) {
+		index_add(j2, &current_pos);
+		CHECK(journal_next(j2, &current_pos));
+	}
+
+	/*
+	 * Write index.
+	 */
+	CHECK(index_to_disk(j2));
+	CHECK(journal_fsync(j2));
+
+failure:
+	return (result);
+}
+
+/*
+ * Replace the journal 'filename' with the compacted journal 'newname'.
+ */
+static isc_result_t
+compact_rename(const char *filename, const char *newname, const char *backup,
+	       bool is_backup) {
+	isc_result_t result;
+
+	/*
+	 * With a UFS file system this should just succeed and be atomic.
+	 * Any IXFR outs will just continue and the old journal will be
+	 * removed on final close.
+	 *
+	 * With MSDOS / NTFS we need to do a two stage rename, triggered
+	 * by EEXIST.  (If any IXFR's are running in other threads, however,
+	 * this will fail, and the journal will not be compacted.  But
+	 * if so, hopefully they'll be finished by the next time we
+	 * compact.)
+	 */
+	if (rename(newname, filename) == -1) {
+		if (errno == EEXIST && !is_backup) {
+			result = isc_file_remove(backup);
+			if (result != ISC_R_SUCCESS &&
+			    result != ISC_R_FILENOTFOUND)
+			{
+				return (result);
+			}
+			if (rename(filename, backup) == -1) {
+				return (ISC_R_FAILURE);
+			}
+			if (rename(newname, filename) == -1) {
+				return (ISC_R_FAILURE);
+			}
+			(void)isc_file_remove(backup);
+		} else {
+			return (ISC_R_FAILURE);
+		}
+	}
+
+	return (ISC_R_SUCCESS);
+}
+
+isc_result_t
+dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
+		    uint32_t flags, uint32_t target_size) {
+	journal_pos_t best_guess;
+	dns_journal_t *j1 = NULL;
+	dns_journal_t *j2 = NULL;
+	unsigned int len;
+	unsigned char *buf = NULL;
+	unsigned int size = 0;
+	isc_result_t result;
+	unsigned int indexend;
+	char newname[PATH_MAX];
+	char backup[PATH_MAX];
+	bool is_backup = false;
+	bool rewrite = false;
+	bool downgrade = false;
+
+	REQUIRE(filename != NULL);
+
+	compact_names(filename, newname, backup);
 
 	result = journal_open(mctx, filename, false, false, false, &j1);
 	if (result == ISC_R_NOTFOUND) {
@@ -2531,18 +3706,7 @@ dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
 		return (ISC_R_RANGE);
 	}
 
-	/*
-	 * Cope with very small target sizes.
-	 */
-	indexend = sizeof(journal_rawheader_t) +
-		   ISC_CHECKED_MUL(j1->header.index_size,
-				   sizeof(journal_rawpos_t));
-	if (target_size < DNS_JOURNAL_SIZE_MIN) {
-		target_size = DNS_JOURNAL_SIZE_MIN;
-	}
-	if (target_size < indexend * 2) {
-		target_size = target_size / 2 + indexend;
-	}
+	target_size = compact_target(j1, target_size, &indexend);
 
 	/*
 	 * See if there is any work to do.
@@ -2562,44 +3726,8 @@ dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
 		target_size -= indexend;
 	}
 
-	/*
-	 * Find if we can create enough free space.
-	 */
-	best_guess = j1->header.begin;
-	for (i = 0; i < j1->header.index_size; i++) {
-		if (POS_VALID(j1->index[i]) &&
-		    DNS_SERIAL_GE(serial, j1->index[i].serial) &&
-		    ((uint32_t)(j1->header.end.offset - j1->index[i].offset) >=
-		     target_size / 2) &&
-		    j1->index[i].offset > best_guess.offset)
-		{
-			best_guess = j1->index[i];
-		}
-	}
-
-	current_pos = best_guess;
-	while (current_pos.serial != serial) {
-		CHECK(journal_next(j1, &current_pos));
-		if (current_pos.serial == j1->header.end.serial) {
-			break;
-		}
-
-		if (DNS_SERIAL_GE(serial, current_pos.serial) &&
-		    ((uint32_t)(j1->header.end.offset - current_pos.offset) >=
-		     (target_size / 2)) &&
-		    current_pos.offset > best_guess.offset)
-		{
-			best_guess = current_pos;
-		} else {
-			break;
-		}
-	}
-
-	INSIST(best_guess.serial != j1->header.end.serial);
-	if (best_guess.serial != serial) {
-		CHECK(journal_next(j1, &best_guess));
-		serial = best_guess.serial;
-	}
+	CHECK(compact_start(j1, serial, target_size, &best_guess));
+	serial = best_guess.serial;
 
 	/*
 	 * We should now be roughly half target_size provided
@@ -2735,44 +3863,11 @@ dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
 		 * this faster method instead.
 		 */
 		if (!rewrite) {
-			size = ISC_MIN(64 * 1024, len);
-			buf = isc_mem_get(mctx, size);
-			for (i = 0; i < len; i += size) {
-				unsigned int blob = ISC_MIN(size, len - i);
-				CHECK(journal_read(j1, buf, blob));
-				CHECK(journal_write(j2, buf, blob));
-			}
-
+			CHECK(compact_copy(mctx, j1, j2, len));
 			j2->header.end.offset = indexend + len;
 		}
 
-		CHECK(journal_fsync(j2));
-
-		/*
-		 * Update the journal header.
-		 */
-		journal_header_encode(&j2->header, &rawheader);
-		CHECK(journal_seek(j2, 0));
-		CHECK(journal_write(j2, &rawheader, sizeof(rawheader)));
-		CHECK(journal_fsync(j2));
-
-		/*
-		 * Build new index.
-		 */
-		current_pos = j2->header.begin;
-		while (current_pos.serial != j2->header.end.serial) {
-			index_add(j2, &current_pos);
-			CHECK(journal_next(j2, &current_pos));
-		}
-
-		/*
-		 * Write index.
-		 */
-		CHECK(index_to_disk(j2));
-		CHECK(journal_fsync(j2));
-
-		indexend = j2->header.end.offset;
-		POST(indexend);
+		CHECK(compact_index(j2));
 	}
 
 	/*
@@ -2781,38 +3876,7 @@ dns_journal_compact(isc_mem_t *mctx, char *filename, uint32_t serial,
 	dns_journal_destroy(&j1);
 	dns_journal_destroy(&j2);
 
-	/*
-	 * With a UFS file system this should just succeed and be atomic.
-	 * Any IXFR outs will just continue and the old journal will be
-	 * removed on final close.
-	 *
-	 * With MSDOS / NTFS we need to do a two stage rename, triggered
-	 * by EEXIST.  (If any IXFR's are running in other threads, however,
-	 * this will fail, and the journal will not be compacted.  But
-	 * if so, hopefully they'll be finished by the next time we
-	 * compact.)
-	 */
-	if (rename(newname, filename) == -1) {
-		if (errno == EEXIST && !is_backup) {
-			result = isc_file_remove(backup);
-			if (result != ISC_R_SUCCESS &&
-			    result != ISC_R_FILENOTFOUND)
-			{
-				goto failure;
-			}
-			if (rename(filename, backup) == -1) {
-				goto maperrno;
-			}
-			if (rename(newname, filename) == -1) {
-				goto maperrno;
-			}
-			(void)isc_file_remove(backup);
-		} else {
-		maperrno:
-			result = ISC_R_FAILURE;
-			goto failure;
-		}
-	}
+	CHECK(compact_rename(filename, newname, backup, is_backup));
 
 	result = ISC_R_SUCCESS;
 
@@ -2830,6 +3894,237 @@ failure:
 	return (result);
 }
 
+/*
+ * Background compaction.
+ */
+
+struct dns_journalcompact {
+	unsigned int magic; /*%< JCMP */
+	isc_mem_t *mctx;
+	char *filename;
+	char newname[PATH_MAX];
+	char backup[PATH_MAX];
+	dev_t dev;		    /*%< Device and inode of the journal */
+	ino_t ino;		    /*%< being compacted */
+	dns_journal_t *j2;	    /*%< The new journal */
+	journal_pos_t copied;	    /*%< End of the part copied so far */
+	journal_pos_t begin;	    /*%< Start and end of the transactions */
+	journal_pos_t end;	    /*%< in the new journal so far */
+	isc_nanosecs_t start;	    /*%< When compaction began */
+};
+
+#define DNS_JOURNALCOMPACT_MAGIC    ISC_MAGIC('J', 'C', 'M', 'P')
+#define DNS_JOURNALCOMPACT_VALID(c) ISC_MAGIC_VALID(c, DNS_JOURNALCOMPACT_MAGIC)
+
+static isc_result_t
+compact_fileid(dns_journal_t *j, dev_t *devp, ino_t *inop) {
+	struct stat sb;
+
+	if (fstat(fileno(j->fp), &sb) != 0) {
+		return (isc_errno_toresult(errno));
+	}
+	*devp = sb.st_dev;
+	*inop = sb.st_ino;
+	return (ISC_R_SUCCESS);
+}
+
+static void
+compact_free(dns_journalcompact_t *jc) {
+	if (jc->j2 != NULL) {
+		dns_journal_destroy(&jc->j2);
+	}
+	(void)isc_file_remove(jc->newname);
+	jc->magic = 0;
+	isc_mem_free(jc->mctx, jc->filename);
+	isc_mem_putanddetach(&jc->mctx, jc, sizeof(*jc));
+}
+
+isc_result_t
+dns_journal_compact_begin(isc_mem_t *mctx, const char *filename,
+			  uint32_t serial, uint32_t target_size,
+			  dns_journalcompact_t **jcp) {
+	isc_result_t result;
+	dns_journalcompact_t *jc = NULL;
+	dns_journal_t *j1 = NULL;
+	journal_pos_t best_guess;
+	unsigned int indexend;
+	uint32_t len;
+
+	REQUIRE(filename != NULL);
+	REQUIRE(jcp != NULL && *jcp == NULL);
+
+	jc = isc_mem_get(mctx, sizeof(*jc));
+	*jc = (dns_journalcompact_t){
+		.magic = DNS_JOURNALCOMPACT_MAGIC,
+		.filename = isc_mem_strdup(mctx, filename),
+		.start = isc_time_monotonic(),
+	};
+	isc_mem_attach(mctx, &jc->mctx);
+	compact_names(filename, jc->newname, jc->backup);
+
+	CHECK(journal_open(mctx, filename, false, false, false, &j1));
+
+	/*
+	 * Journals that have to be repaired while they are copied are
+	 * left to dns_journal_compact().
+	 */
+	if (j1->header_ver1) {
+		FAIL(ISC_R_NOTIMPLEMENTED);
+	}
+
+	if (JOURNAL_EMPTY(&j1->header)) {
+		FAIL(ISC_R_SUCCESS);
+	}
+
+	if (DNS_SERIAL_GT(j1->header.begin.serial, serial) ||
+	    DNS_SERIAL_GT(serial, j1->header.end.serial))
+	{
+		FAIL(ISC_R_RANGE);
+	}
+
+	target_size = compact_target(j1, target_size, &indexend);
+	if ((uint32_t)j1->header.end.offset < target_size) {
+		FAIL(ISC_R_SUCCESS);
+	}
+
+	CHECK(compact_fileid(j1, &jc->dev, &jc->ino));
+
+	/*
+	 * Don't append to whatever an earlier, interrupted compaction
+	 * may have left behind.
+	 */
+	(void)isc_file_remove(jc->newname);
+	CHECK(journal_open(mctx, jc->newname, true, true, false, &jc->j2));
+	CHECK(journal_seek(jc->j2, indexend));
+
+	if (target_size >= indexend) {
+		target_size -= indexend;
+	}
+	CHECK(compact_start(j1, serial, target_size, &best_guess));
+
+	/*
+	 * Copy the transactions that are kept, as far as the end of the
+	 * journal as it is now.  Any added while this is running are
+	 * copied by dns_journal_compact_finish().
+	 */
+	len = j1->header.end.offset - best_guess.offset;
+	CHECK(journal_seek(j1, best_guess.offset));
+	CHECK(compact_copy(mctx, j1, jc->j2, len));
+
+	jc->copied = j1->header.end;
+	jc->begin.serial = best_guess.serial;
+	jc->begin.offset = indexend;
+	jc->end.serial = j1->header.end.serial;
+	jc->end.offset = indexend + len;
+
+	dns_journal_destroy(&j1);
+
+	*jcp = jc;
+	return (ISC_R_SUCCESS);
+
+failure:
+	if (j1 != NULL) {
+		dns_journal_destroy(&j1);
+	}
+	compact_free(jc);
+	return (result);
+}
+
+isc_result_t
+dns_journal_compact_finish(dns_journalcompact_t **jcp,
+			   isc_nanosecs_t *elapsedp) {
+	isc_result_t result;
+	dns_journalcompact_t *jc = NULL;
+	dns_journal_t *j1 = NULL;
+	journal_xhdr_t xhdr;
+	dev_t dev;
+	ino_t ino;
+	uint32_t len;
+
+	REQUIRE(jcp != NULL && DNS_JOURNALCOMPACT_VALID(*jcp));
+
+	jc = *jcp;
+	*jcp = NULL;
+
+	CHECK(journal_open(jc->mctx, jc->filename, false, false, false, &j1));
+
+	/*
+	 * If the journal has been replaced since the copy was made, the
+	 * copy is of no use.
+	 */
+	CHECK(compact_fileid(j1, &dev, &ino));
+	if (dev != jc->dev || ino != jc->ino) {
+		FAIL(ISC_R_CANCELED);
+	}
+
+	/*
+	 * Copy the transactions added since, checking that they follow
+	 * on from the ones already copied.
+	 */
+	len = j1->header.end.offset - jc->copied.offset;
+	if (j1->header.end.offset < jc->copied.offset ||
+	    (len == 0 && j1->header.end.serial != jc->copied.serial))
+	{
+		FAIL(ISC_R_CANCELED);
+	}
+	if (len != 0) {
+		CHECK(journal_seek(j1, jc->copied.offset));
+		CHECK(journal_read_xhdr(j1, &xhdr));
+		if (xhdr.serial0 != jc->copied.serial) {
+			FAIL(ISC_R_CANCELED);
+		}
+		CHECK(journal_seek(j1, jc->copied.offset));
+		CHECK(journal_seek(jc->j2, jc->end.offset));
+		CHECK(compact_copy(jc->mctx, j1, jc->j2, len));
+		jc->end.serial = j1->header.end.serial;
+		jc->end.offset += len;
+	}
+
+	/*
+	 * As with dns_journal_compact(), a new journal with no
+	 * transactions in it keeps the header it was created with.
+	 */
+	if (jc->end.offset != jc->begin.offset) {
+		jc->j2->header.begin = jc->begin;
+		jc->j2->header.end = jc->end;
+		jc->j2->header.sourceserial = j1->header.sourceserial;
+		jc->j2->header.serialset = j1->header.serialset;
+		CHECK(compact_index(jc->j2));
+	}
+
+	/*
+	 * Close both journals before trying to rename files.
+	 */
+	dns_journal_destroy(&j1);
+	dns_journal_destroy(&jc->j2);
+
+	CHECK(compact_rename(jc->filename, jc->newname, jc->backup, false));
+
+	if (elapsedp != NULL) {
+		*elapsedp = isc_time_monotonic() - jc->start;
+	}
+	result = ISC_R_SUCCESS;
+
+failure:
+	if (j1 != NULL) {
+		dns_journal_destroy(&j1);
+	}
+	compact_free(jc);
+	return (result);
+}
+
+void
+dns_journal_compact_cancel(dns_journalcompact_t **jcp) {
+	dns_journalcompact_t *jc = NULL;
+
+	REQUIRE(jcp != NULL && DNS_JOURNALCOMPACT_VALID(*jcp));
+
+	jc = *jcp;
+	*jcp = NULL;
+
+	compact_free(jc);
+}
+
 static isc_result_t
 index_to_disk(dns_journal_t *j) {
 	isc_result_t result = ISC_R_SUCCESS;
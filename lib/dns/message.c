@@ -395,6 +395,10 @@ msginitprivate(dns_message_t *m) {
 	m->padding = 0;
 	m->padding_off = 0;
 	m->buffer = NULL;
+	m->lazy_pending = 0;
+	m->lazy_offset = 0;
+	m->lazy_additional = 0;
+	m->lazy_options = 0;
 }
 
 static void
@@ -1606,6 +1610,173 @@ cleanup:
 	return (result);
 }
 
+/*
+ * Step over a possibly compressed owner name without decompressing it:
+ * the labels up to the root or the first compression pointer must fit
+ * in the buffer and must not exceed the maximum wire length of a name.
+ * Compression pointers are not followed; their targets are checked when
+ * the section is built.
+ */
+static isc_result_t
+skipname(isc_buffer_t *source) {
+	unsigned char *cp = isc_buffer_current(source);
+	unsigned int length = isc_buffer_remaininglength(source);
+	unsigned int used = 0, wirelen = 0;
+
+	for (;;) {
+		unsigned int c;
+
+		if (used >= length) {
+			return (ISC_R_UNEXPECTEDEND);
+		}
+		c = cp[used];
+		if (c >= 192) {
+			if (used + 2 > length) {
+				return (ISC_R_UNEXPECTEDEND);
+			}
+			used += 2;
+			break;
+		}
+		if (c >= 64) {
+			return (DNS_R_BADLABELTYPE);
+		}
+		used += c + 1;
+		wirelen += c + 1;
+		if (wirelen > DNS_NAME_MAXWIRE) {
+			return (DNS_R_NAMETOOLONG);
+		}
+		if (c == 0) {
+			break;
+		}
+	}
+
+	isc_buffer_forward(source, used);
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Walk the records of section 'sectionid' checking only that they are
+ * correctly framed: the owner name is well formed, the type, class, TTL
+ * and rdata length are present and the rdata fits in the message.
+ * Nothing is allocated and no name is decompressed.
+ *
+ * In the additional section, OPT, TSIG and SIG records are the ones
+ * getsection() has to see during the parse; they normally come last,
+ * so '*specialp' is set to the index of the first record of the
+ * trailing run of such records ('count' if there are none) and
+ * '*specialoffp' to its offset.
+ *
+ * '*deferrablep' is set to false if a record is found that getsection()
+ * would treat specially or reject, or if an OPT, TSIG or SIG record is
+ * followed by any other record, so that the caller can fall back to a
+ * full parse and report the same error.
+ */
+static isc_result_t
+skipsection(isc_buffer_t *source, dns_message_t *msg, dns_section_t sectionid,
+	    unsigned int *specialp, unsigned int *specialoffp,
+	    bool *deferrablep) {
+	isc_region_t r;
+	isc_result_t result;
+	dns_rdatatype_t rdtype;
+	dns_rdataclass_t rdclass;
+	unsigned int count, rdatalen, recstart;
+	unsigned int special = msg->counts[sectionid];
+	unsigned int specialoff = 0;
+
+	for (count = 0; count < msg->counts[sectionid]; count++) {
+		recstart = source->current;
+		result = skipname(source);
+		if (result != ISC_R_SUCCESS) {
+			return (result);
+		}
+
+		isc_buffer_remainingregion(source, &r);
+		if (r.length < 2 + 2 + 4 + 2) {
+			return (ISC_R_UNEXPECTEDEND);
+		}
+		rdtype = isc_buffer_getuint16(source);
+		rdclass = isc_buffer_getuint16(source);
+		isc_buffer_forward(source, 4);
+		rdatalen = isc_buffer_getuint16(source);
+		r.length -= (2 + 2 + 4 + 2);
+		if (r.length < rdatalen) {
+			return (ISC_R_UNEXPECTEDEND);
+		}
+		isc_buffer_forward(source, rdatalen);
+
+		if (sectionid == DNS_SECTION_ADDITIONAL &&
+		    (rdtype == dns_rdatatype_opt ||
+		     rdtype == dns_rdatatype_tsig ||
+		     rdtype == dns_rdatatype_sig))
+		{
+			if (special == msg->counts[sectionid]) {
+				special = count;
+				specialoff = recstart;
+			}
+			continue;
+		}
+
+		if (special != msg->counts[sectionid] ||
+		    rdclass != msg->rdclass || rdtype == dns_rdatatype_sig ||
+		    dns_rdatatype_ismeta(rdtype))
+		{
+			*deferrablep = false;
+			return (ISC_R_SUCCESS);
+		}
+	}
+
+	if (specialp != NULL) {
+		*specialp = special;
+		*specialoffp = (special == count) ? source->current
+						  : specialoff;
+	}
+
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Build the sections of a message that were deferred by
+ * DNS_MESSAGEPARSE_LAZY, using the saved copy of the wire data: the
+ * answer and authority sections and the records of the additional
+ * section that precede any OPT, TSIG or SIG(0).
+ */
+static isc_result_t
+getdeferred(dns_message_t *msg) {
+	isc_buffer_t source;
+	isc_result_t result;
+	unsigned int arcount;
+
+	if (msg->lazy_pending == 0) {
+		return (ISC_R_SUCCESS);
+	}
+
+	INSIST(msg->saved.base != NULL);
+	INSIST(msg->lazy_offset <= msg->saved.length);
+	INSIST(msg->lazy_additional <= msg->counts[DNS_SECTION_ADDITIONAL]);
+
+	msg->lazy_pending = 0;
+
+	isc_buffer_init(&source, msg->saved.base, msg->saved.length);
+	isc_buffer_add(&source, msg->saved.length);
+	isc_buffer_forward(&source, msg->lazy_offset);
+
+	result = getsection(&source, msg, DNS_DECOMPRESS_ALWAYS,
+			    DNS_SECTION_ANSWER, msg->lazy_options);
+	if (result == ISC_R_SUCCESS) {
+		result = getsection(&source, msg, DNS_DECOMPRESS_ALWAYS,
+				    DNS_SECTION_AUTHORITY, msg->lazy_options);
+	}
+	if (result == ISC_R_SUCCESS) {
+		arcount = msg->counts[DNS_SECTION_ADDITIONAL];
+		msg->counts[DNS_SECTION_ADDITIONAL] = msg->lazy_additional;
+		result = getsection(&source, msg, DNS_DECOMPRESS_ALWAYS,
+				    DNS_SECTION_ADDITIONAL, msg->lazy_options);
+		msg->counts[DNS_SECTION_ADDITIONAL] = arcount;
+	}
+
+	return (result);
+}
+
 isc_result_t
 dns_message_parse(dns_message_t *msg, isc_buffer_t *source,
 		  unsigned int options) {
@@ -1616,6 +1787,7 @@ dns_message_parse(dns_message_t *msg, isc_buffer_t *source,
 	isc_buffer_t origsource;
 	bool seen_problem;
 	bool ignore_tc;
+	bool lazy;
 
 	REQUIRE(DNS_MESSAGE_VALID(msg));
 	REQUIRE(source != NULL);
@@ -1623,6 +1795,9 @@ dns_message_parse(dns_message_t *msg, isc_buffer_t *source,
 
 	seen_problem = false;
 	ignore_tc = ((options & DNS_MESSAGEPARSE_IGNORETRUNCATION) != 0);
+	lazy = ((options & DNS_MESSAGEPARSE_LAZY) != 0 &&
+		(options & (DNS_MESSAGEPARSE_BESTEFFORT |
+			    DNS_MESSAGEPARSE_IGNORETRUNCATION)) == 0);
 
 	origsource = *source;
 
@@ -1673,6 +1848,59 @@ dns_message_parse(dns_message_t *msg, isc_buffer_t *source,
 	}
 	msg->question_ok = 1;
 
+	/*
+	 * The server only looks at the answer and authority sections of
+	 * a query for a few special cases such as IXFR, and only needs
+	 * the OPT, TSIG and SIG(0) records from the additional section,
+	 * so when asked to, just check that the sections are well formed,
+	 * parse those records and leave building the rest until needed.
+	 */
+	if (lazy && msg->opcode == dns_opcode_query && msg->rdclass_set != 0) {
+		isc_buffer_t deferred = *source;
+		bool deferrable = true;
+		unsigned int special = 0, specialoff = 0;
+
+		ret = skipsection(source, msg, DNS_SECTION_ANSWER, NULL, NULL,
+				  &deferrable);
+		if (ret == ISC_R_SUCCESS && deferrable) {
+			ret = skipsection(source, msg, DNS_SECTION_AUTHORITY,
+					  NULL, NULL, &deferrable);
+		}
+		if (ret == ISC_R_SUCCESS && deferrable) {
+			ret = skipsection(source, msg, DNS_SECTION_ADDITIONAL,
+					  &special, &specialoff, &deferrable);
+		}
+		if (ret != ISC_R_SUCCESS) {
+			return (ret);
+		}
+		if (deferrable) {
+			unsigned int arcount =
+				msg->counts[DNS_SECTION_ADDITIONAL];
+
+			source->current = specialoff;
+			msg->counts[DNS_SECTION_ADDITIONAL] = arcount - special;
+			ret = getsection(source, msg, dctx,
+					 DNS_SECTION_ADDITIONAL, options);
+			msg->counts[DNS_SECTION_ADDITIONAL] = arcount;
+			if (ret != ISC_R_SUCCESS) {
+				return (ret);
+			}
+
+			if (msg->counts[DNS_SECTION_ANSWER] +
+				    msg->counts[DNS_SECTION_AUTHORITY] +
+				    special !=
+			    0)
+			{
+				msg->lazy_pending = 1;
+				msg->lazy_offset = deferred.current;
+				msg->lazy_additional = special;
+				msg->lazy_options = options;
+			}
+			goto trailing;
+		}
+		*source = deferred;
+	}
+
 	ret = getsection(source, msg, dctx, DNS_SECTION_ANSWER, options);
 	if (ret == ISC_R_UNEXPECTEDEND && ignore_tc) {
 		goto truncated;
@@ -1709,6 +1937,7 @@ dns_message_parse(dns_message_t *msg, isc_buffer_t *source,
 		return (ret);
 	}
 
+trailing:
 	isc_buffer_remainingregion(source, &r);
 	if (r.length != 0) {
 		isc_log_write(dns_lctx, ISC_LOGCATEGORY_GENERAL,
@@ -2365,6 +2594,13 @@ dns_message_firstname(dns_message_t *msg, dns_section_t section) {
 	REQUIRE(DNS_MESSAGE_VALID(msg));
 	REQUIRE(VALID_NAMED_SECTION(section));
 
+	if (msg->lazy_pending != 0) {
+		isc_result_t result = getdeferred(msg);
+		if (result != ISC_R_SUCCESS) {
+			return (result);
+		}
+	}
+
 	msg->cursors[section] = ISC_LIST_HEAD(msg->sections[section]);
 
 	if (msg->cursors[section] == NULL) {
@@ -2425,6 +2661,13 @@ dns_message_findname(dns_message_t *msg, dns_section_t section,
 		REQUIRE(rdataset == NULL || *rdataset == NULL);
 	}
 
+	if (msg->lazy_pending != 0) {
+		result = getdeferred(msg);
+		if (result != ISC_R_SUCCESS) {
+			return (result);
+		}
+	}
+
 	result = findname(&foundname, target, &msg->sections[section]);
 
 	if (result == ISC_R_NOTFOUND) {
@@ -3226,6 +3469,13 @@ dns_message_sectiontotext(dns_message_t *msg, dns_section_t section,
 
 	saved_count = msg->indent.count;
 
+	if (msg->lazy_pending != 0) {
+		result = getdeferred(msg);
+		if (result != ISC_R_SUCCESS) {
+			return (result);
+		}
+	}
+
 	if (ISC_LIST_EMPTY(msg->sections[section])) {
 		goto cleanup;
 	}
@@ -16,9 +16,11 @@
 
 #include <isc/base32.h>
 #include <isc/buffer.h>
+#include <isc/hash.h>
 #include <isc/hex.h>
 #include <isc/iterated_hash.h>
 #include <isc/md.h>
+#include <isc/mutex.h>
 #include <isc/nonce.h>
 #include <isc/result.h>
 #include <isc/safe.h>
@@ -239,6 +241,25 @@ dns_nsec3_generate_salt(unsigned char *salt, size_t saltlen) {
 	return (ISC_R_SUCCESS);
 }
 
+static isc_result_t
+hashtoname(dns_fixedname_t *result, const unsigned char *hash, size_t len,
+	   const dns_name_t *origin) {
+	unsigned char nametext[DNS_NAME_FORMATSIZE];
+	isc_buffer_t namebuffer;
+	isc_region_t region;
+
+	/* convert the hash to base32hex non-padded */
+	region.base = UNCONST(hash);
+	region.length = (unsigned int)len;
+	isc_buffer_init(&namebuffer, nametext, sizeof nametext);
+	isc_base32hexnp_totext(&region, 1, "", &namebuffer);
+
+	/* convert the hex to a domain name */
+	dns_fixedname_init(result);
+	return (dns_name_fromtext(dns_fixedname_name(result), &namebuffer,
+				  origin, 0, NULL));
+}
+
 isc_result_t
 dns_nsec3_hashname(dns_fixedname_t *result,
 		   unsigned char rethash[NSEC3_MAX_HASH_LENGTH],
@@ -247,11 +268,8 @@ dns_nsec3_hashname(dns_fixedname_t *result,
 		   unsigned int iterations, const unsigned char *salt,
 		   size_t saltlength) {
 	unsigned char hash[NSEC3_MAX_HASH_LENGTH];
-	unsigned char nametext[DNS_NAME_FORMATSIZE];
 	dns_fixedname_t fixed;
 	dns_name_t *downcased;
-	isc_buffer_t namebuffer;
-	isc_region_t region;
 	size_t len;
 
 	if (rethash == NULL) {
@@ -273,16 +291,135 @@ dns_nsec3_hashname(dns_fixedname_t *result,
 
 	SET_IF_NOT_NULL(hash_length, len);
 
-	/* convert the hash to base32hex non-padded */
-	region.base = rethash;
-	region.length = (unsigned int)len;
-	isc_buffer_init(&namebuffer, nametext, sizeof nametext);
-	isc_base32hexnp_totext(&region, 1, "", &namebuffer);
+	return (hashtoname(result, rethash, len, origin));
+}
 
-	/* convert the hex to a domain name */
-	dns_fixedname_init(result);
-	return (dns_name_fromtext(dns_fixedname_name(result), &namebuffer,
-				  origin, 0, NULL));
+/*
+ * Per-zone cache of NSEC3 owner name hashes.  The cache is direct
+ * mapped: each name can only live in the slot selected by its hash
+ * value and replaces whatever was there before.
+ */
+#define NSEC3CACHE_MAGIC    ISC_MAGIC('N', '3', 'H', 'C')
+#define VALID_NSEC3CACHE(c) ISC_MAGIC_VALID(c, NSEC3CACHE_MAGIC)
+
+typedef struct nsec3cache_entry {
+	isc_mutex_t lock;
+	uint64_t params;
+	unsigned int namelen;
+	unsigned int hashlen;
+	unsigned char name[DNS_NAME_MAXWIRE];
+	unsigned char hash[NSEC3_MAX_HASH_LENGTH];
+} nsec3cache_entry_t;
+
+struct dns_nsec3cache {
+	unsigned int magic;
+	isc_mem_t *mctx;
+	unsigned int size;
+	nsec3cache_entry_t *entries;
+};
+
+void
+dns_nsec3cache_create(isc_mem_t *mctx, unsigned int size,
+		      dns_nsec3cache_t **cachep) {
+	dns_nsec3cache_t *cache = NULL;
+
+	REQUIRE(size > 0);
+	REQUIRE(cachep != NULL && *cachep == NULL);
+
+	cache = isc_mem_get(mctx, sizeof(*cache));
+	*cache = (dns_nsec3cache_t){
+		.magic = NSEC3CACHE_MAGIC,
+		.size = size,
+	};
+	cache->entries = isc_mem_cget(mctx, size, sizeof(cache->entries[0]));
+	for (unsigned int i = 0; i < size; i++) {
+		isc_mutex_init(&cache->entries[i].lock);
+	}
+	isc_mem_attach(mctx, &cache->mctx);
+
+	*cachep = cache;
+}
+
+void
+dns_nsec3cache_destroy(dns_nsec3cache_t **cachep) {
+	dns_nsec3cache_t *cache = NULL;
+
+	REQUIRE(cachep != NULL && VALID_NSEC3CACHE(*cachep));
+
+	cache = *cachep;
+	*cachep = NULL;
+
+	cache->magic = 0;
+	for (unsigned int i = 0; i < cache->size; i++) {
+		isc_mutex_destroy(&cache->entries[i].lock);
+	}
+	isc_mem_cput(cache->mctx, cache->entries, cache->size,
+		     sizeof(cache->entries[0]));
+	isc_mem_putanddetach(&cache->mctx, cache, sizeof(*cache));
+}
+
+isc_result_t
+dns_nsec3cache_hashname(dns_nsec3cache_t *cache, dns_fixedname_t *result,
+			const dns_name_t *name, const dns_name_t *origin,
+			dns_hash_t hashalg, unsigned int iterations,
+			const unsigned char *salt, size_t saltlength,
+			bool *hitp) {
+	unsigned char hash[NSEC3_MAX_HASH_LENGTH];
+	size_t hashlen = 0;
+	dns_fixedname_t fixed;
+	dns_name_t *downcased = NULL;
+	nsec3cache_entry_t *entry = NULL;
+	isc_hash64_t state;
+	uint64_t params;
+	uint16_t iter = (uint16_t)iterations;
+	isc_result_t ret;
+
+	REQUIRE(VALID_NSEC3CACHE(cache));
+
+	SET_IF_NOT_NULL(hitp, false);
+
+	downcased = dns_fixedname_initname(&fixed);
+	dns_name_downcase(name, downcased, NULL);
+
+	isc_hash64_init(&state);
+	isc_hash64_hash(&state, &hashalg, sizeof(hashalg), true);
+	isc_hash64_hash(&state, &iter, sizeof(iter), true);
+	isc_hash64_hash(&state, salt, saltlength, true);
+	params = isc_hash64_finalize(&state);
+
+	entry = &cache->entries[isc_hash64(downcased->ndata, downcased->length,
+					   true) %
+				cache->size];
+
+	LOCK(&entry->lock);
+	if (entry->params == params && entry->namelen == downcased->length &&
+	    memcmp(entry->name, downcased->ndata, downcased->length) == 0)
+	{
+		hashlen = entry->hashlen;
+		memmove(hash, entry->hash, hashlen);
+	}
+	UNLOCK(&entry->lock);
+
+	if (hashlen != 0) {
+		SET_IF_NOT_NULL(hitp, true);
+		return (hashtoname(result, hash, hashlen, origin));
+	}
+
+	ret = dns_nsec3_hashname(result, hash, &hashlen, downcased, origin,
+				 hashalg, iterations, salt, saltlength);
+	if (ret != ISC_R_SUCCESS) {
+		return (ret);
+	}
+
+	LOCK(&entry->lock);
+	entry->params = params;
+	entry->namelen = downcased->length;
+	memmove(entry->name, downcased->ndata, downcased->length);
+	entry->hashlen = hashlen;
+	memmove(entry->hash, hash, hashlen);
+	UNLOCK(&entry->lock);
+
+	return (ISC_R_SUCCESS);
 }
 
 unsigned int
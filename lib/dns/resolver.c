@@ -69,6 +69,7 @@
 #include <dns/rdatatype.h>
 #include <dns/resolver.h>
 #include <dns/rootns.h>
+#include <dns/soa.h>
 #include <dns/stats.h>
 #include <dns/tsig.h>
 #include <dns/validator.h>
@@ -178,6 +179,18 @@
  */
 #define MINIMUM_QUERY_TIMEOUT (MAX_SINGLE_QUERY_TIMEOUT + 1000U)
 
+/*
+ * The shortest time we wait for an answer before hedging a query.
+ */
+#define HEDGE_MIN_DELAY_US (20 * US_PER_MS)
+
+/*
+ * When the distribution of a server's round trip times is known, the
+ * first retry interval is cut down to a multiple of its 95th percentile,
+ * but never to less than this.
+ */
+#define RETRY_MIN_ADAPTIVE_US (200 * US_PER_MS)
+
 /* The default time in seconds for the whole query to live. */
 #ifndef DEFAULT_QUERY_TIMEOUT
 #define DEFAULT_QUERY_TIMEOUT MINIMUM_QUERY_TIMEOUT
@@ -283,9 +296,11 @@ struct tried {
 #define VALID_QUERY(query) ISC_MAGIC_VALID(query, QUERY_MAGIC)
 
 #define RESQUERY_ATTR_CANCELED 0x02
+#define RESQUERY_ATTR_HEDGE    0x04
 
 #define RESQUERY_CONNECTING(q) ((q)->connects > 0)
 #define RESQUERY_CANCELED(q)   (((q)->attributes & RESQUERY_ATTR_CANCELED) != 0)
+#define RESQUERY_HEDGE(q)      (((q)->attributes & RESQUERY_ATTR_HEDGE) != 0)
 #define RESQUERY_SENDING(q)    ((q)->sends > 0)
 
 typedef enum {
@@ -350,6 +365,8 @@ struct fetchctx {
 	dns_rdataset_t nameservers;
 	atomic_uint_fast32_t attributes;
 	isc_timer_t *timer;
+	isc_timer_t *hedgetimer;
+	bool hedged;
 	isc_time_t expires;
 	isc_time_t expires_try_stale;
 	isc_time_t next_timeout;
@@ -561,6 +578,10 @@ struct dns_resolver {
 	unsigned int retryinterval; /* in milliseconds */
 	unsigned int nonbackofftries;
 
+	/* Hedged queries, as a percentage of queries sent */
+	unsigned int hedgeratio;
+	atomic_uint_fast32_t hedgecredit;
+
 	/* Atomic */
 	isc_refcount_t references;
 	atomic_uint_fast32_t zspill; /* fetches-per-zone */
@@ -571,6 +592,7 @@ struct dns_resolver {
 	unsigned int spillat; /* clients-per-query */
 
 	dns_badcache_t *badcache; /* Bad cache. */
+	dns_badcache_t *nocuts;	  /* Names known not to be zone cuts. */
 
 	/* Locked by primelock. */
 	dns_fetch_t *primefetch;
@@ -633,6 +655,11 @@ static void
 resquery_connected(isc_result_t eresult, isc_region_t *region, void *arg);
 static void
 fctx_try(fetchctx_t *fctx, bool retrying, bool badcache);
+static isc_result_t
+fctx_query(fetchctx_t *fctx, dns_adbaddrinfo_t *addrinfo,
+	   unsigned int options);
+static dns_adbaddrinfo_t *
+fctx_nextaddress(fetchctx_t *fctx);
 static void
 fctx_shutdown(void *arg);
 static void
@@ -914,6 +941,15 @@ rctx_timedout(respctx_t *rctx);
 static void
 rctx_ncache(respctx_t *rctx);
 
+static void
+rctx_nocuts(respctx_t *rctx, const dns_name_t *zone, dns_ttl_t ttl);
+
+static void
+rctx_nocuts_positive(respctx_t *rctx);
+
+static void
+rctx_nocuts_negative(respctx_t *rctx);
+
 /*%
  * Increment resolver-related statistics counters.
  */
@@ -1066,6 +1102,148 @@ fctx_starttimer(fetchctx_t *fctx) {
 static void
 fctx_stoptimer(fetchctx_t *fctx) {
 	isc_timer_stop(fctx->timer);
+	isc_timer_stop(fctx->hedgetimer);
+}
+
+/*
+ * Each query sent normally earns 'hedgeratio' credits, and a hedged
+ * query costs 100, so hedging adds at most 'hedgeratio' percent to the
+ * queries sent.  A limited number of credits can be saved up.
+ */
+#define HEDGE_COST	 100
+#define HEDGE_MAX_CREDIT (100 * HEDGE_COST)
+
+static void
+hedge_earn(dns_resolver_t *res) {
+	uint_fast32_t credit = atomic_load_relaxed(&res->hedgecredit);
+	uint_fast32_t newcredit;
+
+	do {
+		if (credit >= HEDGE_MAX_CREDIT) {
+			return;
+		}
+		newcredit = ISC_MIN(credit + res->hedgeratio,
+				    HEDGE_MAX_CREDIT);
+	} while (!atomic_compare_exchange_weak_relaxed(&res->hedgecredit,
+						       &credit, newcredit));
+}
+
+static bool
+hedge_spend(dns_resolver_t *res) {
+	uint_fast32_t credit = atomic_load_relaxed(&res->hedgecredit);
+
+	do {
+		if (credit < HEDGE_COST) {
+			return (false);
+		}
+	} while (!atomic_compare_exchange_weak_relaxed(
+		&res->hedgecredit, &credit, credit - HEDGE_COST));
+
+	return (true);
+}
+
+/*
+ * Arm the hedge timer after a query has been sent to 'addrinfo': if
+ * it hasn't been answered within the time in which the server usually
+ * answers 95% of queries (or, until that is known, twice its smoothed
+ * RTT), the same query is sent to the next best server as well.  This
+ * is not done when waiting that long would leave little time before
+ * the query would be retried anyway.
+ */
+static void
+fctx_starthedge(fetchctx_t *fctx, dns_adbaddrinfo_t *addrinfo) {
+	dns_resolver_t *res = fctx->res;
+	isc_interval_t interval;
+	unsigned int p95;
+	uint64_t us;
+
+	isc_timer_stop(fctx->hedgetimer);
+	fctx->hedged = false;
+
+	if (res->hedgeratio == 0 || fctx->forwarding ||
+	    (fctx->options & DNS_FETCHOPT_TCP) != 0)
+	{
+		return;
+	}
+
+	hedge_earn(res);
+
+	if (dns_adb_rttquantile(fctx->adb, addrinfo, 0.95, &p95) ==
+	    ISC_R_SUCCESS)
+	{
+		us = ISC_MAX((uint64_t)p95, HEDGE_MIN_DELAY_US);
+	} else {
+		us = ISC_MAX(2 * (uint64_t)addrinfo->srtt, HEDGE_MIN_DELAY_US);
+	}
+	if (us >= isc_interval_ms(&fctx->interval) * US_PER_MS / 2) {
+		return;
+	}
+
+	isc_interval_set(&interval, 0, us * NS_PER_US);
+	isc_timer_start(fctx->hedgetimer, isc_timertype_once, &interval);
+}
+
+static void
+fctx_hedge(void *arg) {
+	fetchctx_t *fctx = (fetchctx_t *)arg;
+	dns_adbaddrinfo_t *addrinfo = NULL;
+	resquery_t *query = NULL;
+	isc_result_t result;
+
+	REQUIRE(VALID_FCTX(fctx));
+	REQUIRE(fctx->tid == isc_tid());
+
+	FCTXTRACE("hedge");
+
+	if (fctx->forwarding || (fctx->options & DNS_FETCHOPT_TCP) != 0) {
+		return;
+	}
+
+	/* Only while a single query is waiting for its answer */
+	LOCK(&fctx->lock);
+	query = ISC_LIST_HEAD(fctx->queries);
+	if (query != NULL && ISC_LIST_NEXT(query, link) != NULL) {
+		query = NULL;
+	}
+	UNLOCK(&fctx->lock);
+
+	if (query == NULL || fctx->hedged || SHUTTINGDOWN(fctx) ||
+	    ADDRWAIT(fctx) || !ISC_LIST_EMPTY(fctx->validators) ||
+	    (query->options & DNS_FETCHOPT_TCP) != 0)
+	{
+		return;
+	}
+
+	if (!hedge_spend(fctx->res)) {
+		return;
+	}
+
+	addrinfo = fctx_nextaddress(fctx);
+	while (addrinfo != NULL && dns_adb_overquota(fctx->adb, addrinfo)) {
+		addrinfo = fctx_nextaddress(fctx);
+	}
+	if (addrinfo == NULL ||
+	    isc_counter_increment(fctx->qc) != ISC_R_SUCCESS)
+	{
+		/* Nobody else to ask; give the credit back */
+		atomic_fetch_add_relaxed(&fctx->res->hedgecredit, HEDGE_COST);
+		return;
+	}
+
+	result = fctx_query(fctx, addrinfo, fctx->options);
+	if (result != ISC_R_SUCCESS) {
+		FCTXTRACE3("hedged query failed", result);
+		atomic_fetch_add_relaxed(&fctx->res->hedgecredit, HEDGE_COST);
+		return;
+	}
+
+	LOCK(&fctx->lock);
+	query = ISC_LIST_TAIL(fctx->queries);
+	query->attributes |= RESQUERY_ATTR_HEDGE;
+	UNLOCK(&fctx->lock);
+
+	fctx->hedged = true;
+	inc_stats(fctx->res, dns_resstatscounter_hedgesent);
 }
 
 static void
@@ -1720,6 +1898,7 @@ fctx__done(fetchctx_t *fctx, isc_result_t result, const char *func,
 	fctx_cleanup(fctx);
 
 	isc_timer_destroy(&fctx->timer);
+	isc_timer_destroy(&fctx->hedgetimer);
 
 	return (true);
 }
@@ -1797,7 +1976,7 @@ fctx_addopt(dns_message_t *message, unsigned int version, uint16_t udpsize,
 }
 
 static void
-fctx_setretryinterval(fetchctx_t *fctx, unsigned int rtt) {
+fctx_setretryinterval(fetchctx_t *fctx, unsigned int rtt, unsigned int p95) {
 	unsigned int seconds, us;
 	uint64_t limit;
 	isc_time_t now;
@@ -1815,6 +1994,17 @@ fctx_setretryinterval(fetchctx_t *fctx, unsigned int rtt) {
 
 	us = fctx->res->retryinterval * US_PER_MS;
 
+	/*
+	 * If we know how long the server usually takes to answer, there
+	 * is no point waiting much longer than that before trying again.
+	 */
+	if (p95 != 0) {
+		unsigned int adaptive = ISC_MAX(3 * p95, RETRY_MIN_ADAPTIVE_US);
+		if (us > adaptive) {
+			us = adaptive;
+		}
+	}
+
 	/*
 	 * Exponential backoff after the first few tries.
 	 */
@@ -1936,7 +2126,7 @@ fctx_query(fetchctx_t *fctx, dns_adbaddrinfo_t *addrinfo,
 	resquery_t *query = NULL;
 	isc_sockaddr_t addr, sockaddr;
 	bool have_addr = false;
-	unsigned int srtt;
+	unsigned int srtt, p95 = 0;
 	isc_tlsctx_cache_t *tlsctx_cache = NULL;
 
 	FCTXTRACE("query");
@@ -1977,7 +2167,15 @@ fctx_query(fetchctx_t *fctx, dns_adbaddrinfo_t *addrinfo,
 		srtt = US_PER_SEC;
 	}
 
-	fctx_setretryinterval(fctx, srtt);
+	/*
+	 * Over UDP to an authoritative server, the retry interval can be
+	 * tailored to the server's observed round trip times.
+	 */
+	if ((options & DNS_FETCHOPT_TCP) == 0 && !ISFORWARDER(addrinfo)) {
+		(void)dns_adb_rttquantile(fctx->adb, addrinfo, 0.95, &p95);
+	}
+
+	fctx_setretryinterval(fctx, srtt, p95);
 	if (isc_interval_iszero(&fctx->interval)) {
 		FCTXTRACE("fetch expired");
 		return (ISC_R_TIMEDOUT);
@@ -2093,9 +2291,28 @@ fctx_query(fetchctx_t *fctx, dns_adbaddrinfo_t *addrinfo,
 		}
 		isc_sockaddr_setport(&addr, 0);
 
-		result = dns_dispatch_createtcp(
-			res->view->dispatchmgr, &addr, &sockaddr,
-			DNS_DISPATCHOPT_UNSHARED, &query->dispatch);
+		if (ISFORWARDER(addrinfo)) {
+			/*
+			 * Queries to a forwarder are pipelined over a
+			 * small pool of long-lived connections.
+			 */
+			result = dns_dispatch_gettcp(res->view->dispatchmgr,
+						     &sockaddr, &addr,
+						     addrinfo->transport,
+						     &query->dispatch);
+			if (result != ISC_R_SUCCESS) {
+				result = dns_dispatch_createtcp(
+					res->view->dispatchmgr, &addr,
+					&sockaddr, addrinfo->transport,
+					DNS_DISPATCHOPT_KEEPALIVE,
+					&query->dispatch);
+			}
+		} else {
+			result = dns_dispatch_createtcp(
+				res->view->dispatchmgr, &addr, &sockaddr,
+				addrinfo->transport, DNS_DISPATCHOPT_UNSHARED,
+				&query->dispatch);
+		}
 		if (result != ISC_R_SUCCESS) {
 			goto cleanup_query;
 		}
@@ -4057,6 +4274,7 @@ fctx_try(fetchctx_t *fctx, bool retrying, bool badcache) {
 		 */
 		options &= ~(DNS_FETCHOPT_QMINIMIZE |
 			     DNS_FETCHOPT_TRYSTALE_ONTIMEOUT);
+		options |= DNS_FETCHOPT_QMINFETCH;
 
 		/*
 		 * Is another QNAME minimization fetch still running?
@@ -4123,6 +4341,7 @@ fctx_try(fetchctx_t *fctx, bool retrying, bool badcache) {
 	if (result != ISC_R_SUCCESS) {
 		goto done;
 	}
+	fctx_starthedge(fctx, addrinfo);
 	if (retrying) {
 		inc_stats(res, dns_resstatscounter_retry);
 	}
@@ -4755,6 +4974,7 @@ fctx_create(dns_resolver_t *res, isc_loop_t *loop, const dns_name_t *name,
 	inc_stats(res, dns_resstatscounter_nfetch);
 
 	isc_timer_create(fctx->loop, fctx_expired, fctx, &fctx->timer);
+	isc_timer_create(fctx->loop, fctx_hedge, fctx, &fctx->hedgetimer);
 
 	*fctxp = fctx;
 
@@ -8325,6 +8545,8 @@ rctx_answer_positive(respctx_t *rctx) {
 	 */
 	rctx_authority_positive(rctx);
 
+	rctx_nocuts_positive(rctx);
+
 	log_ns_ttl(fctx, "rctx_answer");
 
 	if (rctx->ns_rdataset != NULL &&
@@ -8902,6 +9124,7 @@ rctx_answer_none(respctx_t *rctx) {
 
 	if (rctx->negative) {
 		FCTX_ATTR_SET(fctx, FCTX_ATTR_WANTNCACHE);
+		rctx_nocuts_negative(rctx);
 	}
 
 	return (ISC_R_SUCCESS);
@@ -9073,6 +9296,109 @@ rctx_ncache(respctx_t *rctx) {
 	}
 }
 
+/*
+ * rctx_nocuts():
+ * An authoritative NOERROR response from the servers for 'zone' shows
+ * that the query name exists in that zone, so neither it nor any name
+ * between it and the zone apex is a zone cut.  Remember those names
+ * for 'ttl' seconds, so that QNAME minimization doesn't need to query
+ * for them again.
+ *
+ * This is done both for fetches that minimize and for the NS queries
+ * they send for the intermediate names, which are what most often
+ * finds these names.
+ */
+static void
+rctx_nocuts(respctx_t *rctx, const dns_name_t *zone, dns_ttl_t ttl) {
+	fetchctx_t *fctx = rctx->fctx;
+	unsigned int labels, zonelabels;
+
+	if ((fctx->options &
+	     (DNS_FETCHOPT_QMINIMIZE | DNS_FETCHOPT_QMINFETCH)) == 0 ||
+	    !rctx->aa || ttl == 0 || ISFORWARDER(rctx->query->addrinfo) ||
+	    rctx->query->rmessage->rcode != dns_rcode_noerror ||
+	    dns_rdatatype_atparent(fctx->type) ||
+	    !dns_name_issubdomain(fctx->name, zone))
+	{
+		return;
+	}
+
+	/* Minimization never queries names deeper than this */
+	labels = ISC_MIN(dns_name_countlabels(fctx->name),
+			 DNS_QMIN_MAXLABELS);
+	zonelabels = dns_name_countlabels(zone);
+	for (unsigned int i = zonelabels + 1; i <= labels; i++) {
+		dns_name_t name;
+
+		dns_name_init(&name, NULL);
+		dns_name_split(fctx->name, i, NULL, &name);
+		dns_badcache_add(fctx->res->nocuts, &name, dns_rdatatype_ns,
+				 true, 0, rctx->now + ttl);
+	}
+}
+
+/*
+ * rctx_nocuts_positive():
+ * Record the names leading to the owner of an authoritative answer
+ * or CNAME, for as long as the answer may be cached.  The zone is the
+ * one named by the NS records in the authority section, if any, or
+ * else the domain whose servers were queried.  An NS answer means the
+ * query name is a zone apex, so nothing is recorded for it.
+ */
+static void
+rctx_nocuts_positive(respctx_t *rctx) {
+	fetchctx_t *fctx = rctx->fctx;
+	dns_rdataset_t *rdataset = NULL;
+	const dns_name_t *zone = NULL;
+
+	if (rctx->aname != NULL && rctx->type != dns_rdatatype_any) {
+		rdataset = rctx->ardataset;
+	} else if (rctx->aname == NULL && rctx->cname != NULL) {
+		rdataset = rctx->crdataset;
+	}
+	if (rdataset == NULL || rdataset->type == dns_rdatatype_ns) {
+		return;
+	}
+
+	zone = (rctx->ns_name != NULL) ? rctx->ns_name : fctx->domain;
+	rctx_nocuts(rctx, zone,
+		    ISC_MIN(rdataset->ttl, fctx->res->view->maxcachettl));
+}
+
+/*
+ * rctx_nocuts_negative():
+ * Record the names leading to the query name of an authoritative
+ * NODATA response, in the zone named by the SOA record, for as long
+ * as the negative answer may be cached.
+ */
+static void
+rctx_nocuts_negative(respctx_t *rctx) {
+	isc_result_t result;
+	fetchctx_t *fctx = rctx->fctx;
+	dns_rdataset_t *soaset = NULL;
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	dns_ttl_t ttl;
+
+	if (rctx->soa_name == NULL) {
+		return;
+	}
+
+	result = dns_message_findtype(rctx->soa_name, dns_rdatatype_soa, 0,
+				      &soaset);
+	if (result != ISC_R_SUCCESS ||
+	    dns_rdataset_first(soaset) != ISC_R_SUCCESS)
+	{
+		return;
+	}
+	dns_rdataset_current(soaset, &rdata);
+
+	/* The same TTL as the negative cache entry */
+	ttl = ISC_MIN(soaset->ttl, dns_soa_getminimum(&rdata));
+	ttl = ISC_MIN(ttl, fctx->res->view->maxncachettl);
+
+	rctx_nocuts(rctx, rctx->soa_name, ttl);
+}
+
 /*
  * rctx_authority_dnssec():
  *
@@ -9465,6 +9791,14 @@ rctx_nextserver(respctx_t *rctx, dns_message_t *message,
 		fctx_cancelqueries(fctx, true, false);
 		fctx_cleanup(fctx);
 		retrying = false;
+	} else if (fctx->hedged && !ISC_LIST_EMPTY(fctx->queries)) {
+		/*
+		 * The other query of a hedged pair is still
+		 * outstanding; wait for it before trying yet another
+		 * server.
+		 */
+		FCTXTRACE("waiting for the other hedged query");
+		return;
 	}
 
 	/*
@@ -9563,6 +9897,7 @@ rctx_done(respctx_t *rctx, isc_result_t result) {
 	fetchctx_t *fctx = rctx->fctx;
 	dns_adbaddrinfo_t *addrinfo = query->addrinfo;
 	dns_message_t *message = NULL;
+	bool hedge = RESQUERY_HEDGE(query);
 
 	/*
 	 * Need to attach to the message until the scope
@@ -9609,6 +9944,13 @@ rctx_done(respctx_t *rctx, isc_result_t result) {
 	}
 	UNLOCK(&fctx->lock);
 
+	if (hedge && result == ISC_R_SUCCESS && !rctx->next_server &&
+	    !rctx->resend)
+	{
+		/* The hedged query got the answer first */
+		inc_stats(fctx->res, dns_resstatscounter_hedgewon);
+	}
+
 	if (rctx->next_server) {
 		rctx_nextserver(rctx, message, addrinfo, result);
 	} else if (rctx->resend) {
@@ -9885,6 +10227,7 @@ dns_resolver__destroy(dns_resolver_t *res) {
 		isc_mem_put(res->mctx, a, sizeof(*a));
 	}
 	dns_badcache_destroy(&res->badcache);
+	dns_badcache_destroy(&res->nocuts);
 
 	dns_view_weakdetach(&res->view);
 
@@ -9977,6 +10320,7 @@ dns_resolver_create(dns_view_t *view, isc_loopmgr_t *loopmgr, isc_nm_t *nm,
 	isc_refcount_init(&res->references, 1);
 
 	res->badcache = dns_badcache_new(res->mctx);
+	res->nocuts = dns_badcache_new(res->mctx);
 
 	isc_hashmap_create(view->mctx, RES_DOMAIN_HASH_BITS, &res->fctxs);
 	isc_rwlock_init(&res->fctxs_lock);
@@ -10256,8 +10600,19 @@ fctx_minimize_qname(fetchctx_t *fctx) {
 			/*
 			 * Look to see if we have anything cached about NS
 			 * RRsets at this name and if so skip this name and
-			 * try with an additional label prepended.
+			 * try with an additional label prepended.  Names we
+			 * already know are not zone cuts are skipped without
+			 * looking at the cache.
 			 */
+			result = dns_badcache_find(fctx->res->nocuts, &name,
+						   dns_rdatatype_ns, NULL,
+						   fctx->now);
+			if (result == ISC_R_SUCCESS) {
+				inc_stats(fctx->res,
+					  dns_resstatscounter_qminskip);
+				fctx->qmin_labels++;
+				continue;
+			}
 			result = dns_db_find(fctx->cache, &name, NULL,
 					     dns_rdatatype_ns, 0, 0, NULL,
 					     fname, &rdataset, NULL);
@@ -10734,14 +11089,17 @@ void
 dns_resolver_flushbadcache(dns_resolver_t *resolver, const dns_name_t *name) {
 	if (name != NULL) {
 		dns_badcache_flushname(resolver->badcache, name);
+		dns_badcache_flushname(resolver->nocuts, name);
 	} else {
 		dns_badcache_flush(resolver->badcache);
+		dns_badcache_flush(resolver->nocuts);
 	}
 }
 
 void
 dns_resolver_flushbadnames(dns_resolver_t *resolver, const dns_name_t *name) {
 	dns_badcache_flushtree(resolver->badcache, name);
+	dns_badcache_flushtree(resolver->nocuts, name);
 }
 
 void
@@ -11067,6 +11425,21 @@ dns_resolver_setretryinterval(dns_resolver_t *resolver, unsigned int interval) {
 	resolver->retryinterval = ISC_MIN(interval, 2000);
 }
 
+unsigned int
+dns_resolver_gethedgeratio(dns_resolver_t *resolver) {
+	REQUIRE(VALID_RESOLVER(resolver));
+
+	return (resolver->hedgeratio);
+}
+
+void
+dns_resolver_sethedgeratio(dns_resolver_t *resolver, unsigned int percent) {
+	REQUIRE(VALID_RESOLVER(resolver));
+	REQUIRE(percent <= 100);
+
+	resolver->hedgeratio = percent;
+}
+
 unsigned int
 dns_resolver_getnonbackofftries(dns_resolver_t *resolver) {
 	REQUIRE(VALID_RESOLVER(resolver));
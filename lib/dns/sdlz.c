@@ -53,7 +53,9 @@
 #include <string.h>
 
 #include <isc/ascii.h>
+#include <isc/async.h>
 #include <isc/buffer.h>
+#include <isc/hashmap.h>
 #include <isc/lex.h>
 #include <isc/log.h>
 #include <isc/magic.h>
@@ -62,6 +64,8 @@
 #include <isc/region.h>
 #include <isc/result.h>
 #include <isc/rwlock.h>
+#include <isc/stats.h>
+#include <isc/stdtime.h>
 #include <isc/string.h>
 #include <isc/util.h>
 
@@ -78,6 +82,7 @@
 #include <dns/rdatasetiter.h>
 #include <dns/rdatatype.h>
 #include <dns/sdlz.h>
+#include <dns/stats.h>
 #include <dns/types.h>
 
 /*
@@ -93,11 +98,23 @@ struct dns_sdlzimplementation {
 	dns_dlzimplementation_t *dlz_imp;
 };
 
+typedef struct sdlz_cache sdlz_cache_t;
+
+/*
+ * The state of each "dlz" statement, which the DLZ layer passes to the
+ * methods below as 'dbdata'.  The driver's own data is in 'dbdata'.
+ */
+typedef struct sdlz_instance {
+	void *dbdata;
+	sdlz_cache_t *cache;
+} sdlz_instance_t;
+
 struct dns_sdlz_db {
 	/* Unlocked */
 	dns_db_t common;
 	void *dbdata;
 	dns_sdlzimplementation_t *dlzimp;
+	sdlz_cache_t *cache;
 
 	/* Locked */
 	dns_dbversion_t *future_version;
@@ -134,6 +151,81 @@ typedef struct sdlz_rdatasetiter {
 	dns_rdatalist_t *current;
 } sdlz_rdatasetiter_t;
 
+/*
+ * The answer cache holds the nodes looked up by name, and remembers
+ * names that were not found, until their TTL expires.  Cached nodes
+ * are not modified once the lookup that created them has completed,
+ * so they are shared by every query that finds them.
+ */
+typedef struct sdlz_cacheentry sdlz_cacheentry_t;
+
+struct sdlz_cacheentry {
+	dns_name_t name;
+	dns_name_t zone;
+	dns_sdlznode_t *node; /* NULL if the name was not found */
+	isc_stdtime_t expire;
+	ISC_LINK(sdlz_cacheentry_t) link;
+};
+
+typedef struct sdlz_cachekey {
+	const dns_name_t *name;
+	const dns_name_t *zone;
+} sdlz_cachekey_t;
+
+struct sdlz_cache {
+	unsigned int magic;
+	isc_mem_t *mctx;
+	isc_refcount_t references;
+	dns_ttl_t maxttl;
+	unsigned int maxentries;
+	isc_stats_t *stats;
+
+	/* Locked by 'lock' */
+	isc_rwlock_t lock;
+	isc_hashmap_t *hashmap;
+	ISC_LIST(sdlz_cacheentry_t) entries; /* oldest first */
+	bool shuttingdown;
+};
+
+/*
+ * A lookup that the driver runs in the background on behalf of a
+ * query.  When it completes it is kept in the query's state until the
+ * query is done: a find may look up several names (every label between
+ * the zone apex and the query name, for instance), and each repeated
+ * find takes the answers of all the lookups completed so far from here,
+ * so that only one new lookup runs per resumption.
+ */
+typedef struct sdlz_asynclookup sdlz_asynclookup_t;
+
+struct sdlz_asynclookup {
+	dns_sdlzasync_t *async;
+	dns_sdlzimplementation_t *dlzimp;
+	void *dbdata;
+	char *zone;
+	char *name;
+	dns_sdlznode_t *node;
+	isc_result_t result;
+	ISC_LINK(sdlz_asynclookup_t) link;
+};
+
+struct dns_sdlzasync {
+	unsigned int magic;
+	isc_mem_t *mctx;
+	isc_refcount_t references;
+
+	/* Only used by the thread running the query */
+	sdlz_asynclookup_t *spare;
+	bool waiting;
+
+	/* Locked by 'lock' */
+	isc_mutex_t lock;
+	ISC_LIST(sdlz_asynclookup_t) done;
+	bool pending;
+	isc_loop_t *loop;
+	isc_job_cb cb;
+	void *cbarg;
+};
+
 #define SDLZDB_MAGIC ISC_MAGIC('D', 'L', 'Z', 'S')
 
 /*
@@ -148,6 +240,15 @@ typedef struct sdlz_rdatasetiter {
 #define VALID_SDLZLOOKUP(sdlzl) ISC_MAGIC_VALID(sdlzl, SDLZLOOKUP_MAGIC)
 #define VALID_SDLZNODE(sdlzn)	VALID_SDLZLOOKUP(sdlzn)
 
+#define SDLZCACHE_MAGIC	       ISC_MAGIC('D', 'L', 'Z', 'C')
+#define VALID_SDLZCACHE(cache) ISC_MAGIC_VALID(cache, SDLZCACHE_MAGIC)
+
+#define SDLZASYNC_MAGIC	       ISC_MAGIC('D', 'L', 'Z', 'A')
+#define VALID_SDLZASYNC(async) ISC_MAGIC_VALID(async, SDLZASYNC_MAGIC)
+
+/* Initial size of the answer cache hash table, in bits */
+#define SDLZ_CACHE_HASHBITS 12
+
 /* These values are taken from RFC 1537 */
 #define SDLZ_DEFAULT_REFRESH 28800U  /* 8 hours */
 #define SDLZ_DEFAULT_RETRY   7200U   /* 2 hours */
@@ -188,6 +289,10 @@ static void
 list_tordataset(dns_rdatalist_t *rdatalist, dns_db_t *db, dns_dbnode_t *node,
 		dns_rdataset_t *rdataset);
 
+static void
+attachnode(dns_db_t *db, dns_dbnode_t *source,
+	   dns_dbnode_t **targetp DNS__DB_FLARG);
+
 static void
 detachnode(dns_db_t *db, dns_dbnode_t **targetp DNS__DB_FLARG);
 
@@ -240,6 +345,230 @@ initial_size(const char *data) {
 	return (len * 64 + 64);
 }
 
+/*
+ * Answer cache.
+ */
+
+static void
+cache_attach(sdlz_cache_t *cache, sdlz_cache_t **targetp) {
+	REQUIRE(VALID_SDLZCACHE(cache));
+	REQUIRE(targetp != NULL && *targetp == NULL);
+
+	isc_refcount_increment(&cache->references);
+	*targetp = cache;
+}
+
+static void
+cache_detach(sdlz_cache_t **cachep) {
+	sdlz_cache_t *cache = NULL;
+
+	REQUIRE(cachep != NULL && VALID_SDLZCACHE(*cachep));
+
+	cache = *cachep;
+	*cachep = NULL;
+
+	if (isc_refcount_decrement(&cache->references) == 1) {
+		isc_refcount_destroy(&cache->references);
+		INSIST(ISC_LIST_EMPTY(cache->entries));
+		cache->magic = 0;
+		isc_hashmap_destroy(&cache->hashmap);
+		isc_rwlock_destroy(&cache->lock);
+		isc_stats_detach(&cache->stats);
+		isc_mem_putanddetach(&cache->mctx, cache, sizeof(*cache));
+	}
+}
+
+static uint32_t
+cache_hash(const dns_name_t *name, const dns_name_t *zone) {
+	return (dns_name_hash(name) ^ dns_name_hash(zone));
+}
+
+static bool
+cache_match(void *node, const void *key) {
+	const sdlz_cacheentry_t *entry = node;
+	const sdlz_cachekey_t *k = key;
+
+	return (dns_name_equal(&entry->name, k->name) &&
+		dns_name_equal(&entry->zone, k->zone));
+}
+
+/*
+ * Remove 'entry' from the cache.  The caller must hold the write lock,
+ * and must release the node, if any, after unlocking; it is returned
+ * in '*nodep'.
+ */
+static void
+cache_delete(sdlz_cache_t *cache, sdlz_cacheentry_t *entry,
+	     dns_sdlznode_t **nodep) {
+	sdlz_cachekey_t key = { .name = &entry->name, .zone = &entry->zone };
+	isc_result_t result;
+
+	result = isc_hashmap_delete(cache->hashmap,
+				    cache_hash(&entry->name, &entry->zone),
+				    cache_match, &key);
+	INSIST(result == ISC_R_SUCCESS);
+	ISC_LIST_UNLINK(cache->entries, entry, link);
+
+	*nodep = entry->node;
+	dns_name_free(&entry->name, cache->mctx);
+	dns_name_free(&entry->zone, cache->mctx);
+	isc_mem_put(cache->mctx, entry, sizeof(*entry));
+}
+
+static void
+cache_releasenode(dns_sdlznode_t **nodep) {
+	dns_sdlznode_t *node = *nodep;
+	dns_dbnode_t *dbnode = (dns_dbnode_t *)node;
+
+	if (node != NULL) {
+		*nodep = NULL;
+		detachnode((dns_db_t *)node->sdlz, &dbnode DNS__DB_FILELINE);
+	}
+}
+
+/*
+ * Look up 'name' in zone 'zone'.  Returns true if there is an
+ * unexpired entry, with '*nodep' attached to its node, which is NULL
+ * if the name was not found.
+ */
+static bool
+cache_find(sdlz_cache_t *cache, const dns_name_t *name,
+	   const dns_name_t *zone, dns_sdlznode_t **nodep) {
+	sdlz_cachekey_t key = { .name = name, .zone = zone };
+	sdlz_cacheentry_t *entry = NULL;
+	isc_stdtime_t now = isc_stdtime_now();
+	isc_result_t result;
+	bool found = false;
+
+	RWLOCK(&cache->lock, isc_rwlocktype_read);
+	result = isc_hashmap_find(cache->hashmap, cache_hash(name, zone),
+				  cache_match, &key, (void **)&entry);
+	if (result == ISC_R_SUCCESS && entry->expire > now) {
+		if (entry->node != NULL) {
+			attachnode((dns_db_t *)entry->node->sdlz,
+				   (dns_dbnode_t *)entry->node,
+				   (dns_dbnode_t **)nodep DNS__DB_FILELINE);
+		}
+		found = true;
+	}
+	RWUNLOCK(&cache->lock, isc_rwlocktype_read);
+
+	isc_stats_increment(cache->stats,
+			    found ? dns_dlzcachestatscounter_hits
+				  : dns_dlzcachestatscounter_misses);
+
+	return (found);
+}
+
+/*
+ * Remember the result of looking up 'name' in zone 'zone': 'node', or
+ * that the name was not found if 'node' is NULL.
+ */
+static void
+cache_add(sdlz_cache_t *cache, const dns_name_t *name, const dns_name_t *zone,
+	  dns_sdlznode_t *node) {
+	sdlz_cachekey_t key = { .name = name, .zone = zone };
+	sdlz_cacheentry_t *entry = NULL, *found = NULL;
+	dns_sdlznode_t *old = NULL, *evicted = NULL;
+	dns_ttl_t ttl = cache->maxttl;
+	isc_result_t result;
+
+	if (node != NULL) {
+		for (dns_rdatalist_t *list = ISC_LIST_HEAD(node->lists);
+		     list != NULL; list = ISC_LIST_NEXT(list, link))
+		{
+			ttl = ISC_MIN(ttl, list->ttl);
+		}
+	}
+	if (ttl == 0) {
+		return;
+	}
+
+	entry = isc_mem_get(cache->mctx, sizeof(*entry));
+	*entry = (sdlz_cacheentry_t){
+		.expire = isc_stdtime_now() + ttl,
+		.link = ISC_LINK_INITIALIZER,
+	};
+	dns_name_init(&entry->name, NULL);
+	dns_name_dup(name, cache->mctx, &entry->name);
+	dns_name_init(&entry->zone, NULL);
+	dns_name_dup(zone, cache->mctx, &entry->zone);
+	if (node != NULL) {
+		attachnode((dns_db_t *)node->sdlz, (dns_dbnode_t *)node,
+			   (dns_dbnode_t **)&entry->node DNS__DB_FILELINE);
+	}
+
+	RWLOCK(&cache->lock, isc_rwlocktype_write);
+	if (cache->shuttingdown) {
+		RWUNLOCK(&cache->lock, isc_rwlocktype_write);
+		cache_releasenode(&entry->node);
+		dns_name_free(&entry->name, cache->mctx);
+		dns_name_free(&entry->zone, cache->mctx);
+		isc_mem_put(cache->mctx, entry, sizeof(*entry));
+		return;
+	}
+
+	/*
+	 * Replace an entry for the same name, which has expired or was
+	 * looked up concurrently.
+	 */
+	result = isc_hashmap_find(cache->hashmap, cache_hash(name, zone),
+				  cache_match, &key, (void **)&found);
+	if (result == ISC_R_SUCCESS) {
+		cache_delete(cache, found, &old);
+	} else if (isc_hashmap_count(cache->hashmap) >= cache->maxentries) {
+		cache_delete(cache, ISC_LIST_HEAD(cache->entries), &evicted);
+		isc_stats_increment(cache->stats,
+				    dns_dlzcachestatscounter_evictions);
+	}
+
+	result = isc_hashmap_add(cache->hashmap, cache_hash(name, zone),
+				 cache_match, &key, entry, NULL);
+	INSIST(result == ISC_R_SUCCESS);
+	ISC_LIST_APPEND(cache->entries, entry, link);
+	RWUNLOCK(&cache->lock, isc_rwlocktype_write);
+
+	isc_stats_increment(cache->stats, dns_dlzcachestatscounter_inserts);
+
+	cache_releasenode(&old);
+	cache_releasenode(&evicted);
+}
+
+/*
+ * Empty the cache; if 'shutdown' is true, also stop adding to it,
+ * as the entries refer to databases that refer back to the cache.
+ */
+static void
+cache_flush(sdlz_cache_t *cache, bool shutdown) {
+	ISC_LIST(sdlz_cacheentry_t) entries = ISC_LIST_INITIALIZER;
+	sdlz_cacheentry_t *entry = NULL;
+
+	RWLOCK(&cache->lock, isc_rwlocktype_write);
+	ISC_LIST_MOVE(entries, cache->entries);
+	for (entry = ISC_LIST_HEAD(entries); entry != NULL;
+	     entry = ISC_LIST_NEXT(entry, link))
+	{
+		sdlz_cachekey_t key = { .name = &entry->name,
+					.zone = &entry->zone };
+		isc_result_t result = isc_hashmap_delete(
+			cache->hashmap, cache_hash(&entry->name, &entry->zone),
+			cache_match, &key);
+		INSIST(result == ISC_R_SUCCESS);
+	}
+	if (shutdown) {
+		cache->shuttingdown = true;
+	}
+	RWUNLOCK(&cache->lock, isc_rwlocktype_write);
+
+	while ((entry = ISC_LIST_HEAD(entries)) != NULL) {
+		ISC_LIST_UNLINK(entries, entry, link);
+		cache_releasenode(&entry->node);
+		dns_name_free(&entry->name, cache->mctx);
+		dns_name_free(&entry->zone, cache->mctx);
+		isc_mem_put(cache->mctx, entry, sizeof(*entry));
+	}
+}
+
 /*
  * Rdataset Iterator Methods. These methods were "borrowed" from the SDB
  * driver interface.  See the SDB driver interface documentation for more info.
@@ -307,6 +636,9 @@ destroy(dns_db_t *db) {
 	sdlz->common.impmagic = 0;
 
 	dns_name_free(&sdlz->common.origin, sdlz->common.mctx);
+	if (sdlz->cache != NULL) {
+		cache_detach(&sdlz->cache);
+	}
 
 	isc_refcount_destroy(&sdlz->common.references);
 	isc_mem_putanddetach(&sdlz->common.mctx, sdlz, sizeof(dns_sdlz_db_t));
@@ -387,6 +719,10 @@ closeversion(dns_db_t *db, dns_dbversion_t **versionp,
 			 origin);
 	}
 
+	if (commit && sdlz->cache != NULL) {
+		cache_flush(sdlz->cache, false);
+	}
+
 	sdlz->future_version = NULL;
 }
 
@@ -453,6 +789,209 @@ destroynode(dns_sdlznode_t *node) {
 	dns_db_detach(&db);
 }
 
+static void
+asynclookup_free(dns_sdlzasync_t *async, sdlz_asynclookup_t *lk) {
+	dns_dbnode_t *dbnode = (dns_dbnode_t *)lk->node;
+
+	detachnode((dns_db_t *)lk->node->sdlz, &dbnode DNS__DB_FILELINE);
+	isc_mem_free(async->mctx, lk->zone);
+	isc_mem_free(async->mctx, lk->name);
+	isc_mem_put(async->mctx, lk, sizeof(*lk));
+}
+
+static void
+async_destroy(dns_sdlzasync_t *async) {
+	sdlz_asynclookup_t *lk = NULL;
+
+	isc_refcount_destroy(&async->references);
+	async->magic = 0;
+
+	while ((lk = ISC_LIST_HEAD(async->done)) != NULL) {
+		ISC_LIST_UNLINK(async->done, lk, link);
+		asynclookup_free(async, lk);
+	}
+	if (async->spare != NULL) {
+		isc_mem_put(async->mctx, async->spare, sizeof(*async->spare));
+	}
+
+	isc_mutex_destroy(&async->lock);
+	isc_mem_putanddetach(&async->mctx, async, sizeof(*async));
+}
+
+static void
+async_detach(dns_sdlzasync_t **asyncp) {
+	dns_sdlzasync_t *async = *asyncp;
+
+	*asyncp = NULL;
+	if (isc_refcount_decrement(&async->references) == 1) {
+		async_destroy(async);
+	}
+}
+
+/*
+ * Called by the driver when a lookup started in the background has
+ * completed, possibly from a thread of its own.
+ */
+static void
+asynclookup_done(void *arg, isc_result_t result) {
+	sdlz_asynclookup_t *lk = arg;
+	dns_sdlzasync_t *async = lk->async;
+
+	REQUIRE(VALID_SDLZASYNC(async));
+
+	LOCK(&async->lock);
+	INSIST(async->pending);
+	lk->result = result;
+	ISC_LIST_APPEND(async->done, lk, link);
+	async->pending = false;
+	if (async->cb != NULL) {
+		isc_async_run(async->loop, async->cb, async->cbarg);
+		async->cb = NULL;
+		async->cbarg = NULL;
+		async->loop = NULL;
+	}
+	UNLOCK(&async->lock);
+
+	async_detach(&async);
+}
+
+/*
+ * If the background lookup of 'namestr' has completed, add its answer
+ * to 'node', set '*resultp' to its result and return true.  The answer
+ * stays available to later finds by the same query.
+ */
+static bool
+asynclookup_replay(dns_sdlz_db_t *sdlz, dns_sdlzasync_t *async,
+		   const char *zonestr, const char *namestr,
+		   dns_sdlznode_t *node, isc_result_t *resultp) {
+	sdlz_asynclookup_t *lk = NULL;
+	isc_result_t result = ISC_R_SUCCESS;
+
+	LOCK(&async->lock);
+	for (lk = ISC_LIST_HEAD(async->done); lk != NULL;
+	     lk = ISC_LIST_NEXT(lk, link))
+	{
+		if (lk->dlzimp == sdlz->dlzimp && lk->dbdata == sdlz->dbdata &&
+		    strcmp(lk->zone, zonestr) == 0 &&
+		    strcmp(lk->name, namestr) == 0)
+		{
+			break;
+		}
+	}
+	UNLOCK(&async->lock);
+
+	if (lk == NULL) {
+		return (false);
+	}
+
+	/*
+	 * The node of the background lookup may belong to a different
+	 * database object, so copy its records rather than moving them.
+	 */
+	for (dns_rdatalist_t *list = ISC_LIST_HEAD(lk->node->lists);
+	     list != NULL && result == ISC_R_SUCCESS;
+	     list = ISC_LIST_NEXT(list, link))
+	{
+		for (dns_rdata_t *rdata = ISC_LIST_HEAD(list->rdata);
+		     rdata != NULL && result == ISC_R_SUCCESS;
+		     rdata = ISC_LIST_NEXT(rdata, link))
+		{
+			result = dns_sdlz_putrdata(node, list->type, list->ttl,
+						  rdata->data, rdata->length);
+		}
+	}
+	if (result == ISC_R_SUCCESS) {
+		result = lk->result;
+	}
+
+	*resultp = result;
+	return (true);
+}
+
+/*
+ * Look up 'namestr' and add its records to 'node'.  When the caller
+ * allows it, the driver is asked to look up the name in the
+ * background, and DNS_R_WAIT is returned if it does.
+ */
+static isc_result_t
+dolookup(dns_sdlz_db_t *sdlz, const char *zonestr, const char *namestr,
+	 dns_sdlznode_t *node, dns_clientinfomethods_t *methods,
+	 dns_clientinfo_t *clientinfo) {
+	dns_sdlzimplementation_t *dlzimp = sdlz->dlzimp;
+	dns_sdlzasync_t *async = NULL;
+	sdlz_asynclookup_t *lk = NULL;
+	isc_result_t result;
+
+	if (clientinfo == NULL || clientinfo->dlzasync == NULL ||
+	    dlzimp->methods->lookupasync == NULL)
+	{
+		return (dlzimp->methods->lookup(zonestr, namestr,
+						dlzimp->driverarg, sdlz->dbdata,
+						node, methods, clientinfo));
+	}
+
+	async = clientinfo->dlzasync;
+	REQUIRE(VALID_SDLZASYNC(async));
+	REQUIRE(!async->waiting);
+
+	if (asynclookup_replay(sdlz, async, zonestr, namestr, node, &result)) {
+		return (result);
+	}
+
+	/*
+	 * The record is reused until a lookup actually runs in the
+	 * background, so drivers that answer at once cost nothing extra.
+	 */
+	lk = async->spare;
+	async->spare = NULL;
+	if (lk == NULL) {
+		lk = isc_mem_get(async->mctx, sizeof(*lk));
+	}
+	*lk = (sdlz_asynclookup_t){
+		.dlzimp = dlzimp,
+		.dbdata = sdlz->dbdata,
+		.link = ISC_LINK_INITIALIZER,
+	};
+	isc_refcount_increment(&async->references);
+	lk->async = async;
+
+	LOCK(&async->lock);
+	INSIST(!async->pending);
+	async->pending = true;
+	UNLOCK(&async->lock);
+
+	result = dlzimp->methods->lookupasync(
+		zonestr, namestr, dlzimp->driverarg, sdlz->dbdata, node,
+		methods, clientinfo, asynclookup_done, lk);
+	if (result == ISC_R_INPROGRESS) {
+		/*
+		 * The lookup may already have completed, but 'lk' is
+		 * only read again by the repeated find, on this thread.
+		 */
+		attachnode((dns_db_t *)sdlz, (dns_dbnode_t *)node,
+			   (dns_dbnode_t **)&lk->node DNS__DB_FILELINE);
+		lk->zone = isc_mem_strdup(async->mctx, zonestr);
+		lk->name = isc_mem_strdup(async->mctx, namestr);
+		async->waiting = true;
+		return (DNS_R_WAIT);
+	}
+
+	LOCK(&async->lock);
+	async->pending = false;
+	UNLOCK(&async->lock);
+	isc_refcount_decrement1(&async->references);
+	async->spare = lk;
+
+	if (result == ISC_R_NOTIMPLEMENTED) {
+		result = dlzimp->methods->lookup(zonestr, namestr,
+						 dlzimp->driverarg,
+						 sdlz->dbdata, node, methods,
+						 clientinfo);
+	}
+
+	return (result);
+}
+
 static isc_result_t
 getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 	    unsigned int options, dns_clientinfomethods_t *methods,
@@ -465,6 +1004,7 @@ getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 	isc_buffer_t b2;
 	char zonestr[DNS_NAME_MAXTEXT + 1];
 	bool isorigin;
+	bool cacheable;
 	dns_sdlzauthorityfunc_t authority;
 
 	REQUIRE(VALID_SDLZDB(sdlz));
@@ -474,6 +1014,22 @@ getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 		REQUIRE(!create);
 	}
 
+	/*
+	 * Without wildcard matching the lookup could give a different
+	 * answer, so it neither uses nor fills the cache.
+	 */
+	cacheable = sdlz->cache != NULL && !create &&
+		    (options & DNS_DBFIND_NOWILD) == 0;
+	if (cacheable &&
+	    cache_find(sdlz->cache, name, &sdlz->common.origin, &node))
+	{
+		if (node == NULL) {
+			return (ISC_R_NOTFOUND);
+		}
+		*nodep = node;
+		return (ISC_R_SUCCESS);
+	}
+
 	isc_buffer_init(&b, namestr, sizeof(namestr));
 	if ((sdlz->dlzimp->flags & DNS_SDLZFLAG_RELATIVEOWNER) != 0) {
 		dns_name_t relname;
@@ -517,9 +1073,7 @@ getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 	MAYBE_LOCK(sdlz->dlzimp);
 
 	/* try to lookup the host (namestr) */
-	result = sdlz->dlzimp->methods->lookup(
-		zonestr, namestr, sdlz->dlzimp->driverarg, sdlz->dbdata, node,
-		methods, clientinfo);
+	result = dolookup(sdlz, zonestr, namestr, node, methods, clientinfo);
 
 	/*
 	 * If the name was not found and DNS_DBFIND_NOWILD is not
@@ -567,10 +1121,9 @@ getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 			}
 			isc_buffer_putuint8(&b, 0);
 
-			result = sdlz->dlzimp->methods->lookup(
-				zonestr, wildstr, sdlz->dlzimp->driverarg,
-				sdlz->dbdata, node, methods, clientinfo);
-			if (result == ISC_R_SUCCESS) {
+			result = dolookup(sdlz, zonestr, wildstr, node,
+					  methods, clientinfo);
+			if (result == ISC_R_SUCCESS || result == DNS_R_WAIT) {
 				break;
 			}
 		}
@@ -578,6 +1131,12 @@ getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 
 	MAYBE_UNLOCK(sdlz->dlzimp);
 
+	if (result == DNS_R_WAIT) {
+		/* The background lookup may still hold the node */
+		detachnode(db, (dns_dbnode_t **)&node DNS__DB_FILELINE);
+		return (result);
+	}
+
 	if (result == ISC_R_NOTFOUND && (isorigin || create)) {
 		result = ISC_R_SUCCESS;
 	}
@@ -585,6 +1144,10 @@ getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 	if (result != ISC_R_SUCCESS) {
 		isc_refcount_decrementz(&node->references);
 		destroynode(node);
+		if (cacheable && result == ISC_R_NOTFOUND) {
+			cache_add(sdlz->cache, name, &sdlz->common.origin,
+				  NULL);
+		}
 		return (result);
 	}
 
@@ -607,6 +1170,10 @@ getnodedata(dns_db_t *db, const dns_name_t *name, bool create,
 		dns_name_dup(name, sdlz->common.mctx, node->name);
 	}
 
+	if (cacheable) {
+		cache_add(sdlz->cache, name, &sdlz->common.origin, node);
+	}
+
 	*nodep = node;
 	return (ISC_R_SUCCESS);
 }
@@ -1354,7 +1921,7 @@ list_tordataset(dns_rdatalist_t *rdatalist, dns_db_t *db, dns_dbnode_t *node,
  */
 
 static isc_result_t
-dns_sdlzcreateDBP(isc_mem_t *mctx, void *driverarg, void *dbdata,
+dns_sdlzcreateDBP(isc_mem_t *mctx, void *driverarg, sdlz_instance_t *inst,
 		  const dns_name_t *name, dns_rdataclass_t rdclass,
 		  dns_db_t **dbp) {
 	isc_result_t result;
@@ -1374,7 +1941,7 @@ dns_sdlzcreateDBP(isc_mem_t *mctx, void *driverarg, void *dbdata,
 		.dlzimp = imp,
 		.common = { .methods = &sdlzdb_methods,
 			.rdclass = rdclass, },
-			.dbdata = dbdata,
+			.dbdata = inst->dbdata,
 	};
 
 	/* initialize and set origin */
@@ -1389,6 +1956,10 @@ dns_sdlzcreateDBP(isc_mem_t *mctx, void *driverarg, void *dbdata,
 	/* attach to the memory context */
 	isc_mem_attach(mctx, &sdlzdb->common.mctx);
 
+	if (inst->cache != NULL) {
+		cache_attach(inst->cache, &sdlzdb->cache);
+	}
+
 	/* mark structure as valid */
 	sdlzdb->common.magic = DNS_DB_MAGIC;
 	sdlzdb->common.impmagic = SDLZDB_MAGIC;
@@ -1413,6 +1984,7 @@ dns_sdlzallowzonexfr(void *driverarg, void *dbdata, isc_mem_t *mctx,
 	isc_netaddr_t netaddr;
 	isc_result_t result;
 	dns_sdlzimplementation_t *imp;
+	sdlz_instance_t *inst = dbdata;
 
 	/*
 	 * Perform checks to make sure data is as we expect it to be.
@@ -1450,16 +2022,16 @@ dns_sdlzallowzonexfr(void *driverarg, void *dbdata, isc_mem_t *mctx,
 		isc_result_t rresult = ISC_R_SUCCESS;
 
 		MAYBE_LOCK(imp);
-		result = imp->methods->allowzonexfr(imp->driverarg, dbdata,
-						    namestr, clientstr);
+		result = imp->methods->allowzonexfr(
+			imp->driverarg, inst->dbdata, namestr, clientstr);
 		MAYBE_UNLOCK(imp);
 		/*
 		 * if zone is supported and transfers are (or might be)
 		 * allowed, build a 'bind' database driver
 		 */
 		if (result == ISC_R_SUCCESS || result == ISC_R_DEFAULT) {
-			rresult = dns_sdlzcreateDBP(mctx, driverarg, dbdata,
-						    name, rdclass, dbp);
+			rresult = dns_sdlzcreateDBP(mctx, driverarg, inst, name,
+						    rdclass, dbp);
 		}
 		if (rresult != ISC_R_SUCCESS) {
 			result = rresult;
@@ -1474,6 +2046,7 @@ static isc_result_t
 dns_sdlzcreate(isc_mem_t *mctx, const char *dlzname, unsigned int argc,
 	       char *argv[], void *driverarg, void **dbdata) {
 	dns_sdlzimplementation_t *imp;
+	sdlz_instance_t *inst = NULL;
 	isc_result_t result = ISC_R_NOTFOUND;
 
 	/* Write debugging message to log */
@@ -1488,20 +2061,24 @@ dns_sdlzcreate(isc_mem_t *mctx, const char *dlzname, unsigned int argc,
 	UNUSED(mctx);
 
 	imp = driverarg;
+	inst = isc_mem_get(imp->mctx, sizeof(*inst));
+	*inst = (sdlz_instance_t){ .dbdata = NULL };
 
 	/* If the create method exists, call it. */
 	if (imp->methods->create != NULL) {
 		MAYBE_LOCK(imp);
 		result = imp->methods->create(dlzname, argc, argv,
-					      imp->driverarg, dbdata);
+					      imp->driverarg, &inst->dbdata);
 		MAYBE_UNLOCK(imp);
 	}
 
 	/* Write debugging message to log */
 	if (result == ISC_R_SUCCESS) {
 		sdlz_log(ISC_LOG_DEBUG(2), "SDLZ driver loaded successfully.");
+		*dbdata = inst;
 	} else {
 		sdlz_log(ISC_LOG_ERROR, "SDLZ driver failed to load.");
+		isc_mem_put(imp->mctx, inst, sizeof(*inst));
 	}
 
 	return (result);
@@ -1510,18 +2087,30 @@ dns_sdlzcreate(isc_mem_t *mctx, const char *dlzname, unsigned int argc,
 static void
 dns_sdlzdestroy(void *driverdata, void **dbdata) {
 	dns_sdlzimplementation_t *imp;
+	sdlz_instance_t *inst = (sdlz_instance_t *)dbdata;
 
 	/* Write debugging message to log */
 	sdlz_log(ISC_LOG_DEBUG(2), "Unloading SDLZ driver.");
 
 	imp = driverdata;
 
+	/*
+	 * The cached nodes hold references to databases which are
+	 * still using the driver.
+	 */
+	if (inst->cache != NULL) {
+		cache_flush(inst->cache, true);
+		cache_detach(&inst->cache);
+	}
+
 	/* If the destroy method exists, call it. */
 	if (imp->methods->destroy != NULL) {
 		MAYBE_LOCK(imp);
-		imp->methods->destroy(imp->driverarg, dbdata);
+		imp->methods->destroy(imp->driverarg, inst->dbdata);
 		MAYBE_UNLOCK(imp);
 	}
+
+	isc_mem_put(imp->mctx, inst, sizeof(*inst));
 }
 
 static isc_result_t
@@ -1533,6 +2122,7 @@ dns_sdlzfindzone(void *driverarg, void *dbdata, isc_mem_t *mctx,
 	char namestr[DNS_NAME_MAXTEXT + 1];
 	isc_result_t result;
 	dns_sdlzimplementation_t *imp;
+	sdlz_instance_t *inst = dbdata;
 
 	/*
 	 * Perform checks to make sure data is as we expect it to be.
@@ -1556,7 +2146,7 @@ dns_sdlzfindzone(void *driverarg, void *dbdata, isc_mem_t *mctx,
 
 	/* Call SDLZ driver's find zone method */
 	MAYBE_LOCK(imp);
-	result = imp->methods->findzone(imp->driverarg, dbdata, namestr,
+	result = imp->methods->findzone(imp->driverarg, inst->dbdata, namestr,
 					methods, clientinfo);
 	MAYBE_UNLOCK(imp);
 
@@ -1565,7 +2155,7 @@ dns_sdlzfindzone(void *driverarg, void *dbdata, isc_mem_t *mctx,
 	 * structure to return
 	 */
 	if (result == ISC_R_SUCCESS) {
-		result = dns_sdlzcreateDBP(mctx, driverarg, dbdata, name,
+		result = dns_sdlzcreateDBP(mctx, driverarg, inst, name,
 					   rdclass, dbp);
 	}
 
@@ -1577,6 +2167,7 @@ dns_sdlzconfigure(void *driverarg, void *dbdata, dns_view_t *view,
 		  dns_dlzdb_t *dlzdb) {
 	isc_result_t result;
 	dns_sdlzimplementation_t *imp;
+	sdlz_instance_t *inst = dbdata;
 
 	REQUIRE(driverarg != NULL);
 
@@ -1586,7 +2177,7 @@ dns_sdlzconfigure(void *driverarg, void *dbdata, dns_view_t *view,
 	if (imp->methods->configure != NULL) {
 		MAYBE_LOCK(imp);
 		result = imp->methods->configure(view, dlzdb, imp->driverarg,
-						 dbdata);
+						 inst->dbdata);
 		MAYBE_UNLOCK(imp);
 	} else {
 		result = ISC_R_SUCCESS;
@@ -1608,6 +2199,7 @@ dns_sdlzssumatch(const dns_name_t *signer, const dns_name_t *name,
 	isc_buffer_t *tkey_token = NULL;
 	isc_region_t token_region = { NULL, 0 };
 	uint32_t token_len = 0;
+	sdlz_instance_t *inst = dbdata;
 	bool ret;
 
 	REQUIRE(driverarg != NULL);
@@ -1653,7 +2245,7 @@ dns_sdlzssumatch(const dns_name_t *signer, const dns_name_t *name,
 	ret = imp->methods->ssumatch(b_signer, b_name, b_addr, b_type, b_key,
 				     token_len,
 				     token_len != 0 ? token_region.base : NULL,
-				     imp->driverarg, dbdata);
+				     imp->driverarg, inst->dbdata);
 	MAYBE_UNLOCK(imp);
 	return (ret);
 }
@@ -1662,6 +2254,45 @@ static dns_dlzmethods_t sdlzmethods = { dns_sdlzcreate,	   dns_sdlzdestroy,
 					dns_sdlzfindzone,  dns_sdlzallowzonexfr,
 					dns_sdlzconfigure, dns_sdlzssumatch };
 
+/*
+ * Find the rdatalist of type 'typeval' in 'lookup', adding it if there
+ * is none yet.
+ */
+static dns_rdatalist_t *
+getrdatalist(dns_sdlzlookup_t *lookup, dns_rdatatype_t typeval,
+	     dns_ttl_t ttl) {
+	dns_rdatalist_t *rdatalist;
+	isc_mem_t *mctx = lookup->sdlz->common.mctx;
+
+	rdatalist = ISC_LIST_HEAD(lookup->lists);
+	while (rdatalist != NULL) {
+		if (rdatalist->type == typeval) {
+			break;
+		}
+		rdatalist = ISC_LIST_NEXT(rdatalist, link);
+	}
+
+	if (rdatalist == NULL) {
+		rdatalist = isc_mem_get(mctx, sizeof(dns_rdatalist_t));
+		dns_rdatalist_init(rdatalist);
+		rdatalist->rdclass = lookup->sdlz->common.rdclass;
+		rdatalist->type = typeval;
+		rdatalist->ttl = ttl;
+		ISC_LIST_APPEND(lookup->lists, rdatalist, link);
+	} else if (rdatalist->ttl > ttl) {
+		/*
+		 * BIND9 doesn't enforce all RRs in an RRset
+		 * having the same TTL, as per RFC 2136,
+		 * section 7.12. If a DLZ backend has
+		 * different TTLs, then the best
+		 * we can do is return the lowest.
+		 */
+		rdatalist->ttl = ttl;
+	}
+
+	return (rdatalist);
+}
+
 /*
  * Public functions.
  */
@@ -1694,31 +2325,7 @@ dns_sdlz_putrr(dns_sdlzlookup_t *lookup, const char *type, dns_ttl_t ttl,
 		return (result);
 	}
 
-	rdatalist = ISC_LIST_HEAD(lookup->lists);
-	while (rdatalist != NULL) {
-		if (rdatalist->type == typeval) {
-			break;
-		}
-		rdatalist = ISC_LIST_NEXT(rdatalist, link);
-	}
-
-	if (rdatalist == NULL) {
-		rdatalist = isc_mem_get(mctx, sizeof(dns_rdatalist_t));
-		dns_rdatalist_init(rdatalist);
-		rdatalist->rdclass = lookup->sdlz->common.rdclass;
-		rdatalist->type = typeval;
-		rdatalist->ttl = ttl;
-		ISC_LIST_APPEND(lookup->lists, rdatalist, link);
-	} else if (rdatalist->ttl > ttl) {
-		/*
-		 * BIND9 doesn't enforce all RRs in an RRset
-		 * having the same TTL, as per RFC 2136,
-		 * section 7.12. If a DLZ backend has
-		 * different TTLs, then the best
-		 * we can do is return the lowest.
-		 */
-		rdatalist->ttl = ttl;
-	}
+	rdatalist = getrdatalist(lookup, typeval, ttl);
 
 	rdata = isc_mem_get(mctx, sizeof(dns_rdata_t));
 	dns_rdata_init(rdata);
@@ -1786,6 +2393,56 @@ failure:
 	return (result);
 }
 
+isc_result_t
+dns_sdlz_putrdata(dns_sdlzlookup_t *lookup, dns_rdatatype_t type,
+		  dns_ttl_t ttl, const unsigned char *data,
+		  unsigned int length) {
+	dns_rdatalist_t *rdatalist;
+	dns_rdata_t *rdata;
+	isc_buffer_t source;
+	isc_buffer_t *rdatabuf = NULL;
+	isc_result_t result;
+	isc_mem_t *mctx;
+
+	REQUIRE(VALID_SDLZLOOKUP(lookup));
+	REQUIRE(data != NULL || length == 0);
+
+	if (type == 0 || dns_rdatatype_ismeta(type)) {
+		return (DNS_R_METATYPE);
+	}
+	if (length > DNS_RDATA_MAXLENGTH) {
+		return (ISC_R_RANGE);
+	}
+
+	mctx = lookup->sdlz->common.mctx;
+
+	/*
+	 * The names in uncompressed wire format data take the same
+	 * space when copied, so the record fits in 'length' bytes.
+	 */
+	isc_buffer_constinit(&source, data, length);
+	isc_buffer_add(&source, length);
+	isc_buffer_setactive(&source, length);
+	isc_buffer_allocate(mctx, &rdatabuf, length);
+
+	rdata = isc_mem_get(mctx, sizeof(dns_rdata_t));
+	dns_rdata_init(rdata);
+
+	result = dns_rdata_fromwire(rdata, lookup->sdlz->common.rdclass, type,
+				    &source, DNS_DECOMPRESS_NEVER, rdatabuf);
+	if (result != ISC_R_SUCCESS) {
+		isc_mem_put(mctx, rdata, sizeof(dns_rdata_t));
+		isc_buffer_free(&rdatabuf);
+		return (result);
+	}
+
+	rdatalist = getrdatalist(lookup, type, ttl);
+	ISC_LIST_APPEND(rdatalist->rdata, rdata, link);
+	ISC_LIST_APPEND(lookup->buffers, rdatabuf, link);
+
+	return (ISC_R_SUCCESS);
+}
+
 isc_result_t
 dns_sdlz_putnamedrr(dns_sdlzallnodes_t *allnodes, const char *name,
 		    const char *type, dns_ttl_t ttl, const char *data) {
@@ -1970,3 +2627,115 @@ dns_sdlz_setdb(dns_dlzdb_t *dlzdatabase, dns_rdataclass_t rdclass,
 				   dlzdatabase->dbdata, name, rdclass, dbp);
 	return (result);
 }
+
+isc_result_t
+dns_sdlz_setcache(dns_dlzdb_t *dlzdb, dns_ttl_t maxttl,
+		  unsigned int maxentries) {
+	sdlz_instance_t *inst = NULL;
+	sdlz_cache_t *cache = NULL;
+
+	REQUIRE(DNS_DLZ_VALID(dlzdb));
+	REQUIRE(maxttl > 0 && maxentries > 0);
+
+	if (dlzdb->implementation->methods != &sdlzmethods) {
+		return (ISC_R_NOTIMPLEMENTED);
+	}
+
+	inst = dlzdb->dbdata;
+	REQUIRE(inst->cache == NULL);
+
+	cache = isc_mem_get(dlzdb->mctx, sizeof(*cache));
+	*cache = (sdlz_cache_t){
+		.maxttl = maxttl,
+		.maxentries = maxentries,
+		.entries = ISC_LIST_INITIALIZER,
+		.magic = SDLZCACHE_MAGIC,
+	};
+	isc_mem_attach(dlzdb->mctx, &cache->mctx);
+	isc_refcount_init(&cache->references, 1);
+	isc_rwlock_init(&cache->lock);
+	isc_hashmap_create(cache->mctx, SDLZ_CACHE_HASHBITS, &cache->hashmap);
+	isc_stats_create(cache->mctx, &cache->stats,
+			 dns_dlzcachestatscounter_max);
+
+	inst->cache = cache;
+
+	return (ISC_R_SUCCESS);
+}
+
+isc_stats_t *
+dns_sdlz_getcachestats(dns_dlzdb_t *dlzdb) {
+	sdlz_instance_t *inst = NULL;
+
+	REQUIRE(DNS_DLZ_VALID(dlzdb));
+
+	if (dlzdb->implementation->methods != &sdlzmethods) {
+		return (NULL);
+	}
+
+	inst = dlzdb->dbdata;
+	if (inst->cache == NULL) {
+		return (NULL);
+	}
+
+	return (inst->cache->stats);
+}
+
+bool
+dns_sdlz_asyncsupported(dns_db_t *db) {
+	dns_sdlz_db_t *sdlz = (dns_sdlz_db_t *)db;
+
+	REQUIRE(DNS_DB_VALID(db));
+
+	return (db->methods == &sdlzdb_methods &&
+		sdlz->dlzimp->methods->lookupasync != NULL);
+}
+
+void
+dns_sdlz_asynccreate(isc_mem_t *mctx, dns_sdlzasync_t **asyncp) {
+	dns_sdlzasync_t *async = NULL;
+
+	REQUIRE(asyncp != NULL && *asyncp == NULL);
+
+	async = isc_mem_get(mctx, sizeof(*async));
+	*async = (dns_sdlzasync_t){
+		.references = 1,
+		.done = ISC_LIST_INITIALIZER,
+	};
+	isc_mem_attach(mctx, &async->mctx);
+	isc_mutex_init(&async->lock);
+	async->magic = SDLZASYNC_MAGIC;
+
+	*asyncp = async;
+}
+
+void
+dns_sdlz_asyncwait(dns_sdlzasync_t *async, isc_loop_t *loop, isc_job_cb cb,
+		   void *cbarg) {
+	REQUIRE(VALID_SDLZASYNC(async));
+	REQUIRE(async->waiting);
+	REQUIRE(loop != NULL && cb != NULL);
+
+	async->waiting = false;
+
+	LOCK(&async->lock);
+	if (async->pending) {
+		INSIST(async->cb == NULL);
+		async->loop = loop;
+		async->cb = cb;
+		async->cbarg = cbarg;
+		cb = NULL;
+	}
+	UNLOCK(&async->lock);
+
+	if (cb != NULL) {
+		isc_async_run(loop, cb, cbarg);
+	}
+}
+
+void
+dns_sdlz_asyncdetach(dns_sdlzasync_t **asyncp) {
+	REQUIRE(asyncp != NULL && VALID_SDLZASYNC(*asyncp));
+
+	async_detach(asyncp);
+}
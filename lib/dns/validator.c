@@ -40,9 +40,12 @@
 #include <dns/rdataset.h>
 #include <dns/rdatatype.h>
 #include <dns/resolver.h>
+#include <dns/stats.h>
 #include <dns/validator.h>
 #include <dns/view.h>
 
+#include "probes.h"
+
 /*! \file
  * \brief
  * Basic processing sequences:
@@ -63,6 +66,11 @@
  * validate_nx:       attempt to prove a negative response.
  */
 
+/*%
+ * Maximum number of zone cuts prefetch_chain() will walk up.
+ */
+#define VALIDATOR_PREFETCH_MAXLEVELS 8
+
 #define VALIDATOR_MAGIC	   ISC_MAGIC('V', 'a', 'l', '?')
 #define VALID_VALIDATOR(v) ISC_MAGIC_VALID(v, VALIDATOR_MAGIC)
 
@@ -204,6 +212,29 @@ marksecure(dns_validator_t *val) {
 	val->secure = true;
 }
 
+static void
+validator_trace_start(dns_validator_t *val) {
+	if (!LIBDNS_VALIDATOR_START_ENABLED()) {
+		return;
+	}
+
+	char namebuf[DNS_NAME_FORMATSIZE];
+	dns_name_format(val->name, namebuf, sizeof(namebuf));
+	LIBDNS_VALIDATOR_START(val, val->parent, namebuf, val->type);
+}
+
+static void
+validator_trace_done(dns_validator_t *val,
+		     isc_result_t result ISC_ATTR_UNUSED) {
+	if (!LIBDNS_VALIDATOR_DONE_ENABLED()) {
+		return;
+	}
+
+	char namebuf[DNS_NAME_FORMATSIZE];
+	dns_name_format(val->name, namebuf, sizeof(namebuf));
+	LIBDNS_VALIDATOR_DONE(val, namebuf, val->type, result);
+}
+
 static void
 validator_done_cb(void *arg) {
 	dns_validator_t *val = arg;
@@ -226,6 +257,8 @@ validator_done(dns_validator_t *val, isc_result_t result) {
 	val->attributes |= VALATTR_COMPLETE;
 	val->result = result;
 
+	validator_trace_done(val, result);
+
 	dns_validator_ref(val);
 	isc_async_run(val->loop, validator_done_cb, val);
 }
@@ -961,6 +994,177 @@ create_fetch(dns_validator_t *val, dns_name_t *name, dns_rdatatype_t type,
 	return (result);
 }
 
+/*%
+ * A speculative fetch issued by prefetch_chain().  It is not tied to
+ * the validator's lifetime: its only purpose is to get the answer into
+ * the cache (or to be joined by the fetch the validator issues later).
+ */
+typedef struct valprefetch {
+	isc_mem_t *mctx;
+	dns_fetch_t *fetch;
+	dns_rdataset_t rdataset;
+	dns_rdataset_t sigrdataset;
+} valprefetch_t;
+
+static void
+fetch_callback_prefetch(void *arg) {
+	dns_fetchresponse_t *resp = (dns_fetchresponse_t *)arg;
+	valprefetch_t *prefetch = resp->arg;
+
+	INSIST(resp->type == FETCHDONE);
+
+	if (resp->node != NULL) {
+		dns_db_detachnode(resp->db, &resp->node);
+	}
+	if (resp->db != NULL) {
+		dns_db_detach(&resp->db);
+	}
+	isc_mem_putanddetach(&resp->mctx, resp, sizeof(*resp));
+
+	if (dns_rdataset_isassociated(&prefetch->rdataset)) {
+		dns_rdataset_disassociate(&prefetch->rdataset);
+	}
+	if (dns_rdataset_isassociated(&prefetch->sigrdataset)) {
+		dns_rdataset_disassociate(&prefetch->sigrdataset);
+	}
+	dns_resolver_destroyfetch(&prefetch->fetch);
+	isc_mem_putanddetach(&prefetch->mctx, prefetch, sizeof(*prefetch));
+}
+
+/*%
+ * Start a speculative fetch for 'name'/'type' unless the answer (or a
+ * negative answer) is already in the cache.
+ */
+static void
+prefetch_one(dns_validator_t *val, dns_name_t *name, dns_rdatatype_t type) {
+	dns_fixedname_t fixed;
+	dns_rdataset_t rdataset;
+	valprefetch_t *prefetch = NULL;
+	unsigned int fopts = 0;
+	isc_time_t now = isc_time_now();
+	isc_result_t result;
+
+	result = dns_resolver_getbadcache(val->view->resolver, name, type,
+					  &now);
+	if (result == ISC_R_SUCCESS) {
+		return;
+	}
+
+	dns_rdataset_init(&rdataset);
+	result = dns_view_find(val->view, name, type, 0, DNS_DBFIND_PENDINGOK,
+			       false, false, NULL, NULL,
+			       dns_fixedname_initname(&fixed), &rdataset,
+			       NULL);
+	if (dns_rdataset_isassociated(&rdataset)) {
+		dns_rdataset_disassociate(&rdataset);
+	}
+	switch (result) {
+	case ISC_R_SUCCESS:
+	case DNS_R_NCACHENXDOMAIN:
+	case DNS_R_NCACHENXRRSET:
+	case DNS_R_EMPTYNAME:
+	case DNS_R_NXRRSET:
+		return;
+	default:
+		break;
+	}
+
+	if ((val->options & DNS_VALIDATOR_NOCDFLAG) != 0) {
+		fopts |= DNS_FETCHOPT_NOCDFLAG;
+	}
+	if ((val->options & DNS_VALIDATOR_NONTA) != 0) {
+		fopts |= DNS_FETCHOPT_NONTA;
+	}
+
+	validator_logcreate(val, name, type, "prefetch_chain", "fetch");
+
+	prefetch = isc_mem_get(val->view->mctx, sizeof(*prefetch));
+	*prefetch = (valprefetch_t){ 0 };
+	isc_mem_attach(val->view->mctx, &prefetch->mctx);
+	dns_rdataset_init(&prefetch->rdataset);
+	dns_rdataset_init(&prefetch->sigrdataset);
+
+	result = dns_resolver_createfetch(
+		val->view->resolver, name, type, NULL, NULL, NULL, NULL, 0,
+		fopts, 0, NULL, val->loop, fetch_callback_prefetch, prefetch,
+		&prefetch->rdataset, &prefetch->sigrdataset, &prefetch->fetch);
+	if (result != ISC_R_SUCCESS) {
+		isc_mem_putanddetach(&prefetch->mctx, prefetch,
+				     sizeof(*prefetch));
+		return;
+	}
+
+	dns_resolver_incstats(val->view->resolver,
+			      dns_resstatscounter_valprefetch);
+}
+
+/*%
+ * The sequential walk up the chain of trust needs the DNSKEY and DS
+ * RRsets of every zone between the signer and the closest trust anchor,
+ * and waits for one round trip per level when the cache is cold.  Use
+ * the zone cuts already known from the delegation path to issue all of
+ * those fetches at once; the walk then finds the answers in the cache
+ * or joins the fetches that are still in progress.
+ */
+static void
+prefetch_chain(dns_validator_t *val) {
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	dns_rdata_rrsig_t sig;
+	dns_fixedname_t fanchor, fzone, fcut;
+	dns_name_t *anchor = dns_fixedname_initname(&fanchor);
+	dns_name_t *zone = dns_fixedname_initname(&fzone);
+	dns_name_t *cut = dns_fixedname_initname(&fcut);
+	dns_rdataset_t nsset;
+	unsigned int levels = 0;
+	isc_result_t result;
+
+	if (!val->view->chainprefetch || val->parent != NULL ||
+	    val->type == dns_rdatatype_dnskey || val->type == dns_rdatatype_ds)
+	{
+		return;
+	}
+
+	result = dns_rdataset_first(val->sigrdataset);
+	if (result != ISC_R_SUCCESS) {
+		return;
+	}
+	dns_rdataset_current(val->sigrdataset, &rdata);
+	result = dns_rdata_tostruct(&rdata, &sig, NULL);
+	RUNTIME_CHECK(result == ISC_R_SUCCESS);
+	dns_name_copy(&sig.signer, zone);
+
+	result = dns_keytable_finddeepestmatch(val->keytable, zone, anchor);
+	if (result != ISC_R_SUCCESS) {
+		return;
+	}
+
+	dns_rdataset_init(&nsset);
+	while (levels++ < VALIDATOR_PREFETCH_MAXLEVELS) {
+		prefetch_one(val, zone, dns_rdatatype_dnskey);
+		if (dns_name_equal(zone, anchor)) {
+			break;
+		}
+		prefetch_one(val, zone, dns_rdatatype_ds);
+
+		/*
+		 * Move up to the closest enclosing zone cut that is
+		 * known locally; never look above the trust anchor.
+		 */
+		result = dns_view_findzonecut(val->view, zone, cut, NULL, 0,
+					      DNS_DBFIND_NOEXACT, false, true,
+					      &nsset, NULL);
+		if (dns_rdataset_isassociated(&nsset)) {
+			dns_rdataset_disassociate(&nsset);
+		}
+		if (result != ISC_R_SUCCESS ||
+		    !dns_name_issubdomain(cut, anchor))
+		{
+			dns_name_copy(anchor, cut);
+		}
+		dns_name_copy(cut, zone);
+	}
+}
+
 /*%
  * Start a subvalidation process.
  */
@@ -2916,6 +3120,7 @@ validator_start(void *arg) {
 	}
 
 	validator_log(val, ISC_LOG_DEBUG(3), "starting");
+	validator_trace_start(val);
 
 	if (val->rdataset != NULL && val->sigrdataset != NULL) {
 		isc_result_t saved_result;
@@ -2929,6 +3134,7 @@ validator_start(void *arg) {
 
 		INSIST(dns_rdataset_isassociated(val->rdataset));
 		INSIST(dns_rdataset_isassociated(val->sigrdataset));
+		prefetch_chain(val);
 		if (selfsigned_dnskey(val)) {
 			result = validate_dnskey(val);
 		} else {
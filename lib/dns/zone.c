@@ -22,7 +22,9 @@
 #include <isc/file.h>
 #include <isc/hash.h>
 #include <isc/hashmap.h>
+#include <isc/heap.h>
 #include <isc/hex.h>
+#include <isc/histo.h>
 #include <isc/loop.h>
 #include <isc/md.h>
 #include <isc/mutex.h>
@@ -39,9 +41,11 @@
 #include <isc/string.h>
 #include <isc/thread.h>
 #include <isc/tid.h>
-#include <isc/timer.h>
+#include <isc/time.h>
+#include <isc/timerwheel.h>
 #include <isc/tls.h>
 #include <isc/util.h>
+#include <isc/work.h>
 
 #include <dns/acl.h>
 #include <dns/adb.h>
@@ -156,6 +160,7 @@
 #define DNS_DEFAULT_IDLEOUT 3600       /*%< 1 hour */
 #define MAX_XFER_TIME	    (2 * 3600) /*%< Documented default is 2 hours */
 #define RESIGN_DELAY	    3600       /*%< 1 hour */
+#define NSEC3CACHE_SIZE	    128	       /*%< NSEC3 hash cache entries */
 
 #ifndef DNS_MAX_EXPIRE
 #define DNS_MAX_EXPIRE 14515200 /*%< 24 weeks */
@@ -165,6 +170,10 @@
 #define DNS_DUMP_DELAY 900 /*%< 15 minutes */
 #endif			   /* ifndef DNS_DUMP_DELAY */
 
+#ifndef DNS_COMPACT_DUMP_DELAY
+#define DNS_COMPACT_DUMP_DELAY 30 /*%< journal over twice its target size */
+#endif				  /* ifndef DNS_COMPACT_DUMP_DELAY */
+
 typedef struct dns_notify dns_notify_t;
 typedef struct dns_checkds dns_checkds_t;
 typedef struct dns_stub dns_stub_t;
@@ -179,6 +188,7 @@ typedef ISC_LIST(dns_nsec3chain_t) dns_nsec3chainlist_t;
 typedef struct dns_nsfetch dns_nsfetch_t;
 typedef struct dns_keyfetch dns_keyfetch_t;
 typedef struct dns_asyncload dns_asyncload_t;
+typedef struct dns_compact dns_compact_t;
 typedef struct dns_include dns_include_t;
 
 #define DNS_ZONE_CHECKLOCK
@@ -245,6 +255,55 @@ struct dns_keymgmt {
  */
 #define DNS_KEYMGMT_HASH_BITS 12
 
+/*%
+ * Source addresses for outgoing NOTIFY, checkds and zone transfer
+ * requests.  Almost every zone leaves these at the wildcard defaults,
+ * so the zone only allocates its own copy once one of them is set to
+ * something else; until then default_sources is used.
+ */
+typedef struct dns_zonesources {
+	isc_sockaddr_t notifysrc4;
+	isc_sockaddr_t notifysrc6;
+	isc_sockaddr_t parentalsrc4;
+	isc_sockaddr_t parentalsrc6;
+	isc_sockaddr_t xfrsource4;
+	isc_sockaddr_t xfrsource6;
+} dns_zonesources_t;
+
+#define SOURCE_ANY4                                  \
+	{                                            \
+		.type.sin.sin_family = AF_INET,      \
+		.length = sizeof(struct sockaddr_in), \
+		.link = ISC_LINK_INITIALIZER,        \
+	}
+#define SOURCE_ANY6                                   \
+	{                                             \
+		.type.sin6.sin6_family = AF_INET6,    \
+		.length = sizeof(struct sockaddr_in6), \
+		.link = ISC_LINK_INITIALIZER,         \
+	}
+
+static const dns_zonesources_t default_sources = {
+	.notifysrc4 = SOURCE_ANY4,
+	.notifysrc6 = SOURCE_ANY6,
+	.parentalsrc4 = SOURCE_ANY4,
+	.parentalsrc6 = SOURCE_ANY6,
+	.xfrsource4 = SOURCE_ANY4,
+	.xfrsource6 = SOURCE_ANY6,
+};
+
+/*%
+ * Parental agents and the state of outstanding checkds queries.  Only
+ * zones with a dnssec-policy use these; allocated on first use.
+ */
+typedef struct dns_zoneparental {
+	dns_remote_t parentals;
+	dns_dnsseckeylist_t checkds_ok;
+	uint32_t nsfetchcount;
+	uint32_t parent_nscount;
+	ISC_LIST(dns_checkds_t) checkds_requests;
+} dns_zoneparental_t;
+
 struct dns_zone {
 	/* Unlocked */
 	unsigned int magic;
@@ -264,7 +323,7 @@ struct dns_zone {
 	dns_zonemgr_t *zmgr;
 	ISC_LINK(dns_zone_t) link; /* Used by zmgr. */
 	isc_loop_t *loop;
-	isc_timer_t *timer;
+	isc_wheeltimer_t timer;
 	isc_refcount_t irefs;
 	dns_name_t origin;
 	char *masterfile;
@@ -276,6 +335,8 @@ struct dns_zone {
 	const dns_master_style_t *masterstyle;
 	char *journal;
 	int32_t journalsize;
+	dns_journalmap_t *journalmap;
+	dns_loaddiff_t *loaddiff; /* ixfr-from-differences load */
 	dns_rdataclass_t rdclass;
 	dns_zonetype_t type;
 	atomic_uint_fast64_t flags;
@@ -313,21 +374,12 @@ struct dns_zone {
 
 	dns_remote_t primaries;
 
-	dns_remote_t parentals;
-	dns_dnsseckeylist_t checkds_ok;
+	dns_zoneparental_t *parental; /* NULL until first used */
 	dns_checkdstype_t checkdstype;
-	uint32_t nsfetchcount;
-	uint32_t parent_nscount;
 
 	dns_remote_t notify;
 	dns_notifytype_t notifytype;
-	isc_sockaddr_t notifyfrom;
-	isc_sockaddr_t notifysrc4;
-	isc_sockaddr_t notifysrc6;
-	isc_sockaddr_t parentalsrc4;
-	isc_sockaddr_t parentalsrc6;
-	isc_sockaddr_t xfrsource4;
-	isc_sockaddr_t xfrsource6;
+	atomic_ptr(dns_zonesources_t) sources; /* NULL while wildcards */
 	isc_sockaddr_t sourceaddr;
 	dns_xfrin_t *xfr;	    /* loop locked */
 	dns_tsigkey_t *tsigkey;	    /* key used for xfr */
@@ -343,7 +395,6 @@ struct dns_zone {
 	bool zero_no_soa_ttl;
 	dns_severity_t check_names;
 	ISC_LIST(dns_notify_t) notifies;
-	ISC_LIST(dns_checkds_t) checkds_requests;
 	dns_request_t *request;
 	dns_loadctx_t *loadctx;
 	dns_dumpctx_t *dumpctx;
@@ -384,6 +435,8 @@ struct dns_zone {
 	isc_stats_t *requeststats;
 	dns_stats_t *rcvquerystats;
 	dns_stats_t *dnssecsignstats;
+	atomic_ptr(isc_histomulti_t) latencystats;
+	atomic_ptr(dns_nsec3cache_t) nsec3cache;
 	uint32_t notifydelay;
 	dns_isselffunc_t isself;
 	void *isselfarg;
@@ -449,6 +502,14 @@ struct dns_zone {
 	 */
 	dns_updatemethod_t updatemethod;
 
+	/*%
+	 * Dynamic updates arriving within 'updatewindow' milliseconds
+	 * of each other are committed together; 'updatequeue' holds the
+	 * pending updates and is owned by the update code.
+	 */
+	uint32_t updatewindow;
+	void *updatequeue;
+
 	/*%
 	 * whether ixfr is requested
 	 */
@@ -478,15 +539,10 @@ struct dns_zone {
 	dns_ttl_t maxttl;
 
 	/*
-	 * Inline zone signing state.
+	 * Inline zone signing state, only set while
+	 * receive_secure_serial() is in progress.
 	 */
-	dns_diff_t rss_diff;
-	dns_dbversion_t *rss_newver;
-	dns_dbversion_t *rss_oldver;
-	dns_db_t *rss_db;
-	dns_zone_t *rss_raw;
 	struct rss *rss;
-	dns_update_state_t *rss_state;
 
 	isc_stats_t *gluecachestats;
 };
@@ -546,6 +602,8 @@ typedef enum {
 						      * notify due to the zone
 						      * just being loaded for
 						      * the first time. */
+	DNS_ZONEFLG_COMPACTING = 0x100000000U, /*%< journal compaction in
+						* progress */
 	DNS_ZONEFLG___MAX = UINT64_MAX, /* trick to make the ENUM 64-bit wide */
 } dns_zoneflg_t;
 
@@ -591,6 +649,7 @@ struct dns_zonemgr {
 	isc_nm_t *netmgr;
 	uint32_t workers;
 	isc_mem_t **mctxpool;
+	isc_timerwheel_t **wheels;
 	isc_ratelimiter_t *checkdsrl;
 	isc_ratelimiter_t *notifyrl;
 	isc_ratelimiter_t *refreshrl;
@@ -613,6 +672,19 @@ struct dns_zonemgr {
 	unsigned int serialqueryrate;
 	unsigned int startupserialqueryrate;
 
+	/*
+	 * Zones waiting to send a SOA query, grouped by primary.  Locked
+	 * by refreshlock.
+	 */
+	isc_mutex_t refreshlock;
+	isc_hashmap_t *refreshqs;
+	isc_heap_t *refreshheap;
+	unsigned int serialquerybatch;
+	size_t refreshbacklog;
+	size_t refreshneeded;
+	size_t refreshtokens;
+	bool refreshshutdown;
+
 	/* Locked by urlock. */
 	/* LRU cache */
 	struct dns_unreachable unreachable[UNREACH_CACHE_SIZE];
@@ -690,6 +762,7 @@ struct dns_load {
 	dns_db_t *db;
 	isc_time_t loadtime;
 	dns_rdatacallbacks_t callbacks;
+	dns_rdatacallbacks_t diffcallbacks;
 };
 
 /*%
@@ -791,6 +864,18 @@ struct dns_asyncload {
 	void *loaded_arg;
 };
 
+/*%
+ *	Hold state for a background journal compaction.
+ */
+struct dns_compact {
+	dns_zone_t *zone;
+	char *journal;
+	uint32_t serial;
+	int32_t target;
+	dns_journalcompact_t *jc;
+	isc_result_t result;
+};
+
 /*%
  * Reference to an include file encountered during loading
  */
@@ -974,6 +1059,8 @@ static void
 setrl(isc_ratelimiter_t *rl, unsigned int *rate, unsigned int value);
 static void
 zone_journal_compact(dns_zone_t *zone, dns_db_t *db, uint32_t serial);
+static bool
+zone_journal_oversize(dns_zone_t *zone);
 static isc_result_t
 zone_journal_rollforward(dns_zone_t *zone, dns_db_t *db, bool *needdump,
 			 bool *fixjournal);
@@ -1078,6 +1165,67 @@ inc_stats(dns_zone_t *zone, isc_statscounter_t counter) {
 	}
 }
 
+/*
+ * Return the source addresses in use by 'zone'.
+ */
+static const dns_zonesources_t *
+zone_sources(dns_zone_t *zone) {
+	const dns_zonesources_t *sources = atomic_load_acquire(&zone->sources);
+
+	return (sources != NULL ? sources : &default_sources);
+}
+
+/*
+ * Called before setting one of the source addresses of 'zone' to
+ * 'addr'; 'dflt' is the default value of that address.  Returns NULL
+ * if there is nothing to do, because the zone still uses the defaults
+ * and 'addr' is the default; otherwise returns the zone's own copy of
+ * the source addresses, allocating it if needed.
+ *
+ * zone_sources() reads the pointer without the zone lock, so a new
+ * copy is fully initialized before it is published.
+ */
+static dns_zonesources_t *
+zone_needsources(dns_zone_t *zone, const isc_sockaddr_t *addr,
+		 const isc_sockaddr_t *dflt) {
+	dns_zonesources_t *sources = NULL;
+
+	REQUIRE(LOCKED_ZONE(zone));
+
+	sources = atomic_load_relaxed(&zone->sources);
+	if (sources == NULL) {
+		if (isc_sockaddr_equal(addr, dflt)) {
+			return (NULL);
+		}
+		sources = isc_mem_get(zone->mctx, sizeof(*sources));
+		*sources = default_sources;
+		atomic_store_release(&zone->sources, sources);
+	}
+
+	return (sources);
+}
+
+/*
+ * Return the parental agents and checkds state of 'zone', allocating
+ * it on first use.
+ */
+static dns_zoneparental_t *
+zone_parental(dns_zone_t *zone) {
+	REQUIRE(LOCKED_ZONE(zone));
+
+	if (zone->parental == NULL) {
+		zone->parental = isc_mem_get(zone->mctx,
+					     sizeof(*zone->parental));
+		*zone->parental = (dns_zoneparental_t){
+			.parentals = { .magic = DNS_REMOTE_MAGIC },
+			.checkds_ok = ISC_LIST_INITIALIZER,
+			.checkds_requests = ISC_LIST_INITIALIZER,
+		};
+	}
+
+	return (zone->parental);
+}
+
 /***
  ***	Public functions.
  ***/
@@ -1127,7 +1275,6 @@ dns_zone_create(dns_zone_t **zonep, isc_mem_t *mctx, unsigned int tid) {
 		.notifytime = now,
 		.newincludes = ISC_LIST_INITIALIZER,
 		.notifies = ISC_LIST_INITIALIZER,
-		.checkds_requests = ISC_LIST_INITIALIZER,
 		.signing = ISC_LIST_INITIALIZER,
 		.nsec3chain = ISC_LIST_INITIALIZER,
 		.setnsec3param_queue = ISC_LIST_INITIALIZER,
@@ -1146,15 +1293,8 @@ dns_zone_create(dns_zone_t **zonep, isc_mem_t *mctx, unsigned int tid) {
 	isc_refcount_init(&zone->references, 1);
 	isc_refcount_init(&zone->irefs, 0);
 	dns_name_init(&zone->origin, NULL);
-	isc_sockaddr_any(&zone->notifysrc4);
-	isc_sockaddr_any6(&zone->notifysrc6);
-	isc_sockaddr_any(&zone->parentalsrc4);
-	isc_sockaddr_any6(&zone->parentalsrc6);
-	isc_sockaddr_any(&zone->xfrsource4);
-	isc_sockaddr_any6(&zone->xfrsource6);
 
 	zone->primaries = r;
-	zone->parentals = r;
 	zone->notify = r;
 	zone->defaultkasp = NULL;
 
@@ -1187,11 +1327,14 @@ static void
 zone_free(dns_zone_t *zone) {
 	dns_signing_t *signing = NULL;
 	dns_nsec3chain_t *nsec3chain = NULL;
+	dns_nsec3cache_t *nsec3cache = NULL;
+	dns_zonesources_t *sources = NULL;
+	isc_histomulti_t *latencystats = NULL;
 	dns_include_t *include = NULL;
 
 	REQUIRE(DNS_ZONE_VALID(zone));
 	REQUIRE(!LOCKED_ZONE(zone));
-	REQUIRE(zone->timer == NULL);
+	REQUIRE(!isc_wheeltimer_initialized(&zone->timer));
 	REQUIRE(zone->zmgr == NULL);
 
 	isc_refcount_destroy(&zone->references);
@@ -1206,6 +1349,7 @@ zone_free(dns_zone_t *zone) {
 	INSIST(zone->statelist == NULL);
 	INSIST(zone->view == NULL);
 	INSIST(zone->prev_view == NULL);
+	INSIST(zone->updatequeue == NULL);
 
 	/* Unmanaged objects */
 	for (struct np3 *npe = ISC_LIST_HEAD(zone->setnsec3param_queue);
@@ -1259,8 +1403,16 @@ zone_free(dns_zone_t *zone) {
 	if (zone->defaultkasp != NULL) {
 		dns_kasp_detach(&zone->defaultkasp);
 	}
-	if (!ISC_LIST_EMPTY(zone->checkds_ok)) {
-		clear_keylist(&zone->checkds_ok, zone->mctx);
+	if (zone->parental != NULL) {
+		INSIST(ISC_LIST_EMPTY(zone->parental->checkds_requests));
+		clear_keylist(&zone->parental->checkds_ok, zone->mctx);
+		dns_remote_clear(&zone->parental->parentals);
+		isc_mem_put(zone->mctx, zone->parental,
+			    sizeof(*zone->parental));
+	}
+	sources = atomic_load_acquire(&zone->sources);
+	if (sources != NULL) {
+		isc_mem_put(zone->mctx, sources, sizeof(*sources));
 	}
 
 	zone->journalsize = -1;
@@ -1268,6 +1420,12 @@ zone_free(dns_zone_t *zone) {
 		isc_mem_free(zone->mctx, zone->journal);
 	}
 	zone->journal = NULL;
+	if (zone->journalmap != NULL) {
+		dns_journalmap_detach(&zone->journalmap);
+	}
+	if (zone->loaddiff != NULL) {
+		dns_loaddiff_destroy(&zone->loaddiff);
+	}
 	if (zone->stats != NULL) {
 		isc_stats_detach(&zone->stats);
 	}
@@ -1280,6 +1438,14 @@ zone_free(dns_zone_t *zone) {
 	if (zone->dnssecsignstats != NULL) {
 		dns_stats_detach(&zone->dnssecsignstats);
 	}
+	latencystats = atomic_load_acquire(&zone->latencystats);
+	if (latencystats != NULL) {
+		isc_histomulti_destroy(&latencystats);
+	}
+	nsec3cache = atomic_load_acquire(&zone->nsec3cache);
+	if (nsec3cache != NULL) {
+		dns_nsec3cache_destroy(&nsec3cache);
+	}
 	if (zone->db != NULL) {
 		zone_detachdb(zone);
 	}
@@ -1293,7 +1459,6 @@ zone_free(dns_zone_t *zone) {
 	}
 	zone_freedbargs(zone);
 
-	dns_zone_setparentals(zone, NULL, NULL, NULL, NULL, 0);
 	dns_zone_setprimaries(zone, NULL, NULL, NULL, NULL, 0);
 	dns_zone_setalsonotify(zone, NULL, NULL, NULL, NULL, 0);
 
@@ -1816,6 +1981,69 @@ dns_zone_getjournal(dns_zone_t *zone) {
 	return (zone->journal);
 }
 
+isc_result_t
+dns_zone_getjournalmap(dns_zone_t *zone, dns_journalmap_t **mapp) {
+	isc_result_t result;
+	dns_journalmap_t *map = NULL, *prev = NULL, *old = NULL;
+	char *journal = NULL;
+
+	REQUIRE(DNS_ZONE_VALID(zone));
+	REQUIRE(mapp != NULL && *mapp == NULL);
+
+	LOCK_ZONE(zone);
+	if (zone->journal == NULL) {
+		UNLOCK_ZONE(zone);
+		return (ISC_R_NOTFOUND);
+	}
+	if (zone->journalmap != NULL) {
+		if (strcmp(dns_journalmap_filename(zone->journalmap),
+			   zone->journal) == 0)
+		{
+			dns_journalmap_attach(zone->journalmap, &prev);
+		} else {
+			dns_journalmap_detach(&zone->journalmap);
+		}
+	}
+	journal = isc_mem_strdup(zone->mctx, zone->journal);
+	UNLOCK_ZONE(zone);
+
+	if (prev != NULL && dns_journalmap_current(prev)) {
+		*mapp = prev;
+		result = ISC_R_SUCCESS;
+		goto cleanup;
+	}
+
+	/*
+	 * Map the journal without holding the zone lock; the transactions
+	 * that were in the previous snapshot do not need to be indexed
+	 * again.
+	 */
+	result = dns_journalmap_create(zone->mctx, journal, prev, &map);
+	if (prev != NULL) {
+		dns_journalmap_detach(&prev);
+	}
+	if (result != ISC_R_SUCCESS) {
+		goto cleanup;
+	}
+
+	LOCK_ZONE(zone);
+	if (zone->journal != NULL && strcmp(zone->journal, journal) == 0) {
+		old = zone->journalmap;
+		zone->journalmap = NULL;
+		dns_journalmap_attach(map, &zone->journalmap);
+	}
+	UNLOCK_ZONE(zone);
+
+	if (old != NULL) {
+		dns_journalmap_detach(&old);
+	}
+	*mapp = map;
+
+cleanup:
+	isc_mem_free(zone->mctx, journal);
+	return (result);
+}
+
 /*
  * Return true iff the zone is "dynamic", in the sense that the zone's
  * master file (if any) is written by the server, rather than being
@@ -2588,12 +2816,67 @@ dns_zone_setrawdata(dns_zone_t *zone, dns_masterrawheader_t *header) {
 	UNLOCK_ZONE(zone);
 }
 
+/*
+ * With ixfr-from-differences, compare the zone being loaded into 'db'
+ * with the current zone database as it is loaded, so that generating
+ * the diff afterwards does not require comparing every name.  Returns
+ * the callbacks to load the zone with.
+ *
+ * The zone is presumed to be locked.
+ */
+static dns_rdatacallbacks_t *
+zone_loaddiff(dns_zone_t *zone, dns_db_t *db, dns_load_t *load) {
+	dns_rdatacallbacks_t *callbacks = &load->callbacks;
+	isc_result_t result;
+
+	INSIST(zone->loaddiff == NULL);
+
+	if (zone->journal == NULL ||
+	    !DNS_ZONE_OPTION(zone, DNS_ZONEOPT_IXFRFROMDIFFS))
+	{
+		return (callbacks);
+	}
+
+	ZONEDB_LOCK(&zone->dblock, isc_rwlocktype_read);
+	if (zone->db != NULL) {
+		result = dns_loaddiff_create(zone->mctx, zone->db, db,
+					     &zone->loaddiff);
+		if (result == ISC_R_SUCCESS) {
+			dns_loaddiff_callbacks(zone->loaddiff, &load->callbacks,
+					       &load->diffcallbacks);
+			callbacks = &load->diffcallbacks;
+		}
+	}
+	ZONEDB_UNLOCK(&zone->dblock, isc_rwlocktype_read);
+
+	return (callbacks);
+}
+
+/*
+ * Generate the diff containing the changes to make version 'ver' of 'db'
+ * from the current zone database, using the comparison made while 'db'
+ * was loaded if there is one.
+ */
+static isc_result_t
+zone_diff(dns_zone_t *zone, dns_db_t *db, dns_dbversion_t *ver,
+	  const char *journal, dns_diff_t *diff) {
+	if (zone->loaddiff != NULL &&
+	    dns_loaddiff_current(zone->loaddiff, zone->db, db))
+	{
+		return (dns_loaddiff_diff(&zone->loaddiff, diff, db, ver,
+					  journal));
+	}
+
+	return (dns_db_diffx(diff, db, ver, zone->db, NULL, journal));
+}
+
 static isc_result_t
 zone_startload(dns_db_t *db, dns_zone_t *zone, isc_time_t loadtime) {
 	isc_result_t result;
 	isc_result_t tresult;
 	unsigned int options;
 	dns_load_t *load = isc_mem_get(zone->mctx, sizeof(*load));
+	dns_rdatacallbacks_t *callbacks = NULL;
 
 	ENTER;
 
@@ -2621,10 +2904,12 @@ zone_startload(dns_db_t *db, dns_zone_t *zone, isc_time_t loadtime) {
 		goto cleanup;
 	}
 
+	callbacks = zone_loaddiff(zone, db, load);
+
 	if (zone->zmgr != NULL && zone->db != NULL) {
 		result = dns_master_loadfileasync(
 			zone->masterfile, dns_db_origin(db), dns_db_origin(db),
-			zone->rdclass, options, 0, &load->callbacks, zone->loop,
+			zone->rdclass, options, 0, callbacks, zone->loop,
 			zone_loaddone, load, &zone->loadctx,
 			zone_registerinclude, zone, zone->mctx,
 			zone->masterformat, zone->maxttl);
@@ -2637,11 +2922,11 @@ zone_startload(dns_db_t *db, dns_zone_t *zone, isc_time_t loadtime) {
 		FILE *stream = UNCONST(zone->stream);
 		result = dns_master_loadstream(
 			stream, &zone->origin, &zone->origin, zone->rdclass,
-			options, &load->callbacks, zone->mctx);
+			options, callbacks, zone->mctx);
 	} else {
 		result = dns_master_loadfile(
 			zone->masterfile, &zone->origin, &zone->origin,
-			zone->rdclass, options, 0, &load->callbacks,
+			zone->rdclass, options, 0, callbacks,
 			zone_registerinclude, zone, zone->mctx,
 			zone->masterformat, zone->maxttl);
 	}
@@ -4700,13 +4985,13 @@ maybe_send_secure(dns_zone_t *zone) {
 }
 
 static bool
-zone_unchanged(dns_db_t *db1, dns_db_t *db2, isc_mem_t *mctx) {
+zone_unchanged(dns_zone_t *zone, dns_db_t *db) {
 	isc_result_t result;
 	bool answer = false;
 	dns_diff_t diff;
 
-	dns_diff_init(mctx, &diff);
-	result = dns_db_diffx(&diff, db1, NULL, db2, NULL, NULL);
+	dns_diff_init(zone->mctx, &diff);
+	result = zone_diff(zone, db, NULL, NULL, &diff);
 	if (result == ISC_R_SUCCESS && ISC_LIST_EMPTY(diff.tuples)) {
 		answer = true;
 	}
@@ -4995,7 +5280,7 @@ zone_postload(dns_zone_t *zone, dns_db_t *db, isc_time_t loadtime,
 				INSIST(zone->raw == NULL);
 
 				if (serial == oldserial &&
-				    zone_unchanged(zone->db, db, zone->mctx))
+				    zone_unchanged(zone, db))
 				{
 					dns_zone_logc(zone,
 						      DNS_LOGCATEGORY_ZONELOAD,
@@ -5292,6 +5577,9 @@ cleanup:
 	}
 
 done:
+	if (zone->loaddiff != NULL) {
+		dns_loaddiff_destroy(&zone->loaddiff);
+	}
 	DNS_ZONE_CLRFLAG(zone, DNS_ZONEFLG_LOADPENDING);
 	/*
 	 * If this is an inline-signed zone and we were called for the raw
@@ -5780,104 +6068,136 @@ dns_zone_getkeyopts(dns_zone_t *zone) {
 
 isc_result_t
 dns_zone_setxfrsource4(dns_zone_t *zone, const isc_sockaddr_t *xfrsource) {
+	dns_zonesources_t *sources = NULL;
+
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
-	zone->xfrsource4 = *xfrsource;
+	sources = zone_needsources(zone, xfrsource, &default_sources.xfrsource4);
+	if (sources != NULL) {
+		sources->xfrsource4 = *xfrsource;
+	}
 	UNLOCK_ZONE(zone);
 
 	return (ISC_R_SUCCESS);
 }
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getxfrsource4(dns_zone_t *zone) {
 	REQUIRE(DNS_ZONE_VALID(zone));
-	return (&zone->xfrsource4);
+	return (&zone_sources(zone)->xfrsource4);
 }
 
 isc_result_t
 dns_zone_setxfrsource6(dns_zone_t *zone, const isc_sockaddr_t *xfrsource) {
+	dns_zonesources_t *sources = NULL;
+
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
-	zone->xfrsource6 = *xfrsource;
+	sources = zone_needsources(zone, xfrsource, &default_sources.xfrsource6);
+	if (sources != NULL) {
+		sources->xfrsource6 = *xfrsource;
+	}
 	UNLOCK_ZONE(zone);
 
 	return (ISC_R_SUCCESS);
 }
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getxfrsource6(dns_zone_t *zone) {
 	REQUIRE(DNS_ZONE_VALID(zone));
-	return (&zone->xfrsource6);
+	return (&zone_sources(zone)->xfrsource6);
 }
 
 isc_result_t
 dns_zone_setparentalsrc4(dns_zone_t *zone, const isc_sockaddr_t *parentalsrc) {
+	dns_zonesources_t *sources = NULL;
+
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
-	zone->parentalsrc4 = *parentalsrc;
+	sources = zone_needsources(zone, parentalsrc,
+				   &default_sources.parentalsrc4);
+	if (sources != NULL) {
+		sources->parentalsrc4 = *parentalsrc;
+	}
 	UNLOCK_ZONE(zone);
 
 	return (ISC_R_SUCCESS);
 }
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getparentalsrc4(dns_zone_t *zone) {
 	REQUIRE(DNS_ZONE_VALID(zone));
-	return (&zone->parentalsrc4);
+	return (&zone_sources(zone)->parentalsrc4);
 }
 
 isc_result_t
 dns_zone_setparentalsrc6(dns_zone_t *zone, const isc_sockaddr_t *parentalsrc) {
+	dns_zonesources_t *sources = NULL;
+
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
-	zone->parentalsrc6 = *parentalsrc;
+	sources = zone_needsources(zone, parentalsrc,
+				   &default_sources.parentalsrc6);
+	if (sources != NULL) {
+		sources->parentalsrc6 = *parentalsrc;
+	}
 	UNLOCK_ZONE(zone);
 
 	return (ISC_R_SUCCESS);
 }
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getparentalsrc6(dns_zone_t *zone) {
 	REQUIRE(DNS_ZONE_VALID(zone));
-	return (&zone->parentalsrc6);
+	return (&zone_sources(zone)->parentalsrc6);
 }
 
 isc_result_t
 dns_zone_setnotifysrc4(dns_zone_t *zone, const isc_sockaddr_t *notifysrc) {
+	dns_zonesources_t *sources = NULL;
+
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
-	zone->notifysrc4 = *notifysrc;
+	sources = zone_needsources(zone, notifysrc, &default_sources.notifysrc4);
+	if (sources != NULL) {
+		sources->notifysrc4 = *notifysrc;
+	}
 	UNLOCK_ZONE(zone);
 
 	return (ISC_R_SUCCESS);
 }
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getnotifysrc4(dns_zone_t *zone) {
 	REQUIRE(DNS_ZONE_VALID(zone));
-	return (&zone->notifysrc4);
+	return (&zone_sources(zone)->notifysrc4);
 }
 
 isc_result_t
 dns_zone_setnotifysrc6(dns_zone_t *zone, const isc_sockaddr_t *notifysrc) {
+	dns_zonesources_t *sources = NULL;
+
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
-	zone->notifysrc6 = *notifysrc;
+	sources = zone_needsources(zone, notifysrc, &default_sources.notifysrc6);
+	if (sources != NULL) {
+		sources->notifysrc6 = *notifysrc;
+	}
 	UNLOCK_ZONE(zone);
 
 	return (ISC_R_SUCCESS);
 }
 
-isc_sockaddr_t *
+const isc_sockaddr_t *
 dns_zone_getnotifysrc6(dns_zone_t *zone) {
 	REQUIRE(DNS_ZONE_VALID(zone));
-	return (&zone->notifysrc6);
+	return (&zone_sources(zone)->notifysrc6);
 }
 
 void
@@ -5977,11 +6297,21 @@ dns_zone_setparentals(dns_zone_t *zone, isc_sockaddr_t *addresses,
 		      isc_sockaddr_t *sources, dns_name_t **keynames,
 		      dns_name_t **tlsnames, uint32_t count) {
 	dns_remote_t remote;
+	dns_zoneparental_t *parental = NULL;
 
 	REQUIRE(DNS_ZONE_VALID(zone));
 
 	LOCK_ZONE(zone);
 
+	/*
+	 * Don't allocate the parental state just to record that
+	 * there are no parental agents.
+	 */
+	if (zone->parental == NULL && count == 0) {
+		goto unlock;
+	}
+	parental = zone_parental(zone);
+
 	remote.magic = DNS_REMOTE_MAGIC;
 	remote.addresses = addresses;
 	remote.sources = sources;
@@ -5989,11 +6319,11 @@ dns_zone_setparentals(dns_zone_t *zone, isc_sockaddr_t *addresses,
 	remote.tlsnames = tlsnames;
 	remote.addrcnt = count;
 
-	if (dns_remote_equal(&zone->parentals, &remote)) {
+	if (dns_remote_equal(&parental->parentals, &remote)) {
 		goto unlock;
 	}
 
-	dns_remote_clear(&zone->parentals);
+	dns_remote_clear(&parental->parentals);
 
 	/*
 	 * If count == 0, don't allocate any space for parentals.
@@ -6005,8 +6335,8 @@ dns_zone_setparentals(dns_zone_t *zone, isc_sockaddr_t *addresses,
 	/*
 	 * Now set up the parentals and parental key lists.
 	 */
-	dns_remote_init(&zone->parentals, count, addresses, sources, keynames,
-			tlsnames, true, zone->mctx);
+	dns_remote_init(&parental->parentals, count, addresses, sources,
+			keynames, tlsnames, true, zone->mctx);
 
 	dns_zone_log(zone, ISC_LOG_NOTICE, "checkds: set %u parentals", count);
 
@@ -11037,7 +11367,8 @@ again:
 	if (secure != NULL) {
 		UNLOCK_ZONE(secure);
 	}
-	zone_needdump(zone, DNS_DUMP_DELAY);
+	zone_needdump(zone, zone_journal_oversize(zone) ? DNS_COMPACT_DUMP_DELAY
+							: DNS_DUMP_DELAY);
 	UNLOCK_ZONE(zone);
 }
 
@@ -11240,18 +11571,16 @@ zone_journal_rollforward(dns_zone_t *zone, dns_db_t *db, bool *needdump,
 	}
 }
 
-static void
-zone_journal_compact(dns_zone_t *zone, dns_db_t *db, uint32_t serial) {
+/*
+ * The size the journal is compacted to: "max-journal-size", or by default
+ * twice the size of the zone.
+ */
+static int32_t
+zone_journal_target(dns_zone_t *zone, dns_db_t *db) {
 	isc_result_t result;
 	int32_t journalsize;
 	dns_dbversion_t *ver = NULL;
 	uint64_t dbsize;
-	uint32_t options = 0;
-
-	INSIST(LOCKED_ZONE(zone));
-	if (inline_raw(zone)) {
-		INSIST(LOCKED_ZONE(zone->secure));
-	}
 
 	journalsize = zone->journalsize;
 	if (journalsize == -1) {
@@ -11268,20 +11597,52 @@ zone_journal_compact(dns_zone_t *zone, dns_db_t *db, uint32_t serial) {
 			journalsize = (int32_t)dbsize * 2;
 		}
 	}
-	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_FIXJOURNAL)) {
-		options |= DNS_JOURNAL_COMPACTALL;
-		DNS_ZONE_CLRFLAG(zone, DNS_ZONEFLG_FIXJOURNAL);
-		zone_debuglog(zone, __func__, 1, "repair full journal");
-	} else {
-		zone_debuglog(zone, __func__, 1, "target journal size %d",
-			      journalsize);
+
+	return (journalsize);
+}
+
+/*
+ * The journal can only be compacted up to the last serial number that was
+ * dumped to the zone file.  Once it has grown to twice its target size,
+ * the next dump is brought forward so that it can be compacted sooner.
+ */
+static bool
+zone_journal_oversize(dns_zone_t *zone) {
+	dns_db_t *db = NULL;
+	int32_t target;
+	off_t size;
+
+	REQUIRE(LOCKED_ZONE(zone));
+
+	if (zone->journal == NULL || zone->masterfile == NULL ||
+	    DNS_ZONE_FLAG(zone, DNS_ZONEFLG_COMPACTING) ||
+	    isc_file_getsize(zone->journal, &size) != ISC_R_SUCCESS)
+	{
+		return (false);
 	}
-	result = dns_journal_compact(zone->mctx, zone->journal, serial, options,
-				     journalsize);
+
+	ZONEDB_LOCK(&zone->dblock, isc_rwlocktype_read);
+	if (zone->db != NULL) {
+		dns_db_attach(zone->db, &db);
+	}
+	ZONEDB_UNLOCK(&zone->dblock, isc_rwlocktype_read);
+	if (db == NULL) {
+		return (false);
+	}
+
+	target = ISC_MAX(zone_journal_target(zone, db), DNS_JOURNAL_SIZE_MIN);
+	dns_db_detach(&db);
+
+	return ((uint64_t)size / 2 >= (uint64_t)target);
+}
+
+static void
+zone_journal_compact_log(dns_zone_t *zone, isc_result_t result) {
 	switch (result) {
 	case ISC_R_SUCCESS:
 	case ISC_R_NOSPACE:
 	case ISC_R_NOTFOUND:
+	case ISC_R_CANCELED:
 		dns_zone_log(zone, ISC_LOG_DEBUG(3), "dns_journal_compact: %s",
 			     isc_result_totext(result));
 		break;
@@ -11293,6 +11654,147 @@ zone_journal_compact(dns_zone_t *zone, dns_db_t *db, uint32_t serial) {
 	}
 }
 
+/*
+ * Copy the part of the journal that is kept on a work thread, then
+ * finish the compaction on the zone's loop, where the journal is written.
+ */
+static void
+zone_compact_work(void *arg) {
+	dns_compact_t *compact = arg;
+
+	compact->result = dns_journal_compact_begin(
+		compact->zone->mctx, compact->journal, compact->serial,
+		compact->target, &compact->jc);
+}
+
+static void
+zone_compact_done(void *arg) {
+	dns_compact_t *compact = arg;
+	dns_zone_t *zone = compact->zone;
+	isc_result_t result = compact->result;
+	isc_nanosecs_t elapsed = 0, start;
+
+	LOCK_ZONE(zone);
+	if (result == ISC_R_NOTIMPLEMENTED && zone->xfr == NULL) {
+		/*
+		 * Old format journals are converted as they are compacted,
+		 * which can only be done in one go.
+		 */
+		result = dns_journal_compact(zone->mctx, compact->journal,
+					     compact->serial, 0,
+					     compact->target);
+	} else if (compact->jc == NULL) {
+		/* Nothing to do, or an error */
+	} else if (zone->xfr != NULL) {
+		/*
+		 * An incoming transfer may be writing to the journal; try
+		 * again once it has finished.
+		 */
+		dns_journal_compact_cancel(&compact->jc);
+		zone->compact_serial = compact->serial;
+		DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_NEEDCOMPACT);
+		result = ISC_R_CANCELED;
+	} else if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING) ||
+		   zone->journal == NULL ||
+		   strcmp(zone->journal, compact->journal) != 0)
+	{
+		dns_journal_compact_cancel(&compact->jc);
+		result = ISC_R_CANCELED;
+	} else {
+		start = isc_time_monotonic();
+		result = dns_journal_compact_finish(&compact->jc, &elapsed);
+		zone_debuglog(zone, __func__, 1,
+			      "compacted journal in %" PRIu64
+			      " ms, finished in %" PRIu64 " ms",
+			      (uint64_t)(elapsed / NS_PER_MS),
+			      (uint64_t)((isc_time_monotonic() - start) /
+					 NS_PER_MS));
+	}
+	DNS_ZONE_CLRFLAG(zone, DNS_ZONEFLG_COMPACTING);
+
+	if (result == ISC_R_SUCCESS && elapsed != 0) {
+		inc_stats(zone, dns_zonestatscounter_jnlcompact);
+		if (zone->stats != NULL) {
+			isc_stats_update_if_greater(
+				zone->stats,
+				dns_zonestatscounter_jnlcompacttime,
+				elapsed / NS_PER_MS);
+		}
+	} else if (result != ISC_R_SUCCESS && result != ISC_R_CANCELED &&
+		   result != ISC_R_NOTFOUND)
+	{
+		inc_stats(zone, dns_zonestatscounter_jnlcompactfail);
+	}
+	zone_journal_compact_log(zone, result);
+	UNLOCK_ZONE(zone);
+
+	isc_mem_free(zone->mctx, compact->journal);
+	isc_mem_put(zone->mctx, compact, sizeof(*compact));
+	dns_zone_idetach(&zone);
+}
+
+static void
+zone_compact_start(void *arg) {
+	dns_compact_t *compact = arg;
+
+	isc_work_enqueue(compact->zone->loop, zone_compact_work,
+			 zone_compact_done, compact);
+}
+
+static void
+zone_journal_compact(dns_zone_t *zone, dns_db_t *db, uint32_t serial) {
+	isc_result_t result;
+	int32_t journalsize;
+	uint32_t options = 0;
+	dns_compact_t *compact = NULL;
+
+	INSIST(LOCKED_ZONE(zone));
+	if (inline_raw(zone)) {
+		INSIST(LOCKED_ZONE(zone->secure));
+	}
+
+	/*
+	 * Only one compaction at a time; the next time the zone is dumped
+	 * the journal will be compacted further.
+	 */
+	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_COMPACTING)) {
+		zone_debuglog(zone, __func__, 1,
+			      "journal compaction already in progress");
+		return;
+	}
+
+	journalsize = zone_journal_target(zone, db);
+	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_FIXJOURNAL)) {
+		options |= DNS_JOURNAL_COMPACTALL;
+		DNS_ZONE_CLRFLAG(zone, DNS_ZONEFLG_FIXJOURNAL);
+		zone_debuglog(zone, __func__, 1, "repair full journal");
+	} else {
+		zone_debuglog(zone, __func__, 1, "target journal size %d",
+			      journalsize);
+	}
+
+	/*
+	 * Journals that need repairing are rewritten here; otherwise, the
+	 * journal is compacted in the background.
+	 */
+	if (options == 0 && zone->loop != NULL && zone->journal != NULL) {
+		compact = isc_mem_get(zone->mctx, sizeof(*compact));
+		*compact = (dns_compact_t){
+			.journal = isc_mem_strdup(zone->mctx, zone->journal),
+			.serial = serial,
+			.target = journalsize,
+		};
+		zone_iattach(zone, &compact->zone);
+		DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_COMPACTING);
+		isc_async_run(zone->loop, zone_compact_start, compact);
+		return;
+	}
+
+	result = dns_journal_compact(zone->mctx, zone->journal, serial, options,
+				     journalsize);
+	zone_journal_compact_log(zone, result);
+}
+
 isc_result_t
 dns_zone_flush(dns_zone_t *zone) {
 	isc_result_t result = ISC_R_SUCCESS;
@@ -11738,8 +12240,12 @@ checkds_cancel(dns_zone_t *zone) {
 
 	REQUIRE(LOCKED_ZONE(zone));
 
-	for (checkds = ISC_LIST_HEAD(zone->checkds_requests); checkds != NULL;
-	     checkds = ISC_LIST_NEXT(checkds, link))
+	if (zone->parental == NULL) {
+		return;
+	}
+
+	for (checkds = ISC_LIST_HEAD(zone->parental->checkds_requests);
+	     checkds != NULL; checkds = ISC_LIST_NEXT(checkds, link))
 	{
 		if (checkds->find != NULL) {
 			dns_adb_cancelfind(checkds->find);
@@ -11913,11 +12419,11 @@ notify_isself(dns_zone_t *zone, isc_sockaddr_t *dst) {
 
 	switch (isc_sockaddr_pf(dst)) {
 	case PF_INET:
-		src = zone->notifysrc4;
+		src = zone_sources(zone)->notifysrc4;
 		isc_sockaddr_any(&any);
 		break;
 	case PF_INET6:
-		src = zone->notifysrc6;
+		src = zone_sources(zone)->notifysrc6;
 		isc_sockaddr_any6(&any);
 		break;
 	default:
@@ -12186,7 +12692,7 @@ notify_send_toaddr(void *arg) {
 
 			src = notify->src;
 			if (isc_sockaddr_equal(&src, &any)) {
-				src = notify->zone->notifysrc4;
+				src = zone_sources(notify->zone)->notifysrc4;
 			}
 		}
 		break;
@@ -12197,7 +12703,7 @@ notify_send_toaddr(void *arg) {
 
 			src = notify->src;
 			if (isc_sockaddr_equal(&src, &any)) {
-				src = notify->zone->notifysrc6;
+				src = zone_sources(notify->zone)->notifysrc6;
 			}
 		}
 		break;
@@ -13882,13 +14388,268 @@ detach:
 
 struct soaquery {
 	dns_zone_t *zone;
-	isc_rlevent_t *rlevent;
+	isc_stdtime_t expire;
+	unsigned int index;
+	bool canceled;
+	ISC_LINK(struct soaquery) link;
 };
 
+/*
+ * SOA queries waiting to be sent are queued by the zone manager per
+ * primary, most urgent (closest to expiring) zone first.  The primaries
+ * are kept in a heap of their own, again ordered by their most urgent
+ * zone.  Each refresh ratelimiter event sends a batch of up to
+ * 'serialquerybatch' queries to the primary at the top of the heap, so
+ * that queries to the same primary go out back to back and share the
+ * dispatches of the request manager.
+ */
+typedef struct refreshq {
+	isc_sockaddr_t primary;
+	isc_heap_t *queries;
+	size_t count;
+	unsigned int index;
+} refreshq_t;
+
+typedef struct refreshtoken {
+	dns_zonemgr_t *zmgr;
+	isc_rlevent_t *rlevent;
+} refreshtoken_t;
+
+static bool
+soaquery_higher(void *v1, void *v2) {
+	struct soaquery *sq1 = v1, *sq2 = v2;
+
+	return (sq1->expire < sq2->expire);
+}
+
+static void
+soaquery_index(void *what, unsigned int index) {
+	struct soaquery *sq = what;
+
+	sq->index = index;
+}
+
+static bool
+refreshq_higher(void *v1, void *v2) {
+	refreshq_t *q1 = v1, *q2 = v2;
+
+	return (soaquery_higher(isc_heap_element(q1->queries, 1),
+				isc_heap_element(q2->queries, 1)));
+}
+
+static void
+refreshq_index(void *what, unsigned int index) {
+	refreshq_t *q = what;
+
+	q->index = index;
+}
+
+static bool
+refreshq_match(void *node, const void *key) {
+	refreshq_t *q = node;
+
+	return (isc_sockaddr_equal(&q->primary, key));
+}
+
+static size_t
+refreshq_batches(dns_zonemgr_t *zmgr, refreshq_t *q) {
+	return ((q->count + zmgr->serialquerybatch - 1) /
+		zmgr->serialquerybatch);
+}
+
+static void
+refreshq_destroy(dns_zonemgr_t *zmgr, refreshq_t **qp) {
+	refreshq_t *q = *qp;
+	isc_result_t result;
+
+	*qp = NULL;
+
+	isc_heap_delete(zmgr->refreshheap, q->index);
+	result = isc_hashmap_delete(zmgr->refreshqs,
+				    isc_sockaddr_hash(&q->primary, false),
+				    refreshq_match, &q->primary);
+	INSIST(result == ISC_R_SUCCESS);
+	isc_heap_destroy(&q->queries);
+	isc_mem_put(zmgr->mctx, q, sizeof(*q));
+}
+
+static void
+refresh_batch(void *arg);
+
+/*
+ * Request ratelimiter events until there is one for each batch waiting
+ * to be sent.  Called with refreshlock held; the events are requested
+ * after it has been released.
+ */
+static size_t
+refresh_tokens(dns_zonemgr_t *zmgr) {
+	size_t tokens = 0;
+
+	if (zmgr->refreshneeded > zmgr->refreshtokens) {
+		tokens = zmgr->refreshneeded - zmgr->refreshtokens;
+		zmgr->refreshtokens = zmgr->refreshneeded;
+	}
+
+	return (tokens);
+}
+
+static void
+refresh_request(dns_zonemgr_t *zmgr, size_t tokens) {
+	isc_loop_t *loop = isc_loop_main(zmgr->loopmgr);
+
+	for (size_t i = 0; i < tokens; i++) {
+		refreshtoken_t *token = isc_mem_get(zmgr->mctx,
+						    sizeof(*token));
+		isc_result_t result;
+
+		*token = (refreshtoken_t){ .zmgr = NULL };
+		dns_zonemgr_attach(zmgr, &token->zmgr);
+
+		result = isc_ratelimiter_enqueue(zmgr->refreshrl, loop,
+						 refresh_batch, token,
+						 &token->rlevent);
+		if (result != ISC_R_SUCCESS) {
+			/*
+			 * The zone manager is shutting down, and the queued
+			 * queries will be canceled.
+			 */
+			dns_zonemgr_detach(&token->zmgr);
+			isc_mem_put(zmgr->mctx, token, sizeof(*token));
+
+			LOCK(&zmgr->refreshlock);
+			zmgr->refreshtokens -= tokens - i;
+			UNLOCK(&zmgr->refreshlock);
+			break;
+		}
+	}
+}
+
+static isc_result_t
+refresh_enqueue(dns_zonemgr_t *zmgr, const isc_sockaddr_t *primary,
+		struct soaquery *sq) {
+	refreshq_t *q = NULL;
+	isc_result_t result;
+	uint32_t hashval = isc_sockaddr_hash(primary, false);
+	size_t batches, tokens;
+
+	LOCK(&zmgr->refreshlock);
+	if (zmgr->refreshshutdown) {
+		UNLOCK(&zmgr->refreshlock);
+		return (ISC_R_SHUTTINGDOWN);
+	}
+
+	result = isc_hashmap_find(zmgr->refreshqs, hashval, refreshq_match,
+				  primary, (void **)&q);
+	if (result == ISC_R_SUCCESS) {
+		batches = refreshq_batches(zmgr, q);
+		isc_heap_insert(q->queries, sq);
+		q->count++;
+		isc_heap_increased(zmgr->refreshheap, q->index);
+	} else {
+		q = isc_mem_get(zmgr->mctx, sizeof(*q));
+		*q = (refreshq_t){ .primary = *primary };
+		isc_heap_create(zmgr->mctx, soaquery_higher, soaquery_index, 0,
+				&q->queries);
+		result = isc_hashmap_add(zmgr->refreshqs, hashval,
+					 refreshq_match, &q->primary, q, NULL);
+		INSIST(result == ISC_R_SUCCESS);
+
+		batches = 0;
+		isc_heap_insert(q->queries, sq);
+		q->count++;
+		isc_heap_insert(zmgr->refreshheap, q);
+	}
+
+	zmgr->refreshbacklog++;
+	zmgr->refreshneeded += refreshq_batches(zmgr, q) - batches;
+	tokens = refresh_tokens(zmgr);
+	UNLOCK(&zmgr->refreshlock);
+
+	refresh_request(zmgr, tokens);
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+refresh_batch(void *arg) {
+	refreshtoken_t *token = arg;
+	dns_zonemgr_t *zmgr = token->zmgr;
+	ISC_LIST(struct soaquery) batch = ISC_LIST_INITIALIZER;
+	struct soaquery *sq = NULL;
+	bool canceled = token->rlevent->canceled;
+	refreshq_t *q = NULL;
+
+	isc_rlevent_free(&token->rlevent);
+	isc_mem_put(zmgr->mctx, token, sizeof(*token));
+
+	LOCK(&zmgr->refreshlock);
+	INSIST(zmgr->refreshtokens > 0);
+	zmgr->refreshtokens--;
+
+	q = isc_heap_element(zmgr->refreshheap, 1);
+	if (!canceled && q != NULL) {
+		for (size_t i = 0; i < zmgr->serialquerybatch; i++) {
+			sq = isc_heap_element(q->queries, 1);
+			if (sq == NULL) {
+				break;
+			}
+			isc_heap_delete(q->queries, 1);
+			q->count--;
+			ISC_LIST_APPEND(batch, sq, link);
+			zmgr->refreshbacklog--;
+		}
+		zmgr->refreshneeded--;
+
+		if (q->count == 0) {
+			refreshq_destroy(zmgr, &q);
+		} else {
+			isc_heap_decreased(zmgr->refreshheap, q->index);
+		}
+	}
+	UNLOCK(&zmgr->refreshlock);
+
+	while ((sq = ISC_LIST_HEAD(batch)) != NULL) {
+		ISC_LIST_UNLINK(batch, sq, link);
+		isc_async_run(sq->zone->loop, soa_query, sq);
+	}
+
+	dns_zonemgr_detach(&zmgr);
+}
+
+/*
+ * Cancel all the queued SOA queries on shutdown.
+ */
+static void
+refresh_cancel(dns_zonemgr_t *zmgr) {
+	ISC_LIST(struct soaquery) canceled = ISC_LIST_INITIALIZER;
+	struct soaquery *sq = NULL;
+	refreshq_t *q = NULL;
+
+	LOCK(&zmgr->refreshlock);
+	zmgr->refreshshutdown = true;
+	while ((q = isc_heap_element(zmgr->refreshheap, 1)) != NULL) {
+		while ((sq = isc_heap_element(q->queries, 1)) != NULL) {
+			isc_heap_delete(q->queries, 1);
+			sq->canceled = true;
+			ISC_LIST_APPEND(canceled, sq, link);
+		}
+		refreshq_destroy(zmgr, &q);
+	}
+	zmgr->refreshbacklog = 0;
+	zmgr->refreshneeded = 0;
+	UNLOCK(&zmgr->refreshlock);
+
+	while ((sq = ISC_LIST_HEAD(canceled)) != NULL) {
+		ISC_LIST_UNLINK(canceled, sq, link);
+		isc_async_run(sq->zone->loop, soa_query, sq);
+	}
+}
+
 static void
 queue_soa_query(dns_zone_t *zone) {
 	isc_result_t result;
 	struct soaquery *sq = NULL;
+	isc_sockaddr_t primary;
 
 	ENTER;
 	/*
@@ -13902,17 +14663,20 @@ queue_soa_query(dns_zone_t *zone) {
 	}
 
 	sq = isc_mem_get(zone->mctx, sizeof(*sq));
-	*sq = (struct soaquery){ .zone = NULL };
+	*sq = (struct soaquery){
+		.expire = isc_time_seconds(&zone->expiretime),
+		.link = ISC_LINK_INITIALIZER,
+	};
 
 	/* Shows in the statistics channel the duration of the current step. */
 	zone->xfrintime = isc_time_now();
 
 	/*
-	 * Attach so that we won't clean up until the event is delivered.
+	 * Attach so that we won't clean up until the query is sent.
 	 */
 	zone_iattach(zone, &sq->zone);
-	result = isc_ratelimiter_enqueue(zone->zmgr->refreshrl, zone->loop,
-					 soa_query, sq, &sq->rlevent);
+	primary = dns_remote_curraddr(&zone->primaries);
+	result = refresh_enqueue(zone->zmgr, &primary, sq);
 	if (result != ISC_R_SUCCESS) {
 		zone_idetach(&sq->zone);
 		isc_mem_put(zone->mctx, sq, sizeof(*sq));
@@ -13942,7 +14706,7 @@ soa_query(void *arg) {
 	ENTER;
 
 	LOCK_ZONE(zone);
-	if (sq->rlevent->canceled || DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING) ||
+	if (sq->canceled || DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING) ||
 	    zone->view->requestmgr == NULL)
 	{
 		if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING)) {
@@ -14044,7 +14808,8 @@ again:
 
 			zone->sourceaddr = sourceaddr;
 			if (isc_sockaddr_equal(&sourceaddr, &any)) {
-				zone->sourceaddr = zone->xfrsource4;
+				zone->sourceaddr =
+					zone_sources(zone)->xfrsource4;
 			}
 		}
 		break;
@@ -14055,7 +14820,8 @@ again:
 
 			zone->sourceaddr = sourceaddr;
 			if (isc_sockaddr_equal(&zone->sourceaddr, &any)) {
-				zone->sourceaddr = zone->xfrsource6;
+				zone->sourceaddr =
+					zone_sources(zone)->xfrsource6;
 			}
 		}
 		break;
@@ -14138,7 +14904,6 @@ cleanup:
 	if (do_queue_xfrin) {
 		queue_xfrin(zone);
 	}
-	isc_rlevent_free(&sq->rlevent);
 	isc_mem_put(zone->mctx, sq, sizeof(*sq));
 	dns_zone_idetach(&zone);
 	return;
@@ -14334,7 +15099,8 @@ ns_query(dns_zone_t *zone, dns_rdataset_t *soardataset, dns_stub_t *stub) {
 
 			zone->sourceaddr = sourceaddr;
 			if (isc_sockaddr_equal(&zone->sourceaddr, &any)) {
-				zone->sourceaddr = zone->xfrsource4;
+				zone->sourceaddr =
+					zone_sources(zone)->xfrsource4;
 			}
 		}
 		break;
@@ -14345,7 +15111,8 @@ ns_query(dns_zone_t *zone, dns_rdataset_t *soardataset, dns_stub_t *stub) {
 
 			zone->sourceaddr = sourceaddr;
 			if (isc_sockaddr_equal(&zone->sourceaddr, &any)) {
-				zone->sourceaddr = zone->xfrsource6;
+				zone->sourceaddr =
+					zone_sources(zone)->xfrsource6;
 			}
 		}
 		break;
@@ -14495,9 +15262,9 @@ zone_shutdown(void *arg) {
 
 	forward_cancel(zone);
 
-	if (zone->timer != NULL) {
+	if (isc_wheeltimer_initialized(&zone->timer)) {
 		isc_refcount_decrement(&zone->irefs);
-		isc_timer_destroy(&zone->timer);
+		isc_wheeltimer_invalidate(&zone->timer);
 	}
 
 	/*
@@ -14553,30 +15320,36 @@ zone_timer(void *arg) {
 static void
 zone_timer_stop(dns_zone_t *zone) {
 	zone_debuglog(zone, __func__, 10, "stop zone timer");
-	if (zone->timer != NULL) {
-		isc_timer_stop(zone->timer);
+	if (isc_wheeltimer_initialized(&zone->timer)) {
+		isc_wheeltimer_stop(&zone->timer);
 	}
 }
 
+/*
+ * The zone maintenance events have a resolution of one second, so the
+ * zone timers live on the zone manager's per-loop timer wheels rather
+ * than each having an isc_timer of their own.
+ */
 static void
 zone_timer_set(dns_zone_t *zone, isc_time_t *next, isc_time_t *now) {
-	isc_interval_t interval;
+	uint32_t seconds = 0;
 
-	if (isc_time_compare(next, now) <= 0) {
-		isc_interval_set(&interval, 0, 0);
-	} else {
-		isc_time_subtract(next, now, &interval);
+	if (isc_time_compare(next, now) > 0) {
+		uint64_t us = isc_time_microdiff(next, now);
+		seconds = (us + US_PER_SEC - 1) / US_PER_SEC;
 	}
 
 	if (zone->loop == NULL) {
 		zone_debuglog(zone, __func__, 10, "zone is not managed");
-	} else if (zone->timer == NULL) {
-		isc_refcount_increment0(&zone->irefs);
-		isc_timer_create(zone->loop, zone_timer, zone, &zone->timer);
+		return;
 	}
-	if (zone->timer != NULL) {
-		isc_timer_start(zone->timer, isc_timertype_once, &interval);
+
+	if (!isc_wheeltimer_initialized(&zone->timer)) {
+		isc_refcount_increment0(&zone->irefs);
+		isc_wheeltimer_init(&zone->timer, zone->zmgr->wheels[zone->tid],
+				    zone_timer, zone);
 	}
+	isc_wheeltimer_start(&zone->timer, seconds);
 }
 
 static void
@@ -15078,12 +15851,11 @@ dns_zone_notifyreceive(dns_zone_t *zone, isc_sockaddr_t *from,
 
 	/*
 	 * If we got this far and there was a refresh in progress just
-	 * let it complete.  Record where we got the notify from so we
-	 * can perform a refresh check when the current one completes
+	 * let it complete.  Record that we got a notify so we can
+	 * perform a refresh check when the current one completes
 	 */
 	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_REFRESH)) {
 		DNS_ZONE_SETFLAG(zone, DNS_ZONEFLG_NEEDREFRESH);
-		zone->notifyfrom = *from;
 		UNLOCK_ZONE(zone);
 		if (have_serial) {
 			dns_zone_log(zone, ISC_LOG_INFO,
@@ -15105,7 +15877,6 @@ dns_zone_notifyreceive(dns_zone_t *zone, isc_sockaddr_t *from,
 		dns_zone_log(zone, ISC_LOG_INFO, "notify from %s: no serial",
 			     fromtext);
 	}
-	zone->notifyfrom = *from;
 	UNLOCK_ZONE(zone);
 
 	if (to != NULL) {
@@ -15752,11 +16523,23 @@ fail:
 	notify_destroy(notify, false);
 }
 
+/*
+ * 'db' is the raw zone database passed to receive_secure_db(), or the
+ * secure zone database being updated by receive_secure_serial().  The
+ * remaining receive_secure_serial() state is kept here rather than in
+ * the zone so that it only exists while an update is in progress.
+ */
 struct rss {
 	dns_zone_t *zone;
 	dns_db_t *db;
 	uint32_t serial;
 	ISC_LINK(struct rss) link;
+
+	dns_diff_t diff;
+	dns_dbversion_t *newver;
+	dns_dbversion_t *oldver;
+	dns_zone_t *raw;
+	dns_update_state_t *state;
 };
 
 static void
@@ -16185,7 +16968,7 @@ receive_secure_serial(void *arg) {
 		UNLOCK_ZONE(zone);
 	} else {
 		zone->rss = rss;
-		dns_diff_init(zone->mctx, &zone->rss_diff);
+		dns_diff_init(zone->mctx, &rss->diff);
 
 		/*
 		 * zone->db may be NULL, if the load from disk failed.
@@ -16193,14 +16976,14 @@ receive_secure_serial(void *arg) {
 		result = ISC_R_SUCCESS;
 		ZONEDB_LOCK(&zone->dblock, isc_rwlocktype_read);
 		if (zone->db != NULL) {
-			dns_db_attach(zone->db, &zone->rss_db);
+			dns_db_attach(zone->db, &rss->db);
 		} else {
 			result = ISC_R_FAILURE;
 		}
 		ZONEDB_UNLOCK(&zone->dblock, isc_rwlocktype_read);
 
 		if (result == ISC_R_SUCCESS && zone->raw != NULL) {
-			dns_zone_attach(zone->raw, &zone->rss_raw);
+			dns_zone_attach(zone->raw, &rss->raw);
 		} else {
 			result = ISC_R_FAILURE;
 		}
@@ -16218,8 +17001,8 @@ receive_secure_serial(void *arg) {
 		 * If that fails, then we'll fall back to a direct comparison
 		 * between raw and secure zones.
 		 */
-		CHECK(dns_journal_open(zone->rss_raw->mctx,
-				       zone->rss_raw->journal,
+		CHECK(dns_journal_open(rss->raw->mctx,
+				       rss->raw->journal,
 				       DNS_JOURNAL_WRITE, &rjournal));
 
 		result = dns_journal_open(zone->mctx, zone->journal,
@@ -16247,34 +17030,34 @@ receive_secure_serial(void *arg) {
 			dns_journal_destroy(&sjournal);
 		}
 
-		dns_db_currentversion(zone->rss_db, &zone->rss_oldver);
-		CHECK(dns_db_newversion(zone->rss_db, &zone->rss_newver));
+		dns_db_currentversion(rss->db, &rss->oldver);
+		CHECK(dns_db_newversion(rss->db, &rss->newver));
 
 		/*
 		 * Try to apply diffs from the raw zone's journal to the secure
 		 * zone.  If that fails, we recover by syncing up the databases
 		 * directly.
 		 */
-		result = sync_secure_journal(zone, zone->rss_raw, rjournal,
+		result = sync_secure_journal(zone, rss->raw, rjournal,
 					     start, end, &soatuple,
-					     &zone->rss_diff);
+					     &rss->diff);
 		if (result == DNS_R_UNCHANGED) {
 			goto failure;
 		} else if (result != ISC_R_SUCCESS) {
-			CHECK(sync_secure_db(zone, zone->rss_raw, zone->rss_db,
-					     zone->rss_oldver, &soatuple,
-					     &zone->rss_diff));
+			CHECK(sync_secure_db(zone, rss->raw, rss->db,
+					     rss->oldver, &soatuple,
+					     &rss->diff));
 		}
 
-		CHECK(dns_diff_apply(&zone->rss_diff, zone->rss_db,
-				     zone->rss_newver));
+		CHECK(dns_diff_apply(&rss->diff, rss->db,
+				     rss->newver));
 
 		if (soatuple != NULL) {
 			uint32_t oldserial;
 
 			CHECK(dns_db_createsoatuple(
-				zone->rss_db, zone->rss_oldver,
-				zone->rss_diff.mctx, DNS_DIFFOP_DEL, &tuple));
+				rss->db, rss->oldver,
+				rss->diff.mctx, DNS_DIFFOP_DEL, &tuple));
 			oldserial = dns_soa_getserial(&tuple->rdata);
 			newserial = desired =
 				dns_soa_getserial(&soatuple->rdata);
@@ -16285,20 +17068,20 @@ receive_secure_serial(void *arg) {
 				}
 				dns_soa_setserial(newserial, &soatuple->rdata);
 			}
-			CHECK(do_one_tuple(&tuple, zone->rss_db,
-					   zone->rss_newver, &zone->rss_diff));
-			CHECK(do_one_tuple(&soatuple, zone->rss_db,
-					   zone->rss_newver, &zone->rss_diff));
+			CHECK(do_one_tuple(&tuple, rss->db,
+					   rss->newver, &rss->diff));
+			CHECK(do_one_tuple(&soatuple, rss->db,
+					   rss->newver, &rss->diff));
 		} else {
-			CHECK(update_soa_serial(zone, zone->rss_db,
-						zone->rss_newver,
-						&zone->rss_diff, zone->mctx,
+			CHECK(update_soa_serial(zone, rss->db,
+						rss->newver,
+						&rss->diff, zone->mctx,
 						zone->updatemethod));
 		}
 	}
 	result = dns_update_signaturesinc(
-		&log, zone, zone->rss_db, zone->rss_oldver, zone->rss_newver,
-		&zone->rss_diff, zone->sigvalidityinterval, &zone->rss_state);
+		&log, zone, rss->db, rss->oldver, rss->newver,
+		&rss->diff, zone->sigvalidityinterval, &rss->state);
 	if (result == DNS_R_CONTINUE) {
 		if (rjournal != NULL) {
 			dns_journal_destroy(&rjournal);
@@ -16315,16 +17098,16 @@ receive_secure_serial(void *arg) {
 	 * were created for it), commence applying raw zone deltas to it so
 	 * that contents of the raw zone and the secure zone are kept in sync.
 	 */
-	if (result != ISC_R_SUCCESS && dns_db_issecure(zone->rss_db)) {
+	if (result != ISC_R_SUCCESS && dns_db_issecure(rss->db)) {
 		goto failure;
 	}
 
 	if (rjournal == NULL) {
-		CHECK(dns_journal_open(zone->rss_raw->mctx,
-				       zone->rss_raw->journal,
+		CHECK(dns_journal_open(rss->raw->mctx,
+				       rss->raw->journal,
 				       DNS_JOURNAL_WRITE, &rjournal));
 	}
-	CHECK(zone_journal(zone, &zone->rss_diff, &end,
+	CHECK(zone_journal(zone, &rss->diff, &end,
 			   "receive_secure_serial"));
 
 	dns_journal_set_sourceserial(rjournal, end);
@@ -16346,8 +17129,8 @@ receive_secure_serial(void *arg) {
 	zone_settimer(zone, &timenow);
 	UNLOCK_ZONE(zone);
 
-	dns_db_closeversion(zone->rss_db, &zone->rss_oldver, false);
-	dns_db_closeversion(zone->rss_db, &zone->rss_newver, true);
+	dns_db_closeversion(rss->db, &rss->oldver, false);
+	dns_db_closeversion(rss->db, &rss->newver, true);
 
 	if (newserial != 0) {
 		dns_zone_log(zone, ISC_LOG_INFO, "serial %u (unsigned %u)",
@@ -16355,11 +17138,10 @@ receive_secure_serial(void *arg) {
 	}
 
 failure:
-	isc_mem_put(zone->mctx, rss, sizeof(*rss));
 	zone->rss = NULL;
 
-	if (zone->rss_raw != NULL) {
-		dns_zone_detach(&zone->rss_raw);
+	if (rss->raw != NULL) {
+		dns_zone_detach(&rss->raw);
 	}
 	if (result != ISC_R_SUCCESS) {
 		LOCK_ZONE(zone);
@@ -16379,23 +17161,24 @@ failure:
 	if (soatuple != NULL) {
 		dns_difftuple_free(&soatuple);
 	}
-	if (zone->rss_db != NULL) {
-		if (zone->rss_oldver != NULL) {
-			dns_db_closeversion(zone->rss_db, &zone->rss_oldver,
+	if (rss->db != NULL) {
+		if (rss->oldver != NULL) {
+			dns_db_closeversion(rss->db, &rss->oldver,
 					    false);
 		}
-		if (zone->rss_newver != NULL) {
-			dns_db_closeversion(zone->rss_db, &zone->rss_newver,
+		if (rss->newver != NULL) {
+			dns_db_closeversion(rss->db, &rss->newver,
 					    false);
 		}
-		dns_db_detach(&zone->rss_db);
+		dns_db_detach(&rss->db);
 	}
-	INSIST(zone->rss_oldver == NULL);
-	INSIST(zone->rss_newver == NULL);
+	INSIST(rss->oldver == NULL);
+	INSIST(rss->newver == NULL);
 	if (rjournal != NULL) {
 		dns_journal_destroy(&rjournal);
 	}
-	dns_diff_clear(&zone->rss_diff);
+	dns_diff_clear(&rss->diff);
+	isc_mem_put(zone->mctx, rss, sizeof(*rss));
 
 	dns_zone_idetach(&zone);
 }
@@ -16932,6 +17715,7 @@ again:
 static isc_result_t
 zone_replacedb(dns_zone_t *zone, dns_db_t *db, bool dump) {
 	dns_dbversion_t *ver;
+	dns_diff_t diff;
 	isc_result_t result;
 	unsigned int soacount = 0;
 	unsigned int nscount = 0;
@@ -17020,8 +17804,9 @@ zone_replacedb(dns_zone_t *zone, dns_db_t *db, bool dump) {
 			goto fail;
 		}
 
-		result = dns_db_diff(zone->mctx, db, ver, zone->db, NULL,
-				     zone->journal);
+		dns_diff_init(zone->mctx, &diff);
+		result = zone_diff(zone, db, ver, zone->journal, &diff);
+		dns_diff_clear(&diff);
 		if (result != ISC_R_SUCCESS) {
 			char strbuf[ISC_STRERRORSIZE];
 			strerror_r(errno, strbuf, sizeof(strbuf));
@@ -17963,14 +18748,14 @@ sendtoprimary(dns_forward_t *forward) {
 		isc_sockaddr_any(&any);
 		src = zone->primaries.sources[forward->which];
 		if (isc_sockaddr_equal(&src, &any)) {
-			src = zone->xfrsource4;
+			src = zone_sources(zone)->xfrsource4;
 		}
 		break;
 	case PF_INET6:
 		isc_sockaddr_any6(&any);
 		src = zone->primaries.sources[forward->which];
 		if (isc_sockaddr_equal(&src, &any)) {
-			src = zone->xfrsource6;
+			src = zone_sources(zone)->xfrsource6;
 		}
 		break;
 	default:
@@ -18363,6 +19148,7 @@ dns_zonemgr_create(isc_mem_t *mctx, isc_loopmgr_t *loopmgr, isc_nm_t *netmgr,
 		.workers = isc_loopmgr_nloops(loopmgr),
 		.transfersin = 10,
 		.transfersperns = 2,
+		.serialquerybatch = 1,
 	};
 
 	isc_refcount_init(&zmgr->refs, 1);
@@ -18380,6 +19166,11 @@ dns_zonemgr_create(isc_mem_t *mctx, isc_loopmgr_t *loopmgr, isc_nm_t *netmgr,
 	/* Unreachable lock. */
 	isc_rwlock_init(&zmgr->urlock);
 
+	isc_mutex_init(&zmgr->refreshlock);
+	isc_hashmap_create(zmgr->mctx, 4, &zmgr->refreshqs);
+	isc_heap_create(zmgr->mctx, refreshq_higher, refreshq_index, 0,
+			&zmgr->refreshheap);
+
 	isc_ratelimiter_create(loop, &zmgr->checkdsrl);
 	isc_ratelimiter_create(loop, &zmgr->notifyrl);
 	isc_ratelimiter_create(loop, &zmgr->refreshrl);
@@ -18393,6 +19184,13 @@ dns_zonemgr_create(isc_mem_t *mctx, isc_loopmgr_t *loopmgr, isc_nm_t *netmgr,
 		isc_mem_setname(zmgr->mctxpool[i], "zonemgr-mctxpool");
 	}
 
+	zmgr->wheels = isc_mem_cget(zmgr->mctx, zmgr->workers,
+				    sizeof(zmgr->wheels[0]));
+	for (size_t i = 0; i < zmgr->workers; i++) {
+		isc_timerwheel_create(isc_loop_get(loopmgr, i),
+				      &zmgr->wheels[i]);
+	}
+
 	/* Key file I/O locks. */
 	zonemgr_keymgmt_init(zmgr);
 
@@ -18447,7 +19245,7 @@ dns_zonemgr_managezone(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
 
 	RWLOCK(&zmgr->rwlock, isc_rwlocktype_write);
 	LOCK_ZONE(zone);
-	REQUIRE(zone->timer == NULL);
+	REQUIRE(!isc_wheeltimer_initialized(&zone->timer));
 	REQUIRE(zone->zmgr == NULL);
 
 	isc_loop_t *loop = isc_loop_get(zmgr->loopmgr, zone->tid);
@@ -18482,9 +19280,9 @@ dns_zonemgr_releasezone(dns_zonemgr_t *zmgr, dns_zone_t *zone) {
 		ENSURE(zone->kfio == NULL);
 	}
 
-	if (zone->timer != NULL) {
+	if (isc_wheeltimer_initialized(&zone->timer)) {
 		isc_refcount_decrement(&zone->irefs);
-		isc_timer_destroy(&zone->timer);
+		isc_wheeltimer_invalidate(&zone->timer);
 	}
 
 	isc_loop_detach(&zone->loop);
@@ -18572,8 +19370,11 @@ dns_zonemgr_shutdown(dns_zonemgr_t *zmgr) {
 	isc_ratelimiter_shutdown(zmgr->startupnotifyrl);
 	isc_ratelimiter_shutdown(zmgr->startuprefreshrl);
 
+	refresh_cancel(zmgr);
+
 	for (size_t i = 0; i < zmgr->workers; i++) {
 		isc_mem_detach(&zmgr->mctxpool[i]);
+		isc_timerwheel_shutdown(zmgr->wheels[i]);
 	}
 
 	RWLOCK(&zmgr->rwlock, isc_rwlocktype_read);
@@ -18603,10 +19404,21 @@ zonemgr_free(dns_zonemgr_t *zmgr) {
 	isc_mem_cput(zmgr->mctx, zmgr->mctxpool, zmgr->workers,
 		     sizeof(zmgr->mctxpool[0]));
 
+	for (size_t i = 0; i < zmgr->workers; i++) {
+		isc_timerwheel_detach(&zmgr->wheels[i]);
+	}
+	isc_mem_cput(zmgr->mctx, zmgr->wheels, zmgr->workers,
+		     sizeof(zmgr->wheels[0]));
+
 	isc_rwlock_destroy(&zmgr->urlock);
 	isc_rwlock_destroy(&zmgr->rwlock);
 	isc_rwlock_destroy(&zmgr->tlsctx_cache_rwlock);
 
+	INSIST(zmgr->refreshbacklog == 0 && zmgr->refreshtokens == 0);
+	isc_heap_destroy(&zmgr->refreshheap);
+	isc_hashmap_destroy(&zmgr->refreshqs);
+	isc_mutex_destroy(&zmgr->refreshlock);
+
 	zonemgr_keymgmt_destroy(zmgr);
 
 	if (zmgr->tlsctx_cache != NULL) {
@@ -18882,6 +19694,55 @@ dns_zonemgr_setserialqueryrate(dns_zonemgr_t *zmgr, unsigned int value) {
 	setrl(zmgr->startuprefreshrl, &zmgr->startupserialqueryrate, value);
 }
 
+static void
+refreshq_count(void *elt, void *uap) {
+	dns_zonemgr_t *zmgr = uap;
+
+	zmgr->refreshneeded += refreshq_batches(zmgr, elt);
+}
+
+void
+dns_zonemgr_setserialquerybatch(dns_zonemgr_t *zmgr, unsigned int value) {
+	size_t tokens;
+
+	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
+
+	LOCK(&zmgr->refreshlock);
+	zmgr->serialquerybatch = (value == 0) ? 1 : value;
+	zmgr->refreshneeded = 0;
+	isc_heap_foreach(zmgr->refreshheap, refreshq_count, zmgr);
+	tokens = refresh_tokens(zmgr);
+	UNLOCK(&zmgr->refreshlock);
+
+	refresh_request(zmgr, tokens);
+}
+
+unsigned int
+dns_zonemgr_getserialquerybatch(dns_zonemgr_t *zmgr) {
+	unsigned int value;
+
+	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
+
+	LOCK(&zmgr->refreshlock);
+	value = zmgr->serialquerybatch;
+	UNLOCK(&zmgr->refreshlock);
+
+	return (value);
+}
+
+void
+dns_zonemgr_getrefreshbacklog(dns_zonemgr_t *zmgr, size_t *zonesp,
+			      size_t *primariesp) {
+	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
+	REQUIRE(zonesp != NULL);
+	REQUIRE(primariesp != NULL);
+
+	LOCK(&zmgr->refreshlock);
+	*zonesp = zmgr->refreshbacklog;
+	*primariesp = isc_hashmap_count(zmgr->refreshqs);
+	UNLOCK(&zmgr->refreshlock);
+}
+
 unsigned int
 dns_zonemgr_getnotifyrate(dns_zonemgr_t *zmgr) {
 	REQUIRE(DNS_ZONEMGR_VALID(zmgr));
@@ -19140,6 +20001,63 @@ dns_zone_getrcvquerystats(dns_zone_t *zone) {
 	}
 }
 
+isc_histomulti_t *
+dns_zone_getlatencystats(dns_zone_t *zone) {
+	isc_histomulti_t *hm = NULL;
+	isc_histomulti_t *expected = NULL;
+
+	REQUIRE(DNS_ZONE_VALID(zone));
+
+	/*
+	 * See the note in dns_zone_getrequeststats() about not locking.
+	 */
+	if (!zone->requeststats_on) {
+		return (NULL);
+	}
+
+	hm = atomic_load_acquire(&zone->latencystats);
+	if (hm != NULL) {
+		return (hm);
+	}
+
+	isc_histomulti_create(zone->mctx, DNS_LATENCYHISTO_SIGBITS, &hm);
+	if (!atomic_compare_exchange_strong_acq_rel(&zone->latencystats,
+						    &expected, hm))
+	{
+		isc_histomulti_destroy(&hm);
+		hm = expected;
+	}
+
+	return (hm);
+}
+
+dns_nsec3cache_t *
+dns_zone_getnsec3cache(dns_zone_t *zone) {
+	dns_nsec3cache_t *cache = NULL;
+	dns_nsec3cache_t *expected = NULL;
+
+	REQUIRE(DNS_ZONE_VALID(zone));
+
+	cache = atomic_load_acquire(&zone->nsec3cache);
+	if (cache != NULL) {
+		return (cache);
+	}
+
+	/*
+	 * The cache is created on first use, so that zones which never
+	 * serve NSEC3 negative answers don't pay for it.
+	 */
+	dns_nsec3cache_create(zone->mctx, NSEC3CACHE_SIZE, &cache);
+	if (!atomic_compare_exchange_strong_acq_rel(&zone->nsec3cache,
+						    &expected, cache))
+	{
+		dns_nsec3cache_destroy(&cache);
+		cache = expected;
+	}
+
+	return (cache);
+}
+
 void
 dns_zone_dialup(dns_zone_t *zone) {
 	REQUIRE(DNS_ZONE_VALID(zone));
@@ -19993,8 +20911,9 @@ checkds_destroy(dns_checkds_t *checkds, bool locked) {
 		}
 		REQUIRE(LOCKED_ZONE(checkds->zone));
 		if (ISC_LINK_LINKED(checkds, link)) {
-			ISC_LIST_UNLINK(checkds->zone->checkds_requests,
-					checkds, link);
+			ISC_LIST_UNLINK(
+				checkds->zone->parental->checkds_requests,
+				checkds, link);
 		}
 		if (!locked) {
 			UNLOCK_ZONE(checkds->zone);
@@ -20055,10 +20974,10 @@ do_checkds(dns_zone_t *zone, dst_key_t *key, isc_stdtime_t now,
 
 	switch (zone->checkdstype) {
 	case dns_checkdstype_yes:
-		num = zone->parent_nscount;
+		num = zone->parental->parent_nscount;
 		break;
 	case dns_checkdstype_explicit:
-		num = dns_remote_count(&zone->parentals);
+		num = dns_remote_count(&zone->parental->parentals);
 		break;
 	case dns_checkdstype_no:
 	default:
@@ -20099,8 +21018,8 @@ do_checkds(dns_zone_t *zone, dst_key_t *key, isc_stdtime_t now,
 		     dspublish ? "published" : "withdrawn", dst_key_id(key));
 
 	dns_zone_lock_keyfiles(zone);
-	result = dns_keymgr_checkds_id(kasp, &zone->checkds_ok, dir, now, now,
-				       dspublish, dst_key_id(key),
+	result = dns_keymgr_checkds_id(kasp, &zone->parental->checkds_ok, dir,
+				       now, now, dspublish, dst_key_id(key),
 				       dst_key_alg(key));
 	dns_zone_unlock_keyfiles(zone);
 
@@ -20247,7 +21166,7 @@ checkds_done(void *arg) {
 
 	KASP_LOCK(kasp);
 	LOCK_ZONE(zone);
-	for (key = ISC_LIST_HEAD(zone->checkds_ok); key != NULL;
+	for (key = ISC_LIST_HEAD(zone->parental->checkds_ok); key != NULL;
 	     key = ISC_LIST_NEXT(key, link))
 	{
 		bool alldone = false, found = false;
@@ -20374,8 +21293,12 @@ checkds_isqueued(dns_zone_t *zone, dns_name_t *name, isc_sockaddr_t *addr,
 		 dns_tsigkey_t *key, dns_transport_t *transport) {
 	dns_checkds_t *checkds;
 
-	for (checkds = ISC_LIST_HEAD(zone->checkds_requests); checkds != NULL;
-	     checkds = ISC_LIST_NEXT(checkds, link))
+	if (zone->parental == NULL) {
+		return (false);
+	}
+
+	for (checkds = ISC_LIST_HEAD(zone->parental->checkds_requests);
+	     checkds != NULL; checkds = ISC_LIST_NEXT(checkds, link))
 	{
 		if (checkds->request != NULL) {
 			continue;
@@ -20617,7 +21540,7 @@ checkds_send_toaddr(void *arg) {
 
 			src = checkds->src;
 			if (isc_sockaddr_equal(&src, &any)) {
-				src = checkds->zone->parentalsrc4;
+				src = zone_sources(checkds->zone)->parentalsrc4;
 			}
 		}
 		break;
@@ -20628,7 +21551,7 @@ checkds_send_toaddr(void *arg) {
 
 			src = checkds->src;
 			if (isc_sockaddr_equal(&src, &any)) {
-				src = checkds->zone->parentalsrc6;
+				src = zone_sources(checkds->zone)->parentalsrc6;
 			}
 		}
 		break;
@@ -20699,8 +21622,8 @@ checkds_send_tons(dns_checkds_t *checkds) {
 			goto cleanup;
 		}
 		zone_iattach(zone, &newcheckds->zone);
-		ISC_LIST_APPEND(newcheckds->zone->checkds_requests, newcheckds,
-				link);
+		ISC_LIST_APPEND(newcheckds->zone->parental->checkds_requests,
+				newcheckds, link);
 		newcheckds->dst = dst;
 		dns_name_dup(&checkds->ns, checkds->mctx, &newcheckds->ns);
 		switch (isc_sockaddr_pf(&newcheckds->dst)) {
@@ -20738,6 +21661,7 @@ cleanup:
 static void
 checkds_send(dns_zone_t *zone) {
 	dns_view_t *view = dns_zone_getview(zone);
+	dns_zoneparental_t *parental = NULL;
 	isc_result_t result;
 	unsigned int flags = 0;
 	unsigned int i = 0;
@@ -20747,9 +21671,11 @@ checkds_send(dns_zone_t *zone) {
 	 */
 	REQUIRE(LOCKED_ZONE(zone));
 
+	parental = zone_parental(zone);
+
 	dns_zone_log(zone, ISC_LOG_DEBUG(3),
 		     "checkds: start sending DS queries to %u parentals",
-		     dns_remote_count(&zone->parentals));
+		     dns_remote_count(&parental->parentals));
 
 	if (DNS_ZONE_FLAG(zone, DNS_ZONEFLG_EXITING)) {
 		dns_zone_log(zone, ISC_LOG_DEBUG(3),
@@ -20757,8 +21683,8 @@ checkds_send(dns_zone_t *zone) {
 		return;
 	}
 
-	dns_remote_reset(&zone->parentals, false);
-	while (!dns_remote_done(&zone->parentals)) {
+	dns_remote_reset(&parental->parentals, false);
+	while (!dns_remote_done(&parental->parentals)) {
 		dns_tsigkey_t *key = NULL;
 		dns_transport_t *transport = NULL;
 		isc_sockaddr_t src, dst;
@@ -20766,15 +21692,15 @@ checkds_send(dns_zone_t *zone) {
 
 		i++;
 
-		if (dns_remote_keyname(&zone->parentals) != NULL) {
+		if (dns_remote_keyname(&parental->parentals) != NULL) {
 			dns_name_t *keyname =
-				dns_remote_keyname(&zone->parentals);
+				dns_remote_keyname(&parental->parentals);
 			(void)dns_view_gettsig(view, keyname, &key);
 		}
 
-		if (dns_remote_tlsname(&zone->parentals) != NULL) {
+		if (dns_remote_tlsname(&parental->parentals) != NULL) {
 			dns_name_t *tlsname =
-				dns_remote_tlsname(&zone->parentals);
+				dns_remote_tlsname(&parental->parentals);
 			(void)dns_view_gettransport(view, DNS_TRANSPORT_TLS,
 						    tlsname, &transport);
 			dns_zone_logc(
@@ -20782,8 +21708,8 @@ checkds_send(dns_zone_t *zone) {
 				"got TLS configuration for zone transfer");
 		}
 
-		dst = dns_remote_curraddr(&zone->parentals);
-		src = dns_remote_sourceaddr(&zone->parentals);
+		dst = dns_remote_curraddr(&parental->parentals);
+		src = dns_remote_sourceaddr(&parental->parentals);
 		INSIST(isc_sockaddr_pf(&src) == isc_sockaddr_pf(&dst));
 
 		/* TODO: glue the transport to the checkds request */
@@ -20832,7 +21758,7 @@ checkds_send(dns_zone_t *zone) {
 			transport = NULL;
 		}
 
-		ISC_LIST_APPEND(zone->checkds_requests, checkds, link);
+		ISC_LIST_APPEND(parental->checkds_requests, checkds, link);
 		result = isc_ratelimiter_enqueue(
 			checkds->zone->zmgr->checkdsrl, checkds->zone->loop,
 			checkds_send_toaddr, checkds, &checkds->rlevent);
@@ -20845,7 +21771,7 @@ checkds_send(dns_zone_t *zone) {
 		}
 
 	next:
-		dns_remote_next(&zone->parentals, false);
+		dns_remote_next(&parental->parentals, false);
 	}
 }
 
@@ -20896,7 +21822,7 @@ nsfetch_done(void *arg) {
 		goto cleanup;
 	}
 
-	zone->nsfetchcount--;
+	zone_parental(zone)->nsfetchcount--;
 
 	dns_name_format(pname, pnamebuf, sizeof(pnamebuf));
 	dnssec_log(zone, ISC_LOG_DEBUG(3),
@@ -20943,7 +21869,7 @@ nsfetch_done(void *arg) {
 	}
 
 	/* Record the number of NS records we found. */
-	zone->parent_nscount = dns_rdataset_count(nsrrset);
+	zone_parental(zone)->parent_nscount = dns_rdataset_count(nsrrset);
 
 	UNLOCK_ZONE(zone);
 
@@ -20987,7 +21913,8 @@ nsfetch_done(void *arg) {
 		LOCK_ZONE(zone);
 		zone_iattach(zone, &checkds->zone);
 		dns_name_dup(&ns.name, zone->mctx, &checkds->ns);
-		ISC_LIST_APPEND(zone->checkds_requests, checkds, link);
+		ISC_LIST_APPEND(zone_parental(zone)->checkds_requests, checkds,
+				link);
 		UNLOCK_ZONE(zone);
 
 		checkds_find_address(checkds);
@@ -21089,7 +22016,7 @@ do_nsfetch(void *arg) {
 			   "Failed to create fetch for '%s' NS request",
 			   namebuf);
 		LOCK_ZONE(zone);
-		zone->nsfetchcount--;
+		zone_parental(zone)->nsfetchcount--;
 		isc_refcount_decrement(&zone->irefs);
 
 		dns_name_free(zname, zone->mctx);
@@ -21117,7 +22044,7 @@ nsfetch_levelup(dns_nsfetch_t *nsfetch) {
 	if (!dns_fuzzing_resolver) {
 #endif /* ifdef ENABLE_AFL */
 		LOCK_ZONE(zone);
-		zone->nsfetchcount++;
+		zone_parental(zone)->nsfetchcount++;
 		isc_refcount_increment0(&zone->irefs);
 
 		dns_rdataset_init(&nsfetch->nsrrset);
@@ -21143,7 +22070,10 @@ zone_checkds(dns_zone_t *zone) {
 		return;
 	}
 
-	for (dns_dnsseckey_t *key = ISC_LIST_HEAD(zone->checkds_ok);
+	/* The parental state was allocated by zone_rekey() */
+	INSIST(zone->parental != NULL);
+
+	for (dns_dnsseckey_t *key = ISC_LIST_HEAD(zone->parental->checkds_ok);
 	     key != NULL; key = ISC_LIST_NEXT(key, link))
 	{
 		dst_key_state_t ds_state = DST_KEY_STATE_NA;
@@ -21196,7 +22126,7 @@ zone_checkds(dns_zone_t *zone) {
 		*nsfetch = (dns_nsfetch_t){ .zone = zone };
 		isc_mem_attach(zone->mctx, &nsfetch->mctx);
 		LOCK_ZONE(zone);
-		zone->nsfetchcount++;
+		zone_parental(zone)->nsfetchcount++;
 		isc_refcount_increment0(&zone->irefs);
 		name = dns_fixedname_initname(&nsfetch->name);
 		dns_name_init(&nsfetch->pname, NULL);
@@ -21331,14 +22261,17 @@ zone_rekey(dns_zone_t *zone) {
 		/*
 		 * Check DS at parental agents. Clear ongoing checks.
 		 */
+		dns_zoneparental_t *parental = NULL;
+
 		LOCK_ZONE(zone);
 		checkds_cancel(zone);
-		clear_keylist(&zone->checkds_ok, zone->mctx);
-		ISC_LIST_INIT(zone->checkds_ok);
+		parental = zone_parental(zone);
+		clear_keylist(&parental->checkds_ok, zone->mctx);
+		ISC_LIST_INIT(parental->checkds_ok);
 		UNLOCK_ZONE(zone);
 
 		result = dns_zone_getdnsseckeys(zone, db, ver, now,
-						&zone->checkds_ok);
+						&parental->checkds_ok);
 
 		if (result == ISC_R_SUCCESS) {
 			zone_checkds(zone);
@@ -22242,6 +23175,35 @@ dns_zone_getserialupdatemethod(dns_zone_t *zone) {
 	return (zone->updatemethod);
 }
 
+void
+dns_zone_setupdatewindow(dns_zone_t *zone, uint32_t window) {
+	REQUIRE(DNS_ZONE_VALID(zone));
+	zone->updatewindow = window;
+}
+
+uint32_t
+dns_zone_getupdatewindow(dns_zone_t *zone) {
+	REQUIRE(DNS_ZONE_VALID(zone));
+	return (zone->updatewindow);
+}
+
+void
+dns_zone_setupdatequeue(dns_zone_t *zone, void *queue) {
+	REQUIRE(DNS_ZONE_VALID(zone));
+	REQUIRE(isc_tid() == zone->tid);
+	REQUIRE(queue == NULL || zone->updatequeue == NULL);
+
+	zone->updatequeue = queue;
+}
+
+void *
+dns_zone_getupdatequeue(dns_zone_t *zone) {
+	REQUIRE(DNS_ZONE_VALID(zone));
+	REQUIRE(isc_tid() == zone->tid);
+
+	return (zone->updatequeue);
+}
+
 /*
  * Lock hierarchy: zmgr, zone, raw.
  */
@@ -22548,7 +23510,7 @@ setnsec3param(void *arg) {
 	 * loop-serialized for the zone. Make sure there's no processing
 	 * currently running.
 	 */
-	INSIST(zone->rss_newver == NULL);
+	INSIST(zone->rss == NULL || zone->rss->newver == NULL);
 
 	bool rescheduled = false;
 	ZONEDB_LOCK(&zone->dblock, isc_rwlocktype_read);
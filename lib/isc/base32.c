@@ -14,6 +14,7 @@
 /*! \file */
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <isc/base32.h>
 #include <isc/buffer.h>
@@ -47,6 +48,60 @@ static const char base32[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567="
 static const char base32hex[] = "0123456789ABCDEFGHIJKLMNOPQRSTUV="
 				"0123456789abcdefghijklmnopqrstuv";
 
+/*%
+ * The value of each digit of the two encodings in either case, 32 for
+ * the "=" pad character and 0xff for anything else.
+ */
+static const uint8_t base32_value[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x20, 0xff, 0xff, 0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+	0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12,
+	0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a,
+	0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+	0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff,
+};
+
+static const uint8_t base32hex_value[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff,
+	0xff, 0x20, 0xff, 0xff, 0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10,
+	0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c,
+	0x1d, 0x1e, 0x1f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14,
+	0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff,
+};
+
 static isc_result_t
 base32_totext(isc_region_t *source, int wordlength, const char *wordbreak,
 	      isc_buffer_t *target, const char base[], char pad) {
@@ -143,31 +198,22 @@ typedef struct {
 	int digits;	      /*%< Number of buffered base32 digits */
 	bool seen_end;	      /*%< True if "=" end marker seen */
 	int val[8];
-	const char *base; /*%< Which encoding we are using */
-	int seen_32;	  /*%< Number of significant bytes if non
-			   * zero */
-	bool pad;	  /*%< Expect padding */
+	const uint8_t *values; /*%< Which encoding we are using */
+	int seen_32;	       /*%< Number of significant bytes if non
+				* zero */
+	bool pad;	       /*%< Expect padding */
 } base32_decode_ctx_t;
 
 static isc_result_t
 base32_decode_char(base32_decode_ctx_t *ctx, int c) {
-	const char *s;
-	unsigned int last;
+	unsigned int last = ctx->values[(unsigned char)c];
 
 	if (ctx->seen_end) {
 		return (ISC_R_BADBASE32);
 	}
-	if ((s = strchr(ctx->base, c)) == NULL) {
+	if (last == 0xff) {
 		return (ISC_R_BADBASE32);
 	}
-	last = (unsigned int)(s - ctx->base);
-
-	/*
-	 * Handle lower case.
-	 */
-	if (last > 32) {
-		last -= 33;
-	}
 
 	/*
 	 * Check that padding is contiguous.
@@ -257,6 +303,79 @@ base32_decode_char(base32_decode_ctx_t *ctx, int c) {
 	return (ISC_R_SUCCESS);
 }
 
+/*
+ * Decode as many complete, unpadded groups of eight digits from 'src' as
+ * fit in 'dstlen' bytes, stopping before the first group containing
+ * anything else.  Returns the number of digits decoded.
+ */
+static size_t
+base32_decode_groups(const uint8_t values[], const unsigned char *src,
+		     size_t srclen, unsigned char *dst, size_t dstlen) {
+	size_t i = 0;
+
+	while (srclen - i >= 8 && dstlen >= 5) {
+		uint8_t v[8];
+		uint8_t all = 0;
+
+		for (size_t j = 0; j < 8; j++) {
+			v[j] = values[src[i + j]];
+			all |= v[j];
+		}
+		if (all > 31) {
+			break;
+		}
+		dst[0] = (v[0] << 3) | (v[1] >> 2);
+		dst[1] = (v[1] << 6) | (v[2] << 1) | (v[3] >> 4);
+		dst[2] = (v[3] << 4) | (v[4] >> 1);
+		dst[3] = (v[4] << 7) | (v[5] << 2) | (v[6] >> 3);
+		dst[4] = (v[6] << 5) | v[7];
+		dst += 5;
+		dstlen -= 5;
+		i += 8;
+	}
+
+	return (i);
+}
+
+/*
+ * Decode the 'length' characters at 'base', which must not contain
+ * white space.  Whole groups of digits are decoded directly into the
+ * target buffer.
+ */
+static isc_result_t
+base32_decode_region(base32_decode_ctx_t *ctx, const unsigned char *base,
+		     size_t length) {
+	while (length > 0) {
+		if (ctx->digits == 0 && ctx->seen_32 == 0 && !ctx->seen_end &&
+		    length >= 8)
+		{
+			isc_region_t avail;
+			size_t srclen = length, done;
+
+			if (ctx->length >= 0) {
+				srclen = ISC_MIN(srclen,
+						 (size_t)ctx->length / 5 * 8);
+			}
+			isc_buffer_availableregion(ctx->target, &avail);
+			done = base32_decode_groups(ctx->values, base, srclen,
+						    avail.base, avail.length);
+			isc_buffer_add(ctx->target, done / 8 * 5);
+			if (ctx->length >= 0) {
+				ctx->length -= done / 8 * 5;
+			}
+			base += done;
+			length -= done;
+			if (length == 0) {
+				break;
+			}
+		}
+		RETERR(base32_decode_char(ctx, *base));
+		base++;
+		length--;
+	}
+	return (ISC_R_SUCCESS);
+}
+
 static isc_result_t
 base32_decode_finish(base32_decode_ctx_t *ctx) {
 	if (ctx->length > 0) {
@@ -278,11 +397,11 @@ base32_decode_finish(base32_decode_ctx_t *ctx) {
 }
 
 static isc_result_t
-base32_tobuffer(isc_lex_t *lexer, const char base[], bool pad,
+base32_tobuffer(isc_lex_t *lexer, const uint8_t values[], bool pad,
 		isc_buffer_t *target, int length) {
 	unsigned int before, after;
 	base32_decode_ctx_t ctx = {
-		.length = length, .base = base, .target = target, .pad = pad
+		.length = length, .values = values, .target = target, .pad = pad
 	};
 	isc_textregion_t *tr;
 	isc_token_t token;
@@ -292,8 +411,6 @@ base32_tobuffer(isc_lex_t *lexer, const char base[], bool pad,
 
 	before = isc_buffer_usedlength(target);
 	while (!ctx.seen_end && (ctx.length != 0)) {
-		unsigned int i;
-
 		if (length > 0) {
 			eol = false;
 		} else {
@@ -305,9 +422,8 @@ base32_tobuffer(isc_lex_t *lexer, const char base[], bool pad,
 			break;
 		}
 		tr = &token.value.as_textregion;
-		for (i = 0; i < tr->length; i++) {
-			RETERR(base32_decode_char(&ctx, tr->base[i]));
-		}
+		RETERR(base32_decode_region(&ctx, (unsigned char *)tr->base,
+					    tr->length));
 	}
 	after = isc_buffer_usedlength(target);
 	if (ctx.length < 0 && !ctx.seen_end) {
@@ -322,35 +438,36 @@ base32_tobuffer(isc_lex_t *lexer, const char base[], bool pad,
 
 isc_result_t
 isc_base32_tobuffer(isc_lex_t *lexer, isc_buffer_t *target, int length) {
-	return (base32_tobuffer(lexer, base32, true, target, length));
+	return (base32_tobuffer(lexer, base32_value, true, target, length));
 }
 
 isc_result_t
 isc_base32hex_tobuffer(isc_lex_t *lexer, isc_buffer_t *target, int length) {
-	return (base32_tobuffer(lexer, base32hex, true, target, length));
+	return (base32_tobuffer(lexer, base32hex_value, true, target, length));
 }
 
 isc_result_t
 isc_base32hexnp_tobuffer(isc_lex_t *lexer, isc_buffer_t *target, int length) {
-	return (base32_tobuffer(lexer, base32hex, false, target, length));
+	return (base32_tobuffer(lexer, base32hex_value, false, target, length));
 }
 
 static isc_result_t
-base32_decodestring(const char *cstr, const char base[], bool pad,
+base32_decodestring(const char *cstr, const uint8_t values[], bool pad,
 		    isc_buffer_t *target) {
 	base32_decode_ctx_t ctx = {
-		.length = -1, .base = base, .target = target, .pad = pad
+		.length = -1, .values = values, .target = target, .pad = pad
 	};
 
 	for (;;) {
-		int c = *cstr++;
-		if (c == '\0') {
+		size_t n = strcspn(cstr, " \t\n\r");
+
+		RETERR(base32_decode_region(&ctx, (const unsigned char *)cstr,
+					    n));
+		cstr += n;
+		if (*cstr == '\0') {
 			break;
 		}
-		if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-			continue;
-		}
-		RETERR(base32_decode_char(&ctx, c));
+		cstr++;
 	}
 	RETERR(base32_decode_finish(&ctx));
 	return (ISC_R_SUCCESS);
@@ -358,48 +475,45 @@ base32_decodestring(const char *cstr, const char base[], bool pad,
 
 isc_result_t
 isc_base32_decodestring(const char *cstr, isc_buffer_t *target) {
-	return (base32_decodestring(cstr, base32, true, target));
+	return (base32_decodestring(cstr, base32_value, true, target));
 }
 
 isc_result_t
 isc_base32hex_decodestring(const char *cstr, isc_buffer_t *target) {
-	return (base32_decodestring(cstr, base32hex, true, target));
+	return (base32_decodestring(cstr, base32hex_value, true, target));
 }
 
 isc_result_t
 isc_base32hexnp_decodestring(const char *cstr, isc_buffer_t *target) {
-	return (base32_decodestring(cstr, base32hex, false, target));
+	return (base32_decodestring(cstr, base32hex_value, false, target));
 }
 
 static isc_result_t
-base32_decoderegion(isc_region_t *source, const char base[], bool pad,
+base32_decoderegion(isc_region_t *source, const uint8_t values[], bool pad,
 		    isc_buffer_t *target) {
 	base32_decode_ctx_t ctx = {
-		.length = -1, .base = base, .target = target, .pad = pad
+		.length = -1, .values = values, .target = target, .pad = pad
 	};
 
-	while (source->length != 0) {
-		int c = *source->base;
-		RETERR(base32_decode_char(&ctx, c));
-		isc_region_consume(source, 1);
-	}
+	RETERR(base32_decode_region(&ctx, source->base, source->length));
+	isc_region_consume(source, source->length);
 	RETERR(base32_decode_finish(&ctx));
 	return (ISC_R_SUCCESS);
 }
 
 isc_result_t
 isc_base32_decoderegion(isc_region_t *source, isc_buffer_t *target) {
-	return (base32_decoderegion(source, base32, true, target));
+	return (base32_decoderegion(source, base32_value, true, target));
 }
 
 isc_result_t
 isc_base32hex_decoderegion(isc_region_t *source, isc_buffer_t *target) {
-	return (base32_decoderegion(source, base32hex, true, target));
+	return (base32_decoderegion(source, base32hex_value, true, target));
 }
 
 isc_result_t
 isc_base32hexnp_decoderegion(isc_region_t *source, isc_buffer_t *target) {
-	return (base32_decoderegion(source, base32hex, false, target));
+	return (base32_decoderegion(source, base32hex_value, false, target));
 }
 
 static isc_result_t
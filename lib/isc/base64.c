@@ -14,6 +14,7 @@
 /*! \file */
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <isc/base64.h>
 #include <isc/buffer.h>
@@ -21,6 +22,8 @@
 #include <isc/string.h>
 #include <isc/util.h>
 
+#include "simd_p.h"
+
 #define RETERR(x)                        \
 	do {                             \
 		isc_result_t _r = (x);   \
@@ -43,28 +46,338 @@ static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvw"
 			     "xyz0123456789+/=";
 /*@}*/
 
+/*%
+ * The value of each base64 digit, 64 for the "=" pad character and 0xff
+ * for anything else.
+ */
+static const uint8_t base64_value[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff,
+	0xff, 0x40, 0xff, 0xff, 0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+	0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12,
+	0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24,
+	0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30,
+	0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff,
+};
+
+/*
+ * Bulk encoding and decoding of whole groups of base64 digits.  The
+ * vector implementations handle as many blocks as they can and leave the
+ * remainder to the narrower ones, and finally the scalar implementation.
+ *
+ * The decoders stop before the first group containing anything other
+ * than a base64 digit (including the "=" pad character), leaving it to
+ * base64_decode_char() to decode or reject, and return the number of
+ * digits decoded.
+ */
+static size_t
+base64_decode_scalar(const unsigned char *src, size_t srclen,
+		     unsigned char *dst, size_t dstlen) {
+	size_t i = 0;
+
+	while (srclen - i >= 4 && dstlen >= 3) {
+		uint8_t a = base64_value[src[i]];
+		uint8_t b = base64_value[src[i + 1]];
+		uint8_t c = base64_value[src[i + 2]];
+		uint8_t d = base64_value[src[i + 3]];
+
+		if ((a | b | c | d) > 63) {
+			break;
+		}
+		dst[0] = (a << 2) | (b >> 4);
+		dst[1] = (b << 4) | (c >> 2);
+		dst[2] = (c << 6) | d;
+		dst += 3;
+		dstlen -= 3;
+		i += 4;
+	}
+
+	return (i);
+}
+
+static void
+base64_encode_scalar(const unsigned char *src, size_t srclen, char *dst) {
+	for (size_t i = 0; i + 3 <= srclen; i += 3) {
+		*dst++ = base64[(src[i] >> 2) & 0x3f];
+		*dst++ = base64[((src[i] << 4) & 0x30) |
+				((src[i + 1] >> 4) & 0x0f)];
+		*dst++ = base64[((src[i + 1] << 2) & 0x3c) |
+				((src[i + 2] >> 6) & 0x03)];
+		*dst++ = base64[src[i + 2] & 0x3f];
+	}
+}
+
+#if ISC_SIMD_X86
+/*
+ * The vector codecs classify and translate the digits with nibble lookup
+ * tables, as described by Wojciech Muła and Alfred Klomp.
+ */
+#define B64_LUT_LO                                                           \
+	0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, \
+		0x1a, 0x1b, 0x1b, 0x1b, 0x1a
+#define B64_LUT_HI                                                      \
+	0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, \
+		0x10, 0x10, 0x10, 0x10, 0x10
+#define B64_LUT_ROLL \
+	0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+#define B64_LUT_ENC                                                        \
+	65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0
+#define B64_DEC_SHUFFLE \
+	2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+#define B64_ENC_SHUFFLE \
+	1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+
+/*
+ * Decode 16 digits into 12 bytes; 16 bytes are written to 'dst'.
+ */
+ISC_TARGET_SSSE3 static size_t
+base64_decode_ssse3(const unsigned char *src, size_t srclen,
+		    unsigned char *dst, size_t dstlen) {
+	const __m128i lut_lo = _mm_setr_epi8(B64_LUT_LO);
+	const __m128i lut_hi = _mm_setr_epi8(B64_LUT_HI);
+	const __m128i lut_roll = _mm_setr_epi8(B64_LUT_ROLL);
+	const __m128i shuffle = _mm_setr_epi8(B64_DEC_SHUFFLE);
+	const __m128i mask_2f = _mm_set1_epi8(0x2f);
+	size_t i = 0, o = 0;
+
+	while (srclen - i >= 16 && dstlen - o >= 16) {
+		__m128i str = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4),
+						   mask_2f);
+		__m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+		__m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+		__m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+		__m128i roll;
+
+		if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi),
+						     _mm_setzero_si128())) != 0)
+		{
+			break;
+		}
+
+		roll = _mm_shuffle_epi8(
+			lut_roll,
+			_mm_add_epi8(_mm_cmpeq_epi8(str, mask_2f), hi_nibbles));
+		str = _mm_add_epi8(str, roll);
+		str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+		str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+		str = _mm_shuffle_epi8(str, shuffle);
+		_mm_storeu_si128((__m128i *)(dst + o), str);
+
+		i += 16;
+		o += 12;
+	}
+
+	return (i);
+}
+
+/*
+ * Decode 32 digits into 24 bytes; 32 bytes are written to 'dst'.
+ */
+ISC_TARGET_AVX2 static size_t
+base64_decode_avx2(const unsigned char *src, size_t srclen,
+		   unsigned char *dst, size_t dstlen) {
+	const __m256i lut_lo = _mm256_setr_epi8(B64_LUT_LO, B64_LUT_LO);
+	const __m256i lut_hi = _mm256_setr_epi8(B64_LUT_HI, B64_LUT_HI);
+	const __m256i lut_roll = _mm256_setr_epi8(B64_LUT_ROLL, B64_LUT_ROLL);
+	const __m256i shuffle = _mm256_setr_epi8(B64_DEC_SHUFFLE,
+						 B64_DEC_SHUFFLE);
+	const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+	const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+	size_t i = 0, o = 0;
+
+	while (srclen - i >= 32 && dstlen - o >= 32) {
+		__m256i str = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4),
+						      mask_2f);
+		__m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+		__m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+		__m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+		__m256i roll;
+
+		if (!_mm256_testz_si256(lo, hi)) {
+			break;
+		}
+
+		roll = _mm256_add_epi8(_mm256_cmpeq_epi8(str, mask_2f),
+				       hi_nibbles);
+		roll = _mm256_shuffle_epi8(lut_roll, roll);
+		str = _mm256_add_epi8(str, roll);
+		str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+		str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+		str = _mm256_shuffle_epi8(str, shuffle);
+		str = _mm256_permutevar8x32_epi32(str, permute);
+		_mm256_storeu_si256((__m256i *)(dst + o), str);
+
+		i += 32;
+		o += 24;
+	}
+
+	return (i);
+}
+
+/*
+ * Encode 12 bytes into 16 digits; 16 bytes are read from 'src'.
+ */
+ISC_TARGET_SSSE3 static size_t
+base64_encode_ssse3(const unsigned char *src, size_t srclen, char *dst) {
+	const __m128i shuffle = _mm_setr_epi8(B64_ENC_SHUFFLE);
+	const __m128i lut = _mm_setr_epi8(B64_LUT_ENC);
+	size_t i = 0, o = 0;
+
+	while (srclen - i >= 16) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i t0, t1, indices;
+
+		in = _mm_shuffle_epi8(in, shuffle);
+		t0 = _mm_mulhi_epu16(_mm_and_si128(in,
+						   _mm_set1_epi32(0x0fc0fc00)),
+				     _mm_set1_epi32(0x04000040));
+		t1 = _mm_mullo_epi16(_mm_and_si128(in,
+						   _mm_set1_epi32(0x003f03f0)),
+				     _mm_set1_epi32(0x01000010));
+		in = _mm_or_si128(t0, t1);
+
+		indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+		indices = _mm_sub_epi8(indices,
+				       _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+		in = _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+		_mm_storeu_si128((__m128i *)(dst + o), in);
+
+		i += 12;
+		o += 16;
+	}
+
+	return (i);
+}
+
+/*
+ * Encode 24 bytes into 32 digits; 28 bytes are read from 'src'.
+ */
+ISC_TARGET_AVX2 static size_t
+base64_encode_avx2(const unsigned char *src, size_t srclen, char *dst) {
+	const __m256i shuffle = _mm256_setr_epi8(B64_ENC_SHUFFLE,
+						 B64_ENC_SHUFFLE);
+	const __m256i lut = _mm256_setr_epi8(B64_LUT_ENC, B64_LUT_ENC);
+	size_t i = 0, o = 0;
+
+	while (srclen - i >= 28) {
+		__m256i in = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(
+				_mm_loadu_si128((const __m128i *)(src + i))),
+			_mm_loadu_si128((const __m128i *)(src + i + 12)), 1);
+		__m256i t0, t1, indices;
+
+		in = _mm256_shuffle_epi8(in, shuffle);
+		t0 = _mm256_mulhi_epu16(
+			_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+			_mm256_set1_epi32(0x04000040));
+		t1 = _mm256_mullo_epi16(
+			_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+			_mm256_set1_epi32(0x01000010));
+		in = _mm256_or_si256(t0, t1);
+
+		indices = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+		indices = _mm256_sub_epi8(
+			indices, _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25)));
+		in = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, indices));
+		_mm256_storeu_si256((__m256i *)(dst + o), in);
+
+		i += 24;
+		o += 32;
+	}
+
+	return (i);
+}
+#endif /* ISC_SIMD_X86 */
+
+static size_t
+base64_decode_groups(const unsigned char *src, size_t srclen,
+		     unsigned char *dst, size_t dstlen) {
+	size_t done = 0;
+
+#if ISC_SIMD_X86
+	if (isc__simd >= isc_simd_avx2) {
+		done = base64_decode_avx2(src, srclen, dst, dstlen);
+	}
+	if (isc__simd >= isc_simd_ssse3) {
+		done += base64_decode_ssse3(src + done, srclen - done,
+					    dst + done / 4 * 3,
+					    dstlen - done / 4 * 3);
+	}
+#endif /* ISC_SIMD_X86 */
+
+	return (done + base64_decode_scalar(src + done, srclen - done,
+					    dst + done / 4 * 3,
+					    dstlen - done / 4 * 3));
+}
+
+/*
+ * Encode the 'srclen' bytes at 'src', which must be a multiple of three.
+ */
+static void
+base64_encode_groups(const unsigned char *src, size_t srclen, char *dst) {
+	size_t done = 0;
+
+#if ISC_SIMD_X86
+	if (isc__simd >= isc_simd_avx2) {
+		done = base64_encode_avx2(src, srclen, dst);
+	}
+	if (isc__simd >= isc_simd_ssse3) {
+		done += base64_encode_ssse3(src + done, srclen - done,
+					    dst + done / 3 * 4);
+	}
+#endif /* ISC_SIMD_X86 */
+
+	base64_encode_scalar(src + done, srclen - done, dst + done / 3 * 4);
+}
+
 isc_result_t
 isc_base64_totext(isc_region_t *source, int wordlength, const char *wordbreak,
 		  isc_buffer_t *target) {
 	char buf[5];
 	unsigned int loops = 0;
+	size_t groups;
 
 	if (wordlength < 4) {
 		wordlength = 4;
 	}
 
+	/*
+	 * The number of groups of four digits on each line, each of which
+	 * is encoded in one go.
+	 */
+	groups = ISC_MAX(((unsigned int)wordlength + 3) / 4 - 1, 1U);
+
 	memset(buf, 0, sizeof(buf));
 	while (source->length > 2) {
-		buf[0] = base64[(source->base[0] >> 2) & 0x3f];
-		buf[1] = base64[((source->base[0] << 4) & 0x30) |
-				((source->base[1] >> 4) & 0x0f)];
-		buf[2] = base64[((source->base[1] << 2) & 0x3c) |
-				((source->base[2] >> 6) & 0x03)];
-		buf[3] = base64[source->base[2] & 0x3f];
-		RETERR(str_totext(buf, target));
-		isc_region_consume(source, 3);
+		size_t n = ISC_MIN(groups - loops, source->length / 3);
+		isc_region_t region;
+
+		isc_buffer_availableregion(target, &region);
+		if (n * 4 > region.length) {
+			return (ISC_R_NOSPACE);
+		}
+		base64_encode_groups(source->base, n * 3, (char *)region.base);
+		isc_buffer_add(target, n * 4);
+		isc_region_consume(source, n * 3);
 
-		loops++;
+		loops += n;
 		if (source->length != 0 && (int)((loops + 1) * 4) >= wordlength)
 		{
 			loops = 0;
@@ -110,15 +423,15 @@ base64_decode_init(base64_decode_ctx_t *ctx, int length, isc_buffer_t *target) {
 
 static isc_result_t
 base64_decode_char(base64_decode_ctx_t *ctx, int c) {
-	const char *s;
+	uint8_t v = base64_value[(unsigned char)c];
 
 	if (ctx->seen_end) {
 		return (ISC_R_BADBASE64);
 	}
-	if ((s = strchr(base64, c)) == NULL) {
+	if (v == 0xff) {
 		return (ISC_R_BADBASE64);
 	}
-	ctx->val[ctx->digits++] = (int)(s - base64);
+	ctx->val[ctx->digits++] = v;
 	if (ctx->digits == 4) {
 		int n;
 		unsigned char buf[3];
@@ -167,6 +480,43 @@ base64_decode_char(base64_decode_ctx_t *ctx, int c) {
 	return (ISC_R_SUCCESS);
 }
 
+/*
+ * Decode the 'length' characters at 'base', which must not contain
+ * white space.  Whole groups of digits are decoded directly into the
+ * target buffer.
+ */
+static isc_result_t
+base64_decode_region(base64_decode_ctx_t *ctx, const unsigned char *base,
+		     size_t length) {
+	while (length > 0) {
+		if (ctx->digits == 0 && !ctx->seen_end && length >= 4) {
+			isc_region_t avail;
+			size_t srclen = length, done;
+
+			if (ctx->length >= 0) {
+				srclen = ISC_MIN(srclen,
+						 (size_t)ctx->length / 3 * 4);
+			}
+			isc_buffer_availableregion(ctx->target, &avail);
+			done = base64_decode_groups(base, srclen, avail.base,
+						    avail.length);
+			isc_buffer_add(ctx->target, done / 4 * 3);
+			if (ctx->length >= 0) {
+				ctx->length -= done / 4 * 3;
+			}
+			base += done;
+			length -= done;
+			if (length == 0) {
+				break;
+			}
+		}
+		RETERR(base64_decode_char(ctx, *base));
+		base++;
+		length--;
+	}
+	return (ISC_R_SUCCESS);
+}
+
 static isc_result_t
 base64_decode_finish(base64_decode_ctx_t *ctx) {
 	if (ctx->length > 0) {
@@ -192,8 +542,6 @@ isc_base64_tobuffer(isc_lex_t *lexer, isc_buffer_t *target, int length) {
 
 	before = isc_buffer_usedlength(target);
 	while (!ctx.seen_end && (ctx.length != 0)) {
-		unsigned int i;
-
 		if (length > 0) {
 			eol = false;
 		} else {
@@ -205,9 +553,8 @@ isc_base64_tobuffer(isc_lex_t *lexer, isc_buffer_t *target, int length) {
 			break;
 		}
 		tr = &token.value.as_textregion;
-		for (i = 0; i < tr->length; i++) {
-			RETERR(base64_decode_char(&ctx, tr->base[i]));
-		}
+		RETERR(base64_decode_region(&ctx, (unsigned char *)tr->base,
+					    tr->length));
 	}
 	after = isc_buffer_usedlength(target);
 	if (ctx.length < 0 && !ctx.seen_end) {
@@ -226,14 +573,15 @@ isc_base64_decodestring(const char *cstr, isc_buffer_t *target) {
 
 	base64_decode_init(&ctx, -1, target);
 	for (;;) {
-		int c = *cstr++;
-		if (c == '\0') {
+		size_t n = strcspn(cstr, " \t\n\r");
+
+		RETERR(base64_decode_region(&ctx, (const unsigned char *)cstr,
+					    n));
+		cstr += n;
+		if (*cstr == '\0') {
 			break;
 		}
-		if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-			continue;
-		}
-		RETERR(base64_decode_char(&ctx, c));
+		cstr++;
 	}
 	RETERR(base64_decode_finish(&ctx));
 	return (ISC_R_SUCCESS);
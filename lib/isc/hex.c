@@ -14,6 +14,7 @@
 /*! \file */
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include <isc/buffer.h>
 #include <isc/hex.h>
@@ -21,6 +22,8 @@
 #include <isc/string.h>
 #include <isc/util.h>
 
+#include "simd_p.h"
+
 #define D ('0' - 0x0) /* ascii '0' to hex */
 #define U ('A' - 0xA) /* ascii 'A' to hex */
 #define L ('a' - 0xa) /* ascii 'a' to hex */
@@ -56,24 +59,223 @@ mem_tobuffer(isc_buffer_t *target, void *base, unsigned int length);
 
 static const char hex[] = "0123456789ABCDEF";
 
+/*
+ * Bulk encoding and decoding of whole bytes.  The vector implementations
+ * handle as many blocks as they can and leave the remainder to the
+ * narrower ones, and finally the scalar implementation.
+ *
+ * The decoders stop before the first pair of characters that are not
+ * both hex digits, leaving it to hex_decode_char() to reject, and return
+ * the number of digits decoded.
+ */
+static size_t
+hex_decode_scalar(const unsigned char *src, size_t srclen,
+		  unsigned char *dst, size_t dstlen) {
+	size_t i = 0;
+
+	while (srclen - i >= 2 && dstlen > 0) {
+		uint8_t hi = isc_hex_char(src[i]);
+		uint8_t lo = isc_hex_char(src[i + 1]);
+
+		if (hi == 0 || lo == 0) {
+			break;
+		}
+		*dst++ = ((src[i] - hi) << 4) | (src[i + 1] - lo);
+		dstlen--;
+		i += 2;
+	}
+
+	return (i);
+}
+
+static void
+hex_encode_scalar(const unsigned char *src, size_t srclen, char *dst) {
+	for (size_t i = 0; i < srclen; i++) {
+		*dst++ = hex[(src[i] >> 4) & 0xf];
+		*dst++ = hex[src[i] & 0xf];
+	}
+}
+
+#if ISC_SIMD_X86
+#define HEX_DIGITS                                                         \
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', \
+		'E', 'F'
+
+/*
+ * Replace the hex digits in 'v' by their values, or return false if any
+ * of them are not hex digits.
+ */
+ISC_TARGET_SSSE3 static inline bool
+hex_values_ssse3(__m128i *v) {
+	const __m128i digit = _mm_sub_epi8(*v, _mm_set1_epi8('0'));
+	const __m128i lower = _mm_or_si128(*v, _mm_set1_epi8(0x20));
+	const __m128i alpha = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+	const __m128i isdigit =
+		_mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+	const __m128i isalpha =
+		_mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+	if (_mm_movemask_epi8(_mm_or_si128(isdigit, isalpha)) != 0xffff) {
+		return (false);
+	}
+
+	*v = _mm_or_si128(
+		_mm_and_si128(isdigit, digit),
+		_mm_and_si128(isalpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+	return (true);
+}
+
+/*
+ * Decode 32 digits into 16 bytes.
+ */
+ISC_TARGET_SSSE3 static size_t
+hex_decode_ssse3(const unsigned char *src, size_t srclen, unsigned char *dst,
+		 size_t dstlen) {
+	const __m128i weights = _mm_set1_epi16(0x0110);
+	size_t i = 0, o = 0;
+
+	while (srclen - i >= 32 && dstlen - o >= 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + i + 16));
+
+		if (!hex_values_ssse3(&a) || !hex_values_ssse3(&b)) {
+			break;
+		}
+
+		a = _mm_maddubs_epi16(a, weights);
+		b = _mm_maddubs_epi16(b, weights);
+		_mm_storeu_si128((__m128i *)(dst + o), _mm_packus_epi16(a, b));
+
+		i += 32;
+		o += 16;
+	}
+
+	return (i);
+}
+
+/*
+ * Encode 16 bytes into 32 digits.
+ */
+ISC_TARGET_SSSE3 static size_t
+hex_encode_ssse3(const unsigned char *src, size_t srclen, char *dst) {
+	const __m128i digits = _mm_setr_epi8(HEX_DIGITS);
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	size_t i = 0, o = 0;
+
+	while (srclen - i >= 16) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i hi = _mm_shuffle_epi8(
+			digits, _mm_and_si128(_mm_srli_epi16(in, 4), mask));
+		__m128i lo = _mm_shuffle_epi8(digits, _mm_and_si128(in, mask));
+
+		_mm_storeu_si128((__m128i *)(dst + o),
+				 _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *)(dst + o + 16),
+				 _mm_unpackhi_epi8(hi, lo));
+
+		i += 16;
+		o += 32;
+	}
+
+	return (i);
+}
+
+/*
+ * Encode 32 bytes into 64 digits.
+ */
+ISC_TARGET_AVX2 static size_t
+hex_encode_avx2(const unsigned char *src, size_t srclen, char *dst) {
+	const __m256i digits = _mm256_setr_epi8(HEX_DIGITS, HEX_DIGITS);
+	const __m256i mask = _mm256_set1_epi8(0x0f);
+	size_t i = 0, o = 0;
+
+	while (srclen - i >= 32) {
+		__m256i in = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 4), mask);
+		__m256i lo = _mm256_and_si256(in, mask);
+		__m256i first, second;
+
+		hi = _mm256_shuffle_epi8(digits, hi);
+		lo = _mm256_shuffle_epi8(digits, lo);
+		first = _mm256_unpacklo_epi8(hi, lo);
+		second = _mm256_unpackhi_epi8(hi, lo);
+
+		/* The unpacking works within each 128 bit lane */
+		_mm256_storeu_si256((__m256i *)(dst + o),
+				    _mm256_permute2x128_si256(first, second,
+							      0x20));
+		_mm256_storeu_si256((__m256i *)(dst + o + 32),
+				    _mm256_permute2x128_si256(first, second,
+							      0x31));
+
+		i += 32;
+		o += 64;
+	}
+
+	return (i);
+}
+#endif /* ISC_SIMD_X86 */
+
+static size_t
+hex_decode_bytes(const unsigned char *src, size_t srclen, unsigned char *dst,
+		 size_t dstlen) {
+	size_t done = 0;
+
+#if ISC_SIMD_X86
+	if (isc__simd >= isc_simd_ssse3) {
+		done = hex_decode_ssse3(src, srclen, dst, dstlen);
+	}
+#endif /* ISC_SIMD_X86 */
+
+	return (done + hex_decode_scalar(src + done, srclen - done,
+					 dst + done / 2, dstlen - done / 2));
+}
+
+static void
+hex_encode_bytes(const unsigned char *src, size_t srclen, char *dst) {
+	size_t done = 0;
+
+#if ISC_SIMD_X86
+	if (isc__simd >= isc_simd_avx2) {
+		done = hex_encode_avx2(src, srclen, dst);
+	}
+	if (isc__simd >= isc_simd_ssse3) {
+		done += hex_encode_ssse3(src + done, srclen - done,
+					 dst + done * 2);
+	}
+#endif /* ISC_SIMD_X86 */
+
+	hex_encode_scalar(src + done, srclen - done, dst + done * 2);
+}
+
 isc_result_t
 isc_hex_totext(isc_region_t *source, int wordlength, const char *wordbreak,
 	       isc_buffer_t *target) {
-	char buf[3];
 	unsigned int loops = 0;
+	size_t bytes;
 
 	if (wordlength < 2) {
 		wordlength = 2;
 	}
 
-	memset(buf, 0, sizeof(buf));
+	/*
+	 * The number of bytes on each line, which are encoded in one go.
+	 */
+	bytes = ISC_MAX(((unsigned int)wordlength + 1) / 2 - 1, 1U);
+
 	while (source->length > 0) {
-		buf[0] = hex[(source->base[0] >> 4) & 0xf];
-		buf[1] = hex[(source->base[0]) & 0xf];
-		RETERR(str_totext(buf, target));
-		isc_region_consume(source, 1);
+		size_t n = ISC_MIN(bytes - loops, source->length);
+		isc_region_t region;
 
-		loops++;
+		isc_buffer_availableregion(target, &region);
+		if (n * 2 > region.length) {
+			return (ISC_R_NOSPACE);
+		}
+		hex_encode_bytes(source->base, n, (char *)region.base);
+		isc_buffer_add(target, n * 2);
+		isc_region_consume(source, n);
+
+		loops += n;
 		if (source->length != 0 && (int)((loops + 1) * 2) >= wordlength)
 		{
 			loops = 0;
@@ -126,6 +328,42 @@ hex_decode_char(hex_decode_ctx_t *ctx, int c) {
 	return (ISC_R_SUCCESS);
 }
 
+/*
+ * Decode the 'length' characters at 'base', which must not contain
+ * white space.  Whole bytes are decoded directly into the target buffer.
+ */
+static isc_result_t
+hex_decode_region(hex_decode_ctx_t *ctx, const unsigned char *base,
+		  size_t length) {
+	while (length > 0) {
+		if (ctx->digits == 0 && length >= 2) {
+			isc_region_t avail;
+			size_t srclen = length, done;
+
+			if (ctx->length >= 0) {
+				srclen = ISC_MIN(srclen,
+						 (size_t)ctx->length * 2);
+			}
+			isc_buffer_availableregion(ctx->target, &avail);
+			done = hex_decode_bytes(base, srclen, avail.base,
+						avail.length);
+			isc_buffer_add(ctx->target, done / 2);
+			if (ctx->length >= 0) {
+				ctx->length -= done / 2;
+			}
+			base += done;
+			length -= done;
+			if (length == 0) {
+				break;
+			}
+		}
+		RETERR(hex_decode_char(ctx, *base));
+		base++;
+		length--;
+	}
+	return (ISC_R_SUCCESS);
+}
+
 static isc_result_t
 hex_decode_finish(hex_decode_ctx_t *ctx) {
 	if (ctx->length > 0) {
@@ -151,8 +389,6 @@ isc_hex_tobuffer(isc_lex_t *lexer, isc_buffer_t *target, int length) {
 
 	before = isc_buffer_usedlength(target);
 	while (ctx.length != 0) {
-		unsigned int i;
-
 		if (length > 0) {
 			eol = false;
 		} else {
@@ -164,9 +400,8 @@ isc_hex_tobuffer(isc_lex_t *lexer, isc_buffer_t *target, int length) {
 			break;
 		}
 		tr = &token.value.as_textregion;
-		for (i = 0; i < tr->length; i++) {
-			RETERR(hex_decode_char(&ctx, tr->base[i]));
-		}
+		RETERR(hex_decode_region(&ctx, (unsigned char *)tr->base,
+					 tr->length));
 	}
 	after = isc_buffer_usedlength(target);
 	if (ctx.length < 0) {
@@ -185,14 +420,14 @@ isc_hex_decodestring(const char *cstr, isc_buffer_t *target) {
 
 	hex_decode_init(&ctx, -1, target);
 	for (;;) {
-		int c = *cstr++;
-		if (c == '\0') {
+		size_t n = strcspn(cstr, " \t\n\r");
+
+		RETERR(hex_decode_region(&ctx, (const unsigned char *)cstr, n));
+		cstr += n;
+		if (*cstr == '\0') {
 			break;
 		}
-		if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
-			continue;
-		}
-		RETERR(hex_decode_char(&ctx, c));
+		cstr++;
 	}
 	RETERR(hex_decode_finish(&ctx));
 	return (ISC_R_SUCCESS);
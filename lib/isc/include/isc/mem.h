@@ -81,6 +81,10 @@ extern unsigned int isc_mem_defaultflags;
 #define ISC_MEMFLAG_RESERVED2 0x00000002 /* reserved, obsoleted, don't use */
 #define ISC_MEMFLAG_FILL \
 	0x00000004 /* fill with pattern after alloc and frees */
+#define ISC_MEMFLAG_SHARDED \
+	0x00000008 /* account allocations in per-loop shards */
+#define ISC_MEMFLAG_LOOPARENAS \
+	0x00000010 /* bind each loop thread to its own jemalloc arena */
 
 /*%
  * Define ISC_MEM_DEFAULTFILL=1 to turn filling the memory with pattern
@@ -323,6 +327,11 @@ isc_mem_setwater(isc_mem_t *mctx, isc_mem_water_t water, void *water_arg,
  * high- and low-water processing are disabled for this memory context.  There's
  * a convenient function isc_mem_clearwater().
  *
+ * If 'mctx' was created with #ISC_MEMFLAG_SHARDED, the marks are checked
+ * against a counter that is only updated once a thread has accumulated
+ * a batch of allocations or frees, so the callbacks can fire a few
+ * megabytes later than they would otherwise.
+ *
  * Requires:
  *
  *\li   If 'water' is NULL, 'hiwater' and 'lowater' must be set to 0.
@@ -426,6 +426,21 @@ isc_nm_setloadbalancesockets(isc_nm_t *mgr, bool enabled);
  * \li	'mgr' is a valid netmgr.
  */
 
+bool
+isc_nm_getiouring(isc_nm_t *mgr);
+void
+isc_nm_setiouring(isc_nm_t *mgr, bool enabled);
+/*%<
+ * Get and set whether UDP listeners receive and send through io_uring
+ * instead of libuv.  The setting takes effect for listeners started
+ * afterwards.  It is ignored when built without liburing, and a
+ * listener falls back to libuv when the kernel doesn't support the
+ * required io_uring features.
+ *
+ * Requires:
+ * \li	'mgr' is a valid netmgr.
+ */
+
 void
 isc_nm_gettimeouts(isc_nm_t *mgr, uint32_t *initial, uint32_t *idle,
 		   uint32_t *keepalive, uint32_t *advertised);
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#pragma once
+
+/*! \file isc/simd.h
+ * \brief Selection of the vector instructions used by the encoding
+ * routines, such as isc_base64_tobuffer() and isc_hex_totext().
+ *
+ * The best instruction set supported by both the compiler and the CPU is
+ * chosen when the library is initialized; a scalar implementation is
+ * always available.
+ */
+
+#include <isc/lang.h>
+
+typedef enum {
+	isc_simd_none = 0,  /*%< Scalar code only */
+	isc_simd_ssse3 = 1, /*%< x86 SSSE3 */
+	isc_simd_avx2 = 2,  /*%< x86 AVX2 */
+} isc_simd_t;
+
+ISC_LANG_BEGINDECLS
+
+isc_simd_t
+isc_simd_supported(void);
+/*%<
+ * Return the best instruction set supported by the CPU that this build
+ * of the library can use.
+ */
+
+isc_simd_t
+isc_simd_get(void);
+/*%<
+ * Return the instruction set in use.
+ */
+
+isc_simd_t
+isc_simd_set(isc_simd_t simd);
+/*%<
+ * Use 'simd', or the best supported instruction set if 'simd' is not
+ * supported, and return the instruction set now in use.  This is meant
+ * for testing and benchmarking, and must be called before any other
+ * threads are started.
+ */
+
+const char *
+isc_simd_totext(isc_simd_t simd);
+/*%<
+ * Return the name of 'simd'.
+ */
+
+ISC_LANG_ENDDECLS
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#pragma once
+
+/*****
+***** Module Info
+*****/
+
+/*! \file isc/timerwheel.h
+ * \brief A hierarchical timing wheel for large numbers of coarse-grained
+ * timers, such as the zone maintenance timers.
+ *
+ * A timer wheel belongs to a loop and is driven by a single isc_timer_t,
+ * which only runs while any of the wheel's timers are pending.  The wheel
+ * timers themselves are embedded in the objects that use them, so no
+ * memory is allocated when they are started or stopped, and starting,
+ * stopping and expiring a timer all take constant time regardless of the
+ * number of pending timers.
+ *
+ * Wheel timers have a resolution of one second: a timer started with a
+ * timeout of 'n' seconds expires no earlier than 'n' and no later than
+ * 'n + 1' seconds after it was started.  A timeout of zero makes the timer
+ * expire on the next iteration of the loop.
+ *
+ * \li MP:
+ *	A timer wheel and its timers must only be started, stopped and
+ *	expired on the wheel's loop.  isc_timerwheel_create(),
+ *	isc_timerwheel_shutdown() and the reference counting functions can
+ *	be called from any thread.
+ */
+
+/***
+ *** Imports.
+ ***/
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include <isc/job.h>
+#include <isc/lang.h>
+#include <isc/list.h>
+#include <isc/refcount.h>
+#include <isc/types.h>
+
+typedef ISC_LIST(isc_wheeltimer_t) isc_wheelslot_t;
+
+struct isc_wheeltimer {
+	isc_timerwheel_t *wheel;
+	isc_job_cb	  cb;
+	void		 *cbarg;
+	uint64_t	  expires;
+	isc_wheelslot_t	 *slot;
+	ISC_LINK(isc_wheeltimer_t) link;
+};
+
+ISC_LANG_BEGINDECLS
+
+/*****
+***** Functions.
+*****/
+
+void
+isc_timerwheel_create(isc_loop_t *loop, isc_timerwheel_t **wheelp);
+/*%<
+ * Create a timer wheel for timers expiring on 'loop'.
+ *
+ * Requires:
+ *\li	'loop' is a valid loop.
+ *\li	'wheelp' is not NULL and '*wheelp' is NULL.
+ */
+
+void
+isc_timerwheel_shutdown(isc_timerwheel_t *wheel);
+/*%<
+ * Shut down the timer wheel.  Pending timers are not expired and further
+ * attempts to start timers are ignored; the timers must still be
+ * invalidated by their owners.
+ *
+ * Requires:
+ *\li	'wheel' is a valid timer wheel.
+ */
+
+size_t
+isc_timerwheel_pending(isc_timerwheel_t *wheel);
+/*%<
+ * Return the number of timers pending on 'wheel'.
+ *
+ * Requires:
+ *\li	'wheel' is a valid timer wheel.
+ *\li	The caller is running on the wheel's loop.
+ */
+
+ISC_REFCOUNT_DECL(isc_timerwheel);
+/*%<
+ * The timer wheel reference counting.
+ */
+
+void
+isc_wheeltimer_init(isc_wheeltimer_t *timer, isc_timerwheel_t *wheel,
+		    isc_job_cb cb, void *cbarg);
+/*%<
+ * Initialize 'timer' to call 'cb' with 'cbarg' on the loop of 'wheel'
+ * when it expires.  The timer is initially stopped and holds a reference
+ * to 'wheel' until it is invalidated.
+ *
+ * Requires:
+ *\li	'timer' is not NULL and is not initialized.
+ *\li	'wheel' is a valid timer wheel.
+ *\li	'cb' is not NULL.
+ */
+
+void
+isc_wheeltimer_start(isc_wheeltimer_t *timer, uint32_t seconds);
+/*%<
+ * Start 'timer', or restart it if it is already pending, so that it
+ * expires after 'seconds'.  The timer is stopped before its callback is
+ * called, and the callback may start it again.
+ *
+ * Requires:
+ *\li	'timer' is initialized.
+ *\li	The caller is running on the wheel's loop.
+ */
+
+void
+isc_wheeltimer_stop(isc_wheeltimer_t *timer);
+/*%<
+ * Stop 'timer' if it is pending.
+ *
+ * Requires:
+ *\li	'timer' is initialized.
+ *\li	The caller is running on the wheel's loop.
+ */
+
+bool
+isc_wheeltimer_initialized(const isc_wheeltimer_t *timer);
+/*%<
+ * Return true if 'timer' has been initialized and not invalidated.
+ */
+
+bool
+isc_wheeltimer_pending(const isc_wheeltimer_t *timer);
+/*%<
+ * Return true if 'timer' is pending.
+ */
+
+void
+isc_wheeltimer_invalidate(isc_wheeltimer_t *timer);
+/*%<
+ * Stop 'timer' and release its reference to the timer wheel.
+ *
+ * Requires:
+ *\li	'timer' is initialized.
+ *\li	If 'timer' is pending, the caller is running on the wheel's loop.
+ */
+
+ISC_LANG_ENDDECLS
@@ -188,6 +188,55 @@ isc_tls_verify_peer_result_string(isc_tls_t *tls);
  *\li	'tls' != NULL.
  */
 
+void
+isc_tlsctx_enable_ktls(isc_tlsctx_t *ctx);
+/*%<
+ * Allow connections using the TLS context 'ctx' to hand their sending
+ * direction over to the kernel (Linux kernel TLS) once the handshake is
+ * complete; see isc_tls_ktls_enable_tx().  This is a no-op on systems
+ * without kernel TLS support.
+ *
+ * Requires:
+ *\li	'ctx' != NULL.
+ */
+
+isc_result_t
+isc_tls_ktls_enable_tx(isc_tls_t *tls, int fd);
+/*%<
+ * Install the sending keys of the TLS 1.3 connection 'tls' into the TCP
+ * socket 'fd' so that the kernel encrypts everything written to the
+ * socket from now on, continuing from the record sequence number
+ * OpenSSL's record layer has reached.  Everything OpenSSL has written
+ * must already have been sent on 'fd'.  After a successful call nothing
+ * may be written to 'fd' through 'tls' again.
+ *
+ * Requires:
+ *\li	'tls' != NULL and its handshake is complete.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS		-- the kernel now encrypts outgoing data.
+ *\li	#ISC_R_NOTFOUND		-- kernel TLS was not enabled on the
+ *				   context of 'tls'.
+ *\li	#ISC_R_NOTIMPLEMENTED	-- the protocol version, the cipher or
+ *				   the kernel does not support it, or
+ *				   the sending keys have been updated.
+ *\li	Other errors from setsockopt().
+ */
+
+isc_result_t
+isc_tls_ktls_close_notify(int fd);
+/*%<
+ * Have the kernel send a close_notify alert on the TCP socket 'fd',
+ * whose sending direction has been handed over with
+ * isc_tls_ktls_enable_tx().  The alert is written without blocking, so
+ * it must not be queued behind other data.
+ *
+ * Returns:
+ *\li	#ISC_R_SUCCESS		-- the alert has been sent.
+ *\li	#ISC_R_NOTIMPLEMENTED	-- no kernel TLS support.
+ *\li	Other errors from sendmsg().
+ */
+
 #if HAVE_LIBNGHTTP2
 void
 isc_tlsctx_enable_http2client_alpn(isc_tlsctx_t *ctx);
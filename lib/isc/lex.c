@@ -30,6 +30,12 @@
 
 #include "errno2result.h"
 
+/*
+ * Files opened by isc_lex_openfile() are read in blocks of this size,
+ * rather than a character at a time.
+ */
+#define LEX_BLOCKSIZE (64 * 1024)
+
 typedef struct inputsource {
 	isc_result_t result;
 	bool is_file;
@@ -39,6 +45,9 @@ typedef struct inputsource {
 	isc_buffer_t *pushback;
 	unsigned int ignored;
 	void *input;
+	unsigned char *block; /*%< Input read ahead from a file, or NULL */
+	size_t blockpos;
+	size_t blocklen;
 	char *name;
 	unsigned long line;
 	unsigned long saved_line;
@@ -48,6 +57,18 @@ typedef struct inputsource {
 #define LEX_MAGIC    ISC_MAGIC('L', 'e', 'x', '!')
 #define VALID_LEX(l) ISC_MAGIC_VALID(l, LEX_MAGIC)
 
+/*
+ * Character classes used by gettoken_fast() to find the end of a string
+ * or number.  A string ends at a delimiter, and the characters in the
+ * other classes have to be handled by the state machine in
+ * isc_lex_gettoken() when the corresponding option or comment style is
+ * in use.
+ */
+#define LEXCLASS_DELIM	   0x01 /*%< White space or a special character */
+#define LEXCLASS_COMMENT   0x02 /*%< Starts a comment */
+#define LEXCLASS_ESCAPE	   0x04 /*%< Backslash */
+#define LEXCLASS_VPAIR	   0x08 /*%< Equals sign */
+
 struct isc_lex {
 	/* Unlocked. */
 	unsigned int magic;
@@ -61,9 +82,39 @@ struct isc_lex {
 	unsigned int paren_count;
 	unsigned int saved_paren_count;
 	isc_lexspecials_t specials;
+	uint8_t classes[256];
 	LIST(struct inputsource) sources;
 };
 
+static void
+set_classes(isc_lex_t *lex) {
+	memset(lex->classes, 0, sizeof(lex->classes));
+	for (size_t c = 0; c < sizeof(lex->classes); c++) {
+		if (lex->specials[c]) {
+			lex->classes[c] |= LEXCLASS_DELIM;
+		}
+	}
+	lex->classes[' '] |= LEXCLASS_DELIM;
+	lex->classes['\t'] |= LEXCLASS_DELIM;
+	lex->classes['\r'] |= LEXCLASS_DELIM;
+	lex->classes['\n'] |= LEXCLASS_DELIM;
+
+	if ((lex->comments & ISC_LEXCOMMENT_DNSMASTERFILE) != 0) {
+		lex->classes[';'] |= LEXCLASS_COMMENT;
+	}
+	if ((lex->comments & (ISC_LEXCOMMENT_C | ISC_LEXCOMMENT_CPLUSPLUS)) !=
+	    0)
+	{
+		lex->classes['/'] |= LEXCLASS_COMMENT;
+	}
+	if ((lex->comments & ISC_LEXCOMMENT_SHELL) != 0) {
+		lex->classes['#'] |= LEXCLASS_COMMENT;
+	}
+
+	lex->classes['\\'] |= LEXCLASS_ESCAPE;
+	lex->classes['='] |= LEXCLASS_VPAIR;
+}
+
 static isc_result_t
 grow_data(isc_lex_t *lex, size_t *remainingp, char **currp, char **prevp) {
 	char *tmp;
@@ -105,6 +156,7 @@ isc_lex_create(isc_mem_t *mctx, size_t max_token, isc_lex_t **lexp) {
 	lex->paren_count = 0;
 	lex->saved_paren_count = 0;
 	memset(lex->specials, 0, 256);
+	set_classes(lex);
 	INIT_LIST(lex->sources);
 	lex->magic = LEX_MAGIC;
 
@@ -154,6 +206,7 @@ isc_lex_setcomments(isc_lex_t *lex, unsigned int comments) {
 	REQUIRE(VALID_LEX(lex));
 
 	lex->comments = comments;
+	set_classes(lex);
 }
 
 void
@@ -177,6 +230,7 @@ isc_lex_setspecials(isc_lex_t *lex, isc_lexspecials_t specials) {
 	REQUIRE(VALID_LEX(lex));
 
 	memmove(lex->specials, specials, 256);
+	set_classes(lex);
 }
 
 static isc_result_t
@@ -191,6 +245,9 @@ new_source(isc_lex_t *lex, bool is_file, bool need_close, void *input,
 	source->at_eof = false;
 	source->last_was_eol = lex->last_was_eol;
 	source->input = input;
+	source->block = NULL;
+	source->blockpos = 0;
+	source->blocklen = 0;
 	source->name = isc_mem_strdup(lex->mctx, name);
 	source->pushback = NULL;
 	isc_buffer_allocate(lex->mctx, &source->pushback,
@@ -221,8 +278,15 @@ isc_lex_openfile(isc_lex_t *lex, const char *filename) {
 	result = new_source(lex, true, true, stream, filename);
 	if (result != ISC_R_SUCCESS) {
 		(void)fclose(stream);
+		return (result);
 	}
-	return (result);
+
+	/*
+	 * Nothing else reads from the stream, so it can be read ahead.
+	 */
+	HEAD(lex->sources)->block = isc_mem_get(lex->mctx, LEX_BLOCKSIZE);
+
+	return (ISC_R_SUCCESS);
 }
 
 isc_result_t
@@ -277,6 +341,9 @@ isc_lex_close(isc_lex_t *lex) {
 			(void)fclose((FILE *)(source->input));
 		}
 	}
+	if (source->block != NULL) {
+		isc_mem_put(lex->mctx, source->block, LEX_BLOCKSIZE);
+	}
 	isc_mem_free(lex->mctx, source->name);
 	isc_buffer_free(&source->pushback);
 	isc_mem_put(lex->mctx, source, sizeof(*source));
@@ -315,9 +382,9 @@ pushback(inputsource *source, int c) {
 	}
 }
 
-static isc_result_t
-pushandgrow(isc_lex_t *lex, inputsource *source, int c) {
-	if (isc_buffer_availablelength(source->pushback) == 0) {
+static void
+growpushback(isc_lex_t *lex, inputsource *source, size_t length) {
+	while (isc_buffer_availablelength(source->pushback) < length) {
 		isc_buffer_t *tbuf = NULL;
 		unsigned int oldlen;
 		isc_region_t used;
@@ -332,10 +399,158 @@ pushandgrow(isc_lex_t *lex, inputsource *source, int c) {
 		isc_buffer_free(&source->pushback);
 		source->pushback = tbuf;
 	}
+}
+
+static isc_result_t
+pushandgrow(isc_lex_t *lex, inputsource *source, int c) {
+	growpushback(lex, source, 1);
 	isc_buffer_putuint8(source->pushback, (uint8_t)c);
 	return (ISC_R_SUCCESS);
 }
 
+static isc_result_t
+fill_block(inputsource *source) {
+	FILE *stream = source->input;
+
+	source->blockpos = 0;
+	source->blocklen = fread(source->block, 1, LEX_BLOCKSIZE, stream);
+	if (source->blocklen == 0 && ferror(stream)) {
+		return (isc__errno2result(errno));
+	}
+	return (ISC_R_SUCCESS);
+}
+
+/*
+ * Scan a string or number directly from the input read ahead from a
+ * file, or from a buffer, rather than a character at a time through the
+ * pushback buffer.  Only tokens which lie within the input read so far,
+ * which are ended by white space or a special character, and which do
+ * not contain anything that the state machine in isc_lex_gettoken()
+ * would treat specially are handled here: otherwise nothing is consumed
+ * and false is returned.
+ */
+static bool
+gettoken_fast(isc_lex_t *lex, inputsource *source, unsigned int options,
+	      isc_token_t *tokenp, isc_result_t *resultp) {
+	const unsigned char *base = NULL;
+	size_t avail, start = 0, end, length;
+	unsigned int stop = LEXCLASS_DELIM;
+	uint32_t as_ulong;
+	bool number;
+
+	if (isc_buffer_remaininglength(source->pushback) != 0) {
+		return (false);
+	}
+
+	if (source->block != NULL) {
+		if (source->blockpos == source->blocklen) {
+			isc_result_t result = fill_block(source);
+			if (result != ISC_R_SUCCESS) {
+				source->result = result;
+				*resultp = result;
+				return (true);
+			}
+		}
+		base = source->block + source->blockpos;
+		avail = source->blocklen - source->blockpos;
+	} else if (!source->is_file) {
+		base = isc_buffer_current((isc_buffer_t *)source->input);
+		avail = isc_buffer_remaininglength(
+			(isc_buffer_t *)source->input);
+	} else {
+		return (false);
+	}
+
+	if (!lex->last_was_eol || (options & ISC_LEXOPT_INITIALWS) == 0) {
+		while (start < avail &&
+		       (base[start] == ' ' || base[start] == '\t'))
+		{
+			start++;
+		}
+	}
+	if (start == avail || (lex->classes[base[start]] & LEXCLASS_DELIM) != 0)
+	{
+		return (false);
+	}
+	if (base[start] == '"' && (options & ISC_LEXOPT_QSTRING) != 0) {
+		return (false);
+	}
+
+	number = ((options & ISC_LEXOPT_NUMBER) != 0 &&
+		  isdigit((unsigned char)base[start]));
+	if (number &&
+	    (options & (ISC_LEXOPT_OCTAL | ISC_LEXOPT_CNUMBER)) != 0)
+	{
+		return (false);
+	}
+
+	if (lex->comment_ok) {
+		stop |= LEXCLASS_COMMENT;
+	}
+	if ((options & ISC_LEXOPT_ESCAPE) != 0) {
+		stop |= LEXCLASS_ESCAPE;
+	}
+	if ((options & ISC_LEXOPT_VPAIR) != 0) {
+		stop |= LEXCLASS_VPAIR;
+	}
+
+	end = start;
+	while (end < avail && (lex->classes[base[end]] & stop) == 0) {
+		end++;
+	}
+	if (end == avail || (lex->classes[base[end]] & stop) != LEXCLASS_DELIM) {
+		return (false);
+	}
+	length = end - start;
+
+	/*
+	 * Consume the token, leaving its delimiter, as if it had been read
+	 * into the pushback buffer a character at a time.
+	 */
+	growpushback(lex, source, end);
+	source->ignored = isc_buffer_consumedlength(source->pushback) + start;
+	isc_buffer_putmem(source->pushback, base, (unsigned int)end);
+	isc_buffer_forward(source->pushback, (unsigned int)end);
+	if (source->block != NULL) {
+		source->blockpos += end;
+	} else {
+		isc_buffer_forward((isc_buffer_t *)source->input,
+				   (unsigned int)end);
+	}
+
+	if (length > lex->max_token) {
+		size_t remaining = 0;
+		char *curr = lex->data, *prev = NULL;
+
+		while (length > lex->max_token) {
+			(void)grow_data(lex, &remaining, &curr, &prev);
+		}
+	}
+	memmove(lex->data, base + start, length);
+	lex->data[length] = '\0';
+	lex->last_was_eol = false;
+
+	for (size_t i = 0; number && i < length; i++) {
+		number = isdigit((unsigned char)lex->data[i]);
+	}
+	if (number) {
+		*resultp = isc_parse_uint32(&as_ulong, lex->data, 10);
+		if (*resultp == ISC_R_SUCCESS) {
+			tokenp->type = isc_tokentype_number;
+			tokenp->value.as_ulong = as_ulong;
+			return (true);
+		} else if (*resultp != ISC_R_BADNUMBER) {
+			return (true);
+		}
+	}
+
+	tokenp->type = isc_tokentype_string;
+	tokenp->value.as_textregion.base = lex->data;
+	tokenp->value.as_textregion.length = (unsigned int)length;
+	*resultp = ISC_R_SUCCESS;
+	return (true);
+}
+
 isc_result_t
 isc_lex_gettoken(isc_lex_t *lex, unsigned int options, isc_token_t *tokenp) {
 	inputsource *source;
@@ -409,6 +624,10 @@ isc_lex_gettoken(isc_lex_t *lex, unsigned int options, isc_token_t *tokenp) {
 	prev = NULL;
 	remaining = lex->max_token;
 
+	if (gettoken_fast(lex, source, options, tokenp, &result)) {
+		return (result);
+	}
+
 #ifdef HAVE_FLOCKFILE
 	if (source->is_file) {
 		flockfile(source->input);
@@ -417,7 +636,21 @@ isc_lex_gettoken(isc_lex_t *lex, unsigned int options, isc_token_t *tokenp) {
 
 	do {
 		if (isc_buffer_remaininglength(source->pushback) == 0) {
-			if (source->is_file) {
+			if (source->block != NULL) {
+				if (source->blockpos == source->blocklen) {
+					source->result = fill_block(source);
+					if (source->result != ISC_R_SUCCESS) {
+						result = source->result;
+						goto done;
+					}
+				}
+				if (source->blockpos < source->blocklen) {
+					c = source->block[source->blockpos++];
+				} else {
+					c = EOF;
+					source->at_eof = true;
+				}
+			} else if (source->is_file) {
 				stream = source->input;
 
 #if defined(HAVE_FLOCKFILE) && defined(HAVE_GETC_UNLOCKED)
@@ -28,6 +28,7 @@
 #include "mem_p.h"
 #include "mutex_p.h"
 #include "os_p.h"
+#include "simd_p.h"
 
 #ifndef ISC_CONSTRUCTOR
 #error Either __attribute__((constructor|destructor))__ or DllMain support needed to compile BIND 9.
@@ -45,6 +46,7 @@ isc__shutdown(void) ISC_DESTRUCTOR;
 void
 isc__initialize(void) {
 	isc__os_initialize();
+	isc__simd_initialize();
 	isc__mutex_initialize();
 	isc__mem_initialize();
 	isc__tls_initialize();
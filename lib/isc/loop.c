@@ -41,6 +41,7 @@
 #include "async_p.h"
 #include "job_p.h"
 #include "loop_p.h"
+#include "mem_p.h"
 
 /**
  * Private
@@ -265,6 +266,7 @@ loop_thread(void *arg) {
 	/* Initialize the thread_local variable */
 
 	isc__tid_init(loop->tid);
+	isc__mem_bindloop(loop->tid);
 
 	int r = uv_prepare_start(&loop->quiescent, quiescent_cb);
 	UV_RUNTIME_CHECK(uv_prepare_start, r);
@@ -32,6 +32,7 @@
 #include <isc/refcount.h>
 #include <isc/strerr.h>
 #include <isc/string.h>
+#include <isc/tid.h>
 #include <isc/types.h>
 #include <isc/urcu.h>
 #include <isc/util.h>
@@ -78,6 +79,17 @@ unsigned int isc_mem_defaultflags = ISC_MEMFLAG_DEFAULT;
 #define ALIGNMENT_SIZE	     sizeof(size_info)
 #define DEBUG_TABLE_COUNT    512U
 
+/*
+ * Contexts created with ISC_MEMFLAG_SHARDED account their allocations
+ * in per-loop shards and only fold a shard into the shared 'inuse'
+ * counter once its pending delta reaches MEM_SHARD_BATCH bytes in
+ * either direction.  The shared counter, which the hi/lo water checks
+ * use, therefore lags the real usage by at most
+ * MEM_SHARDS * MEM_SHARD_BATCH bytes.
+ */
+#define MEM_SHARDS	64U
+#define MEM_SHARD_BATCH (64 * 1024)
+
 /*
  * Types.
  */
@@ -105,6 +117,10 @@ struct element {
 	element *next;
 };
 
+typedef struct mem_shard {
+	alignas(ISC_OS_CACHELINE_SIZE) atomic_int_fast64_t pending;
+} mem_shard_t;
+
 #define MEM_MAGIC	 ISC_MAGIC('M', 'e', 'm', 'C')
 #define VALID_CONTEXT(c) ISC_MAGIC_VALID(c, MEM_MAGIC)
 
@@ -116,6 +132,15 @@ static isc_once_t init_once = ISC_ONCE_INIT;
 static isc_once_t shut_once = ISC_ONCE_INIT;
 static isc_mutex_t contextslock;
 
+/*
+ * jemalloc arenas bound to the loop threads with ISC_MEMFLAG_LOOPARENAS,
+ * indexed by thread ID.  They are never destroyed, as memory allocated
+ * on a loop may outlive it; a loop manager created later reuses them.
+ */
+static isc_mutex_t arenaslock;
+static unsigned int *loop_arenas = NULL;
+static uint32_t nloop_arenas = 0;
+
 struct isc_mem {
 	unsigned int magic;
 	unsigned int flags;
@@ -127,6 +152,7 @@ struct isc_mem {
 	isc_refcount_t references;
 	char name[16];
 	atomic_size_t inuse;
+	mem_shard_t *shards;
 	atomic_bool hi_called;
 	atomic_bool is_overmem;
 	isc_mem_water_t water;
@@ -357,11 +383,34 @@ mem_realloc(isc_mem_t *ctx, void *old_ptr, size_t old_size, size_t new_size,
 		 ? &ctx->stats[STATS_BUCKETS]        \
 		 : &ctx->stats[size / STATS_BUCKET_SIZE])
 
+/*!
+ * Add 'delta' to the shard of the current loop, folding the shard into
+ * the shared counter once enough has accumulated.  Relies on unsigned
+ * wraparound of 'inuse' for negative deltas.
+ */
+static void
+mem_shardstats(isc_mem_t *ctx, int_fast64_t delta) {
+	mem_shard_t *shard = &ctx->shards[isc_tid() % MEM_SHARDS];
+	int_fast64_t pending;
+
+	pending = atomic_fetch_add_relaxed(&shard->pending, delta) + delta;
+
+	if (pending >= MEM_SHARD_BATCH || pending <= -MEM_SHARD_BATCH) {
+		pending = atomic_exchange_relaxed(&shard->pending, 0);
+		atomic_fetch_add_relaxed(&ctx->inuse, (size_t)pending);
+	}
+}
+
 /*!
  * Update internal counters after a memory get.
  */
 static void
 mem_getstats(isc_mem_t *ctx, size_t size) {
+	if (ctx->shards != NULL) {
+		mem_shardstats(ctx, (int_fast64_t)size);
+		return;
+	}
+
 	atomic_fetch_add_relaxed(&ctx->inuse, size);
 }
 
@@ -370,10 +419,43 @@ mem_getstats(isc_mem_t *ctx, size_t size) {
  */
 static void
 mem_putstats(isc_mem_t *ctx, size_t size) {
+	if (ctx->shards != NULL) {
+		mem_shardstats(ctx, -(int_fast64_t)size);
+		return;
+	}
+
 	atomic_size_t s = atomic_fetch_sub_relaxed(&ctx->inuse, size);
 	INSIST(s >= size);
 }
 
+/*!
+ * The memory in use as seen by the hi/lo water checks.  For sharded
+ * contexts the shared counter can briefly go negative when one loop
+ * frees memory that another loop has allocated but not yet folded in.
+ */
+static size_t
+mem_inuse(isc_mem_t *ctx) {
+	ssize_t inuse = (ssize_t)atomic_load_relaxed(&ctx->inuse);
+
+	return (inuse < 0 ? 0 : (size_t)inuse);
+}
+
+/*!
+ * The memory in use including the pending deltas of all shards.
+ */
+static size_t
+mem_inuse_total(isc_mem_t *ctx) {
+	ssize_t inuse = (ssize_t)atomic_load_relaxed(&ctx->inuse);
+
+	if (ctx->shards != NULL) {
+		for (size_t i = 0; i < MEM_SHARDS; i++) {
+			inuse += atomic_load_relaxed(&ctx->shards[i].pending);
+		}
+	}
+
+	return (inuse < 0 ? 0 : (size_t)inuse);
+}
+
 /*
  * Private.
  */
@@ -430,6 +512,7 @@ mem_initialize(void) {
 #endif /* JEMALLOC_API_SUPPORTED */
 
 	isc_mutex_init(&contextslock);
+	isc_mutex_init(&arenaslock);
 	ISC_LIST_INIT(contexts);
 }
 
@@ -442,6 +525,13 @@ static void
 mem_shutdown(void) {
 	isc__mem_checkdestroyed();
 
+	if (loop_arenas != NULL) {
+		sdallocx(loop_arenas, nloop_arenas * sizeof(loop_arenas[0]), 0);
+		loop_arenas = NULL;
+		nloop_arenas = 0;
+	}
+
+	isc_mutex_destroy(&arenaslock);
 	isc_mutex_destroy(&contextslock);
 }
 
@@ -478,6 +568,17 @@ mem_create(isc_mem_t **ctxp, unsigned int debugging, unsigned int flags,
 	atomic_init(&ctx->hi_called, false);
 	atomic_init(&ctx->is_overmem, false);
 
+	if ((flags & ISC_MEMFLAG_SHARDED) != 0) {
+		ctx->shards = mallocx(
+			ISC_CHECKED_MUL(MEM_SHARDS, sizeof(ctx->shards[0])),
+			jemalloc_flags);
+		INSIST(ctx->shards != NULL);
+
+		for (size_t i = 0; i < MEM_SHARDS; i++) {
+			atomic_init(&ctx->shards[i].pending, 0);
+		}
+	}
+
 	ISC_LIST_INIT(ctx->pools);
 
 #if ISC_MEM_TRACKLINES
@@ -546,7 +647,13 @@ destroy(isc_mem_t *ctx) {
 	isc_mutex_destroy(&ctx->lock);
 
 	if (ctx->checkfree) {
-		INSIST(atomic_load(&ctx->inuse) == 0);
+		INSIST(mem_inuse_total(ctx) == 0);
+	}
+
+	if (ctx->shards != NULL) {
+		sdallocx(ctx->shards,
+			 ISC_CHECKED_MUL(MEM_SHARDS, sizeof(ctx->shards[0])),
+			 ctx->jemalloc_flags);
 	}
 	sdallocx(ctx, sizeof(*ctx), ctx->jemalloc_flags);
 
@@ -696,7 +803,7 @@ hi_water(isc_mem_t *ctx) {
 		return (false);
 	}
 
-	inuse = atomic_load_relaxed(&ctx->inuse);
+	inuse = mem_inuse(ctx);
 	if (inuse <= hiwater) {
 		return (false);
 	}
@@ -720,7 +827,7 @@ lo_water(isc_mem_t *ctx) {
 		return (false);
 	}
 
-	inuse = atomic_load_relaxed(&ctx->inuse);
+	inuse = mem_inuse(ctx);
 	if (inuse >= lowater) {
 		return (false);
 	}
@@ -1014,7 +1121,7 @@ size_t
 isc_mem_inuse(isc_mem_t *ctx) {
 	REQUIRE(VALID_CONTEXT(ctx));
 
-	return (atomic_load_relaxed(&ctx->inuse));
+	return (mem_inuse_total(ctx));
 }
 
 void
@@ -1061,7 +1168,7 @@ isc_mem_setwater(isc_mem_t *ctx, isc_mem_water_t water, void *water_arg,
 	atomic_store_release(&ctx->lo_water, lowater);
 
 	if (atomic_load_acquire(&ctx->hi_called) &&
-	    (atomic_load_acquire(&ctx->inuse) < lowater || lowater == 0U))
+	    (mem_inuse(ctx) < lowater || lowater == 0U))
 	{
 		(oldwater)(oldwater_arg, ISC_MEM_LOWATER);
 	}
@@ -1635,6 +1742,44 @@ isc__mem_create_arena(isc_mem_t **mctxp FLARG) {
 #endif /* ISC_MEM_TRACKLINES */
 }
 
+void
+isc__mem_bindloop(uint32_t tid) {
+#ifdef JEMALLOC_API_SUPPORTED
+	unsigned int arena_no;
+	int res;
+
+	if ((isc_mem_defaultflags & ISC_MEMFLAG_LOOPARENAS) == 0) {
+		return;
+	}
+
+	LOCK(&arenaslock);
+	if (loop_arenas == NULL) {
+		nloop_arenas = isc_tid_count();
+		loop_arenas = mallocx(nloop_arenas * sizeof(loop_arenas[0]), 0);
+		INSIST(loop_arenas != NULL);
+		for (uint32_t i = 0; i < nloop_arenas; i++) {
+			loop_arenas[i] = ISC_MEM_ILLEGAL_ARENA;
+		}
+	}
+	INSIST(tid < nloop_arenas);
+	if (loop_arenas[tid] == ISC_MEM_ILLEGAL_ARENA) {
+		RUNTIME_CHECK(mem_jemalloc_arena_create(&loop_arenas[tid]));
+	}
+	arena_no = loop_arenas[tid];
+	UNLOCK(&arenaslock);
+
+	/*
+	 * Bind the thread, and with it the thread's tcache, to the arena,
+	 * and flush whatever the tcache has cached from the old arena.
+	 */
+	res = mallctl("thread.arena", NULL, NULL, &arena_no, sizeof(arena_no));
+	RUNTIME_CHECK(res == 0);
+	(void)mallctl("thread.tcache.flush", NULL, NULL, NULL, 0);
+#else
+	UNUSED(tid);
+#endif /* JEMALLOC_API_SUPPORTED */
+}
+
 #ifdef JEMALLOC_API_SUPPORTED
 static bool
 jemalloc_set_ssize_value(const char *valname, ssize_t newval) {
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <inttypes.h>
 #include <stdio.h>
 
 #include <isc/mem.h>
@@ -32,5 +33,14 @@ isc__mem_checkdestroyed(void);
 void
 isc__mem_initialize(void);
 
+void
+isc__mem_bindloop(uint32_t tid);
+/*%<
+ * Called from the thread running loop 'tid'.  If ISC_MEMFLAG_LOOPARENAS
+ * is set in isc_mem_defaultflags, bind the thread to a jemalloc arena of
+ * its own, so that allocations made on different loops do not contend
+ * on the same arena.  A no-op when jemalloc is not available.
+ */
+
 void
 isc__mem_shutdown(void);
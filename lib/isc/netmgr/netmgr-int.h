@@ -190,6 +190,7 @@ STATIC_ASSERT(ISC_NETMGR_TCP_RECVBUF_SIZE <= ISC_NETMGR_RECVBUF_SIZE,
 #endif
 
 typedef struct isc__nm_uvreq isc__nm_uvreq_t;
+typedef struct isc__nm_uring isc__nm_uring_t;
 
 /*
  * Single network event loop worker.
@@ -207,6 +208,9 @@ typedef struct isc__networker {
 	ISC_LIST(isc_nmsocket_t) active_sockets;
 
 	isc_mempool_t *uvreq_pool;
+
+	/*% io_uring instance, created with the first io_uring socket */
+	isc__nm_uring_t *uring;
 } isc__networker_t;
 
 ISC_REFCOUNT_DECL(isc__networker);
@@ -298,6 +302,12 @@ struct isc__nm_uvreq {
 		uv_connect_t connect;
 		uv_udp_send_t udp_send;
 		uv_fs_t fs;
+#if HAVE_LIBURING
+		struct {
+			struct msghdr msg;
+			struct iovec iov;
+		} uring_send;
+#endif /* HAVE_LIBURING */
 	} uv_req;
 	ISC_LINK(isc__nm_uvreq_t) link;
 	ISC_LINK(isc__nm_uvreq_t) active_link;
@@ -325,6 +335,7 @@ struct isc_nm {
 	atomic_uint_fast32_t maxudp;
 
 	bool load_balance_sockets;
+	bool io_uring;
 
 	/*
 	 * Active connections are being closed and new connections are
@@ -520,6 +531,8 @@ struct isc_nmsocket {
 		bool tcp_nodelay_value;
 		isc_nmsocket_tls_send_req_t *send_req; /*%< Send req to reuse */
 		bool reading;
+		bool ktls_tried; /*%< Kernel TLS has been attempted */
+		bool ktls_tx;	 /*%< The kernel encrypts outgoing data */
 	} tlsstream;
 
 #if HAVE_LIBNGHTTP2
@@ -596,6 +609,9 @@ struct isc_nmsocket {
 
 	bool route_sock;
 
+	/*% UDP listener socket served by the io_uring backend */
+	bool uring;
+
 	/*%
 	 * Socket is closed if it's not active and all the possible
 	 * callbacks were fired, there are no active handles, etc.
@@ -1263,6 +1279,64 @@ isc__nm_udp_read_cb(uv_udp_t *handle, ssize_t nrecv, const uv_buf_t *buf,
 void
 isc__nm_tcp_read_cb(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf);
 
+#if HAVE_LIBURING
+void
+isc__nm_udp_uring_read(isc_nmsocket_t *sock, isc_result_t result, char *base,
+		       size_t len, const struct sockaddr *addr);
+/*%<
+ * Deliver a datagram received by the io_uring backend on the UDP
+ * listener socket 'sock'.  The buffer is only valid for the duration
+ * of the call.
+ */
+
+void
+isc__nm_udp_uring_fallback(isc_nmsocket_t *sock, isc_result_t reason);
+/*%<
+ * Move the UDP listener socket 'sock' from the io_uring backend back
+ * to libuv after its receive could not be rearmed for 'reason'.
+ */
+
+isc_result_t
+isc__nm_uring_udp_start(isc_nmsocket_t *sock);
+/*%<
+ * Start receiving on the bound UDP listener socket 'sock' with
+ * a multishot recvmsg on the worker's io_uring instance, creating
+ * the instance if needed.  On success, 'sock->uring' is set and all
+ * reads and sends on the socket go through io_uring.
+ *
+ * Returns ISC_R_NOTIMPLEMENTED or an error converted from errno when
+ * io_uring cannot be used; the caller falls back to libuv.
+ */
+
+void
+isc__nm_uring_udp_stop(isc_nmsocket_t *sock);
+/*%<
+ * Cancel the multishot receive on 'sock' and submit everything that
+ * is queued for it.  Must be called before the file descriptor is
+ * closed.
+ */
+
+isc_result_t
+isc__nm_uring_udp_send(isc_nmsocket_t *sock, isc__nm_uvreq_t *req,
+		       const struct sockaddr *sa, socklen_t salen);
+/*%<
+ * Queue a sendmsg of 'req->uvbuf' to 'sa' (or the connected peer if
+ * NULL).  Submissions are batched and flushed before the loop polls
+ * for events; the send callback runs when the completion is reaped.
+ *
+ * Returns ISC_R_NORESOURCES when the submission queue is full and
+ * ISC_R_UNEXPECTED while submissions are failing; the request is
+ * left untouched and the caller sends it through libuv instead.
+ */
+
+void
+isc__nm_uring_teardown(isc__networker_t *worker);
+/*%<
+ * Cancel all outstanding operations on the worker's io_uring instance
+ * and release it once they have completed.
+ */
+#endif /* HAVE_LIBURING */
+
 isc_result_t
 isc__nm_start_reading(isc_nmsocket_t *sock);
 void
@@ -122,6 +122,10 @@ networker_teardown(void *arg) {
 
 	uv_walk(&loop->loop, shutdown_walk_cb, NULL);
 
+#if HAVE_LIBURING
+	isc__nm_uring_teardown(worker);
+#endif /* HAVE_LIBURING */
+
 	isc__networker_detach(&worker);
 }
 
@@ -363,6 +367,22 @@ isc_nm_setloadbalancesockets(isc_nm_t *mgr, ISC_ATTR_UNUSED bool enabled) {
 #endif
 }
 
+bool
+isc_nm_getiouring(isc_nm_t *mgr) {
+	REQUIRE(VALID_NM(mgr));
+
+	return (mgr->io_uring);
+}
+
+void
+isc_nm_setiouring(isc_nm_t *mgr, ISC_ATTR_UNUSED bool enabled) {
+	REQUIRE(VALID_NM(mgr));
+
+#if HAVE_LIBURING
+	mgr->io_uring = enabled;
+#endif
+}
+
 void
 isc_nm_gettimeouts(isc_nm_t *mgr, uint32_t *initial, uint32_t *idle,
 		   uint32_t *keepalive, uint32_t *advertised) {
@@ -136,6 +136,9 @@ tls_try_shutdown(isc_tls_t *tls, const bool quite);
 static void
 tls_try_to_enable_tcp_nodelay(isc_nmsocket_t *tlssock);
 
+static int
+tls_send_ktls_close(isc_nmsocket_t *sock);
+
 /*
  * The socket is closing, outerhandle has been detached, listener is
  * inactive, or the netmgr is closing: any operation on it should abort
@@ -161,17 +164,14 @@ tls_call_connect_cb(isc_nmsocket_t *sock, isc_nmhandle_t *handle,
 }
 
 static void
-tls_senddone(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
-	isc_nmsocket_tls_send_req_t *send_req =
-		(isc_nmsocket_tls_send_req_t *)cbarg;
+tls_send_req_done(isc_nmsocket_tls_send_req_t *send_req,
+		  isc_result_t eresult) {
 	isc_nmsocket_t *tlssock = NULL;
 	bool finish = send_req->finish;
 	isc_nm_cb_t send_cb = NULL;
 	void *send_cbarg = NULL;
 	isc_nmhandle_t *send_handle = NULL;
 
-	REQUIRE(VALID_NMHANDLE(handle));
-	REQUIRE(VALID_NMSOCK(handle->sock));
 	REQUIRE(VALID_NMSOCK(send_req->tlssock));
 
 	tlssock = send_req->tlssock;
@@ -205,14 +205,14 @@ tls_senddone(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
 			isc_buffer_init(&send_req->data, send_req->smallbuf,
 					sizeof(send_req->smallbuf));
 			isc_buffer_setmctx(&send_req->data,
-					   handle->sock->worker->mctx);
+					   tlssock->worker->mctx);
 		} else {
 			isc_buffer_clear(&send_req->data);
 		}
 	} else {
 		isc_buffer_clearmctx(&send_req->data);
 		isc_buffer_invalidate(&send_req->data);
-		isc_mem_put(handle->sock->worker->mctx, send_req,
+		isc_mem_put(tlssock->worker->mctx, send_req,
 			    sizeof(*send_req));
 	}
 	tlssock->tlsstream.nsending--;
@@ -256,6 +256,14 @@ tls_senddone(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
 	isc__nmsocket_detach(&tlssock);
 }
 
+static void
+tls_senddone(isc_nmhandle_t *handle, isc_result_t eresult, void *cbarg) {
+	REQUIRE(VALID_NMHANDLE(handle));
+	REQUIRE(VALID_NMSOCK(handle->sock));
+
+	tls_send_req_done((isc_nmsocket_tls_send_req_t *)cbarg, eresult);
+}
+
 static void
 tls_failed_read_cb(isc_nmsocket_t *sock, isc_result_t result) {
 	REQUIRE(VALID_NMSOCK(sock));
@@ -346,33 +354,11 @@ async_tls_do_bio(isc_nmsocket_t *sock) {
 	isc_async_run(sock->worker->loop, tls_do_bio_cb, sock);
 }
 
-static int
-tls_send_outgoing(isc_nmsocket_t *sock, bool finish, isc_nmhandle_t *tlshandle,
-		  isc_nm_cb_t cb, void *cbarg) {
+static isc_nmsocket_tls_send_req_t *
+tls_get_send_req(isc_nmsocket_t *sock, bool finish, isc_nmhandle_t *tlshandle,
+		 isc_nm_cb_t cb, void *cbarg) {
 	isc_nmsocket_tls_send_req_t *send_req = NULL;
-	int pending;
-	int rv;
-	size_t len = 0;
 	bool new_send_req = false;
-	isc_region_t used_region = { 0 };
-
-	if (inactive(sock)) {
-		if (cb != NULL) {
-			INSIST(VALID_NMHANDLE(tlshandle));
-			cb(tlshandle, ISC_R_CANCELED, cbarg);
-		}
-		return (0);
-	}
-
-	if (finish) {
-		tls_try_shutdown(sock->tlsstream.tls, false);
-		tls_keep_client_tls_session(sock);
-	}
-
-	pending = BIO_pending(sock->tlsstream.bio_out);
-	if (pending <= 0) {
-		return (pending);
-	}
 
 	/* Try to reuse previously allocated object */
 	if (sock->tlsstream.send_req != NULL) {
@@ -399,6 +385,65 @@ tls_send_outgoing(isc_nmsocket_t *sock, bool finish, isc_nmhandle_t *tlshandle,
 		isc_nmhandle_attach(tlshandle, &send_req->handle);
 	}
 
+	return (send_req);
+}
+
+static int
+tls_send_outgoing(isc_nmsocket_t *sock, bool finish, isc_nmhandle_t *tlshandle,
+		  isc_nm_cb_t cb, void *cbarg) {
+	isc_nmsocket_tls_send_req_t *send_req = NULL;
+	int pending;
+	int rv;
+	size_t len = 0;
+	isc_region_t used_region = { 0 };
+	bool ktls_close = false;
+
+	if (inactive(sock)) {
+		if (cb != NULL) {
+			INSIST(VALID_NMHANDLE(tlshandle));
+			cb(tlshandle, ISC_R_CANCELED, cbarg);
+		}
+		return (0);
+	}
+
+	if (finish) {
+		/*
+		 * With kernel TLS the close_notify alert has to be written
+		 * by the kernel, see tls_send_ktls_close().
+		 */
+		ktls_close = sock->tlsstream.ktls_tx &&
+			     (SSL_get_shutdown(sock->tlsstream.tls) &
+			      SSL_SENT_SHUTDOWN) == 0;
+		tls_try_shutdown(sock->tlsstream.tls, sock->tlsstream.ktls_tx);
+		tls_keep_client_tls_session(sock);
+	}
+
+	pending = BIO_pending(sock->tlsstream.bio_out);
+
+	if (sock->tlsstream.ktls_tx) {
+		if (pending > 0) {
+			/*
+			 * OpenSSL has produced a record after the kernel took
+			 * over the sending keys, e.g. an alert or the reply to
+			 * a KeyUpdate.  It has been encrypted with the wrong
+			 * record sequence number and the kernel can't switch
+			 * to updated keys, so the connection can't go on.
+			 */
+			(void)BIO_reset(sock->tlsstream.bio_out);
+			return (-1);
+		}
+		if (ktls_close) {
+			return (tls_send_ktls_close(sock));
+		}
+		return (0);
+	}
+
+	if (pending <= 0) {
+		return (pending);
+	}
+
+	send_req = tls_get_send_req(sock, finish, tlshandle, cb, cbarg);
+
 	RUNTIME_CHECK(isc_buffer_reserve(&send_req->data, pending) ==
 		      ISC_R_SUCCESS);
 	isc_buffer_add(&send_req->data, pending);
@@ -512,6 +557,113 @@ tls_try_to_close_unused_socket(isc_nmsocket_t *sock) {
 	return (false);
 }
 
+/*
+ * Called before application data is written after the handshake, until
+ * the kernel has been asked to take over.  The kernel takes over only if
+ * everything OpenSSL has written so far has already reached the socket,
+ * as it would otherwise encrypt those records a second time; while the
+ * handshake or the session tickets are still being sent, this is tried
+ * again on the next send.
+ */
+static void
+tls_try_enable_ktls(isc_nmsocket_t *sock) {
+	isc_nmsocket_t *tcpsock = sock->outerhandle->sock;
+	uv_os_fd_t fd;
+	isc_result_t result;
+
+	if (tcpsock->type != isc_nm_tcpsocket ||
+	    uv_fileno((uv_handle_t *)&tcpsock->uv_handle.tcp, &fd) != 0)
+	{
+		sock->tlsstream.ktls_tried = true;
+		return;
+	}
+
+	if (sock->tlsstream.nsending != 0 ||
+	    BIO_pending(sock->tlsstream.bio_out) != 0)
+	{
+		return;
+	}
+
+	sock->tlsstream.ktls_tried = true;
+	result = isc_tls_ktls_enable_tx(sock->tlsstream.tls, (int)fd);
+	switch (result) {
+	case ISC_R_SUCCESS:
+		sock->tlsstream.ktls_tx = true;
+		break;
+	case ISC_R_NOTFOUND:
+		/* Not enabled for this TLS context */
+		break;
+	default:
+		isc__nmsocket_log(sock, ISC_LOG_DEBUG(1),
+				  "kernel TLS unavailable, using OpenSSL: %s",
+				  isc_result_totext(result));
+		break;
+	}
+}
+
+static void
+tls_ktls_closedone(void *arg) {
+	tls_send_req_done(arg, ISC_R_SUCCESS);
+}
+
+/*
+ * With kernel TLS the close_notify alert has to be written by the
+ * kernel as well, which can only be done directly on the TCP socket.
+ * It is sent when nothing else is queued, and the connection is then
+ * wrapped up as after any final send.  Otherwise the connection is
+ * closed without it once the pending sends have completed.
+ */
+static int
+tls_send_ktls_close(isc_nmsocket_t *sock) {
+	isc_nmsocket_t *tcpsock = sock->outerhandle->sock;
+	isc_nmsocket_tls_send_req_t *send_req = NULL;
+	uv_os_fd_t fd;
+	isc_result_t result;
+
+	if (sock->tlsstream.nsending != 0 ||
+	    uv_fileno((uv_handle_t *)&tcpsock->uv_handle.tcp, &fd) != 0)
+	{
+		return (0);
+	}
+
+	result = isc_tls_ktls_close_notify((int)fd);
+	if (result != ISC_R_SUCCESS) {
+		isc__nmsocket_log(sock, ISC_LOG_DEBUG(1),
+				  "sending close_notify failed: %s",
+				  isc_result_totext(result));
+	}
+
+	send_req = tls_get_send_req(sock, true, NULL, NULL, NULL);
+	sock->tlsstream.nsending++;
+	isc_async_run(sock->worker->loop, tls_ktls_closedone, send_req);
+
+	return (1);
+}
+
+/*
+ * With kernel TLS the plaintext goes straight to the TCP socket.
+ */
+static void
+tls_send_ktls(isc_nmsocket_t *sock, isc__nm_uvreq_t *send_data) {
+	isc_nmsocket_tls_send_req_t *send_req = NULL;
+	isc_region_t used_region = { 0 };
+
+	send_req = tls_get_send_req(sock, false, send_data->handle,
+				    send_data->cb.send, send_data->cbarg);
+
+	if (*(uint16_t *)send_data->tcplen != 0) {
+		isc_buffer_putmem(&send_req->data,
+				  (uint8_t *)send_data->tcplen,
+				  sizeof(send_data->tcplen));
+	}
+	isc_buffer_putmem(&send_req->data, (uint8_t *)send_data->uvbuf.base,
+			  send_data->uvbuf.len);
+
+	sock->tlsstream.nsending++;
+	isc_buffer_remainingregion(&send_req->data, &used_region);
+	isc_nm_send(sock->outerhandle, &used_region, tls_senddone, send_req);
+}
+
 static void
 tls_do_bio(isc_nmsocket_t *sock, isc_region_t *received_data,
 	   isc__nm_uvreq_t *send_data, bool finish) {
@@ -604,6 +756,13 @@ tls_do_bio(isc_nmsocket_t *sock, isc_region_t *received_data,
 				((SSL_get_shutdown(sock->tlsstream.tls) &
 				  SSL_SENT_SHUTDOWN) != 0);
 			bool write_failed = false;
+			if (!sock->tlsstream.ktls_tried) {
+				tls_try_enable_ktls(sock);
+			}
+			if (sock->tlsstream.ktls_tx) {
+				tls_send_ktls(sock, send_data);
+				return;
+			}
 			if (*(uint16_t *)send_data->tcplen != 0) {
 				/*
 				 * There is a DNS message length to write - do
@@ -752,6 +911,10 @@ tls_do_bio(isc_nmsocket_t *sock, isc_region_t *received_data,
 	pending = tls_process_outgoing(sock, finish, send_data);
 	if (pending > 0 && tls_status != SSL_ERROR_SSL) {
 		return;
+	} else if (pending < 0) {
+		/* See tls_send_outgoing() */
+		result = ISC_R_TLSERROR;
+		goto error;
 	}
 
 	switch (tls_status) {
@@ -19,6 +19,7 @@
 #include <isc/buffer.h>
 #include <isc/condition.h>
 #include <isc/errno.h>
+#include <isc/log.h>
 #include <isc/magic.h>
 #include <isc/mem.h>
 #include <isc/netmgr.h>
@@ -160,6 +161,19 @@ start_udp_child_job(void *arg) {
 
 	isc__nm_set_network_buffers(mgr, &sock->uv_handle.handle);
 
+#if HAVE_LIBURING
+	if (mgr->io_uring) {
+		result = isc__nm_uring_udp_start(sock);
+		if (result == ISC_R_SUCCESS) {
+			r = 0;
+			goto done;
+		}
+		isc__nmsocket_log(sock, ISC_LOG_WARNING,
+				  "io_uring unavailable, using libuv: %s",
+				  isc_result_totext(result));
+	}
+#endif /* HAVE_LIBURING */
+
 	r = uv_udp_recv_start(&sock->uv_handle.udp, isc__nm_alloc_cb,
 			      isc__nm_udp_read_cb);
 	if (r != 0) {
@@ -613,6 +627,84 @@ free:
 	isc__nm_free_uvbuf(sock, buf);
 }
 
+#if HAVE_LIBURING
+void
+isc__nm_udp_uring_read(isc_nmsocket_t *sock, isc_result_t result, char *base,
+		       size_t len, const struct sockaddr *addr) {
+	isc__nm_uvreq_t *req = NULL;
+	isc_sockaddr_t sockaddr;
+	uint32_t maxudp;
+
+	REQUIRE(VALID_NMSOCK(sock));
+	REQUIRE(sock->tid == isc_tid());
+	REQUIRE(sock->uring);
+
+	/*
+	 * The same checks as in isc__nm_udp_read_cb(), except that the
+	 * buffer is owned by the io_uring backend.
+	 */
+	if (result != ISC_R_SUCCESS) {
+		isc__nm_failed_read_cb(sock, result, false);
+		return;
+	}
+
+	maxudp = atomic_load_relaxed(&sock->worker->netmgr->maxudp);
+	if (maxudp != 0 && len > maxudp) {
+		return;
+	}
+
+	if (isc__nm_closing(sock->worker)) {
+		isc__nm_failed_read_cb(sock, ISC_R_SHUTTINGDOWN, false);
+		return;
+	}
+
+	if (!isc__nmsocket_active(sock)) {
+		isc__nm_failed_read_cb(sock, ISC_R_CANCELED, false);
+		return;
+	}
+
+	if (isc_sockaddr_fromsockaddr(&sockaddr, addr) != ISC_R_SUCCESS) {
+		return;
+	}
+
+	req = isc__nm_get_read_req(sock, &sockaddr);
+	req->uvbuf.base = base;
+	req->uvbuf.len = len;
+
+	sock->reading = false;
+
+	REQUIRE(!sock->processing);
+	sock->processing = true;
+	isc__nm_readcb(sock, req, ISC_R_SUCCESS, false);
+	sock->processing = false;
+}
+
+void
+isc__nm_udp_uring_fallback(isc_nmsocket_t *sock, isc_result_t reason) {
+	int r;
+
+	REQUIRE(VALID_NMSOCK(sock));
+	REQUIRE(sock->tid == isc_tid());
+	REQUIRE(sock->uring);
+
+	isc__nmsocket_log(sock, ISC_LOG_WARNING,
+			  "io_uring receive could not be rearmed, "
+			  "using libuv: %s",
+			  isc_result_totext(reason));
+
+	sock->uring = false;
+
+	r = uv_udp_recv_start(&sock->uv_handle.udp, isc__nm_alloc_cb,
+			      isc__nm_udp_read_cb);
+	if (r != 0) {
+		isc__nm_incstats(sock, STATID_RECVFAIL);
+		isc__nmsocket_log(sock, ISC_LOG_ERROR,
+				  "uv_udp_recv_start() failed: %s",
+				  isc_result_totext(isc_uverr2result(r)));
+	}
+}
+#endif /* HAVE_LIBURING */
+
 static void
 udp_send_cb(uv_udp_send_t *req, int status) {
 	isc_result_t result = ISC_R_SUCCESS;
@@ -693,6 +785,16 @@ isc__nm_udp_send(isc_nmhandle_t *handle, const isc_region_t *region,
 		goto fail;
 	}
 
+#if HAVE_LIBURING
+	if (sock->uring &&
+	    isc__nm_uring_udp_send(sock, uvreq, sa,
+				   sa != NULL ? peer->length : 0) ==
+		    ISC_R_SUCCESS)
+	{
+		return;
+	}
+#endif /* HAVE_LIBURING */
+
 	r = uv_udp_send(&uvreq->uv_req.udp_send, &sock->uv_handle.udp,
 			&uvreq->uvbuf, 1, sa, udp_send_cb);
 	if (r < 0) {
@@ -964,6 +1066,11 @@ isc__nm_udp_close(isc_nmsocket_t *sock) {
 	/* 2. close the listening socket */
 	isc__nmsocket_clearcb(sock);
 	isc__nm_stop_reading(sock);
+#if HAVE_LIBURING
+	if (sock->uring) {
+		isc__nm_uring_udp_stop(sock);
+	}
+#endif /* HAVE_LIBURING */
 	uv_close(&sock->uv_handle.handle, udp_close_cb);
 
 	/* 1. close the read timer */
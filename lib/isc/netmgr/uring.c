@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * io_uring backend for UDP listener sockets.
+ *
+ * Every network worker that has at least one io_uring socket owns a
+ * single ring.  Datagrams are received with one multishot recvmsg per
+ * socket into buffers picked by the kernel from a provided buffer ring
+ * shared by all the sockets of the worker, so an idle socket costs no
+ * buffer and a busy loop reaps many datagrams per wakeup without a
+ * system call per packet.  Sends are queued as sendmsg requests and
+ * submitted in one batch right before the loop polls for events.
+ *
+ * The ring is driven from the libuv loop: the ring file descriptor is
+ * polled for completions and a prepare handle flushes the submission
+ * queue.  Sockets are still bound and closed through their uv_udp_t
+ * handles, so nothing outside of the netmgr sees a difference.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <liburing.h>
+#include <sys/socket.h>
+
+#include <isc/errno.h>
+#include <isc/log.h>
+#include <isc/mem.h>
+#include <isc/netmgr.h>
+#include <isc/result.h>
+#include <isc/util.h>
+#include <isc/uv.h>
+
+#include "../loop_p.h"
+#include "netmgr-int.h"
+
+/*
+ * Submission queue size; the completion queue is twice as big.
+ */
+#define URING_ENTRIES 1024
+
+/*
+ * Provided receive buffers per worker, and the size of each: the
+ * recvmsg header and the peer address followed by the payload.
+ * Datagrams that don't fit are dropped and counted as receive
+ * failures, which only affects queries larger than 4096 octets;
+ * sizing every buffer for the largest possible datagram would cost
+ * 16 MB per worker.
+ */
+#define URING_NBUFS   256
+#define URING_BGID    0
+#define URING_PAYLOAD 4096
+#define URING_BUFSIZE                                                \
+	(sizeof(struct io_uring_recvmsg_out) + sizeof(struct sockaddr_in6) + \
+	 URING_PAYLOAD)
+
+#define URING_REAP_BATCH 64
+
+/*
+ * The operation is stored in the low bits of the (aligned) socket or
+ * request pointer kept in the submission's user data.
+ */
+#define URING_OP_SEND	0
+#define URING_OP_RECV	1
+#define URING_OP_CANCEL 2
+#define URING_OP_MASK	3
+
+struct isc__nm_uring {
+	struct io_uring ring;
+	struct io_uring_buf_ring *br;
+	uint8_t *bufs;
+	struct msghdr recvmsg;
+	uv_poll_t poll;
+	uv_prepare_t prepare;
+	isc__networker_t *worker;
+	unsigned int inflight;
+	unsigned int unsubmitted;
+	uint64_t dropped;
+	bool failing;
+	bool closing;
+};
+
+static void
+uring_poll_cb(uv_poll_t *handle, int status, int events);
+static void
+uring_prepare_cb(uv_prepare_t *handle);
+
+/*
+ * Flush the submission queue.  A failed io_uring_enter() leaves the
+ * queued entries in the ring, where the next successful one picks
+ * them up, so errors are retried on the next loop iteration.  EBUSY
+ * and EAGAIN only mean the completion queue has to be reaped first;
+ * on any other error no new work is queued until a submission goes
+ * through again, so sends and rearmed receives use libuv meanwhile.
+ */
+static void
+uring_submit(isc__nm_uring_t *uring) {
+	int r;
+
+	if (uring->unsubmitted == 0) {
+		return;
+	}
+
+	r = io_uring_submit(&uring->ring);
+	if (r < 0) {
+		if (r != -EBUSY && r != -EAGAIN && r != -EINTR &&
+		    !uring->failing)
+		{
+			isc__netmgr_log(
+				uring->worker->netmgr, ISC_LOG_ERROR,
+				"io_uring_submit() failed: %s, using libuv "
+				"until it succeeds",
+				isc_result_totext(isc_errno_toresult(-r)));
+			uring->failing = true;
+		}
+		return;
+	}
+
+	if (uring->failing) {
+		isc__netmgr_log(uring->worker->netmgr, ISC_LOG_NOTICE,
+				"io_uring_submit() succeeded again");
+		uring->failing = false;
+	}
+	uring->unsubmitted = 0;
+}
+
+static struct io_uring_sqe *
+uring_get_sqe(isc__nm_uring_t *uring) {
+	struct io_uring_sqe *sqe = io_uring_get_sqe(&uring->ring);
+
+	if (sqe == NULL) {
+		/* The submission queue is full, flush it */
+		uring_submit(uring);
+		sqe = io_uring_get_sqe(&uring->ring);
+	}
+
+	if (sqe != NULL) {
+		uring->unsubmitted++;
+	}
+
+	return (sqe);
+}
+
+static isc__nm_uring_t *
+uring_get(isc__networker_t *worker) {
+	isc__nm_uring_t *uring = NULL;
+	isc_loop_t *loop = worker->loop;
+	int r, mask;
+
+	if (worker->uring != NULL) {
+		return (worker->uring);
+	}
+
+	uring = isc_mem_get(worker->mctx, sizeof(*uring));
+	*uring = (isc__nm_uring_t){
+		.recvmsg.msg_namelen = sizeof(struct sockaddr_in6),
+	};
+
+	r = io_uring_queue_init(URING_ENTRIES, &uring->ring, 0);
+	if (r < 0) {
+		isc__netmgr_log(worker->netmgr, ISC_LOG_WARNING,
+				"io_uring_queue_init() failed: %s",
+				isc_result_totext(isc_errno_toresult(-r)));
+		isc_mem_put(worker->mctx, uring, sizeof(*uring));
+		return (NULL);
+	}
+
+	uring->br = io_uring_setup_buf_ring(&uring->ring, URING_NBUFS,
+					    URING_BGID, 0, &r);
+	if (uring->br == NULL) {
+		isc__netmgr_log(worker->netmgr, ISC_LOG_WARNING,
+				"io_uring_setup_buf_ring() failed: %s",
+				isc_result_totext(isc_errno_toresult(-r)));
+		io_uring_queue_exit(&uring->ring);
+		isc_mem_put(worker->mctx, uring, sizeof(*uring));
+		return (NULL);
+	}
+
+	uring->bufs = isc_mem_get(worker->mctx, URING_NBUFS * URING_BUFSIZE);
+	mask = io_uring_buf_ring_mask(URING_NBUFS);
+	for (unsigned int i = 0; i < URING_NBUFS; i++) {
+		io_uring_buf_ring_add(uring->br, uring->bufs + i * URING_BUFSIZE,
+				      URING_BUFSIZE, i, mask, i);
+	}
+	io_uring_buf_ring_advance(uring->br, URING_NBUFS);
+
+	r = uv_poll_init(&loop->loop, &uring->poll, uring->ring.ring_fd);
+	UV_RUNTIME_CHECK(uv_poll_init, r);
+	uv_handle_set_data((uv_handle_t *)&uring->poll, uring);
+	r = uv_poll_start(&uring->poll, UV_READABLE, uring_poll_cb);
+	UV_RUNTIME_CHECK(uv_poll_start, r);
+
+	r = uv_prepare_init(&loop->loop, &uring->prepare);
+	UV_RUNTIME_CHECK(uv_prepare_init, r);
+	uv_handle_set_data((uv_handle_t *)&uring->prepare, uring);
+	r = uv_prepare_start(&uring->prepare, uring_prepare_cb);
+	UV_RUNTIME_CHECK(uv_prepare_start, r);
+
+	isc__networker_attach(worker, &uring->worker);
+	worker->uring = uring;
+
+	return (uring);
+}
+
+static void
+uring_close_cb(uv_handle_t *handle) {
+	isc__nm_uring_t *uring = uv_handle_get_data(handle);
+	isc__networker_t *worker = uring->worker;
+
+	io_uring_free_buf_ring(&uring->ring, uring->br, URING_NBUFS,
+			       URING_BGID);
+	io_uring_queue_exit(&uring->ring);
+
+	isc_mem_put(worker->mctx, uring->bufs, URING_NBUFS * URING_BUFSIZE);
+	isc_mem_put(worker->mctx, uring, sizeof(*uring));
+
+	isc__networker_detach(&worker);
+}
+
+static void
+uring_maybe_close(isc__nm_uring_t *uring) {
+	if (!uring->closing || uring->inflight > 0) {
+		return;
+	}
+
+	if (uv_is_closing((uv_handle_t *)&uring->prepare)) {
+		return;
+	}
+
+	uring->worker->uring = NULL;
+
+	uv_close((uv_handle_t *)&uring->poll, NULL);
+	uv_close((uv_handle_t *)&uring->prepare, uring_close_cb);
+}
+
+static isc_result_t
+uring_arm_recv(isc__nm_uring_t *uring, isc_nmsocket_t *sock) {
+	struct io_uring_sqe *sqe = NULL;
+
+	if (uring->failing) {
+		return (ISC_R_UNEXPECTED);
+	}
+
+	sqe = uring_get_sqe(uring);
+	if (sqe == NULL) {
+		return (ISC_R_NORESOURCES);
+	}
+
+	io_uring_prep_recvmsg_multishot(sqe, sock->fd, &uring->recvmsg, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BGID;
+	io_uring_sqe_set_data64(sqe, (uintptr_t)sock | URING_OP_RECV);
+
+	uring->inflight++;
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+uring_recv_drop(isc__nm_uring_t *uring, isc_nmsocket_t *sock) {
+	isc__nm_incstats(sock, STATID_RECVFAIL);
+
+	/* Log the first drop and then progressively less often */
+	uring->dropped++;
+	if ((uring->dropped & (uring->dropped - 1)) == 0) {
+		isc__nmsocket_log(sock, ISC_LOG_NOTICE,
+				  "io_uring dropped %" PRIu64
+				  " datagram(s) larger than %u octets",
+				  uring->dropped, URING_PAYLOAD);
+	}
+}
+
+static void
+uring_recv_done(isc__nm_uring_t *uring, isc_nmsocket_t *sock,
+		struct io_uring_cqe *cqe) {
+	REQUIRE(VALID_NMSOCK(sock));
+	REQUIRE(sock->tid == isc_tid());
+
+	if (cqe->res >= 0 && (cqe->flags & IORING_CQE_F_BUFFER) != 0) {
+		unsigned int bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+		uint8_t *buf = uring->bufs + bid * URING_BUFSIZE;
+		struct io_uring_recvmsg_out *out = NULL;
+
+		INSIST(bid < URING_NBUFS);
+
+		out = io_uring_recvmsg_validate(buf, cqe->res, &uring->recvmsg);
+		if (out == NULL || (out->flags & MSG_TRUNC) != 0) {
+			uring_recv_drop(uring, sock);
+		} else {
+			isc__nm_udp_uring_read(
+				sock, ISC_R_SUCCESS,
+				io_uring_recvmsg_payload(out, &uring->recvmsg),
+				io_uring_recvmsg_payload_length(
+					out, cqe->res, &uring->recvmsg),
+				io_uring_recvmsg_name(out));
+		}
+
+		/* The datagram has been consumed, recycle the buffer */
+		io_uring_buf_ring_add(uring->br, buf, URING_BUFSIZE, bid,
+				      io_uring_buf_ring_mask(URING_NBUFS), 0);
+		io_uring_buf_ring_advance(uring->br, 1);
+	} else if (cqe->res < 0 && cqe->res != -ENOBUFS &&
+		   cqe->res != -ECANCELED)
+	{
+		isc__nm_udp_uring_read(sock, isc_errno_toresult(-cqe->res),
+				       NULL, 0, NULL);
+	}
+
+	if ((cqe->flags & IORING_CQE_F_MORE) != 0) {
+		return;
+	}
+
+	/*
+	 * The multishot receive has terminated, either because it was
+	 * canceled or because the buffer ring ran dry; rearm it unless
+	 * the socket is going away, and hand the socket over to libuv
+	 * if that is not possible.
+	 */
+	uring->inflight--;
+	if (!uring->closing && !sock->closing) {
+		isc_result_t result = uring_arm_recv(uring, sock);
+		if (result == ISC_R_SUCCESS) {
+			return;
+		}
+		isc__nm_udp_uring_fallback(sock, result);
+	}
+
+	isc__nmsocket_detach(&sock);
+}
+
+static void
+uring_send_done(isc__nm_uvreq_t *req, struct io_uring_cqe *cqe) {
+	isc_nmsocket_t *sock = req->sock;
+
+	REQUIRE(VALID_UVREQ(req));
+	REQUIRE(VALID_NMSOCK(sock));
+	REQUIRE(sock->tid == isc_tid());
+
+	if (cqe->res < 0) {
+		isc__nm_incstats(sock, STATID_SENDFAIL);
+		isc__nm_failed_send_cb(sock, req,
+				       isc_errno_toresult(-cqe->res), false);
+		return;
+	}
+
+	isc__nm_sendcb(sock, req, ISC_R_SUCCESS, false);
+}
+
+static void
+uring_reap(isc__nm_uring_t *uring) {
+	struct io_uring_cqe *cqes[URING_REAP_BATCH];
+	unsigned int n;
+
+	while ((n = io_uring_peek_batch_cqe(&uring->ring, cqes,
+					    ARRAY_SIZE(cqes))) > 0)
+	{
+		for (unsigned int i = 0; i < n; i++) {
+			uint64_t data = io_uring_cqe_get_data64(cqes[i]);
+			void *ptr = (void *)(uintptr_t)(data & ~URING_OP_MASK);
+
+			switch (data & URING_OP_MASK) {
+			case URING_OP_RECV:
+				uring_recv_done(uring, ptr, cqes[i]);
+				break;
+			case URING_OP_SEND:
+				uring->inflight--;
+				uring_send_done(ptr, cqes[i]);
+				break;
+			case URING_OP_CANCEL:
+				break;
+			default:
+				UNREACHABLE();
+			}
+		}
+		io_uring_cq_advance(&uring->ring, n);
+	}
+
+	/* Send out the responses produced by the callbacks right away */
+	uring_submit(uring);
+
+	uring_maybe_close(uring);
+}
+
+static void
+uring_poll_cb(uv_poll_t *handle, int status, int events) {
+	isc__nm_uring_t *uring = uv_handle_get_data((uv_handle_t *)handle);
+
+	UNUSED(status);
+	UNUSED(events);
+
+	uring_reap(uring);
+}
+
+static void
+uring_prepare_cb(uv_prepare_t *handle) {
+	isc__nm_uring_t *uring = uv_handle_get_data((uv_handle_t *)handle);
+
+	uring_submit(uring);
+}
+
+isc_result_t
+isc__nm_uring_udp_start(isc_nmsocket_t *sock) {
+	isc__nm_uring_t *uring = NULL;
+	isc_result_t result;
+
+	REQUIRE(VALID_NMSOCK(sock));
+	REQUIRE(sock->type == isc_nm_udpsocket);
+	REQUIRE(sock->tid == isc_tid());
+	REQUIRE(!sock->uring);
+
+	if (isc__nm_closing(sock->worker)) {
+		return (ISC_R_SHUTTINGDOWN);
+	}
+
+	uring = uring_get(sock->worker);
+	if (uring == NULL) {
+		return (ISC_R_NOTIMPLEMENTED);
+	}
+
+	result = uring_arm_recv(uring, sock);
+	if (result != ISC_R_SUCCESS) {
+		return (result);
+	}
+
+	/* Detached when the multishot receive terminates */
+	isc__nmsocket_attach(sock, &(isc_nmsocket_t *){ NULL });
+	sock->uring = true;
+
+	uring_submit(uring);
+
+	return (ISC_R_SUCCESS);
+}
+
+void
+isc__nm_uring_udp_stop(isc_nmsocket_t *sock) {
+	isc__nm_uring_t *uring = NULL;
+	struct io_uring_sqe *sqe = NULL;
+
+	REQUIRE(VALID_NMSOCK(sock));
+	REQUIRE(sock->tid == isc_tid());
+	REQUIRE(sock->uring);
+
+	uring = sock->worker->uring;
+	INSIST(uring != NULL);
+
+	sqe = uring_get_sqe(uring);
+	if (sqe != NULL) {
+		io_uring_prep_cancel64(sqe, (uintptr_t)sock | URING_OP_RECV, 0);
+		io_uring_sqe_set_data64(sqe, URING_OP_CANCEL);
+	}
+
+	/*
+	 * The queued operations refer to the socket by its descriptor,
+	 * which is about to be closed.
+	 */
+	uring_submit(uring);
+}
+
+isc_result_t
+isc__nm_uring_udp_send(isc_nmsocket_t *sock, isc__nm_uvreq_t *req,
+		       const struct sockaddr *sa, socklen_t salen) {
+	isc__nm_uring_t *uring = NULL;
+	struct io_uring_sqe *sqe = NULL;
+
+	REQUIRE(VALID_NMSOCK(sock));
+	REQUIRE(VALID_UVREQ(req));
+	REQUIRE(sock->tid == isc_tid());
+	REQUIRE(sock->uring);
+
+	uring = sock->worker->uring;
+	INSIST(uring != NULL);
+
+	if (uring->failing) {
+		return (ISC_R_UNEXPECTED);
+	}
+
+	sqe = uring_get_sqe(uring);
+	if (sqe == NULL) {
+		return (ISC_R_NORESOURCES);
+	}
+
+	req->uv_req.uring_send.iov = (struct iovec){
+		.iov_base = req->uvbuf.base,
+		.iov_len = req->uvbuf.len,
+	};
+	req->uv_req.uring_send.msg = (struct msghdr){
+		.msg_name = (void *)sa,
+		.msg_namelen = salen,
+		.msg_iov = &req->uv_req.uring_send.iov,
+		.msg_iovlen = 1,
+	};
+
+	io_uring_prep_sendmsg(sqe, sock->fd, &req->uv_req.uring_send.msg, 0);
+	io_uring_sqe_set_data64(sqe, (uintptr_t)req | URING_OP_SEND);
+
+	uring->inflight++;
+
+	return (ISC_R_SUCCESS);
+}
+
+void
+isc__nm_uring_teardown(isc__networker_t *worker) {
+	isc__nm_uring_t *uring = worker->uring;
+	struct io_uring_sqe *sqe = NULL;
+
+	if (uring == NULL) {
+		return;
+	}
+
+	uring->closing = true;
+
+	if (uring->inflight > 0) {
+		sqe = uring_get_sqe(uring);
+		if (sqe != NULL) {
+			io_uring_prep_cancel64(sqe, 0, IORING_ASYNC_CANCEL_ANY);
+			io_uring_sqe_set_data64(sqe, URING_OP_CANCEL);
+		}
+		uring_submit(uring);
+	}
+
+	uring_maybe_close(uring);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*! \file */
+
+#include <isc/simd.h>
+#include <isc/util.h>
+
+#include "simd_p.h"
+
+isc_simd_t isc__simd = isc_simd_none;
+
+static isc_simd_t simd_supported = isc_simd_none;
+
+void
+isc__simd_initialize(void) {
+#if ISC_SIMD_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		simd_supported = isc_simd_avx2;
+	} else if (__builtin_cpu_supports("ssse3")) {
+		simd_supported = isc_simd_ssse3;
+	}
+#endif /* ISC_SIMD_X86 */
+
+	isc__simd = simd_supported;
+}
+
+isc_simd_t
+isc_simd_supported(void) {
+	return (simd_supported);
+}
+
+isc_simd_t
+isc_simd_get(void) {
+	return (isc__simd);
+}
+
+isc_simd_t
+isc_simd_set(isc_simd_t simd) {
+	isc__simd = ISC_MIN(simd, simd_supported);
+	return (isc__simd);
+}
+
+const char *
+isc_simd_totext(isc_simd_t simd) {
+	switch (simd) {
+	case isc_simd_none:
+		return ("scalar");
+	case isc_simd_ssse3:
+		return ("ssse3");
+	case isc_simd_avx2:
+		return ("avx2");
+	default:
+		UNREACHABLE();
+	}
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#pragma once
+
+#include <isc/simd.h>
+
+/*! \file */
+
+/*
+ * The vector implementations are compiled for their instruction set with
+ * the target function attribute, and only called once the CPU has been
+ * found to support it.
+ */
+#if HAVE_BUILTIN_CPU_SUPPORTS && (defined(__x86_64__) || defined(__i386__))
+#define ISC_SIMD_X86 1
+#include <immintrin.h>
+#define ISC_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define ISC_TARGET_AVX2	 __attribute__((target("avx2")))
+#else
+#define ISC_SIMD_X86 0
+#endif
+
+/*%
+ * The instruction set in use.
+ */
+extern isc_simd_t isc__simd;
+
+void
+isc__simd_initialize(void);
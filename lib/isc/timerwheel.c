@@ -0,0 +1,441 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*! \file */
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include <isc/async.h>
+#include <isc/atomic.h>
+#include <isc/loop.h>
+#include <isc/magic.h>
+#include <isc/mem.h>
+#include <isc/refcount.h>
+#include <isc/time.h>
+#include <isc/timer.h>
+#include <isc/timerwheel.h>
+#include <isc/util.h>
+#include <isc/uv.h>
+
+#include "loop_p.h"
+
+#define TIMERWHEEL_MAGIC     ISC_MAGIC('T', 'W', 'h', 'l')
+#define VALID_TIMERWHEEL(tw) ISC_MAGIC_VALID(tw, TIMERWHEEL_MAGIC)
+
+/*
+ * The wheel has a 256 slot first level with one slot per second, and
+ * three more levels of 64 slots each, covering 2^26 seconds (a little over
+ * two years) in total.  Timers are kept in the first level when they
+ * expire within 256 seconds; the timers in the upper levels are moved
+ * ("cascaded") one level down each time the level below has completed a
+ * full turn.
+ */
+#define WHEEL_BITS0  8
+#define WHEEL_BITSN  6
+#define WHEEL_SIZE0  (1 << WHEEL_BITS0)
+#define WHEEL_SIZEN  (1 << WHEEL_BITSN)
+#define WHEEL_MASK0  (WHEEL_SIZE0 - 1)
+#define WHEEL_MASKN  (WHEEL_SIZEN - 1)
+#define WHEEL_LEVELS 3 /* in addition to the first level */
+
+#define LEVEL_SHIFT(n) (WHEEL_BITS0 + (n) * WHEEL_BITSN)
+#define LEVEL_INDEX(t, n) \
+	((size_t)(((t) >> LEVEL_SHIFT(n)) & WHEEL_MASKN))
+
+#define WHEEL_MAXTICKS ((UINT64_C(1) << LEVEL_SHIFT(WHEEL_LEVELS)) - 1)
+#define NOT_ARMED      UINT64_MAX
+
+struct isc_timerwheel {
+	unsigned int magic;
+	isc_mem_t *mctx;
+	isc_loop_t *loop;
+	isc_refcount_t references;
+	isc_timer_t *timer;
+	atomic_bool shuttingdown;
+	bool running;
+
+	/*
+	 * Ticks are whole seconds since 'epoch', which is the loop time
+	 * in milliseconds when the first timer was started.  'current' is
+	 * the next tick to be processed and 'armed' the tick that the
+	 * isc_timer will next fire at.
+	 */
+	uint64_t epoch;
+	uint64_t current;
+	uint64_t armed;
+	size_t count;
+
+	isc_wheelslot_t expired;
+	isc_wheelslot_t firing;
+	isc_wheelslot_t level0[WHEEL_SIZE0];
+	isc_wheelslot_t levels[WHEEL_LEVELS][WHEEL_SIZEN];
+};
+
+static void
+timerwheel_run(void *arg);
+
+void
+isc_timerwheel_create(isc_loop_t *loop, isc_timerwheel_t **wheelp) {
+	isc_timerwheel_t *wheel = NULL;
+	isc_mem_t *mctx = NULL;
+
+	REQUIRE(VALID_LOOP(loop));
+	REQUIRE(wheelp != NULL && *wheelp == NULL);
+
+	mctx = isc_loop_getmctx(loop);
+
+	wheel = isc_mem_get(mctx, sizeof(*wheel));
+	*wheel = (isc_timerwheel_t){
+		.armed = NOT_ARMED,
+		.magic = TIMERWHEEL_MAGIC,
+	};
+	atomic_init(&wheel->shuttingdown, false);
+
+	ISC_LIST_INIT(wheel->expired);
+	ISC_LIST_INIT(wheel->firing);
+	for (size_t i = 0; i < WHEEL_SIZE0; i++) {
+		ISC_LIST_INIT(wheel->level0[i]);
+	}
+	for (size_t n = 0; n < WHEEL_LEVELS; n++) {
+		for (size_t i = 0; i < WHEEL_SIZEN; i++) {
+			ISC_LIST_INIT(wheel->levels[n][i]);
+		}
+	}
+
+	isc_mem_attach(mctx, &wheel->mctx);
+	isc_loop_attach(loop, &wheel->loop);
+	isc_refcount_init(&wheel->references, 1);
+
+	*wheelp = wheel;
+}
+
+static void
+timerwheel_doshutdown(void *arg) {
+	isc_timerwheel_t *wheel = arg;
+
+	REQUIRE(VALID_TIMERWHEEL(wheel));
+
+	if (wheel->timer != NULL) {
+		isc_timer_stop(wheel->timer);
+		isc_timer_destroy(&wheel->timer);
+	}
+	wheel->armed = NOT_ARMED;
+
+	isc_timerwheel_detach(&wheel);
+}
+
+void
+isc_timerwheel_shutdown(isc_timerwheel_t *wheel) {
+	REQUIRE(VALID_TIMERWHEEL(wheel));
+
+	if (atomic_compare_exchange_strong(&wheel->shuttingdown,
+					   &(bool){ false }, true))
+	{
+		isc_timerwheel_ref(wheel);
+		isc_async_run(wheel->loop, timerwheel_doshutdown, wheel);
+	}
+}
+
+size_t
+isc_timerwheel_pending(isc_timerwheel_t *wheel) {
+	REQUIRE(VALID_TIMERWHEEL(wheel));
+	REQUIRE(wheel->loop == isc_loop_current(wheel->loop->loopmgr));
+
+	return (wheel->count);
+}
+
+static void
+timerwheel_destroy(isc_timerwheel_t *wheel) {
+	INSIST(wheel->count == 0);
+	INSIST(wheel->timer == NULL);
+
+	wheel->magic = 0;
+	isc_loop_detach(&wheel->loop);
+	isc_mem_putanddetach(&wheel->mctx, wheel, sizeof(*wheel));
+}
+
+ISC_REFCOUNT_IMPL(isc_timerwheel, timerwheel_destroy);
+
+static uint64_t
+timerwheel_now(isc_timerwheel_t *wheel) {
+	return (uv_now(&wheel->loop->loop) - wheel->epoch);
+}
+
+static void
+timerwheel_insert(isc_timerwheel_t *wheel, isc_wheeltimer_t *timer) {
+	uint64_t delta = timer->expires - wheel->current;
+	isc_wheelslot_t *slot = NULL;
+
+	if (delta < WHEEL_SIZE0) {
+		slot = &wheel->level0[timer->expires & WHEEL_MASK0];
+	} else {
+		size_t n = 0;
+
+		if (delta > WHEEL_MAXTICKS) {
+			timer->expires = wheel->current + WHEEL_MAXTICKS;
+			delta = WHEEL_MAXTICKS;
+		}
+		while (delta >= (UINT64_C(1) << LEVEL_SHIFT(n + 1))) {
+			n++;
+		}
+		slot = &wheel->levels[n][LEVEL_INDEX(timer->expires, n)];
+	}
+
+	ISC_LIST_APPEND(*slot, timer, link);
+	timer->slot = slot;
+}
+
+/*
+ * Move the timers in an upper level slot to the levels below, once
+ * the current tick has reached the start of the range the slot covers.
+ */
+static void
+timerwheel_cascade(isc_timerwheel_t *wheel, isc_wheelslot_t *slot) {
+	isc_wheelslot_t list = ISC_LIST_INITIALIZER;
+
+	ISC_LIST_MOVE(list, *slot);
+	while (!ISC_LIST_EMPTY(list)) {
+		isc_wheeltimer_t *timer = ISC_LIST_HEAD(list);
+		ISC_LIST_UNLINK(list, timer, link);
+		timerwheel_insert(wheel, timer);
+	}
+}
+
+static void
+timerwheel_expire(isc_timerwheel_t *wheel, isc_wheelslot_t *slot) {
+	while (!ISC_LIST_EMPTY(*slot)) {
+		isc_wheeltimer_t *timer = ISC_LIST_HEAD(*slot);
+		ISC_LIST_UNLINK(*slot, timer, link);
+		ISC_LIST_APPEND(wheel->firing, timer, link);
+		timer->slot = &wheel->firing;
+	}
+}
+
+/*
+ * Find the next tick the isc_timer needs to fire at: either the next
+ * non-empty first level slot, or the next cascade.
+ */
+static uint64_t
+timerwheel_next(isc_timerwheel_t *wheel) {
+	uint64_t tick = wheel->current;
+
+	if (!ISC_LIST_EMPTY(wheel->expired)) {
+		return (0);
+	}
+
+	do {
+		if (!ISC_LIST_EMPTY(wheel->level0[tick & WHEEL_MASK0])) {
+			return (tick);
+		}
+		tick++;
+	} while ((tick & WHEEL_MASK0) != 0);
+
+	return (tick);
+}
+
+static void
+timerwheel_arm(isc_timerwheel_t *wheel) {
+	isc_interval_t interval;
+	uint64_t next, now, when;
+
+	if (wheel->count == 0 || atomic_load(&wheel->shuttingdown)) {
+		if (wheel->timer != NULL && wheel->armed != NOT_ARMED) {
+			isc_timer_stop(wheel->timer);
+		}
+		wheel->armed = NOT_ARMED;
+		return;
+	}
+
+	/*
+	 * An isc_timer that fires too early only costs an empty run, so
+	 * leave it alone unless the next timer is due before it fires.
+	 */
+	next = timerwheel_next(wheel);
+	if (wheel->armed <= next) {
+		return;
+	}
+
+	if (wheel->timer == NULL) {
+		isc_timer_create(wheel->loop, timerwheel_run, wheel,
+				 &wheel->timer);
+	}
+
+	now = timerwheel_now(wheel);
+	when = next * MS_PER_SEC;
+	when = (when > now) ? when - now : 0;
+
+	isc_interval_set(&interval, when / MS_PER_SEC,
+			 (when % MS_PER_SEC) * NS_PER_MS);
+	isc_timer_start(wheel->timer, isc_timertype_once, &interval);
+	wheel->armed = next;
+}
+
+static void
+timerwheel_run(void *arg) {
+	isc_timerwheel_t *wheel = arg;
+	uint64_t now;
+
+	REQUIRE(VALID_TIMERWHEEL(wheel));
+
+	wheel->armed = NOT_ARMED;
+	if (atomic_load(&wheel->shuttingdown)) {
+		return;
+	}
+
+	wheel->running = true;
+
+	timerwheel_expire(wheel, &wheel->expired);
+
+	now = timerwheel_now(wheel) / MS_PER_SEC;
+	while (wheel->current <= now) {
+		uint64_t tick = wheel->current;
+
+		if ((tick & WHEEL_MASK0) == 0) {
+			for (size_t n = 0; n < WHEEL_LEVELS; n++) {
+				size_t i = LEVEL_INDEX(tick, n);
+
+				timerwheel_cascade(wheel, &wheel->levels[n][i]);
+				if (i != 0) {
+					break;
+				}
+			}
+		}
+
+		wheel->current++;
+		timerwheel_expire(wheel, &wheel->level0[tick & WHEEL_MASK0]);
+	}
+
+	/*
+	 * The callbacks are free to start or stop any timer, including
+	 * the ones that are still waiting to be called.
+	 */
+	while (!ISC_LIST_EMPTY(wheel->firing)) {
+		isc_wheeltimer_t *timer = ISC_LIST_HEAD(wheel->firing);
+		ISC_LIST_UNLINK(wheel->firing, timer, link);
+		timer->slot = NULL;
+		wheel->count--;
+
+		timer->cb(timer->cbarg);
+	}
+
+	wheel->running = false;
+
+	timerwheel_arm(wheel);
+}
+
+void
+isc_wheeltimer_init(isc_wheeltimer_t *timer, isc_timerwheel_t *wheel,
+		    isc_job_cb cb, void *cbarg) {
+	REQUIRE(timer != NULL && timer->wheel == NULL);
+	REQUIRE(VALID_TIMERWHEEL(wheel));
+	REQUIRE(cb != NULL);
+
+	*timer = (isc_wheeltimer_t){
+		.cb = cb,
+		.cbarg = cbarg,
+		.link = ISC_LINK_INITIALIZER,
+	};
+	isc_timerwheel_attach(wheel, &timer->wheel);
+}
+
+void
+isc_wheeltimer_start(isc_wheeltimer_t *timer, uint32_t seconds) {
+	isc_timerwheel_t *wheel = NULL;
+	uint64_t now;
+
+	REQUIRE(isc_wheeltimer_initialized(timer));
+
+	wheel = timer->wheel;
+	REQUIRE(wheel->loop == isc_loop_current(wheel->loop->loopmgr));
+
+	isc_wheeltimer_stop(timer);
+
+	if (atomic_load(&wheel->shuttingdown)) {
+		return;
+	}
+
+	if (wheel->count == 0 && !wheel->running) {
+		/*
+		 * Nothing is pending, so fast-forward the wheel to the
+		 * current time instead of walking over the empty ticks.
+		 */
+		if (wheel->timer == NULL) {
+			wheel->epoch = uv_now(&wheel->loop->loop);
+		}
+		wheel->current = timerwheel_now(wheel) / MS_PER_SEC + 1;
+	}
+	wheel->count++;
+
+	if (seconds == 0) {
+		ISC_LIST_APPEND(wheel->expired, timer, link);
+		timer->slot = &wheel->expired;
+	} else {
+		/* Round up, so that the timer never expires early */
+		now = timerwheel_now(wheel);
+		timer->expires = (now + MS_PER_SEC - 1) / MS_PER_SEC + seconds;
+		if (timer->expires < wheel->current) {
+			timer->expires = wheel->current;
+		}
+		timerwheel_insert(wheel, timer);
+	}
+
+	if (!wheel->running) {
+		timerwheel_arm(wheel);
+	}
+}
+
+void
+isc_wheeltimer_stop(isc_wheeltimer_t *timer) {
+	isc_timerwheel_t *wheel = NULL;
+
+	REQUIRE(isc_wheeltimer_initialized(timer));
+
+	if (timer->slot == NULL) {
+		return;
+	}
+
+	wheel = timer->wheel;
+	REQUIRE(wheel->loop == isc_loop_current(wheel->loop->loopmgr));
+
+	ISC_LIST_UNLINK(*timer->slot, timer, link);
+	timer->slot = NULL;
+	wheel->count--;
+
+	/* Only stop the isc_timer once the wheel is empty */
+	if (wheel->count == 0 && !wheel->running) {
+		timerwheel_arm(wheel);
+	}
+}
+
+bool
+isc_wheeltimer_initialized(const isc_wheeltimer_t *timer) {
+	REQUIRE(timer != NULL);
+
+	return (timer->wheel != NULL);
+}
+
+bool
+isc_wheeltimer_pending(const isc_wheeltimer_t *timer) {
+	REQUIRE(timer != NULL);
+
+	return (timer->slot != NULL);
+}
+
+void
+isc_wheeltimer_invalidate(isc_wheeltimer_t *timer) {
+	REQUIRE(isc_wheeltimer_initialized(timer));
+
+	isc_wheeltimer_stop(timer);
+	isc_timerwheel_detach(&timer->wheel);
+}
@@ -11,6 +11,7 @@
  * information regarding copyright ownership.
  */
 
+#include <errno.h>
 #include <inttypes.h>
 #include <netinet/in.h>
 #include <stdlib.h>
@@ -20,6 +21,12 @@
 #include <nghttp2/nghttp2.h>
 #endif /* HAVE_LIBNGHTTP2 */
 #include <arpa/inet.h>
+#if HAVE_LINUX_TLS_H && HAVE_SSL_CTX_SET_KEYLOG_CALLBACK
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#define HAVE_KTLS 1
+#endif /* HAVE_LINUX_TLS_H && HAVE_SSL_CTX_SET_KEYLOG_CALLBACK */
 
 #include <openssl/bn.h>
 #include <openssl/conf.h>
@@ -27,6 +34,9 @@
 #include <openssl/dh.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#if HAVE_KTLS
+#include <openssl/kdf.h>
+#endif /* HAVE_KTLS */
 #include <openssl/opensslv.h>
 #include <openssl/rand.h>
 #include <openssl/rsa.h>
@@ -34,6 +44,9 @@
 #include <openssl/x509v3.h>
 
 #include <isc/atomic.h>
+#include <isc/buffer.h>
+#include <isc/errno.h>
+#include <isc/hex.h>
 #include <isc/ht.h>
 #include <isc/log.h>
 #include <isc/magic.h>
@@ -56,6 +69,37 @@
 
 static isc_mem_t *isc__tls_mctx = NULL;
 
+#if HAVE_KTLS
+/*
+ * The traffic secret for our sending direction, captured from the key
+ * logging callback and attached to the SSL object as ex_data so that
+ * it can be handed to the kernel once the handshake is complete,
+ * together with the number of records OpenSSL has written with it.
+ */
+typedef struct ktls_secret {
+	size_t length;
+	unsigned char data[EVP_MAX_MD_SIZE];
+	uint64_t seq;
+	bool stale;
+} ktls_secret_t;
+
+static int ktls_secret_index = -1;
+
+static void
+ktls_secret_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx,
+		 long argl, void *argp) {
+	UNUSED(parent);
+	UNUSED(ad);
+	UNUSED(idx);
+	UNUSED(argl);
+	UNUSED(argp);
+
+	if (ptr != NULL) {
+		OPENSSL_clear_free(ptr, sizeof(ktls_secret_t));
+	}
+}
+#endif /* HAVE_KTLS */
+
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 static isc_mutex_t *locks = NULL;
 static int nlocks;
@@ -204,6 +248,12 @@ isc__tls_initialize(void) {
 				       CONF_MFLAGS_IGNORE_MISSING_FILE);
 #endif
 
+#if HAVE_KTLS
+	ktls_secret_index = SSL_get_ex_new_index(0, NULL, NULL, NULL,
+						 ktls_secret_free);
+	RUNTIME_CHECK(ktls_secret_index >= 0);
+#endif /* HAVE_KTLS */
+
 	/* Protect ourselves against unseeded PRNG */
 	if (RAND_status() != 1) {
 		FATAL_ERROR("OpenSSL pseudorandom number generator "
@@ -294,6 +344,140 @@ sslkeylogfile_init(isc_tlsctx_t *ctx) {
 #define sslkeylogfile_init(ctx)
 #endif /* HAVE_SSL_CTX_SET_KEYLOG_CALLBACK */
 
+#if HAVE_KTLS
+/*
+ * Key logging callback used when kernel TLS is enabled on a context.
+ * TLS 1.3 reports the application traffic secrets as
+ * "<LABEL> <client random> <secret>"; keep the one for the direction
+ * we send in.  Lines are still passed on to SSLKEYLOGFILE if asked to.
+ */
+static void
+ktls_keylog(const SSL *ssl, const char *line) {
+	const char *label = SSL_is_server(ssl) ? "SERVER_TRAFFIC_SECRET_0 "
+					       : "CLIENT_TRAFFIC_SECRET_0 ";
+	const char *hex = NULL;
+	ktls_secret_t *secret = NULL;
+	isc_buffer_t b;
+
+	if (getenv("SSLKEYLOGFILE") != NULL) {
+		sslkeylogfile_append(ssl, line);
+	}
+
+	if (strncmp(line, label, strlen(label)) != 0) {
+		return;
+	}
+
+	hex = strchr(line + strlen(label), ' ');
+	if (hex == NULL) {
+		return;
+	}
+
+	secret = OPENSSL_zalloc(sizeof(*secret));
+	if (secret == NULL) {
+		return;
+	}
+
+	isc_buffer_init(&b, secret->data, sizeof(secret->data));
+	if (isc_hex_decodestring(hex + 1, &b) != ISC_R_SUCCESS) {
+		OPENSSL_clear_free(secret, sizeof(*secret));
+		return;
+	}
+	secret->length = isc_buffer_usedlength(&b);
+
+	ktls_secret_free(NULL, SSL_get_ex_data(ssl, ktls_secret_index), NULL,
+			 0, 0, NULL);
+	if (SSL_set_ex_data(UNCONST(ssl), ktls_secret_index, secret) != 1) {
+		OPENSSL_clear_free(secret, sizeof(*secret));
+	}
+}
+
+/*
+ * Message callback used when kernel TLS is enabled on a context.  The
+ * record layer reports the header of every record it writes, which
+ * gives the sequence number the kernel has to continue from.  Once we
+ * have sent a KeyUpdate the captured secret is no longer the one in
+ * use and the connection cannot be handed over.
+ */
+static void
+ktls_msg(int write_p, int version, int content_type, const void *buf,
+	 size_t len, SSL *ssl, void *arg) {
+	ktls_secret_t *secret = NULL;
+
+	UNUSED(version);
+	UNUSED(arg);
+
+	if (write_p == 0) {
+		return;
+	}
+
+	secret = SSL_get_ex_data(ssl, ktls_secret_index);
+	if (secret == NULL) {
+		return;
+	}
+
+	switch (content_type) {
+	case SSL3_RT_HEADER:
+		secret->seq++;
+		break;
+	case SSL3_RT_HANDSHAKE:
+		if (len > 0 &&
+		    ((const unsigned char *)buf)[0] == SSL3_MT_KEY_UPDATE)
+		{
+			secret->stale = true;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * HKDF-Expand-Label() from RFC 8446, section 7.1, with an empty context.
+ */
+static bool
+ktls_expand_label(const EVP_MD *md, const ktls_secret_t *secret,
+		  const char *label, unsigned char *out, size_t outlen) {
+	unsigned char info[2 + 1 + 255 + 1];
+	size_t infolen = 0, labellen = strlen(label);
+	EVP_PKEY_CTX *pctx = NULL;
+	bool ok;
+
+	INSIST(labellen <= 255 - 6);
+
+	info[infolen++] = (outlen >> 8) & 0xff;
+	info[infolen++] = outlen & 0xff;
+	info[infolen++] = (unsigned char)(6 + labellen);
+	memmove(&info[infolen], "tls13 ", 6);
+	infolen += 6;
+	memmove(&info[infolen], label, labellen);
+	infolen += labellen;
+	info[infolen++] = 0;
+
+	pctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, NULL);
+	ok = (pctx != NULL && EVP_PKEY_derive_init(pctx) == 1 &&
+	      EVP_PKEY_CTX_hkdf_mode(pctx,
+				     EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) == 1 &&
+	      EVP_PKEY_CTX_set_hkdf_md(pctx, md) == 1 &&
+	      EVP_PKEY_CTX_set1_hkdf_key(pctx, secret->data,
+					 (int)secret->length) == 1 &&
+	      EVP_PKEY_CTX_add1_hkdf_info(pctx, info, (int)infolen) == 1 &&
+	      EVP_PKEY_derive(pctx, out, &outlen) == 1);
+	EVP_PKEY_CTX_free(pctx);
+
+	return (ok);
+}
+
+/*
+ * The record protection key and IV for 'secret' (RFC 8446, section 7.3).
+ */
+static bool
+ktls_derive(const EVP_MD *md, const ktls_secret_t *secret, unsigned char *key,
+	    size_t keylen, unsigned char *iv, size_t ivlen) {
+	return (ktls_expand_label(md, secret, "key", key, keylen) &&
+		ktls_expand_label(md, secret, "iv", iv, ivlen));
+}
+#endif /* HAVE_KTLS */
+
 isc_result_t
 isc_tlsctx_createclient(isc_tlsctx_t **ctxp) {
 	unsigned long err;
@@ -847,6 +1031,188 @@ isc_tls_verify_peer_result_string(isc_tls_t *tls) {
 	return (X509_verify_cert_error_string(SSL_get_verify_result(tls)));
 }
 
+void
+isc_tlsctx_enable_ktls(isc_tlsctx_t *ctx) {
+	REQUIRE(ctx != NULL);
+
+#if HAVE_KTLS
+	SSL_CTX_set_keylog_callback(ctx, ktls_keylog);
+	SSL_CTX_set_msg_callback(ctx, ktls_msg);
+#endif /* HAVE_KTLS */
+}
+
+isc_result_t
+isc_tls_ktls_enable_tx(isc_tls_t *tls, int fd) {
+	REQUIRE(tls != NULL);
+	REQUIRE(SSL_is_init_finished(tls) == 1);
+
+#if HAVE_KTLS
+	const ktls_secret_t *secret = SSL_get_ex_data(tls, ktls_secret_index);
+	const SSL_CIPHER *cipher = NULL;
+	const EVP_MD *md = NULL;
+	union {
+		struct tls_crypto_info info;
+		struct tls12_crypto_info_aes_gcm_128 aes128;
+		struct tls12_crypto_info_aes_gcm_256 aes256;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+		struct tls12_crypto_info_chacha20_poly1305 chacha;
+#endif /* TLS_CIPHER_CHACHA20_POLY1305 */
+	} ci;
+	unsigned char key[32], iv[12], rec_seq[8];
+	size_t keylen, cilen;
+	isc_result_t result = ISC_R_SUCCESS;
+
+	if (secret == NULL) {
+		return (ISC_R_NOTFOUND);
+	}
+
+	if (secret->stale) {
+		result = ISC_R_NOTIMPLEMENTED;
+		goto cleanup;
+	}
+
+	/*
+	 * Only TLS 1.3 is handled: it has a single record format for all
+	 * the AEAD ciphers the kernel supports and no renegotiation.
+	 */
+	if (SSL_version(tls) != TLS1_3_VERSION) {
+		return (ISC_R_NOTIMPLEMENTED);
+	}
+
+	cipher = SSL_get_current_cipher(tls);
+	switch (SSL_CIPHER_get_id(cipher)) {
+	case TLS1_3_CK_AES_128_GCM_SHA256:
+		keylen = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+		break;
+	case TLS1_3_CK_AES_256_GCM_SHA384:
+		keylen = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+		break;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+	case TLS1_3_CK_CHACHA20_POLY1305_SHA256:
+		keylen = TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE;
+		break;
+#endif /* TLS_CIPHER_CHACHA20_POLY1305 */
+	default:
+		return (ISC_R_NOTIMPLEMENTED);
+	}
+
+	md = SSL_CIPHER_get_handshake_digest(cipher);
+	if (md == NULL || !ktls_derive(md, secret, key, keylen, iv, sizeof(iv)))
+	{
+		result = ISC_R_TLSERROR;
+		goto cleanup;
+	}
+
+	for (size_t i = 0; i < sizeof(rec_seq); i++) {
+		rec_seq[i] = (secret->seq >> (8 * (sizeof(rec_seq) - 1 - i))) &
+			     0xff;
+	}
+
+	memset(&ci, 0, sizeof(ci));
+	ci.info.version = TLS_1_3_VERSION;
+	switch (keylen) {
+	case TLS_CIPHER_AES_GCM_128_KEY_SIZE:
+		ci.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+		memmove(ci.aes128.salt, iv, sizeof(ci.aes128.salt));
+		memmove(ci.aes128.iv, iv + sizeof(ci.aes128.salt),
+			sizeof(ci.aes128.iv));
+		memmove(ci.aes128.key, key, sizeof(ci.aes128.key));
+		memmove(ci.aes128.rec_seq, rec_seq, sizeof(ci.aes128.rec_seq));
+		cilen = sizeof(ci.aes128);
+		break;
+	default:
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+		if (SSL_CIPHER_get_id(cipher) ==
+		    TLS1_3_CK_CHACHA20_POLY1305_SHA256)
+		{
+			ci.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+			memmove(ci.chacha.iv, iv, sizeof(ci.chacha.iv));
+			memmove(ci.chacha.key, key, sizeof(ci.chacha.key));
+			memmove(ci.chacha.rec_seq, rec_seq,
+				sizeof(ci.chacha.rec_seq));
+			cilen = sizeof(ci.chacha);
+			break;
+		}
+#endif /* TLS_CIPHER_CHACHA20_POLY1305 */
+		ci.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+		memmove(ci.aes256.salt, iv, sizeof(ci.aes256.salt));
+		memmove(ci.aes256.iv, iv + sizeof(ci.aes256.salt),
+			sizeof(ci.aes256.iv));
+		memmove(ci.aes256.key, key, sizeof(ci.aes256.key));
+		memmove(ci.aes256.rec_seq, rec_seq, sizeof(ci.aes256.rec_seq));
+		cilen = sizeof(ci.aes256);
+		break;
+	}
+
+	/*
+	 * Attaching the upper layer protocol fails with ENOENT when the
+	 * "tls" kernel module is not available.
+	 */
+	if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) {
+		result = (errno == ENOENT || errno == ENOPROTOOPT)
+				 ? ISC_R_NOTIMPLEMENTED
+				 : isc_errno_toresult(errno);
+		goto cleanup;
+	}
+
+	if (setsockopt(fd, SOL_TLS, TLS_TX, &ci, cilen) != 0) {
+		result = (errno == EINVAL || errno == ENOPROTOOPT)
+				 ? ISC_R_NOTIMPLEMENTED
+				 : isc_errno_toresult(errno);
+		goto cleanup;
+	}
+
+cleanup:
+	OPENSSL_cleanse(&ci, sizeof(ci));
+	OPENSSL_cleanse(key, sizeof(key));
+	OPENSSL_cleanse(iv, sizeof(iv));
+	ktls_secret_free(NULL, SSL_get_ex_data(tls, ktls_secret_index), NULL,
+			 0, 0, NULL);
+	(void)SSL_set_ex_data(tls, ktls_secret_index, NULL);
+
+	return (result);
+#else  /* HAVE_KTLS */
+	UNUSED(fd);
+
+	return (ISC_R_NOTIMPLEMENTED);
+#endif /* HAVE_KTLS */
+}
+
+isc_result_t
+isc_tls_ktls_close_notify(int fd) {
+#if HAVE_KTLS
+	unsigned char alert[2] = { SSL3_AL_WARNING, SSL_AD_CLOSE_NOTIFY };
+	union {
+		char buf[CMSG_SPACE(sizeof(unsigned char))];
+		struct cmsghdr align;
+	} control = { 0 };
+	struct iovec iov = { .iov_base = alert, .iov_len = sizeof(alert) };
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = control.buf,
+		.msg_controllen = sizeof(control.buf),
+	};
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+
+	/* The kernel writes the payload as a record of the given type */
+	cmsg->cmsg_level = SOL_TLS;
+	cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+	*CMSG_DATA(cmsg) = SSL3_RT_ALERT;
+
+	if (sendmsg(fd, &msg, MSG_DONTWAIT) != (ssize_t)sizeof(alert)) {
+		return (isc_errno_toresult(errno));
+	}
+
+	return (ISC_R_SUCCESS);
+#else  /* HAVE_KTLS */
+	UNUSED(fd);
+
+	return (ISC_R_NOTIMPLEMENTED);
+#endif /* HAVE_KTLS */
+}
+
 #if HAVE_LIBNGHTTP2
 #ifndef OPENSSL_NO_NEXTPROTONEG
 /*
@@ -1765,6 +1765,16 @@ check_options(const cfg_obj_t *options, const cfg_obj_t *config,
 		}
 	}
 
+	obj = NULL;
+	(void)cfg_map_get(options, "resolver-hedge-ratio", &obj);
+	if (obj != NULL && cfg_obj_aspercentage(obj) > 100) {
+		cfg_obj_log(obj, logctx, ISC_LOG_ERROR,
+			    "'resolver-hedge-ratio' must not exceed 100%%");
+		if (result == ISC_R_SUCCESS) {
+			result = ISC_R_RANGE;
+		}
+	}
+
 	obj = NULL;
 	(void)cfg_map_get(options, "max-ixfr-ratio", &obj);
 	if (obj != NULL && cfg_obj_ispercentage(obj)) {
@@ -1783,6 +1793,17 @@ check_options(const cfg_obj_t *options, const cfg_obj_t *config,
 		}
 	}
 
+	obj = NULL;
+	(void)cfg_map_get(options, "update-commit-window", &obj);
+	if (obj != NULL && cfg_obj_asuint32(obj) > MAX_UPDATE_COMMIT_WINDOW) {
+		cfg_obj_log(obj, logctx, ISC_LOG_ERROR,
+			    "'update-commit-window' is out of range (0..%u)",
+			    MAX_UPDATE_COMMIT_WINDOW);
+		if (result == ISC_R_SUCCESS) {
+			result = ISC_R_RANGE;
+		}
+	}
+
 	obj = NULL;
 	(void)cfg_map_get(options, "check-names", &obj);
 	if (obj != NULL && !cfg_obj_islist(obj)) {
@@ -32,6 +32,10 @@
 #define MAX_MAX_NCACHE_TTL 7 * 24 * 3600
 #endif /* MAX_MAX_NCACHE_TTL */
 
+#ifndef MAX_UPDATE_COMMIT_WINDOW
+#define MAX_UPDATE_COMMIT_WINDOW 1000
+#endif /* MAX_UPDATE_COMMIT_WINDOW */
+
 #define BIND_CHECK_PLUGINS 0x00000001
 /*%<
  * Check the plugin configuration.
@@ -1265,6 +1265,7 @@ static cfg_clausedef_t options_clauses[] = {
 	{ "host-statistics-max", NULL, CFG_CLAUSEFLAG_ANCIENT },
 	{ "hostname", &cfg_type_qstringornone, 0 },
 	{ "interface-interval", &cfg_type_duration, 0 },
+	{ "io-uring", &cfg_type_boolean, 0 },
 	{ "keep-response-order", &cfg_type_bracketed_aml,
 	  CFG_CLAUSEFLAG_OBSOLETE },
 	{ "listen-on", &cfg_type_listenon, CFG_CLAUSEFLAG_MULTI },
@@ -1302,6 +1303,7 @@ static cfg_clausedef_t options_clauses[] = {
 	{ "reserved-sockets", &cfg_type_uint32, CFG_CLAUSEFLAG_ANCIENT },
 	{ "secroots-file", &cfg_type_qstring, 0 },
 	{ "serial-queries", NULL, CFG_CLAUSEFLAG_ANCIENT },
+	{ "serial-query-batch", &cfg_type_uint32, 0 },
 	{ "serial-query-rate", &cfg_type_uint32, 0 },
 	{ "server-id", &cfg_type_serverid, 0 },
 	{ "session-keyalg", &cfg_type_astring, 0 },
@@ -2052,6 +2054,7 @@ static cfg_clausedef_t view_clauses[] = {
 	  CFG_CLAUSEFLAG_NOTCONFIGURED },
 #endif /* ifdef USE_DNSRPS */
 	{ "dnssec-accept-expired", &cfg_type_boolean, 0 },
+	{ "dnssec-chain-prefetch", &cfg_type_boolean, 0 },
 	{ "dnssec-enable", NULL, CFG_CLAUSEFLAG_ANCIENT },
 	{ "dnssec-lookaside", NULL,
 	  CFG_CLAUSEFLAG_MULTI | CFG_CLAUSEFLAG_ANCIENT },
@@ -2125,6 +2128,7 @@ static cfg_clausedef_t view_clauses[] = {
 	{ "request-nsid", &cfg_type_boolean, 0 },
 	{ "request-sit", NULL, CFG_CLAUSEFLAG_ANCIENT },
 	{ "require-server-cookie", &cfg_type_boolean, 0 },
+	{ "resolver-hedge-ratio", &cfg_type_percentage, 0 },
 	{ "resolver-nonbackoff-tries", &cfg_type_uint32, 0 },
 	{ "resolver-query-timeout", &cfg_type_uint32, 0 },
 	{ "resolver-retry-interval", &cfg_type_uint32, 0 },
@@ -2369,6 +2373,7 @@ static cfg_clausedef_t zone_clauses[] = {
 	  CFG_ZONE_SECONDARY | CFG_ZONE_MIRROR },
 	{ "update-check-ksk", &cfg_type_boolean,
 	  CFG_ZONE_PRIMARY | CFG_ZONE_SECONDARY | CFG_CLAUSEFLAG_OBSOLETE },
+	{ "update-commit-window", &cfg_type_uint32, CFG_ZONE_PRIMARY },
 	{ "use-alt-transfer-source", &cfg_type_boolean,
 	  CFG_ZONE_SECONDARY | CFG_ZONE_MIRROR | CFG_ZONE_STUB |
 		  CFG_CLAUSEFLAG_ANCIENT },
@@ -2487,9 +2492,13 @@ cfg_type_t cfg_type_dnssecpolicyopts = {
 
 /*% The "dynamically loadable zones" statement syntax. */
 
-static cfg_clausedef_t dlz_clauses[] = { { "database", &cfg_type_astring, 0 },
-					 { "search", &cfg_type_boolean, 0 },
-					 { NULL, NULL, 0 } };
+static cfg_clausedef_t dlz_clauses[] = {
+	{ "cache-entries", &cfg_type_uint32, 0 },
+	{ "cache-ttl", &cfg_type_duration, 0 },
+	{ "database", &cfg_type_astring, 0 },
+	{ "search", &cfg_type_boolean, 0 },
+	{ NULL, NULL, 0 }
+};
 static cfg_clausedef_t *dlz_clausesets[] = { dlz_clauses, NULL };
 static cfg_type_t cfg_type_dlz = { "dlz",	  cfg_parse_named_map,
 				   cfg_print_map, cfg_doc_map,
@@ -3961,6 +3970,7 @@ static cfg_clausedef_t tls_clauses[] = {
 	{ "ca-file", &cfg_type_qstring, 0 },
 	{ "remote-hostname", &cfg_type_qstring, 0 },
 	{ "dhparam-file", &cfg_type_qstring, 0 },
+	{ "kernel-tls", &cfg_type_boolean, 0 },
 	{ "protocols", &cfg_type_tlsprotos, 0 },
 	{ "ciphers", &cfg_type_astring, 0 },
 	{ "prefer-server-ciphers", &cfg_type_boolean, 0 },
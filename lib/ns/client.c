@@ -66,6 +66,8 @@
 #include <ns/stats.h>
 #include <ns/update.h>
 
+#include "probes.h"
+
 /***
  *** Client
  ***/
@@ -288,6 +290,71 @@ ns_client_drop(ns_client_t *client, isc_result_t result) {
 	}
 }
 
+/*
+ * Format the name in the question section of the client's message for
+ * a USDT probe; the response is rendered into the same message, so this
+ * is the original QNAME at every stage.
+ */
+static void
+client_trace_qname(ns_client_t *client, char *buf, size_t size) {
+	dns_name_t *qname = NULL;
+
+	if (client->message != NULL) {
+		qname = ISC_LIST_HEAD(
+			client->message->sections[DNS_SECTION_QUESTION]);
+	}
+	if (qname != NULL) {
+		dns_name_format(qname, buf, size);
+	} else {
+		strlcpy(buf, "", size);
+	}
+}
+
+static void
+client_trace_request(ns_client_t *client, size_t reqsize ISC_ATTR_UNUSED) {
+	if (!LIBNS_CLIENT_REQUEST_ENABLED()) {
+		return;
+	}
+
+	char peerbuf[ISC_SOCKADDR_FORMATSIZE];
+	isc_sockaddr_format(&client->peeraddr, peerbuf, sizeof(peerbuf));
+	LIBNS_CLIENT_REQUEST(client, peerbuf, (int)reqsize);
+}
+
+static void
+client_trace_view(ns_client_t *client) {
+	if (!LIBNS_CLIENT_VIEW_ENABLED()) {
+		return;
+	}
+
+	char qnamebuf[DNS_NAME_FORMATSIZE];
+	client_trace_qname(client, qnamebuf, sizeof(qnamebuf));
+	LIBNS_CLIENT_VIEW(client, qnamebuf, client->view->name);
+}
+
+static void
+client_trace_render(ns_client_t *client) {
+	if (!LIBNS_CLIENT_RENDER_ENABLED()) {
+		return;
+	}
+
+	char qnamebuf[DNS_NAME_FORMATSIZE];
+	client_trace_qname(client, qnamebuf, sizeof(qnamebuf));
+	LIBNS_CLIENT_RENDER(client, qnamebuf);
+}
+
+static void
+client_trace_send(ns_client_t *client, isc_region_t *r ISC_ATTR_UNUSED) {
+	if (!LIBNS_CLIENT_SEND_ENABLED()) {
+		return;
+	}
+
+	char qnamebuf[DNS_NAME_FORMATSIZE];
+	client_trace_qname(client, qnamebuf, sizeof(qnamebuf));
+	LIBNS_CLIENT_SEND(client, qnamebuf, client->message->rcode,
+			  (int)r->length);
+}
+
 static void
 client_senddone(isc_nmhandle_t *handle, isc_result_t result, void *cbarg) {
 	ns_client_t *client = cbarg;
@@ -388,6 +455,7 @@ client_sendpkg(ns_client_t *client, isc_buffer_t *buffer) {
 			isc_nm_set_maxage(client->handle, min_ttl);
 		}
 	}
+	client_trace_send(client, &r);
 	isc_nm_send(client->handle, &r, client_senddone, client);
 }
 
@@ -456,6 +524,78 @@ done:
 	ns_client_drop(client, result);
 }
 
+/*
+ * Count the time since the request arrived in the server's latency
+ * histograms, and in the zone's if it was answered authoritatively
+ * from a zone that keeps full statistics.
+ */
+static void
+client_updatelatency(ns_client_t *client) {
+	ns_server_t *sctx = client->manager->sctx;
+	unsigned int attrs = client->query.attributes;
+	ns_latency_t transport, rcode, source;
+	uint64_t usecs;
+
+	usecs = (isc_time_monotonic() - client->requeststart) / NS_PER_US;
+
+	if (isc_nm_is_http_handle(client->handle)) {
+		transport = ns_latency_https;
+	} else if (!TCP_CLIENT(client)) {
+		transport = ns_latency_udp;
+	} else if (isc_nm_has_encryption(client->handle)) {
+		transport = ns_latency_tls;
+	} else {
+		transport = ns_latency_tcp;
+	}
+	isc_histomulti_inc(sctx->latencystats[transport], usecs);
+
+	switch (client->message->rcode) {
+	case dns_rcode_noerror:
+		rcode = ns_latency_noerror;
+		break;
+	case dns_rcode_nxdomain:
+		rcode = ns_latency_nxdomain;
+		break;
+	case dns_rcode_servfail:
+		rcode = ns_latency_servfail;
+		break;
+	case dns_rcode_refused:
+		rcode = ns_latency_refused;
+		break;
+	default:
+		rcode = ns_latency_otherrcode;
+	}
+	isc_histomulti_inc(sctx->latencystats[rcode], usecs);
+
+	/*
+	 * A query that needed the resolver counts as recursion, even if
+	 * part of the answer was cached; a cache miss answered without
+	 * recursion (e.g. with a referral) counts as a miss.
+	 */
+	if ((attrs & NS_QUERYATTR_RECURSED) != 0) {
+		source = ns_latency_recursion;
+	} else if ((attrs & NS_QUERYATTR_CACHEMISS) != 0) {
+		source = ns_latency_cachemiss;
+	} else if ((attrs & NS_QUERYATTR_CACHEHIT) != 0) {
+		source = ns_latency_cachehit;
+	} else if (client->query.authdbset) {
+		source = ns_latency_auth;
+	} else {
+		source = ns_latency_max;
+	}
+	if (source != ns_latency_max) {
+		isc_histomulti_inc(sctx->latencystats[source], usecs);
+	}
+
+	if (client->query.authzone != NULL) {
+		isc_histomulti_t *zonestats =
+			dns_zone_getlatencystats(client->query.authzone);
+		if (zonestats != NULL) {
+			isc_histomulti_inc(zonestats, usecs);
+		}
+	}
+}
+
 void
 ns_client_send(ns_client_t *client) {
 	isc_result_t result;
@@ -490,6 +630,7 @@ ns_client_send(ns_client_t *client) {
 	env = client->manager->aclenv;
 
 	CTRACE("send");
+	client_trace_render(client);
 
 	if (client->message->opcode == dns_opcode_query &&
 	    (client->attributes & NS_CLIENTATTR_RA) != 0)
@@ -659,6 +800,7 @@ renderend:
 
 		respsize = isc_buffer_usedlength(&buffer);
 
+		client_updatelatency(client);
 		client_sendpkg(client, &buffer);
 
 		switch (isc_sockaddr_pf(&client->peeraddr)) {
@@ -688,6 +830,7 @@ renderend:
 
 		respsize = isc_buffer_usedlength(&buffer);
 
+		client_updatelatency(client);
 		client_sendpkg(client, &buffer);
 
 		switch (isc_sockaddr_pf(&client->peeraddr)) {
@@ -1777,10 +1920,12 @@ ns_client_request(isc_nmhandle_t *handle, isc_result_t eresult,
 	client->peeraddr_valid = true;
 
 	reqsize = isc_buffer_usedlength(buffer);
+	client_trace_request(client, reqsize);
 
 	client->state = NS_CLIENTSTATE_WORKING;
 
 	client->requesttime = isc_time_now();
+	client->requeststart = isc_time_monotonic();
 	client->tnow = client->requesttime;
 	client->now = isc_time_seconds(&client->tnow);
 
@@ -1888,9 +2033,12 @@ ns_client_request(isc_nmhandle_t *handle, isc_result_t eresult,
 	}
 
 	/*
-	 * It's a request.  Parse it.
+	 * It's a request.  Parse it.  Apart from OPT, TSIG and SIG(0),
+	 * the records in a query are rarely needed, so only build them
+	 * on demand.
 	 */
-	result = dns_message_parse(client->message, buffer, 0);
+	result = dns_message_parse(client->message, buffer,
+				   DNS_MESSAGEPARSE_LAZY);
 	if (result != ISC_R_SUCCESS) {
 		/*
 		 * Parsing the request failed.  Send a response
@@ -2053,6 +2201,7 @@ ns_client_request(isc_nmhandle_t *handle, isc_result_t eresult,
 
 	ns_client_log(client, NS_LOGCATEGORY_CLIENT, NS_LOGMODULE_CLIENT,
 		      ISC_LOG_DEBUG(5), "using view '%s'", client->view->name);
+	client_trace_view(client);
 
 	/*
 	 * Check for a signature.  We log bad signatures regardless of
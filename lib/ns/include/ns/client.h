@@ -187,6 +187,7 @@ struct ns_client {
 	void		(*cleanup)(ns_client_t *);
 	ns_query_t	query;
 	isc_time_t	requesttime;
+	isc_nanosecs_t	requeststart; /*%< monotonic, for latency */
 	isc_stdtime_t	now;
 	isc_time_t	tnow;
 	dns_name_t	signername; /*%< [T]SIG key name */
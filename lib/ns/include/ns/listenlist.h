@@ -72,6 +72,7 @@ typedef struct ns_listen_tls_params {
 	bool	    prefer_server_ciphers_set;
 	bool	    session_tickets;
 	bool	    session_tickets_set;
+	bool	    kernel_tls;
 } ns_listen_tls_params_t;
 
 /***
@@ -109,6 +109,7 @@ struct ns_query {
 	bool		 isreferral;
 	isc_mutex_t	 fetchlock;
 	ns_hookasync_t	*hookactx;
+	dns_sdlzasync_t *dlzasync;
 	dns_rpz_st_t	*rpz_st;
 	isc_bufferlist_t namebufs;
 	ISC_LIST(ns_dbversion_t) activeversions;
@@ -166,6 +167,9 @@ struct ns_query {
 #define NS_QUERYATTR_ANSWERED	     0x040000
 #define NS_QUERYATTR_STALEOK	     0x080000
 #define NS_QUERYATTR_STALEPENDING    0x100000
+#define NS_QUERYATTR_RECURSED	     0x200000
+#define NS_QUERYATTR_CACHEHIT	     0x400000
+#define NS_QUERYATTR_CACHEMISS	     0x800000
 
 typedef struct query_ctx query_ctx_t;
 
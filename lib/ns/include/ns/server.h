@@ -30,6 +30,7 @@
 #include <dns/acl.h>
 #include <dns/types.h>
 
+#include <ns/stats.h>
 #include <ns/types.h>
 
 #define NS_SERVER_LOGQUERIES	 0x00000001U /*%< log queries */
@@ -126,6 +127,8 @@ struct ns_server {
 	isc_histomulti_t *tcpoutstats4;
 	isc_histomulti_t *tcpinstats6;
 	isc_histomulti_t *tcpoutstats6;
+
+	isc_histomulti_t *latencystats[ns_latency_max];
 };
 
 struct ns_altsecret {
@@ -112,9 +112,38 @@ enum {
 
 	ns_statscounter_updatequota = 67,
 
-	ns_statscounter_max = 68,
+	ns_statscounter_nsec3cachehit = 68,
+	ns_statscounter_nsec3cachemiss = 69,
+
+	ns_statscounter_max = 70,
 };
 
+/*%
+ * Query latency histograms, in microseconds from the receipt of a
+ * request to the sending of its response.  Each response is counted
+ * once per group: by transport, by response code, and by where the
+ * answer came from.
+ */
+typedef enum {
+	ns_latency_udp = 0,
+	ns_latency_tcp = 1,
+	ns_latency_tls = 2,
+	ns_latency_https = 3,
+
+	ns_latency_noerror = 4,
+	ns_latency_nxdomain = 5,
+	ns_latency_servfail = 6,
+	ns_latency_refused = 7,
+	ns_latency_otherrcode = 8,
+
+	ns_latency_auth = 9,
+	ns_latency_cachehit = 10,
+	ns_latency_cachemiss = 11,
+	ns_latency_recursion = 12,
+
+	ns_latency_max = 13,
+} ns_latency_t;
+
 void
 ns_stats_attach(ns_stats_t *stats, ns_stats_t **statsp);
 
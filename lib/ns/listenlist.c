@@ -145,6 +145,10 @@ listenelt_create(isc_mem_t *mctx, in_port_t port, dns_acl_t *acl,
 					sslctx, tls_params->session_tickets);
 			}
 
+			if (tls_params->kernel_tls) {
+				isc_tlsctx_enable_ktls(sslctx);
+			}
+
 #ifdef HAVE_LIBNGHTTP2
 			if (is_http) {
 				isc_tlsctx_enable_http2server_alpn(sslctx);
@@ -57,6 +57,7 @@
 #include <dns/rdatatype.h>
 #include <dns/resolver.h>
 #include <dns/result.h>
+#include <dns/sdlz.h>
 #include <dns/stats.h>
 #include <dns/tkey.h>
 #include <dns/types.h>
@@ -723,6 +724,9 @@ query_reset(ns_client_t *client, bool everything) {
 	if (client->query.authzone != NULL) {
 		dns_zone_detach(&client->query.authzone);
 	}
+	if (client->query.dlzasync != NULL) {
+		dns_sdlz_asyncdetach(&client->query.dlzasync);
+	}
 
 	if (client->query.dns64_aaaa != NULL) {
 		ns_client_putrdataset(client, &client->query.dns64_aaaa);
@@ -4804,8 +4808,10 @@ query_findclosestnsec3(dns_name_t *qname, dns_db_t *db,
 	dns_rdata_nsec3_t nsec3;
 	dns_rdata_t rdata = DNS_RDATA_INIT;
 	bool optout;
+	bool hit;
 	dns_clientinfomethods_t cm;
 	dns_clientinfo_t ci;
+	dns_nsec3cache_t *nsec3cache = NULL;
 
 	salt_length = sizeof(salt);
 	result = dns_db_getnsec3parameters(db, version, &hash, NULL,
@@ -4827,11 +4833,29 @@ query_findclosestnsec3(dns_name_t *qname, dns_db_t *db,
 		hash = 1;
 	}
 
+	/*
+	 * The closest encloser and wildcard names are hashed again and
+	 * again for every negative answer from the zone; use the zone's
+	 * NSEC3 hash cache to avoid the iterated hashing.
+	 */
+	if (client->query.authzone != NULL) {
+		nsec3cache = dns_zone_getnsec3cache(client->query.authzone);
+	}
+
 again:
 	dns_fixedname_init(&fixed);
-	result = dns_nsec3_hashname(&fixed, NULL, NULL, &name,
-				    dns_db_origin(db), hash, iterations, salt,
-				    salt_length);
+	if (nsec3cache != NULL) {
+		result = dns_nsec3cache_hashname(
+			nsec3cache, &fixed, &name, dns_db_origin(db), hash,
+			iterations, salt, salt_length, &hit);
+		ns_stats_increment(client->manager->sctx->nsstats,
+				   hit ? ns_statscounter_nsec3cachehit
+				       : ns_statscounter_nsec3cachemiss);
+	} else {
+		result = dns_nsec3_hashname(&fixed, NULL, NULL, &name,
+					    dns_db_origin(db), hash, iterations,
+					    salt, salt_length);
+	}
 	if (result != ISC_R_SUCCESS) {
 		return;
 	}
@@ -5889,6 +5913,75 @@ stale_client_answer(isc_result_t result) {
 	UNREACHABLE();
 }
 
+static void
+query_dlzwait_cancel(ns_hookasync_t *ctx) {
+	/* The lookup cannot be stopped; the query resumes when it is done */
+	UNUSED(ctx);
+}
+
+static void
+query_dlzwait_destroy(ns_hookasync_t **ctxp) {
+	ns_hookasync_t *ctx = *ctxp;
+
+	*ctxp = NULL;
+	isc_mem_putanddetach(&ctx->mctx, ctx, sizeof(*ctx));
+}
+
+/*%
+ * Suspend the query until the DLZ lookup that made query_lookup()
+ * wait has completed, then run query_lookup() again.
+ */
+static isc_result_t
+query_dlzwait(query_ctx_t *qctx, isc_mem_t *mctx, void *arg, isc_loop_t *loop,
+	      isc_job_cb cb, void *evarg, ns_hookasync_t **ctxp) {
+	dns_sdlzasync_t *async = arg;
+	ns_hook_resume_t *rev = isc_mem_get(mctx, sizeof(*rev));
+	ns_hookasync_t *ctx = isc_mem_get(mctx, sizeof(*ctx));
+
+	*ctx = (ns_hookasync_t){
+		.cancel = query_dlzwait_cancel,
+		.destroy = query_dlzwait_destroy,
+	};
+	isc_mem_attach(mctx, &ctx->mctx);
+
+	*rev = (ns_hook_resume_t){
+		.hookpoint = NS_QUERY_LOOKUP_BEGIN,
+		.origresult = DNS_R_WAIT,
+		.saved_qctx = qctx,
+		.ctx = ctx,
+		.arg = evarg,
+	};
+
+	*ctxp = ctx;
+	dns_sdlz_asyncwait(async, loop, cb, rev);
+
+	return (ISC_R_SUCCESS);
+}
+
+static void
+query_trace_lookupbegin(query_ctx_t *qctx, const dns_name_t *name) {
+	if (!LIBNS_QUERY_LOOKUP_BEGIN_ENABLED()) {
+		return;
+	}
+
+	char namebuf[DNS_NAME_FORMATSIZE];
+	dns_name_format(name, namebuf, sizeof(namebuf));
+	LIBNS_QUERY_LOOKUP_BEGIN(qctx->client, namebuf, qctx->type,
+				 qctx->is_zone);
+}
+
+static void
+query_trace_lookupend(query_ctx_t *qctx, const dns_name_t *name,
+		      isc_result_t result ISC_ATTR_UNUSED) {
+	if (!LIBNS_QUERY_LOOKUP_END_ENABLED()) {
+		return;
+	}
+
+	char namebuf[DNS_NAME_FORMATSIZE];
+	dns_name_format(name, namebuf, sizeof(namebuf));
+	LIBNS_QUERY_LOOKUP_END(qctx->client, namebuf, result);
+}
+
 /*%
  * Perform a local database lookup, in either an authoritative or
  * cache database. If unable to answer, call ns_query_done(); otherwise
@@ -5922,6 +6015,18 @@ query_lookup(query_ctx_t *qctx) {
 		dns_clientinfo_setecs(&ci, &qctx->client->ecs);
 	}
 
+	/*
+	 * Let a DLZ driver look the name up in the background rather
+	 * than block every other client on this loop.
+	 */
+	if (qctx->is_zone && dns_sdlz_asyncsupported(qctx->db)) {
+		if (qctx->client->query.dlzasync == NULL) {
+			dns_sdlz_asynccreate(qctx->client->manager->mctx,
+					     &qctx->client->query.dlzasync);
+		}
+		dns_clientinfo_setdlzasync(&ci, qctx->client->query.dlzasync);
+	}
+
 	/*
 	 * We'll need some resources...
 	 */
@@ -5965,10 +6070,28 @@ query_lookup(query_ctx_t *qctx) {
 		dboptions |= DNS_DBFIND_STALEENABLED;
 	}
 
+	query_trace_lookupbegin(qctx, rpzqname);
 	result = dns_db_findext(qctx->db, rpzqname, qctx->version, qctx->type,
 				dboptions, qctx->client->now, &qctx->node,
 				qctx->fname, &cm, &ci, qctx->rdataset,
 				qctx->sigrdataset);
+	query_trace_lookupend(qctx, rpzqname, result);
+
+	if (result == DNS_R_WAIT) {
+		/*
+		 * Suspend the query like a recursion, and repeat the
+		 * lookup once the DLZ driver has the answer.
+		 */
+		ns_client_releasename(qctx->client, &qctx->fname);
+		ns_client_putrdataset(qctx->client, &qctx->rdataset);
+		if (qctx->sigrdataset != NULL) {
+			ns_client_putrdataset(qctx->client,
+					      &qctx->sigrdataset);
+		}
+		(void)ns_query_hookasync(qctx, query_dlzwait,
+					 qctx->client->query.dlzasync);
+		return (ISC_R_SUCCESS);
+	}
 
 	/*
 	 * Fixup fname and sigrdataset.
@@ -5983,7 +6106,13 @@ query_lookup(query_ctx_t *qctx) {
 	}
 
 	if (!qctx->is_zone) {
-		dns_cache_updatestats(qctx->view->cache, result);
+		if (dns_cache_updatestats(qctx->view->cache, result)) {
+			qctx->client->query.attributes |=
+				NS_QUERYATTR_CACHEHIT;
+		} else {
+			qctx->client->query.attributes |=
+				NS_QUERYATTR_CACHEMISS;
+		}
 	}
 
 	/*
@@ -6259,6 +6388,30 @@ query_lookup_stale(ns_client_t *client) {
 	qctx_destroy(&qctx);
 }
 
+static void
+query_trace_recursestart(ns_client_t *client, const dns_name_t *qname,
+			 dns_rdatatype_t qtype ISC_ATTR_UNUSED) {
+	if (!LIBNS_QUERY_RECURSE_START_ENABLED()) {
+		return;
+	}
+
+	char namebuf[DNS_NAME_FORMATSIZE];
+	dns_name_format(qname, namebuf, sizeof(namebuf));
+	LIBNS_QUERY_RECURSE_START(client, namebuf, qtype);
+}
+
+static void
+query_trace_recurseresume(ns_client_t *client,
+			  isc_result_t result ISC_ATTR_UNUSED) {
+	if (!LIBNS_QUERY_RECURSE_RESUME_ENABLED()) {
+		return;
+	}
+
+	char namebuf[DNS_NAME_FORMATSIZE];
+	dns_name_format(client->query.qname, namebuf, sizeof(namebuf));
+	LIBNS_QUERY_RECURSE_RESUME(client, namebuf, result);
+}
+
 /*
  * Event handler to resume processing a query after recursion, or when a
  * client timeout is triggered. If the query has timed out or been cancelled
@@ -6290,6 +6443,9 @@ fetch_callback(void *arg) {
 		isc_mem_putanddetach(&resp->mctx, resp, sizeof(*resp));
 		return;
 	}
+
+	query_trace_recurseresume(client, resp->result);
+
 	/*
 	 * We are resuming from recursion. Reset any attributes, options
 	 * that a lookup due to stale-answer-client-timeout may have set.
@@ -6561,6 +6717,8 @@ ns_query_recurse(ns_client_t *client, dns_rdatatype_t qtype, dns_name_t *qname,
 		client->query.fetchoptions |= DNS_FETCHOPT_TRYSTALE_ONTIMEOUT;
 	}
 
+	query_trace_recursestart(client, qname, qtype);
+
 	isc_nmhandle_attach(client->handle, &HANDLE_RECTYPE_NORMAL(client));
 	result = dns_resolver_createfetch(
 		client->view->resolver, qname, qtype, qdomain, nameservers,
@@ -6574,6 +6732,8 @@ ns_query_recurse(ns_client_t *client, dns_rdatatype_t qtype, dns_name_t *qname,
 			ns_client_putrdataset(client, &sigrdataset);
 		}
 		recursionquotatype_detach(client);
+	} else {
+		client->query.attributes |= NS_QUERYATTR_RECURSED;
 	}
 
 	/*
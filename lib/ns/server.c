@@ -101,6 +101,11 @@ ns_server_create(isc_mem_t *mctx, ns_matchview_t matchingview,
 	isc_histomulti_create(mctx, DNS_SIZEHISTO_SIGBITSOUT,
 			      &sctx->tcpoutstats6);
 
+	for (size_t i = 0; i < ns_latency_max; i++) {
+		isc_histomulti_create(mctx, DNS_LATENCYHISTO_SIGBITS,
+				      &sctx->latencystats[i]);
+	}
+
 	ISC_LIST_INIT(sctx->altsecrets);
 
 	sctx->magic = SCTX_MAGIC;
@@ -203,6 +208,12 @@ ns_server_detach(ns_server_t **sctxp) {
 			isc_histomulti_destroy(&sctx->tcpoutstats6);
 		}
 
+		for (size_t i = 0; i < ns_latency_max; i++) {
+			if (sctx->latencystats[i] != NULL) {
+				isc_histomulti_destroy(&sctx->latencystats[i]);
+			}
+		}
+
 		sctx->magic = 0;
 
 		isc_mem_putanddetach(&sctx->mctx, sctx, sizeof(*sctx));
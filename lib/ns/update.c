@@ -19,6 +19,8 @@
 #include <isc/serial.h>
 #include <isc/stats.h>
 #include <isc/string.h>
+#include <isc/time.h>
+#include <isc/timer.h>
 #include <isc/util.h>
 
 #include <dns/db.h>
@@ -223,6 +225,7 @@ struct rr {
 };
 
 typedef struct update update_t;
+typedef ISC_LIST(update_t) updatelist_t;
 
 struct update {
 	dns_zone_t *zone;
@@ -231,6 +234,7 @@ struct update {
 	dns_message_t *answer;
 	const dns_ssurule_t **rules;
 	size_t ruleslen;
+	ISC_LINK(update_t) link;
 };
 
 /*%
@@ -263,6 +267,10 @@ typedef struct {
 static void
 update_action(void *arg);
 static void
+update_enqueue(void *arg);
+static bool
+update_groupable(dns_zone_t *zone, dns_db_t *db);
+static void
 updatedone_action(void *arg);
 static isc_result_t
 send_forward(ns_client_t *client, dns_zone_t *zone);
@@ -1898,10 +1906,14 @@ send_update(ns_client_t *client, dns_zone_t *zone) {
 		.rules = rules,
 		.ruleslen = ruleslen,
 		.result = ISC_R_SUCCESS,
+		.link = ISC_LINK_INITIALIZER,
 	};
 
 	isc_nmhandle_attach(client->handle, &client->updatehandle);
-	isc_async_run(dns_zone_getloop(zone), update_action, uev);
+	isc_async_run(dns_zone_getloop(zone),
+		      update_groupable(zone, db) ? update_enqueue
+						 : update_action,
+		      uev);
 	rules = NULL;
 
 failure:
@@ -2738,55 +2750,26 @@ isdnssec(dns_db_t *db, dns_dbversion_t *ver, dns_rdatatype_t privatetype) {
 	return (build_nsec || build_nsec3);
 }
 
-static void
-update_action(void *arg) {
-	update_t *uev = (update_t *)arg;
+/*%
+ * Check the prerequisite section of the request in 'uev' against version
+ * 'ver' of 'db'.  The database is not modified.
+ */
+static isc_result_t
+update_checkprereqs(update_t *uev, dns_db_t *db, dns_dbversion_t *ver) {
 	dns_zone_t *zone = uev->zone;
 	ns_client_t *client = uev->client;
-	const dns_ssurule_t **rules = uev->rules;
-	size_t rule = 0, ruleslen = uev->ruleslen;
 	isc_result_t result;
-	dns_db_t *db = NULL;
-	dns_dbversion_t *oldver = NULL;
-	dns_dbversion_t *ver = NULL;
-	dns_diff_t diff; /* Pending updates. */
 	dns_diff_t temp; /* Pending RR existence assertions. */
-	bool soa_serial_changed = false;
 	isc_mem_t *mctx = client->manager->mctx;
 	dns_rdatatype_t covers;
 	dns_message_t *request = client->message;
-	dns_rdataclass_t zoneclass;
-	dns_name_t *zonename = NULL;
-	dns_ssutable_t *ssutable = NULL;
+	dns_rdataclass_t zoneclass = dns_db_class(db);
+	dns_name_t *zonename = dns_db_origin(db);
 	dns_fixedname_t tmpnamefixed;
 	dns_name_t *tmpname = NULL;
-	dns_zoneopt_t options;
-	bool had_dnskey;
-	dns_rdatatype_t privatetype = dns_zone_getprivatetype(zone);
-	dns_ttl_t maxttl = 0;
-	uint32_t maxrecords;
-	uint64_t records;
-	bool is_inline, is_maintain, is_signing;
 
-	dns_diff_init(mctx, &diff);
 	dns_diff_init(mctx, &temp);
 
-	CHECK(dns_zone_getdb(zone, &db));
-	zonename = dns_db_origin(db);
-	zoneclass = dns_db_class(db);
-	dns_zone_getssutable(zone, &ssutable);
-	options = dns_zone_getoptions(zone);
-
-	is_inline = (!dns_zone_israw(zone) && dns_zone_issecure(zone));
-	is_maintain = ((dns_zone_getkeyopts(zone) & DNS_ZONEKEY_MAINTAIN) != 0);
-	is_signing = is_inline || (!is_inline && is_maintain);
-
-	/*
-	 * Get old and new versions now that queryacl has been checked.
-	 */
-	dns_db_currentversion(db, &oldver);
-	CHECK(dns_db_newversion(db, &ver));
-
 	/*
 	 * Check prerequisites.
 	 */
@@ -2913,6 +2896,50 @@ update_action(void *arg) {
 	}
 
 	update_log(client, zone, LOGLEVEL_DEBUG, "prerequisites are OK");
+	result = ISC_R_SUCCESS;
+
+failure:
+	dns_diff_clear(&temp);
+	return (result);
+}
+
+/*%
+ * Apply the update section of the request in 'uev' to version 'ver' of
+ * 'db', and then make the changes that follow from it, such as the SOA
+ * serial number and DNSSEC records.  'oldver' is the version of 'db'
+ * before 'ver'.  The changes made are appended to 'diff'.
+ *
+ * On failure, 'ver' may have been partially updated and must be rolled
+ * back by the caller.
+ */
+static isc_result_t
+update_apply(update_t *uev, dns_db_t *db, dns_dbversion_t *oldver,
+	     dns_dbversion_t *ver, dns_diff_t *diff) {
+	dns_zone_t *zone = uev->zone;
+	ns_client_t *client = uev->client;
+	const dns_ssurule_t **rules = uev->rules;
+	size_t rule = 0, ruleslen = uev->ruleslen;
+	isc_result_t result;
+	bool soa_serial_changed = false;
+	isc_mem_t *mctx = client->manager->mctx;
+	dns_rdatatype_t covers;
+	dns_message_t *request = client->message;
+	dns_rdataclass_t zoneclass = dns_db_class(db);
+	dns_name_t *zonename = dns_db_origin(db);
+	dns_ssutable_t *ssutable = NULL;
+	dns_zoneopt_t options = dns_zone_getoptions(zone);
+	bool had_dnskey;
+	dns_rdatatype_t privatetype = dns_zone_getprivatetype(zone);
+	dns_ttl_t maxttl = 0;
+	uint32_t maxrecords;
+	uint64_t records;
+	bool is_inline, is_maintain, is_signing;
+
+	dns_zone_getssutable(zone, &ssutable);
+
+	is_inline = (!dns_zone_israw(zone) && dns_zone_issecure(zone));
+	is_maintain = ((dns_zone_getkeyopts(zone) & DNS_ZONEKEY_MAINTAIN) != 0);
+	is_signing = is_inline || (!is_inline && is_maintain);
 
 	/*
 	 * Process the Update Section.
@@ -3132,7 +3159,7 @@ update_action(void *arg) {
 				add_rr_prepare_ctx_t ctx;
 				ctx.db = db;
 				ctx.ver = ver;
-				ctx.diff = &diff;
+				ctx.diff = diff;
 				ctx.name = name;
 				ctx.oldname = name;
 				ctx.update_rr = &rdata;
@@ -3149,18 +3176,18 @@ update_action(void *arg) {
 					dns_diff_clear(&ctx.add_diff);
 				} else {
 					result = do_diff(&ctx.del_diff, db, ver,
-							 &diff);
+							 diff);
 					if (result == ISC_R_SUCCESS) {
 						result = do_diff(&ctx.add_diff,
 								 db, ver,
-								 &diff);
+								 diff);
 					}
 					if (result != ISC_R_SUCCESS) {
 						dns_diff_clear(&ctx.del_diff);
 						dns_diff_clear(&ctx.add_diff);
 						goto failure;
 					}
-					CHECK(update_one_rr(db, ver, &diff,
+					CHECK(update_one_rr(db, ver, diff,
 							    DNS_DIFFOP_ADD,
 							    name, ttl, &rdata));
 				}
@@ -3183,12 +3210,12 @@ update_action(void *arg) {
 					CHECK(delete_if(type_not_soa_nor_ns_p,
 							db, ver, name,
 							dns_rdatatype_any, 0,
-							&rdata, &diff));
+							&rdata, diff));
 				} else {
 					CHECK(delete_if(type_not_dnssec, db,
 							ver, name,
 							dns_rdatatype_any, 0,
-							&rdata, &diff));
+							&rdata, diff));
 				}
 			} else if (dns_name_equal(name, zonename) &&
 				   (rdata.type == dns_rdatatype_soa ||
@@ -3216,7 +3243,7 @@ update_action(void *arg) {
 				}
 				CHECK(delete_if(true_p, db, ver, name,
 						rdata.type, covers, &rdata,
-						&diff));
+						diff));
 			}
 		} else if (update_class == dns_rdataclass_none) {
 			char namestr[DNS_NAME_FORMATSIZE];
@@ -3276,7 +3303,7 @@ update_action(void *arg) {
 			update_log(client, zone, LOGLEVEL_PROTOCOL,
 				   "deleting an RR at %s %s", namestr, typestr);
 			CHECK(delete_if(rr_equal_p, db, ver, name, rdata.type,
-					covers, &rdata, &diff));
+					covers, &rdata, diff));
 		}
 	}
 	if (result != ISC_R_NOMORE) {
@@ -3288,11 +3315,11 @@ update_action(void *arg) {
 	 * If they don't then back out all changes to DNSKEY/NSEC3PARAM
 	 * records.
 	 */
-	if (!ISC_LIST_EMPTY(diff.tuples)) {
-		CHECK(check_dnssec(client, zone, db, ver, &diff));
+	if (!ISC_LIST_EMPTY(diff->tuples)) {
+		CHECK(check_dnssec(client, zone, db, ver, diff));
 	}
 
-	if (!ISC_LIST_EMPTY(diff.tuples)) {
+	if (!ISC_LIST_EMPTY(diff->tuples)) {
 		unsigned int errors = 0;
 		CHECK(dns_zone_nscheck(zone, db, ver, &errors));
 		if (errors != 0) {
@@ -3303,7 +3330,7 @@ update_action(void *arg) {
 			goto failure;
 		}
 	}
-	if (!ISC_LIST_EMPTY(diff.tuples) && is_signing) {
+	if (!ISC_LIST_EMPTY(diff->tuples) && is_signing) {
 		result = dns_zone_cdscheck(zone, db, ver);
 		if (result == DNS_R_BADCDS || result == DNS_R_BADCDNSKEY) {
 			update_log(client, zone, LOGLEVEL_PROTOCOL,
@@ -3318,13 +3345,10 @@ update_action(void *arg) {
 	}
 
 	/*
-	 * If any changes were made, increment the SOA serial number,
-	 * update RRSIGs and NSECs (if zone is secure), and write the update
-	 * to the journal.
+	 * If any changes were made, increment the SOA serial number and
+	 * update RRSIGs and NSECs (if zone is secure).
 	 */
-	if (!ISC_LIST_EMPTY(diff.tuples)) {
-		char *journalfile;
-		dns_journal_t *journal;
+	if (!ISC_LIST_EMPTY(diff->tuples)) {
 		bool has_dnskey;
 
 		/*
@@ -3333,13 +3357,13 @@ update_action(void *arg) {
 		 */
 		if (!soa_serial_changed) {
 			CHECK(update_soa_serial(
-				db, ver, &diff, mctx,
+				db, ver, diff, mctx,
 				dns_zone_getserialupdatemethod(zone)));
 		}
 
-		CHECK(check_mx(client, zone, db, ver, &diff));
+		CHECK(check_mx(client, zone, db, ver, diff));
 
-		CHECK(remove_orphaned_ds(db, ver, &diff));
+		CHECK(remove_orphaned_ds(db, ver, diff));
 
 		CHECK(rrset_exists(db, ver, zonename, dns_rdatatype_dnskey, 0,
 				   &has_dnskey));
@@ -3347,9 +3371,9 @@ update_action(void *arg) {
 		CHECK(rrset_exists(db, oldver, zonename, dns_rdatatype_dnskey,
 				   0, &had_dnskey));
 
-		CHECK(rollback_private(db, privatetype, ver, &diff));
+		CHECK(rollback_private(db, privatetype, ver, diff));
 
-		CHECK(add_nsec3param_records(client, zone, db, ver, &diff));
+		CHECK(add_nsec3param_records(client, zone, db, ver, diff));
 
 		if (is_signing && had_dnskey && !has_dnskey) {
 			/*
@@ -3359,7 +3383,7 @@ update_action(void *arg) {
 			 * remove any NSEC chain present will also be removed.
 			 */
 			CHECK(dns_nsec3param_deletechains(db, ver, zone, true,
-							  &diff));
+							  diff));
 		} else if (has_dnskey && isdnssec(db, ver, privatetype)) {
 			dns_update_log_t log;
 			uint32_t interval =
@@ -3368,7 +3392,7 @@ update_action(void *arg) {
 			log.func = update_log_cb;
 			log.arg = client;
 			result = dns_update_signatures(&log, zone, db, oldver,
-						       ver, &diff, interval);
+						       ver, diff, interval);
 
 			if (result != ISC_R_SUCCESS) {
 				update_log(client, zone, ISC_LOG_ERROR,
@@ -3390,53 +3414,128 @@ update_action(void *arg) {
 				goto failure;
 			}
 		}
+	}
+	result = ISC_R_SUCCESS;
 
-		journalfile = dns_zone_getjournal(zone);
-		if (journalfile != NULL) {
-			update_log(client, zone, LOGLEVEL_DEBUG,
-				   "writing journal %s", journalfile);
+failure:
+	if (ssutable != NULL) {
+		dns_ssutable_detach(&ssutable);
+	}
 
-			journal = NULL;
-			result = dns_journal_open(mctx, journalfile,
-						  DNS_JOURNAL_CREATE, &journal);
-			if (result != ISC_R_SUCCESS) {
-				FAILS(result, "journal open failed");
-			}
+	return (result);
+}
 
-			result = dns_journal_write_transaction(journal, &diff);
-			if (result != ISC_R_SUCCESS) {
-				dns_journal_destroy(&journal);
-				FAILS(result, "journal write failed");
-			}
+/*%
+ * Write 'diff' to the journal of 'zone' and commit version '*verp' of
+ * 'db'.  On failure, '*verp' is left open to be rolled back by the
+ * caller.
+ */
+static isc_result_t
+update_commit(ns_client_t *client, dns_zone_t *zone, dns_db_t *db,
+	      dns_dbversion_t **verp, dns_diff_t *diff) {
+	isc_result_t result;
+	char *journalfile;
+	dns_journal_t *journal = NULL;
+
+	journalfile = dns_zone_getjournal(zone);
+	if (journalfile != NULL) {
+		update_log(client, zone, LOGLEVEL_DEBUG, "writing journal %s",
+			   journalfile);
+
+		result = dns_journal_open(diff->mctx, journalfile,
+					  DNS_JOURNAL_CREATE, &journal);
+		if (result != ISC_R_SUCCESS) {
+			FAILS(result, "journal open failed");
+		}
 
+		result = dns_journal_write_transaction(journal, diff);
+		if (result != ISC_R_SUCCESS) {
 			dns_journal_destroy(&journal);
+			FAILS(result, "journal write failed");
 		}
 
-		/*
-		 * XXXRTH  Just a note that this committing code will have
-		 *	   to change to handle databases that need two-phase
-		 *	   commit, but this isn't a priority.
-		 */
-		update_log(client, zone, LOGLEVEL_DEBUG,
-			   "committing update transaction");
+		dns_journal_destroy(&journal);
+	}
 
-		dns_db_closeversion(db, &ver, true);
+	/*
+	 * XXXRTH  Just a note that this committing code will have
+	 *	   to change to handle databases that need two-phase
+	 *	   commit, but this isn't a priority.
+	 */
+	update_log(client, zone, LOGLEVEL_DEBUG,
+		   "committing update transaction");
 
-		/*
-		 * Mark the zone as dirty so that it will be written to disk.
-		 */
-		dns_zone_markdirty(zone);
+	dns_db_closeversion(db, verp, true);
 
-		/*
-		 * Notify secondaries of the change we just made.
-		 */
-		dns_zone_notify(zone);
+	/*
+	 * Mark the zone as dirty so that it will be written to disk.
+	 */
+	dns_zone_markdirty(zone);
+
+	/*
+	 * Notify secondaries of the change we just made.
+	 */
+	dns_zone_notify(zone);
+
+	result = ISC_R_SUCCESS;
+
+failure:
+	return (result);
+}
+
+/*%
+ * Release the resources only needed while 'uev' is being processed and
+ * send the result back to the client's loop.
+ */
+static void
+update_done(update_t *uev, isc_result_t result) {
+	ns_client_t *client = uev->client;
+
+	if (uev->rules != NULL) {
+		isc_mem_cput(client->manager->mctx, uev->rules, uev->ruleslen,
+			     sizeof(*uev->rules));
+		uev->rules = NULL;
+	}
+
+	uev->result = result;
+	isc_async_run(client->manager->loop, updatedone_action, uev);
+}
+
+static void
+update_action(void *arg) {
+	update_t *uev = (update_t *)arg;
+	dns_zone_t *zone = uev->zone;
+	ns_client_t *client = uev->client;
+	isc_result_t result;
+	dns_db_t *db = NULL;
+	dns_dbversion_t *oldver = NULL;
+	dns_dbversion_t *ver = NULL;
+	dns_diff_t diff; /* Pending updates. */
+
+	dns_diff_init(client->manager->mctx, &diff);
+
+	CHECK(dns_zone_getdb(zone, &db));
+
+	/*
+	 * Get old and new versions now that queryacl has been checked.
+	 */
+	dns_db_currentversion(db, &oldver);
+	CHECK(dns_db_newversion(db, &ver));
+
+	CHECK(update_checkprereqs(uev, db, ver));
+	CHECK(update_apply(uev, db, oldver, ver, &diff));
+
+	/*
+	 * If any changes were made, write the update to the journal
+	 * and commit it.
+	 */
+	if (!ISC_LIST_EMPTY(diff.tuples)) {
+		CHECK(update_commit(client, zone, db, &ver, &diff));
 	} else {
 		update_log(client, zone, LOGLEVEL_DEBUG, "redundant request");
 		dns_db_closeversion(db, &ver, true);
 	}
 	result = ISC_R_SUCCESS;
-	goto common;
 
 failure:
 	/*
@@ -3447,8 +3546,6 @@ failure:
 		dns_db_closeversion(db, &ver, false);
 	}
 
-common:
-	dns_diff_clear(&temp);
 	dns_diff_clear(&diff);
 
 	if (oldver != NULL) {
@@ -3459,21 +3556,212 @@ common:
 		dns_db_detach(&db);
 	}
 
-	if (rules != NULL) {
-		isc_mem_cput(mctx, rules, ruleslen, sizeof(*rules));
+	update_done(uev, result);
+	INSIST(ver == NULL);
+}
+
+/*%
+ * Group commit.
+ *
+ * When a zone has an update commit window, updates that arrive within
+ * the window are queued and then applied one after another to a single
+ * new version of the zone database.  Each update still has its
+ * prerequisites checked against the zone as changed by the updates
+ * before it, and gets its own response, but the changes are written to
+ * the journal as a single transaction, so that the cost of writing and
+ * syncing the journal is shared between all of them.
+ *
+ * Zones that are DNSSEC signed, or are maintained by named, are always
+ * updated one request at a time, as the signing code works on the
+ * difference between the zone before and after each update.
+ */
+#define UPDATE_QUEUE_MAX 256
+
+typedef struct updatequeue {
+	isc_mem_t *mctx;
+	dns_zone_t *zone;
+	isc_timer_t *timer;
+	updatelist_t updates;
+	size_t count;
+} updatequeue_t;
+
+static bool
+update_groupable(dns_zone_t *zone, dns_db_t *db) {
+	bool is_inline = (!dns_zone_israw(zone) && dns_zone_issecure(zone));
+	bool is_maintain = ((dns_zone_getkeyopts(zone) &
+			     DNS_ZONEKEY_MAINTAIN) != 0);
+
+	return (dns_zone_getupdatewindow(zone) != 0 && !is_inline &&
+		!is_maintain && !dns_db_issecure(db));
+}
+
+/*%
+ * Throw away the changes made to version '*verp' of 'db' and open a new
+ * version containing only the changes in 'diff', to back out an update
+ * in a group that failed after it started changing the zone.
+ */
+static isc_result_t
+update_rollback(dns_db_t *db, dns_dbversion_t **verp, dns_diff_t *diff) {
+	isc_result_t result;
+
+	dns_db_closeversion(db, verp, false);
+	CHECK(dns_db_newversion(db, verp));
+	if (!ISC_LIST_EMPTY(diff->tuples)) {
+		CHECK(dns_diff_apply(diff, db, *verp));
 	}
 
-	if (ssutable != NULL) {
-		dns_ssutable_detach(&ssutable);
+failure:
+	return (result);
+}
+
+static void
+update_group(dns_zone_t *zone, updatelist_t *updates) {
+	isc_result_t result;
+	dns_db_t *db = NULL;
+	dns_dbversion_t *oldver = NULL;
+	dns_dbversion_t *ver = NULL;
+	dns_diff_t diff; /* Changes made by the updates in 'done'. */
+	updatelist_t done = ISC_LIST_INITIALIZER;
+	update_t *uev = NULL, *next = NULL;
+	ns_client_t *client = NULL;
+	size_t count = 0;
+
+	result = dns_zone_getdb(zone, &db);
+	if (result == ISC_R_SUCCESS && !update_groupable(zone, db)) {
+		/*
+		 * The zone has been reconfigured or signed since the
+		 * updates were queued.
+		 */
+		dns_db_detach(&db);
+		while ((uev = ISC_LIST_HEAD(*updates)) != NULL) {
+			ISC_LIST_UNLINK(*updates, uev, link);
+			update_action(uev);
+		}
+		return;
 	}
 
-	uev->result = result;
-	if (zone != NULL) {
-		INSIST(uev->zone == zone); /* we use this later */
+	dns_diff_init(dns_zone_getmctx(zone), &diff);
+
+	if (result == ISC_R_SUCCESS) {
+		dns_db_currentversion(db, &oldver);
+		result = dns_db_newversion(db, &ver);
 	}
 
-	isc_async_run(client->manager->loop, updatedone_action, uev);
-	INSIST(ver == NULL);
+	while (result == ISC_R_SUCCESS &&
+	       (uev = ISC_LIST_HEAD(*updates)) != NULL)
+	{
+		dns_diff_t udiff;
+		dns_difftuple_t *tuple = NULL;
+
+		ISC_LIST_UNLINK(*updates, uev, link);
+		ISC_LIST_APPEND(done, uev, link);
+
+		dns_diff_init(uev->client->manager->mctx, &udiff);
+
+		uev->result = update_checkprereqs(uev, db, ver);
+		if (uev->result == ISC_R_SUCCESS) {
+			uev->result = update_apply(uev, db, oldver, ver,
+						   &udiff);
+			if (uev->result != ISC_R_SUCCESS) {
+				update_log(uev->client, zone, LOGLEVEL_DEBUG,
+					   "rolling back");
+				result = update_rollback(db, &ver, &diff);
+			}
+		}
+
+		if (uev->result == ISC_R_SUCCESS) {
+			while ((tuple = ISC_LIST_HEAD(udiff.tuples)) != NULL) {
+				ISC_LIST_UNLINK(udiff.tuples, tuple, link);
+				dns_diff_appendminimal(&diff, &tuple);
+			}
+			client = uev->client;
+			count++;
+		}
+
+		dns_diff_clear(&udiff);
+	}
+
+	if (result == ISC_R_SUCCESS && !ISC_LIST_EMPTY(diff.tuples)) {
+		dns_zone_log(zone, ISC_LOG_DEBUG(3),
+			     "committing %zu dynamic updates", count);
+		result = update_commit(client, zone, db, &ver, &diff);
+	}
+
+	if (ver != NULL) {
+		dns_db_closeversion(db, &ver, result == ISC_R_SUCCESS);
+	}
+
+	dns_diff_clear(&diff);
+
+	if (oldver != NULL) {
+		dns_db_closeversion(db, &oldver, false);
+	}
+
+	if (db != NULL) {
+		dns_db_detach(&db);
+	}
+
+	/*
+	 * The updates that succeeded fail with the group if it could not
+	 * be committed; those not processed at all fail the same way.
+	 */
+	for (uev = ISC_LIST_HEAD(done); uev != NULL; uev = next) {
+		next = ISC_LIST_NEXT(uev, link);
+		ISC_LIST_UNLINK(done, uev, link);
+		update_done(uev, uev->result == ISC_R_SUCCESS ? result
+							      : uev->result);
+	}
+	while ((uev = ISC_LIST_HEAD(*updates)) != NULL) {
+		ISC_LIST_UNLINK(*updates, uev, link);
+		update_done(uev, result);
+	}
+}
+
+static void
+update_flush(void *arg) {
+	updatequeue_t *queue = (updatequeue_t *)arg;
+	dns_zone_t *zone = queue->zone;
+	updatelist_t updates = queue->updates;
+
+	dns_zone_setupdatequeue(zone, NULL);
+
+	isc_timer_stop(queue->timer);
+	isc_timer_destroy(&queue->timer);
+	isc_mem_putanddetach(&queue->mctx, queue, sizeof(*queue));
+
+	update_group(zone, &updates);
+}
+
+static void
+update_enqueue(void *arg) {
+	update_t *uev = (update_t *)arg;
+	dns_zone_t *zone = uev->zone;
+	updatequeue_t *queue = dns_zone_getupdatequeue(zone);
+
+	if (queue == NULL) {
+		uint32_t window = dns_zone_getupdatewindow(zone);
+		isc_interval_t interval;
+
+		queue = isc_mem_get(dns_zone_getmctx(zone), sizeof(*queue));
+		*queue = (updatequeue_t){
+			.zone = zone,
+			.updates = ISC_LIST_INITIALIZER,
+		};
+		isc_mem_attach(dns_zone_getmctx(zone), &queue->mctx);
+
+		isc_interval_set(&interval, window / MS_PER_SEC,
+				 (window % MS_PER_SEC) * NS_PER_MS);
+		isc_timer_create(dns_zone_getloop(zone), update_flush, queue,
+				 &queue->timer);
+		isc_timer_start(queue->timer, isc_timertype_once, &interval);
+
+		dns_zone_setupdatequeue(zone, queue);
+	}
+
+	ISC_LIST_APPEND(queue->updates, uev, link);
+	if (++queue->count >= UPDATE_QUEUE_MAX) {
+		update_flush(queue);
+	}
 }
 
 static void
@@ -222,16 +222,21 @@ ixfr_rrstream_destroy(rrstream_t **sp);
 static rrstream_methods_t ixfr_rrstream_methods;
 
 /*
+ * The journal is read from the zone's shared, memory mapped snapshot
+ * if there is one, so that concurrent IXFRs do not each have to find
+ * their way through the journal file; otherwise it is opened normally.
+ *
  * Returns: anything dns_journal_open() or dns_journal_iter_init()
  * may return.
  */
 
 static isc_result_t
-ixfr_rrstream_create(isc_mem_t *mctx, const char *journal_filename,
-		     uint32_t begin_serial, uint32_t end_serial, size_t *sizep,
-		     rrstream_t **sp) {
+ixfr_rrstream_create(isc_mem_t *mctx, dns_zone_t *zone,
+		     const char *journal_filename, uint32_t begin_serial,
+		     uint32_t end_serial, size_t *sizep, rrstream_t **sp) {
 	isc_result_t result;
 	ixfr_rrstream_t *s = NULL;
+	dns_journalmap_t *map = NULL;
 
 	INSIST(sp != NULL && *sp == NULL);
 
@@ -241,8 +246,14 @@ ixfr_rrstream_create(isc_mem_t *mctx, const char *journal_filename,
 	s->common.methods = &ixfr_rrstream_methods;
 	s->journal = NULL;
 
-	CHECK(dns_journal_open(mctx, journal_filename, DNS_JOURNAL_READ,
-			       &s->journal));
+	if (dns_zone_getjournalmap(zone, &map) == ISC_R_SUCCESS) {
+		result = dns_journal_openmap(mctx, map, &s->journal);
+		dns_journalmap_detach(&map);
+		CHECK(result);
+	} else {
+		CHECK(dns_journal_open(mctx, journal_filename,
+				       DNS_JOURNAL_READ, &s->journal));
+	}
 	CHECK(dns_journal_iter_init(s->journal, begin_serial, end_serial,
 				    sizep));
 
@@ -1019,8 +1030,8 @@ got_soa:
 		journalfile = is_dlz ? NULL : dns_zone_getjournal(zone);
 		if (journalfile != NULL) {
 			result = ixfr_rrstream_create(
-				mctx, journalfile, begin_serial, current_serial,
-				&jsize, &data_stream);
+				mctx, zone, journalfile, begin_serial,
+				current_serial, &jsize, &data_stream);
 		} else {
 			result = ISC_R_NOTFOUND;
 		}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * Throughput of the base64, base32hex and hex encoders and decoders with
+ * each of the instruction sets supported by this CPU.  The data is
+ * encoded in 256 byte chunks, about the size of an RSA signature, with
+ * the line length used when printing zone files.
+ *
+ * Usage: codecs [megabytes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <isc/base32.h>
+#include <isc/base64.h>
+#include <isc/buffer.h>
+#include <isc/hex.h>
+#include <isc/mem.h>
+#include <isc/random.h>
+#include <isc/simd.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#define CHUNK	   256
+#define TEXT	   (3 * CHUNK)
+#define WORDLENGTH 44
+
+typedef isc_result_t
+totext_fn(isc_region_t *source, int wordlength, const char *wordbreak,
+	  isc_buffer_t *target);
+
+typedef isc_result_t
+decode_fn(const char *cstr, isc_buffer_t *target);
+
+static const struct {
+	const char *name;
+	totext_fn *totext;
+	decode_fn *decode;
+} codecs[] = {
+	{ "base64", isc_base64_totext, isc_base64_decodestring },
+	{ "base32hex", isc_base32hex_totext, isc_base32hex_decodestring },
+	{ "hex", isc_hex_totext, isc_hex_decodestring },
+};
+
+static isc_mem_t *mctx = NULL;
+static size_t chunks = 4096;
+static unsigned char *data = NULL;
+static char *text = NULL;
+
+static void
+report(const char *codec, isc_simd_t simd, const char *op,
+       isc_nanosecs_t start) {
+	isc_nanosecs_t elapsed = isc_time_monotonic() - start;
+
+	printf("%-10s %-7s %-7s %zu bytes / %f ms; %f MB/s\n", codec,
+	       isc_simd_totext(simd), op, chunks * CHUNK,
+	       (double)elapsed / NS_PER_MS,
+	       (double)(chunks * CHUNK) * NS_PER_SEC / elapsed / 1000000);
+}
+
+static void
+bench(size_t c, isc_simd_t simd) {
+	isc_nanosecs_t start;
+	unsigned char out[CHUNK];
+	isc_buffer_t b;
+
+	isc_simd_set(simd);
+
+	start = isc_time_monotonic();
+	for (size_t i = 0; i < chunks; i++) {
+		isc_region_t r = { .base = data + i * CHUNK, .length = CHUNK };
+
+		isc_buffer_init(&b, text + i * TEXT, TEXT - 1);
+		RUNTIME_CHECK(codecs[c].totext(&r, WORDLENGTH, " ", &b) ==
+			      ISC_R_SUCCESS);
+		text[i * TEXT + isc_buffer_usedlength(&b)] = '\0';
+	}
+	report(codecs[c].name, simd, "encode", start);
+
+	start = isc_time_monotonic();
+	for (size_t i = 0; i < chunks; i++) {
+		isc_buffer_init(&b, out, sizeof(out));
+		RUNTIME_CHECK(codecs[c].decode(text + i * TEXT, &b) ==
+			      ISC_R_SUCCESS);
+		INSIST(isc_buffer_usedlength(&b) == CHUNK);
+	}
+	report(codecs[c].name, simd, "decode", start);
+}
+
+int
+main(int argc, char *argv[]) {
+	if (argc > 1) {
+		chunks = atoi(argv[1]) * 1024 * 1024 / CHUNK;
+		if (chunks == 0) {
+			fprintf(stderr, "usage: codecs [megabytes]\n");
+			return (EXIT_FAILURE);
+		}
+	}
+
+	setlinebuf(stdout);
+
+	isc_mem_create(&mctx);
+	data = isc_mem_get(mctx, chunks * CHUNK);
+	text = isc_mem_get(mctx, chunks * TEXT);
+	isc_random_buf(data, chunks * CHUNK);
+
+	for (size_t c = 0; c < ARRAY_SIZE(codecs); c++) {
+		for (isc_simd_t simd = isc_simd_none;
+		     simd <= isc_simd_supported(); simd++)
+		{
+			bench(c, simd);
+		}
+	}
+
+	isc_mem_put(mctx, text, chunks * TEXT);
+	isc_mem_put(mctx, data, chunks * CHUNK);
+	isc_mem_destroy(&mctx);
+
+	return (EXIT_SUCCESS);
+}
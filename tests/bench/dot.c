@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * DNS-over-TLS throughput over loopback, first with the record layer
+ * handled by OpenSSL and then with kernel TLS enabled on the server.
+ * A single client keeps a fixed number of queries in flight and the
+ * server answers each with a fixed size response.
+ *
+ * Usage: dot [port]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <isc/async.h>
+#include <isc/loop.h>
+#include <isc/managers.h>
+#include <isc/mem.h>
+#include <isc/netmgr.h>
+#include <isc/sockaddr.h>
+#include <isc/time.h>
+#include <isc/tls.h>
+#include <isc/util.h>
+
+#define QUERIES	       100000
+#define INFLIGHT       16
+#define QUERYSIZE      40
+#define RESPONSESIZE   1232
+#define CONNECTTIMEOUT 5000
+
+static isc_mem_t *mctx = NULL;
+static isc_loopmgr_t *loopmgr = NULL;
+static isc_nm_t *netmgr = NULL;
+
+static isc_tlsctx_t *server_tlsctx = NULL;
+static isc_tlsctx_t *client_tlsctx = NULL;
+static isc_nmsocket_t *listen_sock = NULL;
+static isc_nmhandle_t *client_handle = NULL;
+static in_port_t port = 8853;
+
+static const char *phases[] = { "OpenSSL", "kernel TLS" };
+static unsigned int phase = 0;
+static unsigned int nsent, nrecv;
+static isc_time_t start;
+
+static uint8_t query[QUERYSIZE];
+static uint8_t response[RESPONSESIZE];
+
+static void
+start_phase(void *arg);
+
+static void
+senddone(isc_nmhandle_t *handle, isc_result_t result, void *cbarg) {
+	UNUSED(result);
+	UNUSED(cbarg);
+
+	isc_nmhandle_detach(&handle);
+}
+
+static void
+send_msg(isc_nmhandle_t *handle, uint8_t *data, size_t length) {
+	isc_nmhandle_t *sendhandle = NULL;
+
+	isc_nmhandle_attach(handle, &sendhandle);
+	isc_nm_send(sendhandle, &(isc_region_t){ data, length }, senddone,
+		    NULL);
+}
+
+static void
+server_recv(isc_nmhandle_t *handle, isc_result_t result, isc_region_t *region,
+	    void *cbarg) {
+	UNUSED(region);
+	UNUSED(cbarg);
+
+	if (result != ISC_R_SUCCESS) {
+		isc_nmhandle_detach(&handle);
+		return;
+	}
+
+	send_msg(handle, response, sizeof(response));
+}
+
+static isc_result_t
+server_accept(isc_nmhandle_t *handle, isc_result_t result, void *cbarg) {
+	UNUSED(cbarg);
+
+	if (result == ISC_R_SUCCESS) {
+		/* Detached in server_recv() when the connection ends */
+		isc_nmhandle_attach(handle, &(isc_nmhandle_t *){ NULL });
+	}
+
+	return (result);
+}
+
+static void
+finish_phase(void) {
+	isc_time_t now = isc_time_now_hires();
+	double us = (double)isc_time_microdiff(&now, &start);
+
+	printf("%-10s %u queries / %f ms; %f queries/s; %f MB/s\n",
+	       phases[phase], nrecv, us / 1000.0, nrecv / (us / 1000000.0),
+	       (double)nrecv * RESPONSESIZE / us);
+
+	isc_nm_read_stop(client_handle);
+	isc_nmhandle_detach(&client_handle);
+
+	isc_nm_stoplistening(listen_sock);
+	isc_nmsocket_close(&listen_sock);
+
+	phase++;
+	if (phase < ARRAY_SIZE(phases)) {
+		isc_async_current(loopmgr, start_phase, NULL);
+	} else {
+		isc_loopmgr_shutdown(loopmgr);
+	}
+}
+
+static void
+client_recv(isc_nmhandle_t *handle, isc_result_t result, isc_region_t *region,
+	    void *cbarg) {
+	UNUSED(cbarg);
+
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "read failed: %s\n", isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+
+	INSIST(region->length == RESPONSESIZE);
+
+	nrecv++;
+	if (nsent < QUERIES) {
+		nsent++;
+		send_msg(handle, query, sizeof(query));
+	} else if (nrecv == QUERIES) {
+		finish_phase();
+	}
+}
+
+static void
+client_connect(isc_nmhandle_t *handle, isc_result_t result, void *cbarg) {
+	UNUSED(cbarg);
+
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "connect failed: %s\n",
+			isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+
+	isc_nmhandle_attach(handle, &client_handle);
+	isc_nm_read(handle, client_recv, NULL);
+
+	start = isc_time_now_hires();
+	for (unsigned int i = 0; i < INFLIGHT; i++) {
+		nsent++;
+		send_msg(handle, query, sizeof(query));
+	}
+}
+
+static void
+start_phase(void *arg) {
+	isc_sockaddr_t server_addr, client_addr;
+	struct in_addr in = { .s_addr = htonl(INADDR_LOOPBACK) };
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	if (server_tlsctx != NULL) {
+		isc_tlsctx_free(&server_tlsctx);
+	}
+	RUNTIME_CHECK(isc_tlsctx_createserver(NULL, NULL, &server_tlsctx) ==
+		      ISC_R_SUCCESS);
+	isc_tlsctx_enable_dot_server_alpn(server_tlsctx);
+	if (phase == 1) {
+		isc_tlsctx_enable_ktls(server_tlsctx);
+	}
+
+	isc_sockaddr_fromin(&server_addr, &in, port + phase);
+	isc_sockaddr_fromin(&client_addr, &in, 0);
+
+	result = isc_nm_listenstreamdns(netmgr, ISC_NM_LISTEN_ONE,
+					&server_addr, server_recv, NULL,
+					server_accept, NULL, 128, NULL,
+					server_tlsctx, &listen_sock);
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "listen failed: %s\n",
+			isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+
+	nsent = nrecv = 0;
+	isc_nm_streamdnsconnect(netmgr, &client_addr, &server_addr,
+				client_connect, NULL, CONNECTTIMEOUT,
+				client_tlsctx, NULL);
+}
+
+int
+main(int argc, char *argv[]) {
+	if (argc > 1) {
+		port = atoi(argv[1]);
+	}
+
+	setlinebuf(stdout);
+
+	memset(query, 0x5a, sizeof(query));
+	memset(response, 0xa5, sizeof(response));
+
+	isc_managers_create(&mctx, 1, &loopmgr, &netmgr);
+
+	RUNTIME_CHECK(isc_tlsctx_createclient(&client_tlsctx) ==
+		      ISC_R_SUCCESS);
+	isc_tlsctx_enable_dot_client_alpn(client_tlsctx);
+
+	isc_loop_setup(isc_loop_main(loopmgr), start_phase, NULL);
+	isc_loopmgr_run(loopmgr);
+
+	isc_tlsctx_free(&server_tlsctx);
+	isc_tlsctx_free(&client_tlsctx);
+	isc_managers_destroy(&mctx, &loopmgr, &netmgr);
+
+	return (EXIT_SUCCESS);
+}
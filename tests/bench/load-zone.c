@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * Zone file loading speed.  Tokenizes the zone file through the
+ * character-at-a-time stream path and the block-scanning file path of
+ * the lexer, then loads it into a zone database the way named would,
+ * and reports the throughput of each.
+ *
+ * Usage: load-zone <zonefile> <origin>
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <isc/file.h>
+#include <isc/lex.h>
+#include <isc/mem.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/db.h>
+#include <dns/fixedname.h>
+#include <dns/master.h>
+#include <dns/name.h>
+
+static isc_mem_t *mctx = NULL;
+static off_t size = 0;
+
+static void
+report(const char *what, isc_nanosecs_t start) {
+	isc_nanosecs_t elapsed = isc_time_monotonic() - start;
+
+	printf("%-10s %jd bytes / %f ms; %f MB/s\n", what, (intmax_t)size,
+	       (double)elapsed / NS_PER_MS,
+	       (double)size * NS_PER_SEC / elapsed / 1000000);
+}
+
+static size_t
+tokenize(const char *filename, bool stream) {
+	isc_lexspecials_t specials;
+	isc_lex_t *lex = NULL;
+	isc_token_t token;
+	isc_nanosecs_t start;
+	isc_result_t result;
+	FILE *fp = NULL;
+	size_t tokens = 0;
+	unsigned int options = ISC_LEXOPT_INITIALWS | ISC_LEXOPT_EOL |
+			       ISC_LEXOPT_EOF | ISC_LEXOPT_DNSMULTILINE |
+			       ISC_LEXOPT_ESCAPE | ISC_LEXOPT_QSTRING;
+
+	/*
+	 * Same settings as the master file loader.
+	 */
+	isc_lex_create(mctx, 1024, &lex);
+	memset(specials, 0, sizeof(specials));
+	specials[0] = 1;
+	specials['('] = 1;
+	specials[')'] = 1;
+	specials['"'] = 1;
+	isc_lex_setspecials(lex, specials);
+	isc_lex_setcomments(lex, ISC_LEXCOMMENT_DNSMASTERFILE);
+
+	start = isc_time_monotonic();
+	if (stream) {
+		fp = fopen(filename, "r");
+		RUNTIME_CHECK(fp != NULL);
+		result = isc_lex_openstream(lex, fp);
+	} else {
+		result = isc_lex_openfile(lex, filename);
+	}
+	RUNTIME_CHECK(result == ISC_R_SUCCESS);
+
+	do {
+		result = isc_lex_gettoken(lex, options, &token);
+		if (result != ISC_R_SUCCESS) {
+			fprintf(stderr, "%s:%lu: %s\n", filename,
+				isc_lex_getsourceline(lex),
+				isc_result_totext(result));
+			exit(EXIT_FAILURE);
+		}
+		tokens++;
+	} while (token.type != isc_tokentype_eof);
+
+	isc_lex_destroy(&lex);
+	if (fp != NULL) {
+		fclose(fp);
+	}
+	report(stream ? "stream" : "file", start);
+
+	return (tokens);
+}
+
+static void
+load(const char *filename, const dns_name_t *origin) {
+	dns_db_t *db = NULL;
+	isc_nanosecs_t start;
+	isc_result_t result;
+	size_t before;
+
+	before = isc_mem_inuse(mctx);
+	start = isc_time_monotonic();
+	result = dns_db_create(mctx, "rbt", origin, dns_dbtype_zone,
+			       dns_rdataclass_in, 0, NULL, &db);
+	RUNTIME_CHECK(result == ISC_R_SUCCESS);
+	result = dns_db_load(db, filename, dns_masterformat_text,
+			     DNS_MASTER_ZONE);
+	if (result != ISC_R_SUCCESS && result != DNS_R_SEENINCLUDE) {
+		fprintf(stderr, "%s: %s\n", filename,
+			isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+	report("load", start);
+	printf("%-10s %zu bytes\n", "memory", isc_mem_inuse(mctx) - before);
+
+	dns_db_detach(&db);
+}
+
+int
+main(int argc, char *argv[]) {
+	dns_fixedname_t fixed;
+	dns_name_t *origin = dns_fixedname_initname(&fixed);
+	isc_result_t result;
+	size_t tokens;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: load-zone <zonefile> <origin>\n");
+		return (EXIT_FAILURE);
+	}
+
+	result = isc_file_getsize(argv[1], &size);
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "%s: %s\n", argv[1], isc_result_totext(result));
+		return (EXIT_FAILURE);
+	}
+	if (size == 0) {
+		fprintf(stderr, "%s: empty file\n", argv[1]);
+		return (EXIT_FAILURE);
+	}
+
+	result = dns_name_fromstring(origin, argv[2], dns_rootname, 0, NULL);
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "%s: %s\n", argv[2], isc_result_totext(result));
+		return (EXIT_FAILURE);
+	}
+
+	setlinebuf(stdout);
+
+	isc_mem_create(&mctx);
+
+	tokens = tokenize(argv[1], true);
+	RUNTIME_CHECK(tokenize(argv[1], false) == tokens);
+	printf("%-10s %zu\n", "tokens", tokens);
+	load(argv[1], origin);
+
+	isc_mem_destroy(&mctx);
+
+	return (EXIT_SUCCESS);
+}
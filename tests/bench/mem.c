@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * Multithreaded allocation throughput on a single memory context shared
+ * by all loops, like the cache context in named.  Every loop repeatedly
+ * allocates a batch of blocks of assorted sizes and frees them again;
+ * this is run with a single shared accounting counter, with per-loop
+ * accounting shards, with per-loop jemalloc arenas, and with both.
+ *
+ * Usage: mem [loops]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/atomic.h>
+#include <isc/loop.h>
+#include <isc/mem.h>
+#include <isc/os.h>
+#include <isc/random.h>
+#include <isc/tid.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#define ROUNDS	  2000
+#define ITEMS	  1024
+#define MIN_SIZE  16
+#define MAX_SIZE  1024
+#define MAX_LOOPS 256
+
+static const struct {
+	const char *name;
+	unsigned int flags;
+} modes[] = {
+	{ "shared", 0 },
+	{ "sharded", ISC_MEMFLAG_SHARDED },
+	{ "looparenas", ISC_MEMFLAG_LOOPARENAS },
+	{ "both", ISC_MEMFLAG_SHARDED | ISC_MEMFLAG_LOOPARENAS },
+};
+
+static isc_mem_t *mctx = NULL;
+static isc_loopmgr_t *loopmgr = NULL;
+static uint32_t nloops = 0;
+
+static size_t sizes[ITEMS];
+static isc_nanosecs_t elapsed[MAX_LOOPS];
+static atomic_uint_fast32_t running;
+
+static void
+run(void *arg) {
+	void **items = NULL;
+	isc_nanosecs_t start;
+
+	UNUSED(arg);
+
+	items = malloc(ITEMS * sizeof(items[0]));
+	RUNTIME_CHECK(items != NULL);
+
+	start = isc_time_monotonic();
+	for (size_t round = 0; round < ROUNDS; round++) {
+		for (size_t i = 0; i < ITEMS; i++) {
+			items[i] = isc_mem_get(mctx, sizes[i]);
+		}
+		for (size_t i = 0; i < ITEMS; i++) {
+			isc_mem_put(mctx, items[i], sizes[i]);
+		}
+	}
+	elapsed[isc_tid()] = isc_time_monotonic() - start;
+
+	free(items);
+
+	if (atomic_fetch_sub(&running, 1) == 1) {
+		isc_loopmgr_shutdown(loopmgr);
+	}
+}
+
+static void
+bench(isc_mem_t *lmctx, size_t mode) {
+	unsigned int defaultflags = isc_mem_defaultflags;
+	isc_nanosecs_t slowest = 0;
+	uint64_t ops = (uint64_t)nloops * ROUNDS * ITEMS;
+
+	/*
+	 * The flags have to be in place when the context is created and
+	 * when the loop threads start.
+	 */
+	isc_mem_defaultflags |= modes[mode].flags;
+	isc_mem_create(&mctx);
+	isc_loopmgr_create(lmctx, nloops, &loopmgr);
+	isc_mem_defaultflags = defaultflags;
+
+	atomic_store(&running, nloops);
+	isc_loopmgr_setup(loopmgr, run, NULL);
+	isc_loopmgr_run(loopmgr);
+	isc_loopmgr_destroy(&loopmgr);
+
+	INSIST(isc_mem_inuse(mctx) == 0);
+	isc_mem_destroy(&mctx);
+
+	for (uint32_t i = 0; i < nloops; i++) {
+		slowest = ISC_MAX(slowest, elapsed[i]);
+	}
+
+	printf("%-10s %u loops %" PRIu64 " get/put pairs / %f ms; "
+	       "%f ns per pair per loop; %f pairs/s\n",
+	       modes[mode].name, nloops, ops, (double)slowest / NS_PER_MS,
+	       (double)slowest * nloops / ops,
+	       ops / ((double)slowest / NS_PER_SEC));
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_t *lmctx = NULL;
+
+	nloops = isc_os_ncpus();
+	if (argc > 1) {
+		nloops = atoi(argv[1]);
+	}
+	if (nloops == 0 || nloops > MAX_LOOPS) {
+		fprintf(stderr, "usage: mem [loops]\n");
+		return (EXIT_FAILURE);
+	}
+
+	setlinebuf(stdout);
+
+	for (size_t i = 0; i < ITEMS; i++) {
+		sizes[i] = MIN_SIZE + isc_random_uniform(MAX_SIZE - MIN_SIZE);
+	}
+
+	isc_mem_create(&lmctx);
+	for (size_t mode = 0; mode < ARRAY_SIZE(modes); mode++) {
+		bench(lmctx, mode);
+	}
+	isc_mem_destroy(&lmctx);
+
+	return (EXIT_SUCCESS);
+}
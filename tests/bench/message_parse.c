@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * Compare full and lazy dns_message_parse() on a corpus of captured
+ * messages, by default the fuzzer's dns_message_parse corpus.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <isc/buffer.h>
+#include <isc/dir.h>
+#include <isc/mem.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/message.h>
+
+#define ROUNDS	 1000
+#define MAXMSGS	 4096
+#define MAXMSGSZ 65535
+
+typedef struct packet {
+	uint8_t *data;
+	size_t size;
+} packet_t;
+
+static isc_mem_t *mctx = NULL;
+static packet_t packets[MAXMSGS];
+static unsigned int npackets = 0;
+
+static void
+load_file(const char *dirname, const char *filename) {
+	char path[PATH_MAX];
+	uint8_t buf[MAXMSGSZ];
+	FILE *fp = NULL;
+	size_t n;
+
+	if (npackets == MAXMSGS) {
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", dirname, filename);
+	fp = fopen(path, "rb");
+	if (fp == NULL) {
+		return;
+	}
+	n = fread(buf, 1, sizeof(buf), fp);
+	fclose(fp);
+	if (n == 0) {
+		return;
+	}
+
+	packets[npackets].data = isc_mem_get(mctx, n);
+	packets[npackets].size = n;
+	memmove(packets[npackets].data, buf, n);
+	npackets++;
+}
+
+static void
+load_corpus(const char *dirname) {
+	isc_dir_t dir;
+	isc_result_t result;
+
+	isc_dir_init(&dir);
+	result = isc_dir_open(&dir, dirname);
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "%s: %s\n", dirname, isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+	while (isc_dir_read(&dir) == ISC_R_SUCCESS) {
+		if (dir.entry.name[0] == '.') {
+			continue;
+		}
+		load_file(dirname, dir.entry.name);
+	}
+	isc_dir_close(&dir);
+}
+
+static void
+parse_bench(const char *label, unsigned int options) {
+	dns_message_t *msg = NULL;
+	unsigned int ok = 0, deferred = 0;
+	isc_time_t t0, t1;
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTPARSE, &msg);
+
+	t0 = isc_time_now_hires();
+	for (unsigned int round = 0; round < ROUNDS; round++) {
+		for (unsigned int i = 0; i < npackets; i++) {
+			isc_buffer_t source;
+			isc_result_t result;
+
+			isc_buffer_constinit(&source, packets[i].data,
+					     packets[i].size);
+			isc_buffer_add(&source, packets[i].size);
+
+			result = dns_message_parse(msg, &source, options);
+			if (result == ISC_R_SUCCESS) {
+				ok++;
+			}
+			if (msg->lazy_pending != 0) {
+				deferred++;
+			}
+			dns_message_reset(msg, DNS_MESSAGE_INTENTPARSE);
+		}
+	}
+	t1 = isc_time_now_hires();
+
+	dns_message_detach(&msg);
+
+	double us = (double)isc_time_microdiff(&t1, &t0);
+	unsigned int total = ROUNDS * npackets;
+	printf("  %-5s %u parsed (%u ok, %u deferred) / %f ms; %f / us\n",
+	       label, total, ok, deferred, us / 1000.0, total / us);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_mem_create(&mctx);
+
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++) {
+			load_corpus(argv[i]);
+		}
+	} else {
+		load_corpus(FUZZDIR "/dns_message_parse.in");
+	}
+
+	printf("%u messages x %u rounds\n", npackets, ROUNDS);
+	if (npackets == 0) {
+		return (EXIT_FAILURE);
+	}
+
+	parse_bench("full", 0);
+	parse_bench("lazy", DNS_MESSAGEPARSE_LAZY);
+
+	for (unsigned int i = 0; i < npackets; i++) {
+		isc_mem_put(mctx, packets[i].data, packets[i].size);
+	}
+	isc_mem_destroy(&mctx);
+
+	return (EXIT_SUCCESS);
+}
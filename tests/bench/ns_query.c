@@ -0,0 +1,771 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * End-to-end query processing speed, without a network.  Serves a zone
+ * file as an authoritative zone, or with -c loads it into the cache,
+ * and feeds a list of queries through ns_client_request() on every
+ * loop.  The network manager handles that libns sees are replaced by a
+ * fake UDP transport that answers from memory, in the same way as
+ * tests/ns/netmgr_wrap.c does for the unit tests.
+ *
+ * Reports the throughput, the time spent in each stage of processing a
+ * query (from the request to the NS_QUERY_SETUP hook, from there to
+ * NS_QUERY_DONE_SEND, rendering and sending, and cleaning up), the
+ * response codes, and, when built with jemalloc, the memory allocated
+ * per query.
+ *
+ * The query file has one "name type" pair per line, as for dnsperf.
+ *
+ * Usage: ns_query [-c] [-l loops] [-n queries] <zonefile> <origin> <queryfile>
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <isc/async.h>
+#include <isc/job.h>
+#include <isc/loop.h>
+#include <isc/managers.h>
+#include <isc/mem.h>
+#include <isc/netmgr.h>
+#include <isc/os.h>
+#include <isc/refcount.h>
+#include <isc/sockaddr.h>
+#include <isc/tid.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#include <dns/cache.h>
+#include <dns/callbacks.h>
+#include <dns/db.h>
+#include <dns/dispatch.h>
+#include <dns/fixedname.h>
+#include <dns/master.h>
+#include <dns/masterdump.h>
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/rcode.h>
+#include <dns/rdatatype.h>
+#include <dns/view.h>
+#include <dns/zone.h>
+
+#include <ns/client.h>
+#include <ns/hooks.h>
+#include <ns/interfacemgr.h>
+#include <ns/server.h>
+
+#ifdef HAVE_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#endif /* HAVE_JEMALLOC */
+
+#define DEFAULT_QUERIES 1000000 /* per loop */
+#define BATCH		1000	/* queries between yields to the loop */
+#define QUERY_MAXSIZE	512
+
+#define HANDLE_MAGIC	ISC_MAGIC('B', 'n', 'c', 'H')
+#define VALID_HANDLE(h) ISC_MAGIC_VALID(h, HANDLE_MAGIC)
+
+typedef struct query {
+	unsigned char wire[QUERY_MAXSIZE];
+	unsigned int length;
+} query_t;
+
+typedef struct bench_loop bench_loop_t;
+
+/*
+ * The fake transport: handles are kept on a per-loop list when they
+ * are released, together with the client attached to them, so that
+ * they are reused the way the network manager reuses UDP handles.
+ */
+struct isc_nmhandle {
+	unsigned int magic;
+	isc_refcount_t references;
+	bench_loop_t *bl;
+	void *opaque;
+	isc_nm_opaquecb_t doreset;
+	isc_nm_opaquecb_t dofree;
+	ISC_LINK(isc_nmhandle_t) link;
+};
+
+struct bench_loop {
+	isc_loop_t *loop;
+	isc_job_t job;
+	ISC_LIST(isc_nmhandle_t) inactive;
+	isc_sockaddr_t peer;
+	size_t next;
+	uint64_t sent;
+
+	/* Timestamps for the query in progress */
+	isc_nanosecs_t tstart;
+	isc_nanosecs_t tsetup;
+	isc_nanosecs_t tdone;
+	isc_nanosecs_t tsent;
+
+	/* Results */
+	isc_nanosecs_t request;
+	isc_nanosecs_t query;
+	isc_nanosecs_t render;
+	isc_nanosecs_t cleanup;
+	uint64_t hooked;
+	uint64_t responses;
+	uint64_t bytes;
+	uint64_t pending;
+	uint64_t rcodes[16];
+	uint64_t allocated;
+};
+
+static isc_mem_t *mctx = NULL;
+static isc_loopmgr_t *loopmgr = NULL;
+static isc_nm_t *netmgr = NULL;
+
+static dns_dispatchmgr_t *dispatchmgr = NULL;
+static ns_interfacemgr_t *interfacemgr = NULL;
+static ns_server_t *sctx = NULL;
+static ns_interface_t interface;
+static dns_zonemgr_t *zonemgr = NULL;
+static dns_zone_t *zone = NULL;
+static dns_view_t *view = NULL;
+
+static const char *zonefile = NULL;
+static dns_fixedname_t fixedorigin;
+static dns_name_t *origin = NULL;
+static bool usecache = false;
+
+static query_t *queries = NULL;
+static size_t nqueries = 0;
+static uint64_t count = DEFAULT_QUERIES;
+
+static uint32_t nloops = 0;
+static bench_loop_t *loops = NULL;
+static uint32_t finished = 0;
+static isc_nanosecs_t start;
+
+/*
+ * Fake network manager functions; libns calls these rather than the
+ * ones in libisc.
+ */
+
+static void
+handle_destroy(isc_nmhandle_t *handle) {
+	bench_loop_t *bl = handle->bl;
+
+	if (handle->doreset != NULL) {
+		handle->doreset(handle->opaque);
+	}
+	ISC_LIST_APPEND(bl->inactive, handle, link);
+}
+
+#if ISC_NETMGR_TRACE
+ISC_REFCOUNT_TRACE_IMPL(isc_nmhandle, handle_destroy);
+#else
+ISC_REFCOUNT_IMPL(isc_nmhandle, handle_destroy);
+#endif
+
+void *
+isc_nmhandle_getdata(isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	return (handle->opaque);
+}
+
+void
+isc_nmhandle_setdata(isc_nmhandle_t *handle, void *arg,
+		     isc_nm_opaquecb_t doreset, isc_nm_opaquecb_t dofree) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	handle->opaque = arg;
+	handle->doreset = doreset;
+	handle->dofree = dofree;
+}
+
+bool
+isc_nmhandle_is_stream(isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	return (false);
+}
+
+isc_sockaddr_t
+isc_nmhandle_peeraddr(isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	return (handle->bl->peer);
+}
+
+isc_sockaddr_t
+isc_nmhandle_localaddr(isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	return (interface.addr);
+}
+
+isc_nmsocket_type
+isc_nm_socket_type(const isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	return (isc_nm_udpsocket);
+}
+
+bool
+isc_nm_has_encryption(const isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	return (false);
+}
+
+bool
+isc_nm_is_http_handle(isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	return (false);
+}
+
+void
+isc_nm_bad_request(isc_nmhandle_t *handle) {
+	REQUIRE(VALID_HANDLE(handle));
+}
+
+void
+isc_nm_send(isc_nmhandle_t *handle, isc_region_t *region, isc_nm_cb_t cb,
+	    void *cbarg) {
+	REQUIRE(VALID_HANDLE(handle));
+
+	bench_loop_t *bl = handle->bl;
+
+	bl->tsent = isc_time_monotonic();
+	bl->responses++;
+	bl->bytes += region->length;
+	if (region->length >= 4) {
+		bl->rcodes[region->base[3] & 0x0f]++;
+	}
+
+	cb(handle, ISC_R_SUCCESS, cbarg);
+}
+
+/*
+ * Hooks marking the start and end of query processing.
+ */
+
+static ns_hookresult_t
+hook_setup(void *arg, void *data, isc_result_t *resultp) {
+	UNUSED(arg);
+	UNUSED(data);
+	UNUSED(resultp);
+
+	loops[isc_tid()].tsetup = isc_time_monotonic();
+	return (NS_HOOK_CONTINUE);
+}
+
+static ns_hookresult_t
+hook_done(void *arg, void *data, isc_result_t *resultp) {
+	UNUSED(arg);
+	UNUSED(data);
+	UNUSED(resultp);
+
+	loops[isc_tid()].tdone = isc_time_monotonic();
+	return (NS_HOOK_CONTINUE);
+}
+
+static isc_result_t
+matchview(isc_netaddr_t *srcaddr, isc_netaddr_t *destaddr,
+	  dns_message_t *message, dns_aclenv_t *env, isc_result_t *sigresultp,
+	  dns_view_t **viewp) {
+	UNUSED(srcaddr);
+	UNUSED(destaddr);
+	UNUSED(env);
+	UNUSED(sigresultp);
+
+	if (message->rdclass != view->rdclass) {
+		return (ISC_R_NOTFOUND);
+	}
+
+	dns_view_attach(view, viewp);
+	return (ISC_R_SUCCESS);
+}
+
+static uint64_t
+allocated(void) {
+#ifdef HAVE_JEMALLOC
+	uint64_t *allocatedp = NULL;
+	size_t len = sizeof(allocatedp);
+
+	if (mallctl("thread.allocatedp", &allocatedp, &len, NULL, 0) == 0) {
+		return (*allocatedp);
+	}
+#endif /* HAVE_JEMALLOC */
+	return (0);
+}
+
+static void
+load_queries(const char *filename) {
+	char line[1024];
+	size_t lineno = 0, size = 1024;
+	FILE *fp = NULL;
+
+	fp = fopen(filename, "r");
+	if (fp == NULL) {
+		perror(filename);
+		exit(EXIT_FAILURE);
+	}
+
+	queries = isc_mem_cget(mctx, size, sizeof(queries[0]));
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		dns_name_t *qname = NULL;
+		dns_message_t *message = NULL;
+		dns_rdataset_t *question = NULL, *opt = NULL;
+		dns_rdatatype_t qtype = dns_rdatatype_a;
+		dns_compress_t cctx;
+		isc_buffer_t buffer;
+		isc_textregion_t tr;
+		isc_result_t result;
+		char *name = NULL, *type = NULL, *last = NULL;
+
+		lineno++;
+		name = strtok_r(line, " \t\r\n", &last);
+		if (name == NULL || name[0] == '#' || name[0] == ';') {
+			continue;
+		}
+		type = strtok_r(NULL, " \t\r\n", &last);
+		if (type != NULL) {
+			tr.base = type;
+			tr.length = strlen(type);
+			result = dns_rdatatype_fromtext(&qtype, &tr);
+			if (result != ISC_R_SUCCESS) {
+				fprintf(stderr, "%s:%zu: bad type '%s'\n",
+					filename, lineno, type);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		if (nqueries == size) {
+			queries = isc_mem_creget(mctx, queries, size, size * 2,
+						 sizeof(queries[0]));
+			size *= 2;
+		}
+
+		dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTRENDER,
+				   &message);
+		message->id = (dns_messageid_t)nqueries;
+		message->opcode = dns_opcode_query;
+		if (usecache) {
+			message->flags |= DNS_MESSAGEFLAG_RD;
+		}
+
+		dns_message_gettempname(message, &qname);
+		result = dns_name_fromstring(qname, name, dns_rootname, 0,
+					     NULL);
+		if (result != ISC_R_SUCCESS) {
+			fprintf(stderr, "%s:%zu: bad name '%s': %s\n", filename,
+				lineno, name, isc_result_totext(result));
+			exit(EXIT_FAILURE);
+		}
+		dns_message_gettemprdataset(message, &question);
+		dns_rdataset_makequestion(question, dns_rdataclass_in, qtype);
+		ISC_LIST_APPEND(qname->list, question, link);
+		dns_message_addname(message, qname, DNS_SECTION_QUESTION);
+
+		RUNTIME_CHECK(dns_message_buildopt(message, &opt, 0, 1232, 0,
+						   NULL, 0) == ISC_R_SUCCESS);
+		RUNTIME_CHECK(dns_message_setopt(message, opt) ==
+			      ISC_R_SUCCESS);
+
+		dns_compress_init(&cctx, mctx, 0);
+		isc_buffer_init(&buffer, queries[nqueries].wire,
+				sizeof(queries[nqueries].wire));
+		RUNTIME_CHECK(dns_message_renderbegin(message, &cctx,
+						      &buffer) ==
+			      ISC_R_SUCCESS);
+		RUNTIME_CHECK(dns_message_rendersection(
+				      message, DNS_SECTION_QUESTION, 0) ==
+			      ISC_R_SUCCESS);
+		RUNTIME_CHECK(dns_message_renderend(message) == ISC_R_SUCCESS);
+		dns_compress_invalidate(&cctx);
+		dns_message_detach(&message);
+
+		queries[nqueries].length = isc_buffer_usedlength(&buffer);
+		nqueries++;
+	}
+
+	fclose(fp);
+
+	if (nqueries == 0) {
+		fprintf(stderr, "%s: no queries\n", filename);
+		exit(EXIT_FAILURE);
+	}
+
+	queries = isc_mem_creget(mctx, queries, size, nqueries,
+				 sizeof(queries[0]));
+}
+
+static void
+load_cache(void) {
+	dns_rdatacallbacks_t callbacks;
+	dns_cache_t *cache = NULL;
+	dns_db_t *db = NULL;
+	isc_result_t result, tresult;
+
+	RUNTIME_CHECK(dns_cache_create(loopmgr, dns_rdataclass_in, "",
+				       &cache) == ISC_R_SUCCESS);
+	dns_view_setcache(view, cache, false);
+	dns_cache_detach(&cache);
+
+	dns_db_attach(view->cachedb, &db);
+	dns_rdatacallbacks_init(&callbacks);
+	RUNTIME_CHECK(dns_db_beginload(db, &callbacks) == ISC_R_SUCCESS);
+	result = dns_master_loadfile(zonefile, origin, origin,
+				     dns_rdataclass_in, 0, 0, &callbacks, NULL,
+				     NULL, mctx, dns_masterformat_text, 0);
+	tresult = dns_db_endload(db, &callbacks);
+	if (result == ISC_R_SUCCESS) {
+		result = tresult;
+	}
+	dns_db_detach(&db);
+
+	if (result != ISC_R_SUCCESS && result != DNS_R_SEENINCLUDE) {
+		fprintf(stderr, "%s: %s\n", zonefile,
+			isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void
+load_zone(void) {
+	isc_result_t result;
+
+	dns_zonemgr_create(mctx, loopmgr, netmgr, &zonemgr);
+
+	dns_zone_create(&zone, mctx, 0);
+	dns_zone_settype(zone, dns_zone_primary);
+	RUNTIME_CHECK(dns_zone_setorigin(zone, origin) == ISC_R_SUCCESS);
+	dns_zone_setclass(zone, view->rdclass);
+	dns_zone_setview(zone, view);
+	RUNTIME_CHECK(dns_view_addzone(view, zone) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_zonemgr_managezone(zonemgr, zone) == ISC_R_SUCCESS);
+
+	RUNTIME_CHECK(dns_zone_setfile(zone, zonefile, dns_masterformat_text,
+				       &dns_master_style_default) ==
+		      ISC_R_SUCCESS);
+	result = dns_zone_load(zone, false);
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "%s: %s\n", zonefile,
+			isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+}
+
+static void
+finish_loop(bench_loop_t *bl);
+
+static void
+send_query(bench_loop_t *bl, const query_t *q) {
+	isc_region_t region = { .base = UNCONST(q->wire),
+				.length = q->length };
+	isc_nmhandle_t *handle = ISC_LIST_HEAD(bl->inactive);
+	isc_nanosecs_t end;
+
+	if (handle != NULL) {
+		ISC_LIST_UNLINK(bl->inactive, handle, link);
+	} else {
+		handle = isc_mem_get(mctx, sizeof(*handle));
+		*handle = (isc_nmhandle_t){
+			.magic = HANDLE_MAGIC,
+			.bl = bl,
+			.link = ISC_LINK_INITIALIZER,
+		};
+	}
+	isc_refcount_init(&handle->references, 1);
+
+	bl->tsetup = bl->tdone = bl->tsent = 0;
+	bl->tstart = isc_time_monotonic();
+
+	ns_client_request(handle, ISC_R_SUCCESS, &region, &interface);
+	isc_nmhandle_detach(&handle);
+
+	end = isc_time_monotonic();
+
+	if (bl->tsetup != 0 && bl->tdone != 0 && bl->tsent != 0) {
+		bl->hooked++;
+		bl->request += bl->tsetup - bl->tstart;
+		bl->query += bl->tdone - bl->tsetup;
+		bl->render += bl->tsent - bl->tdone;
+		bl->cleanup += end - bl->tsent;
+	} else {
+		bl->request += end - bl->tstart;
+	}
+}
+
+static void
+run_batch(void *arg) {
+	bench_loop_t *bl = arg;
+
+	for (size_t i = 0; i < BATCH && bl->sent < count; i++) {
+		send_query(bl, &queries[bl->next]);
+		bl->next = (bl->next + 1) % nqueries;
+		bl->sent++;
+	}
+
+	if (bl->sent < count) {
+		isc_job_run(bl->loop, &bl->job, run_batch, bl);
+	} else {
+		finish_loop(bl);
+	}
+}
+
+static void
+start_loop(void *arg) {
+	bench_loop_t *bl = arg;
+
+	bl->allocated = allocated();
+	run_batch(bl);
+}
+
+static void
+shutdown_server(void) {
+	ns_interfacemgr_shutdown(interfacemgr);
+	ns_interfacemgr_detach(&interfacemgr);
+	dns_dispatchmgr_detach(&dispatchmgr);
+
+	if (zone != NULL) {
+		dns_zonemgr_releasezone(zonemgr, zone);
+		dns_zone_detach(&zone);
+		dns_zonemgr_shutdown(zonemgr);
+		dns_zonemgr_detach(&zonemgr);
+	}
+
+	dns_view_detach(&view);
+	ns_server_detach(&sctx);
+}
+
+static void
+report(void) {
+	isc_nanosecs_t elapsed = isc_time_monotonic() - start;
+	uint64_t sent = 0, hooked = 0, responses = 0, bytes = 0;
+	uint64_t pending = 0, alloc = 0;
+	isc_nanosecs_t request = 0, query = 0, render = 0, cleanup = 0;
+	uint64_t rcodes[16] = { 0 };
+
+	for (uint32_t i = 0; i < nloops; i++) {
+		bench_loop_t *bl = &loops[i];
+
+		sent += bl->sent;
+		hooked += bl->hooked;
+		responses += bl->responses;
+		bytes += bl->bytes;
+		pending += bl->pending;
+		alloc += bl->allocated;
+		request += bl->request;
+		query += bl->query;
+		render += bl->render;
+		cleanup += bl->cleanup;
+		for (size_t r = 0; r < ARRAY_SIZE(rcodes); r++) {
+			rcodes[r] += bl->rcodes[r];
+		}
+	}
+
+	printf("%-10s %s, %zu distinct queries, %u loops\n", "mode",
+	       usecache ? "cache" : "zone", nqueries, nloops);
+	printf("%-10s %" PRIu64 " / %f ms; %f qps\n", "queries", sent,
+	       (double)elapsed / NS_PER_MS,
+	       (double)sent * NS_PER_SEC / elapsed);
+	printf("%-10s %" PRIu64 "; %f bytes per response\n", "responses",
+	       responses, responses > 0 ? (double)bytes / responses : 0.0);
+	if (pending > 0) {
+		printf("%-10s %" PRIu64 " still pending\n", "pending", pending);
+	}
+
+	printf("%-10s %f ns per query\n", "request", (double)request / sent);
+	if (hooked > 0) {
+		printf("%-10s %f ns per query\n", "query",
+		       (double)query / hooked);
+		printf("%-10s %f ns per query\n", "render",
+		       (double)render / hooked);
+		printf("%-10s %f ns per query\n", "cleanup",
+		       (double)cleanup / hooked);
+	}
+
+	for (size_t r = 0; r < ARRAY_SIZE(rcodes); r++) {
+		char rcode[64];
+		isc_buffer_t b;
+
+		if (rcodes[r] == 0) {
+			continue;
+		}
+		isc_buffer_init(&b, rcode, sizeof(rcode));
+		RUNTIME_CHECK(dns_rcode_totext((dns_rcode_t)r, &b) ==
+			      ISC_R_SUCCESS);
+		isc_buffer_putuint8(&b, 0);
+		printf("%-10s %" PRIu64 "\n", rcode, rcodes[r]);
+	}
+
+#ifdef HAVE_JEMALLOC
+	printf("%-10s %f bytes per query\n", "allocated",
+	       (double)alloc / sent);
+#else
+	UNUSED(alloc);
+#endif /* HAVE_JEMALLOC */
+}
+
+static void
+collect(void *arg) {
+	UNUSED(arg);
+
+	if (++finished < nloops) {
+		return;
+	}
+
+	report();
+	shutdown_server();
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+static void
+finish_loop(bench_loop_t *bl) {
+	isc_nmhandle_t *handle = NULL;
+
+	bl->allocated = allocated() - bl->allocated;
+
+	/*
+	 * Any handle that is not on the inactive list is still in use
+	 * by a query that has not been answered yet.
+	 */
+	bl->pending = bl->sent - bl->responses;
+
+	while ((handle = ISC_LIST_HEAD(bl->inactive)) != NULL) {
+		ISC_LIST_UNLINK(bl->inactive, handle, link);
+		if (handle->dofree != NULL) {
+			handle->dofree(handle->opaque);
+		}
+		handle->magic = 0;
+		isc_mem_put(mctx, handle, sizeof(*handle));
+	}
+
+	isc_async_run(isc_loop_main(loopmgr), collect, NULL);
+}
+
+static void
+setup(void *arg) {
+	ns_hooktable_t *hooktable = NULL;
+	const ns_hook_t setuphook = { .action = hook_setup };
+	const ns_hook_t donehook = { .action = hook_done };
+	struct in_addr in = { .s_addr = htonl(INADDR_LOOPBACK) };
+
+	UNUSED(arg);
+
+	ns_server_create(mctx, matchview, &sctx);
+	RUNTIME_CHECK(dns_dispatchmgr_create(mctx, loopmgr, netmgr,
+					     &dispatchmgr) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(ns_interfacemgr_create(mctx, sctx, loopmgr, netmgr,
+					     dispatchmgr, NULL, false,
+					     &interfacemgr) == ISC_R_SUCCESS);
+
+	interface = (ns_interface_t){ .mgr = interfacemgr };
+	isc_sockaddr_fromin(&interface.addr, &in, 53);
+
+	RUNTIME_CHECK(dns_view_create(mctx, NULL, dns_rdataclass_in, "bench",
+				      &view) == ISC_R_SUCCESS);
+
+	RUNTIME_CHECK(ns_hooktable_create(mctx, &hooktable) == ISC_R_SUCCESS);
+	ns_hook_add(hooktable, mctx, NS_QUERY_SETUP, &setuphook);
+	ns_hook_add(hooktable, mctx, NS_QUERY_DONE_SEND, &donehook);
+	view->hooktable = hooktable;
+	view->hooktable_free = ns_hooktable_free;
+
+	if (usecache) {
+		load_cache();
+	} else {
+		load_zone();
+	}
+	dns_view_freeze(view);
+
+	start = isc_time_monotonic();
+	for (uint32_t i = 0; i < nloops; i++) {
+		bench_loop_t *bl = &loops[i];
+
+		*bl = (bench_loop_t){
+			.loop = isc_loop_get(loopmgr, i),
+			.job = ISC_JOB_INITIALIZER,
+			.inactive = ISC_LIST_INITIALIZER,
+			.next = (nqueries * i) / nloops,
+		};
+		isc_sockaddr_fromin(&bl->peer, &in, 10000 + i);
+
+		isc_async_run(bl->loop, start_loop, bl);
+	}
+}
+
+static void
+usage(void) {
+	fprintf(stderr, "usage: ns_query [-c] [-l loops] [-n queries] "
+			"<zonefile> <origin> <queryfile>\n");
+	exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[]) {
+	isc_result_t result;
+	int ch;
+
+	nloops = isc_os_ncpus();
+
+	while ((ch = getopt(argc, argv, "cl:n:")) != -1) {
+		switch (ch) {
+		case 'c':
+			usecache = true;
+			break;
+		case 'l':
+			nloops = atoi(optarg);
+			break;
+		case 'n':
+			count = strtoull(optarg, NULL, 10);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (argc != 3 || nloops == 0 || count == 0) {
+		usage();
+	}
+
+	zonefile = argv[0];
+	origin = dns_fixedname_initname(&fixedorigin);
+	result = dns_name_fromstring(origin, argv[1], dns_rootname, 0, NULL);
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "%s: %s\n", argv[1], isc_result_totext(result));
+		return (EXIT_FAILURE);
+	}
+
+	setlinebuf(stdout);
+
+	isc_managers_create(&mctx, nloops, &loopmgr, &netmgr);
+
+	load_queries(argv[2]);
+	loops = isc_mem_cget(mctx, nloops, sizeof(loops[0]));
+
+	isc_loop_setup(isc_loop_main(loopmgr), setup, NULL);
+	isc_loopmgr_run(loopmgr);
+
+	isc_mem_cput(mctx, loops, nloops, sizeof(loops[0]));
+	isc_mem_cput(mctx, queries, nqueries, sizeof(queries[0]));
+
+	isc_managers_destroy(&mctx, &loopmgr, &netmgr);
+
+	return (EXIT_SUCCESS);
+}
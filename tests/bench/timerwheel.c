@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * Cost of scheduling large numbers of zone maintenance style timers,
+ * with a timeout between a minute and a day, first with an isc_timer per
+ * timer and then on a timer wheel.  Each timer is started, restarted with
+ * a new timeout, and stopped again, and the average time taken by each
+ * operation is reported.
+ *
+ * Usage: timerwheel [count]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/loop.h>
+#include <isc/mem.h>
+#include <isc/random.h>
+#include <isc/time.h>
+#include <isc/timer.h>
+#include <isc/timerwheel.h>
+#include <isc/util.h>
+
+#define DEFAULT_COUNT 1000000
+#define MIN_TIMEOUT   60
+#define MAX_TIMEOUT   86400
+
+static isc_mem_t *mctx = NULL;
+static isc_loopmgr_t *loopmgr = NULL;
+static unsigned int count = DEFAULT_COUNT;
+static uint32_t *timeouts = NULL;
+
+static isc_nanosecs_t start;
+
+static void
+expired(void *arg) {
+	UNUSED(arg);
+
+	/* None of the timers should last long enough to expire */
+	UNREACHABLE();
+}
+
+static void
+report(const char *impl, const char *op) {
+	isc_nanosecs_t elapsed = isc_time_monotonic() - start;
+
+	printf("%-10s %-8s %u timers / %f ms; %f ns per timer\n", impl, op,
+	       count, (double)elapsed / NS_PER_MS, (double)elapsed / count);
+
+	start = isc_time_monotonic();
+}
+
+static void
+new_timeouts(void) {
+	for (unsigned int i = 0; i < count; i++) {
+		timeouts[i] = MIN_TIMEOUT +
+			      isc_random_uniform(MAX_TIMEOUT - MIN_TIMEOUT);
+	}
+}
+
+static void
+bench_timer(isc_loop_t *loop) {
+	isc_timer_t **timers = isc_mem_cget(mctx, count, sizeof(timers[0]));
+	isc_interval_t interval;
+
+	new_timeouts();
+	start = isc_time_monotonic();
+	for (unsigned int i = 0; i < count; i++) {
+		isc_interval_set(&interval, timeouts[i], 0);
+		isc_timer_create(loop, expired, NULL, &timers[i]);
+		isc_timer_start(timers[i], isc_timertype_once, &interval);
+	}
+	report("isc_timer", "start");
+
+	new_timeouts();
+	start = isc_time_monotonic();
+	for (unsigned int i = 0; i < count; i++) {
+		isc_interval_set(&interval, timeouts[i], 0);
+		isc_timer_start(timers[i], isc_timertype_once, &interval);
+	}
+	report("isc_timer", "restart");
+
+	for (unsigned int i = 0; i < count; i++) {
+		isc_timer_stop(timers[i]);
+		isc_timer_destroy(&timers[i]);
+	}
+	report("isc_timer", "stop");
+
+	isc_mem_cput(mctx, timers, count, sizeof(timers[0]));
+}
+
+static void
+bench_wheel(isc_loop_t *loop) {
+	isc_wheeltimer_t *timers = isc_mem_cget(mctx, count,
+						sizeof(timers[0]));
+	isc_timerwheel_t *wheel = NULL;
+
+	isc_timerwheel_create(loop, &wheel);
+
+	new_timeouts();
+	start = isc_time_monotonic();
+	for (unsigned int i = 0; i < count; i++) {
+		isc_wheeltimer_init(&timers[i], wheel, expired, NULL);
+		isc_wheeltimer_start(&timers[i], timeouts[i]);
+	}
+	report("timerwheel", "start");
+
+	new_timeouts();
+	start = isc_time_monotonic();
+	for (unsigned int i = 0; i < count; i++) {
+		isc_wheeltimer_start(&timers[i], timeouts[i]);
+	}
+	report("timerwheel", "restart");
+
+	for (unsigned int i = 0; i < count; i++) {
+		isc_wheeltimer_invalidate(&timers[i]);
+	}
+	report("timerwheel", "stop");
+
+	isc_timerwheel_shutdown(wheel);
+	isc_timerwheel_detach(&wheel);
+
+	isc_mem_cput(mctx, timers, count, sizeof(timers[0]));
+}
+
+static void
+run(void *arg) {
+	isc_loop_t *loop = isc_loop_main(loopmgr);
+
+	UNUSED(arg);
+
+	bench_timer(loop);
+	bench_wheel(loop);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+int
+main(int argc, char *argv[]) {
+	if (argc > 1) {
+		count = atoi(argv[1]);
+		if (count == 0) {
+			fprintf(stderr, "usage: timerwheel [count]\n");
+			return (EXIT_FAILURE);
+		}
+	}
+
+	setlinebuf(stdout);
+
+	isc_mem_create(&mctx);
+	timeouts = isc_mem_cget(mctx, count, sizeof(timeouts[0]));
+
+	isc_loopmgr_create(mctx, 1, &loopmgr);
+	isc_loop_setup(isc_loop_main(loopmgr), run, NULL);
+	isc_loopmgr_run(loopmgr);
+	isc_loopmgr_destroy(&loopmgr);
+
+	isc_mem_cput(mctx, timeouts, count, sizeof(timeouts[0]));
+	isc_mem_destroy(&mctx);
+
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * UDP listener throughput over loopback, first with the libuv backend
+ * and then with io_uring.  Client threads each keep a fixed number of
+ * queries in flight on their own socket for a fixed time; the server
+ * echoes every query back.
+ *
+ * Usage: udp [port]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <isc/async.h>
+#include <isc/atomic.h>
+#include <isc/loop.h>
+#include <isc/managers.h>
+#include <isc/mem.h>
+#include <isc/netmgr.h>
+#include <isc/os.h>
+#include <isc/sockaddr.h>
+#include <isc/thread.h>
+#include <isc/time.h>
+#include <isc/util.h>
+
+#define CLIENTS	  4
+#define INFLIGHT  32
+#define QUERYSIZE 40
+#define DURATION  5 /* seconds */
+
+static isc_mem_t *mctx = NULL;
+static isc_loopmgr_t *loopmgr = NULL;
+static isc_nm_t *netmgr = NULL;
+
+static isc_nmsocket_t *listen_sock = NULL;
+static isc_sockaddr_t server_addr;
+static in_port_t port = 5300;
+
+static const char *phases[] = { "libuv", "io_uring" };
+static unsigned int phase = 0;
+
+static isc_thread_t clients[CLIENTS];
+static atomic_uint_fast64_t nrecv;
+static atomic_uint_fast32_t running;
+
+static void
+start_phase(void *arg);
+
+static void
+senddone(isc_nmhandle_t *handle, isc_result_t result, void *cbarg) {
+	UNUSED(result);
+	UNUSED(cbarg);
+
+	isc_nmhandle_detach(&handle);
+}
+
+static void
+server_recv(isc_nmhandle_t *handle, isc_result_t result, isc_region_t *region,
+	    void *cbarg) {
+	isc_nmhandle_t *sendhandle = NULL;
+
+	UNUSED(cbarg);
+
+	if (result != ISC_R_SUCCESS) {
+		return;
+	}
+
+	isc_nmhandle_attach(handle, &sendhandle);
+	isc_nm_send(sendhandle, region, senddone, NULL);
+}
+
+static void
+finish_phase(void *arg) {
+	UNUSED(arg);
+
+	for (size_t i = 0; i < ARRAY_SIZE(clients); i++) {
+		isc_thread_join(clients[i], NULL);
+	}
+
+	printf("%-8s %" PRIuFAST64 " responses / %u s; %f responses/s\n",
+	       phases[phase], atomic_load(&nrecv), DURATION,
+	       (double)atomic_load(&nrecv) / DURATION);
+
+	isc_nm_stoplistening(listen_sock);
+	isc_nmsocket_close(&listen_sock);
+
+	phase++;
+	if (phase < ARRAY_SIZE(phases)) {
+		isc_async_current(loopmgr, start_phase, NULL);
+	} else {
+		isc_loopmgr_shutdown(loopmgr);
+	}
+}
+
+static void *
+client(void *arg) {
+	uint8_t query[QUERYSIZE], answer[QUERYSIZE];
+	struct timeval tv = { .tv_usec = 100000 };
+	isc_time_t start, now;
+	uint64_t received = 0;
+	int fd;
+
+	UNUSED(arg);
+
+	memset(query, 0x5a, sizeof(query));
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	RUNTIME_CHECK(fd >= 0);
+	RUNTIME_CHECK(setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv,
+				 sizeof(tv)) == 0);
+	RUNTIME_CHECK(connect(fd, &server_addr.type.sa, server_addr.length) ==
+		      0);
+
+	start = isc_time_now();
+	for (size_t i = 0; i < INFLIGHT; i++) {
+		(void)send(fd, query, sizeof(query), 0);
+	}
+
+	do {
+		if (recv(fd, answer, sizeof(answer), 0) < 0) {
+			/* Lost a datagram, refill the window */
+			for (size_t i = 0; i < INFLIGHT; i++) {
+				(void)send(fd, query, sizeof(query), 0);
+			}
+		} else {
+			received++;
+			(void)send(fd, query, sizeof(query), 0);
+		}
+		now = isc_time_now();
+	} while (isc_time_microdiff(&now, &start) < DURATION * US_PER_SEC);
+
+	close(fd);
+
+	atomic_fetch_add(&nrecv, received);
+	if (atomic_fetch_sub(&running, 1) == 1) {
+		isc_async_run(isc_loop_main(loopmgr), finish_phase, NULL);
+	}
+
+	return (NULL);
+}
+
+static void
+start_phase(void *arg) {
+	struct in_addr in = { .s_addr = htonl(INADDR_LOOPBACK) };
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	isc_nm_setiouring(netmgr, phase == 1);
+	if (phase == 1 && !isc_nm_getiouring(netmgr)) {
+		printf("%-8s not supported by this build\n", phases[phase]);
+		isc_loopmgr_shutdown(loopmgr);
+		return;
+	}
+
+	isc_sockaddr_fromin(&server_addr, &in, port + phase);
+
+	result = isc_nm_listenudp(netmgr, ISC_NM_LISTEN_ALL, &server_addr,
+				  server_recv, NULL, &listen_sock);
+	if (result != ISC_R_SUCCESS) {
+		fprintf(stderr, "listen failed: %s\n",
+			isc_result_totext(result));
+		exit(EXIT_FAILURE);
+	}
+
+	atomic_store(&nrecv, 0);
+	atomic_store(&running, ARRAY_SIZE(clients));
+	for (size_t i = 0; i < ARRAY_SIZE(clients); i++) {
+		isc_thread_create(client, NULL, &clients[i]);
+	}
+}
+
+int
+main(int argc, char *argv[]) {
+	uint32_t workers = isc_os_ncpus() > CLIENTS ? isc_os_ncpus() - CLIENTS
+						    : 1;
+
+	if (argc > 1) {
+		port = atoi(argv[1]);
+	}
+
+	setlinebuf(stdout);
+
+	isc_managers_create(&mctx, workers, &loopmgr, &netmgr);
+
+	isc_loop_setup(isc_loop_main(loopmgr), start_phase, NULL);
+	isc_loopmgr_run(loopmgr);
+
+	isc_managers_destroy(&mctx, &loopmgr, &netmgr);
+
+	return (EXIT_SUCCESS);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/*
+ * Memory used by zone objects.  Configures a number of synthetic
+ * zones the way named would for a few common kinds of zone and reports
+ * the memory in use per zone, as measured by the memory context.
+ *
+ * Usage: zones [count]
+ */
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <isc/mem.h>
+#include <isc/sockaddr.h>
+#include <isc/util.h>
+
+#include <dns/fixedname.h>
+#include <dns/masterdump.h>
+#include <dns/name.h>
+#include <dns/zone.h>
+
+#define DEFAULT_COUNT 100000
+
+typedef enum {
+	plain_primary,
+	plain_secondary,
+	secondary_sources,
+} zonekind_t;
+
+static const char *kinds[] = {
+	[plain_primary] = "primary",
+	[plain_secondary] = "secondary",
+	[secondary_sources] = "secondary with transfer-source",
+};
+
+static isc_mem_t *mctx = NULL;
+static dns_zone_t **zones = NULL;
+static unsigned int count = DEFAULT_COUNT;
+
+static void
+configure(dns_zone_t *zone, unsigned int i, zonekind_t kind) {
+	isc_sockaddr_t primary, source, any4, any6;
+	struct in_addr in;
+	dns_fixedname_t fixed;
+	dns_name_t *origin = dns_fixedname_initname(&fixed);
+	char buf[64];
+
+	snprintf(buf, sizeof(buf), "z%07u.example.", i);
+	RUNTIME_CHECK(dns_name_fromstring(origin, buf, dns_rootname, 0,
+					  NULL) == ISC_R_SUCCESS);
+	RUNTIME_CHECK(dns_zone_setorigin(zone, origin) == ISC_R_SUCCESS);
+	dns_zone_setclass(zone, dns_rdataclass_in);
+
+	snprintf(buf, sizeof(buf), "z%07u.example.db", i);
+	RUNTIME_CHECK(dns_zone_setfile(zone, buf, dns_masterformat_text,
+				       &dns_master_style_default) ==
+		      ISC_R_SUCCESS);
+
+	/*
+	 * named sets every source address, usually to the wildcard.
+	 */
+	isc_sockaddr_any(&any4);
+	isc_sockaddr_any6(&any6);
+	dns_zone_setnotifysrc4(zone, &any4);
+	dns_zone_setnotifysrc6(zone, &any6);
+	dns_zone_setparentalsrc4(zone, &any4);
+	dns_zone_setparentalsrc6(zone, &any6);
+	dns_zone_setxfrsource4(zone, &any4);
+	dns_zone_setxfrsource6(zone, &any6);
+
+	if (kind == plain_primary) {
+		dns_zone_settype(zone, dns_zone_primary);
+		return;
+	}
+
+	dns_zone_settype(zone, dns_zone_secondary);
+
+	RUNTIME_CHECK(inet_pton(AF_INET, "192.0.2.1", &in) == 1);
+	isc_sockaddr_fromin(&primary, &in, 53);
+	dns_zone_setprimaries(zone, &primary, &any4, NULL, NULL, 1);
+
+	if (kind == secondary_sources) {
+		RUNTIME_CHECK(inet_pton(AF_INET, "192.0.2.53", &in) == 1);
+		isc_sockaddr_fromin(&source, &in, 0);
+		dns_zone_setxfrsource4(zone, &source);
+	}
+}
+
+static void
+measure(zonekind_t kind) {
+	size_t before, after;
+
+	before = isc_mem_inuse(mctx);
+	for (unsigned int i = 0; i < count; i++) {
+		dns_zone_create(&zones[i], mctx, 0);
+		configure(zones[i], i, kind);
+	}
+	after = isc_mem_inuse(mctx);
+
+	printf("%-32s %u zones, %zu bytes, %zu bytes per zone\n", kinds[kind],
+	       count, after - before, (after - before) / count);
+
+	for (unsigned int i = 0; i < count; i++) {
+		dns_zone_detach(&zones[i]);
+	}
+}
+
+int
+main(int argc, char *argv[]) {
+	if (argc > 1) {
+		count = atoi(argv[1]);
+		if (count == 0) {
+			fprintf(stderr, "usage: zones [count]\n");
+			return (EXIT_FAILURE);
+		}
+	}
+
+	isc_mem_create(&mctx);
+	zones = isc_mem_cget(mctx, count, sizeof(zones[0]));
+
+	for (size_t kind = 0; kind < ARRAY_SIZE(kinds); kind++) {
+		measure(kind);
+	}
+
+	isc_mem_cput(mctx, zones, count, sizeof(zones[0]));
+	isc_mem_destroy(&mctx);
+
+	return (EXIT_SUCCESS);
+}
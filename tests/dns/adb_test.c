@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#include <inttypes.h>
+#include <limits.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/util.h>
+
+#include <dns/adb.h>
+
+/*
+ * Include the library source to test the static RTT histogram
+ * functions.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wshadow"
+#include "adb.c"
+#pragma GCC diagnostic pop
+
+#include <tests/dns.h>
+
+/* every bucket covers the range rtt_bucketrange() reports for it */
+ISC_RUN_TEST_IMPL(rtt_bucket_edges) {
+	uint64_t min, max;
+
+	assert_int_equal(rtt_bucket(0), 0);
+	assert_int_equal(rtt_bucket(ADB_RTT_MINUS - 1), 0);
+	assert_int_equal(rtt_bucket(ADB_RTT_MINUS), 1);
+	assert_int_equal(rtt_bucket(1535), 1);
+	assert_int_equal(rtt_bucket(1536), 2);
+	assert_int_equal(rtt_bucket(2047), 2);
+	assert_int_equal(rtt_bucket(2048), 3);
+	assert_int_equal(rtt_bucket(3072), 4);
+
+	rtt_bucketrange(0, &min, &max);
+	assert_int_equal(min, 0);
+	assert_int_equal(max, ADB_RTT_MINUS);
+
+	for (unsigned int bucket = 1; bucket < ADB_RTT_BUCKETS - 1; bucket++)
+	{
+		rtt_bucketrange(bucket, &min, &max);
+		assert_true(min < max);
+		assert_int_equal(rtt_bucket(min), bucket);
+		assert_int_equal(rtt_bucket(max - 1), bucket);
+		assert_int_equal(rtt_bucket(min - 1), bucket - 1);
+	}
+
+	/* anything slower than the top octave lands in the last bucket */
+	assert_int_equal(rtt_bucket(ADB_RTT_MINUS << ADB_RTT_OCTAVES),
+			 ADB_RTT_BUCKETS - 1);
+	assert_int_equal(rtt_bucket(UINT_MAX), ADB_RTT_BUCKETS - 1);
+}
+
+/* quantiles are interpolated inside the bucket holding them */
+ISC_RUN_TEST_IMPL(rtthist_quantile) {
+	dns_adbentry_t entry = { 0 };
+	unsigned int rtt = 0;
+
+	for (size_t i = 0; i < ADB_RTT_MINSAMPLES - 1; i++) {
+		rtthist_add(&entry, 1100);
+	}
+	assert_int_equal(rtthist_quantile(&entry, 0.50, &rtt), ISC_R_NOTFOUND);
+
+	/* 90 samples in [1024, 1536) and 10 in [4096, 6144) */
+	for (size_t i = ADB_RTT_MINSAMPLES - 1; i < 90; i++) {
+		rtthist_add(&entry, 1100);
+	}
+	for (size_t i = 0; i < 10; i++) {
+		rtthist_add(&entry, 5000);
+	}
+	assert_int_equal(entry.rttsamples, 100);
+	assert_int_equal(entry.rttcount, 100);
+
+	assert_int_equal(rtthist_quantile(&entry, 0.0, &rtt), ISC_R_SUCCESS);
+	assert_int_equal(rtt, 1024);
+	assert_int_equal(rtthist_quantile(&entry, 0.50, &rtt), ISC_R_SUCCESS);
+	assert_int_equal(rtt, 1024 + 512 * 49 / 90);
+	assert_int_equal(rtthist_quantile(&entry, 0.95, &rtt), ISC_R_SUCCESS);
+	assert_int_equal(rtt, 4096 + 2048 * 4 / 10);
+	assert_int_equal(rtthist_quantile(&entry, 1.0, &rtt), ISC_R_SUCCESS);
+	assert_int_equal(rtt, 4096 + 2048 * 9 / 10);
+}
+
+/* the counts are halved once ADB_RTT_DECAY samples have been seen */
+ISC_RUN_TEST_IMPL(rtthist_decay) {
+	dns_adbentry_t entry = { 0 };
+	unsigned int rtt = 0;
+
+	for (size_t i = 0; i < ADB_RTT_DECAY - 1; i++) {
+		rtthist_add(&entry, 1100);
+	}
+	assert_int_equal(entry.rtthist[1], ADB_RTT_DECAY - 1);
+	assert_int_equal(entry.rttsamples, ADB_RTT_DECAY - 1);
+
+	rtthist_add(&entry, 1100);
+	assert_int_equal(entry.rtthist[1], ADB_RTT_DECAY / 2);
+	assert_int_equal(entry.rttsamples, ADB_RTT_DECAY / 2);
+	assert_int_equal(entry.rttcount, ADB_RTT_DECAY);
+
+	/* a slower server takes over the median after the decay */
+	for (size_t i = 0; i < ADB_RTT_DECAY / 2 + 1; i++) {
+		rtthist_add(&entry, 5000);
+	}
+	assert_int_equal(rtthist_quantile(&entry, 0.50, &rtt), ISC_R_SUCCESS);
+	assert_int_equal(rtt_bucket(rtt), rtt_bucket(5000));
+}
+
+ISC_TEST_LIST_START
+ISC_TEST_ENTRY(rtt_bucket_edges)
+ISC_TEST_ENTRY(rtthist_quantile)
+ISC_TEST_ENTRY(rtthist_decay)
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN
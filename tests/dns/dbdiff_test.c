@@ -25,9 +25,11 @@
 
 #include <isc/util.h>
 
+#include <dns/callbacks.h>
 #include <dns/db.h>
 #include <dns/dbiterator.h>
 #include <dns/journal.h>
+#include <dns/master.h>
 #include <dns/name.h>
 
 #include <tests/dns.h>
@@ -135,10 +137,149 @@ ISC_RUN_TEST_IMPL(diffx_remove) {
 	dns_db_detach(&olddb);
 }
 
+static bool
+tuple_in_diff(dns_difftuple_t *tuple, dns_diff_t *diff) {
+	for (dns_difftuple_t *t = ISC_LIST_HEAD(diff->tuples); t != NULL;
+	     t = ISC_LIST_NEXT(t, link))
+	{
+		if (t->op == tuple->op && t->ttl == tuple->ttl &&
+		    dns_name_equal(&t->name, &tuple->name) &&
+		    dns_rdata_compare(&t->rdata, &tuple->rdata) == 0)
+		{
+			return (true);
+		}
+	}
+
+	return (false);
+}
+
+/*
+ * Load 'newfile' while comparing it with the zone in 'oldfile', and check
+ * that the diff generated has 'expected' changes and is the same as the
+ * one generated by dns_db_diffx().
+ */
+static void
+test_loaddiff(const char *oldfile, const char *newfile, size_t expected) {
+	dns_rdatacallbacks_t dbcallbacks, callbacks;
+	dns_db_t *newdb = NULL, *olddb = NULL;
+	dns_loaddiff_t *ld = NULL;
+	dns_difftuple_t *tuple;
+	isc_result_t result;
+	dns_diff_t diff, full;
+	size_t count = 0;
+
+	result = dns_test_loaddb(&olddb, dns_dbtype_zone, TEST_ORIGIN, oldfile);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_db_create(mctx, "rbt", dns_db_origin(olddb),
+			       dns_dbtype_zone, dns_rdataclass_in, 0, NULL,
+			       &newdb);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	dns_rdatacallbacks_init(&dbcallbacks);
+	result = dns_db_beginload(newdb, &dbcallbacks);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_loaddiff_create(mctx, olddb, newdb, &ld);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	dns_loaddiff_callbacks(ld, &dbcallbacks, &callbacks);
+
+	result = dns_master_loadfile(newfile, dns_db_origin(newdb),
+				     dns_db_origin(newdb), dns_rdataclass_in,
+				     0, 0, &callbacks, NULL, NULL, mctx,
+				     dns_masterformat_text, 0);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_db_endload(newdb, &dbcallbacks);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	assert_true(dns_loaddiff_current(ld, olddb, newdb));
+	assert_false(dns_loaddiff_current(ld, newdb, olddb));
+
+	dns_diff_init(mctx, &diff);
+	result = dns_loaddiff_diff(&ld, &diff, newdb, NULL, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_null(ld);
+
+	dns_diff_init(mctx, &full);
+	result = dns_db_diffx(&full, newdb, NULL, olddb, NULL, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	for (tuple = ISC_LIST_HEAD(diff.tuples); tuple != NULL;
+	     tuple = ISC_LIST_NEXT(tuple, link))
+	{
+		assert_true(tuple_in_diff(tuple, &full));
+		count++;
+	}
+	assert_int_equal(count, expected);
+
+	for (tuple = ISC_LIST_HEAD(full.tuples); tuple != NULL;
+	     tuple = ISC_LIST_NEXT(tuple, link))
+	{
+		count--;
+	}
+	assert_int_equal(count, 0);
+
+	dns_diff_clear(&full);
+	dns_diff_clear(&diff);
+	dns_db_detach(&newdb);
+	dns_db_detach(&olddb);
+}
+
+/* dns_loaddiff_diff of identical content */
+ISC_RUN_TEST_IMPL(loaddiff_same) {
+	UNUSED(state);
+
+	test_loaddiff(TESTS_DIR "/testdata/diff/zone1.data",
+		      TESTS_DIR "/testdata/diff/zone1.data", 0);
+}
+
+/* dns_loaddiff_diff of zone with a name added out of order */
+ISC_RUN_TEST_IMPL(loaddiff_add) {
+	UNUSED(state);
+
+	test_loaddiff(TESTS_DIR "/testdata/diff/zone1.data",
+		      TESTS_DIR "/testdata/diff/zone2.data", 1);
+}
+
+/* dns_loaddiff_diff of zone with a name removed */
+ISC_RUN_TEST_IMPL(loaddiff_remove) {
+	UNUSED(state);
+
+	test_loaddiff(TESTS_DIR "/testdata/diff/zone1.data",
+		      TESTS_DIR "/testdata/diff/zone3.data", 1);
+}
+
+/* dns_loaddiff_diff of zone with records added, changed and replaced */
+ISC_RUN_TEST_IMPL(loaddiff_change) {
+	UNUSED(state);
+
+	test_loaddiff(TESTS_DIR "/testdata/diff/zone1.data",
+		      TESTS_DIR "/testdata/diff/zone4.data", 6);
+	test_loaddiff(TESTS_DIR "/testdata/diff/zone4.data",
+		      TESTS_DIR "/testdata/diff/zone1.data", 6);
+}
+
+/*
+ * dns_loaddiff_diff of zone loaded out of order with a name removed,
+ * which has to fall back to comparing every name
+ */
+ISC_RUN_TEST_IMPL(loaddiff_unsorted) {
+	UNUSED(state);
+
+	test_loaddiff(TESTS_DIR "/testdata/diff/zone1.data",
+		      TESTS_DIR "/testdata/diff/zone5.data", 4);
+}
+
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY(diffx_same)
 ISC_TEST_ENTRY(diffx_add)
 ISC_TEST_ENTRY(diffx_remove)
+ISC_TEST_ENTRY(loaddiff_same)
+ISC_TEST_ENTRY(loaddiff_add)
+ISC_TEST_ENTRY(loaddiff_remove)
+ISC_TEST_ENTRY(loaddiff_change)
+ISC_TEST_ENTRY(loaddiff_unsorted)
 ISC_TEST_LIST_END
 
 ISC_TEST_MAIN
@@ -492,7 +492,7 @@ connected_gettcp(isc_result_t eresult ISC_ATTR_UNUSED,
 	};
 
 	result = dns_dispatch_gettcp(test2->dispatchmgr, &tcp_server_addr,
-				     &tcp_connect_addr, &test2->dispatch);
+				     &tcp_connect_addr, NULL, &test2->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	assert_ptr_equal(test1->dispatch, test2->dispatch);
@@ -521,11 +521,11 @@ connected_newtcp(isc_result_t eresult ISC_ATTR_UNUSED,
 		.dispatchmgr = dns_dispatchmgr_ref(test3->dispatchmgr),
 	};
 	result = dns_dispatch_gettcp(test4->dispatchmgr, &tcp_server_addr,
-				     &tcp_connect_addr, &test4->dispatch);
+				     &tcp_connect_addr, NULL, &test4->dispatch);
 	assert_int_equal(result, ISC_R_NOTFOUND);
 
 	result = dns_dispatch_createtcp(
-		test4->dispatchmgr, &tcp_connect_addr, &tcp_server_addr,
+		test4->dispatchmgr, &tcp_connect_addr, &tcp_server_addr, NULL,
 		DNS_DISPATCHOPT_UNSHARED, &test4->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
@@ -543,6 +543,44 @@ connected_newtcp(isc_result_t eresult ISC_ATTR_UNUSED,
 	test_dispatch_done(test3);
 }
 
+static void
+connected_keepalive(isc_result_t eresult ISC_ATTR_UNUSED,
+		    isc_region_t *region ISC_ATTR_UNUSED, void *arg) {
+	test_dispatch_t *test5 = arg;
+	dns_dispatch_t *disp = test5->dispatch;
+
+	/* Client 2 - joins the idle connection */
+	isc_result_t result;
+	test_dispatch_t *test6 = isc_mem_get(mctx, sizeof(*test6));
+	*test6 = (test_dispatch_t){
+		.dispatchmgr = dns_dispatchmgr_ref(test5->dispatchmgr),
+	};
+
+	/* The connection stays open after its only query is done */
+	test_dispatch_done(test5);
+
+	/* A different transport doesn't share the connection */
+	result = dns_dispatch_gettcp(test6->dispatchmgr, &tcp_server_addr,
+				     &tcp_connect_addr, tls_transport,
+				     &test6->dispatch);
+	assert_int_equal(result, ISC_R_NOTFOUND);
+
+	result = dns_dispatch_gettcp(test6->dispatchmgr, &tcp_server_addr,
+				     &tcp_connect_addr, NULL, &test6->dispatch);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	assert_ptr_equal(disp, test6->dispatch);
+
+	result = dns_dispatch_add(test6->dispatch, isc_loop_main(loopmgr), 0,
+				  T_CLIENT_CONNECT, &tcp_server_addr, NULL,
+				  NULL, connected_shutdown, client_senddone,
+				  response_noop, test6, &test6->id,
+				  &test6->dispentry);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	dns_dispatch_connect(test6->dispentry);
+}
+
 static void
 timeout_connected(isc_result_t eresult, isc_region_t *region ISC_ATTR_UNUSED,
 		  void *arg) {
@@ -574,7 +612,8 @@ ISC_LOOP_TEST_IMPL(dispatch_timeout_tcp_connect) {
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_createtcp(test->dispatchmgr, &tcp_connect_addr,
-					&tcp_server_addr, 0, &test->dispatch);
+					&tcp_server_addr, NULL, 0,
+					&test->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_add(test->dispatch, isc_loop_main(loopmgr), 0,
@@ -619,7 +658,8 @@ ISC_LOOP_TEST_IMPL(dispatch_timeout_tcp_response) {
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_createtcp(test->dispatchmgr, &tcp_connect_addr,
-					&tcp_server_addr, 0, &test->dispatch);
+					&tcp_server_addr, NULL, 0,
+					&test->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_add(
@@ -653,7 +693,8 @@ ISC_LOOP_TEST_IMPL(dispatch_tcp_response) {
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_createtcp(test->dispatchmgr, &tcp_connect_addr,
-					&tcp_server_addr, 0, &test->dispatch);
+					&tcp_server_addr, NULL, 0,
+					&test->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_add(
@@ -690,7 +731,8 @@ ISC_LOOP_TEST_IMPL(dispatch_tls_response) {
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_createtcp(test->dispatchmgr, &tls_connect_addr,
-					&tls_server_addr, 0, &test->dispatch);
+					&tls_server_addr, tls_transport, 0,
+					&test->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_add(test->dispatch, isc_loop_main(loopmgr), 0,
@@ -794,7 +836,8 @@ ISC_LOOP_TEST_IMPL(dispatch_gettcp) {
 
 	/* Client */
 	result = dns_dispatch_createtcp(test->dispatchmgr, &tcp_connect_addr,
-					&tcp_server_addr, 0, &test->dispatch);
+					&tcp_server_addr, NULL, 0,
+					&test->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_add(
@@ -826,7 +869,7 @@ ISC_LOOP_TEST_IMPL(dispatch_newtcp) {
 	assert_int_equal(result, ISC_R_SUCCESS);
 
 	result = dns_dispatch_createtcp(
-		test->dispatchmgr, &tcp_connect_addr, &tcp_server_addr,
+		test->dispatchmgr, &tcp_connect_addr, &tcp_server_addr, NULL,
 		DNS_DISPATCHOPT_UNSHARED, &test->dispatch);
 	assert_int_equal(result, ISC_R_SUCCESS);
 
@@ -839,9 +882,44 @@ ISC_LOOP_TEST_IMPL(dispatch_newtcp) {
 	dns_dispatch_connect(test->dispentry);
 }
 
+ISC_LOOP_TEST_IMPL(dispatch_keepalive) {
+	isc_result_t result;
+	test_dispatch_t *test = isc_mem_get(mctx, sizeof(*test));
+	*test = (test_dispatch_t){ 0 };
+
+	/* Server */
+	result = isc_nm_listenstreamdns(netmgr, ISC_NM_LISTEN_ONE,
+					&tcp_server_addr, nameserver, NULL,
+					accept_cb, NULL, 0, NULL, NULL, &sock);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	/* ensure we stop listening after the test is done */
+	isc_loop_teardown(isc_loop_main(loopmgr), stop_listening, sock);
+
+	result = dns_dispatchmgr_create(mctx, loopmgr, connect_nm,
+					&test->dispatchmgr);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	/* Client - kept alive */
+	result = dns_dispatch_createtcp(
+		test->dispatchmgr, &tcp_connect_addr, &tcp_server_addr, NULL,
+		DNS_DISPATCHOPT_KEEPALIVE, &test->dispatch);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_dispatch_add(
+		test->dispatch, isc_loop_main(loopmgr), 0, T_CLIENT_CONNECT,
+		&tcp_server_addr, NULL, NULL, connected_keepalive,
+		client_senddone, response_noop, test, &test->id,
+		&test->dispentry);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	dns_dispatch_connect(test->dispentry);
+}
+
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY_CUSTOM(dispatch_gettcp, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatch_newtcp, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(dispatch_keepalive, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatch_timeout_udp_response, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatchset_create, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(dispatchset_get, setup_test, teardown_test)
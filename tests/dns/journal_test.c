@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#include <inttypes.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/file.h>
+#include <isc/util.h>
+
+#include <dns/diff.h>
+#include <dns/journal.h>
+
+#include <tests/dns.h>
+
+#define JOURNAL	    "journal_test.jnl"
+#define JOURNAL_NEW "journal_test.jnw"
+
+static int
+setup_test(void **state) {
+	UNUSED(state);
+
+	(void)isc_file_remove(JOURNAL);
+	(void)isc_file_remove(JOURNAL_NEW);
+
+	return (0);
+}
+
+static int
+teardown_test(void **state) {
+	UNUSED(state);
+
+	(void)isc_file_remove(JOURNAL);
+	(void)isc_file_remove(JOURNAL_NEW);
+
+	return (0);
+}
+
+/*
+ * Append a transaction for each serial number from 'from' to 'to' - 1,
+ * each adding an address record.
+ */
+static void
+write_transactions(uint32_t from, uint32_t to) {
+	dns_journal_t *journal = NULL;
+	isc_result_t result;
+
+	result = dns_journal_open(mctx, JOURNAL,
+				  DNS_JOURNAL_CREATE | DNS_JOURNAL_WRITE,
+				  &journal);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	for (uint32_t serial = from; serial < to; serial++) {
+		char oldsoa[100], newsoa[100], owner[100], addr[100];
+		zonechange_t changes[] = {
+			{ DNS_DIFFOP_DEL, "test.", 3600, "SOA", oldsoa },
+			{ DNS_DIFFOP_ADD, "test.", 3600, "SOA", newsoa },
+			{ DNS_DIFFOP_ADD, owner, 3600, "A", addr },
+			ZONECHANGE_SENTINEL,
+		};
+		dns_diff_t diff;
+
+		snprintf(oldsoa, sizeof(oldsoa),
+			 "ns.test. hostmaster.test. %u 3600 600 86400 60",
+			 serial);
+		snprintf(newsoa, sizeof(newsoa),
+			 "ns.test. hostmaster.test. %u 3600 600 86400 60",
+			 serial + 1);
+		snprintf(owner, sizeof(owner), "host%u.test.", serial);
+		snprintf(addr, sizeof(addr), "10.0.%u.%u", (serial >> 8) & 0xff,
+			 serial & 0xff);
+
+		result = dns_test_difffromchanges(&diff, changes, false);
+		assert_int_equal(result, ISC_R_SUCCESS);
+
+		result = dns_journal_write_transaction(journal, &diff);
+		assert_int_equal(result, ISC_R_SUCCESS);
+
+		dns_diff_clear(&diff);
+	}
+
+	dns_journal_destroy(&journal);
+}
+
+/*
+ * Check that the journal runs from a serial number no later than
+ * 'first' to 'last', and that every transaction in it can be read.
+ * Returns the first serial number in the journal.
+ */
+static uint32_t
+check_journal(uint32_t first, uint32_t last) {
+	dns_journal_t *journal = NULL;
+	isc_result_t result;
+	uint32_t begin;
+	size_t n = 0;
+
+	result = dns_journal_open(mctx, JOURNAL, DNS_JOURNAL_READ, &journal);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	begin = dns_journal_first_serial(journal);
+	assert_true(begin <= first);
+	assert_int_equal(dns_journal_last_serial(journal), last);
+
+	result = dns_journal_iter_init(journal, begin, last, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	for (result = dns_journal_first_rr(journal); result == ISC_R_SUCCESS;
+	     result = dns_journal_next_rr(journal))
+	{
+		n++;
+	}
+	assert_int_equal(result, ISC_R_NOMORE);
+
+	/* Two SOA records and an address record per transaction */
+	assert_int_equal(n, 3 * (last - begin));
+
+	dns_journal_destroy(&journal);
+
+	return (begin);
+}
+
+/* Transactions added while the journal is being compacted are kept */
+ISC_RUN_TEST_IMPL(compact_background) {
+	dns_journalcompact_t *jc = NULL;
+	isc_nanosecs_t elapsed = 0;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	write_transactions(1, 200);
+
+	result = dns_journal_compact_begin(mctx, JOURNAL, 150, 4096, &jc);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(jc);
+	assert_true(isc_file_exists(JOURNAL_NEW));
+
+	write_transactions(200, 220);
+
+	result = dns_journal_compact_finish(&jc, &elapsed);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_null(jc);
+	assert_true(elapsed > 0);
+	assert_false(isc_file_exists(JOURNAL_NEW));
+
+	assert_true(check_journal(150, 220) > 1);
+
+	/* The compacted journal can still be written to */
+	write_transactions(220, 230);
+	(void)check_journal(150, 230);
+}
+
+/* A journal smaller than the target size is left alone */
+ISC_RUN_TEST_IMPL(compact_small) {
+	dns_journalcompact_t *jc = NULL;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	write_transactions(1, 10);
+
+	result = dns_journal_compact_begin(mctx, JOURNAL, 5, 1024 * 1024, &jc);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_null(jc);
+	assert_false(isc_file_exists(JOURNAL_NEW));
+
+	result = dns_journal_compact_begin(mctx, JOURNAL, 20, 1024, &jc);
+	assert_int_equal(result, ISC_R_RANGE);
+	assert_null(jc);
+
+	assert_int_equal(check_journal(1, 10), 1);
+}
+
+/* A journal replaced while it is being compacted is not overwritten */
+ISC_RUN_TEST_IMPL(compact_replaced) {
+	dns_journalcompact_t *jc = NULL;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	write_transactions(1, 200);
+
+	result = dns_journal_compact_begin(mctx, JOURNAL, 150, 4096, &jc);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(jc);
+
+	assert_int_equal(isc_file_remove(JOURNAL), ISC_R_SUCCESS);
+	write_transactions(1000, 1010);
+
+	result = dns_journal_compact_finish(&jc, NULL);
+	assert_int_equal(result, ISC_R_CANCELED);
+	assert_null(jc);
+	assert_false(isc_file_exists(JOURNAL_NEW));
+
+	assert_int_equal(check_journal(1000, 1010), 1000);
+}
+
+/* Cancelling a compaction leaves the journal as it was */
+ISC_RUN_TEST_IMPL(compact_cancel) {
+	dns_journalcompact_t *jc = NULL;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	write_transactions(1, 200);
+
+	result = dns_journal_compact_begin(mctx, JOURNAL, 150, 4096, &jc);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_non_null(jc);
+
+	dns_journal_compact_cancel(&jc);
+	assert_null(jc);
+	assert_false(isc_file_exists(JOURNAL_NEW));
+
+	assert_int_equal(check_journal(1, 200), 1);
+}
+
+ISC_TEST_LIST_START
+
+ISC_TEST_ENTRY_CUSTOM(compact_background, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(compact_small, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(compact_replaced, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(compact_cancel, setup_test, teardown_test)
+
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#include <inttypes.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/buffer.h>
+#include <isc/result.h>
+#include <isc/util.h>
+
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/rdataset.h>
+
+#include <tests/dns.h>
+
+/*
+ * IXFR query for "example." carrying the client's SOA in the
+ * authority section.
+ */
+static const unsigned char ixfr_query[] = {
+	/* header: id 0x1234, QD 1, AN 0, NS 1, AR 0 */
+	0x12, 0x34, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x00,
+	0x00,
+	/* question: example. IXFR IN */
+	0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x00, 0x00, 0xfb, 0x00,
+	0x01,
+	/* authority: example. SOA IN 0 */
+	0xc0, 0x0c, 0x00, 0x06, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x20,
+	/* ns.example. root.example. 1 3600 1800 604800 3600 */
+	0x02, 'n', 's', 0xc0, 0x0c, 0x04, 'r', 'o', 'o', 't', 0xc0, 0x0c,
+	0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x0e, 0x10, 0x00, 0x00, 0x07,
+	0x08, 0x00, 0x09, 0x3a, 0x80, 0x00, 0x00, 0x0e, 0x10
+};
+
+/*
+ * Query for "example." A with glue for "ns.example." and an OPT record
+ * in the additional section.
+ */
+static const unsigned char glue_query[] = {
+	/* header: id 0x1234, QD 1, AN 0, NS 0, AR 2 */
+	0x12, 0x34, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x02,
+	/* question: example. A IN */
+	0x07, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x00, 0x00, 0x01, 0x00,
+	0x01,
+	/* additional: ns.example. A IN 300 192.0.2.1 */
+	0x02, 'n', 's', 0xc0, 0x0c, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00,
+	0x01, 0x2c, 0x00, 0x04, 0xc0, 0x00, 0x02, 0x01,
+	/* additional: . OPT 1232 */
+	0x00, 0x00, 0x29, 0x04, 0xd0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+static isc_result_t
+parse(dns_message_t *msg, const unsigned char *data, size_t size,
+      unsigned int options) {
+	isc_buffer_t source;
+
+	isc_buffer_constinit(&source, data, size);
+	isc_buffer_add(&source, size);
+
+	return (dns_message_parse(msg, &source, options));
+}
+
+/* deferred sections are built on first access */
+ISC_RUN_TEST_IMPL(lazy_parse) {
+	dns_message_t *msg = NULL;
+	dns_name_t *name = NULL, *qname = NULL;
+	dns_rdataset_t *rdataset = NULL;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTPARSE, &msg);
+
+	result = parse(msg, ixfr_query, sizeof(ixfr_query),
+		       DNS_MESSAGEPARSE_LAZY);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 1);
+	assert_int_equal(msg->counts[DNS_SECTION_AUTHORITY], 1);
+	assert_true(ISC_LIST_EMPTY(msg->sections[DNS_SECTION_AUTHORITY]));
+
+	result = dns_message_firstname(msg, DNS_SECTION_AUTHORITY);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 0);
+
+	dns_message_currentname(msg, DNS_SECTION_AUTHORITY, &name);
+	result = dns_message_firstname(msg, DNS_SECTION_QUESTION);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	dns_message_currentname(msg, DNS_SECTION_QUESTION, &qname);
+	assert_true(dns_name_equal(name, qname));
+	rdataset = ISC_LIST_HEAD(name->list);
+	assert_non_null(rdataset);
+	assert_int_equal(rdataset->type, dns_rdatatype_soa);
+	assert_int_equal(dns_rdataset_count(rdataset), 1);
+
+	dns_message_detach(&msg);
+}
+
+/* a malformed deferred section is still rejected by the parse */
+ISC_RUN_TEST_IMPL(lazy_truncated) {
+	dns_message_t *msg = NULL;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTPARSE, &msg);
+
+	result = parse(msg, ixfr_query, sizeof(ixfr_query) - 4, 0);
+	assert_int_equal(result, ISC_R_UNEXPECTEDEND);
+
+	dns_message_reset(msg, DNS_MESSAGE_INTENTPARSE);
+
+	result = parse(msg, ixfr_query, sizeof(ixfr_query) - 4,
+		       DNS_MESSAGEPARSE_LAZY);
+	assert_int_equal(result, ISC_R_UNEXPECTEDEND);
+	assert_int_equal(msg->lazy_pending, 0);
+
+	dns_message_detach(&msg);
+}
+
+/* replying discards deferred sections without building them */
+ISC_RUN_TEST_IMPL(lazy_reply) {
+	dns_message_t *msg = NULL;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTPARSE, &msg);
+
+	result = parse(msg, ixfr_query, sizeof(ixfr_query),
+		       DNS_MESSAGEPARSE_LAZY);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 1);
+
+	result = dns_message_reply(msg, true);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 0);
+
+	result = dns_message_firstname(msg, DNS_SECTION_QUESTION);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = dns_message_firstname(msg, DNS_SECTION_AUTHORITY);
+	assert_int_equal(result, ISC_R_NOMORE);
+
+	dns_message_detach(&msg);
+}
+
+/* the OPT record is parsed up front, the other additional data is deferred */
+ISC_RUN_TEST_IMPL(lazy_additional) {
+	dns_message_t *msg = NULL;
+	dns_name_t *name = NULL;
+	dns_rdataset_t *rdataset = NULL;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTPARSE, &msg);
+
+	result = parse(msg, glue_query, sizeof(glue_query),
+		       DNS_MESSAGEPARSE_LAZY);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 1);
+	assert_int_equal(msg->lazy_additional, 1);
+	assert_non_null(dns_message_getopt(msg));
+	assert_true(ISC_LIST_EMPTY(msg->sections[DNS_SECTION_ADDITIONAL]));
+
+	result = dns_message_firstname(msg, DNS_SECTION_ADDITIONAL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 0);
+	assert_int_equal(msg->counts[DNS_SECTION_ADDITIONAL], 2);
+
+	dns_message_currentname(msg, DNS_SECTION_ADDITIONAL, &name);
+	rdataset = ISC_LIST_HEAD(name->list);
+	assert_non_null(rdataset);
+	assert_int_equal(rdataset->type, dns_rdatatype_a);
+	result = dns_message_nextname(msg, DNS_SECTION_ADDITIONAL);
+	assert_int_equal(result, ISC_R_NOMORE);
+
+	dns_message_detach(&msg);
+}
+
+/* a query with only an OPT record has nothing left to defer */
+ISC_RUN_TEST_IMPL(lazy_optonly) {
+	dns_message_t *msg = NULL;
+	unsigned char data[sizeof(glue_query)];
+	size_t qlen = 12 + 13, glen = 19;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	/* drop the glue record and set ARCOUNT to 1 */
+	memmove(data, glue_query, qlen);
+	memmove(data + qlen, glue_query + qlen + glen,
+		sizeof(glue_query) - qlen - glen);
+	data[11] = 0x01;
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTPARSE, &msg);
+
+	result = parse(msg, data, sizeof(glue_query) - glen,
+		       DNS_MESSAGEPARSE_LAZY);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 0);
+	assert_non_null(dns_message_getopt(msg));
+
+	result = dns_message_firstname(msg, DNS_SECTION_ADDITIONAL);
+	assert_int_equal(result, ISC_R_NOMORE);
+
+	dns_message_detach(&msg);
+}
+
+/* names are skipped without being decompressed */
+ISC_RUN_TEST_IMPL(lazy_badpointer) {
+	dns_message_t *msg = NULL;
+	unsigned char data[sizeof(glue_query)];
+	isc_result_t result;
+
+	UNUSED(state);
+
+	/* point the glue owner name past the end of the message */
+	memmove(data, glue_query, sizeof(data));
+	data[29] = 0xff;
+
+	dns_message_create(mctx, NULL, NULL, DNS_MESSAGE_INTENTPARSE, &msg);
+
+	result = parse(msg, data, sizeof(data), 0);
+	assert_int_not_equal(result, ISC_R_SUCCESS);
+
+	dns_message_reset(msg, DNS_MESSAGE_INTENTPARSE);
+
+	result = parse(msg, data, sizeof(data), DNS_MESSAGEPARSE_LAZY);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(msg->lazy_pending, 1);
+
+	result = dns_message_firstname(msg, DNS_SECTION_ADDITIONAL);
+	assert_int_not_equal(result, ISC_R_SUCCESS);
+
+	dns_message_detach(&msg);
+}
+
+ISC_TEST_LIST_START
+ISC_TEST_ENTRY(lazy_parse)
+ISC_TEST_ENTRY(lazy_truncated)
+ISC_TEST_ENTRY(lazy_reply)
+ISC_TEST_ENTRY(lazy_additional)
+ISC_TEST_ENTRY(lazy_optonly)
+ISC_TEST_ENTRY(lazy_badpointer)
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN
@@ -147,9 +147,64 @@ ISC_RUN_TEST_IMPL(nsec3param_salttotext) {
 	}
 }
 
+/* check the NSEC3 hash cache */
+ISC_RUN_TEST_IMPL(nsec3cache) {
+	/* RFC 5155, Appendix A */
+	const unsigned char salt[] = { 0xaa, 0xbb, 0xcc, 0xdd };
+	dns_nsec3cache_t *cache = NULL;
+	dns_fixedname_t fname, forigin, fexpected, fhashed;
+	dns_name_t *name = NULL, *origin = NULL, *expected = NULL;
+	dns_name_t *hashed = NULL;
+	bool hit = true;
+	isc_result_t result;
+
+	UNUSED(state);
+
+	dns_test_namefromstring("a.example.", &fname);
+	dns_test_namefromstring("example.", &forigin);
+	dns_test_namefromstring("35mthgpgcu1qg68fab165klnsnk3dpvl.example.",
+				&fexpected);
+	name = dns_fixedname_name(&fname);
+	origin = dns_fixedname_name(&forigin);
+	expected = dns_fixedname_name(&fexpected);
+
+	dns_nsec3cache_create(mctx, 4, &cache);
+	assert_non_null(cache);
+
+	/* The first lookup computes the hash... */
+	result = dns_nsec3cache_hashname(cache, &fhashed, name, origin, 1, 12,
+					 salt, sizeof(salt), &hit);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_false(hit);
+	hashed = dns_fixedname_name(&fhashed);
+	assert_true(dns_name_equal(hashed, expected));
+
+	/* ...the next one finds it in the cache, regardless of case... */
+	dns_test_namefromstring("A.EXAMPLE.", &fname);
+	name = dns_fixedname_name(&fname);
+	result = dns_nsec3cache_hashname(cache, &fhashed, name, origin, 1, 12,
+					 salt, sizeof(salt), &hit);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_true(hit);
+	hashed = dns_fixedname_name(&fhashed);
+	assert_true(dns_name_equal(hashed, expected));
+
+	/* ...but not when the NSEC3 parameters change. */
+	result = dns_nsec3cache_hashname(cache, &fhashed, name, origin, 1, 13,
+					 salt, sizeof(salt), &hit);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_false(hit);
+	hashed = dns_fixedname_name(&fhashed);
+	assert_false(dns_name_equal(hashed, expected));
+
+	dns_nsec3cache_destroy(&cache);
+	assert_null(cache);
+}
+
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY(max_iterations)
 ISC_TEST_ENTRY(nsec3param_salttotext)
+ISC_TEST_ENTRY(nsec3cache)
 ISC_TEST_LIST_END
 
 ISC_TEST_MAIN
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+
+#include <inttypes.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/stats.h>
+#include <isc/util.h>
+
+#include <dns/db.h>
+#include <dns/dlz.h>
+#include <dns/fixedname.h>
+#include <dns/name.h>
+#include <dns/rdata.h>
+#include <dns/rdataset.h>
+#include <dns/sdlz.h>
+#include <dns/stats.h>
+
+#include <tests/dns.h>
+
+#define DRIVERNAME "sdlztest"
+
+static dns_sdlzimplementation_t *sdlzimp = NULL;
+static dns_dlzdb_t *dlzdb = NULL;
+static dns_db_t *db = NULL;
+
+static unsigned int lookups = 0;
+static isc_result_t metatype_result, extradata_result, short_result;
+
+static const unsigned char a_wire[] = { 10, 53, 0, 1 };
+
+static isc_result_t
+test_create(const char *dlzname, unsigned int argc, char *argv[],
+	    void *driverarg, void **dbdata) {
+	UNUSED(dlzname);
+	UNUSED(argc);
+	UNUSED(argv);
+	UNUSED(driverarg);
+
+	*dbdata = &lookups;
+	return (ISC_R_SUCCESS);
+}
+
+static void
+test_destroy(void *driverarg, void *dbdata) {
+	UNUSED(driverarg);
+	UNUSED(dbdata);
+}
+
+static isc_result_t
+test_findzone(void *driverarg, void *dbdata, const char *name,
+	      dns_clientinfomethods_t *methods, dns_clientinfo_t *clientinfo) {
+	UNUSED(driverarg);
+	UNUSED(dbdata);
+	UNUSED(methods);
+	UNUSED(clientinfo);
+
+	if (strcmp(name, "example.com") == 0) {
+		return (ISC_R_SUCCESS);
+	}
+	return (ISC_R_NOTFOUND);
+}
+
+static isc_result_t
+test_lookup(const char *zone, const char *name, void *driverarg,
+	    void *dbdata, dns_sdlzlookup_t *lookup,
+	    dns_clientinfomethods_t *methods, dns_clientinfo_t *clientinfo) {
+	unsigned int *count = dbdata;
+
+	UNUSED(zone);
+	UNUSED(driverarg);
+	UNUSED(methods);
+	UNUSED(clientinfo);
+
+	(*count)++;
+
+	if (strcmp(name, "www.example.com") == 0) {
+		return (dns_sdlz_putrdata(lookup, dns_rdatatype_a, 300,
+					  a_wire, sizeof(a_wire)));
+	}
+
+	if (strcmp(name, "zero.example.com") == 0) {
+		return (dns_sdlz_putrr(lookup, "A", 0, "10.53.0.2"));
+	}
+
+	if (strcmp(name, "bad.example.com") == 0) {
+		static const unsigned char long_wire[] = { 10, 53, 0, 1, 0 };
+
+		metatype_result = dns_sdlz_putrdata(lookup, dns_rdatatype_any,
+						    300, a_wire,
+						    sizeof(a_wire));
+		extradata_result = dns_sdlz_putrdata(lookup, dns_rdatatype_a,
+						     300, long_wire,
+						     sizeof(long_wire));
+		short_result = dns_sdlz_putrdata(lookup, dns_rdatatype_a, 300,
+						 a_wire, 3);
+		return (dns_sdlz_putrr(lookup, "A", 300, "10.53.0.3"));
+	}
+
+	return (ISC_R_NOTFOUND);
+}
+
+static dns_sdlzmethods_t test_methods = {
+	.create = test_create,
+	.destroy = test_destroy,
+	.findzone = test_findzone,
+	.lookup = test_lookup,
+};
+
+static int
+setup_test(void **state) {
+	isc_result_t result;
+	char *argv[] = { UNCONST(DRIVERNAME) };
+
+	UNUSED(state);
+
+	lookups = 0;
+
+	result = dns_sdlzregister(DRIVERNAME, &test_methods, NULL,
+				  DNS_SDLZFLAG_THREADSAFE, mctx, &sdlzimp);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dns_dlzcreate(mctx, "test", DRIVERNAME, 1, argv, &dlzdb);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	return (0);
+}
+
+static int
+teardown_test(void **state) {
+	UNUSED(state);
+
+	if (db != NULL) {
+		dns_db_detach(&db);
+	}
+	dns_dlzdestroy(&dlzdb);
+	dns_sdlzunregister(&sdlzimp);
+
+	return (0);
+}
+
+static void
+findzone(void) {
+	dns_fixedname_t fixed;
+	dns_name_t *name = dns_fixedname_initname(&fixed);
+	isc_result_t result;
+
+	result = dns_name_fromstring(name, "example.com", dns_rootname, 0,
+				     NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	result = dlzdb->implementation->methods->findzone(
+		dlzdb->implementation->driverarg, dlzdb->dbdata, mctx,
+		dns_rdataclass_in, name, NULL, NULL, &db);
+	assert_int_equal(result, ISC_R_SUCCESS);
+}
+
+static isc_result_t
+lookup_a(const char *namestr, dns_rdata_t *rdata) {
+	dns_fixedname_t fixed, ffound;
+	dns_name_t *name = dns_fixedname_initname(&fixed);
+	dns_name_t *found = dns_fixedname_initname(&ffound);
+	dns_rdataset_t rdataset;
+	dns_dbnode_t *node = NULL;
+	isc_result_t result;
+
+	result = dns_name_fromstring(name, namestr, dns_rootname, 0, NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	dns_rdataset_init(&rdataset);
+	result = dns_db_find(db, name, NULL, dns_rdatatype_a, 0, 0, &node,
+			     found, &rdataset, NULL);
+	if (result == ISC_R_SUCCESS && rdata != NULL) {
+		assert_int_equal(dns_rdataset_count(&rdataset), 1);
+		assert_int_equal(dns_rdataset_first(&rdataset),
+				 ISC_R_SUCCESS);
+		dns_rdataset_current(&rdataset, rdata);
+	}
+	if (dns_rdataset_isassociated(&rdataset)) {
+		dns_rdataset_disassociate(&rdataset);
+	}
+	if (node != NULL) {
+		dns_db_detachnode(db, &node);
+	}
+
+	return (result);
+}
+
+/* repeated lookups of a name are answered from the DLZ answer cache */
+ISC_RUN_TEST_IMPL(cache) {
+	isc_result_t result;
+	isc_stats_t *stats = NULL;
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+	unsigned int count;
+
+	result = dns_sdlz_setcache(dlzdb, 3600, 16);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	stats = dns_sdlz_getcachestats(dlzdb);
+	assert_non_null(stats);
+
+	findzone();
+
+	/* Positive answer, supplied in wire format. */
+	result = lookup_a("www.example.com", &rdata);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(rdata.length, sizeof(a_wire));
+	assert_memory_equal(rdata.data, a_wire, sizeof(a_wire));
+	count = lookups;
+	assert_true(count > 0);
+	assert_int_equal(isc_stats_get_counter(
+				 stats, dns_dlzcachestatscounter_hits),
+			 0);
+
+	dns_rdata_reset(&rdata);
+	result = lookup_a("www.example.com", &rdata);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_memory_equal(rdata.data, a_wire, sizeof(a_wire));
+	assert_int_equal(lookups, count);
+	assert_true(isc_stats_get_counter(stats,
+					  dns_dlzcachestatscounter_hits) > 0);
+
+	/* Negative answer. */
+	result = lookup_a("nx.example.com", NULL);
+	assert_int_equal(result, DNS_R_NXDOMAIN);
+	assert_true(lookups > count);
+	count = lookups;
+
+	result = lookup_a("nx.example.com", NULL);
+	assert_int_equal(result, DNS_R_NXDOMAIN);
+	assert_int_equal(lookups, count);
+
+	/* Records with a zero TTL are not cached. */
+	result = lookup_a("zero.example.com", NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_true(lookups > count);
+	count = lookups;
+
+	result = lookup_a("zero.example.com", NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_true(lookups > count);
+
+	assert_true(isc_stats_get_counter(
+			    stats, dns_dlzcachestatscounter_inserts) >= 2);
+	assert_int_equal(isc_stats_get_counter(
+				 stats, dns_dlzcachestatscounter_evictions),
+			 0);
+}
+
+/* without cache-ttl every lookup reaches the driver */
+ISC_RUN_TEST_IMPL(nocache) {
+	isc_result_t result;
+	unsigned int count;
+
+	assert_null(dns_sdlz_getcachestats(dlzdb));
+
+	findzone();
+
+	result = lookup_a("www.example.com", NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	count = lookups;
+
+	result = lookup_a("www.example.com", NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_true(lookups > count);
+}
+
+/* a full cache evicts its oldest entry */
+ISC_RUN_TEST_IMPL(evict) {
+	isc_result_t result;
+	isc_stats_t *stats = NULL;
+	unsigned int count;
+
+	result = dns_sdlz_setcache(dlzdb, 3600, 1);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	stats = dns_sdlz_getcachestats(dlzdb);
+
+	findzone();
+
+	result = lookup_a("www.example.com", NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	result = lookup_a("nx.example.com", NULL);
+	assert_int_equal(result, DNS_R_NXDOMAIN);
+	assert_true(isc_stats_get_counter(
+			    stats, dns_dlzcachestatscounter_evictions) > 0);
+
+	count = lookups;
+	result = lookup_a("www.example.com", NULL);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_true(lookups > count);
+}
+
+/* malformed wire format data is rejected by dns_sdlz_putrdata() */
+ISC_RUN_TEST_IMPL(putrdata) {
+	isc_result_t result;
+	dns_rdata_t rdata = DNS_RDATA_INIT;
+
+	findzone();
+
+	metatype_result = extradata_result = short_result = ISC_R_SUCCESS;
+	result = lookup_a("bad.example.com", &rdata);
+	assert_int_equal(result, ISC_R_SUCCESS);
+	assert_int_equal(metatype_result, DNS_R_METATYPE);
+	assert_int_equal(extradata_result, DNS_R_EXTRADATA);
+	assert_int_equal(short_result, ISC_R_UNEXPECTEDEND);
+
+	/* Only the record supplied in text form was added. */
+	assert_int_equal(rdata.length, 4);
+}
+
+ISC_TEST_LIST_START
+ISC_TEST_ENTRY_CUSTOM(cache, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(evict, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(nocache, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(putrdata, setup_test, teardown_test)
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN
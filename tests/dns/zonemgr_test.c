@@ -31,6 +31,17 @@
 #include <dns/view.h>
 #include <dns/zone.h>
 
+/*
+ * Include the zone manager itself, so that the refresh queues can be
+ * inspected.
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wshadow"
+#undef CHECK
+#include "zone.c"
+#pragma GCC diagnostic pop
+
+#undef CHECK
 #include <tests/dns.h>
 
 static int
@@ -123,6 +134,147 @@ ISC_LOOP_TEST_IMPL(zonemgr_createzone) {
 	isc_loopmgr_shutdown(loopmgr);
 }
 
+/* refresh batch size and backlog */
+ISC_LOOP_TEST_IMPL(zonemgr_refreshbatch) {
+	dns_zonemgr_t *myzonemgr = NULL;
+	size_t zones, primaries;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, loopmgr, netmgr, &myzonemgr);
+
+	assert_int_equal(dns_zonemgr_getserialquerybatch(myzonemgr), 1);
+	dns_zonemgr_setserialquerybatch(myzonemgr, 16);
+	assert_int_equal(dns_zonemgr_getserialquerybatch(myzonemgr), 16);
+	dns_zonemgr_setserialquerybatch(myzonemgr, 0);
+	assert_int_equal(dns_zonemgr_getserialquerybatch(myzonemgr), 1);
+
+	dns_zonemgr_getrefreshbacklog(myzonemgr, &zones, &primaries);
+	assert_int_equal(zones, 0);
+	assert_int_equal(primaries, 0);
+
+	dns_zonemgr_shutdown(myzonemgr);
+	dns_zonemgr_detach(&myzonemgr);
+	assert_null(myzonemgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+#define BATCH_ZONES 7
+#define BATCH_SIZE  3
+
+static dns_zonemgr_t *batch_zmgr = NULL;
+static dns_view_t *batch_view = NULL;
+static dns_zone_t *batch_zones[BATCH_ZONES];
+static isc_timer_t *batch_timer = NULL;
+
+/*
+ * Check the refresh queue while the ratelimiter drains it: whole batches
+ * are taken off the queue, most urgent zone first, and every batch still
+ * queued has a ratelimiter event waiting for it.
+ */
+static void
+refreshbatch_check(void *arg) {
+	size_t zones, primaries;
+	refreshq_t *q = NULL;
+	struct soaquery *sq = NULL;
+
+	UNUSED(arg);
+
+	dns_zonemgr_getrefreshbacklog(batch_zmgr, &zones, &primaries);
+	assert_true(zones <= BATCH_ZONES);
+	if (zones != 0) {
+		assert_int_equal((BATCH_ZONES - zones) % BATCH_SIZE, 0);
+	}
+	assert_int_equal(primaries, (zones != 0) ? 1 : 0);
+
+	LOCK(&batch_zmgr->refreshlock);
+	assert_int_equal(batch_zmgr->refreshneeded,
+			 (zones + BATCH_SIZE - 1) / BATCH_SIZE);
+	assert_int_equal(batch_zmgr->refreshtokens,
+			 batch_zmgr->refreshneeded);
+	q = isc_heap_element(batch_zmgr->refreshheap, 1);
+	if (zones != 0) {
+		assert_non_null(q);
+		assert_int_equal(q->count, zones);
+		sq = isc_heap_element(q->queries, 1);
+		assert_ptr_equal(sq->zone, batch_zones[BATCH_ZONES - zones]);
+	} else {
+		assert_null(q);
+	}
+	UNLOCK(&batch_zmgr->refreshlock);
+
+	if (zones != 0) {
+		return;
+	}
+
+	isc_timer_destroy(&batch_timer);
+	for (size_t i = 0; i < BATCH_ZONES; i++) {
+		dns_zonemgr_releasezone(batch_zmgr, batch_zones[i]);
+		dns_zone_detach(&batch_zones[i]);
+	}
+	dns_view_detach(&batch_view);
+	dns_zonemgr_shutdown(batch_zmgr);
+	dns_zonemgr_detach(&batch_zmgr);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+/* refresh queries to one primary are sent in batches */
+ISC_LOOP_TEST_IMPL(zonemgr_refreshqueue) {
+	isc_sockaddr_t primary;
+	struct in_addr in;
+	isc_interval_t interval;
+	isc_result_t result;
+
+	UNUSED(arg);
+
+	dns_zonemgr_create(mctx, loopmgr, netmgr, &batch_zmgr);
+	dns_zonemgr_setserialquerybatch(batch_zmgr, BATCH_SIZE);
+
+	/*
+	 * The view has no request manager, so the SOA queries are
+	 * canceled as soon as they are taken off the queue.
+	 */
+	result = dns_test_makeview("view", false, false, &batch_view);
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	in.s_addr = inet_addr("10.53.0.1");
+	isc_sockaddr_fromin(&primary, &in, 5300);
+
+	/*
+	 * Queue the zones least urgent first; the first zone expires
+	 * first.
+	 */
+	for (size_t i = 0; i < BATCH_ZONES; i++) {
+		char name[32];
+		size_t n = BATCH_ZONES - 1 - i;
+
+		snprintf(name, sizeof(name), "zone%zu.example", n);
+		result = dns_test_makezone(name, &batch_zones[n], batch_view,
+					   false);
+		assert_int_equal(result, ISC_R_SUCCESS);
+		dns_zone_settype(batch_zones[n], dns_zone_secondary);
+		result = dns_zonemgr_managezone(batch_zmgr, batch_zones[n]);
+		assert_int_equal(result, ISC_R_SUCCESS);
+		dns_zone_setprimaries(batch_zones[n], &primary, NULL, NULL,
+				      NULL, 1);
+
+		LOCK_ZONE(batch_zones[n]);
+		isc_time_set(&batch_zones[n]->expiretime, 1000 + n, 0);
+		queue_soa_query(batch_zones[n]);
+		UNLOCK_ZONE(batch_zones[n]);
+	}
+
+	/* Nothing has been sent yet */
+	refreshbatch_check(NULL);
+
+	isc_timer_create(isc_loop_main(loopmgr), refreshbatch_check, NULL,
+			 &batch_timer);
+	isc_interval_set(&interval, 0, NS_PER_MS * 5);
+	isc_timer_start(batch_timer, isc_timertype_ticker, &interval);
+}
+
 /* manage and release a zone */
 ISC_LOOP_TEST_IMPL(zonemgr_unreachable) {
 	dns_zonemgr_t *myzonemgr = NULL;
@@ -191,6 +343,8 @@ ISC_TEST_LIST_START
 ISC_TEST_ENTRY_CUSTOM(zonemgr_create, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(zonemgr_managezone, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(zonemgr_createzone, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_refreshbatch, setup_test, teardown_test)
+ISC_TEST_ENTRY_CUSTOM(zonemgr_refreshqueue, setup_test, teardown_test)
 ISC_TEST_ENTRY_CUSTOM(zonemgr_unreachable, setup_test, teardown_test)
 ISC_TEST_LIST_END
 
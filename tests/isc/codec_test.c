@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#include <inttypes.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/base32.h>
+#include <isc/base64.h>
+#include <isc/buffer.h>
+#include <isc/hex.h>
+#include <isc/random.h>
+#include <isc/simd.h>
+#include <isc/util.h>
+
+#include <tests/isc.h>
+
+/* Long enough for several blocks of the widest vector implementation */
+#define DATALEN 300
+
+typedef isc_result_t
+totext_fn(isc_region_t *source, int wordlength, const char *wordbreak,
+	  isc_buffer_t *target);
+
+typedef isc_result_t
+decode_fn(const char *cstr, isc_buffer_t *target);
+
+static const struct {
+	const char *data;
+	const char *base64;
+	const char *base32hex;
+	const char *hex;
+} vectors[] = {
+	/* RFC 4648 */
+	{ "", "", "", "" },
+	{ "f", "Zg==", "CO======", "66" },
+	{ "fo", "Zm8=", "CPNG====", "666F" },
+	{ "foo", "Zm9v", "CPNMU===", "666F6F" },
+	{ "foob", "Zm9vYg==", "CPNMUOG=", "666F6F62" },
+	{ "fooba", "Zm9vYmE=", "CPNMUOJ1", "666F6F6261" },
+	{ "foobar", "Zm9vYmFy", "CPNMUOJ1E8======", "666F6F626172" },
+	{ "The quick brown fox jumps over the lazy dog",
+	  "VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZw==",
+	  "AHK6A83HELKM6QP0C9P6UTRE41J6UU10D9QMQS3J41NNCPBI41Q6GP90DHGNKU90"
+	  "CHNME===",
+	  "54686520717569636B2062726F776E20666F78206A756D7073206F766572207468"
+	  "65206C617A7920646F67" },
+};
+
+static void
+check_totext(totext_fn *totext, const char *data, size_t len, int wordlength,
+	     const char *wordbreak, const char *expect) {
+	isc_region_t region = { .base = (unsigned char *)data, .length = len };
+	char text[4 * DATALEN];
+	isc_buffer_t b;
+
+	isc_buffer_init(&b, text, sizeof(text) - 1);
+	assert_int_equal(totext(&region, wordlength, wordbreak, &b),
+			 ISC_R_SUCCESS);
+	text[isc_buffer_usedlength(&b)] = '\0';
+	assert_string_equal(text, expect);
+	assert_int_equal(region.length, 0);
+}
+
+static void
+check_decode(decode_fn *decode, const char *text, const char *data,
+	     size_t len) {
+	unsigned char buf[DATALEN];
+	isc_buffer_t b;
+
+	isc_buffer_init(&b, buf, sizeof(buf));
+	assert_int_equal(decode(text, &b), ISC_R_SUCCESS);
+	assert_int_equal(isc_buffer_usedlength(&b), len);
+	assert_memory_equal(buf, data, len);
+}
+
+/* The test vectors are encoded and decoded by every implementation */
+ISC_RUN_TEST_IMPL(codec_vectors) {
+	isc_simd_t supported = isc_simd_supported();
+
+	for (isc_simd_t simd = isc_simd_none; simd <= supported; simd++) {
+		assert_int_equal(isc_simd_set(simd), simd);
+
+		for (size_t i = 0; i < ARRAY_SIZE(vectors); i++) {
+			const char *data = vectors[i].data;
+			size_t len = strlen(data);
+
+			check_totext(isc_base64_totext, data, len, 0, "",
+				     vectors[i].base64);
+			check_totext(isc_base32hex_totext, data, len, 0, "",
+				     vectors[i].base32hex);
+			check_totext(isc_hex_totext, data, len, 0, "",
+				     vectors[i].hex);
+
+			check_decode(isc_base64_decodestring,
+				     vectors[i].base64, data, len);
+			check_decode(isc_base32hex_decodestring,
+				     vectors[i].base32hex, data, len);
+			check_decode(isc_hex_decodestring, vectors[i].hex,
+				     data, len);
+		}
+	}
+
+	isc_simd_set(supported);
+}
+
+/*
+ * Random data of every length up to DATALEN is encoded identically by
+ * every implementation, with and without word breaks, and decodes back
+ * to the same data.
+ */
+ISC_RUN_TEST_IMPL(codec_roundtrip) {
+	isc_simd_t supported = isc_simd_supported();
+	unsigned char data[DATALEN];
+	totext_fn *totext[] = { isc_base64_totext, isc_base32hex_totext,
+				isc_hex_totext };
+	decode_fn *decode[] = { isc_base64_decodestring,
+				isc_base32hex_decodestring,
+				isc_hex_decodestring };
+
+	isc_random_buf(data, sizeof(data));
+
+	for (size_t c = 0; c < ARRAY_SIZE(totext); c++) {
+		for (size_t len = 0; len <= DATALEN; len++) {
+			char expect[5 * DATALEN];
+			int wordlength = (int)len % 80;
+			const char *wordbreak = (len % 2 == 0) ? "" : " ";
+			isc_region_t region = { .base = data, .length = len };
+			isc_buffer_t b;
+
+			isc_simd_set(isc_simd_none);
+			isc_buffer_init(&b, expect, sizeof(expect) - 1);
+			assert_int_equal(totext[c](&region, wordlength,
+						   wordbreak, &b),
+					 ISC_R_SUCCESS);
+			expect[isc_buffer_usedlength(&b)] = '\0';
+
+			for (isc_simd_t simd = isc_simd_none;
+			     simd <= supported; simd++)
+			{
+				isc_simd_set(simd);
+				check_totext(totext[c], (const char *)data, len,
+					     wordlength, wordbreak, expect);
+				check_decode(decode[c], expect,
+					     (const char *)data, len);
+			}
+		}
+	}
+
+	isc_simd_set(supported);
+}
+
+/* An invalid character anywhere in the text is rejected */
+ISC_RUN_TEST_IMPL(codec_invalid) {
+	isc_simd_t supported = isc_simd_supported();
+	unsigned char data[DATALEN];
+	char base64[4 * DATALEN / 3 + 1], hex[2 * DATALEN + 1];
+	isc_region_t region;
+	isc_buffer_t b;
+
+	isc_random_buf(data, sizeof(data));
+
+	region = (isc_region_t){ .base = data, .length = sizeof(data) };
+	isc_buffer_init(&b, base64, sizeof(base64) - 1);
+	assert_int_equal(isc_base64_totext(&region, 0, "", &b),
+			 ISC_R_SUCCESS);
+	base64[isc_buffer_usedlength(&b)] = '\0';
+
+	region = (isc_region_t){ .base = data, .length = sizeof(data) };
+	isc_buffer_init(&b, hex, sizeof(hex) - 1);
+	assert_int_equal(isc_hex_totext(&region, 0, "", &b), ISC_R_SUCCESS);
+	hex[isc_buffer_usedlength(&b)] = '\0';
+
+	for (isc_simd_t simd = isc_simd_none; simd <= supported; simd++) {
+		unsigned char buf[DATALEN];
+
+		isc_simd_set(simd);
+
+		for (size_t i = 0; i < strlen(base64); i++) {
+			char save = base64[i];
+
+			base64[i] = (i % 2 == 0) ? '=' : '.';
+			isc_buffer_init(&b, buf, sizeof(buf));
+			assert_int_equal(isc_base64_decodestring(base64, &b),
+					 ISC_R_BADBASE64);
+			base64[i] = save;
+		}
+
+		for (size_t i = 0; i < strlen(hex); i++) {
+			char save = hex[i];
+
+			hex[i] = (i % 2 == 0) ? 'g' : '/';
+			isc_buffer_init(&b, buf, sizeof(buf));
+			assert_int_equal(isc_hex_decodestring(hex, &b),
+					 ISC_R_BADHEX);
+			hex[i] = save;
+		}
+
+		/* Not enough space for the decoded data */
+		isc_buffer_init(&b, buf, sizeof(buf) - 1);
+		assert_int_equal(isc_base64_decodestring(base64, &b),
+				 ISC_R_NOSPACE);
+		isc_buffer_init(&b, buf, sizeof(buf) - 1);
+		assert_int_equal(isc_hex_decodestring(hex, &b), ISC_R_NOSPACE);
+	}
+
+	isc_simd_set(supported);
+}
+
+ISC_TEST_LIST_START
+ISC_TEST_ENTRY(codec_vectors)
+ISC_TEST_ENTRY(codec_roundtrip)
+ISC_TEST_ENTRY(codec_invalid)
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN
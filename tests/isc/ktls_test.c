@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+/* ! \file */
+
+#include <inttypes.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * As a workaround, include an OpenSSL header file before including cmocka.h,
+ * because OpenSSL 3.1.0 uses __attribute__(malloc), conflicting with a
+ * redefined malloc in cmocka.h.
+ */
+#include <openssl/err.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/buffer.h>
+#include <isc/hex.h>
+#include <isc/result.h>
+#include <isc/tls.h>
+#include <isc/util.h>
+
+#include "tls.c"
+
+#include <tests/isc.h>
+
+#if HAVE_KTLS
+
+static void
+secret_fromhex(ktls_secret_t *secret, const char *hex) {
+	isc_buffer_t b;
+
+	isc_buffer_init(&b, secret->data, sizeof(secret->data));
+	assert_int_equal(isc_hex_decodestring(hex, &b), ISC_R_SUCCESS);
+	secret->length = isc_buffer_usedlength(&b);
+}
+
+static void
+assert_hex_equal(const unsigned char *data, size_t length, const char *hex) {
+	unsigned char expected[64];
+	isc_buffer_t b;
+
+	isc_buffer_init(&b, expected, sizeof(expected));
+	assert_int_equal(isc_hex_decodestring(hex, &b), ISC_R_SUCCESS);
+	assert_int_equal(isc_buffer_usedlength(&b), length);
+	assert_memory_equal(data, expected, length);
+}
+
+static int
+_setup(void **state ISC_ATTR_UNUSED) {
+	if (ktls_secret_index < 0) {
+		ktls_secret_index = SSL_get_ex_new_index(0, NULL, NULL, NULL,
+							 ktls_secret_free);
+	}
+
+	return (ktls_secret_index < 0 ? -1 : 0);
+}
+
+/* HKDF-Expand-Label() with the server handshake secret from RFC 8448 */
+ISC_RUN_TEST_IMPL(ktls_expand_label) {
+	ktls_secret_t secret = { 0 };
+	unsigned char key[16], iv[12];
+
+	secret_fromhex(&secret, "b67b7d690cc16c4e75e54213cb2d37b4"
+				"e9c912bcded9105d42befd59d391ad38");
+
+	assert_true(ktls_expand_label(EVP_sha256(), &secret, "key", key,
+				      sizeof(key)));
+	assert_hex_equal(key, sizeof(key), "3fce516009c21727d0f2e4e86ee403bc");
+
+	assert_true(
+		ktls_expand_label(EVP_sha256(), &secret, "iv", iv, sizeof(iv)));
+	assert_hex_equal(iv, sizeof(iv), "5d313eb2671276ee13000b30");
+}
+
+/* record keys for the server application secret from RFC 8448 */
+ISC_RUN_TEST_IMPL(ktls_derive_aes128) {
+	ktls_secret_t secret = { 0 };
+	unsigned char key[TLS_CIPHER_AES_GCM_128_KEY_SIZE], iv[12];
+
+	secret_fromhex(&secret, "a11af9f05531f856ad47116b45a95032"
+				"8204b4f44bfb6b3a4b4f1f3fcb631643");
+
+	assert_true(ktls_derive(EVP_sha256(), &secret, key, sizeof(key), iv,
+				sizeof(iv)));
+	assert_hex_equal(key, sizeof(key), "9f02283b6c9c07efc26bb9f2ac92e356");
+	assert_hex_equal(iv, sizeof(iv), "cf782b88dd83549aadf1e984");
+}
+
+/* record keys for TLS_AES_256_GCM_SHA384 */
+ISC_RUN_TEST_IMPL(ktls_derive_aes256) {
+	ktls_secret_t secret = { 0 };
+	unsigned char key[TLS_CIPHER_AES_GCM_256_KEY_SIZE], iv[12];
+
+	secret_fromhex(&secret, "000102030405060708090a0b0c0d0e0f"
+				"101112131415161718191a1b1c1d1e1f"
+				"202122232425262728292a2b2c2d2e2f");
+
+	assert_true(ktls_derive(EVP_sha384(), &secret, key, sizeof(key), iv,
+				sizeof(iv)));
+	assert_hex_equal(key, sizeof(key),
+			 "6877d022f1c61d24ebb7487c16752d9a"
+			 "4798e40431c75b39320e537c90e23225");
+	assert_hex_equal(iv, sizeof(iv), "42822531a0fe88648fc09e9f");
+}
+
+/* the records written with the captured secret are counted */
+ISC_RUN_TEST_IMPL(ktls_msg) {
+	SSL_CTX *ctx = SSL_CTX_new(TLS_method());
+	SSL *ssl = NULL;
+	ktls_secret_t *secret = NULL;
+	const unsigned char header[] = { SSL3_RT_APPLICATION_DATA, 0x03, 0x03,
+					 0x00, 0x20 };
+	const unsigned char keyupdate[] = { SSL3_MT_KEY_UPDATE, 0x00, 0x00,
+					    0x01, 0x00 };
+
+	assert_non_null(ctx);
+	ssl = SSL_new(ctx);
+	assert_non_null(ssl);
+
+	/* nothing is counted before the secret has been captured */
+	ktls_msg(1, TLS1_3_VERSION, SSL3_RT_HEADER, header, sizeof(header),
+		 ssl, NULL);
+
+	secret = OPENSSL_zalloc(sizeof(*secret));
+	assert_non_null(secret);
+	assert_int_equal(SSL_set_ex_data(ssl, ktls_secret_index, secret), 1);
+
+	ktls_msg(1, TLS1_3_VERSION, SSL3_RT_HEADER, header, sizeof(header),
+		 ssl, NULL);
+	ktls_msg(1, TLS1_3_VERSION, SSL3_RT_HEADER, header, sizeof(header),
+		 ssl, NULL);
+	/* received records don't count */
+	ktls_msg(0, TLS1_3_VERSION, SSL3_RT_HEADER, header, sizeof(header),
+		 ssl, NULL);
+	assert_int_equal(secret->seq, 2);
+	assert_false(secret->stale);
+
+	ktls_msg(1, TLS1_3_VERSION, SSL3_RT_HANDSHAKE, keyupdate,
+		 sizeof(keyupdate), ssl, NULL);
+	assert_true(secret->stale);
+
+	/* frees the secret */
+	SSL_free(ssl);
+	SSL_CTX_free(ctx);
+}
+
+ISC_TEST_LIST_START
+
+ISC_TEST_ENTRY(ktls_expand_label)
+ISC_TEST_ENTRY(ktls_derive_aes128)
+ISC_TEST_ENTRY(ktls_derive_aes256)
+ISC_TEST_ENTRY(ktls_msg)
+
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN_CUSTOM(_setup, NULL)
+
+#else /* HAVE_KTLS */
+
+#include <stdio.h>
+
+int
+main(void) {
+	printf("1..0 # Skipped: kernel TLS not available\n");
+	return (SKIPPED_TEST_EXIT_CODE);
+}
+
+#endif /* HAVE_KTLS */
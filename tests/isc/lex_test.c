@@ -16,6 +16,7 @@
 #include <setjmp.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -32,6 +33,8 @@
 
 #define AS_STR(x) (x).value.as_textregion.base
 
+#define TESTFILE "lex_test.txt"
+
 /* check handling of 0xff */
 ISC_RUN_TEST_IMPL(lex_0xff) {
 	isc_result_t result;
@@ -338,8 +341,169 @@ ISC_RUN_TEST_IMPL(lex_keypair) {
 	}
 }
 
+/*
+ * Write a zone file long enough to be read in several blocks, with
+ * tokens of every kind, some of them spanning the end of a block.
+ */
+static void
+write_zone(void) {
+	FILE *fp = fopen(TESTFILE, "w");
+
+	assert_non_null(fp);
+	for (size_t i = 0; i < 3000; i++) {
+		fprintf(fp, "host%zu 3600 IN A 10.0.%zu.%zu ; comment %zu\n", i,
+			i / 256, i % 256, i);
+		fprintf(fp, "\tIN TXT \"quoted %zu\" escaped\\ text\\059 (%zu\n"
+			    "  0x%zu 09 4294967296 a=b )\n",
+			i, i, i);
+		fprintf(fp,
+			"@ RRSIG A 8 2 3600 ( 20240101000000 AAAAB3/C+%0*zu= )"
+			"\r\n",
+			(int)(i % 300), i);
+	}
+	assert_int_equal(fclose(fp), 0);
+}
+
+/*
+ * Open the zone file with isc_lex_openfile(), or as a stream if 'fpp'
+ * is not NULL.
+ */
+static isc_lex_t *
+open_zone(FILE **fpp) {
+	isc_lexspecials_t specials;
+	isc_lex_t *lex = NULL;
+	isc_result_t result;
+
+	isc_lex_create(mctx, 64, &lex);
+
+	memset(specials, 0, sizeof(specials));
+	specials['('] = 1;
+	specials[')'] = 1;
+	specials['"'] = 1;
+	isc_lex_setspecials(lex, specials);
+	isc_lex_setcomments(lex, ISC_LEXCOMMENT_DNSMASTERFILE);
+
+	if (fpp != NULL) {
+		*fpp = fopen(TESTFILE, "r");
+		assert_non_null(*fpp);
+		result = isc_lex_openstream(lex, *fpp);
+	} else {
+		result = isc_lex_openfile(lex, TESTFILE);
+	}
+	assert_int_equal(result, ISC_R_SUCCESS);
+
+	return (lex);
+}
+
+/*
+ * Files opened with isc_lex_openfile() are read ahead in blocks and
+ * most tokens scanned directly from them; check that the tokens are the
+ * same as those read from a stream a character at a time.
+ */
+ISC_RUN_TEST_IMPL(lex_file) {
+	isc_lex_t *lex[2] = { NULL, NULL };
+	FILE *fp = NULL;
+	size_t n = 0;
+	bool eof = false;
+	unsigned int options = ISC_LEXOPT_INITIALWS | ISC_LEXOPT_EOL |
+			       ISC_LEXOPT_EOF | ISC_LEXOPT_DNSMULTILINE |
+			       ISC_LEXOPT_ESCAPE | ISC_LEXOPT_QSTRING;
+
+	UNUSED(state);
+
+	write_zone();
+
+	lex[0] = open_zone(NULL);
+	lex[1] = open_zone(&fp);
+
+	while (!eof) {
+		isc_token_t token[2];
+		isc_result_t result[2];
+		isc_region_t text[2];
+
+		for (size_t i = 0; i < 2; i++) {
+			memset(&token[i], 0, sizeof(token[i]));
+			switch (n % 4) {
+			case 0:
+				result[i] = isc_lex_gettoken(lex[i], options,
+							     &token[i]);
+				break;
+			case 1:
+				result[i] = isc_lex_gettoken(
+					lex[i], options | ISC_LEXOPT_NUMBER,
+					&token[i]);
+				break;
+			case 2:
+				result[i] = isc_lex_getmastertoken(
+					lex[i], &token[i],
+					isc_tokentype_number, true);
+				break;
+			default:
+				result[i] = isc_lex_getmastertoken(
+					lex[i], &token[i],
+					isc_tokentype_qvpair, true);
+				break;
+			}
+		}
+
+		assert_int_equal(result[0], result[1]);
+		assert_int_equal(isc_lex_getsourceline(lex[0]),
+				 isc_lex_getsourceline(lex[1]));
+		n++;
+		if (result[0] != ISC_R_SUCCESS) {
+			/* Skip the token that was not a number */
+			for (size_t i = 0; i < 2; i++) {
+				assert_int_equal(isc_lex_gettoken(lex[i],
+								  options,
+								  &token[i]),
+						 ISC_R_SUCCESS);
+			}
+			continue;
+		}
+
+		assert_int_equal(token[0].type, token[1].type);
+		switch (token[0].type) {
+		case isc_tokentype_string:
+		case isc_tokentype_qstring:
+		case isc_tokentype_vpair:
+		case isc_tokentype_qvpair:
+			assert_string_equal(AS_STR(token[0]), AS_STR(token[1]));
+			break;
+		case isc_tokentype_number:
+			assert_int_equal(token[0].value.as_ulong,
+					 token[1].value.as_ulong);
+			break;
+		case isc_tokentype_eof:
+			eof = true;
+			continue;
+		default:
+			break;
+		}
+
+		for (size_t i = 0; i < 2; i++) {
+			isc_lex_getlasttokentext(lex[i], &token[i], &text[i]);
+		}
+		assert_int_equal(text[0].length, text[1].length);
+		assert_memory_equal(text[0].base, text[1].base, text[0].length);
+
+		/* Every so often, read the same token again */
+		if (n % 7 == 0) {
+			isc_lex_ungettoken(lex[0], &token[0]);
+			isc_lex_ungettoken(lex[1], &token[1]);
+		}
+	}
+	assert_true(n > 3000 * 25);
+
+	isc_lex_destroy(&lex[0]);
+	isc_lex_destroy(&lex[1]);
+	fclose(fp);
+
+	(void)remove(TESTFILE);
+}
+
 ISC_TEST_LIST_START
 ISC_TEST_ENTRY(lex_0xff)
+ISC_TEST_ENTRY(lex_file)
 ISC_TEST_ENTRY(lex_keypair)
 ISC_TEST_ENTRY(lex_setline)
 ISC_TEST_ENTRY(lex_string)
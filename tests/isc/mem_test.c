@@ -199,6 +199,59 @@ ISC_RUN_TEST_IMPL(isc_mem_inuse) {
 	isc_mem_destroy(&mctx2);
 }
 
+#define SHARDED_ITEMS	  64
+#define SHARDED_ITEM_SIZE (128 * 1024)
+
+static int sharded_mark = -1;
+
+static void
+sharded_water(void *arg, int mark) {
+	isc_mem_t *mctx2 = arg;
+
+	sharded_mark = mark;
+	isc_mem_waterack(mctx2, mark);
+}
+
+/* test InUse calculation and water marks with sharded accounting */
+ISC_RUN_TEST_IMPL(isc_mem_sharded) {
+	isc_mem_t *mctx2 = NULL;
+	unsigned int defaultflags = isc_mem_defaultflags;
+	void *items[SHARDED_ITEMS];
+	void *ptr = NULL;
+
+	isc_mem_defaultflags |= ISC_MEMFLAG_SHARDED;
+	isc_mem_create(&mctx2);
+	isc_mem_defaultflags = defaultflags;
+
+	/* Small allocations stay in the shard but are still counted */
+	ptr = isc_mem_get(mctx2, 1000);
+	assert_int_equal(isc_mem_inuse(mctx2), 1000);
+	isc_mem_put(mctx2, ptr, 1000);
+	assert_int_equal(isc_mem_inuse(mctx2), 0);
+
+	isc_mem_setwater(mctx2, sharded_water, mctx2,
+			 SHARDED_ITEMS / 2 * SHARDED_ITEM_SIZE,
+			 SHARDED_ITEMS / 4 * SHARDED_ITEM_SIZE);
+
+	for (size_t i = 0; i < SHARDED_ITEMS; i++) {
+		items[i] = isc_mem_get(mctx2, SHARDED_ITEM_SIZE);
+	}
+	assert_int_equal(isc_mem_inuse(mctx2),
+			 SHARDED_ITEMS * SHARDED_ITEM_SIZE);
+	assert_int_equal(sharded_mark, ISC_MEM_HIWATER);
+	assert_true(isc_mem_isovermem(mctx2));
+
+	for (size_t i = 0; i < SHARDED_ITEMS; i++) {
+		isc_mem_put(mctx2, items[i], SHARDED_ITEM_SIZE);
+	}
+	assert_int_equal(isc_mem_inuse(mctx2), 0);
+	assert_int_equal(sharded_mark, ISC_MEM_LOWATER);
+	assert_false(isc_mem_isovermem(mctx2));
+
+	isc_mem_clearwater(mctx2);
+	isc_mem_destroy(&mctx2);
+}
+
 ISC_RUN_TEST_IMPL(isc_mem_zeroget) {
 	uint8_t *data = NULL;
 
@@ -483,6 +536,7 @@ ISC_TEST_ENTRY(isc_mem_get)
 ISC_TEST_ENTRY(isc_mem_cget_zero)
 ISC_TEST_ENTRY(isc_mem_callocate_zero)
 ISC_TEST_ENTRY(isc_mem_inuse)
+ISC_TEST_ENTRY(isc_mem_sharded)
 ISC_TEST_ENTRY(isc_mem_zeroget)
 ISC_TEST_ENTRY(isc_mem_reget)
 ISC_TEST_ENTRY(isc_mem_reallocate)
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) Internet Systems Consortium, Inc. ("ISC")
+ *
+ * SPDX-License-Identifier: MPL-2.0
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, you can obtain one at https://mozilla.org/MPL/2.0/.
+ *
+ * See the COPYRIGHT file distributed with this work for additional
+ * information regarding copyright ownership.
+ */
+
+#include <inttypes.h>
+#include <sched.h> /* IWYU pragma: keep */
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define UNIT_TESTING
+#include <cmocka.h>
+
+#include <isc/job.h>
+#include <isc/loop.h>
+#include <isc/time.h>
+#include <isc/timerwheel.h>
+
+#include "timerwheel.c"
+
+#include <tests/isc.h>
+
+static isc_timerwheel_t *wheel = NULL;
+static isc_wheeltimer_t timers[4];
+static size_t fired[ARRAY_SIZE(timers)];
+static size_t nfired = 0;
+static isc_time_t start_time;
+
+static void
+finish(void) {
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		if (isc_wheeltimer_initialized(&timers[i])) {
+			isc_wheeltimer_invalidate(&timers[i]);
+		}
+	}
+
+	assert_int_equal(isc_timerwheel_pending(wheel), 0);
+
+	isc_timerwheel_shutdown(wheel);
+	isc_timerwheel_detach(&wheel);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+static void
+record(void *arg) {
+	size_t i = (uintptr_t)arg;
+
+	assert_false(isc_wheeltimer_pending(&timers[i]));
+	fired[nfired++] = i;
+}
+
+ISC_LOOP_SETUP_IMPL(timerwheel) {
+	UNUSED(arg);
+
+	assert_null(wheel);
+	memset(timers, 0, sizeof(timers));
+	nfired = 0;
+	start_time = isc_time_now();
+
+	isc_timerwheel_create(mainloop, &wheel);
+	for (size_t i = 0; i < ARRAY_SIZE(timers); i++) {
+		isc_wheeltimer_init(&timers[i], wheel, record,
+				    (void *)(uintptr_t)i);
+	}
+}
+
+ISC_LOOP_TEARDOWN_IMPL(timerwheel) { assert_null(wheel); }
+
+ISC_LOOP_TEST_IMPL(timerwheel_create) {
+	expect_assert_failure(isc_timerwheel_create(NULL, &wheel));
+	expect_assert_failure(isc_timerwheel_create(mainloop, NULL));
+
+	isc_timerwheel_create(mainloop, &wheel);
+	assert_non_null(wheel);
+	assert_int_equal(isc_timerwheel_pending(wheel), 0);
+
+	isc_timerwheel_shutdown(wheel);
+	isc_timerwheel_detach(&wheel);
+
+	isc_loopmgr_shutdown(loopmgr);
+}
+
+static void
+expire_done(void *arg) {
+	isc_time_t now = isc_time_now();
+
+	record(arg);
+
+	/* The zero second timer fired first, the stopped one not at all */
+	assert_int_equal(nfired, 2);
+	assert_int_equal(fired[0], 0);
+	assert_int_equal(fired[1], 1);
+	/* The loop clock only has millisecond resolution */
+	assert_true(isc_time_microdiff(&now, &start_time) >=
+		    US_PER_SEC - US_PER_MS);
+
+	finish();
+}
+
+ISC_LOOP_TEST_CUSTOM_IMPL(timerwheel_expire, setup_loop_timerwheel,
+			  teardown_loop_timerwheel) {
+	timers[1].cb = expire_done;
+
+	isc_wheeltimer_start(&timers[0], 0);
+	isc_wheeltimer_start(&timers[1], 1);
+	isc_wheeltimer_start(&timers[2], 1);
+	assert_int_equal(isc_timerwheel_pending(wheel), 3);
+
+	isc_wheeltimer_stop(&timers[2]);
+	assert_false(isc_wheeltimer_pending(&timers[2]));
+	assert_int_equal(isc_timerwheel_pending(wheel), 2);
+}
+
+static void
+restart(void *arg) {
+	record(arg);
+
+	if (nfired == 1) {
+		isc_wheeltimer_start(&timers[0], 0);
+	} else {
+		finish();
+	}
+}
+
+ISC_LOOP_TEST_CUSTOM_IMPL(timerwheel_restart, setup_loop_timerwheel,
+			  teardown_loop_timerwheel) {
+	timers[0].cb = restart;
+
+	/* Starting a pending timer moves it */
+	isc_wheeltimer_start(&timers[0], 3600);
+	isc_wheeltimer_start(&timers[0], 0);
+	assert_int_equal(isc_timerwheel_pending(wheel), 1);
+}
+
+/*
+ * Timers far enough in the future to be in each of the upper levels are
+ * cascaded down and expire in order once the wheel has caught up with
+ * them.  Rather than waiting, the epoch is moved back in time.
+ */
+ISC_LOOP_TEST_CUSTOM_IMPL(timerwheel_cascade, setup_loop_timerwheel,
+			  teardown_loop_timerwheel) {
+	const uint32_t delays[] = { 100, 300, 20000, 2000000 };
+
+	for (size_t i = ARRAY_SIZE(delays); i > 0; i--) {
+		isc_wheeltimer_start(&timers[i - 1], delays[i - 1]);
+	}
+	assert_int_equal(isc_timerwheel_pending(wheel), ARRAY_SIZE(delays));
+	assert_ptr_equal(timers[0].slot, &wheel->level0[timers[0].expires &
+							  WHEEL_MASK0]);
+	assert_ptr_equal(timers[3].slot,
+			 &wheel->levels[2][LEVEL_INDEX(timers[3].expires, 2)]);
+
+	wheel->epoch -= (uint64_t)(delays[1] + 1) * MS_PER_SEC;
+	timerwheel_run(wheel);
+	assert_int_equal(nfired, 2);
+
+	wheel->epoch -= (uint64_t)delays[3] * MS_PER_SEC;
+	timerwheel_run(wheel);
+	assert_int_equal(nfired, ARRAY_SIZE(delays));
+
+	for (size_t i = 0; i < ARRAY_SIZE(delays); i++) {
+		assert_int_equal(fired[i], i);
+	}
+
+	finish();
+}
+
+ISC_TEST_LIST_START
+
+ISC_TEST_ENTRY_CUSTOM(timerwheel_create, setup_loopmgr, teardown_loopmgr)
+ISC_TEST_ENTRY_CUSTOM(timerwheel_expire, setup_loopmgr, teardown_loopmgr)
+ISC_TEST_ENTRY_CUSTOM(timerwheel_restart, setup_loopmgr, teardown_loopmgr)
+ISC_TEST_ENTRY_CUSTOM(timerwheel_cascade, setup_loopmgr, teardown_loopmgr)
+
+ISC_TEST_LIST_END
+
+ISC_TEST_MAIN
@@ -26,6 +26,10 @@
  */
 #include <openssl/err.h>
 
+#if HAVE_LIBURING
+#include <liburing.h>
+#endif /* HAVE_LIBURING */
+
 #define UNIT_TESTING
 #include <cmocka.h>
 
@@ -1200,6 +1204,85 @@ ISC_LOOP_TEST_IMPL(udp_double_read) {
 	udp__connect(NULL);
 }
 
+#if HAVE_LIBURING
+/*
+ * The io_uring backend needs provided buffer rings, which the kernel
+ * (or a seccomp policy) may not allow.
+ */
+static bool
+uring_available(void) {
+	struct io_uring ring;
+	struct io_uring_buf_ring *br = NULL;
+	int r;
+
+	r = io_uring_queue_init(8, &ring, 0);
+	if (r < 0) {
+		return (false);
+	}
+
+	br = io_uring_setup_buf_ring(&ring, 1, 0, 0, &r);
+	if (br != NULL) {
+		io_uring_free_buf_ring(&ring, br, 1, 0);
+	}
+	io_uring_queue_exit(&ring);
+
+	return (br != NULL);
+}
+
+static void
+uring_listen_read_cb(isc_nmhandle_t *handle, isc_result_t eresult,
+		     isc_region_t *region, void *cbarg) {
+	if (eresult == ISC_R_SUCCESS) {
+		assert_true(handle->sock->uring);
+	}
+	udp_listen_read_cb(handle, eresult, region, cbarg);
+}
+
+ISC_SETUP_TEST_IMPL(udp_uring_recv_one) {
+	if (!uring_available()) {
+		skip();
+	}
+
+	setup_test_udp_recv_one(state);
+	isc_nm_setiouring(netmgr, true);
+
+	return (0);
+}
+
+ISC_TEARDOWN_TEST_IMPL(udp_uring_recv_one) {
+	return (teardown_test_udp_recv_one(state));
+}
+
+ISC_LOOP_TEST_IMPL(udp_uring_recv_one) {
+	start_listening(ISC_NM_LISTEN_ONE, uring_listen_read_cb);
+
+	udp__connect(NULL);
+}
+
+ISC_SETUP_TEST_IMPL(udp_uring_recv_send) {
+	if (!uring_available()) {
+		skip();
+	}
+
+	setup_test_udp_recv_send(state);
+	isc_nm_setiouring(netmgr, true);
+
+	return (0);
+}
+
+ISC_TEARDOWN_TEST_IMPL(udp_uring_recv_send) {
+	return (teardown_test_udp_recv_send(state));
+}
+
+ISC_LOOP_TEST_IMPL(udp_uring_recv_send) {
+	start_listening(ISC_NM_LISTEN_ALL, uring_listen_read_cb);
+
+	for (size_t i = 0; i < workers; i++) {
+		isc_async_run(isc_loop_get(loopmgr, i), udp__connect, NULL);
+	}
+}
+#endif /* HAVE_LIBURING */
+
 ISC_TEST_LIST_START
 
 ISC_TEST_ENTRY_CUSTOM(mock_listenudp_uv_udp_open, setup_test, teardown_test)
@@ -1223,6 +1306,10 @@ ISC_TEST_ENTRY_SETUP_TEARDOWN(udp_double_read)
 ISC_TEST_ENTRY_SETUP_TEARDOWN(udp_recv_one)
 ISC_TEST_ENTRY_SETUP_TEARDOWN(udp_recv_two)
 ISC_TEST_ENTRY_SETUP_TEARDOWN(udp_recv_send)
+#if HAVE_LIBURING
+ISC_TEST_ENTRY_SETUP_TEARDOWN(udp_uring_recv_one)
+ISC_TEST_ENTRY_SETUP_TEARDOWN(udp_uring_recv_send)
+#endif /* HAVE_LIBURING */
 
 ISC_TEST_LIST_END
 